@@ -57,6 +57,12 @@ namespace nntl {
 			CantInitializeWeights,
 			CantInitializePAB,
 			NNDiverged,
+			InvalidReplicas,
+			MiniBatchRequired,
+			TransportFailed,
+			RanksMismatch,
+			ConcurrentTasksUnsupported,
+			ReplicaPoolTooBig,
 		};
 
 		//TODO: table lookup would be better here. But it's not essential
@@ -83,6 +89,12 @@ namespace nntl {
 			case CantInitializeWeights: return NNTL_STRING("Weights initialization failed");
 			case CantInitializePAB: return NNTL_STRING("Activations penalizer initialization failed");
 			case NNDiverged: return NNTL_STRING("NN diverged! (Training loss value surpassed the threshold from opts.divergenceCheckThreshold())");
+			case InvalidReplicas: return NNTL_STRING("Replicas must be distinct nnet objects with own layers, iMath and iRng, and the same weights shapes");
+			case MiniBatchRequired: return NNTL_STRING("The minibatch mode is required (opts.batchSize() must be in (0, train set size) range)");
+			case TransportFailed: return NNTL_STRING("Distributed training: the transport failed to connect or a data exchange between ranks failed or timed out");
+			case RanksMismatch: return NNTL_STRING("Distributed training: ranks must have the same training set size, batch size, number of epochs and weights shapes");
+			case ConcurrentTasksUnsupported: return NNTL_STRING("Distributed training: layer_pack_horizontal concurrent tasks mode isn't supported, turn it off with concurrent_tasks(0)");
+			case ReplicaPoolTooBig: return NNTL_STRING("Data parallel training: iMath of every replica must be constructed with at most cores_per_replica() threads");
 			default: NNTL_ASSERT(!"WTF?"); return NNTL_STRING("Unknown code.");
 			}
 		}
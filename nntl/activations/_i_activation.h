@@ -59,6 +59,16 @@ namespace activation {
 		template <typename iMath>
 		nntl_interface static void f(realmtx_t& srcdest, iMath& m) noexcept;
 
+		//Optional: template <typename iMath> static void f_st(realmtx_t& srcdest, iMath& m) noexcept;
+		// same as f(), but must be computed by the calling thread only (i.e. with _st() functions of iMath). It's called from
+		// worker threads of iMath on different parts of a matrix at the same time, see iMath::mMulABt_Cnb_ep().
+		// An activation without it isn't fused with the matrix multiplication (see has_f_st<>). It's not declared here,
+		// because has_f_st<> would always detect the declaration.
+
+		//true if f() computes each element independently of others, so it may be applied to any part of a matrix (that's
+		// used to fuse the activation with the matrix multiplication, see _LFC::_fprop()). Override in derived class if it's not so
+		static constexpr bool bElementwise = true;
+
 		//get requirements on temporary memory size needed to calculate f() over matrix act (need it for memory
 		// preallocation algorithm of iMath). This is default version. Override in derived class if need something more
 		// #todo we should probably split output to fprop() only and fprop()+bprop() versions like we're doing in _i_layer::init()
@@ -84,6 +94,11 @@ namespace activation {
 		template <typename iMath>
 		nntl_interface static void df(realmtx_t& f_df, iMath& m) noexcept;
 
+		//Optional: template <typename iMath> static void df_mul(realmtx_t& f_df, const realmtx_t& dLdA, iMath& m) noexcept;
+		// computes dL/dZ = df(f_df).*dLdA in place of f_df (f_df contains activation values on entry). Should be done in
+		// a single pass over the data, i.e. without storing the whole derivative first. If it's not implemented, layers
+		// call df() followed by iMath::evMul_ip() (see has_df_mul<>). Not declared here for the same reason as f_st().
+
 		//to support linear layers
 		template <typename iMath>
 		static void dIdentity(realmtx_t& f_df, iMath& m) noexcept {
@@ -93,6 +108,16 @@ namespace activation {
 			//m.dIdentity(f_df);
 			f_df.ones();
 		}
+		template <typename iMath>
+		static void dIdentity_mul(realmtx_t& f_df, const realmtx_t& dLdA, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_UNREF(m);
+			NNTL_ASSERT(!f_df.emulatesBiases() && !dLdA.emulatesBiases());
+			//dA/dZ == 1, therefore dL/dZ == dL/dA
+			const auto r = dLdA.copy_to(f_df);
+			NNTL_UNREF(r);
+			NNTL_ASSERT(r);
+		}
 
 		static constexpr real_t act_scaling_coeff()noexcept {
 			return real_t(1.);
@@ -119,8 +144,39 @@ namespace activation {
 		template <typename iMath>
 		nntl_interface static void dLdZIdentity(const typename iMath::realmtx_t& data_y,
 			IN OUT typename iMath::realmtx_t& act_dLdZ, iMath& m) noexcept;
+
+		//OPTIONAL fused versions of dLdZ() and dLdZIdentity(): they compute dL/dZ inplace and return the value that loss()
+		// would return on the activations before they were overwritten. If an activation doesn't provide dLdZ_loss(),
+		// the output layer falls back to the separate loss() + dLdZ() calls (see has_dLdZ_loss)
+		template <typename iMath>
+		nntl_interface static RealT dLdZ_loss(const typename iMath::realmtx_t& data_y,
+			IN OUT typename iMath::realmtx_t& act_dLdZ, iMath& m)noexcept;
+		template <typename iMath>
+		nntl_interface static RealT dLdZIdentity_loss(const typename iMath::realmtx_t& data_y,
+			IN OUT typename iMath::realmtx_t& act_dLdZ, iMath& m)noexcept;
 	};
 
+	template<class ActT, class iMath, class = ::std::void_t<>>
+	struct has_f_st : ::std::false_type {};
+
+	template<class ActT, class iMath>
+	struct has_f_st<ActT, iMath, ::std::void_t<decltype(ActT::f_st(::std::declval<typename iMath::realmtx_t&>()
+		, ::std::declval<iMath&>()))>> : ::std::true_type {};
+
+	template<class ActT, class iMath, class = ::std::void_t<>>
+	struct has_df_mul : ::std::false_type {};
+
+	template<class ActT, class iMath>
+	struct has_df_mul<ActT, iMath, ::std::void_t<decltype(ActT::df_mul(::std::declval<typename iMath::realmtx_t&>()
+		, ::std::declval<const typename iMath::realmtx_t&>(), ::std::declval<iMath&>()))>> : ::std::true_type {};
+
+	template<class ActT, class iMath, class = ::std::void_t<>>
+	struct has_dLdZ_loss : ::std::false_type {};
+
+	template<class ActT, class iMath>
+	struct has_dLdZ_loss<ActT, iMath, ::std::void_t<decltype(ActT::dLdZ_loss(::std::declval<const typename iMath::realmtx_t&>()
+		, ::std::declval<typename iMath::realmtx_t&>(), ::std::declval<iMath&>()))>> : ::std::true_type {};
+
 	template<typename RealT>
 	class _i_quadratic_loss : public _i_activation_loss<RealT> {
 	public:
@@ -136,6 +192,17 @@ namespace activation {
 			NNTL_ASSERT(!data_y.emulatesBiases() && !act_dLdZ.emulatesBiases());
 			m.evSub_ip(act_dLdZ, data_y);
 		}
+
+		//used only when the derived class provides dLdZ_loss() (loss() is the non numerically stabilized loss_quadratic())
+		template <typename iMath>
+		static RealT dLdZIdentity_loss(const typename iMath::realmtx_t& data_y,
+			IN OUT typename iMath::realmtx_t& act_dLdZ, iMath& m) noexcept
+		{
+			static_assert(::std::is_base_of<math::_i_math<RealT>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(data_y.size() == act_dLdZ.size());
+			NNTL_ASSERT(!data_y.emulatesBiases() && !act_dLdZ.emulatesBiases());
+			return m.dIdentityQuadLoss_dZ_loss(data_y, act_dLdZ);
+		}
 	};
 
 	template<typename RealT>
@@ -149,6 +216,16 @@ namespace activation {
 			NNTL_ASSERT(!data_y.emulatesBiases() && !act_dLdZ.emulatesBiases());
 			m.dIdentityXEntropyLoss_dZ(data_y, act_dLdZ);
 		}
+
+		//used only when the derived class provides dLdZ_loss() (loss() is the non numerically stabilized loss_xentropy())
+		template <typename iMath>
+		static RealT dLdZIdentity_loss(const typename iMath::realmtx_t& data_y,
+			IN OUT typename iMath::realmtx_t& act_dLdZ, iMath& m) noexcept
+		{
+			static_assert(::std::is_base_of<math::_i_math<RealT>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!data_y.emulatesBiases() && !act_dLdZ.emulatesBiases());
+			return m.dIdentityXEntropyLoss_dZ_loss(data_y, act_dLdZ);
+		}
 	};
 
 
@@ -79,6 +79,27 @@ namespace activation {
 			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
 			m.elogu_ua_nb(srcdest);
 		};
+		//same as f(), but computed by the calling thread only (see _i_function)
+		template <typename iMath, bool bUnitAlpha = bIsUnitAlpha, bool bNatB = bIsNaturalBase>
+		static ::std::enable_if_t<!bUnitAlpha && !bNatB> f_st(realmtx_t& srcdest, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			m.elogu_st(srcdest, Alpha, LogBase);
+		};
+		template <typename iMath, bool bUnitAlpha = bIsUnitAlpha, bool bNatB = bIsNaturalBase>
+		static ::std::enable_if_t<bUnitAlpha && !bNatB> f_st(realmtx_t& srcdest, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			m.elogu_ua_st(srcdest, LogBase);
+		};
+		template <typename iMath, bool bUnitAlpha = bIsUnitAlpha, bool bNatB = bIsNaturalBase>
+		static ::std::enable_if_t<!bUnitAlpha && bNatB> f_st(realmtx_t& srcdest, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			m.elogu_nb_st(srcdest, Alpha);
+		};
+		template <typename iMath, bool bUnitAlpha = bIsUnitAlpha, bool bNatB = bIsNaturalBase>
+		static ::std::enable_if_t<bUnitAlpha && bNatB> f_st(realmtx_t& srcdest, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			m.elogu_ua_nb_st(srcdest);
+		};
 
 		template <typename iMath, bool bUnitAlpha = bIsUnitAlpha, bool bNatB = bIsNaturalBase>
 		static ::std::enable_if_t<!bUnitAlpha && !bNatB> df(realmtx_t& f_df, iMath& m) noexcept {
@@ -104,6 +125,35 @@ namespace activation {
 			NNTL_ASSERT(!f_df.emulatesBiases());
 			m.delogu_ua_nb(f_df);
 		}
+
+		//computes dL/dZ = df(f_df).*dLdA in a single pass over the data (see iMath::dact_mul())
+		template <typename iMath, bool bUnitAlpha = bIsUnitAlpha, bool bNatB = bIsNaturalBase>
+		static ::std::enable_if_t<!bUnitAlpha && !bNatB> df_mul(realmtx_t& f_df, const realmtx_t& dLdA, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!f_df.emulatesBiases() && f_df.size() == dLdA.size());
+			m.delogu_mul(f_df, dLdA, Alpha, LogBase);
+		}
+
+		template <typename iMath, bool bUnitAlpha = bIsUnitAlpha, bool bNatB = bIsNaturalBase>
+		static ::std::enable_if_t<bUnitAlpha && !bNatB> df_mul(realmtx_t& f_df, const realmtx_t& dLdA, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!f_df.emulatesBiases() && f_df.size() == dLdA.size());
+			m.delogu_ua_mul(f_df, dLdA, LogBase);
+		}
+
+		template <typename iMath, bool bUnitAlpha = bIsUnitAlpha, bool bNatB = bIsNaturalBase>
+		static ::std::enable_if_t<!bUnitAlpha && bNatB> df_mul(realmtx_t& f_df, const realmtx_t& dLdA, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!f_df.emulatesBiases() && f_df.size() == dLdA.size());
+			m.delogu_nb_mul(f_df, dLdA, Alpha);
+		}
+
+		template <typename iMath, bool bUnitAlpha = bIsUnitAlpha, bool bNatB = bIsNaturalBase>
+		static ::std::enable_if_t<bUnitAlpha && bNatB> df_mul(realmtx_t& f_df, const realmtx_t& dLdA, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!f_df.emulatesBiases() && f_df.size() == dLdA.size());
+			m.delogu_ua_nb_mul(f_df, dLdA);
+		}
 	};
 
 	template<typename RealT, unsigned int LogBase1e3 = 2000, typename WeightsInitScheme = weights_init::He_Zhang<>>
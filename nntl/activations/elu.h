@@ -66,6 +66,17 @@ namespace activation {
 			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
 			m.elu_unitalpha(srcdest);
 		};
+		//same as f(), but computed by the calling thread only (see _i_function)
+		template <typename iMath, bool bUnitAlpha = bIsUnitAlpha>
+		static ::std::enable_if_t<!bUnitAlpha> f_st(realmtx_t& srcdest, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			m.elu_st(srcdest, Alpha);
+		};
+		template <typename iMath, bool bUnitAlpha = bIsUnitAlpha>
+		static ::std::enable_if_t<bUnitAlpha> f_st(realmtx_t& srcdest, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			m.elu_unitalpha_st(srcdest);
+		};
 
 		template <typename iMath, bool bUnitAlpha = bIsUnitAlpha>
 		static ::std::enable_if_t<!bUnitAlpha> df(realmtx_t& f_df, iMath& m) noexcept {
@@ -79,6 +90,21 @@ namespace activation {
 			NNTL_ASSERT(!f_df.emulatesBiases());
 			m.delu_unitalpha(f_df);
 		}
+
+		//computes dL/dZ = df(f_df).*dLdA in a single pass over the data (see iMath::dact_mul())
+		template <typename iMath, bool bUnitAlpha = bIsUnitAlpha>
+		static ::std::enable_if_t<!bUnitAlpha> df_mul(realmtx_t& f_df, const realmtx_t& dLdA, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!f_df.emulatesBiases() && f_df.size() == dLdA.size());
+			m.delu_mul(f_df, dLdA, Alpha);
+		}
+
+		template <typename iMath, bool bUnitAlpha = bIsUnitAlpha>
+		static ::std::enable_if_t<bUnitAlpha> df_mul(realmtx_t& f_df, const realmtx_t& dLdA, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!f_df.emulatesBiases() && f_df.size() == dLdA.size());
+			m.delu_unitalpha_mul(f_df, dLdA);
+		}
 	};
 
 	template<typename RealT, typename WeightsInitScheme = weights_init::He_Zhang<>>
@@ -55,10 +55,23 @@ namespace activation {
 			NNTL_UNREF(srcdest); NNTL_UNREF(m);
 			//should do nothing.
 		};
+		//same as f(), but computed by the calling thread only (see _i_function)
+		template <typename iMath>
+		static void f_st(realmtx_t& srcdest, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_UNREF(srcdest); NNTL_UNREF(m);
+			//should do nothing.
+		};
 		template <typename iMath>
 		static void df(realmtx_t& f_df, iMath& m) noexcept {
 			dIdentity(f_df, m);
 		}
+
+		//computes dL/dZ = df(f_df).*dLdA in a single pass over the data (see iMath::dact_mul())
+		template <typename iMath>
+		static void df_mul(realmtx_t& f_df, const realmtx_t& dLdA, iMath& m) noexcept {
+			dIdentity_mul(f_df, dLdA, m);
+		}
 	};
 
 	template<typename RealT, typename WeightsInitScheme = weights_init::SNNInit, bool bNumericStable = false>
@@ -79,6 +79,27 @@ namespace activation {
 			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
 			m.loglogu_nbn_nbp(srcdest);
 		};
+		//same as f(), but computed by the calling thread only (see _i_function)
+		template <typename iMath, bool bNBN = bIsNBN, bool bNBP = bIsNBP>
+		static ::std::enable_if_t<!bNBN && !bNBP> f_st(realmtx_t& srcdest, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			m.loglogu_st(srcdest, LogBaseNeg, LogBasePos);
+		};
+		template <typename iMath, bool bNBN = bIsNBN, bool bNBP = bIsNBP>
+		static ::std::enable_if_t<bNBN && !bNBP> f_st(realmtx_t& srcdest, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			m.loglogu_nbn_st(srcdest, LogBasePos);
+		};
+		template <typename iMath, bool bNBN = bIsNBN, bool bNBP = bIsNBP>
+		static ::std::enable_if_t<!bNBN && bNBP> f_st(realmtx_t& srcdest, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			m.loglogu_nbp_st(srcdest, LogBaseNeg);
+		};
+		template <typename iMath, bool bNBN = bIsNBN, bool bNBP = bIsNBP>
+		static ::std::enable_if_t<bNBN && bNBP> f_st(realmtx_t& srcdest, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			m.loglogu_nbn_nbp_st(srcdest);
+		};
 
 		template <typename iMath, bool bNBN = bIsNBN, bool bNBP = bIsNBP>
 		static ::std::enable_if_t<!bNBN && !bNBP> df(realmtx_t& f_df, iMath& m) noexcept {
@@ -104,6 +125,35 @@ namespace activation {
 			NNTL_ASSERT(!f_df.emulatesBiases());
 			m.dloglogu_nbn_nbp(f_df);
 		}
+
+		//computes dL/dZ = df(f_df).*dLdA in a single pass over the data (see iMath::dact_mul())
+		template <typename iMath, bool bNBN = bIsNBN, bool bNBP = bIsNBP>
+		static ::std::enable_if_t<!bNBN && !bNBP> df_mul(realmtx_t& f_df, const realmtx_t& dLdA, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!f_df.emulatesBiases() && f_df.size() == dLdA.size());
+			m.dloglogu_mul(f_df, dLdA, LogBaseNeg, LogBasePos);
+		}
+
+		template <typename iMath, bool bNBN = bIsNBN, bool bNBP = bIsNBP>
+		static ::std::enable_if_t<bNBN && !bNBP> df_mul(realmtx_t& f_df, const realmtx_t& dLdA, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!f_df.emulatesBiases() && f_df.size() == dLdA.size());
+			m.dloglogu_nbn_mul(f_df, dLdA, LogBasePos);
+		}
+
+		template <typename iMath, bool bNBN = bIsNBN, bool bNBP = bIsNBP>
+		static ::std::enable_if_t<!bNBN && bNBP> df_mul(realmtx_t& f_df, const realmtx_t& dLdA, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!f_df.emulatesBiases() && f_df.size() == dLdA.size());
+			m.dloglogu_nbp_mul(f_df, dLdA, LogBaseNeg);
+		}
+
+		template <typename iMath, bool bNBN = bIsNBN, bool bNBP = bIsNBP>
+		static ::std::enable_if_t<bNBN && bNBP> df_mul(realmtx_t& f_df, const realmtx_t& dLdA, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!f_df.emulatesBiases() && f_df.size() == dLdA.size());
+			m.dloglogu_nbn_nbp_mul(f_df, dLdA);
+		}
 	};
 
 	template<typename RealT, unsigned int LogBasePos1e3 = 2000, typename WeightsInitScheme = weights_init::He_Zhang<>>
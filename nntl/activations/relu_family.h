@@ -55,6 +55,12 @@ namespace activation {
 			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
 			m.relu(srcdest);
 		};
+		//same as f(), but computed by the calling thread only (see _i_function)
+		template <typename iMath>
+		static void f_st(realmtx_t& srcdest, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			m.relu_st(srcdest);
+		};
 
 		template <typename iMath>
 		static void df(realmtx_t& f_df, iMath& m) noexcept {
@@ -62,6 +68,14 @@ namespace activation {
 			NNTL_ASSERT(!f_df.emulatesBiases());
 			m.drelu(f_df);
 		}
+
+		//computes dL/dZ = df(f_df).*dLdA in a single pass over the data (see iMath::dact_mul())
+		template <typename iMath>
+		static void df_mul(realmtx_t& f_df, const realmtx_t& dLdA, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!f_df.emulatesBiases() && f_df.size() == dLdA.size());
+			m.drelu_mul(f_df, dLdA);
+		}
 	};
 
 	//activation types should not be templated (probably besides real_t), because they are intended to be used
@@ -87,6 +101,12 @@ namespace activation {
 			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
 			m.leakyrelu(srcdest, LeakK);
 		};
+		//same as f(), but computed by the calling thread only (see _i_function)
+		template <typename iMath>
+		static void f_st(realmtx_t& srcdest, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			m.leakyrelu_st(srcdest, LeakK);
+		};
 
 		template <typename iMath>
 		static void df(realmtx_t& f_df, iMath& m) noexcept {
@@ -94,6 +114,14 @@ namespace activation {
 			NNTL_ASSERT(!f_df.emulatesBiases());
 			m.dleakyrelu(f_df, LeakK);
 		}
+
+		//computes dL/dZ = df(f_df).*dLdA in a single pass over the data (see iMath::dact_mul())
+		template <typename iMath>
+		static void df_mul(realmtx_t& f_df, const realmtx_t& dLdA, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!f_df.emulatesBiases() && f_df.size() == dLdA.size());
+			m.dleakyrelu_mul(f_df, dLdA, LeakK);
+		}
 	};
 
 	template<typename RealT, typename WeightsInitScheme = weights_init::He_Zhang<>>
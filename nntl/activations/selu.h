@@ -64,6 +64,12 @@ namespace activation {
 			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
 			m.selu(srcdest, Alpha_t_Lambda, Lambda);
 		};
+		//same as f(), but computed by the calling thread only (see _i_function)
+		template <typename iMath>
+		static void f_st(realmtx_t& srcdest, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			m.selu_st(srcdest, Alpha_t_Lambda, Lambda);
+		};
 		template <typename iMath>
 		static void df(realmtx_t& f_df, iMath& m) noexcept {
 			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
@@ -71,6 +77,14 @@ namespace activation {
 			m.dselu(f_df, Alpha_t_Lambda, Lambda);
 		}
 
+		//computes dL/dZ = df(f_df).*dLdA in a single pass over the data (see iMath::dact_mul())
+		template <typename iMath>
+		static void df_mul(realmtx_t& f_df, const realmtx_t& dLdA, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!f_df.emulatesBiases() && f_df.size() == dLdA.size());
+			m.dselu_mul(f_df, dLdA, Alpha_t_Lambda, Lambda);
+		}
+
 		static constexpr real_t act_scaling_coeff()noexcept {
 			return Lambda;
 		}
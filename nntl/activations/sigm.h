@@ -56,12 +56,26 @@ namespace activation {
 			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
 			m.sigm(srcdest);
 		};
+		//same as f(), but computed by the calling thread only (see _i_function)
+		template <typename iMath>
+		static void f_st(realmtx_t& srcdest, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			m.sigm_st(srcdest);
+		};
 		template <typename iMath>
 		static void df(realmtx_t& f_df, iMath& m) noexcept {
 			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
 			NNTL_ASSERT(!f_df.emulatesBiases());
 			m.dsigm(f_df);
 		}
+
+		//computes dL/dZ = df(f_df).*dLdA in a single pass over the data (see iMath::dact_mul())
+		template <typename iMath>
+		static void df_mul(realmtx_t& f_df, const realmtx_t& dLdA, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!f_df.emulatesBiases() && f_df.size() == dLdA.size());
+			m.dsigm_mul(f_df, dLdA);
+		}
 	};
 
 	template<typename RealT, typename WeightsInitScheme = weights_init::Martens_SI_sigm<>, bool bNumericStable = false>
@@ -72,6 +86,11 @@ namespace activation {
 			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
 			m.dSigmQuadLoss_dZ(data_y, act_dLdZ);
 		}
+		template <typename iMath, bool bNS = bNumericStable>
+		static ::std::enable_if_t<!bNS, real_t> dLdZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ, iMath& m)noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			return m.dSigmQuadLoss_dZ_loss(data_y, act_dLdZ);
+		}
 
 		template <typename iMath, bool bNS = bNumericStable>
 		static ::std::enable_if_t<!bNS, real_t> loss(const realmtx_t& activations, const realmtx_t& data_y, iMath& m)noexcept {
@@ -97,7 +116,11 @@ namespace activation {
 			NNTL_ASSERT(!act_dLdZ.emulatesBiases() && !data_y.emulatesBiases());
 			m.evSub_ip(act_dLdZ, data_y);
 		}
-
+		template <typename iMath, bool bNS = bNumericStable>
+		static ::std::enable_if_t<!bNS, real_t> dLdZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ, iMath& m)noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			return m.dSigmXEntropyLoss_dZ_loss(data_y, act_dLdZ);
+		}
 
 		template <typename iMath, bool bNS = bNumericStable>
 		static ::std::enable_if_t<!bNS, real_t> loss(const realmtx_t& activations, const realmtx_t& data_y, iMath& m)noexcept {
@@ -53,6 +53,9 @@ namespace activation {
 	{
 	public:
 
+		//softmax of an element depends on all elements of the same row
+		static constexpr bool bElementwise = false;
+
 		//apply f to each srcdest matrix element. The biases (if any) must be left untouched!
 		template <typename iMath>
 		static void f(realmtxdef_t& srcdest, iMath& m) noexcept {
@@ -73,6 +76,12 @@ namespace activation {
 			NNTL_ASSERT(!act_dLdZ.emulatesBiases() && !data_y.emulatesBiases());
 			m.evSub_ip(act_dLdZ, data_y);
 		}
+		template <typename iMath>
+		static real_t dLdZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ, iMath& m)noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!act_dLdZ.emulatesBiases() && !data_y.emulatesBiases());
+			return m.dSoftmaxXEntropyLoss_dZ_loss(data_y, act_dLdZ);
+		}
 
 		template <typename iMath>
 		static real_t loss(const realmtx_t& activations, const realmtx_t& data_y, iMath& m)noexcept {
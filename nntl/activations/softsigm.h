@@ -59,6 +59,12 @@ namespace activation {
 			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
 			m.softsigm(srcdest, A);
 		};
+		//same as f(), but computed by the calling thread only (see _i_function)
+		template <typename iMath>
+		static void f_st(realmtx_t& srcdest, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			m.softsigm_st(srcdest, A);
+		};
 
 		template <typename iMath>
 		static void df(realmtx_t& f_df, iMath& m) noexcept {
@@ -66,6 +72,14 @@ namespace activation {
 			NNTL_ASSERT(!f_df.emulatesBiases());
 			m.dsoftsigm(f_df, A);
 		}
+
+		//computes dL/dZ = df(f_df).*dLdA in a single pass over the data (see iMath::dact_mul())
+		template <typename iMath>
+		static void df_mul(realmtx_t& f_df, const realmtx_t& dLdA, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!f_df.emulatesBiases() && f_df.size() == dLdA.size());
+			m.dsoftsigm_mul(f_df, dLdA, A);
+		}
 	};
 
 	template<typename RealT, typename WeightsInitScheme = weights_init::He_Zhang<>>
@@ -123,6 +137,11 @@ namespace activation {
 			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
 			m.dSoftSigmXEntropyLoss_dZ(data_y, act_dLdZ, A);
 		}
+		template <typename iMath, bool bNS = bNumericStable>
+		static ::std::enable_if_t<!bNS, real_t> dLdZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ, iMath& m)noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			return m.dSoftSigmXEntropyLoss_dZ_loss(data_y, act_dLdZ, A);
+		}
 
 		template <typename iMath, bool bNS = bNumericStable>
 		static ::std::enable_if_t<!bNS, real_t> loss(const realmtx_t& activations, const realmtx_t& data_y, iMath& m)noexcept {
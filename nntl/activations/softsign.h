@@ -70,6 +70,17 @@ namespace activation {
 			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
 			m.softsign_uc(srcdest, A);
 		};
+		//same as f(), but computed by the calling thread only (see _i_function)
+		template <typename iMath, bool bUnitC = bIsUnitC>
+		static ::std::enable_if_t<!bUnitC> f_st(realmtx_t& srcdest, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			m.softsign_st(srcdest, A, C);
+		};
+		template <typename iMath, bool bUnitC = bIsUnitC>
+		static ::std::enable_if_t<bUnitC> f_st(realmtx_t& srcdest, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			m.softsign_uc_st(srcdest, A);
+		};
 
 
 		template <typename iMath, bool bUnitAll = bIsUnitA && bIsUnitC>
@@ -84,6 +95,21 @@ namespace activation {
 			NNTL_ASSERT(!f_df.emulatesBiases());
 			m.dsoftsign_ua_uc(f_df);
 		}
+
+		//computes dL/dZ = df(f_df).*dLdA in a single pass over the data (see iMath::dact_mul())
+		template <typename iMath, bool bUnitAll = bIsUnitA && bIsUnitC>
+		static ::std::enable_if_t<!bUnitAll> df_mul(realmtx_t& f_df, const realmtx_t& dLdA, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!f_df.emulatesBiases() && f_df.size() == dLdA.size());
+			m.dsoftsign_mul(f_df, dLdA, A, C);
+		}
+
+		template <typename iMath, bool bUnitAll = bIsUnitA && bIsUnitC>
+		static ::std::enable_if_t<bUnitAll> df_mul(realmtx_t& f_df, const realmtx_t& dLdA, iMath& m) noexcept {
+			static_assert(::std::is_base_of<math::_i_math<real_t>, iMath>::value, "iMath should implement math::_i_math");
+			NNTL_ASSERT(!f_df.emulatesBiases() && f_df.size() == dLdA.size());
+			m.dsoftsign_ua_uc_mul(f_df, dLdA);
+		}
 	};
 
 	template<typename RealT, typename WeightsInitScheme = weights_init::He_Zhang<>>
@@ -98,6 +98,25 @@ namespace _impl {
 			NNTL_ASSERT(m_pMath && m_pRng && m_pInspect && m_pbNotLearningNow);
 		}
 
+		//makes a common data for a subset of layers that must use their own math & rng objects (see concurrent mode of
+		// layer_pack_horizontal). The rest is taken from the parent.
+		void init_as_child(const common_nn_data& parent, iMath_t& im, iRng_t& ir)noexcept {
+			NNTL_ASSERT(parent.m_pInspect && parent.m_pbNotLearningNow);
+			m_pMath = &im;
+			m_pRng = &ir;
+			m_pInspect = parent.m_pInspect;
+			m_pbNotLearningNow = parent.m_pbNotLearningNow;
+			m_max_fprop_batch_size = parent.m_max_fprop_batch_size;
+			m_training_batch_size = parent.m_training_batch_size;
+			sync_mode_from(parent);
+		}
+		//must be called for a child common data every time the parent's mode or batch size changes
+		void sync_mode_from(const common_nn_data& parent)noexcept {
+			NNTL_ASSERT(m_max_fprop_batch_size == parent.m_max_fprop_batch_size && m_training_batch_size == parent.m_training_batch_size);
+			m_cur_batch_size = parent.m_cur_batch_size;
+			m_bInTraining = parent.m_bInTraining;
+		}
+
 		void deinit()noexcept {
 			m_max_fprop_batch_size = 0;
 			m_training_batch_size = 0;
@@ -0,0 +1,98 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//Transports of the multi-process data parallel training (see nnet_distributed.h).
+// A transport connects a process (a rank) into a ring of size() processes and moves bytes between the ring neighbours
+// only: everything is sent to the next rank ((rank()+1) % size()) and received from the previous one. Collective
+// operations are built on top of that in allreduce.h, so a ring is all a transport has to provide.
+// A transport object is used by a single thread at a time (the training uses it from the communication thread of
+// grad_exchange and from the main thread between epochs).
+//
+// Available transports:
+// - shm_ring - POSIX shared memory, for processes on the same host;
+// - tcp_ring - TCP sockets, for processes on different hosts (or on the same host via the loopback interface).
+// shm_ring is implemented for POSIX systems only, tcp_ring for POSIX systems and Windows (Winsock).
+
+#include "../_defs.h"
+#include <cstddef>
+#include <chrono>
+
+#if defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))
+#define NNTL_DISTRIBUTED_POSIX 1
+#elif defined(_WIN32)
+#define NNTL_DISTRIBUTED_WINSOCK 1
+#endif
+
+namespace nntl {
+namespace distributed {
+
+	struct _i_transport {
+		//id of the process in the ring, [0, size())
+		nntl_interface int rank()const noexcept;
+		//total number of processes in the ring
+		nntl_interface int size()const noexcept;
+
+		//establishes the connections to the neighbours. Blocks until the neighbours are up or the timeout expires
+		nntl_interface bool connect()noexcept;
+		nntl_interface bool connected()const noexcept;
+		nntl_interface void disconnect()noexcept;
+
+		//sends sendBytes from pSend to the next rank and concurrently receives recvBytes into pRecv from the previous rank
+		// (so the ring never deadlocks, whatever the message size is). Returns when both transfers are complete.
+		// Returns false on an error or on the timeout; the transport is unusable after that.
+		// Every rank must make the same sequence of calls, the recvBytes of a rank must be equal to the sendBytes of the
+		// previous rank.
+		nntl_interface bool exchange(const void* pSend, const size_t sendBytes, void* pRecv, const size_t recvBytes)noexcept;
+	};
+
+	namespace _impl {
+		typedef ::std::chrono::steady_clock transport_clock_t;
+
+		struct transport_deadline {
+			const transport_clock_t::time_point at;
+
+			transport_deadline(const unsigned timeoutMs)noexcept
+				: at(transport_clock_t::now() + ::std::chrono::milliseconds(timeoutMs)) {}
+
+			bool expired()const noexcept { return transport_clock_t::now() >= at; }
+
+			//milliseconds left, never negative
+			int left_ms()const noexcept {
+				const auto l = ::std::chrono::duration_cast<::std::chrono::milliseconds>(at - transport_clock_t::now()).count();
+				return l > 0 ? static_cast<int>(l) : 0;
+			}
+		};
+	}
+
+}
+}
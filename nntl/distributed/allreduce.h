@@ -0,0 +1,288 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//Collective operations over a ring transport (see _i_transport.h) and the gradient averaging used by the distributed
+// training (see nnet_distributed.h).
+// Every rank must call the same functions in the same order with the same sizes. Results are bitwise the same on every
+// rank, which keeps the weights of the ranks identical without any further synchronization.
+
+#include "_i_transport.h"
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cstring>
+#include <cmath>
+
+namespace nntl {
+namespace distributed {
+
+	//ring allgather: all points to size()*msgBytes bytes and the message of the rank r is at all+r*msgBytes. On entry only
+	// the own message must be in place, on exit all of them are.
+	template<typename TransportT>
+	bool ring_allgather(TransportT& tr, void* all, const size_t msgBytes)noexcept {
+		const int N = tr.size(), r = tr.rank();
+		const auto p = static_cast<char*>(all);
+		for (int s = 0; s < N - 1; ++s) {
+			const size_t sendBlk = static_cast<size_t>((r - s + N) % N), recvBlk = static_cast<size_t>((r - s - 1 + N) % N);
+			if (!tr.exchange(p + sendBlk*msgBytes, msgBytes, p + recvBlk*msgBytes, msgBytes)) return false;
+		}
+		return true;
+	}
+
+	//ring allreduce (Patarasuk & Yuan, "Bandwidth optimal all-reduce algorithms for clusters of workstations", 2009):
+	// the vector is split into size() chunks, a reduce-scatter leaves the complete sum of the chunk r+1 on the rank r and
+	// an allgather distributes the sums. Both phases are size()-1 exchanges of a single chunk with the ring neighbours, so
+	// every rank sends about 2*n elements whatever the number of ranks is.
+	// On exit p holds the elementwise sum over all ranks. tmp is a scratch buffer.
+	template<typename TransportT, typename RealT>
+	bool ring_allreduce_sum(TransportT& tr, RealT* p, const size_t n, ::std::vector<RealT>& tmp)noexcept {
+		const int N = tr.size();
+		if (N <= 1 || !n) return N >= 1;
+		const int r = tr.rank();
+		const auto chunk_begin = [n, N](const int c)noexcept { return n*static_cast<size_t>(c) / static_cast<size_t>(N); };
+
+		const size_t maxChunk = (n + N - 1) / N;
+		if (tmp.size() < maxChunk) tmp.resize(maxChunk);
+		const auto pT = tmp.data();
+
+		//reduce-scatter: after the step s the chunk r-s-1 of the rank r holds the sum over s+2 ranks
+		for (int s = 0; s < N - 1; ++s) {
+			const int sc = (r - s + N) % N, rc = (r - s - 1 + N) % N;
+			const size_t sb = chunk_begin(sc), rb = chunk_begin(rc), rn = chunk_begin(rc + 1) - rb;
+			if (!tr.exchange(p + sb, (chunk_begin(sc + 1) - sb)*sizeof(RealT), pT, rn*sizeof(RealT))) return false;
+			const auto pD = p + rb;
+			for (size_t i = 0; i < rn; ++i) pD[i] += pT[i];
+		}
+		//allgather: the rank r starts with the complete chunk r+1
+		for (int s = 0; s < N - 1; ++s) {
+			const int sc = (r + 1 - s + N) % N, rc = (r - s + N) % N;
+			const size_t sb = chunk_begin(sc), rb = chunk_begin(rc);
+			if (!tr.exchange(p + sb, (chunk_begin(sc + 1) - sb)*sizeof(RealT), p + rb, (chunk_begin(rc + 1) - rb)*sizeof(RealT)))
+				return false;
+		}
+		return true;
+	}
+
+	enum class Compression {
+		None,//the exact ring allreduce
+		TopK,//see topk_codec
+		OneBit//see onebit_codec
+	};
+
+	//Top-k sparsification with the error feedback (Aji & Heafield, "Sparse Communication for Distributed Gradient
+	// Descent", 2017): only k elements of the biggest magnitude of g+residual are sent as (index, value) pairs, the rest
+	// stays in the residual and is added to the next gradient, so nothing is lost, just delayed.
+	template<typename RealT>
+	struct topk_codec {
+		typedef RealT real_t;
+		typedef uint32_t index_t;
+		static constexpr size_t pair_bytes = sizeof(index_t) + sizeof(real_t);
+
+		static size_t k(const size_t n, const real_t ratio)noexcept {
+			const auto k = static_cast<size_t>(::std::ceil(ratio*static_cast<real_t>(n)));
+			return ::std::min(n, ::std::max(k, size_t(1)));
+		}
+		static size_t msg_bytes(const size_t k)noexcept { return k*pair_bytes; }
+
+		//adds g to the residual res, moves k biggest elements of res into msg. idxs is a scratch buffer
+		static void encode(const real_t* g, real_t* res, const size_t n, const size_t k, char* msg
+			, ::std::vector<index_t>& idxs)noexcept
+		{
+			NNTL_ASSERT(k > 0 && k <= n && n <= ::std::numeric_limits<index_t>::max());
+			for (size_t i = 0; i < n; ++i) res[i] += g[i];
+
+			idxs.resize(n);
+			::std::iota(idxs.begin(), idxs.end(), index_t(0));
+			::std::nth_element(idxs.begin(), idxs.begin() + (k - 1), idxs.end(), [res](const index_t a, const index_t b)noexcept {
+				return ::std::abs(res[a]) > ::std::abs(res[b]);
+			});
+			for (size_t j = 0; j < k; ++j, msg += pair_bytes) {
+				const index_t idx = idxs[j];
+				::std::memcpy(msg, &idx, sizeof(idx));
+				::std::memcpy(msg + sizeof(idx), res + idx, sizeof(real_t));
+				res[idx] = real_t(0);
+			}
+		}
+
+		static void decode_add(const char* msg, const size_t k, real_t* p)noexcept {
+			for (size_t j = 0; j < k; ++j, msg += pair_bytes) {
+				index_t idx;
+				real_t v;
+				::std::memcpy(&idx, msg, sizeof(idx));
+				::std::memcpy(&v, msg + sizeof(idx), sizeof(v));
+				p[idx] += v;
+			}
+		}
+	};
+
+	//1-bit quantization with the error feedback (Seide et al., "1-Bit Stochastic Gradient Descent and its Application to
+	// Data-Parallel Distributed Training of Speech DNNs", 2014): only the sign of every element of g+residual is sent
+	// along with two scales, the means of the non-negative and of the negative elements. The quantization error stays
+	// in the residual.
+	template<typename RealT>
+	struct onebit_codec {
+		typedef RealT real_t;
+
+		static size_t msg_bytes(const size_t n)noexcept { return 2 * sizeof(real_t) + (n + 7) / 8; }
+
+		static void encode(const real_t* g, real_t* res, const size_t n, char* msg)noexcept {
+			double sPos = 0, sNeg = 0;
+			size_t cPos = 0;
+			for (size_t i = 0; i < n; ++i) {
+				const auto v = (res[i] += g[i]);
+				if (v >= real_t(0)) {
+					sPos += v;
+					++cPos;
+				} else sNeg += v;
+			}
+			const real_t mPos = cPos ? static_cast<real_t>(sPos / cPos) : real_t(0);
+			const real_t mNeg = cPos < n ? static_cast<real_t>(sNeg / (n - cPos)) : real_t(0);
+
+			::std::memcpy(msg, &mPos, sizeof(real_t));
+			::std::memcpy(msg + sizeof(real_t), &mNeg, sizeof(real_t));
+			const auto pBits = reinterpret_cast<unsigned char*>(msg + 2 * sizeof(real_t));
+			::std::memset(pBits, 0, (n + 7) / 8);
+			for (size_t i = 0; i < n; ++i) {
+				if (res[i] >= real_t(0)) {
+					pBits[i >> 3] |= static_cast<unsigned char>(1u << (i & 7));
+					res[i] -= mPos;
+				} else res[i] -= mNeg;
+			}
+		}
+
+		static void decode_add(const char* msg, const size_t n, real_t* p)noexcept {
+			real_t mPos, mNeg;
+			::std::memcpy(&mPos, msg, sizeof(real_t));
+			::std::memcpy(&mNeg, msg + sizeof(real_t), sizeof(real_t));
+			const auto pBits = reinterpret_cast<const unsigned char*>(msg + 2 * sizeof(real_t));
+			for (size_t i = 0; i < n; ++i) {
+				p[i] += (pBits[i >> 3] & (1u << (i & 7))) ? mPos : mNeg;
+			}
+		}
+	};
+
+	//averages vectors over all ranks of the transport, optionally compressing them. The compressed modes do a ring
+	// allgather of the compressed messages (sparse and quantized vectors can't be summed chunkwise on the way) and every
+	// rank decodes them in the rank order, so the result is still the same on every rank.
+	template<typename TransportT, typename RealT>
+	class allreducer {
+	public:
+		typedef TransportT transport_t;
+		typedef RealT real_t;
+
+	protected:
+		transport_t& m_tr;
+		::std::vector<real_t> m_tmp;
+		::std::vector<char> m_msgs;
+		::std::vector<uint32_t> m_idxs;
+		real_t m_topkRatio;
+		Compression m_compression;
+
+	public:
+		~allreducer()noexcept {}
+		allreducer(transport_t& tr)noexcept : m_tr(tr), m_topkRatio(real_t(.01)), m_compression(Compression::None) {}
+
+		transport_t& transport()const noexcept { return m_tr; }
+
+		//topkRatio is the share of elements TopK sends
+		allreducer& compression(const Compression c, const real_t topkRatio = real_t(.01))noexcept {
+			NNTL_ASSERT(topkRatio > 0 && topkRatio <= 1);
+			m_compression = c;
+			m_topkRatio = topkRatio;
+			return *this;
+		}
+		Compression compression()const noexcept { return m_compression; }
+		real_t topk_ratio()const noexcept { return m_topkRatio; }
+
+		//whether mean() requires a residual vector
+		bool needs_residual()const noexcept { return Compression::None != m_compression && m_tr.size() > 1; }
+
+		//the exact elementwise sum over all ranks
+		bool sum(real_t* p, const size_t n)noexcept {
+			return ring_allreduce_sum(m_tr, p, n, m_tmp);
+		}
+
+		//replaces p with its elementwise mean over all ranks. pResidual is n elements (zeros initially) that persist between
+		// calls for the same vector, required only when needs_residual()
+		bool mean(real_t* p, const size_t n, real_t* pResidual)noexcept {
+			const int N = m_tr.size();
+			if (N <= 1 || !n) return N >= 1;
+			NNTL_ASSERT(Compression::None == m_compression || pResidual);
+
+			const size_t myOfs = static_cast<size_t>(m_tr.rank());
+			switch (m_compression) {
+			case Compression::None:
+				if (!sum(p, n)) return false;
+				break;
+
+			case Compression::TopK: {
+				typedef topk_codec<real_t> codec_t;
+				const size_t k = codec_t::k(n, m_topkRatio), msgBytes = codec_t::msg_bytes(k);
+				m_msgs.resize(N*msgBytes);
+				codec_t::encode(p, pResidual, n, k, &m_msgs[myOfs*msgBytes], m_idxs);
+				if (!ring_allgather(m_tr, m_msgs.data(), msgBytes)) return false;
+				::std::fill(p, p + n, real_t(0));
+				for (int r = 0; r < N; ++r) codec_t::decode_add(&m_msgs[r*msgBytes], k, p);
+				break;
+			}
+
+			case Compression::OneBit: {
+				typedef onebit_codec<real_t> codec_t;
+				const size_t msgBytes = codec_t::msg_bytes(n);
+				m_msgs.resize(N*msgBytes);
+				codec_t::encode(p, pResidual, n, &m_msgs[myOfs*msgBytes]);
+				if (!ring_allgather(m_tr, m_msgs.data(), msgBytes)) return false;
+				::std::fill(p, p + n, real_t(0));
+				for (int r = 0; r < N; ++r) codec_t::decode_add(&m_msgs[r*msgBytes], n, p);
+				break;
+			}
+
+			default:
+				NNTL_ASSERT(!"WTF??");
+				return false;
+			}
+
+			const real_t s = real_t(1) / static_cast<real_t>(N);
+			for (size_t i = 0; i < n; ++i) p[i] *= s;
+			return true;
+		}
+
+		//grad_exchange::reduce_func_t compatible adapter of mean()
+		static bool mean_func(void* pThis, real_t* p, const size_t n, real_t* pResidual)noexcept {
+			return static_cast<allreducer*>(pThis)->mean(p, n, pResidual);
+		}
+	};
+
+}
+}
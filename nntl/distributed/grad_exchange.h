@@ -0,0 +1,165 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//grad_exchange averages the weight gradients of _grad_works objects over the ranks of a distributed training on its
+// background communication thread. _grad_works::apply_grad() copies dL/dW and starts the averaging, the update itself is
+// done by _grad_works::complete_grad() that layers::bprop() calls at its end, so the averaging of an upper layer gradient
+// overlaps with the backward pass of lower layers.
+// The averagings are done strictly in the order they were started. Every rank runs the same bprop() and so starts them in
+// the same order, which is what the ring collectives require.
+
+#include "../interface/threads/bgworkers.h"
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <limits>
+
+namespace nntl {
+namespace distributed {
+
+	template<typename RealT>
+	class grad_exchange {
+	public:
+		typedef RealT real_t;
+		typedef size_t slot_id_t;
+		static constexpr slot_id_t invalid_slot = ::std::numeric_limits<slot_id_t>::max();
+
+		//must replace n elements of p with their mean over all ranks. pResidual is n elements of the slot (zeros initially)
+		// that persist between calls, or nullptr if the residual wasn't requested. See allreducer::mean_func()
+		typedef bool(*reduce_func_t)(void* pCtx, real_t* p, const size_t n, real_t* pResidual);
+
+	protected:
+		typedef threads::futex_word::value_t state_t;
+		static constexpr state_t s_idle = 0;
+		static constexpr state_t s_inFlight = 1;
+		static constexpr state_t s_done = 2;
+		static constexpr state_t s_failed = 3;
+
+		struct slot_t {
+			const void* pOwner;
+			real_t* pData;
+			size_t n;
+			::std::vector<real_t> residual;
+			threads::futex_word state;
+
+			slot_t(const void* pO, const size_t _n)noexcept : pOwner(pO), pData(nullptr), n(_n), state(s_idle) {}
+		};
+
+	protected:
+		//slots are allocated individually, because a job references its slot while new slots may be added
+		::std::vector<::std::unique_ptr<slot_t>> m_slots;
+		threads::BgWorkers<> m_comm;
+		reduce_func_t m_pfnReduce;
+		void* m_pCtx;
+		::std::atomic<bool> m_bFailed;
+		const bool m_bResidual;
+
+	public:
+		~grad_exchange()noexcept {
+			for (slot_id_t i = 0; i < m_slots.size(); ++i) wait(i);
+		}
+		grad_exchange(const grad_exchange& other)noexcept = delete;
+		grad_exchange& operator=(const grad_exchange& rhs)noexcept = delete;
+
+		//pfnReduce(pCtx,...) is called from the communication thread. bResidual requests a residual vector for every slot
+		grad_exchange(reduce_func_t pfnReduce, void* pCtx, const bool bResidual)noexcept
+			: m_comm(1, threads::PriorityClass::threads_priority_no_change), m_pfnReduce(pfnReduce), m_pCtx(pCtx)
+			, m_bFailed(false), m_bResidual(bResidual)
+		{
+			NNTL_ASSERT(pfnReduce);
+		}
+
+		//true if any averaging has failed (a transport error or a timeout). Further averagings are skipped then
+		bool failed()const noexcept { return m_bFailed.load(::std::memory_order_acquire); }
+		void fail()noexcept { m_bFailed.store(true, ::std::memory_order_release); }
+
+		size_t slots_count()const noexcept { return m_slots.size(); }
+
+		//returns the slot of the owner (a _grad_works object) for n elements, making it if needed. Returns invalid_slot on
+		// memory allocation failure. slot() and start() aren't thread-safe and the collectives they issue must go in the same
+		// order on every rank, so they must be called by a single thread (see ConcurrentTasksUnsupported in nnet_distributed)
+		slot_id_t slot(const void* pOwner, const size_t n)noexcept {
+			NNTL_ASSERT(pOwner && n);
+			for (slot_id_t i = 0; i < m_slots.size(); ++i) {
+				auto& s = *m_slots[i];
+				if (s.pOwner == pOwner) {
+					if (s.n != n) {
+						wait(i);
+						s.n = n;
+						if (m_bResidual) s.residual.assign(n, real_t(0));
+					}
+					return i;
+				}
+			}
+			::std::unique_ptr<slot_t> pS(new(::std::nothrow) slot_t(pOwner, n));
+			if (!pS) return invalid_slot;
+			if (m_bResidual) pS->residual.assign(n, real_t(0));
+			m_slots.push_back(::std::move(pS));
+			return m_slots.size() - 1;
+		}
+
+		//starts averaging n (set by slot()) elements of p over the ranks. p must remain valid until wait()
+		void start(const slot_id_t id, real_t* p)noexcept {
+			NNTL_ASSERT(id < m_slots.size() && p);
+			const auto pS = m_slots[id].get();
+			NNTL_ASSERT(s_idle == pS->state.load());
+			pS->pData = p;
+			pS->state.store(s_inFlight);
+			//a lane holds hundreds of jobs, a full one means the communication is way too slow, so just wait for a room
+			while (!m_comm.post([this, pS](const thread_id_t)noexcept { _reduce(*pS); })) {
+				::std::this_thread::yield();
+			}
+		}
+
+		//waits for the averaging of the slot to finish. Returns true if it succeeded, false if it failed or if
+		// it wasn't started
+		bool wait(const slot_id_t id)noexcept {
+			NNTL_ASSERT(id < m_slots.size());
+			auto& st = m_slots[id]->state;
+			const auto v = st.wait_while_equal(s_inFlight, 1024);
+			st.store(s_idle);
+			return s_done == v;
+		}
+
+	protected:
+		void _reduce(slot_t& s)noexcept {
+			const bool bOk = !failed()
+				&& m_pfnReduce(m_pCtx, s.pData, s.n, s.residual.empty() ? nullptr : s.residual.data());
+			if (!bOk) fail();
+			s.state.store(bOk ? s_done : s_failed);
+			s.state.wake_all();
+		}
+	};
+
+}
+}
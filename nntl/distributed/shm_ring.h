@@ -0,0 +1,373 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//POSIX shared memory transport for processes of the same host (see _i_transport.h).
+// Every rank creates its outgoing ring buffer as a shared memory object named "/<name>_<rank>" and maps the outgoing
+// ring buffer of the previous rank. A ring buffer is a single producer single consumer queue of bytes: the producer
+// advances the head, the consumer advances the tail, both are lock-free atomics on separate cache lines, so there are no
+// process shared mutexes and a crashed peer can't leave a lock behind (the peers just time out).
+// Use a name that is unique to the job. connect() removes a stale object of the same name left by a crashed run, but a
+// concurrently running job with the same name would be disrupted.
+// A consumer may map such a stale object before the producer replaces it, so connect() ends with a handshake: the consumer
+// writes a fresh per-connect nonce into the header of the ring it has mapped and waits until the producer echoes it.
+// Nobody echoes in a stale object, and once the name refers to another object the consumer maps that one instead.
+
+#include "_i_transport.h"
+#include "../interface/threads/_sync_primitives.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <cstring>
+#include <thread>
+#include <algorithm>
+#include <new>
+
+#if defined(NNTL_DISTRIBUTED_POSIX)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#pragma message("shm_ring is implemented only for POSIX systems, its connect() always fails")
+#endif
+
+namespace nntl {
+namespace distributed {
+
+	class shm_ring : public _i_transport {
+	public:
+		static constexpr size_t default_capacity = size_t(1) << 22;
+		static constexpr unsigned default_timeout_ms = 60000;
+
+	protected:
+		static constexpr uint64_t header_magic = 0x314d48534c544e4eull;//"NNTLSHM1"
+		static constexpr size_t cache_line = 64;
+		//how many times exchange() spins without any progress before yielding, and then before sleeping
+		static constexpr unsigned spin_count = 4096;
+
+		static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "The shared memory ring requires lock-free (and so address-free) 64 bit atomics");
+
+		struct alignas(64) header_t {
+			::std::atomic<uint64_t> head;//total bytes written, changed by the producer only
+			char _pad0[cache_line - sizeof(::std::atomic<uint64_t>)];
+			::std::atomic<uint64_t> tail;//total bytes read, changed by the consumer only
+			char _pad1[cache_line - sizeof(::std::atomic<uint64_t>)];
+			uint64_t capacity;
+			::std::atomic<uint64_t> magic;//the producer sets it last, when the ring is ready
+			::std::atomic<uint64_t> peerNonce;//the consumer writes its per-connect nonce here after it has mapped the ring
+			::std::atomic<uint64_t> nonceEcho;//the producer copies peerNonce here, so the consumer knows the ring is live
+		};
+
+		struct segment_t {
+			header_t* pHdr;
+			char* pData;
+			size_t mapBytes;
+			uint64_t cap;
+			uint64_t dev, ino;//identity of the mapped object, to find out if the name was given to another one
+
+			segment_t()noexcept : pHdr(nullptr), pData(nullptr), mapBytes(0), cap(0), dev(0), ino(0) {}
+		};
+
+	protected:
+		::std::string m_name;
+		segment_t m_out, m_in;
+		size_t m_capacity;
+		int m_rank, m_size;
+		unsigned m_timeoutMs;
+		bool m_bConnected;
+
+	public:
+		~shm_ring()noexcept {
+			disconnect();
+		}
+		shm_ring(const shm_ring& other)noexcept = delete;
+		shm_ring& operator=(const shm_ring& rhs)noexcept = delete;
+
+		//name must be unique to the job and valid as a part of a file name. capacity is the size of the outgoing ring buffer
+		// in bytes, timeoutMs bounds the waiting for the peers during connect() and the time exchange() may go
+		// without any progress
+		shm_ring(const char* name, const int rank, const int size, const size_t capacity = default_capacity
+			, const unsigned timeoutMs = default_timeout_ms)noexcept
+			: m_name(name), m_capacity(capacity), m_rank(rank), m_size(size), m_timeoutMs(timeoutMs), m_bConnected(false)
+		{
+			NNTL_ASSERT(size > 0 && rank >= 0 && rank < size && capacity > 0);
+		}
+
+		int rank()const noexcept { return m_rank; }
+		int size()const noexcept { return m_size; }
+		bool connected()const noexcept { return m_bConnected; }
+
+		bool connect()noexcept {
+			disconnect();
+			if (m_size <= 0 || m_rank < 0 || m_rank >= m_size || !m_capacity) return false;
+			if (m_size > 1 && (!_create_out() || !_handshake())) {
+				disconnect();
+				return false;
+			}
+			m_bConnected = true;
+			return true;
+		}
+
+		void disconnect()noexcept {
+			m_bConnected = false;
+			_unmap(m_in);
+			if (m_out.pHdr) {
+				_unmap(m_out);
+				_unlink(m_rank);
+			}
+		}
+
+		bool exchange(const void* pSend, const size_t sendBytes, void* pRecv, const size_t recvBytes)noexcept {
+			NNTL_ASSERT(m_bConnected);
+			if (!m_bConnected) return false;
+			if (1 == m_size) {
+				if (sendBytes != recvBytes) return false;
+				if (sendBytes && pSend != pRecv) ::std::memmove(pRecv, pSend, sendBytes);
+				return true;
+			}
+
+			const auto pS = static_cast<const char*>(pSend);
+			const auto pR = static_cast<char*>(pRecv);
+			size_t sent = 0, recvd = 0;
+			unsigned idle = 0;
+			_impl::transport_clock_t::time_point idleSince;
+			while (sent < sendBytes || recvd < recvBytes) {
+				size_t n = 0;
+				if (sent < sendBytes) {
+					const auto w = _write(pS + sent, sendBytes - sent);
+					sent += w;
+					n += w;
+				}
+				if (recvd < recvBytes) {
+					const auto r = _read(pR + recvd, recvBytes - recvd);
+					recvd += r;
+					n += r;
+				}
+
+				if (n) {
+					idle = 0;
+				} else if (++idle < spin_count) {
+					NNTL_CPU_RELAX();
+				} else {
+					if (spin_count == idle) {
+						idleSince = _impl::transport_clock_t::now();
+					} else if (_impl::transport_clock_t::now() - idleSince > ::std::chrono::milliseconds(m_timeoutMs)) {
+						disconnect();
+						return false;
+					}
+					if (idle < 2 * spin_count) {
+						::std::this_thread::yield();
+					} else ::std::this_thread::sleep_for(::std::chrono::microseconds(50));
+				}
+			}
+			return true;
+		}
+
+	protected:
+		::std::string _seg_name(const int r)const {
+			return "/" + m_name + "_" + ::std::to_string(r);
+		}
+
+		//nonzero and different for every connect() of every rank of every process (with overwhelming probability)
+		uint64_t _make_nonce()const noexcept {
+			static ::std::atomic<uint64_t> counter(0);
+			uint64_t z = static_cast<uint64_t>(_impl::transport_clock_t::now().time_since_epoch().count())
+				^ (static_cast<uint64_t>(reinterpret_cast<::std::uintptr_t>(this)) << 7) ^ (counter.fetch_add(1) << 48)
+				^ static_cast<uint64_t>(m_rank) ^ _pid();
+			//splitmix64 finalizer
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+			z ^= z >> 31;
+			return z ? z : 1;
+		}
+
+		//echoes the nonce of the next rank into our outgoing ring and waits until the previous rank echoes ours in the
+		// ring we read. Both sides are polled in one loop, because every rank is a producer and a consumer at once
+		bool _handshake()noexcept {
+			const uint64_t nonce = _make_nonce();
+			const _impl::transport_deadline dl(m_timeoutMs);
+			auto nextCheck = _impl::transport_clock_t::now();
+			bool bOutDone = false, bInDone = false;
+			while (true) {
+				if (!bOutDone) {
+					const auto pn = m_out.pHdr->peerNonce.load(::std::memory_order_acquire);
+					if (pn) {
+						m_out.pHdr->nonceEcho.store(pn, ::std::memory_order_release);
+						bOutDone = true;
+					}
+				}
+				if (!bInDone) {
+					if (!m_in.pHdr) _open_in();
+					if (m_in.pHdr) {
+						auto& h = *m_in.pHdr;
+						if (!m_in.cap && header_magic == h.magic.load(::std::memory_order_acquire)) {
+							const auto cap = h.capacity;
+							if (cap > 0 && cap + sizeof(header_t) <= m_in.mapBytes) {
+								m_in.cap = cap;
+								h.peerNonce.store(nonce, ::std::memory_order_release);
+							} else _unmap(m_in);//broken leftover, wait for the producer to replace it
+						}
+						if (m_in.cap && nonce == h.nonceEcho.load(::std::memory_order_acquire)) {
+							bInDone = true;
+						} else if (m_in.pHdr && _impl::transport_clock_t::now() >= nextCheck) {
+							nextCheck = _impl::transport_clock_t::now() + ::std::chrono::milliseconds(10);
+							if (_is_replaced_in()) _unmap(m_in);
+						}
+					}
+				}
+				if (bOutDone && bInDone) return true;
+				if (dl.expired()) return false;
+				::std::this_thread::sleep_for(::std::chrono::milliseconds(1));
+			}
+		}
+
+		//writes as much as the outgoing ring has space for
+		size_t _write(const char* p, const size_t len)noexcept {
+			auto& h = *m_out.pHdr;
+			const uint64_t cap = m_out.cap;
+			const uint64_t head = h.head.load(::std::memory_order_relaxed);
+			const uint64_t tail = h.tail.load(::std::memory_order_acquire);
+			const size_t n = static_cast<size_t>(::std::min<uint64_t>(len, cap - (head - tail)));
+			if (n) {
+				const size_t ofs = static_cast<size_t>(head % cap);
+				const size_t n1 = ::std::min(n, static_cast<size_t>(cap) - ofs);
+				::std::memcpy(m_out.pData + ofs, p, n1);
+				if (n > n1) ::std::memcpy(m_out.pData, p + n1, n - n1);
+				h.head.store(head + n, ::std::memory_order_release);
+			}
+			return n;
+		}
+
+		//reads as much as the incoming ring has
+		size_t _read(char* p, const size_t len)noexcept {
+			auto& h = *m_in.pHdr;
+			const uint64_t cap = m_in.cap;
+			const uint64_t tail = h.tail.load(::std::memory_order_relaxed);
+			const uint64_t head = h.head.load(::std::memory_order_acquire);
+			const size_t n = static_cast<size_t>(::std::min<uint64_t>(len, head - tail));
+			if (n) {
+				const size_t ofs = static_cast<size_t>(tail % cap);
+				const size_t n1 = ::std::min(n, static_cast<size_t>(cap) - ofs);
+				::std::memcpy(p, m_in.pData + ofs, n1);
+				if (n > n1) ::std::memcpy(p + n1, m_in.pData, n - n1);
+				h.tail.store(tail + n, ::std::memory_order_release);
+			}
+			return n;
+		}
+
+#if defined(NNTL_DISTRIBUTED_POSIX)
+		static bool _map(const int fd, const size_t bytes, segment_t& seg)noexcept {
+			void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (MAP_FAILED == p) return false;
+			seg.pHdr = static_cast<header_t*>(p);
+			seg.pData = static_cast<char*>(p) + sizeof(header_t);
+			seg.mapBytes = bytes;
+			return true;
+		}
+
+		static void _unmap(segment_t& seg)noexcept {
+			if (seg.pHdr) ::munmap(seg.pHdr, seg.mapBytes);
+			seg = segment_t();
+		}
+
+		void _unlink(const int r)const noexcept {
+			::shm_unlink(_seg_name(r).c_str());
+		}
+
+		bool _create_out()noexcept {
+			const auto name = _seg_name(m_rank);
+			::shm_unlink(name.c_str());//a leftover of a crashed run
+			const int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+			if (fd < 0) return false;
+			const size_t bytes = sizeof(header_t) + m_capacity;
+			const bool bOk = 0 == ::ftruncate(fd, static_cast<off_t>(bytes)) && _map(fd, bytes, m_out);
+			::close(fd);
+			if (!bOk) {
+				::shm_unlink(name.c_str());
+				return false;
+			}
+
+			auto pHdr = new(m_out.pHdr) header_t;
+			pHdr->head.store(0, ::std::memory_order_relaxed);
+			pHdr->tail.store(0, ::std::memory_order_relaxed);
+			pHdr->capacity = m_capacity;
+			pHdr->peerNonce.store(0, ::std::memory_order_relaxed);
+			pHdr->nonceEcho.store(0, ::std::memory_order_relaxed);
+			pHdr->magic.store(header_magic, ::std::memory_order_release);
+			m_out.cap = m_capacity;
+			return true;
+		}
+
+		::std::string _in_name()const {
+			return _seg_name((m_rank + m_size - 1) % m_size);
+		}
+
+		//tries to map the outgoing ring of the previous rank, which may be not made yet (or be a leftover)
+		bool _open_in()noexcept {
+			const int fd = ::shm_open(_in_name().c_str(), O_RDWR, 0600);
+			if (fd < 0) return false;
+			struct stat st;
+			const bool bSized = 0 == ::fstat(fd, &st) && static_cast<size_t>(st.st_size) > sizeof(header_t);
+			const bool bMapped = bSized && _map(fd, static_cast<size_t>(st.st_size), m_in);
+			::close(fd);
+			if (bMapped) {
+				m_in.dev = static_cast<uint64_t>(st.st_dev);
+				m_in.ino = static_cast<uint64_t>(st.st_ino);
+			}
+			return bMapped;
+		}
+
+		//true if the name of the incoming ring no longer refers to the mapped object
+		bool _is_replaced_in()const noexcept {
+			const int fd = ::shm_open(_in_name().c_str(), O_RDONLY, 0600);
+			if (fd < 0) return true;
+			struct stat st;
+			const bool bSame = 0 == ::fstat(fd, &st) && m_in.dev == static_cast<uint64_t>(st.st_dev)
+				&& m_in.ino == static_cast<uint64_t>(st.st_ino);
+			::close(fd);
+			return !bSame;
+		}
+
+		static uint64_t _pid()noexcept { return static_cast<uint64_t>(::getpid()) << 32; }
+#else
+		static void _unmap(segment_t& seg)noexcept { seg = segment_t(); }
+		void _unlink(const int)const noexcept {}
+		bool _create_out()noexcept { return false; }
+		bool _open_in()noexcept { return false; }
+		bool _is_replaced_in()const noexcept { return true; }
+		static uint64_t _pid()noexcept { return 0; }
+#endif
+	};
+
+}
+}
@@ -0,0 +1,425 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//TCP transport (see _i_transport.h). The rank r listens on the port basePort+r of its host, connects to the next rank
+// and accepts the connection of the previous one, so a ring of N ranks uses N connections. Sockets are non-blocking with
+// the Nagle's algorithm turned off, exchange() drives both directions at once with poll() (WSAPoll() on Windows).
+// With all hosts set to "127.0.0.1" the ring runs over the loopback interface of a single machine, which is handy for tests.
+//
+// On Windows the header must be included before <windows.h> (or <windows.h> must be included with WIN32_LEAN_AND_MEAN
+// defined), because winsock2.h conflicts with the winsock.h that <windows.h> brings in otherwise.
+
+#include "_i_transport.h"
+#include <cstdint>
+#include <string>
+#include <cstring>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <limits>
+
+#if defined(NNTL_DISTRIBUTED_POSIX)
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#elif defined(NNTL_DISTRIBUTED_WINSOCK)
+#if defined(_WINSOCKAPI_) && !defined(_WINSOCK2API_)
+#error "tcp_ring.h must be included before <windows.h> or WIN32_LEAN_AND_MEAN must be defined"
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#pragma message("tcp_ring is implemented only for POSIX systems and Windows, its connect() always fails")
+#endif
+
+namespace nntl {
+namespace distributed {
+
+#if defined(NNTL_DISTRIBUTED_POSIX) || defined(NNTL_DISTRIBUTED_WINSOCK)
+	namespace _impl {
+		//the few socket calls that differ between BSD sockets and Winsock
+		struct tcp_sys {
+#if defined(NNTL_DISTRIBUTED_WINSOCK)
+			typedef SOCKET socket_t;
+			static constexpr socket_t invalid_socket = INVALID_SOCKET;
+
+			//Winsock is reference counted, every successful startup() must be paired with cleanup()
+			static bool startup()noexcept {
+				::WSADATA wd;
+				return 0 == ::WSAStartup(MAKEWORD(2, 2), &wd);
+			}
+			static void cleanup()noexcept { ::WSACleanup(); }
+
+			static void close(const socket_t s)noexcept { ::closesocket(s); }
+			static int last_error()noexcept { return ::WSAGetLastError(); }
+			static bool interrupted(const int e)noexcept { return WSAEINTR == e; }
+			static bool would_block(const int e)noexcept { return WSAEWOULDBLOCK == e || WSAEINTR == e; }
+			static bool connect_in_progress(const int e)noexcept { return WSAEWOULDBLOCK == e; }
+
+			static int poll(::pollfd* pFds, const unsigned n, const int ms)noexcept {
+				return ::WSAPoll(pFds, static_cast<ULONG>(n), ms);
+			}
+
+			static bool set_nonblocking(const socket_t s)noexcept {
+				u_long one = 1;
+				return 0 == ::ioctlsocket(s, FIONBIO, &one);
+			}
+			//SO_REUSEADDR lets another socket steal a bound port on Windows, the TIME_WAIT doesn't block listen()ing anyway
+			static void set_reuse_addr(const socket_t)noexcept {}
+
+			//a failed non-blocking connect() isn't reported by WSAPoll() on some versions of Windows, select() reports it
+			static bool wait_connected(const socket_t s, const int ms)noexcept {
+				::fd_set wfds, efds;
+				FD_ZERO(&wfds);
+				FD_ZERO(&efds);
+				FD_SET(s, &wfds);
+				FD_SET(s, &efds);
+				::timeval tv;
+				tv.tv_sec = ms / 1000;
+				tv.tv_usec = (ms % 1000) * 1000;
+				return ::select(0, nullptr, &wfds, &efds, &tv) > 0 && !FD_ISSET(s, &efds) && FD_ISSET(s, &wfds);
+			}
+#else
+			typedef int socket_t;
+			static constexpr socket_t invalid_socket = -1;
+
+			static bool startup()noexcept { return true; }
+			static void cleanup()noexcept {}
+
+			static void close(const socket_t s)noexcept { ::close(s); }
+			static int last_error()noexcept { return errno; }
+			static bool interrupted(const int e)noexcept { return EINTR == e; }
+			static bool would_block(const int e)noexcept { return EAGAIN == e || EWOULDBLOCK == e || EINTR == e; }
+			static bool connect_in_progress(const int e)noexcept { return EINPROGRESS == e; }
+
+			static int poll(::pollfd* pFds, const unsigned n, const int ms)noexcept {
+				return ::poll(pFds, static_cast<nfds_t>(n), ms);
+			}
+
+			static bool set_nonblocking(const socket_t s)noexcept {
+				const int fl = ::fcntl(s, F_GETFL, 0);
+				return fl >= 0 && 0 == ::fcntl(s, F_SETFL, fl | O_NONBLOCK);
+			}
+			//lets a restarted rank bind its port while the connections of the previous run are in TIME_WAIT
+			static void set_reuse_addr(const socket_t s)noexcept {
+				set_opt(s, SOL_SOCKET, SO_REUSEADDR, 1);
+			}
+
+			static bool wait_connected(const socket_t s, const int ms)noexcept {
+				::pollfd pfd;
+				pfd.fd = s;
+				pfd.events = POLLOUT;
+				pfd.revents = 0;
+				return ::poll(&pfd, 1, ms) > 0;
+			}
+#endif
+			static bool set_opt(const socket_t s, const int level, const int name, const int v)noexcept {
+				return 0 == ::setsockopt(s, level, name, reinterpret_cast<const char*>(&v), sizeof(v));
+			}
+
+			static int send_flags()noexcept {
+#if defined(MSG_NOSIGNAL)
+				return MSG_NOSIGNAL;
+#else
+				return 0;
+#endif
+			}
+
+			//Winsock takes int lengths, the rest goes with the next call
+			static int io_len(const size_t len)noexcept {
+				return static_cast<int>(::std::min(len, static_cast<size_t>(::std::numeric_limits<int>::max())));
+			}
+			static ptrdiff_t send(const socket_t s, const char* p, const size_t len)noexcept {
+				return static_cast<ptrdiff_t>(::send(s, p, io_len(len), send_flags()));
+			}
+			static ptrdiff_t recv(const socket_t s, char* p, const size_t len)noexcept {
+				return static_cast<ptrdiff_t>(::recv(s, p, io_len(len), 0));
+			}
+		};
+	}
+#endif
+
+	class tcp_ring : public _i_transport {
+	public:
+		static constexpr unsigned default_timeout_ms = 60000;
+
+	protected:
+		::std::vector<::std::string> m_hosts;
+#if defined(NNTL_DISTRIBUTED_POSIX) || defined(NNTL_DISTRIBUTED_WINSOCK)
+		typedef _impl::tcp_sys sys;
+		typedef sys::socket_t socket_t;
+
+		socket_t m_out, m_in;//sockets to the next and from the previous rank
+#endif
+		int m_rank, m_size;
+		unsigned m_timeoutMs;
+		uint16_t m_basePort;
+		bool m_bConnected;
+		bool m_bSysStarted;
+
+	public:
+		~tcp_ring()noexcept {
+			disconnect();
+#if defined(NNTL_DISTRIBUTED_POSIX) || defined(NNTL_DISTRIBUTED_WINSOCK)
+			if (m_bSysStarted) sys::cleanup();
+#endif
+		}
+		tcp_ring(const tcp_ring& other)noexcept = delete;
+		tcp_ring& operator=(const tcp_ring& rhs)noexcept = delete;
+
+		//hosts[r] is the host name or the IPv4 address of the rank r, a single entry is used for every rank.
+		// timeoutMs bounds the waiting for the peers during connect() and the time exchange() may go without any progress
+		tcp_ring(const int rank, const int size, const ::std::vector<::std::string>& hosts, const uint16_t basePort
+			, const unsigned timeoutMs = default_timeout_ms)noexcept
+			: m_hosts(hosts)
+#if defined(NNTL_DISTRIBUTED_POSIX) || defined(NNTL_DISTRIBUTED_WINSOCK)
+			, m_out(sys::invalid_socket), m_in(sys::invalid_socket)
+#endif
+			, m_rank(rank), m_size(size), m_timeoutMs(timeoutMs), m_basePort(basePort), m_bConnected(false), m_bSysStarted(false)
+		{
+			NNTL_ASSERT(size > 0 && rank >= 0 && rank < size);
+			NNTL_ASSERT(1 == hosts.size() || static_cast<size_t>(size) == hosts.size());
+		}
+
+		int rank()const noexcept { return m_rank; }
+		int size()const noexcept { return m_size; }
+		bool connected()const noexcept { return m_bConnected; }
+
+		const ::std::string& host(const int r)const noexcept {
+			return m_hosts[m_hosts.size() > 1 ? static_cast<size_t>(r) : 0];
+		}
+
+#if defined(NNTL_DISTRIBUTED_POSIX) || defined(NNTL_DISTRIBUTED_WINSOCK)
+		bool connect()noexcept {
+			disconnect();
+			if (m_size <= 0 || m_rank < 0 || m_rank >= m_size || m_hosts.empty()
+				|| (m_hosts.size() > 1 && m_hosts.size() != static_cast<size_t>(m_size))) return false;
+
+			if (m_size > 1) {
+				if (!m_bSysStarted) {
+					if (!sys::startup()) return false;
+					m_bSysStarted = true;
+				}
+				const _impl::transport_deadline dl(m_timeoutMs);
+				const socket_t lsn = _listen();
+				//the connection to the next rank completes in its listen backlog, so connecting before accepting can't deadlock
+				const bool bOk = sys::invalid_socket != lsn && _connect_next(dl) && _accept_prev(lsn, dl);
+				if (sys::invalid_socket != lsn) sys::close(lsn);
+				if (!bOk) {
+					disconnect();
+					return false;
+				}
+			}
+			m_bConnected = true;
+			return true;
+		}
+
+		void disconnect()noexcept {
+			m_bConnected = false;
+			if (sys::invalid_socket != m_out) sys::close(m_out);
+			if (sys::invalid_socket != m_in) sys::close(m_in);
+			m_out = m_in = sys::invalid_socket;
+		}
+
+		bool exchange(const void* pSend, const size_t sendBytes, void* pRecv, const size_t recvBytes)noexcept {
+			NNTL_ASSERT(m_bConnected);
+			if (!m_bConnected) return false;
+			if (1 == m_size) {
+				if (sendBytes != recvBytes) return false;
+				if (sendBytes && pSend != pRecv) ::std::memmove(pRecv, pSend, sendBytes);
+				return true;
+			}
+
+			const auto pS = static_cast<const char*>(pSend);
+			const auto pR = static_cast<char*>(pRecv);
+			size_t sent = 0, recvd = 0;
+			while (sent < sendBytes || recvd < recvBytes) {
+				::pollfd fds[2];
+				unsigned nfds = 0;
+				int iOut = -1, iIn = -1;
+				if (sent < sendBytes) {
+					iOut = static_cast<int>(nfds++);
+					fds[iOut].fd = m_out;
+					fds[iOut].events = POLLOUT;
+					fds[iOut].revents = 0;
+				}
+				if (recvd < recvBytes) {
+					iIn = static_cast<int>(nfds++);
+					fds[iIn].fd = m_in;
+					fds[iIn].events = POLLIN;
+					fds[iIn].revents = 0;
+				}
+
+				const int pr = sys::poll(fds, nfds, static_cast<int>(m_timeoutMs));
+				if (pr < 0 && sys::interrupted(sys::last_error())) continue;
+				if (pr <= 0) return _fail();
+
+				if (iOut >= 0 && fds[iOut].revents) {
+					if (fds[iOut].revents & POLLNVAL) return _fail();
+					const auto n = sys::send(m_out, pS + sent, sendBytes - sent);
+					if (n > 0) {
+						sent += static_cast<size_t>(n);
+					} else if (!sys::would_block(sys::last_error())) return _fail();
+				}
+				if (iIn >= 0 && fds[iIn].revents) {
+					if (fds[iIn].revents & POLLNVAL) return _fail();
+					const auto n = sys::recv(m_in, pR + recvd, recvBytes - recvd);
+					if (n > 0) {
+						recvd += static_cast<size_t>(n);
+					} else if (0 == n || !sys::would_block(sys::last_error())) return _fail();//0 means the peer has closed the connection
+				}
+			}
+			return true;
+		}
+
+	protected:
+		bool _fail()noexcept {
+			disconnect();
+			return false;
+		}
+
+		static bool _setup_socket(const socket_t s)noexcept {
+#if defined(SO_NOSIGPIPE)
+			sys::set_opt(s, SOL_SOCKET, SO_NOSIGPIPE, 1);
+#endif
+			return sys::set_nonblocking(s) && sys::set_opt(s, IPPROTO_TCP, TCP_NODELAY, 1);
+		}
+
+		//sends or receives exactly len bytes over the non-blocking socket s
+		template<bool bSend>
+		static bool _xfer_all(const socket_t s, char* p, size_t len, const _impl::transport_deadline& dl)noexcept {
+			while (len) {
+				::pollfd pfd;
+				pfd.fd = s;
+				pfd.events = bSend ? POLLOUT : POLLIN;
+				pfd.revents = 0;
+				const int pr = sys::poll(&pfd, 1, dl.left_ms());
+				if (pr < 0 && sys::interrupted(sys::last_error())) continue;
+				if (pr <= 0) return false;
+				const auto n = bSend ? sys::send(s, p, len) : sys::recv(s, p, len);
+				if (n > 0) {
+					p += n;
+					len -= static_cast<size_t>(n);
+				} else if (0 == n || !sys::would_block(sys::last_error())) return false;
+			}
+			return true;
+		}
+
+		socket_t _listen()const noexcept {
+			const socket_t s = ::socket(AF_INET, SOCK_STREAM, 0);
+			if (sys::invalid_socket == s) return s;
+			sys::set_reuse_addr(s);
+
+			::sockaddr_in addr;
+			::std::memset(&addr, 0, sizeof(addr));
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = htonl(INADDR_ANY);
+			addr.sin_port = htons(static_cast<uint16_t>(m_basePort + m_rank));
+			if (0 != ::bind(s, reinterpret_cast<const ::sockaddr*>(&addr), sizeof(addr)) || 0 != ::listen(s, 4)) {
+				sys::close(s);
+				return sys::invalid_socket;
+			}
+			return s;
+		}
+
+		//connects to the next rank, retrying until it starts listening. Then introduces itself by sending the own rank
+		bool _connect_next(const _impl::transport_deadline& dl)noexcept {
+			const int next = (m_rank + 1) % m_size;
+			::addrinfo hints;
+			::std::memset(&hints, 0, sizeof(hints));
+			hints.ai_family = AF_INET;
+			hints.ai_socktype = SOCK_STREAM;
+			::addrinfo* pAI = nullptr;
+			const auto port = ::std::to_string(m_basePort + next);
+			if (0 != ::getaddrinfo(host(next).c_str(), port.c_str(), &hints, &pAI) || !pAI) return false;
+
+			socket_t s = sys::invalid_socket;
+			while (sys::invalid_socket == s && !dl.expired()) {
+				s = ::socket(AF_INET, SOCK_STREAM, 0);
+				if (sys::invalid_socket == s) break;
+				bool bOk = _setup_socket(s);
+				if (bOk && 0 != ::connect(s, pAI->ai_addr, static_cast<socklen_t>(pAI->ai_addrlen))) {
+					bOk = sys::connect_in_progress(sys::last_error());
+					if (bOk) {
+						int err = 0;
+						socklen_t errLen = sizeof(err);
+						bOk = sys::wait_connected(s, dl.left_ms())
+							&& 0 == ::getsockopt(s, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&err), &errLen) && 0 == err;
+					}
+				}
+				if (!bOk) {
+					sys::close(s);
+					s = sys::invalid_socket;
+					::std::this_thread::sleep_for(::std::chrono::milliseconds(10));
+				}
+			}
+			::freeaddrinfo(pAI);
+			if (sys::invalid_socket == s) return false;
+
+			m_out = s;
+			uint32_t r = static_cast<uint32_t>(m_rank);
+			return _xfer_all<true>(m_out, reinterpret_cast<char*>(&r), sizeof(r), dl);
+		}
+
+		//accepts the connection of the previous rank and checks it's really that rank
+		bool _accept_prev(const socket_t lsn, const _impl::transport_deadline& dl)noexcept {
+			::pollfd pfd;
+			pfd.fd = lsn;
+			pfd.events = POLLIN;
+			pfd.revents = 0;
+			if (sys::poll(&pfd, 1, dl.left_ms()) <= 0) return false;
+
+			const socket_t s = ::accept(lsn, nullptr, nullptr);
+			if (sys::invalid_socket == s) return false;
+			m_in = s;
+			uint32_t r = 0;
+			return _setup_socket(m_in) && _xfer_all<false>(m_in, reinterpret_cast<char*>(&r), sizeof(r), dl)
+				&& static_cast<uint32_t>((m_rank + m_size - 1) % m_size) == r;
+		}
+#else
+		bool connect()noexcept { return false; }
+		void disconnect()noexcept { m_bConnected = false; }
+		bool exchange(const void*, const size_t, void*, const size_t)noexcept { return false; }
+#endif
+	};
+
+}
+}
@@ -109,17 +109,27 @@ namespace nntl {
 
 			if (CD.is_training_mode()) {
 				//must make dropoutMask and apply it
-				NNTL_ASSERT(m_dropoutMask.size() == activations.size_no_bias());
-				NNTL_ASSERT(m_dropoutMask.size() == m_origActivations.size());
+				NNTL_ASSERT(m_origActivations.size() == activations.size_no_bias());
+				NNTL_ASSERT(m_bPackedMask || m_dropoutMask.size() == m_origActivations.size());
 				NNTL_ASSERT(m_a && m_b && m_mbDropVal);
-
-				_dropout_saveActivations(activations);
-				CD.iRng().gen_matrix_norm(m_dropoutMask);
-
 				auto& _iI = CD.iInspect();
-				_iI.fprop_preDropout(activations, m_dropoutPercentActive, m_dropoutMask);
 
-				CD.iMath().make_alphaDropout(activations, m_dropoutPercentActive, m_a, m_b, m_mbDropVal, m_dropoutMask);
+				if (m_bPackedMask) {
+					const auto n = m_origActivations.numel();
+					NNTL_ASSERT(m_dropoutBits.size() >= realmtx_t::sBitMaskWords(n));
+					CD.iRng().bernoulli_bits(m_dropoutBits.data(), n, m_dropoutPercentActive);
+					_iI.fprop_preDropout(activations, m_dropoutPercentActive, m_dropoutMask);
+
+					//dL/dA of kept elements is scaled by a during bprop
+					m_packedKeepVal = m_a;
+					CD.iMath().make_alphaDropout_packed(activations, m_a, m_b, m_mbDropVal, m_dropoutBits.data(), m_origActivations);
+				} else {
+					_dropout_saveActivations(activations);
+					CD.iRng().gen_matrix_norm(m_dropoutMask);
+					_iI.fprop_preDropout(activations, m_dropoutPercentActive, m_dropoutMask);
+
+					CD.iMath().make_alphaDropout(activations, m_dropoutPercentActive, m_a, m_b, m_mbDropVal, m_dropoutMask);
+				}
 
 				_iI.fprop_postDropout(activations, m_dropoutMask);
 			}
@@ -129,7 +139,7 @@ namespace nntl {
 		void dropoutPercentActive(const real_t dpa)noexcept {
 			_base_class_t::dropoutPercentActive(dpa);
 			if (bDropout()) {
-				NNTL_ASSERT(m_dropoutMask.size() == m_origActivations.size());
+				NNTL_ASSERT(m_bPackedMask || m_dropoutMask.size() == m_origActivations.size());
 				calc_coeffs<ext_real_t>(dpa, m_origActivations.cols(), m_a, m_b, m_mbDropVal);
 			}
 		}
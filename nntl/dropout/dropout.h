@@ -57,11 +57,20 @@ namespace nntl {
 			realmtxdef_t m_dropoutMask;//<batch_size rows> x <m_neurons_cnt cols> (must not have a bias column)
 			realmtxdef_t m_origActivations;//<batch_size rows> x <m_neurons_cnt cols> (must not have a bias column)
 
+			//the bit-packed mask (a set bit means "keep") that is used instead of m_dropoutMask when m_bPackedMask is set.
+			// It's generated from raw RNG integers and applied in the same pass that saves m_origActivations.
+			// m_dropoutMask stays empty then, so inspectors get an empty mask
+			::std::vector<bitmask_word_t> m_dropoutBits;
+			//the value of kept elements of the (non-packed) dropout mask; it's set during _dropout_apply()
+			real_t m_packedKeepVal;
+
 			real_t m_dropoutPercentActive;//probability of keeping unit active
 
+			bool m_bPackedMask;
+
 		protected:
 			~_dropout_base()noexcept {}
-			_dropout_base()noexcept : m_dropoutPercentActive(real_t(1.)) {}
+			_dropout_base()noexcept : m_packedKeepVal(real_t(0)), m_dropoutPercentActive(real_t(1.)), m_bPackedMask(false) {}
 
 			template<class Archive>
 			void _dropout_serialize(Archive & ar, const unsigned int version) noexcept {
@@ -71,7 +80,7 @@ namespace nntl {
 				}
 
 				if (bDropout() && utils::binary_option<true>(ar, serialization::serialize_dropout_mask)) {
-					ar & NNTL_SERIALIZATION_NVP(m_dropoutMask);
+					if (!m_bPackedMask) ar & NNTL_SERIALIZATION_NVP(m_dropoutMask);
 					ar & NNTL_SERIALIZATION_NVP(m_origActivations);
 				}
 			}
@@ -85,14 +94,18 @@ namespace nntl {
 					NNTL_ASSERT(max_batch_size);
 					//we don't check bDropout() here because assume that if the dropout enabled, it'll be used
 					//even if now it's disabled.
-					NNTL_ASSERT(!m_dropoutMask.emulatesBiases());
-					//resize to the biggest possible size during training
-					if (!m_dropoutMask.resize(max_batch_size, neurons_cnt)) return false;
-
 					NNTL_ASSERT(!m_origActivations.emulatesBiases());
+					//resize to the biggest possible size during training
 					if (!m_origActivations.resize(max_batch_size, neurons_cnt)) return false;
 
-					CD.iRng().preinit_additive_norm(m_dropoutMask.numel());
+					NNTL_ASSERT(!m_dropoutMask.emulatesBiases());
+					if (m_bPackedMask) {
+						m_dropoutMask.clear();
+						m_dropoutBits.resize(realmtx_t::sBitMaskWords(m_origActivations.numel()));
+					} else {
+						if (!m_dropoutMask.resize(max_batch_size, neurons_cnt)) return false;
+						CD.iRng().preinit_additive_norm(m_dropoutMask.numel());
+					}
 				}
 				return true;
 			}
@@ -100,6 +113,8 @@ namespace nntl {
 			void _dropout_deinit()noexcept {
 				m_dropoutMask.clear();
 				m_origActivations.clear();
+				m_dropoutBits.clear();
+				m_dropoutBits.shrink_to_fit();
 				//we mustn't clear settings here
 			}
 
@@ -108,8 +123,10 @@ namespace nntl {
 				if (CD.is_training_mode() && bDropout()) {
 					const auto bs = CD.get_cur_batch_size();
 
-					NNTL_ASSERT(!m_dropoutMask.empty());
-					m_dropoutMask.deform_rows(bs);
+					if (!m_bPackedMask) {
+						NNTL_ASSERT(!m_dropoutMask.empty());
+						m_dropoutMask.deform_rows(bs);
+					}
 
 					NNTL_ASSERT(!m_origActivations.empty());
 					m_origActivations.deform_rows(bs);
@@ -134,13 +151,16 @@ namespace nntl {
 			template<typename CommonDataT>
 			void _dropout_restoreScaling(realmtx_t& dLdA, realmtx_t& activations, const CommonDataT& CD)noexcept {
 				NNTL_ASSERT(bDropout());
-				NNTL_ASSERT(m_dropoutMask.size() == dLdA.size());
-				NNTL_ASSERT(m_dropoutMask.size() == m_origActivations.size());
+				NNTL_ASSERT(m_origActivations.size() == dLdA.size());
+				NNTL_ASSERT(m_bPackedMask || m_dropoutMask.size() == m_origActivations.size());
 
 				auto& _iI = CD.iInspect();
 				_iI.bprop_preCancelDropout(dLdA, activations, m_dropoutPercentActive);
 
-				CD.iMath().evMul_ip(dLdA, m_dropoutMask);
+				if (m_bPackedMask) {
+					NNTL_ASSERT(m_dropoutBits.size() >= realmtx_t::sBitMaskWords(dLdA.numel()));
+					CD.iMath().evMulByBitMask_ip(dLdA, m_dropoutBits.data(), m_packedKeepVal);
+				} else CD.iMath().evMul_ip(dLdA, m_dropoutMask);
 				_dropout_restoreActivations(activations);
 
 				_iI.bprop_postCancelDropout(dLdA, activations);
@@ -155,6 +175,14 @@ namespace nntl {
 				NNTL_ASSERT(real_t(0.) <= dpa && dpa <= real_t(1.));
 				m_dropoutPercentActive = (dpa <= real_t(+0.) || dpa > real_t(1.)) ? real_t(1.) : dpa;
 			}
+
+			//switches to the bit-packed dropout mask (64x less memory for double, no separate passes to make and apply the
+			// mask). Must be set before the layer initialization. Off by default, because inspectors can't see the mask then
+			void packed_mask(const bool b)noexcept {
+				NNTL_ASSERT(m_origActivations.empty() || !"Must be set before the layer initialization");
+				m_bPackedMask = b;
+			}
+			bool packed_mask()const noexcept { return m_bPackedMask; }
 		};
 	}
 
@@ -208,16 +236,26 @@ namespace nntl {
 
 			if (CD.is_training_mode()) {
 				//must make dropoutMask and apply it
-				NNTL_ASSERT(m_dropoutMask.size() == activations.size_no_bias());
-				NNTL_ASSERT(m_dropoutMask.size() == m_origActivations.size());
-
-				_dropout_saveActivations(activations);
-				CD.iRng().gen_matrix_norm(m_dropoutMask);
-
+				NNTL_ASSERT(m_origActivations.size() == activations.size_no_bias());
+				NNTL_ASSERT(m_bPackedMask || m_dropoutMask.size() == m_origActivations.size());
 				auto& _iI = CD.iInspect();
-				_iI.fprop_preDropout(activations, m_dropoutPercentActive, m_dropoutMask);
 
-				CD.iMath().make_dropout(activations, m_dropoutPercentActive, m_dropoutMask);
+				if (m_bPackedMask) {
+					const auto n = m_origActivations.numel();
+					NNTL_ASSERT(m_dropoutBits.size() >= realmtx_t::sBitMaskWords(n));
+					CD.iRng().bernoulli_bits(m_dropoutBits.data(), n, m_dropoutPercentActive);
+					_iI.fprop_preDropout(activations, m_dropoutPercentActive, m_dropoutMask);
+
+					m_packedKeepVal = real_t(1.) / m_dropoutPercentActive;
+					//saves the activations too
+					CD.iMath().make_dropout_packed(activations, m_packedKeepVal, m_dropoutBits.data(), m_origActivations);
+				} else {
+					_dropout_saveActivations(activations);
+					CD.iRng().gen_matrix_norm(m_dropoutMask);
+					_iI.fprop_preDropout(activations, m_dropoutPercentActive, m_dropoutMask);
+
+					CD.iMath().make_dropout(activations, m_dropoutPercentActive, m_dropoutMask);
+				}
 
 				_iI.fprop_postDropout(activations, m_dropoutMask);
 			}
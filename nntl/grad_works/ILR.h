@@ -68,6 +68,8 @@ namespace GW { //GW namespace is for grad_works mixins and other stuff, that hel
 		static constexpr bool ILR_init(const mtx_size_t& weightsSize) noexcept { return true; }
 		static constexpr void ILR_deinit() noexcept {}
 		static constexpr void ILR_apply(const bool bFirstRun, realmtx_t& dLdW, const realmtx_t& Vw) noexcept {}
+		template<typename FusedParamsT>
+		static constexpr void ILR_fused_setup(FusedParamsT& u, realmtx_t& Vw) noexcept {}
 
 	public:
 		//extension functions (that aren't required by a root) probably shouldn't be defined at all.
@@ -163,6 +165,18 @@ namespace GW { //GW namespace is for grad_works mixins and other stuff, that hel
 			}
 		}
 
+		//fills ILR part of the parameters of MathN::apply_grad_fused(). Counterpart of ILR_apply() for !bFirstRun
+		template<typename FusedParamsT>
+		void ILR_fused_setup(FusedParamsT& u, realmtx_t& Vw)noexcept {
+			if (use_individual_learning_rates()) {
+				const auto bUseVelocity = _ILR_use_momentum();
+				NNTL_ASSERT(bUseVelocity || !m_prevdLdW.empty());
+				u.set_ILR(m_ILRGain.data(), bUseVelocity ? Vw.data() : m_prevdLdW.data()
+					, m_ILR.mulDecr, m_ILR.mulIncr, m_ILR.capLow, m_ILR.capHigh);
+				if (!bUseVelocity) u.pILRStore = m_prevdLdW.data();
+			}
+		}
+
 	public:
 		const bool use_individual_learning_rates()const noexcept { return get_opt(f_UseILR); }
 		const bool applyILRToMomentum()const noexcept { return get_opt(f_ApplyILRToMomentum); }
@@ -38,6 +38,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../common_nn_data.h"
 #include "ILR.h"
 #include "loss_addendums.h"
+#include "../distributed/grad_exchange.h"
 
 namespace nntl {
 
@@ -68,6 +69,10 @@ namespace nntl {
 			//dLdW can have any values on output (use it for temporary calculations if needed)
 			nntl_interface void apply_grad(realmtxdef_t& weights, realmtxdef_t& dLdW)noexcept;
 
+			//apply_grad() may only start an update (see the distributed training); complete_grad() must finish it.
+			// layers::bprop() calls it for every layer after the backward pass
+			nntl_interface void complete_grad()noexcept;
+
 			//////////////////////////////////////////////////////////////////////////
 			// The following function ALSO MUST BE IMPLEMENTED
 			// They are commented out for the reason, - they are implemented as a mixin, and it's an issue to correctly specify
@@ -103,6 +108,7 @@ namespace nntl {
 		
 		typedef math::smatrix<real_t> realmtx_t;
 		typedef math::smatrix_deform<real_t> realmtxdef_t;
+		typedef distributed::grad_exchange<real_t> grad_exchange_t;
 
 	protected:
 		enum OptsList {
@@ -126,6 +132,8 @@ namespace nntl {
 
 			f_UseMaxNorm,
 			f_NormIncludesBias,//if true, the max-norm parameter describes full norm of weight vector
+
+			f_FusedApplyGrad,//allows to use the single-pass weights update (see _apply_grad_fused())
 			
 			opts_total
 		};
@@ -133,6 +141,11 @@ namespace nntl {
 	public:
 		static constexpr size_t mixins_count = sizeof...(MixinsT);
 
+		//the fused weights update doesn't materialize intermediate values of dLdW (post-optimizer, post-ILR) that the
+		// inspector would like to see, therefore it is available only with a dummy inspector
+		static constexpr bool bFusedApplyGradAvailable
+			= inspector::is_dummy_inspector<typename _impl::_common_data_consumer<InterfacesT>::iInspect_t>::value;
+
 		typedef utils::mixins::indexed::make_mixin_vec<FinalT, real_t, MixinsT...> mixins_tvec;
 		//#TODO: opts_total must be extendable in derived classes
 		typedef utils::mixins::make_mixin_options_count_vec_c<mixins_tvec, opts_total> mixin_opts_cnt;
@@ -191,6 +204,12 @@ namespace nntl {
 
 		real_t m_optBeta1t, m_optBeta2t;//storage for coefficients some optimizers (Adam, AdaMax) needed
 
+		//distributed training support, see set_grad_exchange()
+		grad_exchange_t* m_pGradExch;
+		realmtxdef_t* m_pExchWeights;//weights waiting for the averaged m_exchdLdW. Non-null while the averaging is in flight
+		realmtxdef_t m_exchdLdW;//copy of dLdW, because the layer's dLdW storage is reused by lower layers during bprop()
+		typename grad_exchange_t::slot_id_t m_exchSlot;
+
 	public:
 		//::std::bitset<opts_total> m_flags;
 		//unfortunately, it must be left inside public scope at this moment
@@ -242,7 +261,7 @@ namespace nntl {
 
 	protected:
 		void _flags_default()noexcept {
-			set_opt(f_FirstRun, true).set_opt(f_UseNesterovMomentum, true); // .reset(f_ApplyILRToMomentum);
+			set_opt(f_FirstRun, true).set_opt(f_UseNesterovMomentum, true).set_opt(f_FusedApplyGrad, true); // .reset(f_ApplyILRToMomentum);
 		}
 
 		~_grad_works()noexcept {}
@@ -257,6 +276,7 @@ namespace nntl {
 			, m_numericStabilizerEps(_impl::NUM_STAB_EPS<real_t>::value), m_WeightVecNormSqared(real_t(0.0))
 			, m_optBeta1t(real_t(1.)), m_optBeta2t(real_t(1.))
 			, m_type(ClassicalConstant)
+			, m_pGradExch(nullptr), m_pExchWeights(nullptr), m_exchSlot(grad_exchange_t::invalid_slot)
 		{
 			learning_rate(lr);
 			_flags_default();
@@ -294,6 +314,10 @@ namespace nntl {
 		}
 
 		void deinit() noexcept {
+			complete_grad();
+			m_exchdLdW.clear();
+			m_exchSlot = grad_exchange_t::invalid_slot;
+
 			clean_common_data();
 			
 			ILR_deinit();
@@ -331,9 +355,53 @@ namespace nntl {
 			}
 		}
 		
-		//#todo this code should be refactored.
+		//attaches (nullptr detaches) the gradient exchanger of the distributed training (see nnet_distributed.h). While it's
+		// attached apply_grad() only starts averaging dLdW over the ranks and complete_grad() does the update with the average
+		void set_grad_exchange(grad_exchange_t* p)noexcept {
+			complete_grad();
+			m_pGradExch = p;
+			m_exchSlot = grad_exchange_t::invalid_slot;
+			if (!p) m_exchdLdW.clear();
+		}
+		grad_exchange_t* get_grad_exchange()const noexcept { return m_pGradExch; }
+
 		void apply_grad(realmtxdef_t& weights, realmtxdef_t& dLdW) noexcept {
 			NNTL_ASSERT(dLdW.size() == weights.size());
+			//the blocked learning is the same on every rank, so there's nothing to average then
+			if (m_pGradExch && !isLearningBlocked()) {
+				complete_grad();
+				if (_start_grad_exchange(dLdW)) {
+					m_pExchWeights = &weights;
+				} else m_pGradExch->fail();//a local update would make the ranks diverge
+				return;
+			}
+			_apply_grad_now(weights, dLdW);
+		}
+
+		void complete_grad()noexcept {
+			if (m_pExchWeights) {
+				auto& weights = *m_pExchWeights;
+				m_pExchWeights = nullptr;
+				//if the averaging failed the weights are left intact, the distributed training stops at the epoch end then
+				if (m_pGradExch->wait(m_exchSlot)) _apply_grad_now(weights, m_exchdLdW);
+			}
+		}
+
+	protected:
+		bool _start_grad_exchange(const realmtxdef_t& dLdW)noexcept {
+			if (grad_exchange_t::invalid_slot == m_exchSlot) {
+				m_exchSlot = m_pGradExch->slot(this, dLdW.numel());
+				if (grad_exchange_t::invalid_slot == m_exchSlot) return false;
+			}
+			if (m_exchdLdW.size() != dLdW.size() && !m_exchdLdW.resize(dLdW.size())) return false;
+			if (!dLdW.copy_to(m_exchdLdW)) return false;
+			m_pGradExch->start(m_exchSlot, m_exchdLdW.data());
+			return true;
+		}
+
+		//#todo this code should be refactored.
+		void _apply_grad_now(realmtxdef_t& weights, realmtxdef_t& dLdW) noexcept {
+			NNTL_ASSERT(dLdW.size() == weights.size());
 
 			auto& iI = get_iInspect();
 
@@ -355,6 +423,13 @@ namespace nntl {
 
 			auto& iM = get_iMath();
 
+			//optimizers must be initialized during the first run, so it always goes the long way
+			if (!bFirstRun && use_fused_apply_grad()) {
+				_apply_grad_fused(iM, weights, dLdW);
+				iI.apply_grad_end(weights);
+				return;
+			}
+
 			/*//changing nesterov momentum vars with fresh dL/dW (should do the same with classical momentum #todo)
 			if (use_momentums() && get_opt(f_UseNesterovMomentum)) {
 				NNTL_ASSERT(m_Vw.size() == dLdW.size());
@@ -485,6 +560,69 @@ namespace nntl {
 			iI.apply_grad_end(weights);
 		}
 
+	protected:
+		//Does the same as the optimizer + ILR + momentum + weights update + max-norm part of apply_grad(), but in a single
+		// pass over the data (see MathN::apply_grad_fused()). dLdW is left intact.
+		template<typename iMathT>
+		void _apply_grad_fused(iMathT& iM, realmtxdef_t& weights, const realmtx_t& dLdW)noexcept {
+			NNTL_ASSERT(!isFirstRun());
+			math::fused_update::params<real_t> u;
+			if (use_momentums()) {
+				NNTL_ASSERT(m_Vw.size() == dLdW.size());
+				u.set_momentum(m_Vw.data(), m_momentum
+					, get_opt(f_UseNesterovMomentum) ? math::fused_update::mom_nesterov : math::fused_update::mom_classical);
+			}
+			if (use_max_norm()) u.set_max_norm(m_WeightVecNormSqared, get_opt(f_NormIncludesBias));
+			ILR_fused_setup(u, m_Vw);
+
+			switch (m_type) {
+			case ClassicalConstant:
+				iM.apply_grad_fused(weights, dLdW, math::fused_update::opt_classical<real_t>(m_learningRate), u);
+				break;
+
+			case RMSProp_Hinton:
+				iM.apply_grad_fused(weights, dLdW, math::fused_update::opt_RMSProp_Hinton<real_t>(m_optMtxA
+					, m_learningRate, m_optBeta1, m_numericStabilizerEps), u);
+				break;
+
+			case RMSProp_Graves:
+				iM.apply_grad_fused(weights, dLdW, math::fused_update::opt_RMSProp_Graves<real_t>(m_optMtxA, m_optMtxB
+					, m_learningRate, m_optBeta1, m_numericStabilizerEps), u);
+				break;
+
+			case RProp:
+				iM.apply_grad_fused(weights, dLdW, math::fused_update::opt_RProp<real_t>(m_learningRate), u);
+				break;
+
+			case ModProp:
+				iM.apply_grad_fused(weights, dLdW, math::fused_update::opt_ModProp<real_t>(m_optMtxA
+					, m_learningRate, m_optBeta1, m_numericStabilizerEps), u);
+				break;
+
+			case Adam:
+				iM.apply_grad_fused(weights, dLdW, math::fused_update::opt_Adam<real_t>(m_optMtxA, m_optMtxB, m_optBeta1t, m_optBeta2t
+					, m_learningRate, m_optBeta1, m_optBeta2, m_numericStabilizerEps), u);
+				break;
+
+			case AdaMax:
+				iM.apply_grad_fused(weights, dLdW, math::fused_update::opt_AdaMax<real_t>(m_optMtxA, m_optMtxB, m_optBeta1t
+					, m_learningRate, m_optBeta1, m_optBeta2, m_numericStabilizerEps), u);
+				break;
+
+			case Nadam:
+			case Radam:
+				iM.apply_grad_fused(weights, dLdW, math::fused_update::opt_RNadam<real_t>(m_optMtxA, m_optMtxB, m_optBeta1t, m_optBeta2t
+					, m_learningRate, m_optBeta1, m_optBeta2, m_optGamma, m_numericStabilizerEps), u);
+				break;
+
+			default:
+				NNTL_ASSERT(!"WTF??");
+				STDCOUTL("*** " << NNTL_FUNCTION << ": Wrong type of optimizer specified!");
+				abort();
+			}
+		}
+
+	public:
 		//////////////////////////////////////////////////////////////////////////
 
 		self_ref_t learning_rate(const real_t& learningRate)noexcept {
@@ -575,6 +713,14 @@ namespace nntl {
 		const bool use_classical_momentum()const noexcept { return get_opt(f_UseMomentum) & (!get_opt(f_UseNesterovMomentum)); }
 
 		const bool use_max_norm()const noexcept { return get_opt(f_UseMaxNorm); }
+
+		//the single-pass weights update is on by default (if bFusedApplyGradAvailable)
+		self_ref_t fused_apply_grad(const bool b)noexcept {
+			set_opt(f_FusedApplyGrad, b);
+			return get_self();
+		}
+		const bool fused_apply_grad()const noexcept { return get_opt(f_FusedApplyGrad); }
+		const bool use_fused_apply_grad()const noexcept { return bFusedApplyGradAvailable && get_opt(f_FusedApplyGrad); }
 		const bool isFirstRun()const noexcept { return get_opt(f_FirstRun); }
 	};
 
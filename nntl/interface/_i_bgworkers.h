@@ -62,9 +62,20 @@ namespace threads {
 
 		nntl_interface self_t& delete_tasks()noexcept;
 
+		//one-shot job for any single worker thread. Never blocks, returns false if the queue is full
+		template<typename FJob>
+		nntl_interface bool post(FJob&& func, const unsigned priority = 0) noexcept;
+		nntl_interface size_t jobs_count()const noexcept;
+
 		//never call recursively or from non-main thread
 		template<typename FExec>
 		nntl_interface self_t& exec(FExec&& func) noexcept;
+
+		//non-blocking variant of exec(). func must be an lvalue and must outlive the paired exec_wait() call
+		template<typename FExec>
+		nntl_interface self_t& exec_async(FExec&& func) noexcept;
+		nntl_interface self_t& exec_wait()noexcept;
+		nntl_interface bool exec_pending()const noexcept;
 	};
 
 
@@ -313,6 +313,16 @@ namespace math {
 		// L = sum( -y*log(a) )/activations.rows(), dL/dz=a-y
 		nntl_interface real_t loss_softmax_xentropy(const realmtx_t& activations, const realmtx_t& data_y)noexcept;
 
+		//////////////////////////////////////////////////////////////////////////
+		// fused dL/dZ and loss computation for the output layer. Each function overwrites act_dLdZ with dL/dZ (as the
+		// corresponding dL/dZ function does) and returns the loss value of the activations (as the corresponding loss_*() does)
+		nntl_interface real_t dSigmQuadLoss_dZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ)noexcept;
+		nntl_interface real_t dIdentityQuadLoss_dZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ)noexcept;
+		nntl_interface real_t dSigmXEntropyLoss_dZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ)noexcept;
+		nntl_interface real_t dIdentityXEntropyLoss_dZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ)noexcept;
+		nntl_interface real_t dSoftSigmXEntropyLoss_dZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ, const real_t& a)noexcept;
+		nntl_interface real_t dSoftmaxXEntropyLoss_dZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ)noexcept;
+
 		//////////////////////////////////////////////////////////////////////////
 		//gradient application procedures
 		nntl_interface void RMSProp_Hinton(realmtx_t& dW, realmtx_t& rmsF, const real_t learningRate,
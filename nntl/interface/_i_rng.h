@@ -32,6 +32,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include <random>
+#include "math/simd/ziggurat.h"
+#include "../serialization/serialization.h"
 
 namespace nntl {
 namespace rng {
@@ -62,6 +64,23 @@ namespace rng {
 		bool init_rng()noexcept { return true; }
 		void deinit_rng()noexcept {}
 
+		//called by the training loop right before every training batch. RNGs that pregenerate data in background use it
+		// to learn the per batch demand and to schedule the generation
+		void on_train_batch_begin()noexcept {}
+
+		//////////////////////////////////////////////////////////////////////////
+		// Checkpointing support
+		// 
+		//Every iRng must be serializable with ::nntl::serialization archives (serialize() or save()/load() pair). The state
+		// saved must be enough to continue generating exactly the same sequence after loading it into an object that was
+		// set up the same way (the same class, the same threads count) as the saved one. Loading is expected to happen between
+		// the training batches only.
+		// 
+		//seek_epoch() puts the generator into a state that depends only on the last seed and the epoch index e. This is
+		// a cheap jump-ahead: an epoch could be replayed or a training resumed from a checkpoint of epoch e without saving
+		// the whole state of the generator (see nnet_train_opts::seekRngEachEpoch())
+		nntl_interface void seek_epoch(const uint64_t e)noexcept;
+
 		//////////////////////////////////////////////////////////////////////////
 		// Multithreading support. iRng instance should not create own threading pool, it should be given a threads pool object
 		// during initialization
@@ -107,6 +126,9 @@ namespace rng {
 		//generate a vector using Bernoulli distribution with probability of success p and success value sVal.
 		nntl_interface void bernoulli_vector(real_t* ptr, const size_t n, const real_t p, const real_t sVal = real_t(1.), const real_t negVal = real_t(0.))noexcept;
 		nntl_interface void bernoulli_matrix(realmtx_t& A, const real_t p, const real_t sVal = real_t(1.), const real_t negVal = real_t(0.))noexcept;
+		//generate n bits using Bernoulli distribution with probability of success p and pack them into sBitMaskWords(n) words
+		// of pBits (see smatrix_td::bitmask_word_t). Unused bits of the last word are zeroed
+		nntl_interface void bernoulli_bits(bitmask_word_t* pBits, const numel_cnt_t n, const real_t p)noexcept;
 
 		nntl_interface void normal_vector(real_t* ptr, const size_t n, const real_t m = real_t(0.), const real_t st = real_t(1.))noexcept;
 		nntl_interface void normal_matrix(realmtx_t& A, const real_t m = real_t(0.), const real_t st = real_t(1.))noexcept;
@@ -200,13 +222,30 @@ namespace rng {
 			get_self().bernoulli_vector(A.data(), A.numel(), p, posVal, negVal);
 		}
 
+		//generic (and slow) version. RNGs with a full ranged integer generator should override it
+		void bernoulli_bits(bitmask_word_t*const pBits, const numel_cnt_t n, const real_t p)noexcept {
+			NNTL_ASSERT(pBits);
+			NNTL_ASSERT(p > real_t(0) && p < real_t(1));
+			const auto nw = sBitMaskWords(n);
+			for (numel_cnt_t w = 0; w < nw; ++w) {
+				const unsigned cnt = static_cast<unsigned>(::std::min(numel_cnt_t(64), n - w * 64));
+				bitmask_word_t v = 0;
+				for (unsigned j = 0; j < cnt; ++j) {
+					v |= static_cast<bitmask_word_t>(get_self().gen_f_norm() < p) << j;
+				}
+				pBits[w] = v;
+			}
+		}
+
 		//////////////////////////////////////////////////////////////////////////
 		//////////////////////////////////////////////////////////////////////////
+		//Ziggurat over gen_vector_norm(), slow path samples take their additional bits from gen_int()
 		void normal_vector(real_t*const ptr, const size_t n, const real_t m = real_t(0.), const real_t st = real_t(1.))noexcept {
-			::std::normal_distribution<real_t> distr(m,n);
-			for (size_t i = 0; i < n; ++i) {
-				ptr[i] = distr(*this);
-			}
+			NNTL_ASSERT(ptr || !n);
+			get_self().gen_vector_norm(ptr, n);
+			math::simd::ziggurat<real_t>::transform(ptr, n, m, st, [this](const size_t) {
+				return [this]() { return static_cast<uint32_t>(get_self().gen_int()); };
+			});
 		}
 		void normal_matrix(realmtx_t& A, const real_t m = real_t(0.), const real_t st = real_t(1.))noexcept {
 			get_self().normal_vector(A.data(), A.numel(), m , st);
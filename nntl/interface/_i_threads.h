@@ -55,6 +55,14 @@ namespace threads {
 
 		nntl_interface bool denormalsOnInAnyThread()noexcept;
 
+		// Implementations also have a constructor taking the pool size nThreads (including the main thread, clamped
+		// to [1, workers_count()]). Thread ids are always less than the pool size, workers_count() doesn't depend on it.
+
+		// caps (at runtime) the number of threads (including the main thread) run() and reduce() may use. Returns the value set,
+		// which is clamped to [1, pool size]. workers_count() itself doesn't change.
+		nntl_interface thread_id_t max_threads(const thread_id_t n)noexcept;
+		nntl_interface thread_id_t max_threads()const noexcept;
+
 		// useNThreads (if greater than 1 and less or equal to workers_count() specifies the number of threads to serve request.
 		// if pThreadsUsed is specified, it'll contain total number of threads (including the main thread),
 		// that is used to serve the request. It'll be less or equal to workers_count()
@@ -0,0 +1,138 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+//Native (header-only) implementation of the BLAS level-3 general matrix multiplication, that runs on nntl's own thread
+// pool instead of a BLAS library internal one. This prevents threads oversubscription when BLAS library threads fight with
+// iThreads_t workers (and that gets even worse when several nets are trained side by side, because each BLAS call
+// spawns work for the whole BLAS pool on top of all the workers).
+// 
+// Only gemm() is implemented natively (it does the most of the work: mMulAB_C(), mMulABt_Cnb(), mScaledMulAtB_C() and so on).
+// Other routines (syrk, symm, gesvd, ...) are inherited from the FallbackT binding.
+// 
+// Use it as MathN<real_t, iThreads_t, _impl::MATHN_THR<real_t>, b_Native<iThreads_t>>
+// 
+// Note that the native gemm() takes the reference to the thread pool as the first argument. MathN detects such bindings
+// with the _impl::blas_runs_on_ithreads<> and passes its own m_threads there.
+
+#include <atomic>
+#include "b_open_blas.h"
+#include "../simd/gemm.h"
+
+namespace nntl {
+namespace math {
+
+	template<typename iThreadsT, typename FallbackT = b_OpenBLAS>
+	struct b_Native : public FallbackT {
+		typedef iThreadsT iThreads_t;
+		typedef typename iThreads_t::par_range_t par_range_t;
+		typedef typename iThreads_t::range_t range_t;
+
+		//a product that requires less multiply-add operations (M*N*K) is computed by the calling thread only
+		static constexpr double gemm_mt_minMulAdds = 64. * 64. * 64.;
+
+		//////////////////////////////////////////////////////////////////////////
+		// General matrix multiplication C := alpha*op(A)*op(B) + beta*C, where op(A) is M x K, op(B) is K x N and C is M x N.
+		// Arguments have the same meaning as for b_OpenBLAS::gemm() (col-major data only).
+		// C is split into a grid of independent blocks (one per worker); sizes of blocks are multiples of the micro-kernel
+		// register block, so no thread writes to another thread's cache lines except for blocks edges.
+		template<typename sz_t, typename fl_t>
+		static void gemm(iThreads_t& iT, const bool bTransposeA, const bool bTransposeB,
+			const sz_t& M, const sz_t& N, const sz_t& K, const fl_t& alpha, const fl_t *A, const sz_t& lda,
+			const fl_t *B, const sz_t& ldb, const fl_t& beta, fl_t *C, const sz_t& ldc)noexcept
+		{
+			gemm_ep(iT, bTransposeA, bTransposeB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, simd::gemm_no_epilogue());
+		}
+
+		//same as gemm(), but every thread calls ep(pC, ldc, mc, nc) for every block of C it has just finished (see
+		// simd::gemm_kernels::gemm_ep()). Therefore ep is called concurrently for disjoint blocks and must not use iT.
+		template<typename sz_t, typename fl_t, typename EpilogueF>
+		static void gemm_ep(iThreads_t& iT, const bool bTransposeA, const bool bTransposeB,
+			const sz_t& M, const sz_t& N, const sz_t& K, const fl_t& alpha, const fl_t *A, const sz_t& lda,
+			const fl_t *B, const sz_t& ldb, const fl_t& beta, fl_t *C, const sz_t& ldc, EpilogueF&& ep)noexcept
+		{
+			typedef ::std::remove_cv_t<fl_t> real_t;
+			typedef simd::gemm<real_t> kernel_t;
+
+			const size_t m = static_cast<size_t>(M), n = static_cast<size_t>(N), k = static_cast<size_t>(K)
+				, _lda = static_cast<size_t>(lda), _ldb = static_cast<size_t>(ldb), _ldc = static_cast<size_t>(ldc);
+			NNTL_ASSERT(_ldc >= m && _lda >= (bTransposeA ? k : m) && _ldb >= (bTransposeB ? n : k));
+			if (0 == m || 0 == n) return;
+
+			const size_t workers = static_cast<size_t>(iT.max_threads());
+			if (workers < 2 || static_cast<double>(m)*static_cast<double>(n)*static_cast<double>(k) < gemm_mt_minMulAdds) {
+				const auto r = kernel_t::run_ep(bTransposeA, bTransposeB, k, alpha, A, _lda, B, _ldb, beta, C, _ldc, 0, m, 0, n, ep);
+				NNTL_ASSERT(r || !"Failed to allocate gemm pack buffers");
+				if (!r) abort();
+				return;
+			}
+
+			//making a grid of blocks. Splitting columns first, because then every thread packs only its own part of op(B)
+			const size_t mr = kernel_t::MR(), nr = kernel_t::NR();
+			const size_t mTiles = (m + mr - 1) / mr, nTiles = (n + nr - 1) / nr;
+			const size_t tn = ::std::min(workers, nTiles), tm = ::std::min(::std::max(size_t(1), workers / tn), mTiles);
+			const size_t mBlk = ((mTiles + tm - 1) / tm)*mr, nBlk = ((nTiles + tn - 1) / tn)*nr;
+
+			::std::atomic_bool bFailed(false);
+			iT.run([=, &bFailed, &ep](const par_range_t& pr) {
+				const auto bE = pr.offset() + pr.cnt();
+				for (auto b = pr.offset(); b < bE; ++b) {
+					const size_t bi = static_cast<size_t>(b) / tn, bj = static_cast<size_t>(b) % tn;
+					const size_t m0 = bi*mBlk, n0 = bj*nBlk;
+					if (m0 < m && n0 < n) {
+						if (!kernel_t::run_ep(bTransposeA, bTransposeB, k, alpha, A, _lda, B, _ldb, beta, C, _ldc
+							, m0, ::std::min(m, m0 + mBlk), n0, ::std::min(n, n0 + nBlk), ep))
+						{
+							bFailed = true;
+						}
+					}
+				}
+			}, static_cast<range_t>(tm*tn));
+			NNTL_ASSERT(!bFailed || !"Failed to allocate gemm pack buffers");
+			if (bFailed) abort();
+		}
+	};
+
+	namespace _impl {
+		//detects whether the binding BlasT runs level-3 routines on the thread pool of type iThreadsT (and therefore
+		// takes it as the first argument of the routine)
+		template<typename BlasT, typename iThreadsT, typename = void>
+		struct blas_runs_on_ithreads : public ::std::false_type {};
+
+		template<typename BlasT, typename iThreadsT>
+		struct blas_runs_on_ithreads<BlasT, iThreadsT, ::std::void_t<typename BlasT::iThreads_t>>
+			: public ::std::is_same<typename BlasT::iThreads_t, iThreadsT> {};
+	}
+
+}
+}
@@ -0,0 +1,270 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//Definitions for MathN::apply_grad_fused() - a single-pass weights update (optimizer + ILR + momentum + W-=dW + max-norm).
+//Optimizer functors replicate per-element operations of corresponding MathN optimizer functions (RMSProp_Hinton(), Adam()
+// and so on) and must be kept in sync with them.
+//Each functor takes a gradient value g with its offset i and returns a weight update value. Scalar state updates, that
+// the MathN functions perform once per call (such as beta1t*=beta1 in Adam()), are done by the functor's constructor.
+
+namespace nntl {
+namespace math {
+namespace fused_update {
+
+	enum MomentumType {
+		mom_none,
+		mom_classical, //vW = momentum.*vW + dW; W = W - vW
+		mom_nesterov //vW = vW + dW; W = W - dW (see _grad_works for the details)
+	};
+
+	template<typename RealT>
+	struct params : public smatrix_td {
+		typedef RealT real_t;
+
+		//ILR. pILRGain==nullptr turns off ILR. pILRPrev is previous dLdW (or momentum velocity)
+		real_t* pILRGain;
+		const real_t* pILRPrev;
+		//if not nullptr, then the post-ILR dLdW value is stored here (may be the same as pILRPrev)
+		real_t* pILRStore;
+		real_t ILRdecr, ILRincr, ILRcapLow, ILRcapHigh;
+
+		//momentum
+		real_t* pVw;
+		real_t momentum;
+		MomentumType momType;
+
+		//max-norm, maxNormSquared==0 turns it off
+		real_t maxNormSquared;
+		bool bNormIncludesBias;
+
+		params()noexcept : pILRGain(nullptr), pILRPrev(nullptr), pILRStore(nullptr), ILRdecr(0), ILRincr(0), ILRcapLow(0)
+			, ILRcapHigh(0), pVw(nullptr), momentum(0), momType(mom_none), maxNormSquared(0), bNormIncludesBias(false)
+		{}
+
+		void set_ILR(real_t*const pGain, const real_t*const pPrev, const real_t decr, const real_t incr
+			, const real_t capLow, const real_t capHigh)noexcept
+		{
+			NNTL_ASSERT(pGain && pPrev);
+			NNTL_ASSERT(decr > 0 && decr < 1 && incr>1 && capLow < capHigh && capLow>0);
+			pILRGain = pGain; pILRPrev = pPrev;
+			ILRdecr = decr; ILRincr = incr; ILRcapLow = capLow; ILRcapHigh = capHigh;
+		}
+		void set_momentum(real_t*const pV, const real_t m, const MomentumType mt)noexcept {
+			NNTL_ASSERT(pV && mt != mom_none);
+			pVw = pV; momentum = m; momType = mt;
+		}
+		void set_max_norm(const real_t mn, const bool bIncludesBias)noexcept {
+			NNTL_ASSERT(mn > real_t(0));
+			maxNormSquared = mn; bNormIncludesBias = bIncludesBias;
+		}
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	// optimizers
+
+	template<typename RealT>
+	struct opt_classical : public smatrix_td {
+		typedef RealT real_t;
+		const real_t lr;
+		
+		opt_classical(const real_t learningRate)noexcept : lr(learningRate) {}
+		nntl_force_inline real_t operator()(const real_t g, const numel_cnt_t)const noexcept { return lr*g; }
+	};
+
+	template<typename RealT>
+	struct opt_RMSProp_Hinton : public smatrix_td {
+		typedef RealT real_t;
+		real_t*const pF;
+		const real_t lr, emaDecay, _1_emaDecay, numStab;
+
+		opt_RMSProp_Hinton(smatrix<real_t>& rmsF, const real_t learningRate, const real_t ema, const real_t ns)noexcept
+			: pF(rmsF.data()), lr(learningRate), emaDecay(ema), _1_emaDecay(real_t(1) - ema), numStab(ns)
+		{
+			NNTL_ASSERT(emaDecay > 0 && emaDecay < 1);
+			NNTL_ASSERT(numStab > 0 && numStab < 1);
+		}
+		nntl_force_inline real_t operator()(const real_t g, const numel_cnt_t i)const noexcept {
+			const auto rms = emaDecay*pF[i] + g*g*_1_emaDecay;
+			pF[i] = rms;
+			return lr*(g / (::std::sqrt(rms) + numStab));
+		}
+	};
+
+	template<typename RealT>
+	struct opt_RMSProp_Graves : public smatrix_td {
+		typedef RealT real_t;
+		real_t*const pF;
+		real_t*const pG;
+		const real_t lr, emaDecay, _1_emaDecay, numStab;
+
+		opt_RMSProp_Graves(smatrix<real_t>& rmsF, smatrix<real_t>& rmsG, const real_t learningRate, const real_t ema, const real_t ns)noexcept
+			: pF(rmsF.data()), pG(rmsG.data()), lr(learningRate), emaDecay(ema), _1_emaDecay(real_t(1) - ema), numStab(ns)
+		{
+			NNTL_ASSERT(emaDecay > 0 && emaDecay < 1);
+			NNTL_ASSERT(numStab > 0 && numStab < 1);
+		}
+		nntl_force_inline real_t operator()(const real_t g, const numel_cnt_t i)const noexcept {
+			const auto wdec = g*_1_emaDecay;
+			const auto rF = emaDecay*pF[i] + g*wdec;
+			pF[i] = rF;
+			const auto rG = emaDecay*pG[i] + wdec;
+			pG[i] = rG;
+			return lr*(g / (::std::sqrt(rF - rG*rG + numStab)));
+		}
+	};
+
+	template<typename RealT>
+	struct opt_RProp : public smatrix_td {
+		typedef RealT real_t;
+		const real_t lr;
+
+		opt_RProp(const real_t learningRate)noexcept : lr(learningRate) {}
+		nntl_force_inline real_t operator()(const real_t g, const numel_cnt_t)const noexcept { return lr*math::sign(g); }
+	};
+
+	template<typename RealT>
+	struct opt_ModProp : public smatrix_td {
+		typedef RealT real_t;
+		real_t*const pF;
+		const real_t lr, emaDecay, _1_emaDecay, numStab;
+
+		opt_ModProp(smatrix<real_t>& rmsF, const real_t learningRate, const real_t ema, const real_t ns)noexcept
+			: pF(rmsF.data()), lr(learningRate), emaDecay(ema), _1_emaDecay(real_t(1) - ema), numStab(ns)
+		{
+			NNTL_ASSERT(emaDecay > 0 && emaDecay < 1);
+			NNTL_ASSERT(numStab > 0 && numStab < 1);
+		}
+		nntl_force_inline real_t operator()(const real_t g, const numel_cnt_t i)const noexcept {
+			const auto ema = pF[i] * emaDecay + ::std::abs(g)*_1_emaDecay;
+			pF[i] = ema;
+			return lr*(g / (ema + numStab));
+		}
+	};
+
+	template<typename RealT>
+	struct opt_Adam : public smatrix_td {
+		typedef RealT real_t;
+		real_t*const pM;
+		real_t*const pV;
+		real_t alphat;
+		const real_t beta1, beta2, ombeta1, ombeta2, numStab;
+
+		//beta1t and beta2t are updated here. On the first call they must be initialized with 1
+		opt_Adam(smatrix<real_t>& Mt, smatrix<real_t>& Vt, real_t& beta1t, real_t& beta2t, const real_t learningRate
+			, const real_t b1, const real_t b2, const real_t ns)noexcept
+			: pM(Mt.data()), pV(Vt.data()), beta1(b1), beta2(b2), ombeta1(real_t(1) - b1), ombeta2(real_t(1) - b2), numStab(ns)
+		{
+			NNTL_ASSERT(real_t(0.) < beta1 && beta1 < real_t(1.) && real_t(0.) < beta2 && beta2 < real_t(1.));
+			NNTL_ASSERT(real_t(0.) < numStab && numStab < real_t(1.));
+			beta1t *= beta1;
+			beta2t *= beta2;
+			NNTL_ASSERT(beta1t < real_t(1.) && beta2t < real_t(1.));
+			alphat = learningRate*::std::sqrt(real_t(1.) - beta2t) / (real_t(1.) - beta1t);
+		}
+		nntl_force_inline real_t operator()(const real_t g, const numel_cnt_t i)const noexcept {
+			const auto m = pM[i] * beta1 + g*ombeta1;
+			pM[i] = m;
+			const auto v = pV[i] * beta2 + (g*g)*ombeta2;
+			pV[i] = v;
+			return alphat*m / (::std::sqrt(v) + numStab);
+		}
+	};
+
+	template<typename RealT>
+	struct opt_AdaMax : public smatrix_td {
+		typedef RealT real_t;
+		real_t*const pM;
+		real_t*const pU;
+		real_t alphat;
+		const real_t beta1, beta2, ombeta1, numStab;
+
+		//beta1t is updated here. On the first call it must be initialized with 1
+		opt_AdaMax(smatrix<real_t>& Mt, smatrix<real_t>& Ut, real_t& beta1t, const real_t learningRate
+			, const real_t b1, const real_t b2, const real_t ns)noexcept
+			: pM(Mt.data()), pU(Ut.data()), beta1(b1), beta2(b2), ombeta1(real_t(1) - b1), numStab(ns)
+		{
+			NNTL_ASSERT(real_t(0.) < beta1 && beta1 < real_t(1.) && real_t(0.) < beta2 && beta2 < real_t(1.));
+			beta1t *= beta1;
+			NNTL_ASSERT(beta1t < real_t(1.));
+			alphat = learningRate / (real_t(1.) - beta1t);
+		}
+		nntl_force_inline real_t operator()(const real_t g, const numel_cnt_t i)const noexcept {
+			const auto m = pM[i] * beta1 + g*ombeta1;
+			pM[i] = m;
+			const auto u = ::std::max({ ::std::abs(g),beta2*pU[i] });
+			pU[i] = u;
+			return alphat*m / (u + numStab);
+		}
+	};
+
+	//Nadam (gamma==0) and Radam
+	template<typename RealT>
+	struct opt_RNadam : public smatrix_td {
+		typedef RealT real_t;
+		real_t*const pM;
+		real_t*const pN;
+		const real_t lr, numStab;
+		real_t mu_t, eta_t, o_m_mu_t, o_m_eta_t, mHat_c_mt, mHat_c_g;
+
+		//mu_pow_t and eta_pow_t are updated here. On the first call they must be initialized with 1
+		opt_RNadam(smatrix<real_t>& Mt, smatrix<real_t>& Nt, real_t& mu_pow_t, real_t& eta_pow_t, const real_t learningRate
+			, const real_t mu, const real_t eta, const real_t gamma, const real_t ns)noexcept
+			: pM(Mt.data()), pN(Nt.data()), lr(learningRate), numStab(ns)
+		{
+			NNTL_ASSERT(real_t(0.) < mu && mu < real_t(1.) && real_t(0.) < eta && eta < real_t(1.));
+			NNTL_ASSERT(real_t(0.) <= gamma && gamma < real_t(1.));
+			mu_pow_t *= mu;
+			eta_pow_t *= eta;
+			NNTL_ASSERT(mu_pow_t < real_t(1.) && eta_pow_t < real_t(1.));
+
+			mu_t = (mu - mu_pow_t) / (real_t(1.) - mu_pow_t);
+			eta_t = (eta - eta_pow_t) / (real_t(1.) - eta_pow_t);
+			o_m_mu_t = real_t(1.) - mu_t;
+			o_m_eta_t = real_t(1.) - eta_t;
+
+			const bool bIsNadam = gamma == real_t(0);
+			mHat_c_mt = bIsNadam ? mu*((real_t(1.) - mu_pow_t) / (real_t(1) - mu*mu_pow_t)) : (real_t(1.) - gamma);
+			mHat_c_g = bIsNadam ? o_m_mu_t : gamma;
+		}
+		nntl_force_inline real_t operator()(const real_t g, const numel_cnt_t i)const noexcept {
+			const auto n = pN[i] * eta_t + (g*g)*o_m_eta_t;
+			pN[i] = n;
+			const auto m = pM[i] * mu_t + g*o_m_mu_t;
+			pM[i] = m;
+			return lr*((mHat_c_mt*m + mHat_c_g*g) / (::std::sqrt(n) + numStab));
+		}
+	};
+
+}
+}
+}
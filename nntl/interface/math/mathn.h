@@ -33,6 +33,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "../_i_math.h"
 #include "bindings/b_open_blas.h"
+#include "bindings/b_native.h"
 //#include "bindings/b_yeppp.h"
 
 
@@ -41,6 +42,11 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <limits>
 #include "mathn_thr.h"
+#include "simd/act.h"
+#include "simd/smallgemm.h"
+#include "simd/qgemm.h"
+#include "simd/loss.h"
+#include "fused_update.h"
 
 #include "smath.h"
 
@@ -56,11 +62,23 @@ namespace math {
 		typedef _SMath<RealT, iThreadsT, ThresholdsT, FinalPolymorphChild> base_class_t;
 		typedef bindingBlasT b_BLAS_t;
 
+		//true if b_BLAS_t runs level-3 routines on our m_threads (see b_Native)
+		static constexpr bool bBlasRunsOnIThreads = _impl::blas_runs_on_ithreads<b_BLAS_t, iThreadsT>::value;
+
 		using base_class_t::real_t;
 		using base_class_t::realmtx_t;
 		using base_class_t::realmtxdef_t;
 		using base_class_t::numel_cnt_t;
 		using base_class_t::vec_len_t;
+		typedef typename realmtx_t::bitmask_word_t bitmask_word_t;
+
+		//weights packed for mMulABt_Cnb_small()
+		typedef simd::small_gemm_weights<real_t> small_gemm_weights_t;
+		//int8 weights and the scratch for int8 activations for mMulABt_Cnb_q8()
+		typedef simd::q8_weights<real_t> q8_weights_t;
+		typedef simd::q8_activations<real_t> q8_activations_t;
+		//sparse (CSR) data matrix, see smatrix_csr.h
+		typedef smatrix_csr<real_t> realmtx_csr_t;
 
 		//TODO: probably don't need this assert
 		static_assert(::std::is_base_of<_impl::MATHN_THR<real_t>, Thresholds_t>::value, "Thresholds_t must be derived from _impl::MATHN_THR<real_t>");
@@ -120,6 +138,7 @@ namespace math {
 
 		~_MathN()noexcept {};
 		_MathN() noexcept : base_class_t() {}
+		explicit _MathN(const thread_id_t nThreads) noexcept : base_class_t(nThreads) {}
 
 		//////////////////////////////////////////////////////////////////////////
 		// i_math interface implementation
@@ -167,7 +186,21 @@ namespace math {
 		static void softmax_parts_st_cw(const realmtx_t& act, const real_t*const pMax, real_t*const pDenominator, real_t*const pNumerator, const rowcol_range*const pRCR = nullptr)noexcept {
 			NNTL_ASSERT(act.numel() > 0 && !act.empty() && pMax && pDenominator && pNumerator);
 			_memset_rowrange(pDenominator, real_t(0.0), act.rows(), pRCR);
-			_mrwVecOperation_st_cw(act, pDenominator, 0, pRCR ? *pRCR : rowcol_range(act), _mrw_SOFTMAXPARTS(pMax, pNumerator));
+			const rowcol_range RCR(pRCR ? *pRCR : rowcol_range(act));
+			const size_t rm = act.rows(), rb = RCR.rowBegin, rcnt = RCR.totalRows();
+			const auto pMx = pMax + rb;
+			const auto pDen = pDenominator + rb;
+			//columns are processed by the vectorized kernel, the rest of each column is done here
+			for (vec_len_t c = RCR.colBegin; c < RCR.colEnd; ++c) {
+				const auto ofs = rm*c + rb;
+				const auto pA = act.data() + ofs;
+				const auto pNum = pNumerator + ofs;
+				for (size_t i = simd::act<real_t>::softmax_parts(pA, pMx, pNum, pDen, rcnt); i < rcnt; ++i) {
+					const auto numerator = ::std::exp(pA[i] - pMx[i]);
+					pDen[i] += numerator;
+					pNum[i] = numerator;
+				}
+			}
 		}
 		void softmax_parts_mt(const realmtx_t& act, const real_t*const pMax, real_t*const pDenominator, real_t*const pNumerator)noexcept {
 			if (act.cols() <= Thresholds_t::softmax_parts_mt_cw_ColsPerThread || act.rows()> Thresholds_t::softmax_parts_mt_rows) {
@@ -401,6 +434,92 @@ namespace math {
 			}, dest.rows());
 		}
 
+		//same as mExtractRows(), but a thread that executes par_range_t with tid()==t reads the rows from the srcForTid(t) copy
+		// of the src data (the copy must have exactly the same layout). Intended to be used with threads::numa::node_replicas
+		template<typename SeqIt, typename SrcForTidT>
+		void mExtractRows_replicated(const realmtx_t& src, SrcForTidT&& srcForTid, const SeqIt& ridxsItBegin, realmtx_t& dest)noexcept {
+			NNTL_ASSERT(!dest.empty() && !src.empty());
+			NNTL_ASSERT(dest.cols() == src.cols() && dest.rows() <= src.rows());
+			if (dest.cols()<2 || dest.numel() < Thresholds_t::mExtractRows) {
+				const realmtx_t s(const_cast<real_t*>(srcForTid(0)), src.rows(), src.cols(), src.emulatesBiases(), src.isHoleyBiases());
+				_imExtractRows_seqWrite_st(s, ridxsItBegin, dest, elms_range(0, dest.rows()));
+			} else {
+				m_threads.run([&src, &srcForTid, &dest, &ridxsItBegin](const par_range_t& r) {
+					const realmtx_t s(const_cast<real_t*>(srcForTid(r.tid())), src.rows(), src.cols(), src.emulatesBiases(), src.isHoleyBiases());
+					_imExtractRows_seqWrite_st(s, ridxsItBegin, dest, elms_range(r));
+				}, dest.rows());
+			}
+		}
+
+		//extract rows of the sparse src with indexes specified by [ridxsItBegin, ridxsItBegin+dest.rows()) into dest.
+		// dest must have the proper size; its capacity grows if necessary. Returns false if failed to allocate the memory
+		template<typename SeqIt>
+		bool mExtractRows(const realmtx_csr_t& src, const SeqIt& ridxsItBegin, realmtx_csr_t& dest)noexcept {
+			//the count of elements to copy is estimated by the mean row
+			if (dest.rows()*(src.nnz() / src.rows()) < Thresholds_t::mExtractRows_csr) {
+				return get_self().mExtractRows_st(src, ridxsItBegin, dest);
+			} else return get_self().mExtractRows_mt(src, ridxsItBegin, dest);
+		}
+		template<typename SeqIt>
+		bool mExtractRows_st(const realmtx_csr_t& src, const SeqIt& ridxsItBegin, realmtx_csr_t& dest)noexcept {
+			if (!_mExtractRows_prep(src, ridxsItBegin, dest)) return false;
+			_imExtractRows_st(src, ridxsItBegin, dest, elms_range(0, dest.rows()));
+			return true;
+		}
+		template<typename SeqIt>
+		bool mExtractRows_mt(const realmtx_csr_t& src, const SeqIt& ridxsItBegin, realmtx_csr_t& dest)noexcept {
+			if (!_mExtractRows_prep(src, ridxsItBegin, dest)) return false;
+			m_threads.run([&src, &dest, &ridxsItBegin](const par_range_t& r) {
+				_imExtractRows_st(src, ridxsItBegin, dest, elms_range(r));
+			}, dest.rows());
+			return true;
+		}
+	protected:
+		//makes row offsets of dest
+		template<typename SeqIt>
+		static bool _mExtractRows_prep(const realmtx_csr_t& src, const SeqIt& ridxsItBegin, realmtx_csr_t& dest)noexcept {
+			NNTL_ASSERT(!dest.empty() && !src.empty());
+			static_assert(::std::is_same<vec_len_t, SeqIt::value_type>::value, "Contnr type should contain vec_len_t data");
+			NNTL_ASSERT(dest.cols() == src.cols() && dest.rows() <= src.rows() && src.emulatesBiases() == dest.emulatesBiases());
+
+			const vec_len_t destRows = dest.rows();
+			const auto pSrcRP = src.row_ptrs();
+			numel_cnt_t n = 0;
+			SeqIt pRI = ridxsItBegin;
+			for (vec_len_t r = 0; r < destRows; ++r) {
+				const auto idx = *pRI++;
+				NNTL_ASSERT(idx < src.rows());
+				n += pSrcRP[idx + 1] - pSrcRP[idx];
+			}
+			if (!dest.reserve(n)) return false;
+
+			const auto pDestRP = dest.row_ptrs();
+			pDestRP[0] = 0;
+			pRI = ridxsItBegin;
+			for (vec_len_t r = 0; r < destRows; ++r) {
+				const auto idx = *pRI++;
+				pDestRP[r + 1] = pDestRP[r] + (pSrcRP[idx + 1] - pSrcRP[idx]);
+			}
+			return true;
+		}
+	public:
+		template<typename SeqIt>
+		static void _imExtractRows_st(const realmtx_csr_t& src, const SeqIt& ridxsItBegin, realmtx_csr_t& dest, const elms_range& er)noexcept {
+			const auto pSrcRP = src.row_ptrs();
+			const auto pDestRP = dest.row_ptrs();
+			SeqIt pRI = ridxsItBegin + er.elmBegin;
+			for (numel_cnt_t r = er.elmBegin; r < er.elmEnd; ++r) {
+				const auto idx = *pRI++;
+				const auto sb = pSrcRP[idx], db = pDestRP[r];
+				const auto cnt = pSrcRP[idx + 1] - sb;
+				NNTL_ASSERT(cnt == pDestRP[r + 1] - db);
+				if (cnt) {
+					memcpy(dest.values() + db, src.values() + sb, cnt * sizeof(real_t));
+					memcpy(dest.col_idxs() + db, src.col_idxs() + sb, cnt * sizeof(vec_len_t));
+				}
+			}
+		}
+
 		//////////////////////////////////////////////////////////////////////////
 		//////////////////////////////////////////////////////////////////////////
 		// compute squared L2norm of each matrix A row into a vector pNormsVec: pNormsVec(i) = norm(A(i,:)) (rowwise sum of squares)
@@ -759,6 +878,112 @@ namespace math {
 			}, dropoutMask.numel());
 		}
 
+		//////////////////////////////////////////////////////////////////////////
+		// Dropout variants with the bit-packed mask (see _i_rng::bernoulli_bits(); set bit means "keep").
+		// In a single pass they store the original activations into origAct (it must be of act.size_no_bias() size) and
+		// apply the mask (with keepVal scaling) to act. The range is always a range of mask words.
+		// A <- bit ? A*keepVal : 0
+		void make_dropout_packed(realmtx_t& act, const real_t keepVal, const bitmask_word_t*const pMask, realmtx_t& origAct)noexcept {
+			if (origAct.numel() < Thresholds_t::make_dropout_packed) {
+				get_self().make_dropout_packed_st(act, keepVal, pMask, origAct);
+			} else get_self().make_dropout_packed_mt(act, keepVal, pMask, origAct);
+		}
+		void make_dropout_packed_st(realmtx_t& act, const real_t keepVal, const bitmask_word_t*const pMask, realmtx_t& origAct
+			, const elms_range*const pER = nullptr)const noexcept
+		{
+			_imake_dropout_packed_st(act, keepVal, real_t(0), real_t(0), pMask, origAct
+				, pER ? *pER : elms_range(0, realmtx_t::sBitMaskWords(origAct.numel())));
+		}
+		void make_dropout_packed_mt(realmtx_t& act, const real_t keepVal, const bitmask_word_t*const pMask, realmtx_t& origAct)noexcept {
+			m_threads.run([&act, keepVal, pMask, &origAct](const par_range_t& r) {
+				_imake_dropout_packed_st(act, keepVal, real_t(0), real_t(0), pMask, origAct, elms_range(r));
+			}, realmtx_t::sBitMaskWords(origAct.numel()));
+		}
+
+		// Alpha-dropout (see make_alphaDropout()): A <- bit ? A*a_dmKeepVal + b_mbKeepVal : mbDropVal
+		void make_alphaDropout_packed(realmtx_t& act, const real_t a_dmKeepVal, const real_t b_mbKeepVal, const real_t mbDropVal
+			, const bitmask_word_t*const pMask, realmtx_t& origAct)noexcept
+		{
+			if (origAct.numel() < Thresholds_t::make_alphaDropout_packed) {
+				get_self().make_alphaDropout_packed_st(act, a_dmKeepVal, b_mbKeepVal, mbDropVal, pMask, origAct);
+			} else get_self().make_alphaDropout_packed_mt(act, a_dmKeepVal, b_mbKeepVal, mbDropVal, pMask, origAct);
+		}
+		void make_alphaDropout_packed_st(realmtx_t& act, const real_t a_dmKeepVal, const real_t b_mbKeepVal, const real_t mbDropVal
+			, const bitmask_word_t*const pMask, realmtx_t& origAct, const elms_range*const pER = nullptr)const noexcept
+		{
+			_imake_dropout_packed_st(act, a_dmKeepVal, b_mbKeepVal, mbDropVal, pMask, origAct
+				, pER ? *pER : elms_range(0, realmtx_t::sBitMaskWords(origAct.numel())));
+		}
+		void make_alphaDropout_packed_mt(realmtx_t& act, const real_t a_dmKeepVal, const real_t b_mbKeepVal, const real_t mbDropVal
+			, const bitmask_word_t*const pMask, realmtx_t& origAct)noexcept
+		{
+			m_threads.run([&act, a_dmKeepVal, b_mbKeepVal, mbDropVal, pMask, &origAct](const par_range_t& r) {
+				_imake_dropout_packed_st(act, a_dmKeepVal, b_mbKeepVal, mbDropVal, pMask, origAct, elms_range(r));
+			}, realmtx_t::sBitMaskWords(origAct.numel()));
+		}
+
+		//A <- bit ? A*keepVal + keepAdd : dropVal. The inverted dropout is the case of keepAdd==dropVal==0
+		static void _imake_dropout_packed_st(realmtx_t& act, const real_t keepVal, const real_t keepAdd, const real_t dropVal
+			, const bitmask_word_t*const pMask, realmtx_t& origAct, const elms_range& er)noexcept
+		{
+			NNTL_ASSERT(act.emulatesBiases() && !origAct.emulatesBiases());
+			NNTL_ASSERT(act.size_no_bias() == origAct.size());
+			NNTL_ASSERT(pMask && keepVal > real_t(0));
+			const numel_cnt_t n = origAct.numel();
+			NNTL_ASSERT(er.elmEnd <= realmtx_t::sBitMaskWords(n));
+
+			const auto pA = act.data();
+			const auto pO = origAct.data();
+			for (numel_cnt_t w = er.elmBegin; w < er.elmEnd; ++w) {
+				const bitmask_word_t bits = pMask[w];
+				const numel_cnt_t ofs = w * 64;
+				const unsigned cnt = static_cast<unsigned>(::std::min(numel_cnt_t(64), n - ofs));
+				real_t*const __restrict pAw = pA + ofs;
+				real_t*const __restrict pOw = pO + ofs;
+				for (unsigned j = 0; j < cnt; ++j) {
+					const real_t v = pAw[j];
+					pOw[j] = v;
+					pAw[j] = ((bits >> j) & 1) ? v*keepVal + keepAdd : dropVal;
+				}
+			}
+		}
+
+		//A <- bit ? A*keepVal : 0. That's what the dropout does to dL/dA during bprop
+		void evMulByBitMask_ip(realmtx_t& A, const bitmask_word_t*const pMask, const real_t keepVal)noexcept {
+			if (A.numel() < Thresholds_t::evMulByBitMask_ip) {
+				get_self().evMulByBitMask_ip_st(A, pMask, keepVal);
+			} else get_self().evMulByBitMask_ip_mt(A, pMask, keepVal);
+		}
+		void evMulByBitMask_ip_st(realmtx_t& A, const bitmask_word_t*const pMask, const real_t keepVal
+			, const elms_range*const pER = nullptr)const noexcept
+		{
+			_ievMulByBitMask_ip_st(A, pMask, keepVal, pER ? *pER : elms_range(0, realmtx_t::sBitMaskWords(A.numel())));
+		}
+		void evMulByBitMask_ip_mt(realmtx_t& A, const bitmask_word_t*const pMask, const real_t keepVal)noexcept {
+			m_threads.run([&A, pMask, keepVal](const par_range_t& r) {
+				_ievMulByBitMask_ip_st(A, pMask, keepVal, elms_range(r));
+			}, realmtx_t::sBitMaskWords(A.numel()));
+		}
+		//er is a range of mask words
+		static void _ievMulByBitMask_ip_st(realmtx_t& A, const bitmask_word_t*const pMask, const real_t keepVal
+			, const elms_range& er)noexcept
+		{
+			NNTL_ASSERT(!A.emulatesBiases() && pMask);
+			const numel_cnt_t n = A.numel();
+			NNTL_ASSERT(er.elmEnd <= realmtx_t::sBitMaskWords(n));
+
+			const auto pA = A.data();
+			for (numel_cnt_t w = er.elmBegin; w < er.elmEnd; ++w) {
+				const bitmask_word_t bits = pMask[w];
+				const numel_cnt_t ofs = w * 64;
+				const unsigned cnt = static_cast<unsigned>(::std::min(numel_cnt_t(64), n - ofs));
+				real_t*const pAw = pA + ofs;
+				for (unsigned j = 0; j < cnt; ++j) {
+					pAw[j] = ((bits >> j) & 1) ? pAw[j] * keepVal : real_t(0);
+				}
+			}
+		}
+
 		////////////////////////////////////////////////////////////////////////// 
 		//////////////////////////////////////////////////////////////////////////
 		//apply individual learning rate to dLdW
@@ -1553,9 +1778,20 @@ namespace math {
 			}, _vec_sum<false, real_t>, A.numel());
 		}
 
+		//////////////////////////////////////////////////////////////////////////
+		// every gemm call goes through _gemm() to pass m_threads to bindings that need it
+		template<bool _b = bBlasRunsOnIThreads, typename... ArgsT>
+		::std::enable_if_t<_b> _gemm(ArgsT&&... args)noexcept {
+			b_BLAS_t::gemm(m_threads, ::std::forward<ArgsT>(args)...);
+		}
+		template<bool _b = bBlasRunsOnIThreads, typename... ArgsT>
+		::std::enable_if_t<!_b> _gemm(ArgsT&&... args)noexcept {
+			b_BLAS_t::gemm(::std::forward<ArgsT>(args)...);
+		}
+
 		//////////////////////////////////////////////////////////////////////////
 		//C = A * B, - matrix multiplication
-		static void mMulAB_C(const realmtx_t& A, const realmtx_t& B, realmtx_t& C)noexcept {
+		void mMulAB_C(const realmtx_t& A, const realmtx_t& B, realmtx_t& C)noexcept {
 			A.assert_storage_does_not_intersect(B);
 			A.assert_storage_does_not_intersect(C);
 			B.assert_storage_does_not_intersect(C);
@@ -1567,7 +1803,7 @@ namespace math {
 			B.breakWhenDenormal();
 #endif
 
-			b_BLAS_t::gemm(false, false, A.rows(), C.cols(), acols, real_t(1.0), A.data(), A.rows(), B.data(), B.rows(),
+			get_self()._gemm(false, false, A.rows(), C.cols(), acols, real_t(1.0), A.data(), A.rows(), B.data(), B.rows(),
 				real_t(0.0), C.data(), C.rows());
 #if NNTL_DEBUGBREAK_ON_OPENBLAS_DENORMALS
 			C.breakWhenDenormal();
@@ -1575,7 +1811,7 @@ namespace math {
 		}
 		//////////////////////////////////////////////////////////////////////////
 		//matrix multiplication C(no bias) = A * B` (B transposed). C could have emulated biases (they will be left untouched)
-		static void mMulABt_Cnb(const realmtx_t& A, const realmtx_t& B, realmtx_t& C)noexcept {
+		void mMulABt_Cnb(const realmtx_t& A, const realmtx_t& B, realmtx_t& C)noexcept {
 			A.assert_storage_does_not_intersect(B);
 			A.assert_storage_does_not_intersect(C);
 			B.assert_storage_does_not_intersect(C);
@@ -1587,16 +1823,185 @@ namespace math {
 			B.breakWhenDenormal();
 #endif
 
-			b_BLAS_t::gemm(false, true, A.rows(), ccols, A.cols(), real_t(1.0), A.data(), A.rows(), B.data(), ccols,
+			get_self()._gemm(false, true, A.rows(), ccols, A.cols(), real_t(1.0), A.data(), A.rows(), B.data(), ccols,
 				real_t(0.0), C.data(), C.rows());
 
 #if NNTL_DEBUGBREAK_ON_OPENBLAS_DENORMALS
 			C.breakWhenDenormal();
 #endif
 		}
+		//////////////////////////////////////////////////////////////////////////
+		// C = A * B' with an epilogue. Same as mMulABt_Cnb(), but epilogue(P) is called for every part of C right after
+		// the part was computed, while it's still in cache. P is a bias-less matrix that uses part's storage (the epilogue
+		// may change it), so the epilogue is the place to apply an elementwise function (such as an activation) to C
+		// without a separate pass over the whole matrix. Biases of C (if any) are left untouched.
+		// With b_Native binding the epilogue runs inside the gemm loops on each finished block of C by the thread that computed
+		// it, so it's called concurrently for disjoint parts and MUST use single threaded (_st) functions only. If a block
+		// doesn't span whole columns of C, the epilogue gets every column of the block separately.
+		// Other bindings provide no way into their loops, so C is computed there by column panels that fit into cache.
+		template<typename EpilogueF>
+		void mMulABt_Cnb_ep(const realmtx_t& A, const realmtx_t& B, realmtx_t& C, EpilogueF&& epilogue)noexcept {
+			A.assert_storage_does_not_intersect(B);
+			A.assert_storage_does_not_intersect(C);
+			B.assert_storage_does_not_intersect(C);
+			NNTL_ASSERT(A.cols() == B.cols() && A.rows() == C.rows() && B.rows() == C.cols_no_bias());
+
+#if NNTL_DEBUGBREAK_ON_OPENBLAS_DENORMALS
+			A.breakWhenDenormal();
+			B.breakWhenDenormal();
+#endif
+			get_self()._mMulABt_Cnb_ep(A, B, C, epilogue);
+		}
+
+	protected:
+		template<typename EpilogueF, bool _b = bBlasRunsOnIThreads>
+		::std::enable_if_t<_b> _mMulABt_Cnb_ep(const realmtx_t& A, const realmtx_t& B, realmtx_t& C, EpilogueF& epilogue)noexcept {
+			const auto rm = A.rows();
+			b_BLAS_t::gemm_ep(m_threads, false, true, rm, C.cols_no_bias(), A.cols(), real_t(1.0), A.data(), rm
+				, B.data(), B.rows(), real_t(0.0), C.data(), rm
+				, [&epilogue](real_t*const pC, const size_t ldc, const size_t mc, const size_t nc)
+			{
+				realmtx_t P;
+				if (mc == ldc) {
+					P.useExternalStorage(pC, static_cast<vec_len_t>(mc), static_cast<vec_len_t>(nc), false);
+#if NNTL_DEBUGBREAK_ON_OPENBLAS_DENORMALS
+					P.breakWhenDenormal();
+#endif
+					epilogue(P);
+				} else {
+					for (size_t j = 0; j < nc; ++j) {
+						P.useExternalStorage(pC + j*ldc, static_cast<vec_len_t>(mc), 1, false);
+#if NNTL_DEBUGBREAK_ON_OPENBLAS_DENORMALS
+						P.breakWhenDenormal();
+#endif
+						epilogue(P);
+					}
+				}
+			});
+		}
+
+		template<typename EpilogueF, bool _b = bBlasRunsOnIThreads>
+		::std::enable_if_t<!_b> _mMulABt_Cnb_ep(const realmtx_t& A, const realmtx_t& B, realmtx_t& C, EpilogueF& epilogue)noexcept {
+			const auto ccols = C.cols_no_bias();
+			const auto rm = A.rows();
+			const vec_len_t panelCols = ::std::min(ccols, ::std::max(vec_len_t(Thresholds_t::mMulABt_Cnb_ep_minCols)
+				, static_cast<vec_len_t>(Thresholds_t::mMulABt_Cnb_ep_panel / rm)));
+			
+			realmtx_t P;
+			for (vec_len_t c0 = 0; c0 < ccols; c0 += panelCols) {
+				const vec_len_t pc = ::std::min(panelCols, ccols - c0);
+				const auto pC = C.colDataAsVec(c0);
+				get_self()._gemm(false, true, rm, pc, A.cols(), real_t(1.0), A.data(), rm, B.data() + c0, ccols,
+					real_t(0.0), pC, rm);
+				P.useExternalStorage(pC, rm, pc, false);
+#if NNTL_DEBUGBREAK_ON_OPENBLAS_DENORMALS
+				P.breakWhenDenormal();
+#endif
+				epilogue(P);
+			}
+		}
+
+	public:
+		//////////////////////////////////////////////////////////////////////////
+		// Low latency C = A * B' for a tiny A (a single sample or a few samples during inference).
+		// B must be packed beforehand by mPack4SmallMulABt() and repacked every time it changes. The product is computed by
+		// the calling thread only, see simd/smallgemm.h
+
+		//packs B for mMulABt_Cnb_small(). Returns false if failed to allocate the memory
+		static bool mPack4SmallMulABt(const realmtx_t& B, small_gemm_weights_t& Bp)noexcept {
+			NNTL_ASSERT(!B.empty() && !B.emulatesBiases());
+			return simd::small_gemm<real_t>::pack(Bp, B.data(), B.rows(), B.cols(), B.rows());
+		}
+		//returns true if mMulABt_Cnb_small() should be used instead of mMulABt_Cnb() for A with aRows rows times B of size
+		// (bRows, bCols)
+		static bool useSmallMulABt(const vec_len_t aRows, const vec_len_t bRows, const vec_len_t bCols)noexcept {
+			return aRows <= Thresholds_t::mMulABt_Cnb_small_maxRows
+				&& realmtx_t::sNumel(aRows, bRows)*bCols <= Thresholds_t::mMulABt_Cnb_small_maxMACs;
+		}
+		//matrix multiplication C(no bias) = A * B` (B transposed) with B packed by mPack4SmallMulABt().
+		// C could have emulated biases (they will be left untouched)
+		void mMulABt_Cnb_small(const realmtx_t& A, const small_gemm_weights_t& Bp, realmtx_t& C)noexcept {
+			A.assert_storage_does_not_intersect(C);
+			NNTL_ASSERT(!Bp.empty() && A.cols() == Bp.inputs() && A.rows() == C.rows() && Bp.neurons() == C.cols_no_bias());
+			simd::small_gemm<real_t>::run(A.rows(), A.data(), A.rows(), Bp, C.data(), C.rows());
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		// Quantized C = A * B' for the inference. B is quantized to int8 beforehand by mQuantize4MulABt_q8() (every row with its own
+		// scale), A is quantized on every call with a single scale into the scratch Aq, and the product is accumulated in int32,
+		// see simd/qgemm.h. The result differs from mMulABt_Cnb() by the quantization error, so it's never used for training.
+
+		//quantizes B (the weights of a layer, the last column holds biases) for mMulABt_Cnb_q8().
+		// Returns false if failed to allocate the memory
+		static bool mQuantize4MulABt_q8(const realmtx_t& B, q8_weights_t& Bq)noexcept {
+			NNTL_ASSERT(!B.empty() && !B.emulatesBiases() && B.cols() > 1);
+			const auto K = B.cols() - 1;
+			return Bq.quantize(B.data(), B.rows(), K, B.rows(), B.colDataAsVec(K));
+		}
+		//matrix multiplication C(no bias) = A * B` (B transposed) with B quantized by mQuantize4MulABt_q8(). The last column of A must
+		// contain biases (ones), they are accounted by the last column of B. Returns false if failed to allocate the memory for Aq.
+		// C could have emulated biases (they will be left untouched)
+		bool mMulABt_Cnb_q8(const realmtx_t& A, q8_activations_t& Aq, const q8_weights_t& Bq, realmtx_t& C)noexcept {
+			return get_self().mMulABt_Cnb_q8(A, Aq, Bq, C, [](realmtx_t&)noexcept {});
+		}
+		//same as mMulABt_Cnb_q8(), but C is computed in column panels and epilogue(P) is called for every panel P right after
+		// it was computed (see mMulABt_Cnb_ep()). The dequantization happens in the kernel, so the epilogue gets real values.
+		template<typename EpilogueF>
+		bool mMulABt_Cnb_q8(const realmtx_t& A, q8_activations_t& Aq, const q8_weights_t& Bq, realmtx_t& C, EpilogueF&& epilogue)noexcept {
+			A.assert_storage_does_not_intersect(C);
+			NNTL_ASSERT(!Bq.empty());
+			const size_t rm = A.rows(), K = Bq.inputs();
+			const vec_len_t ccols = C.cols_no_bias();
+			NNTL_ASSERT(K + 1 == static_cast<size_t>(A.cols()) && A.rows() == C.rows() && Bq.neurons() == static_cast<size_t>(ccols));
+
+			if (!Aq.reserve(rm, Bq.padded_inputs())) return false;
+
+			typedef simd::q8_gemm<real_t> q8_gemm_t;
+			const real_t*const pA = A.data();
+			const bool bMT = rm*K*ccols >= Thresholds_t::mMulABt_Cnb_q8_mt;
+			//quantization of A. First K columns of A are contiguous, so max|A| is taken over a plain vector
+			if (bMT) {
+				Aq.set_amax(m_threads.reduce([pA](const par_range_t& r)->real_t {
+					return q8_activations_t::amax(pA + r.offset(), r.cnt());
+				}, [](const real_t* p, const size_t cnt)noexcept->real_t {
+					return *::std::max_element(p, p + cnt);
+				}, rm*K));
+				m_threads.run([pA, rm, K, &Aq](const par_range_t& r) {
+					Aq.quantize_rows(pA, rm, K, r.offset(), r.offset() + r.cnt());
+				}, rm);
+			} else {
+				Aq.set_amax(q8_activations_t::amax(pA, rm*K));
+				Aq.quantize_rows(pA, rm, K, 0, rm);
+			}
+
+			const vec_len_t panelCols = ::std::min(ccols, ::std::max(vec_len_t(Thresholds_t::mMulABt_Cnb_q8_minCols)
+				, static_cast<vec_len_t>(Thresholds_t::mMulABt_Cnb_q8_panel / rm)));
+			real_t*const pC = C.data();
+			realmtx_t P;
+			for (vec_len_t c0 = 0; c0 < ccols; c0 += panelCols) {
+				const vec_len_t pc = ::std::min(panelCols, ccols - c0);
+				if (bMT) {
+					//splitting the panel along its bigger dimension
+					if (rm >= static_cast<size_t>(pc)) {
+						m_threads.run([&Aq, &Bq, pC, rm, c0, pc](const par_range_t& r) {
+							q8_gemm_t::run(Aq, Bq, r.offset(), r.offset() + r.cnt(), c0, c0 + pc, pC, rm);
+						}, rm);
+					} else {
+						m_threads.run([&Aq, &Bq, pC, rm, c0](const par_range_t& r) {
+							q8_gemm_t::run(Aq, Bq, 0, rm, c0 + r.offset(), c0 + r.offset() + r.cnt(), pC, rm);
+						}, pc);
+					}
+				} else q8_gemm_t::run(Aq, Bq, 0, rm, c0, c0 + pc, pC, rm);
+
+				P.useExternalStorage(C.colDataAsVec(c0), static_cast<vec_len_t>(rm), pc, false);
+				epilogue(P);
+			}
+			return true;
+		}
+
 		//////////////////////////////////////////////////////////////////////////
 		//C = a*(A` * B) - matrix multiplication of transposed A times B with result normalization
-		static void mScaledMulAtB_C(const real_t& alpha, const realmtx_t& A, const realmtx_t& B, realmtx_t& C)noexcept {
+		void mScaledMulAtB_C(const real_t& alpha, const realmtx_t& A, const realmtx_t& B, realmtx_t& C)noexcept {
 			//A.assert_storage_does_not_intersect(B);
 			A.assert_storage_does_not_intersect(C);
 			B.assert_storage_does_not_intersect(C);
@@ -1614,7 +2019,7 @@ namespace math {
 			global_denormalized_floats_mode();
 #endif
 
-			b_BLAS_t::gemm(true, false, acols, B.cols(), arows, alpha, A.data(), arows, B.data(), arows,
+			get_self()._gemm(true, false, acols, B.cols(), arows, alpha, A.data(), arows, B.data(), arows,
 				real_t(0.0), C.data(), acols);
 
 #if NNTL_DEBUGBREAK_ON_OPENBLAS_DENORMALS
@@ -1622,6 +2027,126 @@ namespace math {
 #endif
 		}
 
+		//////////////////////////////////////////////////////////////////////////
+		// Sparse x dense products for the first layer fed by sparse data (see smatrix_csr.h). The sparse matrix plays the role
+		// of the layer input activations, so the bias column (if emulated) is implied and handled here.
+		// The work is done on blocks of _SparseBlockElms neurons: the corresponding part of a row of weights is contiguous
+		// (weights are stored column major as neurons x inputs), so every nonzero value updates a short contiguous vector.
+	protected:
+		static constexpr vec_len_t _SparseBlockElms = 256;
+
+	public:
+		//matrix multiplication C(no bias) = A * B` (B transposed) for a sparse A. C could have emulated biases (they will be left untouched)
+		void mMulABt_Cnb(const realmtx_csr_t& A, const realmtx_t& B, realmtx_t& C)noexcept {
+			if (static_cast<numel_cnt_t>(A.nnz())*B.rows() < Thresholds_t::mMulABt_Cnb_csr) {
+				get_self().mMulABt_Cnb_st(A, B, C);
+			} else get_self().mMulABt_Cnb_mt(A, B, C);
+		}
+		void mMulABt_Cnb_st(const realmtx_csr_t& A, const realmtx_t& B, realmtx_t& C, const elms_range*const pER = nullptr)noexcept {
+			_imMulABt_Cnb_st(A, B, C, pER ? *pER : elms_range(0, A.rows()));
+		}
+		void mMulABt_Cnb_mt(const realmtx_csr_t& A, const realmtx_t& B, realmtx_t& C)noexcept {
+			m_threads.run([&A, &B, &C](const par_range_t& r) {
+				_imMulABt_Cnb_st(A, B, C, elms_range(r));
+			}, A.rows());
+		}
+		//er is a range of rows of A
+		static void _imMulABt_Cnb_st(const realmtx_csr_t& A, const realmtx_t& B, realmtx_t& C, const elms_range& er)noexcept {
+			NNTL_ASSERT(!A.empty() && !B.empty() && !C.empty());
+			const vec_len_t N = C.cols_no_bias(), K = A.cols_no_bias();
+			NNTL_ASSERT(A.cols() == B.cols() && A.rows() == C.rows() && B.rows() == N);
+			const numel_cnt_t cRows = C.rows();
+
+			const auto pVals = A.values();
+			const auto pColIdxs = A.col_idxs();
+			const auto pRowPtrs = A.row_ptrs();
+			const auto pB = B.data();
+			const auto pBBias = A.emulatesBiases() ? pB + static_cast<numel_cnt_t>(K)*N : nullptr;
+			const auto pC = C.data();
+
+			real_t acc[_SparseBlockElms];
+			for (vec_len_t n0 = 0; n0 < N; n0 += _SparseBlockElms) {
+				const vec_len_t nb = ::std::min(_SparseBlockElms, N - n0);
+				for (numel_cnt_t r = er.elmBegin; r < er.elmEnd; ++r) {
+					if (pBBias) {
+						for (vec_len_t j = 0; j < nb; ++j) acc[j] = pBBias[n0 + j];
+					} else ::std::fill_n(acc, nb, real_t(0));
+
+					for (numel_cnt_t i = pRowPtrs[r], ie = pRowPtrs[r + 1]; i < ie; ++i) {
+						const real_t v = pVals[i];
+						const auto pBk = pB + static_cast<numel_cnt_t>(pColIdxs[i])*N + n0;
+						for (vec_len_t j = 0; j < nb; ++j) acc[j] += v*pBk[j];
+					}
+
+					auto pCr = pC + r + static_cast<numel_cnt_t>(n0)*cRows;
+					for (vec_len_t j = 0; j < nb; ++j) {
+						*pCr = acc[j];
+						pCr += cRows;
+					}
+				}
+			}
+		}
+
+		//C = a*(A` * B) for a sparse B - the dL/dW of the first layer. C gets the bias column if B emulates biases
+		void mScaledMulAtB_C(const real_t& alpha, const realmtx_t& A, const realmtx_csr_t& B, realmtx_t& C)noexcept {
+			if (static_cast<numel_cnt_t>(B.nnz())*A.cols() < Thresholds_t::mScaledMulAtB_C_csr) {
+				get_self().mScaledMulAtB_C_st(alpha, A, B, C);
+			} else get_self().mScaledMulAtB_C_mt(alpha, A, B, C);
+		}
+		void mScaledMulAtB_C_st(const real_t& alpha, const realmtx_t& A, const realmtx_csr_t& B, realmtx_t& C
+			, const elms_range*const pER = nullptr)noexcept
+		{
+			_imScaledMulAtB_C_st(alpha, A, B, C, pER ? *pER : elms_range(0, A.cols()));
+		}
+		void mScaledMulAtB_C_mt(const real_t& alpha, const realmtx_t& A, const realmtx_csr_t& B, realmtx_t& C)noexcept {
+			m_threads.run([&alpha, &A, &B, &C](const par_range_t& r) {
+				_imScaledMulAtB_C_st(alpha, A, B, C, elms_range(r));
+			}, A.cols());
+		}
+		//er is a range of columns of A (i.e. rows of C), so different threads never write to the same elements
+		static void _imScaledMulAtB_C_st(const real_t& alpha, const realmtx_t& A, const realmtx_csr_t& B, realmtx_t& C
+			, const elms_range& er)noexcept
+		{
+			NNTL_ASSERT(!A.empty() && !B.empty() && !C.empty());
+			A.assert_storage_does_not_intersect(C);
+			const numel_cnt_t N = A.cols(), aRows = A.rows();
+			NNTL_ASSERT(aRows == B.rows() && N == C.rows() && B.cols() == C.cols());
+			const vec_len_t K = B.cols_no_bias(), cCols = C.cols();
+
+			const auto pVals = B.values();
+			const auto pColIdxs = B.col_idxs();
+			const auto pRowPtrs = B.row_ptrs();
+			const auto pA = A.data();
+			const auto pC = C.data();
+			const auto pCBias = B.emulatesBiases() ? pC + static_cast<numel_cnt_t>(K)*N : nullptr;
+
+			real_t a[_SparseBlockElms];
+			for (numel_cnt_t n0 = er.elmBegin; n0 < er.elmEnd; n0 += _SparseBlockElms) {
+				const vec_len_t nb = static_cast<vec_len_t>(::std::min(static_cast<numel_cnt_t>(_SparseBlockElms), er.elmEnd - n0));
+
+				for (vec_len_t c = 0; c < cCols; ++c) {
+					::std::fill_n(pC + static_cast<numel_cnt_t>(c)*N + n0, nb, real_t(0));
+				}
+
+				for (numel_cnt_t r = 0; r < aRows; ++r) {
+					auto pAr = pA + r + n0*aRows;
+					for (vec_len_t j = 0; j < nb; ++j) {
+						a[j] = alpha*(*pAr);
+						pAr += aRows;
+					}
+
+					for (numel_cnt_t i = pRowPtrs[r], ie = pRowPtrs[r + 1]; i < ie; ++i) {
+						const real_t v = pVals[i];
+						const auto pCk = pC + static_cast<numel_cnt_t>(pColIdxs[i])*N + n0;
+						for (vec_len_t j = 0; j < nb; ++j) pCk[j] += v*a[j];
+					}
+					if (pCBias) {
+						for (vec_len_t j = 0; j < nb; ++j) pCBias[n0 + j] += a[j];
+					}
+				}
+			}
+		}
+
 		//////////////////////////////////////////////////////////////////////////
 		// Computes a symmetrical matrix C = 1/ARowsCnt  A' * A.
 		// If the columns of A are zero meaned, the resulting matrix is the actual covariance matrix for columns of A
@@ -1708,7 +2233,7 @@ namespace math {
 		template<> struct _mIsOrthogonal_defEps<float> { static constexpr float eps = 1e-5f; };
 		// This function checks whether A is orthogonal, i.e. A'*A is identity matrix.
 		// Not optimized, FOR DEBUG PURPOSES ONLY!
-		static bool _mIsOrthogonal(const realmtx_t& A,  bool bFirstTransposed = true, const real_t epsV = _mIsOrthogonal_defEps<real_t>::eps)noexcept {
+		bool _mIsOrthogonal(const realmtx_t& A,  bool bFirstTransposed = true, const real_t epsV = _mIsOrthogonal_defEps<real_t>::eps)noexcept {
 			NNTL_ASSERT(!A.empty());
 			const vec_len_t opArows = bFirstTransposed ? A.cols() : A.rows()
 				, opAcols = bFirstTransposed ? A.rows() : A.cols()
@@ -1719,7 +2244,7 @@ namespace math {
 			A.breakWhenDenormal();
 #endif
 
-			b_BLAS_t::gemm(bFirstTransposed, !bFirstTransposed, opArows, opArows, opAcols
+			get_self()._gemm(bFirstTransposed, !bFirstTransposed, opArows, opArows, opAcols
 				, real_t(1.), A.data(), ldab, A.data(), ldab,
 				real_t(0.0), ICand.data(), opArows);
 
@@ -1872,6 +2397,7 @@ namespace math {
 // 			for (range_t i = er.elmBegin; i < er.elmEnd; ++i) ptr[i] = real_t(1.0) / (real_t(1.0) + ::std::exp(-ptr[i]));
 			auto pA = srcdest.data() + er.elmBegin;
 			const auto pAE = pA + er.totalElements();
+			pA += simd::act<real_t>::sigm(pA, er.totalElements());
 			while (pA != pAE) {
 				const auto x = *pA;
 				*pA++ = real_t(1.0) / (real_t(1.0) + ::std::exp(-x));
@@ -1899,6 +2425,7 @@ namespace math {
 			NNTL_ASSERT(!f_df.empty());
 			auto pF = f_df.data() + er.elmBegin;
 			const auto pFE = pF + er.totalElements();
+			pF += simd::act<real_t>::dsigm(pF, er.totalElements());
 			while (pF != pFE) {
 				const auto f = *pF;
 				NNTL_ASSERT(f >= real_t(0.) && f <= real_t(1.));
@@ -2075,6 +2602,7 @@ namespace math {
 			NNTL_ASSERT(alpha > real_t(0.0));
 			auto pV = srcdest.data() + er.elmBegin;
 			const auto pVE = pV + er.totalElements();
+			pV += simd::act<real_t>::elu(pV, er.totalElements(), alpha);
 			while (pV != pVE) {
 				const auto v = *pV;
 				/*if (v < real_t(+0.0)) *pV = (::std::exp(v) - real_t(1.0))*alpha;
@@ -2104,6 +2632,7 @@ namespace math {
 			NNTL_ASSERT(!f_df.empty());
 			auto ptrDF = f_df.data() + er.elmBegin;
 			const auto ptrDFE = ptrDF + er.totalElements();
+			ptrDF += simd::act<real_t>::dselu(ptrDF, er.totalElements(), alpha, real_t(1.));
 			while (ptrDF != ptrDFE) {
 				const auto v = *ptrDF;
 				*ptrDF++ = v < real_t(0.) ? (v + alpha) : real_t(1.0);
@@ -2130,6 +2659,7 @@ namespace math {
 			NNTL_ASSERT(!srcdest.empty());
 			auto pV = srcdest.data() + er.elmBegin;
 			const auto pVE = pV + er.totalElements();
+			pV += simd::act<real_t>::elu(pV, er.totalElements(), real_t(1.));
 			while (pV != pVE) {
 				const auto v = *pV;
 				/*if (v < real_t(+0.0)) *pV = (::std::exp(v) - real_t(1.0));
@@ -2158,6 +2688,7 @@ namespace math {
 			NNTL_ASSERT(!f_df.empty());
 			auto ptrDF = f_df.data() + er.elmBegin;
 			const auto ptrDFE = ptrDF + er.totalElements();
+			ptrDF += simd::act<real_t>::dselu(ptrDF, er.totalElements(), real_t(1.), real_t(1.));
 			while (ptrDF != ptrDFE) {
 				const auto v = *ptrDF;
 				*ptrDF++ = v < real_t(0.) ? (v + real_t(1.0)) : real_t(1.0);
@@ -2188,6 +2719,7 @@ namespace math {
 			const real_t lbi = real_t(1.) / ::std::log(b);
 			auto pV = srcdest.data() + er.elmBegin;
 			const auto pVE = pV + er.totalElements();
+			pV += simd::act<real_t>::elogu(pV, er.totalElements(), alpha, lbi);
 			while (pV != pVE) {
 				const auto v = *pV;
 				//*pV++ = v < real_t(0.0) ? (::std::exp(v) - real_t(1.))*alpha : log(v + real_t(1.))*lbi;
@@ -2222,6 +2754,7 @@ namespace math {
 
 			auto ptrDF = f_df.data() + er.elmBegin;
 			const auto ptrDFE = ptrDF + er.totalElements();
+			ptrDF += simd::act<real_t>::delogu(ptrDF, er.totalElements(), alpha, nlb, nllb);
 			while (ptrDF != ptrDFE) {
 				const auto v = *ptrDF;
 				*ptrDF++ = v < real_t(0.) ? (v + alpha) : ::std::exp(v*nlb + nllb);
@@ -2252,6 +2785,7 @@ namespace math {
 			const real_t lbi = real_t(1.) / ::std::log(b);
 			auto pV = srcdest.data() + er.elmBegin;
 			const auto pVE = pV + er.totalElements();
+			pV += simd::act<real_t>::elogu(pV, er.totalElements(), real_t(1.), lbi);
 			while (pV != pVE) {
 				const auto v = *pV;
 				//*pV++ = v < real_t(0.0) ? (::std::exp(v) - real_t(1.)) : log(v + real_t(1.))*lbi;
@@ -2284,6 +2818,7 @@ namespace math {
 
 			auto ptrDF = f_df.data() + er.elmBegin;
 			const auto ptrDFE = ptrDF + er.totalElements();
+			ptrDF += simd::act<real_t>::delogu(ptrDF, er.totalElements(), real_t(1.), nlb, nllb);
 			while (ptrDF != ptrDFE) {
 				const auto v = *ptrDF;
 				*ptrDF++ = v < real_t(0.) ? (v + real_t(1.)) : ::std::exp(v*nlb + nllb);
@@ -2424,6 +2959,7 @@ namespace math {
 				, nlbnegi = real_t(ext_real_t (-1.) / ::std::log(ext_real_t(b_neg)));
 			auto pV = srcdest.data() + er.elmBegin;
 			const auto pVE = pV + er.totalElements();
+			pV += simd::act<real_t>::loglogu(pV, er.totalElements(), nlbnegi, lbposi);
 			while (pV != pVE) {
 				const auto v = *pV;
 				//const auto isNeg = v < real_t(0.0);
@@ -2462,6 +2998,7 @@ namespace math {
 			const real_t nllbneg = -static_cast<real_t>(::std::log(_lbneg)), lbneg = static_cast<real_t>(_lbneg);
 			auto ptrDF = f_df.data() + er.elmBegin;
 			const auto ptrDFE = ptrDF + er.totalElements();
+			ptrDF += simd::act<real_t>::dloglogu(ptrDF, er.totalElements(), lbneg, nllbneg, nlbpos, nllbpos);
 			while (ptrDF != ptrDFE) {
 				const auto v = *ptrDF;
 				*ptrDF++ = ::std::exp(v < real_t(0.) ? (v*lbneg + nllbneg) : (v*nlbpos + nllbpos));
@@ -2671,6 +3208,7 @@ namespace math {
 
 			auto pV = srcdest.data() + er.elmBegin;
 			const auto pVE = pV + er.totalElements();
+			pV += simd::act<real_t>::softsign(pV, er.totalElements(), a, real_t(1.));
 			while (pV != pVE) {
 				const auto v = *pV;
 				*pV++ = v / (a + ::std::abs(v));
@@ -2700,6 +3238,7 @@ namespace math {
 
 			auto pV = srcdest.data() + er.elmBegin;
 			const auto pVE = pV + er.totalElements();
+			pV += simd::act<real_t>::softsign(pV, er.totalElements(), a, c);
 			while (pV != pVE) {
 				const auto v = *pV;
 				*pV++ = (c*v) / (a + ::std::abs(v));
@@ -2727,6 +3266,7 @@ namespace math {
 			NNTL_ASSERT(!f_df.empty());
 			auto ptrDF = f_df.data() + er.elmBegin;
 			const auto ptrDFE = ptrDF + er.totalElements();
+			ptrDF += simd::act<real_t>::dsoftsign(ptrDF, er.totalElements(), real_t(1.), real_t(1.));
 			while (ptrDF != ptrDFE) {
 				const auto v = *ptrDF;
 				NNTL_ASSERT(real_t(-1.) <= v && v <= real_t(1.));
@@ -2757,6 +3297,7 @@ namespace math {
 			const auto mult = real_t(1.) / (c*a);
 			auto ptrDF = f_df.data() + er.elmBegin;
 			const auto ptrDFE = ptrDF + er.totalElements();
+			ptrDF += simd::act<real_t>::dsoftsign(ptrDF, er.totalElements(), mult, c);
 			while (ptrDF != ptrDFE) {
 				const auto v = *ptrDF;
 				NNTL_ASSERT(real_t(-c) <= v && v <= c);
@@ -2935,6 +3476,7 @@ namespace math {
 			NNTL_ASSERT(alpha_t_lambda > real_t(0.0));
 			auto pV = srcdest.data() + er.elmBegin;
 			const auto pVE = pV + er.totalElements();
+			pV += simd::act<real_t>::selu(pV, er.totalElements(), alpha_t_lambda, lambda);
 			while (pV != pVE) {
 				const auto v = *pV;
 				/*if (v < real_t(+0.0)) *pV = (::std::exp(v) - real_t(1.0))*alpha;
@@ -2968,6 +3510,7 @@ namespace math {
 			NNTL_ASSERT(!f_df.empty());
 			auto ptrDF = f_df.data() + er.elmBegin;
 			const auto ptrDFE = ptrDF + er.totalElements();
+			ptrDF += simd::act<real_t>::dselu(ptrDF, er.totalElements(), alpha_t_lambda, lambda);
 			while (ptrDF != ptrDFE) {
 				const auto v = *ptrDF;
 				*ptrDF++ = v < real_t(0.) ? (v + alpha_t_lambda) : lambda;
@@ -3073,6 +3616,129 @@ namespace math {
 		}*/
 
 
+		//////////////////////////////////////////////////////////////////////////
+		//////////////////////////////////////////////////////////////////////////
+		// Fused activation derivative and dL/dA multiplication: f_df = df(f_df).*dLdA, i.e. dL/dZ is computed in a single
+		// pass over the data instead of d*() followed by evMul_ip(). The derivative kernel dfunc(f_df, elms_range) is applied
+		// to consecutive chunks of Thresholds_t::dact_mul_chunk elements and every chunk is multiplied by the corresponding
+		// chunk of dLdA right after that, while it is still in L1 cache.
+		// mtThreshold is the st/mt threshold to use (it's usually the threshold of the derivative function)
+		template<typename DfT>
+		void dact_mul(realmtx_t& f_df, const realmtx_t& dLdA, DfT&& dfunc, const numel_cnt_t mtThreshold) noexcept {
+			if (f_df.numel() < mtThreshold) {
+				get_self().dact_mul_st(f_df, dLdA, dfunc);
+			} else get_self().dact_mul_mt(f_df, dLdA, dfunc);
+		}
+		template<typename DfT>
+		void dact_mul_st(realmtx_t& f_df, const realmtx_t& dLdA, DfT&& dfunc, const elms_range*const pER = nullptr) noexcept {
+			get_self()._idact_mul_st(f_df, dLdA, dfunc, pER ? *pER : elms_range(f_df));
+		}
+		template<typename DfT>
+		static void _idact_mul_st(realmtx_t& f_df, const realmtx_t& dLdA, DfT& dfunc, const elms_range& er) noexcept {
+			NNTL_ASSERT(!f_df.empty() && !f_df.emulatesBiases() && !dLdA.emulatesBiases() && f_df.size() == dLdA.size());
+			f_df.assert_storage_does_not_intersect(dLdA);
+			const numel_cnt_t chunk = Thresholds_t::dact_mul_chunk;
+			for (numel_cnt_t b = er.elmBegin; b < er.elmEnd; b += chunk) {
+				const elms_range cer(b, ::std::min(er.elmEnd, b + chunk));
+				dfunc(f_df, cer);
+				_ievMul_ip_st(f_df.data(), dLdA.data(), cer);
+			}
+		}
+		template<typename DfT>
+		void dact_mul_mt(realmtx_t& f_df, const realmtx_t& dLdA, DfT&& dfunc) noexcept {
+			NNTL_ASSERT(!f_df.empty());
+			m_threads.run([&f_df, &dLdA, &dfunc, this](const par_range_t& r) {
+				get_self()._idact_mul_st(f_df, dLdA, dfunc, elms_range(r));
+			}, f_df.numel());
+		}
+
+		//fused versions of activation derivatives. See dact_mul()
+		void dsigm_mul(realmtx_t& f_df, const realmtx_t& dLdA) noexcept {
+			get_self().dact_mul(f_df, dLdA, [this](realmtx_t& F, const elms_range& er) {
+				get_self()._idsigm_st(F, er);
+			}, Thresholds_t::dsigm);
+		}
+		void drelu_mul(realmtx_t& f_df, const realmtx_t& dLdA) noexcept {
+			get_self().dact_mul(f_df, dLdA, [this](realmtx_t& F, const elms_range& er) {
+				get_self()._idrelu_st(F, er);
+			}, Thresholds_t::drelu);
+		}
+		void dleakyrelu_mul(realmtx_t& f_df, const realmtx_t& dLdA, const real_t leak) noexcept {
+			get_self().dact_mul(f_df, dLdA, [this, leak](realmtx_t& F, const elms_range& er) {
+				get_self()._idleakyrelu_st(F, leak, er);
+			}, Thresholds_t::dleakyrelu);
+		}
+		void delu_mul(realmtx_t& f_df, const realmtx_t& dLdA, const real_t alpha) noexcept {
+			get_self().dact_mul(f_df, dLdA, [this, alpha](realmtx_t& F, const elms_range& er) {
+				get_self()._idelu_st(F, alpha, er);
+			}, Thresholds_t::delu);
+		}
+		void delu_unitalpha_mul(realmtx_t& f_df, const realmtx_t& dLdA) noexcept {
+			get_self().dact_mul(f_df, dLdA, [this](realmtx_t& F, const elms_range& er) {
+				get_self()._idelu_unitalpha_st(F, er);
+			}, Thresholds_t::delu_unitalpha);
+		}
+		void delogu_mul(realmtx_t& f_df, const realmtx_t& dLdA, const real_t alpha, const real_t b) noexcept {
+			get_self().dact_mul(f_df, dLdA, [this, alpha, b](realmtx_t& F, const elms_range& er) {
+				get_self()._idelogu_st(F, alpha, b, er);
+			}, Thresholds_t::delogu);
+		}
+		void delogu_ua_mul(realmtx_t& f_df, const realmtx_t& dLdA, const real_t b) noexcept {
+			get_self().dact_mul(f_df, dLdA, [this, b](realmtx_t& F, const elms_range& er) {
+				get_self()._idelogu_ua_st(F, b, er);
+			}, Thresholds_t::delogu_ua);
+		}
+		void delogu_nb_mul(realmtx_t& f_df, const realmtx_t& dLdA, const real_t alpha) noexcept {
+			get_self().dact_mul(f_df, dLdA, [this, alpha](realmtx_t& F, const elms_range& er) {
+				get_self()._idelogu_nb_st(F, alpha, er);
+			}, Thresholds_t::delogu_nb);
+		}
+		void delogu_ua_nb_mul(realmtx_t& f_df, const realmtx_t& dLdA) noexcept {
+			get_self().dact_mul(f_df, dLdA, [this](realmtx_t& F, const elms_range& er) {
+				get_self()._idelogu_ua_nb_st(F, er);
+			}, Thresholds_t::delogu_ua_nb);
+		}
+		void dloglogu_mul(realmtx_t& f_df, const realmtx_t& dLdA, const real_t b_neg, const real_t b_pos) noexcept {
+			get_self().dact_mul(f_df, dLdA, [this, b_neg, b_pos](realmtx_t& F, const elms_range& er) {
+				get_self()._idloglogu_st(F, b_neg, b_pos, er);
+			}, Thresholds_t::dloglogu);
+		}
+		void dloglogu_nbn_mul(realmtx_t& f_df, const realmtx_t& dLdA, const real_t b_pos) noexcept {
+			get_self().dact_mul(f_df, dLdA, [this, b_pos](realmtx_t& F, const elms_range& er) {
+				get_self()._idloglogu_nbn_st(F, b_pos, er);
+			}, Thresholds_t::dloglogu_nbn);
+		}
+		void dloglogu_nbp_mul(realmtx_t& f_df, const realmtx_t& dLdA, const real_t b_neg) noexcept {
+			get_self().dact_mul(f_df, dLdA, [this, b_neg](realmtx_t& F, const elms_range& er) {
+				get_self()._idloglogu_nbp_st(F, b_neg, er);
+			}, Thresholds_t::dloglogu_nbp);
+		}
+		void dloglogu_nbn_nbp_mul(realmtx_t& f_df, const realmtx_t& dLdA) noexcept {
+			get_self().dact_mul(f_df, dLdA, [this](realmtx_t& F, const elms_range& er) {
+				get_self()._idloglogu_nbn_nbp_st(F, er);
+			}, Thresholds_t::dloglogu_nbn_nbp);
+		}
+		void dsoftsign_mul(realmtx_t& f_df, const realmtx_t& dLdA, const real_t a, const real_t c) noexcept {
+			get_self().dact_mul(f_df, dLdA, [this, a, c](realmtx_t& F, const elms_range& er) {
+				get_self()._idsoftsign_st(F, a, c, er);
+			}, Thresholds_t::dsoftsign);
+		}
+		void dsoftsign_ua_uc_mul(realmtx_t& f_df, const realmtx_t& dLdA) noexcept {
+			get_self().dact_mul(f_df, dLdA, [this](realmtx_t& F, const elms_range& er) {
+				get_self()._idsoftsign_ua_uc_st(F, er);
+			}, Thresholds_t::dsoftsign_ua_uc);
+		}
+		void dsoftsigm_mul(realmtx_t& f_df, const realmtx_t& dLdA, const real_t a) noexcept {
+			get_self().dact_mul(f_df, dLdA, [this, a](realmtx_t& F, const elms_range& er) {
+				get_self()._idsoftsigm_st(F, a, er);
+			}, Thresholds_t::dsoftsigm);
+		}
+		void dselu_mul(realmtx_t& f_df, const realmtx_t& dLdA, const real_t alpha_t_lambda, const real_t lambda) noexcept {
+			get_self().dact_mul(f_df, dLdA, [this, alpha_t_lambda, lambda](realmtx_t& F, const elms_range& er) {
+				get_self()._idselu_st(F, alpha_t_lambda, lambda, er);
+			}, Thresholds_t::dselu);
+		}
+
 		//////////////////////////////////////////////////////////////////////////
 		//loss functions
 		//////////////////////////////////////////////////////////////////////////
@@ -3166,9 +3832,20 @@ namespace math {
 		}
 		static real_t _iloss_xentropy_st(const realmtx_t& activations, const realmtx_t& data_y, const elms_range& er)noexcept {
 			NNTL_ASSERT(activations.size() == data_y.size() && !activations.empty() && !data_y.empty());
-			const auto ptrA = activations.data(), ptrY = data_y.data();
+			return _iloss_xentropy_sum_st(activations.data(), data_y.data(), er);
+		}
+		//returns the sum of y*log(a)+(1-y)log(1-a) (i.e. negated and not normalized loss value)
+		static real_t _iloss_xentropy_sum_st(const real_t*const ptrA, const real_t*const ptrY, const elms_range& er)noexcept {
+			NNTL_ASSERT(ptrA && ptrY);
 			real_t ql = 0;
-			for (numel_cnt_t i = er.elmBegin; i < er.elmEnd; ++i) {
+			//the vectorized kernel processes the most of the range, the rest is done here
+#if NNTL_CFG_CAREFULL_LOG_EXP
+			const auto vecCnt = simd::loss<real_t>::xentropy_log1p(ptrA + er.elmBegin, ptrY + er.elmBegin, er.totalElements()
+				, math::real_t_limits<real_t>::log_almost_zero, ql);
+#else
+			const auto vecCnt = simd::loss<real_t>::xentropy(ptrA + er.elmBegin, ptrY + er.elmBegin, er.totalElements(), ql);
+#endif
+			for (numel_cnt_t i = er.elmBegin + vecCnt; i < er.elmEnd; ++i) {
 				const auto y = ptrY[i];
 				const auto a = ptrA[i];
 				NNTL_ASSERT(y == real_t(0.0) || y == real_t(1.0));
@@ -3273,6 +3950,222 @@ namespace math {
 			}, _vec_sum<false, real_t>, activations.numel()) / activations.rows();
 		}
 
+		//////////////////////////////////////////////////////////////////////////
+		// fused dL/dZ and loss computation for the output layer.
+		// Every function overwrites act_dLdZ with dL/dZ exactly as the corresponding dL/dZ function does and returns
+		// the loss value of the activations (the same value as the corresponding loss_*() function returns), so the loss
+		// comes almost for free during the bprop(). Numerically stabilized (_ns) loss versions aren't fused.
+	protected:
+		//the loss part is computed over a block of elements before the block is overwritten with dL/dZ. The block must be
+		//small enough to stay in L1 between the two passes
+		static constexpr numel_cnt_t _FusedLossBlockElms = 2048;
+
+		template<typename LossF, typename dLdZF>
+		static real_t _iloss_dLdZ_blocked_st(const elms_range& er, LossF&& lossF, dLdZF&& dLdZf)noexcept {
+			real_t ql(0.);
+			for (numel_cnt_t b = er.elmBegin; b < er.elmEnd; b += _FusedLossBlockElms) {
+				const elms_range blk(b, ::std::min(b + _FusedLossBlockElms, er.elmEnd));
+				ql += lossF(blk);
+				dLdZf(blk);
+			}
+			return ql;
+		}
+
+	public:
+		//dL/dZ = (a-y)*a*(1-a), L = sum((a-y)^2)/(2*rows)
+		real_t dSigmQuadLoss_dZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ)noexcept {
+			if (act_dLdZ.numel() < Thresholds_t::dSigmQuadLoss_dZ_loss) {
+				return get_self().dSigmQuadLoss_dZ_loss_st(data_y, act_dLdZ);
+			} else return get_self().dSigmQuadLoss_dZ_loss_mt(data_y, act_dLdZ);
+		}
+		real_t dSigmQuadLoss_dZ_loss_st(const realmtx_t& data_y, realmtx_t& act_dLdZ, const elms_range*const pER = nullptr)noexcept {
+			return get_self()._idSigmQuadLoss_dZ_loss_st(data_y, act_dLdZ, pER ? *pER : elms_range(act_dLdZ)) / (2 * act_dLdZ.rows());
+		}
+		//overwrites act_dLdZ with (a-y)*a*(1-a) over er and returns the not normalized sum((a-y)^2) over it
+		static real_t _idSigmQuadLoss_dZ_loss_st(const realmtx_t& data_y, realmtx_t& act_dLdZ, const elms_range& er)noexcept {
+			NNTL_ASSERT(!act_dLdZ.emulatesBiases() && !data_y.emulatesBiases());
+			NNTL_ASSERT(act_dLdZ.size() == data_y.size());
+
+			auto pY = data_y.data() + er.elmBegin;
+			auto pSD = act_dLdZ.data() + er.elmBegin;
+			const auto pSDE = pSD + er.totalElements();
+			real_t ql(0.);
+			while (pSD != pSDE) {
+				const auto a = *pSD;
+				NNTL_ASSERT(real_t(0.) <= a && a <= real_t(1.));
+				const auto e = a - *pY++;
+				ql += e*e;
+				*pSD++ = e*a*(real_t(1.0) - a);
+			}
+			return ql;
+		}
+		real_t dSigmQuadLoss_dZ_loss_mt(const realmtx_t& data_y, realmtx_t& act_dLdZ)noexcept {
+			NNTL_ASSERT(!act_dLdZ.emulatesBiases() && !data_y.emulatesBiases());
+			NNTL_ASSERT(act_dLdZ.size() == data_y.size());
+			return m_threads.reduce([&data_y, &act_dLdZ, this](const par_range_t& r)->real_t {
+				return get_self()._idSigmQuadLoss_dZ_loss_st(data_y, act_dLdZ, elms_range(r));
+			}, _vec_sum<false, real_t>, act_dLdZ.numel()) / (2 * act_dLdZ.rows());
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		//dL/dZ = (a-y), L = sum((a-y)^2)/(2*rows)
+		real_t dIdentityQuadLoss_dZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ)noexcept {
+			if (act_dLdZ.numel() < Thresholds_t::dIdentityQuadLoss_dZ_loss) {
+				return get_self().dIdentityQuadLoss_dZ_loss_st(data_y, act_dLdZ);
+			} else return get_self().dIdentityQuadLoss_dZ_loss_mt(data_y, act_dLdZ);
+		}
+		real_t dIdentityQuadLoss_dZ_loss_st(const realmtx_t& data_y, realmtx_t& act_dLdZ, const elms_range*const pER = nullptr)noexcept {
+			return get_self()._idIdentityQuadLoss_dZ_loss_st(data_y, act_dLdZ, pER ? *pER : elms_range(act_dLdZ)) / (2 * act_dLdZ.rows());
+		}
+		//overwrites act_dLdZ with (a-y) over er and returns the not normalized sum((a-y)^2) over it
+		static real_t _idIdentityQuadLoss_dZ_loss_st(const realmtx_t& data_y, realmtx_t& act_dLdZ, const elms_range& er)noexcept {
+			NNTL_ASSERT(!act_dLdZ.emulatesBiases() && !data_y.emulatesBiases());
+			NNTL_ASSERT(act_dLdZ.size() == data_y.size());
+
+			auto pY = data_y.data() + er.elmBegin;
+			auto pSD = act_dLdZ.data() + er.elmBegin;
+			const auto pSDE = pSD + er.totalElements();
+			real_t ql(0.);
+			while (pSD != pSDE) {
+				const auto e = *pSD - *pY++;
+				ql += e*e;
+				*pSD++ = e;
+			}
+			return ql;
+		}
+		real_t dIdentityQuadLoss_dZ_loss_mt(const realmtx_t& data_y, realmtx_t& act_dLdZ)noexcept {
+			NNTL_ASSERT(!act_dLdZ.emulatesBiases() && !data_y.emulatesBiases());
+			NNTL_ASSERT(act_dLdZ.size() == data_y.size());
+			return m_threads.reduce([&data_y, &act_dLdZ, this](const par_range_t& r)->real_t {
+				return get_self()._idIdentityQuadLoss_dZ_loss_st(data_y, act_dLdZ, elms_range(r));
+			}, _vec_sum<false, real_t>, act_dLdZ.numel()) / (2 * act_dLdZ.rows());
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		//sigmoid + cross entropy: dL/dZ = (a-y), L = sum( -y*log(a)-(1-y)log(1-a) )/rows
+		real_t dSigmXEntropyLoss_dZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ)noexcept {
+			if (act_dLdZ.numel() < Thresholds_t::dSigmXEntropyLoss_dZ_loss) {
+				return get_self().dSigmXEntropyLoss_dZ_loss_st(data_y, act_dLdZ);
+			} else return get_self().dSigmXEntropyLoss_dZ_loss_mt(data_y, act_dLdZ);
+		}
+		real_t dSigmXEntropyLoss_dZ_loss_st(const realmtx_t& data_y, realmtx_t& act_dLdZ, const elms_range*const pER = nullptr)noexcept {
+			return -get_self()._idSigmXEntropyLoss_dZ_loss_st(data_y, act_dLdZ, pER ? *pER : elms_range(act_dLdZ)) / act_dLdZ.rows();
+		}
+		//overwrites act_dLdZ with (a-y) over er and returns the sum of y*log(a)+(1-y)log(1-a) over it (i.e. negated and
+		// not normalized loss value, see _iloss_xentropy_sum_st())
+		static real_t _idSigmXEntropyLoss_dZ_loss_st(const realmtx_t& data_y, realmtx_t& act_dLdZ, const elms_range& er)noexcept {
+			NNTL_ASSERT(!act_dLdZ.emulatesBiases() && !data_y.emulatesBiases());
+			NNTL_ASSERT(act_dLdZ.size() == data_y.size());
+			const auto pA = act_dLdZ.data();
+			const auto pY = data_y.data();
+			return _iloss_dLdZ_blocked_st(er, [pA, pY](const elms_range& blk)->real_t {
+				return _iloss_xentropy_sum_st(pA, pY, blk);
+			}, [pA, pY](const elms_range& blk) {
+				_ievSub_ip_st(pA, pY, blk);
+			});
+		}
+		real_t dSigmXEntropyLoss_dZ_loss_mt(const realmtx_t& data_y, realmtx_t& act_dLdZ)noexcept {
+			NNTL_ASSERT(!act_dLdZ.emulatesBiases() && !data_y.emulatesBiases());
+			NNTL_ASSERT(act_dLdZ.size() == data_y.size());
+			return -m_threads.reduce([&data_y, &act_dLdZ, this](const par_range_t& r)->real_t {
+				return get_self()._idSigmXEntropyLoss_dZ_loss_st(data_y, act_dLdZ, elms_range(r));
+			}, _vec_sum<false, real_t>, act_dLdZ.numel()) / act_dLdZ.rows();
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		//identity + cross entropy: dL/dZ = (a-y)/(a*(1-a)), L = sum( -y*log(a)-(1-y)log(1-a) )/rows
+		real_t dIdentityXEntropyLoss_dZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ)noexcept {
+			if (act_dLdZ.numel() < Thresholds_t::dIdentityXEntropyLoss_dZ_loss) {
+				return get_self().dIdentityXEntropyLoss_dZ_loss_st(data_y, act_dLdZ);
+			} else return get_self().dIdentityXEntropyLoss_dZ_loss_mt(data_y, act_dLdZ);
+		}
+		real_t dIdentityXEntropyLoss_dZ_loss_st(const realmtx_t& data_y, realmtx_t& act_dLdZ, const elms_range*const pER = nullptr)noexcept {
+			return -get_self()._idIdentityXEntropyLoss_dZ_loss_st(data_y, act_dLdZ, pER ? *pER : elms_range(act_dLdZ)) / act_dLdZ.rows();
+		}
+		//overwrites act_dLdZ with (a-y)/(a*(1-a)) over er and returns the sum of y*log(a)+(1-y)log(1-a) over it (i.e. negated
+		// and not normalized loss value, see _iloss_xentropy_sum_st())
+		static real_t _idIdentityXEntropyLoss_dZ_loss_st(const realmtx_t& data_y, realmtx_t& act_dLdZ, const elms_range& er)noexcept {
+			NNTL_ASSERT(!act_dLdZ.emulatesBiases() && !data_y.emulatesBiases());
+			NNTL_ASSERT(act_dLdZ.size() == data_y.size());
+			const auto pA = act_dLdZ.data();
+			const auto pY = data_y.data();
+			return _iloss_dLdZ_blocked_st(er, [pA, pY](const elms_range& blk)->real_t {
+				return _iloss_xentropy_sum_st(pA, pY, blk);
+			}, [&data_y, &act_dLdZ](const elms_range& blk) {
+				_idIdentityXEntropyLoss_dZ_st(data_y, act_dLdZ, blk);
+			});
+		}
+		real_t dIdentityXEntropyLoss_dZ_loss_mt(const realmtx_t& data_y, realmtx_t& act_dLdZ)noexcept {
+			NNTL_ASSERT(!act_dLdZ.emulatesBiases() && !data_y.emulatesBiases());
+			NNTL_ASSERT(act_dLdZ.size() == data_y.size());
+			return -m_threads.reduce([&data_y, &act_dLdZ, this](const par_range_t& r)->real_t {
+				return get_self()._idIdentityXEntropyLoss_dZ_loss_st(data_y, act_dLdZ, elms_range(r));
+			}, _vec_sum<false, real_t>, act_dLdZ.numel()) / act_dLdZ.rows();
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		//softsigm + cross entropy: dL/dZ = (a-y)/(a*(1-a)) * dSoftSigm/dZ, L = sum( -y*log(a)-(1-y)log(1-a) )/rows
+		real_t dSoftSigmXEntropyLoss_dZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ, const real_t& a)noexcept {
+			if (act_dLdZ.numel() < Thresholds_t::dSoftSigmXEntropyLoss_dZ_loss) {
+				return get_self().dSoftSigmXEntropyLoss_dZ_loss_st(data_y, act_dLdZ, a);
+			} else return get_self().dSoftSigmXEntropyLoss_dZ_loss_mt(data_y, act_dLdZ, a);
+		}
+		real_t dSoftSigmXEntropyLoss_dZ_loss_st(const realmtx_t& data_y, realmtx_t& act_dLdZ, const real_t& a, const elms_range*const pER = nullptr)noexcept {
+			return -get_self()._idSoftSigmXEntropyLoss_dZ_loss_st(data_y, act_dLdZ, a, pER ? *pER : elms_range(act_dLdZ)) / act_dLdZ.rows();
+		}
+		//overwrites act_dLdZ with dL/dZ of softsigm over er (see _idSoftSigmXEntropyLoss_dZ_st()) and returns the sum of
+		// y*log(a)+(1-y)log(1-a) over it (i.e. negated and not normalized loss value, see _iloss_xentropy_sum_st())
+		static real_t _idSoftSigmXEntropyLoss_dZ_loss_st(const realmtx_t& data_y, realmtx_t& act_dLdZ, const real_t a, const elms_range& er)noexcept {
+			NNTL_ASSERT(!act_dLdZ.emulatesBiases() && !data_y.emulatesBiases());
+			NNTL_ASSERT(act_dLdZ.size() == data_y.size());
+			const auto pA = act_dLdZ.data();
+			const auto pY = data_y.data();
+			return _iloss_dLdZ_blocked_st(er, [pA, pY](const elms_range& blk)->real_t {
+				return _iloss_xentropy_sum_st(pA, pY, blk);
+			}, [&data_y, &act_dLdZ, a](const elms_range& blk) {
+				_idSoftSigmXEntropyLoss_dZ_st(data_y, act_dLdZ, a, blk);
+			});
+		}
+		real_t dSoftSigmXEntropyLoss_dZ_loss_mt(const realmtx_t& data_y, realmtx_t& act_dLdZ, const real_t& a)noexcept {
+			NNTL_ASSERT(!act_dLdZ.emulatesBiases() && !data_y.emulatesBiases());
+			NNTL_ASSERT(act_dLdZ.size() == data_y.size());
+			NNTL_ASSERT(a > real_t(0.0));
+			return -m_threads.reduce([&data_y, &act_dLdZ, &a, this](const par_range_t& r)->real_t {
+				return get_self()._idSoftSigmXEntropyLoss_dZ_loss_st(data_y, act_dLdZ, a, elms_range(r));
+			}, _vec_sum<false, real_t>, act_dLdZ.numel()) / act_dLdZ.rows();
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		//softmax + cross entropy: dL/dZ = (a-y), L = sum( -y*log(a) )/rows
+		real_t dSoftmaxXEntropyLoss_dZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ)noexcept {
+			if (act_dLdZ.numel() < Thresholds_t::dSoftmaxXEntropyLoss_dZ_loss) {
+				return get_self().dSoftmaxXEntropyLoss_dZ_loss_st(data_y, act_dLdZ);
+			} else return get_self().dSoftmaxXEntropyLoss_dZ_loss_mt(data_y, act_dLdZ);
+		}
+		real_t dSoftmaxXEntropyLoss_dZ_loss_st(const realmtx_t& data_y, realmtx_t& act_dLdZ, const elms_range*const pER = nullptr)noexcept {
+			return get_self()._idSoftmaxXEntropyLoss_dZ_loss_st(data_y, act_dLdZ, pER ? *pER : elms_range(act_dLdZ)) / act_dLdZ.rows();
+		}
+		//overwrites act_dLdZ with (a-y) over er and returns the not normalized loss value over it
+		// (see _iloss_softmax_xentropy_sum_st())
+		static real_t _idSoftmaxXEntropyLoss_dZ_loss_st(const realmtx_t& data_y, realmtx_t& act_dLdZ, const elms_range& er)noexcept {
+			NNTL_ASSERT(!act_dLdZ.emulatesBiases() && !data_y.emulatesBiases());
+			NNTL_ASSERT(act_dLdZ.size() == data_y.size());
+			const auto pA = act_dLdZ.data();
+			const auto pY = data_y.data();
+			return _iloss_dLdZ_blocked_st(er, [pA, pY](const elms_range& blk)->real_t {
+				return _iloss_softmax_xentropy_sum_st(pA, pY, blk);
+			}, [pA, pY](const elms_range& blk) {
+				_ievSub_ip_st(pA, pY, blk);
+			});
+		}
+		real_t dSoftmaxXEntropyLoss_dZ_loss_mt(const realmtx_t& data_y, realmtx_t& act_dLdZ)noexcept {
+			NNTL_ASSERT(!act_dLdZ.emulatesBiases() && !data_y.emulatesBiases());
+			NNTL_ASSERT(act_dLdZ.size() == data_y.size());
+			return m_threads.reduce([&data_y, &act_dLdZ, this](const par_range_t& r)->real_t {
+				return get_self()._idSoftmaxXEntropyLoss_dZ_loss_st(data_y, act_dLdZ, elms_range(r));
+			}, _vec_sum<false, real_t>, act_dLdZ.numel()) / act_dLdZ.rows();
+		}
+
 
 		//////////////////////////////////////////////////////////////////////////
 		//gradient application procedures
@@ -3716,6 +4609,154 @@ namespace math {
 
 
 
+		//////////////////////////////////////////////////////////////////////////
+		//////////////////////////////////////////////////////////////////////////
+		// Single-pass weights update. Fuses the optimizer (OptT is one of fused_update::opt_* functors), ILR, momentum,
+		// the W-=dW and the max-norm row norm computation into one sweep over W. The max-norm rescaling itself is done by
+		// the separate mrwMulByVec() call and only if any row violates the constraint.
+		// dLdW is read only. Produces the same result (up to a floating point rounding) as the sequence of
+		// optimizer function, apply_ILR(), apply_momentum(), evSub_ip() (or evAdd_ip()) and mCheck_normalize_rows()
+		// that _grad_works::apply_grad() does.
+		template<typename OptT>
+		void apply_grad_fused(realmtxdef_t& W, const realmtx_t& dLdW, const OptT& opt, const fused_update::params<real_t>& u)noexcept {
+			NNTL_ASSERT(!W.empty() && W.size() == dLdW.size());
+			NNTL_ASSERT(!u.pILRGain || u.pILRPrev);
+			NNTL_ASSERT(u.momType == fused_update::mom_none || u.pVw);
+			if (u.pILRGain) {
+				if (u.pILRStore) {
+					get_self()._apply_grad_fused_mom<OptT, true, true>(W, dLdW, opt, u);
+				} else get_self()._apply_grad_fused_mom<OptT, true, false>(W, dLdW, opt, u);
+			} else {
+				if (u.pILRStore) {
+					get_self()._apply_grad_fused_mom<OptT, false, true>(W, dLdW, opt, u);
+				} else get_self()._apply_grad_fused_mom<OptT, false, false>(W, dLdW, opt, u);
+			}
+		}
+		template<typename OptT, bool bILR, bool bILRStore>
+		void _apply_grad_fused_mom(realmtxdef_t& W, const realmtx_t& dLdW, const OptT& opt, const fused_update::params<real_t>& u)noexcept {
+			switch (u.momType) {
+			case fused_update::mom_none:
+				get_self()._apply_grad_fused<OptT, bILR, bILRStore, fused_update::mom_none>(W, dLdW, opt, u);
+				break;
+			case fused_update::mom_classical:
+				get_self()._apply_grad_fused<OptT, bILR, bILRStore, fused_update::mom_classical>(W, dLdW, opt, u);
+				break;
+			case fused_update::mom_nesterov:
+				get_self()._apply_grad_fused<OptT, bILR, bILRStore, fused_update::mom_nesterov>(W, dLdW, opt, u);
+				break;
+			default:
+				NNTL_ASSERT(!"WTF? Unknown momentum type");
+				abort();
+			}
+		}
+
+		//updates a single weight and returns its new value
+		template<typename OptT, bool bILR, bool bILRStore, fused_update::MomentumType MomT>
+		static nntl_force_inline real_t _apply_grad_fused_elm(real_t*const pW, const real_t*const pdW, const OptT& opt
+			, const fused_update::params<real_t>& u, const numel_cnt_t i)noexcept
+		{
+			real_t d = opt(pdW[i], i);
+			if (bILR) {
+				const real_t cond = u.pILRPrev[i] * d;
+				auto g = u.pILRGain[i];
+				const auto bUp = (cond > real_t(+0.0))&(g < u.ILRcapHigh)
+					, bDown = (cond < real_t(-0.0)) & (g > u.ILRcapLow);
+				g *= (!(bUp | bDown))*real_t(1.) + bUp*u.ILRincr + bDown*u.ILRdecr;
+				u.pILRGain[i] = g;
+				d *= g;
+			}
+			if (bILRStore) u.pILRStore[i] = d;
+			if (fused_update::mom_classical == MomT) {
+				d += u.momentum*u.pVw[i];
+				u.pVw[i] = d;
+			} else if (fused_update::mom_nesterov == MomT) {
+				u.pVw[i] += d;
+			}
+			const auto w = pW[i] - d;
+			pW[i] = w;
+			return w;
+		}
+		template<typename OptT, bool bILR, bool bILRStore, fused_update::MomentumType MomT>
+		static void _iapply_grad_fused_st(real_t*const pW, const real_t*const pdW, const OptT& opt
+			, const fused_update::params<real_t>& u, const elms_range& er)noexcept
+		{
+			for (numel_cnt_t i = er.elmBegin; i < er.elmEnd; ++i) {
+				_apply_grad_fused_elm<OptT, bILR, bILRStore, MomT>(pW, pdW, opt, u, i);
+			}
+		}
+		//same as above, but also accumulates squared row norms of columns [RCR.colBegin, min(RCR.colEnd, normCols)) into pNorms
+		template<typename OptT, bool bILR, bool bILRStore, fused_update::MomentumType MomT>
+		static void _iapply_grad_fused_norms_st(real_t*const pW, const real_t*const pdW, const OptT& opt
+			, const fused_update::params<real_t>& u, const vec_len_t mRows, const vec_len_t normCols
+			, const rowcol_range& RCR, real_t*const pNorms)noexcept
+		{
+			NNTL_ASSERT(0 == RCR.rowBegin && mRows == RCR.rowEnd);
+			memset(pNorms, 0, sizeof(*pNorms)*mRows);
+			for (vec_len_t c = RCR.colBegin; c < RCR.colEnd; ++c) {
+				const auto ofs = realmtx_t::sNumel(mRows, c);
+				if (c < normCols) {
+					for (vec_len_t r = 0; r < mRows; ++r) {
+						const auto w = _apply_grad_fused_elm<OptT, bILR, bILRStore, MomT>(pW, pdW, opt, u, ofs + r);
+						pNorms[r] += w*w;
+					}
+				} else {
+					for (vec_len_t r = 0; r < mRows; ++r) {
+						_apply_grad_fused_elm<OptT, bILR, bILRStore, MomT>(pW, pdW, opt, u, ofs + r);
+					}
+				}
+			}
+		}
+		template<typename OptT, bool bILR, bool bILRStore, fused_update::MomentumType MomT>
+		void _apply_grad_fused(realmtxdef_t& W, const realmtx_t& dLdW, const OptT& opt, const fused_update::params<real_t>& u)noexcept {
+			const auto pW = W.data();
+			const auto pdW = dLdW.data();
+			const auto dataCnt = W.numel();
+
+			if (u.maxNormSquared <= real_t(0)) {
+				if (dataCnt < Thresholds_t::apply_grad_fused) {
+					_iapply_grad_fused_st<OptT, bILR, bILRStore, MomT>(pW, pdW, opt, u, elms_range(0, dataCnt));
+				} else {
+					m_threads.run([pW, pdW, &opt, &u](const par_range_t& r) {
+						_iapply_grad_fused_st<OptT, bILR, bILRStore, MomT>(pW, pdW, opt, u, elms_range(r));
+					}, dataCnt);
+				}
+				return;
+			}
+
+			//max-norm requires row norms, therefore processing columnwise
+			const auto mRows = W.rows(), mCols = W.cols();
+			const vec_len_t normCols = u.bNormIncludesBias ? mCols : mCols - 1;
+			const auto tmemSize = realmtx_t::sNumel(mRows, m_threads.workers_count());
+			const auto pTmpStor = get_self()._istor_alloc(tmemSize);
+
+			if (dataCnt < Thresholds_t::apply_grad_fused || mCols <= Thresholds_t::mrwL2NormSquared_mt_cw_ColsPerThread) {
+				_iapply_grad_fused_norms_st<OptT, bILR, bILRStore, MomT>(pW, pdW, opt, u, mRows, normCols, rowcol_range(W), pTmpStor);
+			} else {
+				_processMtx_cw(W, Thresholds_t::mrwL2NormSquared_mt_cw_ColsPerThread
+					, [pW, pdW, &opt, &u, mRows, normCols](const rowcol_range& RCR, real_t*const pVec)noexcept
+				{
+					_iapply_grad_fused_norms_st<OptT, bILR, bILRStore, MomT>(pW, pdW, opt, u, mRows, normCols, RCR, pVec);
+				},
+					[this](realmtx_t& fin)noexcept
+				{
+					get_self().mrwSum_ip(fin);
+				}, pTmpStor);
+			}
+
+			// calc scaling coefficients
+			const auto maxNormSquared = u.maxNormSquared;
+			bool bNeedRenorm = false;
+			for (vec_len_t r = 0; r < mRows; ++r) {
+				const auto rowNorm = pTmpStor[r];
+				const bool bViolates = rowNorm > maxNormSquared;
+				bNeedRenorm |= bViolates;
+				pTmpStor[r] = bViolates ? ::std::sqrt(maxNormSquared / rowNorm) : real_t(1.0);
+			}
+			if (bNeedRenorm) get_self().mrwMulByVec(W, pTmpStor);
+			get_self()._istor_free(pTmpStor, tmemSize);
+		}
+
+
 		//////////////////////////////////////////////////////////////////////////
 		//////////////////////////////////////////////////////////////////////////
 		// loss addendum functions
@@ -3851,11 +4892,14 @@ namespace math {
 
 	};
 
-	template <typename RealT, typename iThreadsT, typename ThresholdsT = _impl::MATHN_THR<RealT>>
-	class MathN final : public _MathN<RealT, iThreadsT, ThresholdsT, MathN<RealT, iThreadsT, ThresholdsT>> {
+	//use bindingBlasT = b_Native<iThreadsT> to run matrix multiplications on the iThreadsT pool instead of OpenBLAS threads
+	template <typename RealT, typename iThreadsT, typename ThresholdsT = _impl::MATHN_THR<RealT>, typename bindingBlasT = b_OpenBLAS>
+	class MathN final : public _MathN<RealT, iThreadsT, ThresholdsT, MathN<RealT, iThreadsT, ThresholdsT, bindingBlasT>, bindingBlasT> {
 	public:
 		~MathN()noexcept {}
-		MathN()noexcept : _MathN<RealT, iThreadsT, ThresholdsT, MathN<RealT, iThreadsT, ThresholdsT>>() {}
+		MathN()noexcept : _MathN<RealT, iThreadsT, ThresholdsT, MathN<RealT, iThreadsT, ThresholdsT, bindingBlasT>, bindingBlasT>() {}
+		explicit MathN(const thread_id_t nThreads)noexcept
+			: _MathN<RealT, iThreadsT, ThresholdsT, MathN<RealT, iThreadsT, ThresholdsT, bindingBlasT>, bindingBlasT>(nThreads) {}
 	};
 
 }
@@ -51,6 +51,7 @@ namespace math {
 
 		~MathN_mt()noexcept {};
 		MathN_mt() noexcept : base_class_t(){}
+		explicit MathN_mt(const thread_id_t nThreads) noexcept : base_class_t(nThreads) {}
 
 		//////////////////////////////////////////////////////////////////////////
 		// i_math interface implementation
@@ -417,6 +418,25 @@ namespace math {
 			return loss_softmax_xentropy_mt(activations, data_y);
 		}
 
+		real_t dSigmQuadLoss_dZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ)noexcept {
+			return dSigmQuadLoss_dZ_loss_mt(data_y, act_dLdZ);
+		}
+		real_t dIdentityQuadLoss_dZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ)noexcept {
+			return dIdentityQuadLoss_dZ_loss_mt(data_y, act_dLdZ);
+		}
+		real_t dSigmXEntropyLoss_dZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ)noexcept {
+			return dSigmXEntropyLoss_dZ_loss_mt(data_y, act_dLdZ);
+		}
+		real_t dIdentityXEntropyLoss_dZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ)noexcept {
+			return dIdentityXEntropyLoss_dZ_loss_mt(data_y, act_dLdZ);
+		}
+		real_t dSoftSigmXEntropyLoss_dZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ, const real_t& a)noexcept {
+			return dSoftSigmXEntropyLoss_dZ_loss_mt(data_y, act_dLdZ, a);
+		}
+		real_t dSoftmaxXEntropyLoss_dZ_loss(const realmtx_t& data_y, realmtx_t& act_dLdZ)noexcept {
+			return dSoftmaxXEntropyLoss_dZ_loss_mt(data_y, act_dLdZ);
+		}
+
 		//////////////////////////////////////////////////////////////////////////
 		//gradient application procedures
 		void RMSProp_Hinton(realmtx_t& dW, realmtx_t& rmsF, const real_t learningRate,
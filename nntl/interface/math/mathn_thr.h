@@ -49,10 +49,29 @@ namespace _impl {
 	//It is better, than nothing. But in future this pron should be substituted by a run-time function profiling over real-task data
 
 	template <> struct MATHN_THR<double> : public SMATH_THR<double> {
+		//C panel size (in elements) for mMulABt_Cnb_ep(). The panel should fit into L2 together with the corresponding part of B
+		static constexpr size_t mMulABt_Cnb_ep_panel = 16384;
+		//minimum columns count in a panel (too narrow panels make gemm() inefficient)
+		static constexpr size_t mMulABt_Cnb_ep_minCols = 8;
+		//mMulABt_Cnb_small() bounds: max rows of A and max total count of multiply-adds. Such small products are computed
+		// by a single thread with pre-packed weights, bigger ones are better handled by the multithreaded gemm
+		static constexpr size_t mMulABt_Cnb_small_maxRows = 16;
+		static constexpr size_t mMulABt_Cnb_small_maxMACs = 4000000;//nt
+		//mMulABt_Cnb_q8(): count of multiply-adds to run multithreaded, C panel size (in elements) and minimum columns in a panel
+		static constexpr size_t mMulABt_Cnb_q8_mt = 1000000;//nt
+		static constexpr size_t mMulABt_Cnb_q8_panel = 16384;//nt
+		static constexpr size_t mMulABt_Cnb_q8_minCols = 8;//nt
+		//chunk size (in elements) for fused activation derivative kernels d*_mul(). The chunk of f_df and dLdA must fit into L1
+		static constexpr size_t dact_mul_chunk = 2048;
+
 		static constexpr size_t ewBinarize_ip = 132000;
 		static constexpr size_t ewBinarize = 11000;
 
 		static constexpr size_t mExtractRows = 8000000/2;//nt
+		//sparse (smatrix_csr) variants. The work is estimated by the count of nonzero elements touched (times neurons)
+		static constexpr size_t mExtractRows_csr = 20000;//nt
+		static constexpr size_t mMulABt_Cnb_csr = 100000;//nt
+		static constexpr size_t mScaledMulAtB_C_csr = 100000;//nt
 
 		static constexpr size_t mrwL2NormSquared = 124000;
 		static constexpr vec_len_t mrwL2NormSquared_mt_cw_ColsPerThread = 3;
@@ -61,6 +80,9 @@ namespace _impl {
 		static constexpr size_t evClamp = 9000;
 		static constexpr size_t make_dropout = 7000;
 		static constexpr size_t make_alphaDropout = 5000;
+		static constexpr size_t make_dropout_packed = 10000;//nt
+		static constexpr size_t make_alphaDropout_packed = 8000;//nt
+		static constexpr size_t evMulByBitMask_ip = 30000;//nt
 
 		static constexpr size_t apply_ILR_st_vec = 2620/2;
 		static constexpr size_t apply_ILR_mt = 9000/2;
@@ -156,6 +178,14 @@ namespace _impl {
 		static constexpr size_t loss_xentropy_ns = 1000;
 		static constexpr size_t loss_softmax_xentropy = 1100;
 
+		//fused dL/dZ + loss
+		static constexpr size_t dSigmQuadLoss_dZ_loss = 14000;//nt
+		static constexpr size_t dIdentityQuadLoss_dZ_loss = 16000;//nt
+		static constexpr size_t dSigmXEntropyLoss_dZ_loss = 1000;//nt
+		static constexpr size_t dIdentityXEntropyLoss_dZ_loss = 1000;//nt
+		static constexpr size_t dSoftSigmXEntropyLoss_dZ_loss = 1000;//nt
+		static constexpr size_t dSoftmaxXEntropyLoss_dZ_loss = 1100;//nt
+
 		static constexpr size_t RMSProp_Hinton = 2940;
 		static constexpr size_t RMSProp_Graves = 2970;
 		static constexpr size_t RProp = 5220;
@@ -165,6 +195,8 @@ namespace _impl {
 
 		static constexpr size_t RNadam = 3000;
 
+		static constexpr size_t apply_grad_fused = 3000;//nt
+
 		//////////////////////////////////////////////////////////////////////////
 		template<typename WlT> struct dLoss_dZ {};
 		template<> struct dLoss_dZ<activation::tag_Linear_Loss_quadWeighted_FP> { static constexpr size_t thr = 10000; };
@@ -175,10 +207,29 @@ namespace _impl {
 	};
 
 	template <> struct MATHN_THR<float> : public SMATH_THR<float> {
+		//C panel size (in elements) for mMulABt_Cnb_ep(). The panel should fit into L2 together with the corresponding part of B
+		static constexpr size_t mMulABt_Cnb_ep_panel = 32768;
+		//minimum columns count in a panel (too narrow panels make gemm() inefficient)
+		static constexpr size_t mMulABt_Cnb_ep_minCols = 8;
+		//mMulABt_Cnb_small() bounds: max rows of A and max total count of multiply-adds. Such small products are computed
+		// by a single thread with pre-packed weights, bigger ones are better handled by the multithreaded gemm
+		static constexpr size_t mMulABt_Cnb_small_maxRows = 16;
+		static constexpr size_t mMulABt_Cnb_small_maxMACs = 8000000;//nt
+		//mMulABt_Cnb_q8(): count of multiply-adds to run multithreaded, C panel size (in elements) and minimum columns in a panel
+		static constexpr size_t mMulABt_Cnb_q8_mt = 1500000;//nt
+		static constexpr size_t mMulABt_Cnb_q8_panel = 16384;//nt
+		static constexpr size_t mMulABt_Cnb_q8_minCols = 8;//nt
+		//chunk size (in elements) for fused activation derivative kernels d*_mul(). The chunk of f_df and dLdA must fit into L1
+		static constexpr size_t dact_mul_chunk = 4096;
+
 		static constexpr size_t ewBinarize_ip = 13000;
 		static constexpr size_t ewBinarize = 9200;
 
 		static constexpr size_t mExtractRows = 800000;
+		//sparse (smatrix_csr) variants. The work is estimated by the count of nonzero elements touched (times neurons)
+		static constexpr size_t mExtractRows_csr = 40000;//nt
+		static constexpr size_t mMulABt_Cnb_csr = 200000;//nt
+		static constexpr size_t mScaledMulAtB_C_csr = 200000;//nt
 
 		static constexpr size_t mrwL2NormSquared = 250000;
 		static constexpr vec_len_t mrwL2NormSquared_mt_cw_ColsPerThread = 3;
@@ -187,6 +238,9 @@ namespace _impl {
 		static constexpr size_t evClamp = 14000;
 		static constexpr size_t make_dropout = 7500;//* for 0.5
 		static constexpr size_t make_alphaDropout = 7500;//* for 0.9
+		static constexpr size_t make_dropout_packed = 12000;//nt
+		static constexpr size_t make_alphaDropout_packed = 12000;//nt
+		static constexpr size_t evMulByBitMask_ip = 12000;//nt
 
 		static constexpr size_t apply_ILR_st_vec = 2620; //*
 		static constexpr size_t apply_ILR_mt = 9000; //*
@@ -282,6 +336,14 @@ namespace _impl {
 		static constexpr size_t loss_xentropy_ns = 850;//750;
 		static constexpr size_t loss_softmax_xentropy = 1100;
 
+		//fused dL/dZ + loss
+		static constexpr size_t dSigmQuadLoss_dZ_loss = 9000;//nt
+		static constexpr size_t dIdentityQuadLoss_dZ_loss = 11000;//nt
+		static constexpr size_t dSigmXEntropyLoss_dZ_loss = 850;//nt
+		static constexpr size_t dIdentityXEntropyLoss_dZ_loss = 850;//nt
+		static constexpr size_t dSoftSigmXEntropyLoss_dZ_loss = 850;//nt
+		static constexpr size_t dSoftmaxXEntropyLoss_dZ_loss = 1100;//nt
+
 		static constexpr size_t RMSProp_Hinton = 8100;
 		static constexpr size_t RMSProp_Graves = 8000;
 		static constexpr size_t RProp = 12000;
@@ -291,6 +353,8 @@ namespace _impl {
 
 		static constexpr size_t RNadam = 7400;
 
+		static constexpr size_t apply_grad_fused = 7300;//nt
+
 		//////////////////////////////////////////////////////////////////////////
 		template<typename WlT> struct dLoss_dZ {};
 		template<> struct dLoss_dZ<activation::tag_Linear_Loss_quadWeighted_FP> { static constexpr size_t thr = 8100; };//*
@@ -0,0 +1,124 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+//This file defines run-time adjustable single/multi-threading code thresholds for MathN class.
+//Default values are taken from MATHN_THR<> and may be replaced by values obtained by a run-time profiling
+// (see mt_dispatcher/profiler.h and mt_dispatcher/mt_dispatcher.h)
+// Use it as MathN<real_t, iThreads_t, _impl::MATHN_THR_RT<real_t>>
+
+#include <cstring>
+#include "mathn_thr.h"
+
+//list of thresholds that could be adjusted in run-time. Every threshold here MUST be a size_t value that exists in
+// MATHN_THR<real_t> (or in its SMATH_THR<real_t> base) and that only selects a code path or a block size of a kernel.
+// Thresholds that define a size of a temporary storage (ColsPerThread and so on) MUST remain constexpr, because
+// the temporary storage is requested before any profile could be loaded.
+#define NNTL_MATHN_THR_RT_LIST(_) \
+	_(ewSumProd) _(ewSumSquares) _(ewSumSquares_ns) \
+	_(mrwDivideByVec) _(mrwDivideByVec_rw) _(mrwDivideByVec_mt_rows) \
+	_(mrwMulByVec) _(mrwMulByVec_st_rows) _(mrwMulByVec_mt_rows) \
+	_(mrwIdxsOfMax) _(mrwIdxsOfMax_st_rows) _(mrwIdxsOfMax_mt_rows) \
+	_(mrwMax) _(mrwSum_ip_st_cols) _(mrwSum_ip_st_rows) _(mrwSum) _(mrwSum_st) _(mrwBinaryOR) \
+	_(mcwSub_ip) _(mcwMulDiag_ip) _(mTilingRoll) _(mTilingUnroll) \
+	_(mMulABt_Cnb_ep_minCols) _(mMulABt_Cnb_ep_panel) _(mMulABt_Cnb_small_maxRows) _(mMulABt_Cnb_small_maxMACs) \
+	_(mMulABt_Cnb_q8_minCols) _(mMulABt_Cnb_q8_mt) _(mMulABt_Cnb_q8_panel) \
+	_(mMulABt_Cnb_csr) _(mScaledMulAtB_C_csr) \
+	_(ewBinarize_ip) _(ewBinarize) _(mExtractRows) _(mExtractRows_csr) _(mrwL2NormSquared) _(mCheck_normalize_rows) \
+	_(make_dropout) _(make_alphaDropout) _(make_dropout_packed) _(make_alphaDropout_packed) _(evMulByBitMask_ip) \
+	_(apply_ILR_st_vec) _(apply_ILR_mt) _(apply_ILR_mt_vec) _(apply_ILR_mt_vec2) \
+	_(evClamp) _(apply_momentum) _(evMulC_ip) _(evMulC_ip_Anb) _(evMul_ip) _(evAdd_ip) _(evAddScaled_ip) \
+	_(evNZAddScaled_ip) _(evAddScaledSign_ip) _(evNZAddScaledSign_ip) _(evSign) _(evSub_ip) _(evSub) \
+	_(evMulC_ip_Sub_ip) _(evSubMtxMulC_ip_nb) _(evSquare) _(evAbs) _(vSumAbs) \
+	_(sigm) _(dsigm) _(dSigmQuadLoss_dZ) _(dIdentityXEntropyLoss_dZ) \
+	_(relu) _(drelu) _(leakyrelu) _(dleakyrelu) \
+	_(elu) _(delu) _(elu_unitalpha) _(delu_unitalpha) \
+	_(elogu) _(delogu) _(elogu_ua) _(delogu_ua) _(elogu_nb) _(delogu_nb) _(elogu_ua_nb) _(delogu_ua_nb) \
+	_(loglogu) _(dloglogu) _(loglogu_nbn) _(dloglogu_nbn) _(loglogu_nbp) _(dloglogu_nbp) \
+	_(loglogu_nbn_nbp) _(dloglogu_nbn_nbp) \
+	_(softsign) _(softsign_uc) _(dsoftsign) _(dsoftsign_ua_uc) _(softsigm) _(dsoftsigm) \
+	_(dSoftSigmQuadLoss_dZ) _(dSoftSigmXEntropyLoss_dZ) \
+	_(selu) _(dselu) _(step) \
+	_(softmax_parts) _(softmax_parts_mt_rows) _(softmax) \
+	_(loss_quadratic) _(loss_quadratic_ns) _(loss_xentropy) _(loss_xentropy_ns) _(loss_softmax_xentropy) \
+	_(dSigmQuadLoss_dZ_loss) _(dIdentityQuadLoss_dZ_loss) _(dSigmXEntropyLoss_dZ_loss) \
+	_(dIdentityXEntropyLoss_dZ_loss) _(dSoftSigmXEntropyLoss_dZ_loss) _(dSoftmaxXEntropyLoss_dZ_loss) \
+	_(dact_mul_chunk) \
+	_(RMSProp_Hinton) _(RMSProp_Graves) _(RProp) _(ModProp) _(Adam) _(AdaMax) _(RNadam) _(apply_grad_fused)
+
+namespace nntl {
+namespace math {
+
+namespace _impl {
+
+	template <typename RealT>
+	struct MATHN_THR_RT : public MATHN_THR<RealT> {
+		typedef MATHN_THR<RealT> defaults_t;
+
+#define _NNTL_THR_RT_DECLARE(n) static size_t n;
+		NNTL_MATHN_THR_RT_LIST(_NNTL_THR_RT_DECLARE)
+#undef _NNTL_THR_RT_DECLARE
+
+		//restores default (compile-time) values
+		static void reset()noexcept {
+#define _NNTL_THR_RT_RESET(n) n = defaults_t::n;
+			NNTL_MATHN_THR_RT_LIST(_NNTL_THR_RT_RESET)
+#undef _NNTL_THR_RT_RESET
+		}
+
+		//returns a pointer to the threshold variable by its name or nullptr if there's no such threshold
+		static size_t* find(const char*const pName)noexcept {
+			NNTL_ASSERT(pName);
+#define _NNTL_THR_RT_FIND(n) if (0 == ::std::strcmp(pName, #n)) return &n;
+			NNTL_MATHN_THR_RT_LIST(_NNTL_THR_RT_FIND)
+#undef _NNTL_THR_RT_FIND
+			return nullptr;
+		}
+
+		//F is called as F(const char* name, size_t& value) for every run-time threshold
+		template<typename F>
+		static void for_each(F&& f)noexcept {
+#define _NNTL_THR_RT_FOREACH(n) f(#n, n);
+			NNTL_MATHN_THR_RT_LIST(_NNTL_THR_RT_FOREACH)
+#undef _NNTL_THR_RT_FOREACH
+		}
+	};
+
+#define _NNTL_THR_RT_DEFINE(n) template <typename RealT> size_t MATHN_THR_RT<RealT>::n = MATHN_THR<RealT>::n;
+	NNTL_MATHN_THR_RT_LIST(_NNTL_THR_RT_DEFINE)
+#undef _NNTL_THR_RT_DEFINE
+
+}
+
+}
+}
@@ -0,0 +1,256 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+//vectorized activation functions and their derivatives.
+// Each kernel processes the longest prefix of the data that is a multiple of the vector width of the active instruction
+// set and returns the length of the prefix. The caller processes the rest with a scalar code (and it gets the whole data
+// if vectorized kernels aren't available). Parameters have the same meaning as in corresponding MathN::_i*_st() functions.
+// Formulas are the same as in scalar versions, so results differ only by the error of vectorized exp()/log() (see
+// accuracy policies in vmath.h). exp(x)-1 and log(1+x) are always computed by expm1() and log1p(), because vectorized
+// versions of them are as cheap as exp() and log().
+
+#include "vmath.h"
+
+namespace nntl {
+namespace math {
+namespace simd {
+
+	template<typename VT, typename AccT>
+	struct act_kernels {
+		typedef typename VT::real_t real_t;
+		typedef typename VT::vec_t vec_t;
+		static constexpr unsigned W = VT::width;
+
+		static size_t _vec_cnt(const size_t n)noexcept { return n - (n % W); }
+
+		static size_t sigm(real_t*const p, const size_t n)noexcept {
+			const auto ne = _vec_cnt(n);
+			const vec_t one = VT::set1(real_t(1.));
+			for (size_t i = 0; i < ne; i += W) {
+				VT::store(p + i, VT::div(one, VT::add(one, vexp<VT, AccT>(VT::neg(VT::load(p + i))))));
+			}
+			return ne;
+		}
+		static size_t dsigm(real_t*const p, const size_t n)noexcept {
+			const auto ne = _vec_cnt(n);
+			const vec_t one = VT::set1(real_t(1.));
+			for (size_t i = 0; i < ne; i += W) {
+				const vec_t f = VT::load(p + i);
+				VT::store(p + i, VT::mul(f, VT::sub(one, f)));
+			}
+			return ne;
+		}
+
+		//alpha*(exp(x)-1) | x<0,   x*lambda | x>=0. ELU is SELU with lambda==1
+		static size_t selu(real_t*const p, const size_t n, const real_t alpha_t_lambda, const real_t lambda)noexcept {
+			const auto ne = _vec_cnt(n);
+			const vec_t zero = VT::set1(real_t(0.)), atl = VT::set1(alpha_t_lambda), l = VT::set1(lambda);
+			for (size_t i = 0; i < ne; i += W) {
+				const vec_t x = VT::load(p + i);
+				const vec_t neg = VT::mul(vexpm1<VT, AccT>(VT::min(x, zero)), atl);
+				VT::store(p + i, VT::select(VT::lt(x, zero), neg, VT::mul(x, l)));
+			}
+			return ne;
+		}
+		static size_t elu(real_t*const p, const size_t n, const real_t alpha)noexcept {
+			const auto ne = _vec_cnt(n);
+			const vec_t zero = VT::set1(real_t(0.)), a = VT::set1(alpha);
+			for (size_t i = 0; i < ne; i += W) {
+				const vec_t x = VT::load(p + i);
+				const vec_t neg = VT::mul(vexpm1<VT, AccT>(VT::min(x, zero)), a);
+				VT::store(p + i, VT::select(VT::lt(x, zero), neg, x));
+			}
+			return ne;
+		}
+		//y+alpha | y<0,   lambda | y>=0. Also dELU with lambda==1
+		static size_t dselu(real_t*const p, const size_t n, const real_t alpha_t_lambda, const real_t lambda)noexcept {
+			const auto ne = _vec_cnt(n);
+			const vec_t zero = VT::set1(real_t(0.)), atl = VT::set1(alpha_t_lambda), l = VT::set1(lambda);
+			for (size_t i = 0; i < ne; i += W) {
+				const vec_t y = VT::load(p + i);
+				VT::store(p + i, VT::select(VT::lt(y, zero), VT::add(y, atl), l));
+			}
+			return ne;
+		}
+
+		//alpha*(exp(x)-1) | x<0,    log(x+1)*lbi | x>=0
+		static size_t elogu(real_t*const p, const size_t n, const real_t alpha, const real_t lbi)noexcept {
+			const auto ne = _vec_cnt(n);
+			const vec_t zero = VT::set1(real_t(0.)), a = VT::set1(alpha), vlbi = VT::set1(lbi);
+			for (size_t i = 0; i < ne; i += W) {
+				const vec_t x = VT::load(p + i);
+				const vec_t neg = VT::mul(vexpm1<VT, AccT>(VT::min(x, zero)), a);
+				const vec_t pos = VT::mul(vlog1p<VT, AccT>(VT::max(x, zero)), vlbi);
+				VT::store(p + i, VT::select(VT::lt(x, zero), neg, pos));
+			}
+			return ne;
+		}
+		//y+alpha | y<0,   exp(y*nlb + nllb) | y>=0
+		static size_t delogu(real_t*const p, const size_t n, const real_t alpha, const real_t nlb, const real_t nllb)noexcept {
+			const auto ne = _vec_cnt(n);
+			const vec_t zero = VT::set1(real_t(0.)), a = VT::set1(alpha), vnlb = VT::set1(nlb), vnllb = VT::set1(nllb);
+			for (size_t i = 0; i < ne; i += W) {
+				const vec_t y = VT::load(p + i);
+				const vec_t pos = vexp<VT, AccT>(VT::add(VT::mul(VT::max(y, zero), vnlb), vnllb));
+				VT::store(p + i, VT::select(VT::lt(y, zero), VT::add(y, a), pos));
+			}
+			return ne;
+		}
+
+		//(x<0 ? nlbnegi : lbposi)*log(1+|x|)
+		static size_t loglogu(real_t*const p, const size_t n, const real_t nlbnegi, const real_t lbposi)noexcept {
+			const auto ne = _vec_cnt(n);
+			const vec_t zero = VT::set1(real_t(0.)), vneg = VT::set1(nlbnegi), vpos = VT::set1(lbposi);
+			for (size_t i = 0; i < ne; i += W) {
+				const vec_t x = VT::load(p + i);
+				VT::store(p + i, VT::mul(VT::select(VT::lt(x, zero), vneg, vpos), vlog1p<VT, AccT>(VT::abs(x))));
+			}
+			return ne;
+		}
+		//exp(y<0 ? (y*lbneg + nllbneg) : (y*nlbpos + nllbpos))
+		static size_t dloglogu(real_t*const p, const size_t n, const real_t lbneg, const real_t nllbneg
+			, const real_t nlbpos, const real_t nllbpos)noexcept
+		{
+			const auto ne = _vec_cnt(n);
+			const vec_t zero = VT::set1(real_t(0.)), vlbneg = VT::set1(lbneg), vnllbneg = VT::set1(nllbneg)
+				, vnlbpos = VT::set1(nlbpos), vnllbpos = VT::set1(nllbpos);
+			for (size_t i = 0; i < ne; i += W) {
+				const vec_t y = VT::load(p + i);
+				const auto bNeg = VT::lt(y, zero);
+				VT::store(p + i, vexp<VT, AccT>(VT::add(VT::mul(y, VT::select(bNeg, vlbneg, vnlbpos)), VT::select(bNeg, vnllbneg, vnllbpos))));
+			}
+			return ne;
+		}
+
+		//(c*x)/(a+|x|)
+		static size_t softsign(real_t*const p, const size_t n, const real_t a, const real_t c)noexcept {
+			const auto ne = _vec_cnt(n);
+			const vec_t va = VT::set1(a), vc = VT::set1(c);
+			for (size_t i = 0; i < ne; i += W) {
+				const vec_t x = VT::load(p + i);
+				VT::store(p + i, VT::div(VT::mul(vc, x), VT::add(va, VT::abs(x))));
+			}
+			return ne;
+		}
+		//mult*(c-|y|)^2
+		static size_t dsoftsign(real_t*const p, const size_t n, const real_t mult, const real_t c)noexcept {
+			const auto ne = _vec_cnt(n);
+			const vec_t vm = VT::set1(mult), vc = VT::set1(c);
+			for (size_t i = 0; i < ne; i += W) {
+				const vec_t s = VT::sub(vc, VT::abs(VT::load(p + i)));
+				VT::store(p + i, VT::mul(vm, VT::mul(s, s)));
+			}
+			return ne;
+		}
+
+		//a part of softmax over a column of a matrix: pNum[i] = exp(pA[i] - pMax[i]), pDen[i] += pNum[i]
+		static size_t softmax_parts(const real_t*const pA, const real_t*const pMax, real_t*const pNum, real_t*const pDen
+			, const size_t n)noexcept
+		{
+			const auto ne = _vec_cnt(n);
+			for (size_t i = 0; i < ne; i += W) {
+				const vec_t num = vexp<VT, AccT>(VT::sub(VT::load(pA + i), VT::load(pMax + i)));
+				VT::store(pNum + i, num);
+				VT::store(pDen + i, VT::add(VT::load(pDen + i), num));
+			}
+			return ne;
+		}
+	};
+
+	//dispatches a call to act_kernels<> of the active instruction set. Returns the count of processed elements
+	template<typename RealT, typename AccT = vmath_default_t>
+	struct act {
+		typedef RealT real_t;
+
+		template<typename F>
+		static nntl_force_inline size_t _run(F&& f)noexcept {
+			switch (active_isa()) {
+#if NNTL_SIMD_AVX512
+			case isa::avx512:
+				return f(act_kernels<vtraits<isa::avx512, real_t>, AccT>());
+#endif
+#if NNTL_SIMD_AVX2
+			case isa::avx2:
+				return f(act_kernels<vtraits<isa::avx2, real_t>, AccT>());
+#endif
+			default:
+				return 0;
+			}
+		}
+
+		static size_t sigm(real_t*const p, const size_t n)noexcept {
+			return _run([p, n](auto k) { return decltype(k)::sigm(p, n); });
+		}
+		static size_t dsigm(real_t*const p, const size_t n)noexcept {
+			return _run([p, n](auto k) { return decltype(k)::dsigm(p, n); });
+		}
+		static size_t elu(real_t*const p, const size_t n, const real_t alpha)noexcept {
+			return _run([=](auto k) { return decltype(k)::elu(p, n, alpha); });
+		}
+		static size_t selu(real_t*const p, const size_t n, const real_t alpha_t_lambda, const real_t lambda)noexcept {
+			return _run([=](auto k) { return decltype(k)::selu(p, n, alpha_t_lambda, lambda); });
+		}
+		static size_t dselu(real_t*const p, const size_t n, const real_t alpha_t_lambda, const real_t lambda)noexcept {
+			return _run([=](auto k) { return decltype(k)::dselu(p, n, alpha_t_lambda, lambda); });
+		}
+		static size_t elogu(real_t*const p, const size_t n, const real_t alpha, const real_t lbi)noexcept {
+			return _run([=](auto k) { return decltype(k)::elogu(p, n, alpha, lbi); });
+		}
+		static size_t delogu(real_t*const p, const size_t n, const real_t alpha, const real_t nlb, const real_t nllb)noexcept {
+			return _run([=](auto k) { return decltype(k)::delogu(p, n, alpha, nlb, nllb); });
+		}
+		static size_t loglogu(real_t*const p, const size_t n, const real_t nlbnegi, const real_t lbposi)noexcept {
+			return _run([=](auto k) { return decltype(k)::loglogu(p, n, nlbnegi, lbposi); });
+		}
+		static size_t dloglogu(real_t*const p, const size_t n, const real_t lbneg, const real_t nllbneg
+			, const real_t nlbpos, const real_t nllbpos)noexcept
+		{
+			return _run([=](auto k) { return decltype(k)::dloglogu(p, n, lbneg, nllbneg, nlbpos, nllbpos); });
+		}
+		static size_t softsign(real_t*const p, const size_t n, const real_t a, const real_t c)noexcept {
+			return _run([=](auto k) { return decltype(k)::softsign(p, n, a, c); });
+		}
+		static size_t dsoftsign(real_t*const p, const size_t n, const real_t mult, const real_t c)noexcept {
+			return _run([=](auto k) { return decltype(k)::dsoftsign(p, n, mult, c); });
+		}
+		static size_t softmax_parts(const real_t*const pA, const real_t*const pMax, real_t*const pNum, real_t*const pDen
+			, const size_t n)noexcept
+		{
+			return _run([=](auto k) { return decltype(k)::softmax_parts(pA, pMax, pNum, pDen, n); });
+		}
+	};
+
+}
+}
+}
@@ -0,0 +1,350 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+//Packed and register-blocked general matrix multiplication C = alpha*op(A)*op(B) + C for column-major matrices
+// (a classical Goto/BLIS-style decomposition):
+// - op(B) is processed by KC x NC blocks, each block is packed into NR-columns wide slivers (kept in L3/L2),
+// - op(A) is processed by MC x KC blocks, each block is packed into MR-rows high slivers (kept in L2),
+// - the micro-kernel computes MR x NR block of C in registers from one sliver of A and one sliver of B (kept in L1).
+// The code here is single threaded; a caller splits C into independent parts for threads (see b_Native).
+// Pack buffers are thread local and grow on demand.
+// An optional epilogue is called for every block of C as soon as the block is finished, i.e. while it's still in cache
+// (see gemm_kernels::gemm_ep()).
+
+#include <algorithm>
+#include "simd.h"
+
+namespace nntl {
+namespace math {
+namespace simd {
+
+	//scalar "vector" of width 1 for CPUs without AVX2. Lets the same micro-kernel code to be used
+	template<typename RealT>
+	struct scalar_vtraits {
+		typedef RealT real_t;
+		typedef RealT vec_t;
+		static constexpr unsigned width = 1;
+
+		static nntl_force_inline vec_t load(const real_t* p)noexcept { return *p; }
+		static nntl_force_inline void store(real_t* p, const vec_t v)noexcept { *p = v; }
+		static nntl_force_inline vec_t set1(const real_t v)noexcept { return v; }
+		static nntl_force_inline vec_t fmadd(const vec_t a, const vec_t b, const vec_t c)noexcept { return a*b + c; }
+		static nntl_force_inline vec_t add(const vec_t a, const vec_t b)noexcept { return a + b; }
+	};
+
+	//epilogue that does nothing (for the plain gemm)
+	struct gemm_no_epilogue {
+		template<typename RealT>
+		nntl_force_inline void operator()(RealT*const, const size_t, const size_t, const size_t)const noexcept {}
+	};
+
+	//register and cache blocking parameters.
+	// MV vectors by NR columns of accumulators + MV vectors of A + a broadcasted element of B must fit into registers
+	// (16 for AVX2, 32 for AVX-512). MC*KC elements of A should fit into a half of L2, KC*NR of B - into a half of L1.
+	template<typename VT> struct gemm_blocking {
+		static constexpr unsigned MV = 4, NR = 4, KC = 256, MC = 64, NC = 1024;
+	};
+#if NNTL_SIMD_AVX2
+	template<typename RealT> struct gemm_blocking<vtraits<isa::avx2, RealT>> {
+		static constexpr unsigned MV = 2, NR = 6, KC = 256, MC = 128 * sizeof(double) / sizeof(RealT), NC = 2048;
+	};
+#endif
+#if NNTL_SIMD_AVX512
+	template<typename RealT> struct gemm_blocking<vtraits<isa::avx512, RealT>> {
+		static constexpr unsigned MV = 2, NR = 12, KC = 256, MC = 128 * sizeof(double) / sizeof(RealT), NC = 2048;
+	};
+#endif
+
+	namespace _impl {
+		template<typename RealT>
+		class gemm_pack_buffer {
+			RealT* m_p;
+			size_t m_n;
+
+		public:
+			~gemm_pack_buffer()noexcept { if (m_p) _mm_free(m_p); }
+			gemm_pack_buffer()noexcept : m_p(nullptr), m_n(0) {}
+
+			//returns nullptr if failed to allocate the memory
+			RealT* get(const size_t n)noexcept {
+				if (n > m_n) {
+					if (m_p) _mm_free(m_p);
+					m_p = static_cast<RealT*>(_mm_malloc(n * sizeof(RealT), 64));
+					m_n = m_p ? n : 0;
+				}
+				return m_p;
+			}
+		};
+
+		//0 is for A and 1 is for B
+		template<typename RealT, unsigned Idx>
+		RealT* gemm_pack_mem(const size_t n)noexcept {
+			static thread_local gemm_pack_buffer<RealT> buf;
+			return buf.get(n);
+		}
+	}
+
+	template<typename VT>
+	struct gemm_kernels {
+		typedef typename VT::real_t real_t;
+		typedef typename VT::vec_t vec_t;
+		typedef gemm_blocking<VT> blocking_t;
+
+		static constexpr unsigned W = VT::width, MV = blocking_t::MV, MR = MV*W, NR = blocking_t::NR
+			, KC = blocking_t::KC, MC = (blocking_t::MC / MR)*MR, NC = (blocking_t::NC / NR)*NR;
+		static_assert(MC > 0 && NC > 0, "Wrong blocking parameters");
+
+		//packs rows [i0, i0+mc) and columns [k0, k0+kc) of op(A) into MR-rows high slivers. Each sliver stores kc columns
+		// of MR elements each. Rows past mc are zero-padded.
+		static void packA(const bool bTransposeA, const real_t*const A, const size_t lda, const size_t i0, const size_t mc
+			, const size_t k0, const size_t kc, real_t* pDest)noexcept
+		{
+			for (size_t s = 0; s < mc; s += MR) {
+				const size_t mr = ::std::min(size_t(MR), mc - s);
+				if (bTransposeA) {
+					//op(A)(i,k) == A[k + i*lda], so a row of op(A) is contiguous
+					for (size_t r = 0; r < mr; ++r) {
+						const real_t* pSrc = A + k0 + (i0 + s + r)*lda;
+						for (size_t k = 0; k < kc; ++k) pDest[k*MR + r] = pSrc[k];
+					}
+					for (size_t r = mr; r < MR; ++r) {
+						for (size_t k = 0; k < kc; ++k) pDest[k*MR + r] = real_t(0);
+					}
+				} else {
+					const real_t* pSrc = A + i0 + s + k0*lda;
+					for (size_t k = 0; k < kc; ++k) {
+						const auto pD = pDest + k*MR;
+						size_t r = 0;
+						for (; r < mr; ++r) pD[r] = pSrc[r];
+						for (; r < MR; ++r) pD[r] = real_t(0);
+						pSrc += lda;
+					}
+				}
+				pDest += kc*MR;
+			}
+		}
+
+		//packs rows [k0, k0+kc) and columns [j0, j0+nc) of op(B) into NR-columns wide slivers. Each sliver stores kc rows
+		// of NR elements each. Columns past nc are zero-padded.
+		static void packB(const bool bTransposeB, const real_t*const B, const size_t ldb, const size_t k0, const size_t kc
+			, const size_t j0, const size_t nc, real_t* pDest)noexcept
+		{
+			for (size_t s = 0; s < nc; s += NR) {
+				const size_t nr = ::std::min(size_t(NR), nc - s);
+				if (bTransposeB) {
+					//op(B)(k,j) == B[j + k*ldb], so a row of op(B) is contiguous
+					const real_t* pSrc = B + j0 + s + k0*ldb;
+					for (size_t k = 0; k < kc; ++k) {
+						const auto pD = pDest + k*NR;
+						size_t c = 0;
+						for (; c < nr; ++c) pD[c] = pSrc[c];
+						for (; c < NR; ++c) pD[c] = real_t(0);
+						pSrc += ldb;
+					}
+				} else {
+					for (size_t c = 0; c < nr; ++c) {
+						const real_t* pSrc = B + k0 + (j0 + s + c)*ldb;
+						for (size_t k = 0; k < kc; ++k) pDest[k*NR + c] = pSrc[k];
+					}
+					for (size_t c = nr; c < NR; ++c) {
+						for (size_t k = 0; k < kc; ++k) pDest[k*NR + c] = real_t(0);
+					}
+				}
+				pDest += kc*NR;
+			}
+		}
+
+		//C(MR x NR) += alpha * Ap(MR x kc) * Bp(kc x NR)
+		static nntl_force_inline void micro(const size_t kc, const real_t* pA, const real_t* pB, const real_t alpha
+			, real_t*const C, const size_t ldc)noexcept
+		{
+			vec_t acc[NR][MV];
+			for (unsigned j = 0; j < NR; ++j) {
+				for (unsigned v = 0; v < MV; ++v) acc[j][v] = VT::set1(real_t(0));
+			}
+			for (size_t k = 0; k < kc; ++k) {
+				vec_t a[MV];
+				for (unsigned v = 0; v < MV; ++v) a[v] = VT::load(pA + v*W);
+				for (unsigned j = 0; j < NR; ++j) {
+					const vec_t b = VT::set1(pB[j]);
+					for (unsigned v = 0; v < MV; ++v) acc[j][v] = VT::fmadd(a[v], b, acc[j][v]);
+				}
+				pA += MR;
+				pB += NR;
+			}
+			const vec_t va = VT::set1(alpha);
+			for (unsigned j = 0; j < NR; ++j) {
+				const auto pC = C + j*ldc;
+				for (unsigned v = 0; v < MV; ++v) VT::store(pC + v*W, VT::fmadd(acc[j][v], va, VT::load(pC + v*W)));
+			}
+		}
+
+		//C(mr x nr) += alpha * Ap * Bp for partial blocks
+		static void micro_edge(const size_t kc, const real_t* pA, const real_t* pB, const real_t alpha
+			, real_t*const C, const size_t ldc, const size_t mr, const size_t nr)noexcept
+		{
+			real_t tmp[MR*NR];
+			::std::fill_n(tmp, MR*NR, real_t(0));
+			micro(kc, pA, pB, real_t(1), tmp, MR);
+			for (size_t j = 0; j < nr; ++j) {
+				for (size_t i = 0; i < mr; ++i) C[i + j*ldc] += alpha*tmp[i + j*MR];
+			}
+		}
+
+		//C = beta*C for the rows [m0, m1) and columns [n0, n1). beta==0 overwrites C regardless of its content (like BLAS does)
+		static void scale(const real_t beta, real_t*const C, const size_t ldc, const size_t m0, const size_t m1
+			, const size_t n0, const size_t n1)noexcept
+		{
+			if (real_t(1) == beta) return;
+			for (size_t j = n0; j < n1; ++j) {
+				const auto pC = C + j*ldc;
+				if (real_t(0) == beta) {
+					for (size_t i = m0; i < m1; ++i) pC[i] = real_t(0);
+				} else {
+					for (size_t i = m0; i < m1; ++i) pC[i] *= beta;
+				}
+			}
+		}
+
+		//computes the rows [m0, m1) and columns [n0, n1) of C = alpha*op(A)*op(B) + beta*C. op(A) is M x K, op(B) is K x N.
+		// Returns false if failed to allocate pack buffers
+		static bool gemm(const bool bTransposeA, const bool bTransposeB, const size_t K, const real_t alpha
+			, const real_t*const A, const size_t lda, const real_t*const B, const size_t ldb, const real_t beta
+			, real_t*const C, const size_t ldc, const size_t m0, const size_t m1, const size_t n0, const size_t n1)noexcept
+		{
+			return gemm_ep(bTransposeA, bTransposeB, K, alpha, A, lda, B, ldb, beta, C, ldc, m0, m1, n0, n1, gemm_no_epilogue());
+		}
+
+		//same as gemm(), but calls ep(pC, ldc, mc, nc) for every finished block of C (MC x NC at most). pC points to the
+		// top left element of a block of mc rows and nc columns; blocks cover [m0, m1) x [n0, n1) exactly once. The block
+		// is passed as soon as the last K-slice of it has been accumulated, so the epilogue finds it in cache.
+		template<typename EpilogueF>
+		static bool gemm_ep(const bool bTransposeA, const bool bTransposeB, const size_t K, const real_t alpha
+			, const real_t*const A, const size_t lda, const real_t*const B, const size_t ldb, const real_t beta
+			, real_t*const C, const size_t ldc, const size_t m0, const size_t m1, const size_t n0, const size_t n1
+			, EpilogueF&& ep)noexcept
+		{
+			if (m0 >= m1 || n0 >= n1) return true;
+			scale(beta, C, ldc, m0, m1, n0, n1);
+			if (0 == K || real_t(0) == alpha) {
+				ep(C + m0 + n0*ldc, ldc, m1 - m0, n1 - n0);
+				return true;
+			}
+
+			const size_t mcMax = ::std::min(size_t(MC), ((m1 - m0 + MR - 1) / MR)*MR)
+				, ncMax = ::std::min(size_t(NC), ((n1 - n0 + NR - 1) / NR)*NR), kcMax = ::std::min(size_t(KC), K);
+			const auto pAp = _impl::gemm_pack_mem<real_t, 0>(mcMax*kcMax);
+			const auto pBp = _impl::gemm_pack_mem<real_t, 1>(ncMax*kcMax);
+			if (!pAp || !pBp) return false;
+
+			for (size_t jc = n0; jc < n1; jc += NC) {
+				const size_t nc = ::std::min(size_t(NC), n1 - jc);
+				for (size_t pc = 0; pc < K; pc += KC) {
+					const size_t kc = ::std::min(size_t(KC), K - pc);
+					packB(bTransposeB, B, ldb, pc, kc, jc, nc, pBp);
+
+					for (size_t ic = m0; ic < m1; ic += MC) {
+						const size_t mc = ::std::min(size_t(MC), m1 - ic);
+						packA(bTransposeA, A, lda, ic, mc, pc, kc, pAp);
+
+						for (size_t jr = 0; jr < nc; jr += NR) {
+							const size_t nr = ::std::min(size_t(NR), nc - jr);
+							const auto pB = pBp + jr*kc;
+							for (size_t ir = 0; ir < mc; ir += MR) {
+								const size_t mr = ::std::min(size_t(MR), mc - ir);
+								const auto pA = pAp + ir*kc;
+								const auto pC = C + (ic + ir) + (jc + jr)*ldc;
+								if (MR == mr && NR == nr) {
+									micro(kc, pA, pB, alpha, pC, ldc);
+								} else micro_edge(kc, pA, pB, alpha, pC, ldc, mr, nr);
+							}
+						}
+						if (pc + kc >= K) ep(C + ic + jc*ldc, ldc, mc, nc);
+					}
+				}
+			}
+			return true;
+		}
+	};
+
+	//dispatches a call to gemm_kernels<> of the active instruction set
+	template<typename RealT>
+	struct gemm {
+		typedef RealT real_t;
+
+		template<typename F>
+		static nntl_force_inline auto _run(F&& f)noexcept {
+			switch (active_isa()) {
+#if NNTL_SIMD_AVX512
+			case isa::avx512:
+				return f(gemm_kernels<vtraits<isa::avx512, real_t>>());
+#endif
+#if NNTL_SIMD_AVX2
+			case isa::avx2:
+				return f(gemm_kernels<vtraits<isa::avx2, real_t>>());
+#endif
+			default:
+				return f(gemm_kernels<scalar_vtraits<real_t>>());
+			}
+		}
+
+		//the size of the register block of the active instruction set. C should be split among threads by these
+		static size_t MR()noexcept { return _run([](auto k) { return size_t(decltype(k)::MR); }); }
+		static size_t NR()noexcept { return _run([](auto k) { return size_t(decltype(k)::NR); }); }
+
+		static bool run(const bool bTransposeA, const bool bTransposeB, const size_t K, const real_t alpha
+			, const real_t*const A, const size_t lda, const real_t*const B, const size_t ldb, const real_t beta
+			, real_t*const C, const size_t ldc, const size_t m0, const size_t m1, const size_t n0, const size_t n1)noexcept
+		{
+			return _run([=](auto k) {
+				return decltype(k)::gemm(bTransposeA, bTransposeB, K, alpha, A, lda, B, ldb, beta, C, ldc, m0, m1, n0, n1);
+			});
+		}
+
+		//see gemm_kernels::gemm_ep()
+		template<typename EpilogueF>
+		static bool run_ep(const bool bTransposeA, const bool bTransposeB, const size_t K, const real_t alpha
+			, const real_t*const A, const size_t lda, const real_t*const B, const size_t ldb, const real_t beta
+			, real_t*const C, const size_t ldc, const size_t m0, const size_t m1, const size_t n0, const size_t n1
+			, EpilogueF&& ep)noexcept
+		{
+			return _run([=, &ep](auto k) {
+				return decltype(k)::gemm_ep(bTransposeA, bTransposeB, K, alpha, A, lda, B, ldb, beta, C, ldc, m0, m1, n0, n1, ep);
+			});
+		}
+	};
+
+}
+}
+}
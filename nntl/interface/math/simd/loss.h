@@ -0,0 +1,129 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+//vectorized parts of loss functions. Same conventions as in act.h: a kernel processes the longest prefix of the data that
+// is a multiple of the vector width and returns its length, the caller processes the rest with a scalar code.
+
+#include <limits>
+#include "vmath.h"
+
+namespace nntl {
+namespace math {
+namespace simd {
+
+	template<typename VT, typename AccT>
+	struct loss_kernels {
+		typedef typename VT::real_t real_t;
+		typedef typename VT::vec_t vec_t;
+		static constexpr unsigned W = VT::width;
+
+		static size_t _vec_cnt(const size_t n)noexcept { return n - (n % W); }
+
+		static nntl_force_inline real_t _hsum(const vec_t v)noexcept {
+			real_t t[W];
+			VT::store(t, v);
+			real_t s = real_t(0);
+			for (unsigned i = 0; i < W; ++i) s += t[i];
+			return s;
+		}
+
+		//adds to ql a sum of y>0 ? log(a + min) : log((1-a) + min) over binary y, where min is the smallest normal number
+		static size_t xentropy(const real_t*const pA, const real_t*const pY, const size_t n, real_t& ql)noexcept {
+			const auto ne = _vec_cnt(n);
+			const vec_t zero = VT::set1(real_t(0.)), one = VT::set1(real_t(1.))
+				, tiny = VT::set1(::std::numeric_limits<real_t>::min());
+			vec_t acc = zero;
+			for (size_t i = 0; i < ne; i += W) {
+				const vec_t a = VT::load(pA + i);
+				//taking a single log() of the selected argument
+				const vec_t v = VT::select(VT::gt(VT::load(pY + i), zero), a, VT::sub(one, a));
+				acc = VT::add(acc, vlog<VT, AccT>(VT::add(v, tiny)));
+			}
+			if (ne) ql += _hsum(acc);
+			return ne;
+		}
+		//same as xentropy(), but log(1-a) is computed as log1p(-a) (and a==1 gives logZero)
+		static size_t xentropy_log1p(const real_t*const pA, const real_t*const pY, const size_t n, const real_t logZero
+			, real_t& ql)noexcept
+		{
+			const auto ne = _vec_cnt(n);
+			const vec_t zero = VT::set1(real_t(0.)), one = VT::set1(real_t(1.)), lz = VT::set1(logZero)
+				, tiny = VT::set1(::std::numeric_limits<real_t>::min());
+			vec_t acc = zero;
+			for (size_t i = 0; i < ne; i += W) {
+				const vec_t a = VT::load(pA + i);
+				const vec_t pos = vlog<VT, AccT>(VT::add(a, tiny));
+				//lanes with a==1 compute garbage that is thrown away
+				const vec_t neg = VT::select(VT::lt(a, one), vlog1p<VT, AccT>(VT::neg(a)), lz);
+				acc = VT::add(acc, VT::select(VT::gt(VT::load(pY + i), zero), pos, neg));
+			}
+			if (ne) ql += _hsum(acc);
+			return ne;
+		}
+	};
+
+	//dispatches a call to loss_kernels<> of the active instruction set. Returns the count of processed elements
+	template<typename RealT, typename AccT = vmath_default_t>
+	struct loss {
+		typedef RealT real_t;
+
+		template<typename F>
+		static nntl_force_inline size_t _run(F&& f)noexcept {
+			switch (active_isa()) {
+#if NNTL_SIMD_AVX512
+			case isa::avx512:
+				return f(loss_kernels<vtraits<isa::avx512, real_t>, AccT>());
+#endif
+#if NNTL_SIMD_AVX2
+			case isa::avx2:
+				return f(loss_kernels<vtraits<isa::avx2, real_t>, AccT>());
+#endif
+			default:
+				return 0;
+			}
+		}
+
+		static size_t xentropy(const real_t*const pA, const real_t*const pY, const size_t n, real_t& ql)noexcept {
+			return _run([=, &ql](auto k) { return decltype(k)::xentropy(pA, pY, n, ql); });
+		}
+		static size_t xentropy_log1p(const real_t*const pA, const real_t*const pY, const size_t n, const real_t logZero
+			, real_t& ql)noexcept
+		{
+			return _run([=, &ql](auto k) { return decltype(k)::xentropy_log1p(pA, pY, n, logZero, ql); });
+		}
+	};
+
+}
+}
+}
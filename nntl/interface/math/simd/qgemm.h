@@ -0,0 +1,447 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//Quantized int8 matrix multiplication C = A * W' for the inference.
+// W (N x K, the weights of a layer) is quantized once, every row (neuron) with its own symmetric scale
+// sw[n] = max|W[n,:]|/127. Biases aren't quantized. A (M x K) is quantized on every call with a single symmetric scale
+// sa = max|A|/127 for the whole batch. The int32 dot products are dequantized C[m,n] = acc*sa*sw[n] + b[n].
+// Both operands are packed into panels like in gemm.h: A into panels of q8_MR rows, W into panels of q8_NR neurons.
+// K is padded with zeros to a multiple of 4, and a panel stores 4 consecutive k of each of its rows (neurons) together,
+// i.e. every group of 4 k takes 4*q8_MR (4*q8_NR) contiguous bytes. The kernel keeps q8_MR x q8_NR int32 accumulators
+// in registers, broadcasts 4 bytes of a row of A and multiplies them by the same 4 k of q8_NR neurons at once, so
+// there are no horizontal sums. K is processed in blocks of KC, the block of a W panel stays in L1 while it's multiplied
+// by MC rows of A. The sums of the blocks are accumulated in C.
+// The AVX2 kernel uses vpmaddubsw (unsigned by signed bytes) on |a| and w*sign(a): a pair of such products fits into
+// int16 without saturation, because |a|,|w| <= 127. vpmaddwd then sums pairs of int16 into int32. The same kernel is
+// used for AVX-512, because the 512 bit versions of these instructions require AVX-512BW, while only AVX-512F is
+// detected (see simd.h)
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "simd.h"
+
+namespace nntl {
+namespace math {
+namespace simd {
+
+	namespace _impl {
+		//int8 storage that grows on demand
+		class q8_buffer {
+		protected:
+			::std::int8_t* m_p;
+			size_t m_capacity;
+
+		public:
+			~q8_buffer()noexcept { clear(); }
+			q8_buffer()noexcept : m_p(nullptr), m_capacity(0) {}
+			q8_buffer(const q8_buffer&) = delete;
+			q8_buffer& operator=(const q8_buffer&) = delete;
+			q8_buffer(q8_buffer&& o)noexcept : m_p(o.m_p), m_capacity(o.m_capacity) {
+				o.m_p = nullptr;
+				o.m_capacity = 0;
+			}
+
+			::std::int8_t* data()const noexcept { return m_p; }
+			size_t capacity()const noexcept { return m_capacity; }
+
+			bool reserve(const size_t n)noexcept {
+				if (n > m_capacity) {
+					clear();
+					m_p = static_cast<::std::int8_t*>(_mm_malloc(n, 64));
+					if (!m_p) return false;
+					m_capacity = n;
+				}
+				return true;
+			}
+			void clear()noexcept {
+				if (m_p) {
+					_mm_free(m_p);
+					m_p = nullptr;
+				}
+				m_capacity = 0;
+			}
+		};
+
+		//the value is rounded to the nearest (half away from zero) and clamped to [-127, 127]
+		template<typename RealT>
+		inline ::std::int8_t q8_round(const RealT v)noexcept {
+			const RealT r = v >= RealT(0) ? v + RealT(.5) : v - RealT(.5);
+			return static_cast<::std::int8_t>(r >= RealT(127) ? 127 : (r <= RealT(-127) ? -127 : static_cast<int>(r)));
+		}
+	}
+
+	//padding of K dimension (the size of a group of k). Both operands are padded with zeros
+	static constexpr size_t q8_KAlign = 4;
+	inline size_t q8_padded(const size_t K)noexcept { return (K + q8_KAlign - 1) & ~(q8_KAlign - 1); }
+
+	//rows of A and neurons of W in a panel. The packed layout doesn't depend on the instruction set
+	static constexpr unsigned q8_MR = 4, q8_NR = 16;
+
+	//offset of the element (i, k) in the operand packed into panels of P rows with kp (padded) columns
+	template<unsigned P>
+	inline size_t q8_packed_offset(const size_t i, const size_t k, const size_t kp)noexcept {
+		return (i / P)*P*kp + (k / q8_KAlign)*P*q8_KAlign + (i % P)*q8_KAlign + k % q8_KAlign;
+	}
+
+	//per-row quantized weights W (N x K) packed into panels of q8_NR neurons, and their biases
+	template<typename RealT>
+	class q8_weights {
+	public:
+		typedef RealT real_t;
+
+	protected:
+		_impl::q8_buffer m_w;
+		real_t* m_pSB;//N scales followed by N biases
+		size_t m_sbCapacity, m_n, m_k, m_kp;
+
+	public:
+		~q8_weights()noexcept { _free(); }
+		q8_weights()noexcept : m_pSB(nullptr), m_sbCapacity(0), m_n(0), m_k(0), m_kp(0) {}
+
+		q8_weights(const q8_weights&) = delete;
+		q8_weights& operator=(const q8_weights&) = delete;
+
+		q8_weights(q8_weights&& o)noexcept : m_w(::std::move(o.m_w)), m_pSB(o.m_pSB), m_sbCapacity(o.m_sbCapacity)
+			, m_n(o.m_n), m_k(o.m_k), m_kp(o.m_kp)
+		{
+			o.m_pSB = nullptr;
+			o.m_sbCapacity = o.m_n = o.m_k = o.m_kp = 0;
+		}
+
+		bool empty()const noexcept { return 0 == m_n; }
+		size_t neurons()const noexcept { return m_n; }
+		size_t inputs()const noexcept { return m_k; }
+		size_t padded_inputs()const noexcept { return m_kp; }
+		size_t panels()const noexcept { return (m_n + q8_NR - 1) / q8_NR; }
+
+		const ::std::int8_t* panel(const size_t p)const noexcept { NNTL_ASSERT(p < panels()); return m_w.data() + p*q8_NR*m_kp; }
+		const real_t* scales()const noexcept { return m_pSB; }
+		const real_t* biases()const noexcept { return m_pSB + m_n; }
+
+		//the amount of memory the quantized weights occupy
+		size_t bytes()const noexcept { return panels()*q8_NR*m_kp + 2 * m_n * sizeof(real_t); }
+
+		//forgets the content, but keeps the memory for the next quantize()
+		void reset()noexcept { m_n = m_k = m_kp = 0; }
+
+		void clear()noexcept {
+			_free();
+			m_w.clear();
+			reset();
+		}
+
+		//quantizes N x K column-major matrix W with leading dimension ldw. pB points to N biases (may be nullptr,
+		// then biases are zeros). Returns false if failed to allocate the memory
+		bool quantize(const real_t*const W, const size_t N, const size_t K, const size_t ldw, const real_t*const pB)noexcept {
+			NNTL_ASSERT(W && N && K && ldw >= N);
+			const size_t kp = q8_padded(K), packedBytes = ((N + q8_NR - 1) / q8_NR)*q8_NR*kp;
+			if (!m_w.reserve(packedBytes)) {
+				reset();
+				return false;
+			}
+			if (2 * N > m_sbCapacity) {
+				_free();
+				m_pSB = static_cast<real_t*>(_mm_malloc(2 * N * sizeof(real_t), 64));
+				if (!m_pSB) {
+					reset();
+					return false;
+				}
+				m_sbCapacity = 2 * N;
+			}
+
+			//W is walked column-wise, so it's read sequentially. Biases storage holds 1/scale meanwhile
+			real_t*const pScales = m_pSB;
+			real_t*const pBiases = m_pSB + N;
+			::std::fill(pScales, pScales + N, real_t(0));
+			for (size_t k = 0; k < K; ++k) {
+				const real_t* pW = W + k*ldw;
+				for (size_t n = 0; n < N; ++n) pScales[n] = ::std::max(pScales[n], ::std::abs(pW[n]));
+			}
+			for (size_t n = 0; n < N; ++n) {
+				//a zero row stays zero with any scale
+				pScales[n] = pScales[n] > real_t(0) ? pScales[n] / real_t(127) : real_t(1);
+				pBiases[n] = real_t(1) / pScales[n];
+			}
+
+			auto pQ = m_w.data();
+			//padding neurons and padding k stay zero
+			::std::memset(pQ, 0, packedBytes);
+			for (size_t k = 0; k < K; ++k) {
+				const real_t* pW = W + k*ldw;
+				for (size_t n = 0; n < N; ++n) pQ[q8_packed_offset<q8_NR>(n, k, kp)] = _impl::q8_round(pW[n] * pBiases[n]);
+			}
+			for (size_t n = 0; n < N; ++n) pBiases[n] = pB ? pB[n] : real_t(0);
+
+			m_n = N;
+			m_k = K;
+			m_kp = kp;
+			return true;
+		}
+
+	protected:
+		void _free()noexcept {
+			if (m_pSB) {
+				_mm_free(m_pSB);
+				m_pSB = nullptr;
+			}
+			m_sbCapacity = 0;
+		}
+	};
+
+	//per-batch quantized activations A (M x K) packed into panels of q8_MR rows
+	template<typename RealT>
+	class q8_activations {
+	public:
+		typedef RealT real_t;
+
+	protected:
+		_impl::q8_buffer m_a;
+		real_t m_scale;
+		size_t m_m, m_kp;
+
+	public:
+		q8_activations()noexcept : m_scale(0), m_m(0), m_kp(0) {}
+
+		size_t rows()const noexcept { return m_m; }
+		size_t padded_inputs()const noexcept { return m_kp; }
+		size_t panels()const noexcept { return (m_m + q8_MR - 1) / q8_MR; }
+		real_t scale()const noexcept { return m_scale; }
+		const ::std::int8_t* panel(const size_t p)const noexcept { NNTL_ASSERT(p < panels()); return m_a.data() + p*q8_MR*m_kp; }
+
+		void clear()noexcept {
+			m_a.clear();
+			m_m = m_kp = 0;
+		}
+
+		//prepares the storage for M rows of kp elements. Returns false if failed to allocate the memory
+		bool reserve(const size_t M, const size_t kp)noexcept {
+			NNTL_ASSERT(0 == kp % q8_KAlign);
+			if (!m_a.reserve(((M + q8_MR - 1) / q8_MR)*q8_MR*kp)) {
+				m_m = m_kp = 0;
+				return false;
+			}
+			m_m = M;
+			m_kp = kp;
+			return true;
+		}
+
+		//returns max|A| over M x K column-major matrix A stored contiguously (i.e. lda == M)
+		static real_t amax(const real_t*const pA, const size_t n)noexcept {
+			real_t am(0);
+			for (size_t i = 0; i < n; ++i) am = ::std::max(am, ::std::abs(pA[i]));
+			return am;
+		}
+
+		//sets the scale from the value of max|A|
+		void set_amax(const real_t am)noexcept {
+			m_scale = am > real_t(0) ? am / real_t(127) : real_t(1);
+		}
+
+		//quantizes rows [m0, m1) of M x K column-major matrix A with leading dimension lda. Must be called after set_amax().
+		// Different threads may quantize different rows of the same panel, because every row has its own bytes in it
+		void quantize_rows(const real_t*const A, const size_t lda, const size_t K, const size_t m0, const size_t m1)noexcept {
+			NNTL_ASSERT(m0 < m1 && m1 <= m_m && K <= m_kp && m_scale > real_t(0));
+			const real_t invS = real_t(1) / m_scale;
+			const auto pQ = m_a.data();
+			//column-wise walk reads A sequentially
+			for (size_t k = 0; k < K; ++k) {
+				const real_t* pA = A + k*lda;
+				for (size_t m = m0; m < m1; ++m) pQ[q8_packed_offset<q8_MR>(m, k, m_kp)] = _impl::q8_round(pA[m] * invS);
+			}
+			for (size_t k = K; k < m_kp; ++k) {
+				for (size_t m = m0; m < m1; ++m) pQ[q8_packed_offset<q8_MR>(m, k, m_kp)] = 0;
+			}
+			//padding rows of the last panel belong to the last row
+			if (m1 == m_m) {
+				const size_t mEnd = panels()*q8_MR;
+				for (size_t k = 0; k < m_kp; ++k) {
+					for (size_t m = m_m; m < mEnd; ++m) pQ[q8_packed_offset<q8_MR>(m, k, m_kp)] = 0;
+				}
+			}
+		}
+	};
+
+	//acc[TR rows][q8_NR] = the int32 dot products of the first TR rows of an A panel and a W panel over kg groups of k
+	struct q8_scalar_kernel {
+		template<unsigned TR>
+		static nntl_force_inline void tile(const size_t kg, const ::std::int8_t* pA, const ::std::int8_t* pW
+			, ::std::int32_t(&acc)[q8_MR][q8_NR])noexcept
+		{
+			for (unsigned r = 0; r < TR; ++r) {
+				for (unsigned n = 0; n < q8_NR; ++n) acc[r][n] = 0;
+			}
+			for (size_t g = 0; g < kg; ++g) {
+				for (unsigned r = 0; r < TR; ++r) {
+					const auto a = pA + r*q8_KAlign;
+					for (unsigned n = 0; n < q8_NR; ++n) {
+						const auto w = pW + n*q8_KAlign;
+						::std::int32_t s = 0;
+						for (unsigned i = 0; i < q8_KAlign; ++i) s += ::std::int32_t(a[i]) * ::std::int32_t(w[i]);
+						acc[r][n] += s;
+					}
+				}
+				pA += q8_MR*q8_KAlign;
+				pW += q8_NR*q8_KAlign;
+			}
+		}
+	};
+
+#if NNTL_SIMD_AVX2
+	struct q8_avx2_kernel {
+		//a ymm register holds 4 k of 8 neurons, so a row of the tile takes NV registers.
+		// q8_MR*NV accumulators + NV vectors of W + a broadcasted A, its absolute value and ones fit into 16 ymm registers
+		static constexpr unsigned NV = q8_NR / 8;
+		static_assert(NV * 8 == q8_NR, "q8_NR must be a multiple of 8");
+
+		template<unsigned TR>
+		static nntl_force_inline void tile(const size_t kg, const ::std::int8_t* pA, const ::std::int8_t* pW
+			, ::std::int32_t(&acc)[q8_MR][q8_NR])noexcept
+		{
+			const __m256i ones = _mm256_set1_epi16(1);
+			__m256i c[TR][NV];
+			for (unsigned r = 0; r < TR; ++r) {
+				for (unsigned v = 0; v < NV; ++v) c[r][v] = _mm256_setzero_si256();
+			}
+			for (size_t g = 0; g < kg; ++g) {
+				__m256i w[NV];
+				for (unsigned v = 0; v < NV; ++v) w[v] = _mm256_load_si256(reinterpret_cast<const __m256i*>(pW + v * 32));
+				for (unsigned r = 0; r < TR; ++r) {
+					::std::int32_t a4;
+					::std::memcpy(&a4, pA + r*q8_KAlign, sizeof(a4));
+					const __m256i a = _mm256_set1_epi32(a4), absA = _mm256_sign_epi8(a, a);
+					for (unsigned v = 0; v < NV; ++v) {
+						const __m256i p = _mm256_maddubs_epi16(absA, _mm256_sign_epi8(w[v], a));
+						c[r][v] = _mm256_add_epi32(c[r][v], _mm256_madd_epi16(p, ones));
+					}
+				}
+				pA += q8_MR*q8_KAlign;
+				pW += q8_NR*q8_KAlign;
+			}
+			for (unsigned r = 0; r < TR; ++r) {
+				for (unsigned v = 0; v < NV; ++v) _mm256_storeu_si256(reinterpret_cast<__m256i*>(&acc[r][v * 8]), c[r][v]);
+			}
+		}
+	};
+#endif
+
+	//cache blocking: KCG groups of k (KCG*q8_KAlign*q8_NR bytes of a W panel should fit into a half of L1) by MCP panels of A
+	template<typename KT> struct q8_blocking {
+		static constexpr size_t KCG = 128, MCP = 16;
+	};
+
+	template<typename RealT>
+	struct q8_gemm {
+		typedef RealT real_t;
+		typedef q8_weights<real_t> weights_t;
+		typedef q8_activations<real_t> activations_t;
+
+		template<typename KT>
+		static nntl_force_inline void _tile(const unsigned rc, const size_t kg, const ::std::int8_t* pA
+			, const ::std::int8_t* pW, ::std::int32_t(&acc)[q8_MR][q8_NR])noexcept
+		{
+			static_assert(4 == q8_MR, "update the switch");
+			switch (rc) {
+			case 1: KT::template tile<1>(kg, pA, pW, acc); break;
+			case 2: KT::template tile<2>(kg, pA, pW, acc); break;
+			case 3: KT::template tile<3>(kg, pA, pW, acc); break;
+			default: KT::template tile<q8_MR>(kg, pA, pW, acc); break;
+			}
+		}
+
+		//C[m0:m1, n0:n1] = dequantized(Aq[m0:m1] * Wq[n0:n1]'). C is column-major. The ranges don't have to be aligned to
+		// panels, a panel that is shared by ranges of different threads is computed by each of them, but only the own part
+		// of C is written
+		template<typename KT>
+		static void run_k(const activations_t& Aq, const weights_t& Wq, const size_t m0, const size_t m1
+			, const size_t n0, const size_t n1, real_t*const C, const size_t ldc)noexcept
+		{
+			constexpr size_t KCG = q8_blocking<KT>::KCG, MCP = q8_blocking<KT>::MCP;
+			NNTL_ASSERT(m0 < m1 && m1 <= Aq.rows() && n0 < n1 && n1 <= Wq.neurons());
+			const size_t kp = Wq.padded_inputs(), groups = kp / q8_KAlign;
+			NNTL_ASSERT(kp == Aq.padded_inputs());
+			const real_t sa = Aq.scale();
+			const real_t*const pScales = Wq.scales();
+			const real_t*const pBiases = Wq.biases();
+
+			const size_t pm0 = m0 / q8_MR, pm1 = (m1 + q8_MR - 1) / q8_MR;
+			const size_t pn0 = n0 / q8_NR, pn1 = (n1 + q8_NR - 1) / q8_NR;
+			alignas(32) ::std::int32_t acc[q8_MR][q8_NR];
+
+			for (size_t pmc = pm0; pmc < pm1; pmc += MCP) {
+				const size_t pmcEnd = ::std::min(pmc + MCP, pm1);
+				for (size_t g0 = 0; g0 < groups; g0 += KCG) {
+					const size_t kg = ::std::min(KCG, groups - g0);
+					const bool bFirst = 0 == g0;
+					for (size_t pn = pn0; pn < pn1; ++pn) {
+						const auto pW = Wq.panel(pn) + g0*q8_NR*q8_KAlign;
+						const size_t nb = ::std::max(n0, pn*q8_NR), ne = ::std::min(n1, pn*q8_NR + q8_NR);
+						for (size_t pm = pmc; pm < pmcEnd; ++pm) {
+							const size_t mb = ::std::max(m0, pm*q8_MR), me = ::std::min(m1, pm*q8_MR + q8_MR);
+							//rows of the panel past m1 aren't needed
+							_tile<KT>(static_cast<unsigned>(me - pm*q8_MR), kg, Aq.panel(pm) + g0*q8_MR*q8_KAlign, pW, acc);
+
+							for (size_t n = nb; n < ne; ++n) {
+								const real_t s = sa*pScales[n];
+								const unsigned j = static_cast<unsigned>(n - pn*q8_NR);
+								real_t*const pC = C + n*ldc;
+								if (bFirst) {
+									const real_t b = pBiases[n];
+									for (size_t m = mb; m < me; ++m) pC[m] = static_cast<real_t>(acc[m - pm*q8_MR][j])*s + b;
+								} else {
+									for (size_t m = mb; m < me; ++m) pC[m] += static_cast<real_t>(acc[m - pm*q8_MR][j])*s;
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+
+		static void run(const activations_t& Aq, const weights_t& Wq, const size_t m0, const size_t m1
+			, const size_t n0, const size_t n1, real_t*const C, const size_t ldc)noexcept
+		{
+#if NNTL_SIMD_AVX2
+			//AVX2 is available on every CPU with AVX-512
+			if (isa::scalar != active_isa()) {
+				run_k<q8_avx2_kernel>(Aq, Wq, m0, m1, n0, n1, C, ldc);
+				return;
+			}
+#endif
+			run_k<q8_scalar_kernel>(Aq, Wq, m0, m1, n0, n1, C, ldc);
+		}
+	};
+
+}
+}
+}
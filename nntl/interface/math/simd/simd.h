@@ -0,0 +1,388 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+//This file contains run-time detection of SIMD instruction sets available to nntl vectorized kernels (see simd/*.h)
+// and thin wrappers over AVX2 and AVX-512 intrinsics that allow to write a kernel once for every instruction set and data type.
+//
+// Vectorized kernels are used only if they are enabled at compile time (set NNTL_CFG_SIMD to 0 to turn them off completely)
+// and the CPU and the OS support the instruction set (the check is done once per process via CPUID/XGETBV). The instruction
+// set to use may also be capped at run-time with simd::set_max_isa() (useful for testing and benchmarking).
+//
+// MSVC allows to use any intrinsics regardless of /arch switch, so all the code paths are always compiled there. Other
+// compilers require the instruction set to be enabled for the whole translation unit (-mavx2 -mfma / -mavx512f), so
+// a code path is compiled only if the corresponding macro is defined by the compiler.
+
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+#if !defined(NNTL_CFG_SIMD)
+#define NNTL_CFG_SIMD 1
+#endif
+
+#if NNTL_CFG_SIMD && (defined(_MSC_VER) || (defined(__AVX2__) && defined(__FMA__)))
+#define NNTL_SIMD_AVX2 1
+#else
+#define NNTL_SIMD_AVX2 0
+#endif
+
+#if NNTL_CFG_SIMD && (defined(_MSC_VER) || defined(__AVX512F__))
+#define NNTL_SIMD_AVX512 1
+#else
+#define NNTL_SIMD_AVX512 0
+#endif
+
+namespace nntl {
+namespace math {
+namespace simd {
+
+	//instruction sets ordered by preference
+	enum class isa : unsigned {
+		scalar = 0,
+		avx2,//AVX2+FMA3
+		avx512//AVX-512F
+	};
+
+	namespace _impl {
+		inline void cpuid(int regs[4], const int leaf, const int subleaf)noexcept {
+#if defined(_MSC_VER)
+			__cpuidex(regs, leaf, subleaf);
+#else
+			unsigned a = 0, b = 0, c = 0, d = 0;
+			__cpuid_count(leaf, subleaf, a, b, c, d);
+			regs[0] = static_cast<int>(a); regs[1] = static_cast<int>(b); regs[2] = static_cast<int>(c); regs[3] = static_cast<int>(d);
+#endif
+		}
+
+		inline ::std::uint64_t xgetbv0()noexcept {
+#if defined(_MSC_VER)
+			return _xgetbv(0);
+#else
+			unsigned lo = 0, hi = 0;
+			__asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+			return (static_cast<::std::uint64_t>(hi) << 32) | lo;
+#endif
+		}
+
+		inline isa detect_isa()noexcept {
+			int r[4];
+			cpuid(r, 0, 0);
+			const int maxLeaf = r[0];
+			if (maxLeaf < 7) return isa::scalar;
+
+			cpuid(r, 1, 0);
+			const bool bOSXSAVE = 0 != (r[2] & (1 << 27)), bAVX = 0 != (r[2] & (1 << 28)), bFMA = 0 != (r[2] & (1 << 12));
+			if (!(bOSXSAVE && bAVX && bFMA)) return isa::scalar;
+
+			const auto xcr0 = xgetbv0();
+			//XMM and YMM states must be enabled by the OS
+			if (0x6 != (xcr0 & 0x6)) return isa::scalar;
+
+			cpuid(r, 7, 0);
+			const bool bAVX2 = 0 != (r[1] & (1 << 5)), bAVX512F = 0 != (r[1] & (1 << 16));
+			if (!bAVX2) return isa::scalar;
+			
+			//opmask, ZMM_Hi256 and Hi16_ZMM states must be enabled by the OS as well
+			return (bAVX512F && 0xe6 == (xcr0 & 0xe6)) ? isa::avx512 : isa::avx2;
+		}
+
+		inline isa& max_isa()noexcept {
+			static isa v = isa::avx512;
+			return v;
+		}
+	}
+
+	//returns the best instruction set supported by the CPU, OS and the compiled code
+	inline isa supported_isa()noexcept {
+		static const isa v = [](){
+			auto r = _impl::detect_isa();
+#if !NNTL_SIMD_AVX512
+			if (isa::avx512 == r) r = isa::avx2;
+#endif
+#if !NNTL_SIMD_AVX2
+			if (isa::avx2 == r) r = isa::scalar;
+#endif
+			return r;
+		}();
+		return v;
+	}
+
+	//returns the instruction set that the vectorized kernels use now
+	inline isa active_isa()noexcept {
+		const auto s = supported_isa(), m = _impl::max_isa();
+		return static_cast<unsigned>(s) < static_cast<unsigned>(m) ? s : m;
+	}
+
+	//caps the instruction set to use. Pass isa::scalar to turn vectorized kernels off. Not thread-safe, call it only
+	// when no math kernels are running
+	inline void set_max_isa(const isa i)noexcept {
+		_impl::max_isa() = i;
+	}
+
+	inline const char* isa_name(const isa i)noexcept {
+		switch (i) {
+		case isa::scalar: return "scalar";
+		case isa::avx2: return "AVX2";
+		case isa::avx512: return "AVX-512";
+		default: NNTL_ASSERT(!"WTF?"); return "unknown";
+		}
+	}
+
+	//returns the CPU brand string (such as "Intel(R) Core(TM) i7-6700K CPU @ 4.00GHz") with leading and trailing
+	// spaces stripped, or an empty string if the CPU doesn't report it
+	inline const char* cpu_brand()noexcept {
+		static const struct _brand {
+			char s[3 * 16 + 1];
+			_brand()noexcept {
+				::std::memset(s, 0, sizeof(s));
+				int r[4];
+				_impl::cpuid(r, static_cast<int>(0x80000000), 0);
+				if (static_cast<unsigned>(r[0]) < 0x80000004u) return;
+				for (int i = 0; i < 3; ++i) {
+					_impl::cpuid(r, static_cast<int>(0x80000002 + i), 0);
+					::std::memcpy(s + 16 * i, r, 16);
+				}
+				size_t e = ::std::strlen(s);
+				while (e > 0 && ' ' == s[e - 1]) s[--e] = 0;
+				size_t b = 0;
+				while (' ' == s[b]) ++b;
+				if (b) ::std::memmove(s, s + b, e - b + 1);
+			}
+		} v;
+		return v.s;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// vtraits<isa, real_t> wraps intrinsics of the instruction set into a common set of static functions.
+	// Every function is elementwise; mask_t is the result of comparisons and is used only by select(m, a, b) == m ? a : b
+	template<isa I, typename RealT> struct vtraits {};
+
+#if NNTL_SIMD_AVX2
+	template<> struct vtraits<isa::avx2, float> {
+		typedef float real_t;
+		typedef __m256 vec_t;
+		typedef __m256 mask_t;
+		static constexpr unsigned width = 8;
+
+		static nntl_force_inline vec_t load(const real_t* p)noexcept { return _mm256_loadu_ps(p); }
+		static nntl_force_inline void store(real_t* p, const vec_t v)noexcept { _mm256_storeu_ps(p, v); }
+		static nntl_force_inline vec_t set1(const real_t v)noexcept { return _mm256_set1_ps(v); }
+
+		static nntl_force_inline vec_t add(const vec_t a, const vec_t b)noexcept { return _mm256_add_ps(a, b); }
+		static nntl_force_inline vec_t sub(const vec_t a, const vec_t b)noexcept { return _mm256_sub_ps(a, b); }
+		static nntl_force_inline vec_t mul(const vec_t a, const vec_t b)noexcept { return _mm256_mul_ps(a, b); }
+		static nntl_force_inline vec_t div(const vec_t a, const vec_t b)noexcept { return _mm256_div_ps(a, b); }
+		//a*b+c
+		static nntl_force_inline vec_t fmadd(const vec_t a, const vec_t b, const vec_t c)noexcept { return _mm256_fmadd_ps(a, b, c); }
+		//-(a*b)+c
+		static nntl_force_inline vec_t fnmadd(const vec_t a, const vec_t b, const vec_t c)noexcept { return _mm256_fnmadd_ps(a, b, c); }
+		static nntl_force_inline vec_t min(const vec_t a, const vec_t b)noexcept { return _mm256_min_ps(a, b); }
+		static nntl_force_inline vec_t max(const vec_t a, const vec_t b)noexcept { return _mm256_max_ps(a, b); }
+		static nntl_force_inline vec_t abs(const vec_t a)noexcept { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+		static nntl_force_inline vec_t neg(const vec_t a)noexcept { return _mm256_xor_ps(_mm256_set1_ps(-0.f), a); }
+		static nntl_force_inline vec_t floor(const vec_t a)noexcept { return _mm256_floor_ps(a); }
+
+		static nntl_force_inline mask_t lt(const vec_t a, const vec_t b)noexcept { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+		static nntl_force_inline mask_t gt(const vec_t a, const vec_t b)noexcept { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+		//true if a or b is NaN
+		static nntl_force_inline mask_t unord(const vec_t a, const vec_t b)noexcept { return _mm256_cmp_ps(a, b, _CMP_UNORD_Q); }
+		static nntl_force_inline vec_t select(const mask_t m, const vec_t a, const vec_t b)noexcept { return _mm256_blendv_ps(b, a, m); }
+		//bit i of the result is set iff the lane i of m is set
+		static nntl_force_inline unsigned bits(const mask_t m)noexcept { return static_cast<unsigned>(_mm256_movemask_ps(m)); }
+		//gathers tbl[idx[i]] for an integral-valued non-negative idx
+		static nntl_force_inline vec_t lut(const real_t* tbl, const vec_t idx)noexcept { return _mm256_i32gather_ps(tbl, _mm256_cvttps_epi32(idx), 4); }
+
+		//2^n for an integral-valued n in [-126, 127]
+		static nntl_force_inline vec_t pow2n(const vec_t n)noexcept {
+			return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23));
+		}
+		//for a positive normal x returns m in [.5, 1) and e such that x = m*2^e
+		static nntl_force_inline vec_t frexp(const vec_t x, vec_t& e)noexcept {
+			const __m256i xi = _mm256_castps_si256(x);
+			e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(xi, 23), _mm256_set1_epi32(126)));
+			return _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(xi, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f000000)));
+		}
+	};
+
+	template<> struct vtraits<isa::avx2, double> {
+		typedef double real_t;
+		typedef __m256d vec_t;
+		typedef __m256d mask_t;
+		static constexpr unsigned width = 4;
+
+		static nntl_force_inline vec_t load(const real_t* p)noexcept { return _mm256_loadu_pd(p); }
+		static nntl_force_inline void store(real_t* p, const vec_t v)noexcept { _mm256_storeu_pd(p, v); }
+		static nntl_force_inline vec_t set1(const real_t v)noexcept { return _mm256_set1_pd(v); }
+
+		static nntl_force_inline vec_t add(const vec_t a, const vec_t b)noexcept { return _mm256_add_pd(a, b); }
+		static nntl_force_inline vec_t sub(const vec_t a, const vec_t b)noexcept { return _mm256_sub_pd(a, b); }
+		static nntl_force_inline vec_t mul(const vec_t a, const vec_t b)noexcept { return _mm256_mul_pd(a, b); }
+		static nntl_force_inline vec_t div(const vec_t a, const vec_t b)noexcept { return _mm256_div_pd(a, b); }
+		static nntl_force_inline vec_t fmadd(const vec_t a, const vec_t b, const vec_t c)noexcept { return _mm256_fmadd_pd(a, b, c); }
+		static nntl_force_inline vec_t fnmadd(const vec_t a, const vec_t b, const vec_t c)noexcept { return _mm256_fnmadd_pd(a, b, c); }
+		static nntl_force_inline vec_t min(const vec_t a, const vec_t b)noexcept { return _mm256_min_pd(a, b); }
+		static nntl_force_inline vec_t max(const vec_t a, const vec_t b)noexcept { return _mm256_max_pd(a, b); }
+		static nntl_force_inline vec_t abs(const vec_t a)noexcept { return _mm256_andnot_pd(_mm256_set1_pd(-0.), a); }
+		static nntl_force_inline vec_t neg(const vec_t a)noexcept { return _mm256_xor_pd(_mm256_set1_pd(-0.), a); }
+		static nntl_force_inline vec_t floor(const vec_t a)noexcept { return _mm256_floor_pd(a); }
+
+		static nntl_force_inline mask_t lt(const vec_t a, const vec_t b)noexcept { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+		static nntl_force_inline mask_t gt(const vec_t a, const vec_t b)noexcept { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+		//true if a or b is NaN
+		static nntl_force_inline mask_t unord(const vec_t a, const vec_t b)noexcept { return _mm256_cmp_pd(a, b, _CMP_UNORD_Q); }
+		static nntl_force_inline vec_t select(const mask_t m, const vec_t a, const vec_t b)noexcept { return _mm256_blendv_pd(b, a, m); }
+		static nntl_force_inline unsigned bits(const mask_t m)noexcept { return static_cast<unsigned>(_mm256_movemask_pd(m)); }
+		static nntl_force_inline vec_t lut(const real_t* tbl, const vec_t idx)noexcept { return _mm256_i32gather_pd(tbl, _mm256_cvttpd_epi32(idx), 8); }
+
+		//2^n for an integral-valued n in [-1022, 1023]. AVX2 has no double->int64 conversion, so using the 1.5*2^52 trick
+		static nntl_force_inline vec_t pow2n(const vec_t n)noexcept {
+			const __m256d magic = _mm256_set1_pd(6755399441055744.0);
+			const __m256i ni = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(n, magic)), _mm256_castpd_si256(magic));
+			return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(ni, _mm256_set1_epi64x(1023)), 52));
+		}
+		static nntl_force_inline vec_t frexp(const vec_t x, vec_t& e)noexcept {
+			const __m256i xi = _mm256_castpd_si256(x);
+			//exponent bits are placed into the mantissa of 2^52 to convert it to double
+			const __m256d two52 = _mm256_set1_pd(4503599627370496.0);
+			e = _mm256_sub_pd(_mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(xi, 52), _mm256_castpd_si256(two52))), two52)
+				, _mm256_set1_pd(1022.));
+			return _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(xi, _mm256_set1_epi64x(0x000fffffffffffffLL))
+				, _mm256_set1_epi64x(0x3fe0000000000000LL)));
+		}
+	};
+#endif //NNTL_SIMD_AVX2
+
+#if NNTL_SIMD_AVX512
+	template<> struct vtraits<isa::avx512, float> {
+		typedef float real_t;
+		typedef __m512 vec_t;
+		typedef __mmask16 mask_t;
+		static constexpr unsigned width = 16;
+
+		static nntl_force_inline vec_t load(const real_t* p)noexcept { return _mm512_loadu_ps(p); }
+		static nntl_force_inline void store(real_t* p, const vec_t v)noexcept { _mm512_storeu_ps(p, v); }
+		static nntl_force_inline vec_t set1(const real_t v)noexcept { return _mm512_set1_ps(v); }
+
+		static nntl_force_inline vec_t add(const vec_t a, const vec_t b)noexcept { return _mm512_add_ps(a, b); }
+		static nntl_force_inline vec_t sub(const vec_t a, const vec_t b)noexcept { return _mm512_sub_ps(a, b); }
+		static nntl_force_inline vec_t mul(const vec_t a, const vec_t b)noexcept { return _mm512_mul_ps(a, b); }
+		static nntl_force_inline vec_t div(const vec_t a, const vec_t b)noexcept { return _mm512_div_ps(a, b); }
+		static nntl_force_inline vec_t fmadd(const vec_t a, const vec_t b, const vec_t c)noexcept { return _mm512_fmadd_ps(a, b, c); }
+		static nntl_force_inline vec_t fnmadd(const vec_t a, const vec_t b, const vec_t c)noexcept { return _mm512_fnmadd_ps(a, b, c); }
+		static nntl_force_inline vec_t min(const vec_t a, const vec_t b)noexcept { return _mm512_min_ps(a, b); }
+		static nntl_force_inline vec_t max(const vec_t a, const vec_t b)noexcept { return _mm512_max_ps(a, b); }
+		static nntl_force_inline vec_t abs(const vec_t a)noexcept {
+			return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a), _mm512_set1_epi32(0x7fffffff)));
+		}
+		static nntl_force_inline vec_t neg(const vec_t a)noexcept {
+			return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), _mm512_set1_epi32(0x80000000)));
+		}
+		static nntl_force_inline vec_t floor(const vec_t a)noexcept { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+
+		static nntl_force_inline mask_t lt(const vec_t a, const vec_t b)noexcept { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+		static nntl_force_inline mask_t gt(const vec_t a, const vec_t b)noexcept { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+		//true if a or b is NaN
+		static nntl_force_inline mask_t unord(const vec_t a, const vec_t b)noexcept { return _mm512_cmp_ps_mask(a, b, _CMP_UNORD_Q); }
+		static nntl_force_inline vec_t select(const mask_t m, const vec_t a, const vec_t b)noexcept { return _mm512_mask_blend_ps(m, b, a); }
+		static nntl_force_inline unsigned bits(const mask_t m)noexcept { return static_cast<unsigned>(m); }
+		static nntl_force_inline vec_t lut(const real_t* tbl, const vec_t idx)noexcept { return _mm512_i32gather_ps(_mm512_cvttps_epi32(idx), tbl, 4); }
+
+		static nntl_force_inline vec_t pow2n(const vec_t n)noexcept {
+			return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127)), 23));
+		}
+		static nntl_force_inline vec_t frexp(const vec_t x, vec_t& e)noexcept {
+			const __m512i xi = _mm512_castps_si512(x);
+			e = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(xi, 23), _mm512_set1_epi32(126)));
+			return _mm512_castsi512_ps(_mm512_or_si512(_mm512_and_si512(xi, _mm512_set1_epi32(0x007fffff)), _mm512_set1_epi32(0x3f000000)));
+		}
+	};
+
+	template<> struct vtraits<isa::avx512, double> {
+		typedef double real_t;
+		typedef __m512d vec_t;
+		typedef __mmask8 mask_t;
+		static constexpr unsigned width = 8;
+
+		static nntl_force_inline vec_t load(const real_t* p)noexcept { return _mm512_loadu_pd(p); }
+		static nntl_force_inline void store(real_t* p, const vec_t v)noexcept { _mm512_storeu_pd(p, v); }
+		static nntl_force_inline vec_t set1(const real_t v)noexcept { return _mm512_set1_pd(v); }
+
+		static nntl_force_inline vec_t add(const vec_t a, const vec_t b)noexcept { return _mm512_add_pd(a, b); }
+		static nntl_force_inline vec_t sub(const vec_t a, const vec_t b)noexcept { return _mm512_sub_pd(a, b); }
+		static nntl_force_inline vec_t mul(const vec_t a, const vec_t b)noexcept { return _mm512_mul_pd(a, b); }
+		static nntl_force_inline vec_t div(const vec_t a, const vec_t b)noexcept { return _mm512_div_pd(a, b); }
+		static nntl_force_inline vec_t fmadd(const vec_t a, const vec_t b, const vec_t c)noexcept { return _mm512_fmadd_pd(a, b, c); }
+		static nntl_force_inline vec_t fnmadd(const vec_t a, const vec_t b, const vec_t c)noexcept { return _mm512_fnmadd_pd(a, b, c); }
+		static nntl_force_inline vec_t min(const vec_t a, const vec_t b)noexcept { return _mm512_min_pd(a, b); }
+		static nntl_force_inline vec_t max(const vec_t a, const vec_t b)noexcept { return _mm512_max_pd(a, b); }
+		static nntl_force_inline vec_t abs(const vec_t a)noexcept {
+			return _mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(a), _mm512_set1_epi64(0x7fffffffffffffffLL)));
+		}
+		static nntl_force_inline vec_t neg(const vec_t a)noexcept {
+			return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(a), _mm512_set1_epi64(static_cast<long long>(0x8000000000000000ULL))));
+		}
+		static nntl_force_inline vec_t floor(const vec_t a)noexcept { return _mm512_roundscale_pd(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+
+		static nntl_force_inline mask_t lt(const vec_t a, const vec_t b)noexcept { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+		static nntl_force_inline mask_t gt(const vec_t a, const vec_t b)noexcept { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+		//true if a or b is NaN
+		static nntl_force_inline mask_t unord(const vec_t a, const vec_t b)noexcept { return _mm512_cmp_pd_mask(a, b, _CMP_UNORD_Q); }
+		static nntl_force_inline vec_t select(const mask_t m, const vec_t a, const vec_t b)noexcept { return _mm512_mask_blend_pd(m, b, a); }
+		static nntl_force_inline unsigned bits(const mask_t m)noexcept { return static_cast<unsigned>(m); }
+		static nntl_force_inline vec_t lut(const real_t* tbl, const vec_t idx)noexcept { return _mm512_i32gather_pd(_mm512_cvttpd_epi32(idx), tbl, 8); }
+
+		static nntl_force_inline vec_t pow2n(const vec_t n)noexcept {
+			const __m512d magic = _mm512_set1_pd(6755399441055744.0);
+			const __m512i ni = _mm512_sub_epi64(_mm512_castpd_si512(_mm512_add_pd(n, magic)), _mm512_castpd_si512(magic));
+			return _mm512_castsi512_pd(_mm512_slli_epi64(_mm512_add_epi64(ni, _mm512_set1_epi64(1023)), 52));
+		}
+		static nntl_force_inline vec_t frexp(const vec_t x, vec_t& e)noexcept {
+			const __m512i xi = _mm512_castpd_si512(x);
+			const __m512d two52 = _mm512_set1_pd(4503599627370496.0);
+			e = _mm512_sub_pd(_mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(_mm512_srli_epi64(xi, 52), _mm512_castpd_si512(two52))), two52)
+				, _mm512_set1_pd(1022.));
+			return _mm512_castsi512_pd(_mm512_or_si512(_mm512_and_si512(xi, _mm512_set1_epi64(0x000fffffffffffffLL))
+				, _mm512_set1_epi64(0x3fe0000000000000LL)));
+		}
+	};
+#endif //NNTL_SIMD_AVX512
+
+}
+}
+}
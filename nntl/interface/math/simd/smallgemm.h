@@ -0,0 +1,282 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+//Matrix multiplication C = A * W' for a small number of rows of A (a single sample or a tiny batch during inference).
+// A generic gemm has to pack both operands on every call, that's a waste when A has just a few rows and W (the weights of
+// a layer) is the same for many calls. Here W is packed once into panels of P neurons, each panel stores K rows of P
+// contiguous elements (i.e. a panel is a transposed slice of W), so the kernel reads weights strictly sequentially.
+// The kernel keeps R rows x P neurons of C in registers and broadcasts elements of A, which are contiguous for R rows of
+// a column-major A. R is a compile time constant for every possible tail of rows.
+// The code is single threaded by design: for a tiny batch the cost of waking up worker threads is comparable to the
+// cost of the multiplication itself.
+
+#include <algorithm>
+#include "gemm.h"
+
+namespace nntl {
+namespace math {
+namespace simd {
+
+	//NV is the number of vectors in a panel of neurons (P = NV*width), RB - the maximum number of rows processed at once.
+	// RB*NV accumulators + NV vectors of W + a broadcasted element of A must fit into registers.
+	template<typename VT> struct small_gemm_blocking {
+		static constexpr unsigned NV = 4, RB = 2;
+	};
+#if NNTL_SIMD_AVX2
+	template<typename RealT> struct small_gemm_blocking<vtraits<isa::avx2, RealT>> {
+		static constexpr unsigned NV = 4, RB = 2;
+	};
+#endif
+#if NNTL_SIMD_AVX512
+	template<typename RealT> struct small_gemm_blocking<vtraits<isa::avx512, RealT>> {
+		static constexpr unsigned NV = 4, RB = 4;
+	};
+#endif
+
+	//weights W (N x K, column-major) packed for small_gemm<>. The layout depends on the instruction set that was active
+	// during packing, so the packed weights remember it
+	template<typename RealT>
+	class small_gemm_weights {
+	public:
+		typedef RealT real_t;
+
+	protected:
+		real_t* m_p;
+		size_t m_capacity, m_n, m_k;
+		unsigned m_panel;
+		isa m_isa;
+
+	public:
+		~small_gemm_weights()noexcept { _free(); }
+		small_gemm_weights()noexcept : m_p(nullptr), m_capacity(0), m_n(0), m_k(0), m_panel(0), m_isa(isa::scalar) {}
+
+		small_gemm_weights(const small_gemm_weights&) = delete;
+		small_gemm_weights& operator=(const small_gemm_weights&) = delete;
+
+		small_gemm_weights(small_gemm_weights&& o)noexcept : m_p(o.m_p), m_capacity(o.m_capacity), m_n(o.m_n), m_k(o.m_k)
+			, m_panel(o.m_panel), m_isa(o.m_isa)
+		{
+			o.m_p = nullptr;
+			o.m_capacity = o.m_n = o.m_k = 0;
+		}
+
+		bool empty()const noexcept { return 0 == m_n; }
+		size_t neurons()const noexcept { return m_n; }
+		size_t inputs()const noexcept { return m_k; }
+		unsigned panel()const noexcept { return m_panel; }
+		isa packed_isa()const noexcept { return m_isa; }
+		const real_t* data()const noexcept { return m_p; }
+
+		//forgets the content, but keeps the memory for the next pack()
+		void reset()noexcept { m_n = m_k = 0; }
+
+		void clear()noexcept {
+			_free();
+			reset();
+		}
+
+		//packs N x K column-major matrix W with leading dimension ldw into panels of P neurons. Returns false if failed
+		// to allocate the memory
+		bool pack(const isa i, const unsigned P, const real_t*const W, const size_t N, const size_t K, const size_t ldw)noexcept {
+			NNTL_ASSERT(W && N && K && P && ldw >= N);
+			const size_t panels = (N + P - 1) / P, need = panels*P*K;
+			if (need > m_capacity) {
+				_free();
+				m_p = static_cast<real_t*>(_mm_malloc(need * sizeof(real_t), 64));
+				if (!m_p) {
+					reset();
+					return false;
+				}
+				m_capacity = need;
+			}
+
+			real_t* pD = m_p;
+			for (size_t p0 = 0; p0 < N; p0 += P) {
+				const size_t pn = ::std::min(size_t(P), N - p0);
+				const real_t* pW = W + p0;
+				for (size_t k = 0; k < K; ++k) {
+					size_t j = 0;
+					for (; j < pn; ++j) pD[j] = pW[j];
+					for (; j < P; ++j) pD[j] = real_t(0);
+					pD += P;
+					pW += ldw;
+				}
+			}
+			m_n = N;
+			m_k = K;
+			m_panel = P;
+			m_isa = i;
+			return true;
+		}
+
+	protected:
+		void _free()noexcept {
+			if (m_p) {
+				_mm_free(m_p);
+				m_p = nullptr;
+			}
+			m_capacity = 0;
+		}
+	};
+
+	template<typename VT>
+	struct small_gemm_kernels {
+		typedef typename VT::real_t real_t;
+		typedef typename VT::vec_t vec_t;
+		typedef small_gemm_blocking<VT> blocking_t;
+
+		static constexpr unsigned W = VT::width, NV = blocking_t::NV, P = NV*W, RB = blocking_t::RB;
+
+		//C(R x pn) = A(R x K) * Wp(K x P)
+		template<unsigned R>
+		static nntl_force_inline void block(const size_t K, const real_t* pA, const size_t lda, const real_t* pW
+			, real_t*const C, const size_t ldc, const size_t pn)noexcept
+		{
+			vec_t acc[R][NV];
+			for (unsigned r = 0; r < R; ++r) {
+				for (unsigned v = 0; v < NV; ++v) acc[r][v] = VT::set1(real_t(0));
+			}
+			size_t k = 0;
+			if (1 == R) {
+				//a single row has only NV dependency chains, that's too few to hide the latency of fmadd. Even and odd k
+				// go to separate accumulators
+				vec_t acc2[NV];
+				for (unsigned v = 0; v < NV; ++v) acc2[v] = VT::set1(real_t(0));
+				for (; k + 2 <= K; k += 2) {
+					const vec_t a = VT::set1(pA[0]), a2 = VT::set1(pA[lda]);
+					for (unsigned v = 0; v < NV; ++v) {
+						acc[0][v] = VT::fmadd(VT::load(pW + v*W), a, acc[0][v]);
+						acc2[v] = VT::fmadd(VT::load(pW + P + v*W), a2, acc2[v]);
+					}
+					pA += 2 * lda;
+					pW += 2 * P;
+				}
+				for (unsigned v = 0; v < NV; ++v) acc[0][v] = VT::add(acc[0][v], acc2[v]);
+			}
+			for (; k < K; ++k) {
+				vec_t w[NV];
+				for (unsigned v = 0; v < NV; ++v) w[v] = VT::load(pW + v*W);
+				for (unsigned r = 0; r < R; ++r) {
+					const vec_t a = VT::set1(pA[r]);
+					for (unsigned v = 0; v < NV; ++v) acc[r][v] = VT::fmadd(w[v], a, acc[r][v]);
+				}
+				pA += lda;
+				pW += P;
+			}
+
+			if (1 == R && 1 == ldc && P == pn) {
+				for (unsigned v = 0; v < NV; ++v) VT::store(C + v*W, acc[0][v]);
+			} else {
+				//C is column-major, so a row of C has the stride ldc
+				real_t tmp[R*P];
+				for (unsigned r = 0; r < R; ++r) {
+					for (unsigned v = 0; v < NV; ++v) VT::store(tmp + r*P + v*W, acc[r][v]);
+				}
+				for (size_t j = 0; j < pn; ++j) {
+					const auto pC = C + j*ldc;
+					for (unsigned r = 0; r < R; ++r) pC[r] = tmp[r*P + j];
+				}
+			}
+		}
+
+		//processes the last rCnt < RB rows with a kernel specialized for exactly rCnt rows
+		template<unsigned R>
+		static void block_tail(const unsigned rCnt, const size_t K, const real_t* pA, const size_t lda, const real_t* pW
+			, real_t*const C, const size_t ldc, const size_t pn)noexcept
+		{
+			NNTL_ASSERT(rCnt > 0 && rCnt <= R);
+			if (R == rCnt || 1 == R) {
+				block<R>(K, pA, lda, pW, C, ldc, pn);
+			} else block_tail<(R > 1 ? R - 1 : 1)>(rCnt, K, pA, lda, pW, C, ldc, pn);
+		}
+
+		//C(M x N) = A(M x K) * W'. A and C are column-major
+		static void run(const size_t M, const real_t*const A, const size_t lda, const small_gemm_weights<real_t>& Wp
+			, real_t*const C, const size_t ldc)noexcept
+		{
+			NNTL_ASSERT(Wp.panel() == P);
+			const size_t N = Wp.neurons(), K = Wp.inputs();
+			const real_t* pW = Wp.data();
+			for (size_t p0 = 0; p0 < N; p0 += P) {
+				const size_t pn = ::std::min(size_t(P), N - p0);
+				const auto pC = C + p0*ldc;
+				size_t i = 0;
+				for (; i + RB <= M; i += RB) block<RB>(K, A + i, lda, pW, pC + i, ldc, pn);
+				if (i < M) block_tail<RB>(static_cast<unsigned>(M - i), K, A + i, lda, pW, pC + i, ldc, pn);
+				pW += P*K;
+			}
+		}
+	};
+
+	//dispatches a call to small_gemm_kernels<> of the active instruction set (for packing) or of the instruction set
+	// the weights were packed for (for the multiplication)
+	template<typename RealT>
+	struct small_gemm {
+		typedef RealT real_t;
+		typedef small_gemm_weights<real_t> weights_t;
+
+		template<typename F>
+		static nntl_force_inline auto _run(const isa i, F&& f)noexcept {
+			switch (i) {
+#if NNTL_SIMD_AVX512
+			case isa::avx512:
+				return f(small_gemm_kernels<vtraits<isa::avx512, real_t>>());
+#endif
+#if NNTL_SIMD_AVX2
+			case isa::avx2:
+				return f(small_gemm_kernels<vtraits<isa::avx2, real_t>>());
+#endif
+			default:
+				return f(small_gemm_kernels<scalar_vtraits<real_t>>());
+			}
+		}
+
+		//packs N x K matrix W for the active instruction set. Returns false if failed to allocate the memory
+		static bool pack(weights_t& Wp, const real_t*const W, const size_t N, const size_t K, const size_t ldw)noexcept {
+			const auto i = active_isa();
+			return _run(i, [&](auto k) { return Wp.pack(i, decltype(k)::P, W, N, K, ldw); });
+		}
+
+		//C(M x N) = A(M x K) * W'
+		static void run(const size_t M, const real_t*const A, const size_t lda, const weights_t& Wp
+			, real_t*const C, const size_t ldc)noexcept
+		{
+			NNTL_ASSERT(!Wp.empty());
+			_run(Wp.packed_isa(), [&](auto k) { decltype(k)::run(M, A, lda, Wp, C, ldc); });
+		}
+	};
+
+}
+}
+}
@@ -0,0 +1,251 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+//vectorized elementary functions over vtraits<> (see simd.h).
+// Every function has two accuracy policies:
+// - vmath_accurate: polynomial approximations follow the Cephes library (by Stephen L. Moshier). The error is within
+//		a couple of ULPs of ::std:: counterparts wherever the result isn't saturated (see below).
+// - vmath_fast: shorter polynomials (fitted over the reduced argument range) that give relative error below 1e-4
+//		(the worst case is about 3e-5). Good enough for activations and losses and 2-3 times cheaper.
+// Special values are handled as follows: exp() and expm1() saturate to 0 (-1) and +inf outside [exp_lo, exp_hi].
+// The range is a bit narrower than the representable one: exp(x) is +inf for x in (88.02, 88.72] (float) and
+// (709, 709.78] (double) where the true value is still finite, and is 0 for x < -87.34 (float) and x < -708 (double)
+// where ::std::exp() returns a denormal. NaN is passed through by every function. log() expects its argument to be a positive normal number, log1p() - a number greater than -1 such that 1+x is a
+// normal number (it's the caller's responsibility).
+
+#include <limits>
+#include <type_traits>
+#include "simd.h"
+
+//if NNTL_CFG_FAST_VMATH is set to 1, vectorized kernels of MathN use vmath_fast policy instead of vmath_accurate
+#ifndef NNTL_CFG_FAST_VMATH
+#define NNTL_CFG_FAST_VMATH 0
+#endif
+
+namespace nntl {
+namespace math {
+namespace simd {
+
+	struct vmath_accurate {};
+	struct vmath_fast {};
+
+	typedef ::std::conditional_t<NNTL_CFG_FAST_VMATH, vmath_fast, vmath_accurate> vmath_default_t;
+
+	namespace _impl {
+		template<typename RealT> struct _vmath_consts {};
+		template<> struct _vmath_consts<float> {
+			//limits are chosen so that n = floor(x*log2e + .5) stays within [-126, 127] and 2^n is a normal number.
+			//exp(x) for x in (exp_hi, ln(FLT_MAX)] is saturated to inf, the price of a single pow2n() scaling
+			static constexpr float exp_hi = 88.02f, exp_lo = -87.3365447504f, log2e = 1.44269504088896341f;
+			//ln(2) == hi + lo, hi has only a few significant bits, so n*hi is exact
+			static constexpr float exp_ln2_hi = 0.693359375f, exp_ln2_lo = -2.12194440e-4f;
+			static constexpr float log_ln2_hi = 0.693359375f, log_ln2_lo = -2.12194440e-4f;
+			static constexpr float sqrt_half = 0.707106781186547524f;
+		};
+		template<> struct _vmath_consts<double> {
+			static constexpr double exp_hi = 709., exp_lo = -708., log2e = 1.4426950408889634073599;
+			static constexpr double exp_ln2_hi = 6.93145751953125E-1, exp_ln2_lo = 1.42860682030941723212E-6;
+			static constexpr double log_ln2_hi = 0.693359375, log_ln2_lo = -2.121944400546905827679e-4;
+			static constexpr double sqrt_half = 0.70710678118654752440;
+		};
+
+		//polynomial parts of the functions over the reduced argument ranges:
+		// expm1_r(r) == exp(r)-1 for |r| <= ln(2)/2
+		// log1p_tail(m, m^2) == log(1+m) - m + m^2/2 for m in [sqrt(.5)-1, sqrt(2)-1)
+		template<typename VT, typename AccT, typename RealT = typename VT::real_t> struct _vpoly {};
+
+		template<typename VT> struct _vpoly<VT, vmath_accurate, float> {
+			typedef typename VT::vec_t vec_t;
+
+			static nntl_force_inline vec_t expm1_r(const vec_t r)noexcept {
+				vec_t p = VT::set1(1.9875691500E-4f);
+				p = VT::fmadd(p, r, VT::set1(1.3981999507E-3f));
+				p = VT::fmadd(p, r, VT::set1(8.3334519073E-3f));
+				p = VT::fmadd(p, r, VT::set1(4.1665795894E-2f));
+				p = VT::fmadd(p, r, VT::set1(1.6666665459E-1f));
+				p = VT::fmadd(p, r, VT::set1(5.0000001201E-1f));
+				return VT::fmadd(p, VT::mul(r, r), r);
+			}
+
+			static nntl_force_inline vec_t log1p_tail(const vec_t m, const vec_t z)noexcept {
+				vec_t p = VT::set1(7.0376836292E-2f);
+				p = VT::fmadd(p, m, VT::set1(-1.1514610310E-1f));
+				p = VT::fmadd(p, m, VT::set1(1.1676998740E-1f));
+				p = VT::fmadd(p, m, VT::set1(-1.2420140846E-1f));
+				p = VT::fmadd(p, m, VT::set1(1.4249322787E-1f));
+				p = VT::fmadd(p, m, VT::set1(-1.6668057665E-1f));
+				p = VT::fmadd(p, m, VT::set1(2.0000714765E-1f));
+				p = VT::fmadd(p, m, VT::set1(-2.4999993993E-1f));
+				p = VT::fmadd(p, m, VT::set1(3.3333331174E-1f));
+				return VT::mul(VT::mul(p, m), z);
+			}
+		};
+
+		template<typename VT> struct _vpoly<VT, vmath_accurate, double> {
+			typedef typename VT::vec_t vec_t;
+
+			//Pade approximation exp(r) - 1 = 2*r*P(r^2)/(Q(r^2) - r*P(r^2))
+			static nntl_force_inline vec_t expm1_r(const vec_t r)noexcept {
+				const vec_t rr = VT::mul(r, r);
+				vec_t p = VT::set1(1.26177193074810590878E-4);
+				p = VT::fmadd(p, rr, VT::set1(3.02994407707441961300E-2));
+				p = VT::fmadd(p, rr, VT::set1(9.99999999999999999910E-1));
+				p = VT::mul(p, r);
+
+				vec_t q = VT::set1(3.00198505138664455042E-6);
+				q = VT::fmadd(q, rr, VT::set1(2.52448340349684104192E-3));
+				q = VT::fmadd(q, rr, VT::set1(2.27265548208155028766E-1));
+				q = VT::fmadd(q, rr, VT::set1(2.00000000000000000009E0));
+
+				return VT::div(VT::add(p, p), VT::sub(q, p));
+			}
+
+			//m^3*P(m)/Q(m)
+			static nntl_force_inline vec_t log1p_tail(const vec_t m, const vec_t z)noexcept {
+				vec_t p = VT::set1(1.01875663804580931796E-4);
+				p = VT::fmadd(p, m, VT::set1(4.97494994976747001425E-1));
+				p = VT::fmadd(p, m, VT::set1(4.70579119878881725854E0));
+				p = VT::fmadd(p, m, VT::set1(1.44989225341610930846E1));
+				p = VT::fmadd(p, m, VT::set1(1.79368678507819816313E1));
+				p = VT::fmadd(p, m, VT::set1(7.70838733755885391666E0));
+
+				vec_t q = VT::add(m, VT::set1(1.12873587189167450590E1));
+				q = VT::fmadd(q, m, VT::set1(4.52279145837532221105E1));
+				q = VT::fmadd(q, m, VT::set1(8.29875266912776603211E1));
+				q = VT::fmadd(q, m, VT::set1(7.11544750618563894466E1));
+				q = VT::fmadd(q, m, VT::set1(2.31251620126765340583E1));
+
+				return VT::mul(m, VT::div(VT::mul(z, p), q));
+			}
+		};
+
+		//the same (least squares fitted) polynomials for both float and double
+		template<typename VT, typename RealT> struct _vpoly<VT, vmath_fast, RealT> {
+			typedef typename VT::vec_t vec_t;
+
+			static nntl_force_inline vec_t expm1_r(const vec_t r)noexcept {
+				vec_t p = VT::set1(RealT(4.0917402900507056E-2));
+				p = VT::fmadd(p, r, VT::set1(RealT(1.6753975960310585E-1)));
+				p = VT::fmadd(p, r, VT::set1(RealT(5.000893097488001E-1)));
+				return VT::fmadd(p, VT::mul(r, r), r);
+			}
+
+			static nntl_force_inline vec_t log1p_tail(const vec_t m, const vec_t z)noexcept {
+				vec_t p = VT::set1(RealT(-1.4776995615968305E-1));
+				p = VT::fmadd(p, m, VT::set1(RealT(2.1891667338011622E-1)));
+				p = VT::fmadd(p, m, VT::set1(RealT(-2.523527146556837E-1)));
+				p = VT::fmadd(p, m, VT::set1(RealT(3.327530382405818E-1)));
+				return VT::mul(VT::mul(p, m), z);
+			}
+		};
+
+		template<typename VT, typename AccT>
+		struct _vmath {
+			typedef typename VT::real_t real_t;
+			typedef typename VT::vec_t vec_t;
+			typedef _vmath_consts<real_t> C;
+			typedef _vpoly<VT, AccT> P;
+
+			//x == n*ln(2) + r, returns expm1(r) and n
+			static nntl_force_inline vec_t _exp_reduced(const vec_t x, vec_t& n)noexcept {
+				const vec_t xc = VT::min(VT::max(x, VT::set1(C::exp_lo)), VT::set1(C::exp_hi));
+				n = VT::floor(VT::fmadd(xc, VT::set1(C::log2e), VT::set1(real_t(.5))));
+				vec_t r = VT::fnmadd(n, VT::set1(C::exp_ln2_hi), xc);
+				r = VT::fnmadd(n, VT::set1(C::exp_ln2_lo), r);
+				return P::expm1_r(r);
+			}
+
+			//min/max of _exp_reduced() replace NaN with a clamp value, so NaN must be blended back
+			static nntl_force_inline vec_t _saturate(const vec_t x, const vec_t res, const real_t lowVal)noexcept {
+				return VT::select(VT::lt(x, VT::set1(C::exp_lo)), VT::set1(lowVal)
+					, VT::select(VT::gt(x, VT::set1(C::exp_hi)), VT::set1(::std::numeric_limits<real_t>::infinity())
+						, VT::select(VT::unord(x, x), x, res)));
+			}
+
+			static nntl_force_inline vec_t exp(const vec_t x)noexcept {
+				vec_t n;
+				const vec_t em = _exp_reduced(x, n);
+				return _saturate(x, VT::mul(VT::add(em, VT::set1(real_t(1.))), VT::pow2n(n)), real_t(0.));
+			}
+
+			//exp(x)-1 == 2^n*expm1(r) + (2^n - 1). For n==0 it's just expm1(r), so there's no cancellation near zero
+			static nntl_force_inline vec_t expm1(const vec_t x)noexcept {
+				vec_t n;
+				const vec_t em = _exp_reduced(x, n);
+				const vec_t p2 = VT::pow2n(n);
+				return _saturate(x, VT::fmadd(p2, em, VT::sub(p2, VT::set1(real_t(1.)))), real_t(-1.));
+			}
+
+			static nntl_force_inline vec_t log(const vec_t x)noexcept {
+				vec_t e;
+				vec_t m = VT::frexp(x, e);
+				//m in [sqrt(.5), sqrt(2)), m = m-1
+				const auto bSmall = VT::lt(m, VT::set1(C::sqrt_half));
+				e = VT::select(bSmall, VT::sub(e, VT::set1(real_t(1.))), e);
+				m = VT::sub(VT::select(bSmall, VT::add(m, m), m), VT::set1(real_t(1.)));
+
+				const vec_t z = VT::mul(m, m);
+				vec_t y = P::log1p_tail(m, z);
+				y = VT::fmadd(e, VT::set1(C::log_ln2_lo), y);
+				y = VT::fnmadd(z, VT::set1(real_t(.5)), y);
+				//frexp() of NaN gives a finite mantissa, so NaN must be blended back
+				return VT::select(VT::unord(x, x), x, VT::fmadd(e, VT::set1(C::log_ln2_hi), VT::add(m, y)));
+			}
+
+			//log(1+x) == log(u) + (x-(u-1))/u, where u = 1+x rounded. The second term compensates the rounding error of u
+			static nntl_force_inline vec_t log1p(const vec_t x)noexcept {
+				const vec_t one = VT::set1(real_t(1.));
+				const vec_t u = VT::add(one, x);
+				return VT::add(log(u), VT::div(VT::sub(x, VT::sub(u, one)), u));
+			}
+		};
+	}
+
+	template<typename VT, typename AccT = vmath_accurate>
+	nntl_force_inline typename VT::vec_t vexp(const typename VT::vec_t x)noexcept { return _impl::_vmath<VT, AccT>::exp(x); }
+
+	template<typename VT, typename AccT = vmath_accurate>
+	nntl_force_inline typename VT::vec_t vexpm1(const typename VT::vec_t x)noexcept { return _impl::_vmath<VT, AccT>::expm1(x); }
+
+	//x must be a positive normal number
+	template<typename VT, typename AccT = vmath_accurate>
+	nntl_force_inline typename VT::vec_t vlog(const typename VT::vec_t x)noexcept { return _impl::_vmath<VT, AccT>::log(x); }
+
+	//x must be greater than -1 and 1+x must be a normal number
+	template<typename VT, typename AccT = vmath_accurate>
+	nntl_force_inline typename VT::vec_t vlog1p(const typename VT::vec_t x)noexcept { return _impl::_vmath<VT, AccT>::log1p(x); }
+
+}
+}
+}
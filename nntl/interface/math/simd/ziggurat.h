@@ -0,0 +1,229 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//Vectorized Ziggurat method (G. Marsaglia, W.W. Tsang, "The Ziggurat Method for Generating Random Variables", 2000) that
+// converts uniformly distributed samples to normally distributed ones in place.
+// 256 layers are used, parameters are from J.A. Doornik "An Improved Ziggurat Method to Generate Normal Random Samples".
+// A uniform sample u in [0,1] provides everything the fast path needs: u*512 gives a sign (the top bit), a layer index
+// (8 bits) and a position in the layer (the remaining bits of u: 15 for float and 24+ for double). About 99% of samples
+// are accepted by the fast path, that is branchless and vectorized. The rest go through the slow path (wedges and the tail)
+// that is scalar and needs additional random bits. They're taken from a source of uniform 32bit integers supplied by
+// the caller for each such sample.
+
+#include <cmath>
+#include <algorithm>
+#include "simd.h"
+
+namespace nntl {
+namespace math {
+namespace simd {
+
+	namespace _impl {
+
+		template<typename RealT>
+		struct ziggurat_tables {
+			typedef RealT real_t;
+
+			static constexpr unsigned layers = 256;
+			static constexpr double R = 3.6541528853610088;//the start of the tail
+			static constexpr double V = 4.92867323399e-3;//area of each layer
+
+			//the layer i spans [0, X[i]). X[0] is the width of the virtual rectangle of the same area as the base layer
+			// (the rectangle below f(R) plus the tail)
+			real_t X[layers + 1];
+			//X[i+1]/X[i]. A sample at the relative position f in the layer i is accepted straight away if f < K[i]
+			real_t K[layers];
+
+			//double precision versions for the slow path. F[i] = exp(-X[i]^2/2)
+			double Xd[layers + 1], Kd[layers], F[layers + 1];
+
+			static double _f(const double x)noexcept { return ::std::exp(-.5*x*x); }
+
+			ziggurat_tables()noexcept {
+				Xd[0] = V / _f(R);
+				Xd[1] = R;
+				for (unsigned i = 1; i < layers - 1; ++i) {
+					Xd[i + 1] = ::std::sqrt(-2 * ::std::log(V / Xd[i] + _f(Xd[i])));
+				}
+				Xd[layers] = 0;
+				for (unsigned i = 0; i <= layers; ++i) {
+					F[i] = _f(Xd[i]);
+					X[i] = static_cast<real_t>(Xd[i]);
+				}
+				for (unsigned i = 0; i < layers; ++i) {
+					Kd[i] = Xd[i + 1] / Xd[i];
+					K[i] = static_cast<real_t>(Kd[i]);
+				}
+			}
+
+			static const ziggurat_tables& get()noexcept {
+				static const ziggurat_tables t;
+				return t;
+			}
+		};
+
+		template<typename RealT>
+		struct ziggurat_base {
+			typedef RealT real_t;
+			typedef ziggurat_tables<real_t> tables_t;
+
+			static constexpr real_t uMult = real_t(2 * tables_t::layers);
+
+			static double _u01(const uint32_t u)noexcept { return u * (1. / 4294967296.); }
+			//(0,1]
+			static double _u01nz(const uint32_t u)noexcept { return (static_cast<double>(u) + 1.) * (1. / 4294967296.); }
+
+			//finishes the sample rejected by the fast path. x is the candidate in the layer i.
+			//src() must return uniformly distributed uint32_t values
+			template<typename U32SrcT>
+			static real_t slow(const tables_t& T, unsigned i, double x, bool bNeg, U32SrcT& src)noexcept {
+				for (;;) {
+					if (0 == i) {
+						//the tail, Marsaglia's 1964 method
+						double x1, y;
+						do {
+							x1 = -::std::log(_u01nz(src())) / tables_t::R;
+							y = -::std::log(_u01nz(src()));
+						} while (y + y < x1*x1);
+						x = tables_t::R + x1;
+						break;
+					}
+					//the wedge
+					if (T.F[i] + _u01(src())*(T.F[i + 1] - T.F[i]) < ::std::exp(-.5*x*x)) break;
+
+					//rejected, making a new candidate
+					const uint32_t a = src(), b = src();
+					i = a & (tables_t::layers - 1);
+					bNeg = 0 != (a & tables_t::layers);
+					const double f = _u01(b) + (a >> 9)*(1. / 36028797018963968.);//2^-55
+					x = f*T.Xd[i];
+					if (f < T.Kd[i]) break;
+				}
+				return static_cast<real_t>(bNeg ? -x : x);
+			}
+
+			//standard normal sample made of a uniform sample u in [0,1]
+			template<typename U32SrcT>
+			static real_t transform1(const tables_t& T, const real_t u, U32SrcT& src)noexcept {
+				const real_t v = u * uMult;
+				const real_t w = ::std::min(::std::floor(v), uMult - real_t(1));
+				const real_t f = v - w;
+				const bool bNeg = w >= real_t(tables_t::layers);
+				const unsigned i = static_cast<unsigned>(w) & (tables_t::layers - 1);
+				const real_t x = f*T.X[i];
+				return f < T.K[i] ? (bNeg ? -x : x) : slow(T, i, x, bNeg, src);
+			}
+		};
+	}
+
+	template<typename VT>
+	struct ziggurat_kernels : public _impl::ziggurat_base<typename VT::real_t> {
+		typedef _impl::ziggurat_base<typename VT::real_t> _base_t;
+		typedef typename VT::real_t real_t;
+		typedef typename VT::vec_t vec_t;
+		typedef typename _base_t::tables_t tables_t;
+		static constexpr unsigned W = VT::width;
+
+		//processes the longest prefix of p that is a multiple of W and returns its length. See ziggurat::transform()
+		template<typename SrcAtF>
+		static size_t transform(const tables_t& T, real_t*const p, const size_t n, const real_t m, const real_t st, SrcAtF& srcAt)noexcept {
+			const size_t ne = n - (n % W);
+			const vec_t vMult = VT::set1(_base_t::uMult), vMaxW = VT::set1(_base_t::uMult - real_t(1))
+				, vLayers = VT::set1(real_t(tables_t::layers)), vHalf = VT::set1(real_t(tables_t::layers) - real_t(.5))
+				, vm = VT::set1(m), vst = VT::set1(st);
+			constexpr unsigned allLanes = (1u << W) - 1;
+
+			for (size_t i = 0; i < ne; i += W) {
+				const vec_t u = VT::load(p + i);
+				const vec_t v = VT::mul(u, vMult);
+				const vec_t w = VT::min(VT::floor(v), vMaxW);
+				const vec_t f = VT::sub(v, w);
+				const auto bNeg = VT::gt(w, vHalf);
+				const vec_t li = VT::select(bNeg, VT::sub(w, vLayers), w);
+				const vec_t x = VT::mul(f, VT::lut(T.X, li));
+				const unsigned rej = ~VT::bits(VT::lt(f, VT::lut(T.K, li))) & allLanes;
+
+				VT::store(p + i, VT::fmadd(VT::select(bNeg, VT::neg(x), x), vst, vm));
+
+				if (rej) {
+					real_t ut[W];
+					VT::store(ut, u);
+					for (unsigned j = 0; j < W; ++j) {
+						if (rej & (1u << j)) {
+							auto src = srcAt(i + j);
+							p[i + j] = _base_t::transform1(T, ut[j], src)*st + m;
+						}
+					}
+				}
+			}
+			return ne;
+		}
+	};
+
+	template<typename RealT>
+	struct ziggurat : public _impl::ziggurat_base<RealT> {
+		typedef _impl::ziggurat_base<RealT> _base_t;
+		typedef RealT real_t;
+		typedef typename _base_t::tables_t tables_t;
+
+		//converts n uniform samples in [0,1] stored in p to samples of N(m, st^2) in place.
+		//srcAt(k) is called only for the samples k that need the slow path and must return a functor that produces
+		// uniformly distributed uint32_t values to be used for the sample k
+		template<typename SrcAtF>
+		static void transform(real_t*const p, const size_t n, const real_t m, const real_t st, SrcAtF&& srcAt)noexcept {
+			const auto& T = tables_t::get();
+			size_t done = 0;
+			switch (active_isa()) {
+#if NNTL_SIMD_AVX512
+			case isa::avx512:
+				done = ziggurat_kernels<vtraits<isa::avx512, real_t>>::transform(T, p, n, m, st, srcAt);
+				break;
+#endif
+#if NNTL_SIMD_AVX2
+			case isa::avx2:
+				done = ziggurat_kernels<vtraits<isa::avx2, real_t>>::transform(T, p, n, m, st, srcAt);
+				break;
+#endif
+			default:
+				break;
+			}
+			for (size_t k = done; k < n; ++k) {
+				auto src = srcAt(k);
+				p[k] = _base_t::transform1(T, p[k], src)*st + m;
+			}
+		}
+	};
+
+}
+}
+}
@@ -36,6 +36,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "../_i_threads.h"
 #include "smatrix.h"
+#include "smatrix_csr.h"
 #include "smath_thr.h"
 #include <algorithm>
 #include <numeric>
@@ -113,6 +114,10 @@ namespace math {
 		_SMath()noexcept : m_minTempStorageSize(0), m_curStorElementsAllocated(0){
 			global_denormalized_floats_mode();
 		}
+		//nThreads is passed to the iThreads_t constructor and limits the size of the thread pool (see threads::Workers)
+		explicit _SMath(const thread_id_t nThreads)noexcept : m_threads(nThreads), m_minTempStorageSize(0), m_curStorElementsAllocated(0) {
+			global_denormalized_floats_mode();
+		}
 
 		// use with care, it's kind of "internal memory" of the class object. Don't know, if really 
 		// should expose it into public (for some testing purposes only at this moment)
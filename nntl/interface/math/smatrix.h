@@ -55,6 +55,10 @@ namespace math {
 		
 		typedef ::std::pair<const vec_len_t, const vec_len_t> mtx_size_t;
 		typedef ::std::pair<vec_len_t, vec_len_t> mtx_coords_t;
+
+		//bit-packed masks: the mask of an element with index i is stored in the bit (i%64) of the word (i/64)
+		typedef uint64_t bitmask_word_t;
+		static constexpr numel_cnt_t sBitMaskWords(const numel_cnt_t n)noexcept { return (n + 63) / 64; }
 	};
 
 	//////////////////////////////////////////////////////////////////////////
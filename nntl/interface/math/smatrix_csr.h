@@ -0,0 +1,334 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+//Sparse matrix in the compressed sparse row (CSR) format. It's intended to store very sparse X data (such as bag-of-features)
+// and to feed it directly to the first fully connected layer (see sparse overloads of _MathN::mExtractRows(), mMulABt_Cnb() and
+// mScaledMulAtB_C()).
+//Like smatrix, it may emulate biases. Then cols() counts the last column of ones, however it isn't stored.
+
+#include "smatrix.h"
+
+namespace nntl {
+namespace math {
+
+	template <typename T_>
+	class smatrix_csr : public smatrix_td {
+	public:
+		typedef T_ value_type;
+		typedef smatrix<value_type> densemtx_t;
+
+		//////////////////////////////////////////////////////////////////////////
+		//members
+	protected:
+		value_type* m_pVals;
+		vec_len_t* m_pColIdxs;
+		//m_rows+1 elements. Nonzero elements of row r are stored in [m_pRowPtrs[r], m_pRowPtrs[r+1]) of m_pVals and m_pColIdxs
+		numel_cnt_t* m_pRowPtrs;
+		numel_cnt_t m_nnzCapacity;
+		vec_len_t m_rows, m_cols;//m_cols counts the bias column if m_bEmulateBiases is set
+		bool m_bEmulateBiases;
+
+	protected:
+		void _free_elements()noexcept {
+			delete[] m_pVals;
+			m_pVals = nullptr;
+			delete[] m_pColIdxs;
+			m_pColIdxs = nullptr;
+			m_nnzCapacity = 0;
+		}
+		void _free()noexcept {
+			_free_elements();
+			delete[] m_pRowPtrs;
+			m_pRowPtrs = nullptr;
+			m_rows = 0;
+			m_cols = 0;
+		}
+
+	public:
+		~smatrix_csr()noexcept { _free(); }
+		smatrix_csr()noexcept : m_pVals(nullptr), m_pColIdxs(nullptr), m_pRowPtrs(nullptr), m_nnzCapacity(0)
+			, m_rows(0), m_cols(0), m_bEmulateBiases(false) {}
+
+		smatrix_csr(smatrix_csr&& src)noexcept : m_pVals(src.m_pVals), m_pColIdxs(src.m_pColIdxs), m_pRowPtrs(src.m_pRowPtrs)
+			, m_nnzCapacity(src.m_nnzCapacity), m_rows(src.m_rows), m_cols(src.m_cols), m_bEmulateBiases(src.m_bEmulateBiases)
+		{
+			src.m_pVals = nullptr;
+			src.m_pColIdxs = nullptr;
+			src.m_pRowPtrs = nullptr;
+			src.m_nnzCapacity = 0;
+			src.m_rows = 0;
+			src.m_cols = 0;
+		}
+		smatrix_csr& operator=(smatrix_csr&& rhs)noexcept {
+			if (this != &rhs) {
+				_free();
+				m_pVals = rhs.m_pVals;
+				m_pColIdxs = rhs.m_pColIdxs;
+				m_pRowPtrs = rhs.m_pRowPtrs;
+				m_nnzCapacity = rhs.m_nnzCapacity;
+				m_rows = rhs.m_rows;
+				m_cols = rhs.m_cols;
+				m_bEmulateBiases = rhs.m_bEmulateBiases;
+
+				rhs.m_pVals = nullptr;
+				rhs.m_pColIdxs = nullptr;
+				rhs.m_pRowPtrs = nullptr;
+				rhs.m_nnzCapacity = 0;
+				rhs.m_rows = 0;
+				rhs.m_cols = 0;
+			}
+			return *this;
+		}
+
+		smatrix_csr(const smatrix_csr&) = delete;
+		smatrix_csr& operator=(const smatrix_csr&) = delete;
+
+		//////////////////////////////////////////////////////////////////////////
+		bool operator==(const smatrix_csr& rhs)const noexcept {
+			if (m_bEmulateBiases != rhs.m_bEmulateBiases || size() != rhs.size()) return false;
+			if (empty()) return true;
+			const auto n = nnz();
+			return n == rhs.nnz()
+				&& 0 == memcmp(m_pRowPtrs, rhs.m_pRowPtrs, (static_cast<numel_cnt_t>(m_rows) + 1) * sizeof(numel_cnt_t))
+				&& 0 == memcmp(m_pColIdxs, rhs.m_pColIdxs, n * sizeof(vec_len_t))
+				&& 0 == memcmp(m_pVals, rhs.m_pVals, n * sizeof(value_type));
+		}
+		bool operator!=(const smatrix_csr& rhs)const noexcept { return !operator==(rhs); }
+
+		//////////////////////////////////////////////////////////////////////////
+		bool emulatesBiases()const noexcept { return m_bEmulateBiases; }
+		void will_emulate_biases()noexcept {
+			NNTL_ASSERT(empty());
+			m_bEmulateBiases = true;
+		}
+		void dont_emulate_biases()noexcept {
+			NNTL_ASSERT(empty());
+			m_bEmulateBiases = false;
+		}
+
+		bool empty()const noexcept { return nullptr == m_pRowPtrs; }
+		vec_len_t rows()const noexcept { return m_rows; }
+		vec_len_t cols()const noexcept { return m_cols; }
+		vec_len_t cols_no_bias()const noexcept { return m_cols - static_cast<vec_len_t>(m_bEmulateBiases); }
+		mtx_size_t size()const noexcept { return mtx_size_t(m_rows, m_cols); }
+		mtx_size_t size_no_bias()const noexcept { return mtx_size_t(m_rows, cols_no_bias()); }
+
+		//count of stored (nonzero) elements. Biases aren't stored
+		numel_cnt_t nnz()const noexcept { return m_pRowPtrs ? m_pRowPtrs[m_rows] : 0; }
+		numel_cnt_t nnz_capacity()const noexcept { return m_nnzCapacity; }
+		numel_cnt_t row_nnz(const vec_len_t r)const noexcept {
+			NNTL_ASSERT(r < m_rows);
+			return m_pRowPtrs[r + 1] - m_pRowPtrs[r];
+		}
+		numel_cnt_t max_row_nnz()const noexcept {
+			numel_cnt_t m = 0;
+			for (vec_len_t r = 0; r < m_rows; ++r) m = ::std::max(m, row_nnz(r));
+			return m;
+		}
+		//fraction of nonzero elements (biases excluded)
+		double density()const noexcept {
+			return empty() ? 0. : double(nnz()) / (double(m_rows)*double(cols_no_bias()));
+		}
+
+		const value_type* values()const noexcept { return m_pVals; }
+		value_type* values()noexcept { return m_pVals; }
+		const vec_len_t* col_idxs()const noexcept { return m_pColIdxs; }
+		vec_len_t* col_idxs()noexcept { return m_pColIdxs; }
+		const numel_cnt_t* row_ptrs()const noexcept { return m_pRowPtrs; }
+		numel_cnt_t* row_ptrs()noexcept { return m_pRowPtrs; }
+
+		//////////////////////////////////////////////////////////////////////////
+		void clear()noexcept { _free(); }
+
+		//makes an r x c (plus bias column if emulatesBiases()) matrix without nonzero elements, that may store up
+		// to nnzCapacity elements without reallocation. Returns false if failed to allocate the memory
+		bool resize(const vec_len_t r, vec_len_t c, const numel_cnt_t nnzCapacity)noexcept {
+			NNTL_ASSERT(r > 0 && c > 0);
+			if (r <= 0 || c <= 0) {
+				NNTL_ASSERT(!"Wrong row or col count!");
+				return false;
+			}
+			if (m_bEmulateBiases) ++c;
+
+			if (r != m_rows || !m_pRowPtrs) {
+				delete[] m_pRowPtrs;
+				m_pRowPtrs = new(::std::nothrow) numel_cnt_t[static_cast<numel_cnt_t>(r) + 1];
+				if (!m_pRowPtrs) {
+					_free();
+					return false;
+				}
+			}
+			m_rows = r;
+			m_cols = c;
+			memset(m_pRowPtrs, 0, (static_cast<numel_cnt_t>(r) + 1) * sizeof(numel_cnt_t));
+			if (!reserve(nnzCapacity)) {
+				_free();
+				return false;
+			}
+			return true;
+		}
+
+		//makes sure that nnzCapacity elements could be stored. The content is preserved. Returns false if failed to allocate the memory
+		bool reserve(const numel_cnt_t nnzCapacity)noexcept {
+			if (nnzCapacity <= m_nnzCapacity) return true;
+
+			const auto pV = new(::std::nothrow) value_type[nnzCapacity];
+			const auto pC = new(::std::nothrow) vec_len_t[nnzCapacity];
+			if (!pV || !pC) {
+				delete[] pV;
+				delete[] pC;
+				return false;
+			}
+			//row offsets may already describe the new content, so only the old capacity is valid
+			const auto n = ::std::min(nnz(), m_nnzCapacity);
+			if (n) {
+				memcpy(pV, m_pVals, n * sizeof(value_type));
+				memcpy(pC, m_pColIdxs, n * sizeof(vec_len_t));
+			}
+			_free_elements();
+			m_pVals = pV;
+			m_pColIdxs = pC;
+			m_nnzCapacity = nnzCapacity;
+			return true;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		//takes nonzero elements of M. Biases of M (if any) are implied. Returns false if failed to allocate the memory
+		bool from_dense(const densemtx_t& M)noexcept {
+			NNTL_ASSERT(!M.empty());
+			_free();
+			m_bEmulateBiases = M.emulatesBiases();
+
+			const vec_len_t rm = M.rows(), cnb = M.cols_no_bias();
+			const auto pM = M.data();
+			numel_cnt_t n = 0;
+			const auto ne = M.numel_no_bias();
+			for (numel_cnt_t i = 0; i < ne; ++i) n += (pM[i] != value_type(0));
+
+			if (!resize(rm, cnb, n)) return false;
+
+			//counting elements of every row, then turning counts into offsets
+			for (numel_cnt_t i = 0; i < ne; ++i) {
+				if (pM[i] != value_type(0)) ++m_pRowPtrs[i % rm + 1];
+			}
+			for (vec_len_t r = 0; r < rm; ++r) m_pRowPtrs[r + 1] += m_pRowPtrs[r];
+
+			//walking the column-major M column by column gives sorted column indexes within every row
+			const auto pos = new(::std::nothrow) numel_cnt_t[rm];
+			if (!pos) {
+				_free();
+				return false;
+			}
+			memcpy(pos, m_pRowPtrs, static_cast<numel_cnt_t>(rm) * sizeof(numel_cnt_t));
+			for (vec_len_t c = 0; c < cnb; ++c) {
+				const auto pCol = pM + static_cast<numel_cnt_t>(c)*rm;
+				for (vec_len_t r = 0; r < rm; ++r) {
+					const auto v = pCol[r];
+					if (v != value_type(0)) {
+						const auto p = pos[r]++;
+						m_pVals[p] = v;
+						m_pColIdxs[p] = c;
+					}
+				}
+			}
+			delete[] pos;
+			NNTL_ASSERT(test_valid());
+			return true;
+		}
+
+		//makes the dense version of the matrix. Returns false if failed to allocate the memory
+		bool to_dense(densemtx_t& M)const noexcept {
+			NNTL_ASSERT(!empty());
+			if (M.emulatesBiases() != m_bEmulateBiases) {
+				M.clear();
+				if (m_bEmulateBiases) {
+					M.will_emulate_biases();
+				} else M.dont_emulate_biases();
+			}
+			if (!M.resize(m_rows, cols_no_bias())) return false;
+			M.zeros();
+
+			const auto pM = M.data();
+			const numel_cnt_t rm = m_rows;
+			for (vec_len_t r = 0; r < m_rows; ++r) {
+				for (auto i = m_pRowPtrs[r]; i < m_pRowPtrs[r + 1]; ++i) {
+					pM[r + m_pColIdxs[i] * rm] = m_pVals[i];
+				}
+			}
+			NNTL_ASSERT(!m_bEmulateBiases || M.test_biases_ok());
+			return true;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		//debug/NNTL_ASSERT only. Biases are implied, so they are always fine
+		bool test_biases_ok()const noexcept { return m_bEmulateBiases; }
+
+		//debug/NNTL_ASSERT only
+		bool test_noNaNs()const noexcept {
+			const auto n = nnz();
+			int cond = 0;
+			for (numel_cnt_t i = 0; i < n; ++i) {
+				const int c = ::std::isnan(m_pVals[i]);
+				NNTL_ASSERT(!c || !"NaN check failed!");
+				cond = cond | c;
+			}
+			return !cond;
+		}
+
+		//debug/NNTL_ASSERT only. Checks the structure of the matrix
+		bool test_valid()const noexcept {
+			if (empty()) return 0 == m_rows && 0 == m_cols;
+			if (0 != m_pRowPtrs[0] || nnz() > m_nnzCapacity) return false;
+			const auto cnb = cols_no_bias();
+			for (vec_len_t r = 0; r < m_rows; ++r) {
+				if (m_pRowPtrs[r] > m_pRowPtrs[r + 1]) return false;
+				for (auto i = m_pRowPtrs[r]; i < m_pRowPtrs[r + 1]; ++i) {
+					if (m_pColIdxs[i] >= cnb) return false;
+				}
+			}
+			return true;
+		}
+	};
+
+	//the code that expects a dense matrix (such as inspectors) gets an empty matrix instead of a sparse one
+	template<typename T>
+	inline const smatrix<T>& dense_or_empty(const smatrix<T>& M)noexcept { return M; }
+	template<typename T>
+	inline const smatrix<T>& dense_or_empty(const smatrix_csr<T>&)noexcept {
+		static const smatrix<T> e;
+		return e;
+	}
+
+}
+}
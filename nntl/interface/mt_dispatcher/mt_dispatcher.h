@@ -32,41 +32,179 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
-//ignore this file, to be done later
-
-
-#include "../../utils/tictoc.h"
+//mt_dispatcher ties run-time adjustable thresholds of MathN (math/mathn_thr_rt.h) to the profiler and to a profile file.
+//Typical usage (once per process, before the training starts):
+//		typedef math::MathN<real_t, iThreads_t, math::_impl::MATHN_THR_RT<real_t>> iMath_t;
+//		iMath_t iM;
+//		mt::mt_dispatcher<iMath_t> disp(iM);
+//		disp.autotune("mathn.profile");//loads thresholds from the file or profiles kernels and saves results to the file
+//
+// Profile file is a plain text file. The first line is a signature that binds the file to a data type, to a number of
+// worker threads and to a CPU model (its brand string with spaces replaced by underscores); every other line is a "<threshold name> <value>" pair. Unknown names are ignored, missing names keep
+// their current values, so a profile remains usable when the set of thresholds changes.
+
+#include <cstdio>
+#include "profiler.h"
+#include "../math/simd/simd.h"
+#include "../../errors.h"
+#include "../../utils/scope_exit.h"
 
 namespace nntl {
 namespace mt {
 
-	template<typename BaseClass_t>
-	class mt_dispatcher : public BaseClass_t {
+	struct _mt_dispatcher_errs {
+		enum ErrorCode {
+			Success = 0,
+			FailedToOpenFile,
+			WrongFileSignature,
+			FileIsForOtherMachine,
+			FailedToReadFile,
+			FailedToWriteFile,
+			ProfilingFailed
+		};
+
+		static const strchar_t* get_error_str(const ErrorCode ec) noexcept {
+			switch (ec) {
+			case Success: return NNTL_STRING("No error / success.");
+			case FailedToOpenFile: return NNTL_STRING("Failed to open profile file.");
+			case WrongFileSignature: return NNTL_STRING("File is not an nntl MathN profile.");
+			case FileIsForOtherMachine: return NNTL_STRING("Profile was made for other data type, other count of worker threads or other CPU model.");
+			case FailedToReadFile: return NNTL_STRING("Failed to read profile file.");
+			case FailedToWriteFile: return NNTL_STRING("Failed to write profile file.");
+			case ProfilingFailed: return NNTL_STRING("Failed to profile kernels.");
+
+			default: NNTL_ASSERT(!"WTF?"); return NNTL_STRING("Unknown code.");
+			}
+		}
+	};
+
+	template<typename iMathT>
+	class mt_dispatcher : public _has_last_error<_mt_dispatcher_errs> {
 	public:
-		typedef BaseClass_t base_class_t;
-		typedef utils::tictoc tictoc_t;
+		typedef iMathT iMath_t;
+		typedef typename iMath_t::real_t real_t;
+		typedef typename iMath_t::Thresholds_t Thresholds_t;
+		typedef profiler<iMath_t> profiler_t;
+
+		static_assert(::std::is_base_of<math::_impl::MATHN_THR_RT<real_t>, Thresholds_t>::value
+			, "iMath_t::Thresholds_t must be derived from MATHN_THR_RT<real_t>");
+
+		static constexpr const char* sSignature = "nntl_mathn_profile";
+		static constexpr unsigned sVersion = 2;
+		static constexpr unsigned sMaxNameLen = 63;
 
 		//////////////////////////////////////////////////////////////////////////
 		//members
-	public:
+	protected:
+		iMath_t& m_iM;
 
 		//////////////////////////////////////////////////////////////////////////
 		//methods
 	public:
 		~mt_dispatcher()noexcept {};
-		mt_dispatcher()noexcept : base_class_t() {}
+		mt_dispatcher(iMath_t& iM)noexcept : m_iM(iM) {}
 
-		//////////////////////////////////////////////////////////////////////////
-		//overridings
+		//loads thresholds from the profile file if it exists and was made for this machine setup. Otherwise (or if bForceProfiling is set)
+		// runs the profiler and saves the results to the file (if fname isn't nullptr).
+		// Returns Success if thresholds were either loaded or profiled (a failure to save the profile is reported, but
+		// thresholds remain tuned)
+		ErrorCode autotune(const char*const fname, const bool bForceProfiling = false
+			, const profiler_settings& ps = profiler_settings())noexcept
+		{
+			if (fname && !bForceProfiling && ErrorCode::Success == load(fname)) return ErrorCode::Success;
 
-		void evMul_ip(realmtx_t& A, const realmtx_t& B)noexcept {
-			const auto decisionValue = A.numel();
+			if (!profile(ps)) return _set_last_error(ErrorCode::ProfilingFailed);
 
+			return fname ? save(fname) : _set_last_error(ErrorCode::Success);
+		}
 
+		//runs the profiler, updating thresholds in place
+		bool profile(const profiler_settings& ps = profiler_settings())noexcept {
+			profiler_t p(m_iM, ps);
+			return p.run();
+		}
 
+		//restores default (compile-time) thresholds
+		static void reset()noexcept {
+			Thresholds_t::reset();
 		}
 
+		ErrorCode save(const char*const fname)noexcept {
+			NNTL_ASSERT(fname);
+			FILE* fp = nullptr;
+			if (fopen_s(&fp, fname, "w") || nullptr == fp) return _set_last_error(ErrorCode::FailedToOpenFile);
+
+			char cpuName[sMaxNameLen + 1];
+			bool bOk = fprintf_s(fp, "%s %u %s %u %s\n", sSignature, sVersion, _real_t_name(), _workers_count()
+				, _cpu_name(cpuName)) > 0;
+			Thresholds_t::for_each([fp, &bOk](const char*const pName, const size_t& v) {
+				NNTL_ASSERT(::std::strlen(pName) <= sMaxNameLen);
+				bOk = bOk && fprintf_s(fp, "%s %zu\n", pName, v) > 0;
+			});
+			bOk = (0 == fclose(fp)) && bOk;
+			return _set_last_error(bOk ? ErrorCode::Success : ErrorCode::FailedToWriteFile);
+		}
 
+		ErrorCode load(const char*const fname)noexcept {
+			NNTL_ASSERT(fname);
+			FILE* fp = nullptr;
+			if (fopen_s(&fp, fname, "r") || nullptr == fp) return _set_last_error(ErrorCode::FailedToOpenFile);
+			utils::scope_exit on_exit([&fp]() {
+				fclose(fp);
+			});
+
+			char name[sMaxNameLen + 1], typeName[sMaxNameLen + 1], fileCpu[sMaxNameLen + 1], cpuName[sMaxNameLen + 1];
+			unsigned ver = 0, wc = 0;
+			//the version is checked before the CPU name is read, because older profiles don't have it
+			if (2 != fscanf_s(fp, "%63s %u", name, static_cast<unsigned>(sizeof(name)), &ver))
+				return _set_last_error(ErrorCode::WrongFileSignature);
+			if (0 != ::std::strcmp(name, sSignature) || ver != sVersion) return _set_last_error(ErrorCode::WrongFileSignature);
+
+			if (3 != fscanf_s(fp, "%63s %u %63s", typeName, static_cast<unsigned>(sizeof(typeName)), &wc
+				, fileCpu, static_cast<unsigned>(sizeof(fileCpu))))
+			{
+				return _set_last_error(ErrorCode::WrongFileSignature);
+			}
+			if (0 != ::std::strcmp(typeName, _real_t_name()) || wc != _workers_count()
+				|| 0 != ::std::strcmp(fileCpu, _cpu_name(cpuName)))
+			{
+				return _set_last_error(ErrorCode::FileIsForOtherMachine);
+			}
+
+			//reading into temporary storage first to leave thresholds intact if the file is broken
+			::std::vector<::std::pair<size_t*, size_t>> vals;
+			size_t v;
+			int r;
+			while (2 == (r = fscanf_s(fp, "%63s %zu", name, static_cast<unsigned>(sizeof(name)), &v))) {
+				const auto pThr = Thresholds_t::find(name);
+				if (pThr) vals.push_back(::std::make_pair(pThr, v));
+			}
+			if (EOF != r) return _set_last_error(ErrorCode::FailedToReadFile);
+
+			for (const auto& e : vals) *e.first = e.second;
+			return _set_last_error(ErrorCode::Success);
+		}
+
+	protected:
+		static constexpr const char* _real_t_name()noexcept {
+			return ::std::is_same<real_t, float>::value ? "float" : "double";
+		}
+		unsigned _workers_count()noexcept {
+			return static_cast<unsigned>(m_iM.ithreads().workers_count());
+		}
+		//fills buf with the CPU brand string, suitable to be read back with %s
+		static const char* _cpu_name(char (&buf)[sMaxNameLen + 1])noexcept {
+			const char* pSrc = math::simd::cpu_brand();
+			if (!*pSrc) pSrc = "unknown_cpu";
+			unsigned i = 0;
+			for (; i < sMaxNameLen && pSrc[i]; ++i) {
+				const char c = pSrc[i];
+				buf[i] = (' ' == c || '\t' == c || '\n' == c || '\r' == c) ? '_' : c;
+			}
+			buf[i] = 0;
+			return buf;
+		}
 	};
+
+}
 }
-}
\ No newline at end of file
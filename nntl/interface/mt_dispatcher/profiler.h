@@ -32,80 +32,371 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
-//ignore this file, to be done later
+//Run-time profiler of single/multi-threaded branching points of MathN class.
+//It times _st and _mt versions (as well as _cw and _rw versions where applicable) of a kernel over a sweep of data sizes
+// on the current machine and core count and sets a corresponding run-time threshold (see math/mathn_thr_rt.h) to the
+// crossover point, i.e. to the smallest data size starting from which the second (usually _mt) version is faster.
+// Use mt_dispatcher.h to load/store the results from/to a profile file.
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <iostream>
 
 #include "../../utils/tictoc.h"
+#include "../math/mathn_thr_rt.h"
 
 namespace nntl {
 namespace mt {
 
-	template<typename BaseClass_t>
-	class profiler : public BaseClass_t {
+	struct profiler_settings {
+		//data sizes sweep is [minNumel, maxNumel] with a geometric step sweepFactor
+		::std::size_t minNumel, maxNumel;
+		double sweepFactor;
+		//count of timed runs per each data size and each version of a kernel. The best time is taken into account
+		unsigned repeats;
+		//numel-based sweeps use matrices with this count of columns (unless numel is less than it)
+		math::smatrix_td::vec_len_t cols;
+		//the second version must be faster by this fraction to be considered a winner (makes decision more noise-tolerant)
+		double winMargin;
+		bool bVerbose;
+
+		profiler_settings()noexcept : minNumel(256), maxNumel(1 << 21), sweepFactor(1.41421356), repeats(11)
+			, cols(64), winMargin(.02), bVerbose(false)
+		{}
+	};
+
+	template<typename iMathT>
+	class profiler {
 	public:
-		typedef BaseClass_t base_class_t;
+		typedef iMathT iMath_t;
+		typedef typename iMath_t::real_t real_t;
+		typedef typename iMath_t::realmtx_t realmtx_t;
+		typedef typename iMath_t::Thresholds_t Thresholds_t;
+		typedef typename realmtx_t::vec_len_t vec_len_t;
+		typedef typename realmtx_t::numel_cnt_t numel_cnt_t;
 		typedef utils::tictoc tictoc_t;
 
+		static_assert(::std::is_base_of<math::_impl::MATHN_THR_RT<real_t>, Thresholds_t>::value
+			, "iMath_t::Thresholds_t must be derived from MATHN_THR_RT<real_t> to be profiled");
+
 		//////////////////////////////////////////////////////////////////////////
 		//members
-	public:
+	protected:
+		iMath_t& m_iM;
+		const profiler_settings m_settings;
+
+		::std::vector<numel_cnt_t> m_sizes;
+
+		//pristine data and working copies
+		realmtx_t m_A0, m_B0, m_C0, m_A, m_B, m_C;
+		::std::vector<real_t> m_vec;
+
+		::std::mt19937_64 m_gen;
+
+		//to prevent the compiler from throwing out computations of reductions
+		volatile real_t m_sink;
 
-		
 		//////////////////////////////////////////////////////////////////////////
 		//methods
 	public:
 		~profiler()noexcept {};
-		profiler()noexcept : base_class_t() {}
+		profiler(iMath_t& iM, const profiler_settings& s = profiler_settings())noexcept
+			: m_iM(iM), m_settings(s), m_gen(0x5EED), m_sink(real_t(0))
+		{
+			NNTL_ASSERT(m_settings.minNumel > 1 && m_settings.minNumel < m_settings.maxNumel && m_settings.sweepFactor > 1);
+			double n = static_cast<double>(m_settings.minNumel);
+			while (n <= static_cast<double>(m_settings.maxNumel)) {
+				const auto v = static_cast<numel_cnt_t>(n);
+				if (m_sizes.empty() || m_sizes.back() != v) m_sizes.push_back(v);
+				n *= m_settings.sweepFactor;
+			}
+		}
+
+		const profiler_settings& settings()const noexcept { return m_settings; }
+
+		//profiles every kernel, which threshold is listed in NNTL_MATHN_THR_RT_LIST, and updates the thresholds
+		bool run()noexcept {
+			if (m_sizes.size() < 3) return false;
+			//the biggest temporary storage that may be required by profiled kernels is a vector of rows elements
+			m_vec.resize(m_settings.maxNumel);
 
+			threads::prioritize_workers<threads::PriorityClass::PerfTesting, typename iMath_t::iThreads_t> pw(m_iM.ithreads());
+
+			_run_reductions();
+			_run_rowwise();
+			_run_elementwise();
+			_run_activations();
+			_run_optimizers();
+
+			//freeing memory
+			m_A0.clear(); m_B0.clear(); m_C0.clear();
+			m_A.clear(); m_B.clear(); m_C.clear();
+			m_vec.clear();
+			m_vec.shrink_to_fit();
+			return true;
+		}
+
+	protected:
 		//////////////////////////////////////////////////////////////////////////
-		//overridings
-
-		//   
-		
-		//    < > => <     >
-		// ,           . ,   , 
-		//  ,       (???       ?),   .
-		// -      , -  -   .
-		// -          .
-		// -  -      .
-		//       .  ,   . 
-		//     -         void*
-		//		*            .
-		//		*      ID ,        
-		//			(     )
-		// :
-		//		*           
-		//		*        ,   .
-		struct mt_router {
-			//      . nullptr   .
-			void* get(auto decisionValue)noexcept {};
-			//==  .      .
-			void update(auto updateDescription)noexcept {};
-		};
-
-		mt_router m_evMul_ip_router;
-		typedef void(base_class_t::*evMul_ip_func_t)(realmtx_t& A, const realmtx_t& B)noexcept;
-
-		void evMul_ip(realmtx_t& A, const realmtx_t& B)noexcept {
-			const auto decisionValue = A.numel();
-
-			//        -  ,  -     
-			evMul_ip_func_t pF = static_cast<evMul_ip_func_t>m_evMul_ip_router.get(decisionValue);
-			if (nullptr==pF) {
-				//      
-
-
-
-			} else {
-				//    .
-				pF(A, B);
-				//TODO:              , 
-				//    .    ,    .
+		void _fill(realmtx_t& m, const real_t lo, const real_t hi)noexcept {
+			::std::uniform_real_distribution<real_t> distr(lo, hi);
+			for (auto& e : m) e = distr(m_gen);
+		}
+		void _fill_binary(realmtx_t& m)noexcept {
+			::std::bernoulli_distribution distr(.5);
+			for (auto& e : m) e = distr(m_gen) ? real_t(1) : real_t(0);
+		}
+
+		bool _prepare(const vec_len_t r, const vec_len_t c, const real_t lo, const real_t hi
+			, const real_t loB, const real_t hiB, const bool bBinaryC)noexcept
+		{
+			if (!m_A0.resize(r, c) || !m_B0.resize(r, c) || !m_C0.resize(r, c)
+				|| !m_A.resize(r, c) || !m_B.resize(r, c) || !m_C.resize(r, c)) return false;
+			_fill(m_A0, lo, hi);
+			_fill(m_B0, loB, hiB);
+			if (bBinaryC) {
+				_fill_binary(m_C0);
+			} else _fill(m_C0, lo, hi);
+			_restore();
+			return true;
+		}
+		void _restore()noexcept {
+			m_A0.copy_to(m_A);
+			m_B0.copy_to(m_B);
+			m_C0.copy_to(m_C);
+		}
+
+		vec_len_t _cols4numel(const numel_cnt_t n)const noexcept {
+			return static_cast<vec_len_t>(::std::min(static_cast<numel_cnt_t>(m_settings.cols), n));
+		}
+
+		template<typename F>
+		::std::chrono::nanoseconds _time_it(F&& f)noexcept {
+			tictoc_t tt;
+			//warming up caches
+			_restore();
+			f();
+			for (unsigned i = 0; i < m_settings.repeats; ++i) {
+				_restore();
+				tt.tic();
+				f();
+				tt.toc();
 			}
+			return tt.m_dBestRun;
+		}
 
+		//returns the smallest sweep point, starting from which the second function is faster than the first. Data is prepared
+		// by PrepF(sweepPoint) call (that should return false on error).
+		// If F2 is never faster at the largest sweep points, returns the doubled maximum sweep point (F1 is preferred
+		// over all the tested range).
+		template<typename PrepF, typename F1, typename F2>
+		numel_cnt_t _crossover(const char*const pName, const ::std::vector<numel_cnt_t>& sweep, PrepF&& prep, F1&& f1, F2&& f2)noexcept {
+			const auto n = sweep.size();
+			NNTL_ASSERT(n > 2);
+			::std::vector<double> ratio(n);
+			for (size_t i = 0; i < n; ++i) {
+				if (!prep(sweep[i])) {
+					NNTL_ASSERT(!"Failed to prepare data");
+					//sizes beyond this point are unreachable, treat them as the F1 wins
+					for (; i < n; ++i) ratio[i] = 0;
+					break;
+				}
+				const auto t1 = _time_it(f1), t2 = _time_it(f2);
+				ratio[i] = static_cast<double>(t1.count()) / ::std::max(t2.count(), decltype(t2.count())(1));
+			}
+
+			//smoothing the measurements with median of 3 filter
+			::std::vector<double> sm(ratio);
+			for (size_t i = 1; i < n - 1; ++i) {
+				double a = ratio[i - 1], b = ratio[i], c = ratio[i + 1];
+				sm[i] = ::std::max(::std::min(a, b), ::std::min(::std::max(a, b), c));
+			}
+
+			//finding the longest suffix of sweep points where the F2 wins
+			const double winRatio = 1. + m_settings.winMargin;
+			size_t idx = n;
+			while (idx > 0 && sm[idx - 1] > winRatio) --idx;
+
+			const numel_cnt_t ret = idx < n ? sweep[idx] : 2 * sweep.back();
+
+			if (m_settings.bVerbose) {
+				::std::cout << pName << ": " << ret << " (was " << _current_value(pName) << ")" << ::std::endl;
+			}
+			return ret;
+		}
+
+		static size_t _current_value(const char*const pName)noexcept {
+			const auto p = Thresholds_t::find(pName);
+			return p ? *p : 0;
+		}
+
+		//standard numel-based sweep for functions that uses only m_A,m_B,m_C with values in [lo,hi] ([loB,hiB] for m_B)
+		template<typename F1, typename F2>
+		void _tune(const char*const pName, size_t& thr, const real_t lo, const real_t hi, F1&& f1, F2&& f2
+			, const real_t loB = real_t(-1), const real_t hiB = real_t(1), const bool bBinaryC = false)noexcept
+		{
+			thr = _crossover(pName, m_sizes, [lo, hi, loB, hiB, bBinaryC, this](const numel_cnt_t n) {
+				const auto c = _cols4numel(n);
+				return _prepare(static_cast<vec_len_t>(n / c), c, lo, hi, loB, hiB, bBinaryC);
+			}, ::std::forward<F1>(f1), ::std::forward<F2>(f2));
 		}
 
+		//rows-based sweep for rowwise functions. Matrices will have m_settings.cols columns
+		template<typename F1, typename F2>
+		void _tune_rows(const char*const pName, size_t& thr, F1&& f1, F2&& f2)noexcept {
+			::std::vector<numel_cnt_t> rowsSweep;
+			for (const auto n : m_sizes) {
+				const auto r = n / m_settings.cols;
+				if (r > 0 && (rowsSweep.empty() || rowsSweep.back() != r)) rowsSweep.push_back(r);
+			}
+			if (rowsSweep.size() < 3) return;
 
+			thr = _crossover(pName, rowsSweep, [this](const numel_cnt_t r) {
+				return _prepare(static_cast<vec_len_t>(r), m_settings.cols, real_t(-1), real_t(1), real_t(1), real_t(2), false);
+			}, ::std::forward<F1>(f1), ::std::forward<F2>(f2));
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		void _run_reductions()noexcept {
+			auto& iM = m_iM;
+			_tune("ewSumProd", Thresholds_t::ewSumProd, real_t(-1), real_t(1)
+				, [&iM, this]() { m_sink = iM.ewSumProd_st(m_A, m_B); }
+				, [&iM, this]() { m_sink = iM.ewSumProd_mt(m_A, m_B); });
+			_tune("ewSumSquares", Thresholds_t::ewSumSquares, real_t(-1), real_t(1)
+				, [&iM, this]() { m_sink = iM.ewSumSquares_st(m_A); }
+				, [&iM, this]() { m_sink = iM.ewSumSquares_mt(m_A); });
+			_tune("vSumAbs", Thresholds_t::vSumAbs, real_t(-1), real_t(1)
+				, [&iM, this]() { m_sink = iM.vSumAbs_st(m_A); }
+				, [&iM, this]() { m_sink = iM.vSumAbs_mt(m_A); });
+			_tune("loss_quadratic", Thresholds_t::loss_quadratic, real_t(0), real_t(1)
+				, [&iM, this]() { m_sink = iM.loss_quadratic_st_naive(m_A, m_C); }
+				, [&iM, this]() { m_sink = iM.loss_quadratic_mt_naive(m_A, m_C); }, real_t(-1), real_t(1), true);
+			_tune("loss_xentropy", Thresholds_t::loss_xentropy, real_t(.01), real_t(.99)
+				, [&iM, this]() { m_sink = iM.loss_xentropy_st(m_A, m_C); }
+				, [&iM, this]() { m_sink = iM.loss_xentropy_mt(m_A, m_C); }, real_t(-1), real_t(1), true);
+		}
+
+		void _run_rowwise()noexcept {
+			auto& iM = m_iM;
+			const auto pV = &m_vec[0];
+			//_st branches must be tuned before _mt, because _mt versions use _st
+			_tune("mrwDivideByVec_rw", Thresholds_t::mrwDivideByVec_rw, real_t(-1), real_t(1)
+				, [&iM, this]() { iM.mrwDivideByVec_st_rw(m_A, m_B.data()); }
+				, [&iM, this]() { iM.mrwDivideByVec_st_cw(m_A, m_B.data()); }, real_t(1), real_t(2));
+			_tune_rows("mrwDivideByVec_mt_rows", Thresholds_t::mrwDivideByVec_mt_rows
+				, [&iM, this]() { iM.mrwDivideByVec_mt_cw(m_A, m_B.data()); }
+				, [&iM, this]() { iM.mrwDivideByVec_mt_rw(m_A, m_B.data()); });
+			_tune("mrwDivideByVec", Thresholds_t::mrwDivideByVec, real_t(-1), real_t(1)
+				, [&iM, this]() { iM.mrwDivideByVec_st(m_A, m_B.data()); }
+				, [&iM, this]() { iM.mrwDivideByVec_mt(m_A, m_B.data()); }, real_t(1), real_t(2));
+
+			_tune_rows("mrwMulByVec_st_rows", Thresholds_t::mrwMulByVec_st_rows
+				, [&iM, this]() { iM.mrwMulByVec_st_cw(m_A, m_B.data()); }
+				, [&iM, this]() { iM.mrwMulByVec_st_rw(m_A, m_B.data()); });
+			_tune_rows("mrwMulByVec_mt_rows", Thresholds_t::mrwMulByVec_mt_rows
+				, [&iM, this]() { iM.mrwMulByVec_mt_cw(m_A, m_B.data()); }
+				, [&iM, this]() { iM.mrwMulByVec_mt_rw(m_A, m_B.data()); });
+			_tune("mrwMulByVec", Thresholds_t::mrwMulByVec, real_t(-1), real_t(1)
+				, [&iM, this]() { iM.mrwMulByVec_st(m_A, m_B.data()); }
+				, [&iM, this]() { iM.mrwMulByVec_mt(m_A, m_B.data()); });
+
+			_tune("mrwMax", Thresholds_t::mrwMax, real_t(-1), real_t(1)
+				, [&iM, this, pV]() { iM.mrwMax_st(m_A, pV); }
+				, [&iM, this, pV]() { iM.mrwMax_mt(m_A, pV); });
+		}
+
+		void _run_elementwise()noexcept {
+			auto& iM = m_iM;
+			_tune("evClamp", Thresholds_t::evClamp, real_t(-2), real_t(2)
+				, [&iM, this]() { iM.evClamp_st(m_A, real_t(-1), real_t(1)); }
+				, [&iM, this]() { iM.evClamp_mt(m_A, real_t(-1), real_t(1)); });
+			_tune("apply_momentum", Thresholds_t::apply_momentum, real_t(-1), real_t(1)
+				, [&iM, this]() { iM.apply_momentum_st(m_A, real_t(.9), m_B); }
+				, [&iM, this]() { iM.apply_momentum_mt(m_A, real_t(.9), m_B); });
+			_tune("evMulC_ip", Thresholds_t::evMulC_ip, real_t(-1), real_t(1)
+				, [&iM, this]() { iM.evMulC_ip_st(m_A, real_t(.9)); }
+				, [&iM, this]() { iM.evMulC_ip_mt(m_A, real_t(.9)); });
+			_tune("evMul_ip", Thresholds_t::evMul_ip, real_t(-1), real_t(1)
+				, [&iM, this]() { iM.evMul_ip_st(m_A, m_B); }
+				, [&iM, this]() { iM.evMul_ip_mt(m_A, m_B); });
+			_tune("evAdd_ip", Thresholds_t::evAdd_ip, real_t(-1), real_t(1)
+				, [&iM, this]() { iM.evAdd_ip_st(m_A, m_B); }
+				, [&iM, this]() { iM.evAdd_ip_mt(m_A, m_B); });
+			_tune("evAddScaled_ip", Thresholds_t::evAddScaled_ip, real_t(-1), real_t(1)
+				, [&iM, this]() { iM.evAddScaled_ip_st(m_A, real_t(.5), m_B); }
+				, [&iM, this]() { iM.evAddScaled_ip_mt(m_A, real_t(.5), m_B); });
+			_tune("evSub_ip", Thresholds_t::evSub_ip, real_t(-1), real_t(1)
+				, [&iM, this]() { iM.evSub_ip_st_naive(m_A, m_B); }
+				, [&iM, this]() { iM.evSub_ip_mt_naive(m_A, m_B); });
+			_tune("evSquare", Thresholds_t::evSquare, real_t(-1), real_t(1)
+				, [&iM, this]() { iM.evSquare_st(m_C, m_A); }
+				, [&iM, this]() { iM.evSquare_mt(m_C, m_A); });
+			_tune("evAbs", Thresholds_t::evAbs, real_t(-1), real_t(1)
+				, [&iM, this]() { iM.evAbs_st(m_C, m_A); }
+				, [&iM, this]() { iM.evAbs_mt(m_C, m_A); });
+			_tune("dSigmQuadLoss_dZ", Thresholds_t::dSigmQuadLoss_dZ, real_t(0), real_t(1)
+				, [&iM, this]() { iM.dSigmQuadLoss_dZ_st(m_C, m_A); }
+				, [&iM, this]() { iM.dSigmQuadLoss_dZ_mt(m_C, m_A); }, real_t(-1), real_t(1), true);
+		}
+
+		void _run_activations()noexcept {
+			auto& iM = m_iM;
+			const real_t lo(-2), hi(2), flo(0), fhi(1);
+			const real_t alpha(1.5), b(2.), leak(.01), a(1), c(1.5), lambda(1.0507), atl(1.6733*1.0507);
+
+			_tune("sigm", Thresholds_t::sigm, lo, hi, [&iM, this]() { iM.sigm_st(m_A); }, [&iM, this]() { iM.sigm_mt(m_A); });
+			_tune("dsigm", Thresholds_t::dsigm, flo, fhi, [&iM, this]() { iM.dsigm_st(m_A); }, [&iM, this]() { iM.dsigm_mt(m_A); });
+			_tune("relu", Thresholds_t::relu, lo, hi, [&iM, this]() { iM.relu_st(m_A); }, [&iM, this]() { iM.relu_mt(m_A); });
+			_tune("drelu", Thresholds_t::drelu, lo, hi, [&iM, this]() { iM.drelu_st(m_A); }, [&iM, this]() { iM.drelu_mt(m_A); });
+			_tune("leakyrelu", Thresholds_t::leakyrelu, lo, hi
+				, [&iM, this, leak]() { iM.leakyrelu_st(m_A, leak); }, [&iM, this, leak]() { iM.leakyrelu_mt(m_A, leak); });
+			_tune("dleakyrelu", Thresholds_t::dleakyrelu, lo, hi
+				, [&iM, this, leak]() { iM.dleakyrelu_st(m_A, leak); }, [&iM, this, leak]() { iM.dleakyrelu_mt(m_A, leak); });
+			_tune("elu", Thresholds_t::elu, lo, hi
+				, [&iM, this, alpha]() { iM.elu_st(m_A, alpha); }, [&iM, this, alpha]() { iM.elu_mt(m_A, alpha); });
+			_tune("delu", Thresholds_t::delu, lo, hi
+				, [&iM, this, alpha]() { iM.delu_st(m_A, alpha); }, [&iM, this, alpha]() { iM.delu_mt(m_A, alpha); });
+			_tune("elu_unitalpha", Thresholds_t::elu_unitalpha, lo, hi
+				, [&iM, this]() { iM.elu_unitalpha_st(m_A); }, [&iM, this]() { iM.elu_unitalpha_mt(m_A); });
+			_tune("delu_unitalpha", Thresholds_t::delu_unitalpha, lo, hi
+				, [&iM, this]() { iM.delu_unitalpha_st(m_A); }, [&iM, this]() { iM.delu_unitalpha_mt(m_A); });
+			_tune("elogu", Thresholds_t::elogu, lo, hi
+				, [&iM, this, alpha, b]() { iM.elogu_st(m_A, alpha, b); }, [&iM, this, alpha, b]() { iM.elogu_mt(m_A, alpha, b); });
+			_tune("delogu", Thresholds_t::delogu, lo, hi
+				, [&iM, this, alpha, b]() { iM.delogu_st(m_A, alpha, b); }, [&iM, this, alpha, b]() { iM.delogu_mt(m_A, alpha, b); });
+			_tune("loglogu", Thresholds_t::loglogu, lo, hi
+				, [&iM, this, b]() { iM.loglogu_st(m_A, b, b); }, [&iM, this, b]() { iM.loglogu_mt(m_A, b, b); });
+			_tune("dloglogu", Thresholds_t::dloglogu, lo, hi
+				, [&iM, this, b]() { iM.dloglogu_st(m_A, b, b); }, [&iM, this, b]() { iM.dloglogu_mt(m_A, b, b); });
+			_tune("softsign", Thresholds_t::softsign, lo, hi
+				, [&iM, this, a, c]() { iM.softsign_st(m_A, a, c); }, [&iM, this, a, c]() { iM.softsign_mt(m_A, a, c); });
+			_tune("dsoftsign", Thresholds_t::dsoftsign, real_t(-1), real_t(1)
+				, [&iM, this, a, c]() { iM.dsoftsign_st(m_A, a, c); }, [&iM, this, a, c]() { iM.dsoftsign_mt(m_A, a, c); });
+			_tune("softsigm", Thresholds_t::softsigm, lo, hi
+				, [&iM, this, a]() { iM.softsigm_st(m_A, a); }, [&iM, this, a]() { iM.softsigm_mt(m_A, a); });
+			_tune("dsoftsigm", Thresholds_t::dsoftsigm, flo, fhi
+				, [&iM, this, a]() { iM.dsoftsigm_st(m_A, a); }, [&iM, this, a]() { iM.dsoftsigm_mt(m_A, a); });
+			_tune("selu", Thresholds_t::selu, lo, hi
+				, [&iM, this, atl, lambda]() { iM.selu_st(m_A, atl, lambda); }, [&iM, this, atl, lambda]() { iM.selu_mt(m_A, atl, lambda); });
+			_tune("dselu", Thresholds_t::dselu, lo, hi
+				, [&iM, this, atl, lambda]() { iM.dselu_st(m_A, atl, lambda); }, [&iM, this, atl, lambda]() { iM.dselu_mt(m_A, atl, lambda); });
+			_tune("step", Thresholds_t::step, lo, hi, [&iM, this]() { iM.step_st(m_A); }, [&iM, this]() { iM.step_mt(m_A); });
+		}
+
+		void _run_optimizers()noexcept {
+			auto& iM = m_iM;
+			_tune("RMSProp_Hinton", Thresholds_t::RMSProp_Hinton, real_t(-1), real_t(1)
+				, [&iM, this]() { iM.RMSProp_Hinton_st(m_A, m_B, real_t(.01), real_t(.9), real_t(1e-6)); }
+				, [&iM, this]() { iM.RMSProp_Hinton_mt(m_A, m_B, real_t(.01), real_t(.9), real_t(1e-6)); }, real_t(0), real_t(1));
+			_tune("RProp", Thresholds_t::RProp, real_t(-1), real_t(1)
+				, [&iM, this]() { iM.RProp_st(m_A, real_t(.01)); }
+				, [&iM, this]() { iM.RProp_mt(m_A, real_t(.01)); });
+			_tune("ModProp", Thresholds_t::ModProp, real_t(-1), real_t(1)
+				, [&iM, this]() { iM.ModProp_st(m_A, m_B, real_t(.01), real_t(.9), real_t(1e-6)); }
+				, [&iM, this]() { iM.ModProp_mt(m_A, m_B, real_t(.01), real_t(.9), real_t(1e-6)); }, real_t(0), real_t(1));
+		}
 	};
 
 }
-}
\ No newline at end of file
+}
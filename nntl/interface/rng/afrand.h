@@ -36,6 +36,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../../../_extern/agner.org/AF_randomc_h/random.h"
 
 #include "../_i_rng.h"
+#include "afrand_state.h"
 
 namespace nntl {
 namespace rng {
@@ -45,10 +46,23 @@ namespace rng {
 	public:
 		typedef AgnerFogRNG base_rng_t;
 
-		AFRand()noexcept : m_rng(static_cast<int>(s64to32(::std::time(0)))) {}
-		AFRand(seed_t s)noexcept : m_rng(static_cast<int>(s)) {}
+		typedef _impl::afrand_state<base_rng_t> state_t;
 
-		void seed(seed_t s) noexcept { m_rng.RandomInit(static_cast<int>(s)); }
+		AFRand()noexcept : AFRand(static_cast<seed_t>(s64to32(::std::time(0)))) {}
+		AFRand(seed_t s)noexcept : m_rng(static_cast<int>(s)), m_lastSeed(static_cast<int>(s)) {}
+
+		void seed(seed_t s) noexcept {
+			m_rng.RandomInit(static_cast<int>(s));
+			m_lastSeed = static_cast<int>(s);
+		}
+
+		void seek_epoch(const uint64_t e)noexcept {
+			int sd[3];
+			sd[0] = m_lastSeed;
+			sd[1] = static_cast<int>(static_cast<uint32_t>(e));
+			sd[2] = static_cast<int>(static_cast<uint32_t>(e >> 32));
+			m_rng.RandomInitByArray(sd, 3);
+		}
 
 		// int_4_random_shuffle_t is either int on 32bits or int64 on 64bits
 		int_4_random_shuffle_t gen_i(int_4_random_shuffle_t lessThan)noexcept {
@@ -107,6 +121,42 @@ namespace rng {
 	protected:
 		//AFog::CRandomMersenne m_rng;
 		base_rng_t m_rng;
+		int m_lastSeed;
+
+		//////////////////////////////////////////////////////////////////////////
+		//Serialization support
+	private:
+		friend class ::boost::serialization::access;
+		template<class Archive>
+		void save(Archive & ar, const unsigned int version) const {
+			NNTL_UNREF(version);
+			typename state_t::state_mtx_t rngState;
+			if (!state_t::save(rngState, &m_rng, 1)) {
+				STDCOUTL("*** Failed to allocate memory to save the state of AFRand");
+				return;
+			}
+			ar & NNTL_SERIALIZATION_NVP(m_lastSeed);
+			ar & NNTL_SERIALIZATION_NVP(rngState);
+		}
+		template<class Archive>
+		void load(Archive & ar, const unsigned int version) {
+			NNTL_UNREF(version);
+			int lastSeed = m_lastSeed;
+			typename state_t::state_mtx_t rngState;
+			ar & serialization::make_nvp("m_lastSeed", lastSeed);
+			ar & NNTL_SERIALIZATION_NVP(rngState);
+			if (ar.success()) {
+				if (state_t::load(&m_rng, 1, rngState)) {
+					m_lastSeed = lastSeed;
+				} else {
+					STDCOUTL("*** Saved state doesn't match the generator of AFRand");
+					ar.mark_invalid_var();
+				}
+			} else {
+				STDCOUTL("*** Failed to read the state of AFRand, " << ar.get_last_error_str());
+			}
+		}
+		BOOST_SERIALIZATION_SPLIT_MEMBER()
 	};
 
 }
@@ -37,6 +37,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // background threads permanently working with a huge memory buffer contaminates processor's cache and cause much more cache misses
 // for main algorithms. Cache misses actually slows down computations significantly more than a synchronous RNG.
 // Leave the code here, thought it's kinda at max "early beta" quality.
+//
+//The buffers are sized to hold bufsizeMul batches worth of data. The per batch demand is taken from the preinit_additive_*()
+// calls and then learned from the actual requests between the on_train_batch_begin() calls. Every on_train_batch_begin()
+// also posts high priority refill jobs to the workers. If a buffer runs dry, the requester gets whatever is ready and
+// the rest is generated inline by the synchronous _AFRand_mt.
+//
+//Checkpoints save the state of the synchronous generators and the learned demand only (see save()). Note, that what
+// a background thread generates and which part of a request is served from the buffers depends on threads scheduling,
+// so this RNG never reproduces a sequence exactly, with or without checkpoints.
 
 
 #include "afrand_mt.h"
@@ -68,6 +77,16 @@ namespace rng {
 					return ptr->_as_norm(t);
 				}
 			};
+
+			template<class T>
+			struct Call_refill {
+				T*const ptr;
+
+				Call_refill(T*const p)noexcept:ptr(p) {}
+				void operator()(const thread_id_t t) {
+					ptr->_as_refill(t);
+				}
+			};
 		}
 
 		template<typename RealT, typename AgnerFogRNG>
@@ -85,14 +104,13 @@ namespace rng {
 
 			struct BgThreadCtx {
 				base_rng_t Rng;
-				::std::normal_distribution<real_t> normDistr;
 				real_t* pTmpMem;
 
 				~BgThreadCtx()noexcept {
 					pTmpMem = nullptr;
 				}
-				BgThreadCtx(const int RgSeed, real_t*const pMem, const real_t ndMean, const real_t ndStdev)noexcept
-					: Rng(RgSeed), normDistr(ndMean, ndStdev), pTmpMem(pMem)
+				BgThreadCtx(const int RgSeed, real_t*const pMem)noexcept
+					: Rng(RgSeed), pTmpMem(pMem)
 				{}
 			};
 
@@ -111,6 +129,7 @@ namespace rng {
 			static constexpr real_t normal_distr_stdev = real_t(1.);
 
 			typedef _impl::Call_norm<self_t> call_norm_t;
+			typedef _impl::Call_refill<self_t> call_refill_t;
 
 			static constexpr real_t threadmemMul = real_t(20);
 			static constexpr size_t thread_mem_count4_normal_distr = size_t(threadmemMul*Thresholds_t::bnd_normal_vector);
@@ -143,9 +162,26 @@ namespace rng {
 			
 			//size_t m_bufferSize_normal_distr{ 0 }, m_bufferSize_norm{ 0 };
 			::std::array<size_t, maxTasksCount> ma_bufferSize;
+			//expected per batch demand. Set by preinit_additive_*() and updated by on_train_batch_begin() with the observed one
+			::std::array<size_t, maxTasksCount> ma_batchNeed;
+			//amount of data requested since the last on_train_batch_begin()
+			::std::array<size_t, maxTasksCount> ma_requested;
+			//amount of data generated inline since init_rng(), because the buffer was dry
+			::std::array<size_t, maxTasksCount> ma_inlineCnt;
+
+			//count of posted refill jobs that haven't finished yet
+			::std::atomic<unsigned> m_refillsPending{ 0 };
+			//count of checkpoint restorations since the last seed() or seek_epoch(), see save()
+			uint64_t m_bgReseeds{ 0 };
+			bool m_bRngInit{ false };
+			bool m_bBatchSeen{ false };
+
+			//the demand read from a checkpoint. Consumed by the next _make_buffers()
+			::std::array<size_t, maxTasksCount> ma_restoredNeed;
 
 			call_normal_distr_t m_call_normal_distr{ this };
 			call_norm_t m_call_norm{ this };
+			call_refill_t m_call_refill{ this };
 
 		public:
 			~AsynchRng()noexcept {
@@ -158,6 +194,10 @@ namespace rng {
 			}
 			AsynchRng()noexcept {// : m_bgThreads(threads::PriorityClass::threads_priority_no_change) {
 				::std::fill(ma_bufferSize.begin(), ma_bufferSize.end(), size_t(0));
+				::std::fill(ma_batchNeed.begin(), ma_batchNeed.end(), size_t(0));
+				::std::fill(ma_requested.begin(), ma_requested.end(), size_t(0));
+				::std::fill(ma_inlineCnt.begin(), ma_inlineCnt.end(), size_t(0));
+				::std::fill(ma_restoredNeed.begin(), ma_restoredNeed.end(), size_t(0));
 			}
 
 		protected:
@@ -206,7 +246,7 @@ namespace rng {
 				mas_ThreadCtx.reserve(wc);
 
 				for (unsigned i = 0; i < wc; ++i) {
-					mas_ThreadCtx.emplace_back(s + i, pTM, normal_distr_mean, normal_distr_stdev);
+					mas_ThreadCtx.emplace_back(s + i, pTM);
 					pTM += maxSize;
 				}
 			}
@@ -214,6 +254,7 @@ namespace rng {
 		public:
 			void seed(int s, const thread_id_t syncWc) noexcept {
 				NNTL_ASSERT(mas_ThreadCtx.size());
+				m_bgReseeds = 0;
 				auto& ctx = mas_ThreadCtx;
 				m_bgThreads.exec([s, &ctx, syncWc](const thread_id_t tId) {
 					int sd[2];
@@ -223,6 +264,35 @@ namespace rng {
 				});
 			}
 
+			//the bg generator tId is seeded with {s, tId+syncWc, lo32(e), hi32(e)}. The pregenerated data is dropped.
+			void seek_epoch(const int s, const uint64_t e, const thread_id_t syncWc)noexcept {
+				m_bgReseeds = 0;
+				_reseed_bg(s, syncWc, e, 4);
+			}
+
+		protected:
+			//seeds the bg generator tId with the first sdCnt of {s, tId+syncWc, lo32(v), hi32(v), 1}
+			void _reseed_bg(const int s, const thread_id_t syncWc, const uint64_t v, const int sdCnt)noexcept {
+				NNTL_ASSERT(mas_ThreadCtx.size() && (4 == sdCnt || 5 == sdCnt));
+				const bool bBuffers = !!m_pMainBuffer;
+				//stops the background generation, so the generators could be reseeded from here
+				if (bBuffers) _free_buffers();
+
+				int sd[5];
+				sd[0] = s;
+				sd[2] = static_cast<int>(static_cast<uint32_t>(v));
+				sd[3] = static_cast<int>(static_cast<uint32_t>(v >> 32));
+				sd[4] = 1;
+				const auto wc = mas_ThreadCtx.size();
+				for (size_t tId = 0; tId < wc; ++tId) {
+					sd[1] = static_cast<int>(tId + syncWc);
+					mas_ThreadCtx[tId].Rng.RandomInitByArray(sd, sdCnt);
+				}
+
+				if (bBuffers) _make_buffers();
+			}
+
+		public:
 			auto& bgThreads()noexcept {
 				return m_bgThreads;
 			}
@@ -230,22 +300,129 @@ namespace rng {
 			//////////////////////////////////////////////////////////////////////////
 			//////////////////////////////////////////////////////////////////////////
 			void preinit_additive_normal_distr(const numel_cnt_t ne)noexcept {
-				//m_bufferSize_normal_distr += ne;
-				ma_bufferSize[static_cast<size_t>(_TaskId::normal_distr)] += ne;
+				ma_batchNeed[static_cast<size_t>(_TaskId::normal_distr)] += ne;
 			}
 
 			void preinit_additive_norm(const numel_cnt_t ne)noexcept {
-				//m_bufferSize_norm += ne;
-				ma_bufferSize[static_cast<size_t>(_TaskId::vector_norm)] += ne;
+				ma_batchNeed[static_cast<size_t>(_TaskId::vector_norm)] += ne;
 			}
 
 			bool init_rng()noexcept {
-				if (m_pMainBuffer) {
+				if (m_bRngInit) {
 					STDCOUTL("Double initialization of " << NNTL_FUNCTION);
 					abort();
 				}
+				m_bRngInit = true;
+				m_bBatchSeen = false;
+				::std::fill(ma_requested.begin(), ma_requested.end(), size_t(0));
+				::std::fill(ma_inlineCnt.begin(), ma_inlineCnt.end(), size_t(0));
+				return _make_buffers();
+			}
+			bool isInitialized()const noexcept {
+				return !!m_pMainBuffer;
+			}
+			void deinit_rng()noexcept {
+				_free_buffers();
+				::std::fill(ma_batchNeed.begin(), ma_batchNeed.end(), size_t(0));
+				m_bRngInit = false;
+			}
 
-				for (auto& b : ma_bufferSize) b *= bufsizeMul;
+			//must be called by the training loop before every training batch. Learns the per batch demand, grows the buffers
+			// if necessary and posts the refill jobs, so the data for the next batch is being prepared while the current
+			// one is processed. Requests made before the first call (such as weights initialization) are not counted.
+			void on_train_batch_begin()noexcept {
+				if (!m_bRngInit) return;
+
+				if (m_bBatchSeen) {
+					bool bGrow = false;
+					for (size_t i = 0; i < maxTasksCount; ++i) {
+						if (ma_requested[i] > ma_batchNeed[i]) {
+							ma_batchNeed[i] = ma_requested[i];
+							bGrow = true;
+						}
+					}
+					if (bGrow) {
+						//the pregenerated data is lost, but it happens only until the biggest batch has been seen
+						_free_buffers();
+						//if it fails, everything is just generated inline
+						_make_buffers();
+					}
+				} else m_bBatchSeen = true;
+
+				::std::fill(ma_requested.begin(), ma_requested.end(), size_t(0));
+				_post_refills();
+			}
+
+			//total size of the buffers for the pregenerated data. Zero until some demand is known
+			size_t buffer_size()const noexcept {
+				return ::std::accumulate(ma_bufferSize.begin(), ma_bufferSize.end(), size_t(0));
+			}
+
+			//total amount of data generated inline since init_rng(), because the buffers were dry
+			size_t inline_generated()const noexcept {
+				return ::std::accumulate(ma_inlineCnt.begin(), ma_inlineCnt.end(), size_t(0));
+			}
+
+			//////////////////////////////////////////////////////////////////////////
+			//Serialization support. It's not a standalone object, _AFRand_as calls these after the synchronous part.
+			// 
+			//The background generators and the pregenerated data are changed by the running background threads, so they
+			// can't be saved without stopping the threads. Only the learned per batch demand and the count of restorations
+			// are saved. load() reseeds the background generators with {s, tId+syncWc, lo32(r), hi32(r), 1}, where r is the
+			// restorations count including this one, so a restored object doesn't repeat the background streams of the run
+			// it was saved from.
+		protected:
+			static const char* _task_need_name(const size_t i)noexcept {
+				static constexpr const char* names[maxTasksCount] = { "normal_distr_need", "vector_norm_need" };
+				return names[i];
+			}
+
+			template<class Archive>
+			void save(Archive & ar, const unsigned int version) const {
+				NNTL_UNREF(version);
+				uint64_t bgReseeds = m_bgReseeds;
+				ar & NNTL_SERIALIZATION_NVP(bgReseeds);
+				for (size_t i = 0; i < maxTasksCount; ++i) {
+					uint64_t need = ma_batchNeed[i];
+					ar & serialization::make_nvp(_task_need_name(i), need);
+				}
+			}
+
+			template<class Archive>
+			void load(Archive & ar, const unsigned int version, const int s, const thread_id_t syncWc) {
+				NNTL_UNREF(version);
+				NNTL_ASSERT(mas_ThreadCtx.size());
+				uint64_t bgReseeds = 0;
+				::std::array<uint64_t, maxTasksCount> aNeed;
+				ar & NNTL_SERIALIZATION_NVP(bgReseeds);
+				for (size_t i = 0; i < maxTasksCount; ++i) {
+					aNeed[i] = 0;
+					ar & serialization::make_nvp(_task_need_name(i), aNeed[i]);
+				}
+				if (!ar.success()) {
+					STDCOUTL("*** Failed to read the state of AsynchRng, " << ar.get_last_error_str());
+					return;
+				}
+
+				for (size_t i = 0; i < maxTasksCount; ++i) ma_restoredNeed[i] = static_cast<size_t>(aNeed[i]);
+				m_bgReseeds = bgReseeds + 1;
+				_reseed_bg(s, syncWc, m_bgReseeds, 5);
+			}
+
+			DataBuffer_t& _buffer(const size_t i)noexcept {
+				NNTL_ASSERT(m_pMainBuffer && ma_bufferSize[i]);
+				auto& r = *reinterpret_cast<DataBuffer_t*>(&ma_Storage[i]);
+				NNTL_ASSERT(r.isInitialized());
+				return r;
+			}
+
+			bool _make_buffers()noexcept {
+				NNTL_ASSERT(!m_pMainBuffer);
+				for (size_t i = 0; i < maxTasksCount; ++i) {
+					ma_batchNeed[i] = ::std::max(ma_batchNeed[i], ma_restoredNeed[i]);
+					ma_restoredNeed[i] = 0;
+					ma_bufferSize[i] = static_cast<size_t>(bufsizeMul*ma_batchNeed[i]);
+				}
 
 				const size_t totalBufferSize = ::std::accumulate(ma_bufferSize.begin(), ma_bufferSize.end(), size_t(0));
 				if (!totalBufferSize) return true;
@@ -254,9 +431,11 @@ namespace rng {
 				//#todo preconditions on generateable thread buffers size for _as_should_work
 
 				m_pMainBuffer = ::new(::std::nothrow) real_t[totalBufferSize];
-				if (!m_pMainBuffer) return false;
+				if (!m_pMainBuffer) {
+					::std::fill(ma_bufferSize.begin(), ma_bufferSize.end(), size_t(0));
+					return false;
+				}
 
-				unsigned int tc{ 0 };
 				real_t* ptrBuf = m_pMainBuffer;
 
 				for (size_t i = 0; i < maxTasksCount; ++i) {
@@ -264,12 +443,20 @@ namespace rng {
 					if (bufSize) {
 						new(&ma_Storage[i]) DataBuffer_t(ptrBuf, bufSize);
 						ptrBuf += bufSize;
-						++tc;
 					} else {
 						new(&ma_Storage[i]) DataBuffer_t();
 					}
 				}
 
+				_start_bg();
+				return true;
+			}
+
+			void _start_bg()noexcept {
+				NNTL_ASSERT(m_pMainBuffer);
+				unsigned int tc{ 0 };
+				for (const auto s : ma_bufferSize) if (s) ++tc;
+
 				m_bgThreads.expect_tasks_count(tc);
 				if (ma_bufferSize[static_cast<size_t>(_TaskId::normal_distr)]) {
 					m_bgThreads.add_task(m_call_normal_distr);
@@ -277,13 +464,17 @@ namespace rng {
 				if (ma_bufferSize[static_cast<size_t>(_TaskId::vector_norm)]) {
 					m_bgThreads.add_task(m_call_norm);
 				}
-				return true;
-			}
-			bool isInitialized()const noexcept {
-				return !!m_pMainBuffer;
 			}
-			void deinit_rng()noexcept {
+
+			void _stop_bg()noexcept {
+				//waits for the running tasks to finish
 				m_bgThreads.delete_tasks();
+				//the posted refills might be still running or waiting in the queue
+				while (m_refillsPending.load(::std::memory_order_acquire)) ::std::this_thread::yield();
+			}
+
+			void _free_buffers()noexcept {
+				_stop_bg();
 
 				if (m_pMainBuffer) {
 					for (auto& e : ma_Storage) {
@@ -297,6 +488,19 @@ namespace rng {
 				::std::fill(ma_bufferSize.begin(), ma_bufferSize.end(), size_t(0));
 			}
 
+			//one job per worker is enough, they share the generation through DataBuffer::_as_should_work()
+			void _post_refills()noexcept {
+				if (!m_pMainBuffer) return;
+				const unsigned wc = m_bgThreads.workers_count();
+				for (unsigned i = m_refillsPending.load(::std::memory_order_relaxed); i < wc; ++i) {
+					m_refillsPending.fetch_add(1, ::std::memory_order_relaxed);
+					if (!m_bgThreads.post(m_call_refill, bgworkers_t::priority_lanes - 1)) {
+						m_refillsPending.fetch_sub(1, ::std::memory_order_relaxed);
+						break;
+					}
+				}
+			}
+
 			//////////////////////////////////////////////////////////////////////////
 			//////////////////////////////////////////////////////////////////////////
 		protected:
@@ -312,27 +516,31 @@ namespace rng {
 				static constexpr result_type max() noexcept { return ::std::numeric_limits<result_type>::max(); }
 			};
 
+			//copies to ptr as much of the requested data as is ready and returns its count
 			template<_TaskId _tsk>
-			bool _move_data(real_t*const ptr, const size_t n)noexcept {
+			size_t _move_data(real_t*const ptr, const size_t n)noexcept {
 				static constexpr size_t tsk = static_cast<size_t>(_tsk);
 
-				NNTL_ASSERT(m_pMainBuffer && ma_bufferSize[tsk]);
-				if (!m_pMainBuffer || !ma_bufferSize[tsk])return false;
-
-				auto& Buf = *reinterpret_cast<DataBuffer_t*>(&ma_Storage[tsk]);
-				NNTL_ASSERT(Buf.isInitialized());
-
-				const auto br = Buf.acquire_data(n);
-				if (!br.acquired()) return false;
-
-				::std::memcpy(ptr, br.ptr1, sizeof(real_t)*br.n1);
-				if (br.isTwoArrays()) {
-					NNTL_ASSERT(n == br.n1 + br.n2);
-					::std::memcpy(ptr + br.n1, br.ptr2, sizeof(real_t)*br.n2);
-				} else NNTL_ASSERT(n == br.n1);
-
-				Buf.release_data(br);
-				return true;
+				ma_requested[tsk] += n;
+				size_t r = 0;
+				if (m_pMainBuffer && ma_bufferSize[tsk]) {
+					auto& Buf = *reinterpret_cast<DataBuffer_t*>(&ma_Storage[tsk]);
+					NNTL_ASSERT(Buf.isInitialized());
+
+					const auto br = Buf.acquire_available(n);
+					if (br.acquired()) {
+						::std::memcpy(ptr, br.ptr1, sizeof(real_t)*br.n1);
+						r = br.n1;
+						if (br.isTwoArrays()) {
+							::std::memcpy(ptr + r, br.ptr2, sizeof(real_t)*br.n2);
+							r += br.n2;
+						}
+						NNTL_ASSERT(r <= n);
+						Buf.release_data(br);
+					}
+				}
+				ma_inlineCnt[tsk] += n - r;
+				return r;
 			}
 
 		public:
@@ -346,12 +554,13 @@ namespace rng {
 
 				auto& Ctx = mas_ThreadCtx[tId];
 				real_t*const pTmpMem = Ctx.pTmpMem;
-				auto& distr = Ctx.normDistr;
-				rgWrapper Rng = { Ctx.Rng };
-				
+				auto& rg = Ctx.Rng;
+
 				for (size_t i = 0; i < genSize; ++i) {
-					pTmpMem[i] = distr(Rng);
+					pTmpMem[i] = static_cast<real_t>(rg.Random());
 				}
+				math::simd::ziggurat<real_t>::transform(pTmpMem, genSize, normal_distr_mean, normal_distr_stdev
+					, [&rg](const size_t) { return [&rg]() { return static_cast<uint32_t>(rg.BRandom()); }; });
 
 				Buf._as_done(pTmpMem, genSize);
 				return true;
@@ -374,6 +583,17 @@ namespace rng {
 				return true;
 			}
 
+			void _as_refill(const thread_id_t tId)noexcept {
+				const bool bNormalDistr = !!ma_bufferSize[static_cast<size_t>(_TaskId::normal_distr)]
+					, bNorm = !!ma_bufferSize[static_cast<size_t>(_TaskId::vector_norm)];
+				bool bWork = true;
+				while (bWork) {
+					bWork = bNormalDistr && _as_normal_distr(tId);
+					bWork = (bNorm && _as_norm(tId)) || bWork;
+				}
+				m_refillsPending.fetch_sub(1, ::std::memory_order_release);
+			}
+
 			//////////////////////////////////////////////////////////////////////////
 			//////////////////////////////////////////////////////////////////////////
 		protected:
@@ -401,10 +621,12 @@ namespace rng {
 				}
 			}
 		public:
-			bool normal_vector(real_t*const ptr, const size_t n, const real_t m, const real_t st)noexcept {
-				if (!_move_data<_TaskId::normal_distr>(ptr, n)) return false;
-				_apply_scaling(ptr, n, st, m, normal_distr_stdev, normal_distr_mean);
-				return true;
+			//the following functions fill the beginning of ptr with the pregenerated data and return its count. The caller
+			// is responsible for generating the rest.
+			size_t normal_vector(real_t*const ptr, const size_t n, const real_t m, const real_t st)noexcept {
+				const auto r = _move_data<_TaskId::normal_distr>(ptr, n);
+				_apply_scaling(ptr, r, st, m, normal_distr_stdev, normal_distr_mean);
+				return r;
 			}
 
 			/*BufferRange_t acquire_standard_normal_distr(const size_t n)noexcept {
@@ -426,13 +648,13 @@ namespace rng {
 
 			//////////////////////////////////////////////////////////////////////////
 
-			bool gen_vector_norm(real_t*const ptr, const size_t n)noexcept {
+			size_t gen_vector_norm(real_t*const ptr, const size_t n)noexcept {
 				return _move_data<_TaskId::vector_norm>(ptr, n);
 			}
-			bool gen_vector_uni(const real_t span, const real_t ofs, real_t*const ptr, const size_t n)noexcept {
-				if (!_move_data<_TaskId::vector_norm>(ptr, n)) return false;
-				_apply_scaling(ptr, n, span, ofs, real_t(1.), real_t(0.));
-				return true;
+			size_t gen_vector_uni(const real_t span, const real_t ofs, real_t*const ptr, const size_t n)noexcept {
+				const auto r = _move_data<_TaskId::vector_norm>(ptr, n);
+				_apply_scaling(ptr, r, span, ofs, real_t(1.), real_t(0.));
+				return r;
 			}
 		};
 
@@ -453,7 +675,21 @@ namespace rng {
 		typedef as::AsynchRng<RealT, AgnerFogRNG> asynch_rng_t;
 		typedef _base_class_t mt_rng_t;
 
-	protected:
+		//////////////////////////////////////////////////////////////////////////
+		//Serialization support
+	private:
+		friend class ::boost::serialization::access;
+		template<class Archive>
+		void save(Archive & ar, const unsigned int version) const {
+			_base_class_t::save(ar, version);
+			asynch_rng_t::save(ar, version);
+		}
+		template<class Archive>
+		void load(Archive & ar, const unsigned int version) {
+			_base_class_t::load(ar, version);
+			if (ar.success()) asynch_rng_t::load(ar, version, m_lastSeed, m_pThreads->workers_count());
+		}
+		BOOST_SERIALIZATION_SPLIT_MEMBER()
 
 	public:
 		~_AFRand_as()noexcept {}
@@ -482,6 +718,11 @@ namespace rng {
 			asynch_rng_t::seed(s, m_pThreads->workers_count());
 		}
 
+		void seek_epoch(const uint64_t e)noexcept {
+			_base_class_t::seek_epoch(e);
+			asynch_rng_t::seek_epoch(m_lastSeed, e, m_pThreads->workers_count());
+		}
+
 		void preinit_additive_normal_distr(const numel_cnt_t ne)noexcept {
 			_base_class_t::preinit_additive_normal_distr(ne);
 			asynch_rng_t::preinit_additive_normal_distr(ne);
@@ -500,6 +741,9 @@ namespace rng {
 			_base_class_t::deinit_rng();
 			asynch_rng_t::deinit_rng();
 		}
+		void on_train_batch_begin()noexcept {
+			asynch_rng_t::on_train_batch_begin();
+		}
 
 
 		//////////////////////////////////////////////////////////////////////////
@@ -514,25 +758,19 @@ namespace rng {
 		//////////////////////////////////////////////////////////////////////////
 		// matrix/vector generation (sequence from begin to end of numbers drawn from uniform distribution in [-a,a])
 		void gen_vector(real_t* ptr, const size_t n, const real_t a)noexcept {
-			if (!asynch_rng_t::gen_vector_uni(a*real_t(2), -a, ptr, n)) {
-				STDCOUT("_GVa!");
-				_base_class_t::gen_vector(ptr, n, a);
-			}
+			const auto k = asynch_rng_t::gen_vector_uni(a*real_t(2), -a, ptr, n);
+			if (k < n) _base_class_t::gen_vector(ptr + k, n - k, a);
 		}
 		void gen_vector(real_t* ptr, const size_t n, const real_t neg, const real_t pos)noexcept {
-			if (!asynch_rng_t::gen_vector_uni(pos - neg, neg, ptr, n)) {
-				STDCOUT("_GVnp!");
-				_base_class_t::gen_vector(ptr, n, neg, pos);
-			}
+			const auto k = asynch_rng_t::gen_vector_uni(pos - neg, neg, ptr, n);
+			if (k < n) _base_class_t::gen_vector(ptr + k, n - k, neg, pos);
 		}
 		//////////////////////////////////////////////////////////////////////////
 		//////////////////////////////////////////////////////////////////////////
 		//generate vector with values in range [0,1]
 		void gen_vector_norm(real_t* ptr, const size_t n)noexcept {
-			if (!asynch_rng_t::gen_vector_norm(ptr, n)) {
-				STDCOUT("_GVN!");
-				_base_class_t::gen_vector_norm(ptr, n);
-			}
+			const auto k = asynch_rng_t::gen_vector_norm(ptr, n);
+			if (k < n) _base_class_t::gen_vector_norm(ptr + k, n - k);
 		}
 
 		//////////////////////////////////////////////////////////////////////////
@@ -635,10 +873,8 @@ namespace rng {
 		///////////////////////////////////////////////////////////////////////////
 		//////////////////////////////////////////////////////////////////////////
 		void normal_vector(real_t*const ptr, const size_t n, const real_t m = real_t(0.), const real_t st = real_t(1.))noexcept {
-			if (!asynch_rng_t::normal_vector(ptr, n, m, st)) {
-				STDCOUT("_NV!");
-				_base_class_t::normal_vector(ptr, n, m, st);
-			}
+			const auto k = asynch_rng_t::normal_vector(ptr, n, m, st);
+			if (k < n) _base_class_t::normal_vector(ptr + k, n - k, m, st);
 		}
 
 	};
@@ -39,6 +39,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../_i_threads.h"
 
 #include "AFRAND_MT_THR.h"
+#include "afrand_state.h"
 
 namespace nntl {
 	namespace rng {
@@ -55,6 +56,7 @@ namespace nntl {
 			//typedef typename iThreads_t::thread_id_t thread_id_t;
 
 			typedef _impl::AFRAND_MT_THR<base_rng_t,real_t> Thresholds_t;
+			typedef _impl::afrand_state<base_rng_t> state_t;
 
 		protected:
 			typedef ::std::vector<base_rng_t> rng_vector_t;
@@ -68,6 +70,46 @@ namespace nntl {
 
 			int m_lastSeed{ 0 };
 
+			//////////////////////////////////////////////////////////////////////////
+			//Serialization support
+			//Every per thread generator is saved, therefore the state could be loaded only into an object with the same
+			// workers count.
+		protected:
+			friend class ::boost::serialization::access;
+			template<class Archive>
+			void save(Archive & ar, const unsigned int version) const {
+				NNTL_UNREF(version);
+				NNTL_ASSERT(m_pThreads && !m_Rngs.empty());
+				typename state_t::state_mtx_t rngState;
+				if (!state_t::save(rngState, m_Rngs.data(), static_cast<vec_len_t>(m_Rngs.size()))) {
+					STDCOUTL("*** Failed to allocate memory to save the state of AFRand_mt");
+					return;
+				}
+				ar & NNTL_SERIALIZATION_NVP(m_lastSeed);
+				ar & NNTL_SERIALIZATION_NVP(rngState);
+			}
+			template<class Archive>
+			void load(Archive & ar, const unsigned int version) {
+				NNTL_UNREF(version);
+				NNTL_ASSERT(m_pThreads && !m_Rngs.empty());
+				int lastSeed = m_lastSeed;
+				typename state_t::state_mtx_t rngState;
+				ar & serialization::make_nvp("m_lastSeed", lastSeed);
+				ar & NNTL_SERIALIZATION_NVP(rngState);
+				if (ar.success()) {
+					if (state_t::load(m_Rngs.data(), static_cast<vec_len_t>(m_Rngs.size()), rngState)) {
+						m_lastSeed = lastSeed;
+					} else {
+						STDCOUTL("*** Saved state of AFRand_mt has " << rngState.cols() << " generators, but there are "
+							<< m_Rngs.size() << " workers");
+						ar.mark_invalid_var();
+					}
+				} else {
+					STDCOUTL("*** Failed to read the state of AFRand_mt, " << ar.get_last_error_str());
+				}
+			}
+			BOOST_SERIALIZATION_SPLIT_MEMBER()
+
 		private:
 			void _construct_rngs(const int s)noexcept {
 				NNTL_ASSERT(::std::thread::hardware_concurrency() > 1 || !"There's no sense to use _mt generator in the uniprocessor system. Please use RNG from afrand.h");
@@ -109,11 +151,16 @@ namespace nntl {
 			void seed(const seed_t s) noexcept {
 				NNTL_ASSERT(m_pThreads);
 				auto& rngs = m_Rngs;
+				//iterating over the range (and not using r.tid()) to seed every generator even when the pool is capped
+				// with max_threads(). The generator i is still seeded with {s, i}
 				m_pThreads->run([s,&rngs](const par_range_t&r) {
 					int sd[2];
 					sd[0] = static_cast<int>(s);
-					sd[1] = static_cast<int>(r.tid());
-					rngs[r.tid()].RandomInitByArray(sd, 2);
+					const auto ofs = r.offset(), last = ofs + r.cnt();
+					for (auto i = ofs; i < last; ++i) {
+						sd[1] = static_cast<int>(i);
+						rngs[static_cast<size_t>(i)].RandomInitByArray(sd, 2);
+					}
 				},m_pThreads->workers_count());
 
 				//for (auto& e : m_stdNormDevs) e.reset();
@@ -122,6 +169,24 @@ namespace nntl {
 			}
 			void reseed()noexcept { get_self().seed(m_lastSeed); }
 
+			//the generator i is seeded with {last seed, i, lo32(e), hi32(e)}
+			void seek_epoch(const uint64_t e)noexcept {
+				NNTL_ASSERT(m_pThreads);
+				auto& rngs = m_Rngs;
+				const int s = m_lastSeed;
+				m_pThreads->run([s, e, &rngs](const par_range_t&r) {
+					int sd[4];
+					sd[0] = s;
+					sd[2] = static_cast<int>(static_cast<uint32_t>(e));
+					sd[3] = static_cast<int>(static_cast<uint32_t>(e >> 32));
+					const auto ofs = r.offset(), last = ofs + r.cnt();
+					for (auto i = ofs; i < last; ++i) {
+						sd[1] = static_cast<int>(i);
+						rngs[static_cast<size_t>(i)].RandomInitByArray(sd, 4);
+					}
+				}, m_pThreads->workers_count());
+			}
+
 			// int_4_random_shuffle_t is either int on 32bits or int64 on 64bits
 			int_4_random_shuffle_t gen_i(const int_4_random_shuffle_t lessThan)noexcept {
 				NNTL_ASSERT(m_pThreads);
@@ -297,6 +362,44 @@ namespace nntl {
 				}
 			}
 
+			//////////////////////////////////////////////////////////////////////////
+			//the mask is made straight from the raw 32bit integers, there's no conversion to floating point
+			void bernoulli_bits(bitmask_word_t*const pBits, const numel_cnt_t n, const real_t p)noexcept {
+				if (n < Thresholds_t::bnd_bernoulli_bits) {
+					get_self().bernoulli_bits_st(pBits, n, p);
+				} else get_self().bernoulli_bits_mt(pBits, n, p);
+			}
+			void bernoulli_bits_st(bitmask_word_t*const pBits, const numel_cnt_t n, const real_t p)noexcept {
+				NNTL_ASSERT(pBits);
+				NNTL_ASSERT(p > real_t(0) && p < real_t(1));
+				get_self()._ibernoulli_bits_st(pBits, n, p, elms_range(0, sBitMaskWords(n)), 0);
+			}
+			void bernoulli_bits_mt(bitmask_word_t*const pBits, const numel_cnt_t n, const real_t p)noexcept {
+				NNTL_ASSERT(pBits);
+				NNTL_ASSERT(p > real_t(0) && p < real_t(1));
+				m_pThreads->run([pBits, n, p, this](const par_range_t& r) {
+					get_self()._ibernoulli_bits_st(pBits, n, p, elms_range(r), r.tid());
+				}, sBitMaskWords(n));
+			}
+			//er is a range of words of pBits
+			void _ibernoulli_bits_st(bitmask_word_t*const pBits, const numel_cnt_t n, const real_t p
+				, const elms_range& er, const thread_id_t tId)noexcept
+			{
+				NNTL_ASSERT(pBits);
+				NNTL_ASSERT(p > real_t(0) && p < real_t(1));
+				auto& rg = m_Rngs[tId];
+				//BRandom() < thr with probability p
+				const uint32_t thr = static_cast<uint32_t>(static_cast<double>(p) * 4294967296.);
+				for (numel_cnt_t w = er.elmBegin; w < er.elmEnd; ++w) {
+					const unsigned cnt = static_cast<unsigned>(::std::min(numel_cnt_t(64), n - w * 64));
+					bitmask_word_t v = 0;
+					for (unsigned j = 0; j < cnt; ++j) {
+						v |= static_cast<bitmask_word_t>(rg.BRandom() < thr) << j;
+					}
+					pBits[w] = v;
+				}
+			}
+
 			/*void _ibernoulli_vector_st(real_t*const ptr, const real_t p, const real_t posVal, const real_t negVal
 				, const elms_range& er, const thread_id_t tId)noexcept
 			{
@@ -353,12 +456,12 @@ namespace nntl {
 			};
 
 		public:			
+			//Ziggurat over the uniform samples of the thread's generator (see math/simd/ziggurat.h)
 			void _inormal_vector_st(real_t*const ptr, const real_t m, const real_t st, const elms_range& er, const thread_id_t tId)noexcept {
-				::std::normal_distribution<real_t> distr(m, st);
-				rgWrapper w { m_Rngs[tId] };
-				for (size_t i = er.elmBegin; i < er.elmEnd; ++i) {
-					ptr[i] = distr(w);
-				}
+				get_self()._igen_vector_norm_st(ptr, er, tId);
+				auto& rg = m_Rngs[tId];
+				math::simd::ziggurat<real_t>::transform(ptr + er.elmBegin, static_cast<size_t>(er.totalElements()), m, st
+					, [&rg](const size_t) { return [&rg]() { return static_cast<uint32_t>(rg.BRandom()); }; });
 			}
 
 			//////////////////////////////////////////////////////////////////////////
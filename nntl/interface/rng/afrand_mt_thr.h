@@ -50,6 +50,7 @@ namespace rng {
 			static constexpr size_t bnd_gen_vector_norm = 1640;
 
 			static constexpr size_t bnd_bernoulli_vector = 1500;
+			static constexpr size_t bnd_bernoulli_bits = 1500;//nt
 			static constexpr size_t bnd_normal_vector = 1000;
 		};
 
@@ -59,6 +60,7 @@ namespace rng {
 			static constexpr size_t bnd_gen_vector_norm = 2620;
 
 			static constexpr size_t bnd_bernoulli_vector = 2500;
+			static constexpr size_t bnd_bernoulli_bits = 2500;//nt
 			static constexpr size_t bnd_normal_vector = 2000;
 		};
 
@@ -69,6 +71,7 @@ namespace rng {
 			static constexpr size_t bnd_gen_vector_norm = 3000;
 
 			static constexpr size_t bnd_bernoulli_vector = 2900;
+			static constexpr size_t bnd_bernoulli_bits = 2900;//nt
 			static constexpr size_t bnd_normal_vector = 2300;
 		};
 
@@ -80,6 +83,7 @@ namespace rng {
 			static constexpr size_t bnd_gen_vector_norm = 2900;// 1600;// 2900;
 
 			static constexpr size_t bnd_bernoulli_vector = 1700;
+			static constexpr size_t bnd_bernoulli_bits = 1700;//nt
 			static constexpr size_t bnd_normal_vector = 175;
 		};
 
@@ -89,6 +93,7 @@ namespace rng {
 			static constexpr size_t bnd_gen_vector_norm = 4200;// 2620;// 4200;
 
 			static constexpr size_t bnd_bernoulli_vector = 2250;
+			static constexpr size_t bnd_bernoulli_bits = 2250;//nt
 			static constexpr size_t bnd_normal_vector = 175;
 		};
 
@@ -98,6 +103,7 @@ namespace rng {
 			static constexpr size_t bnd_gen_vector_norm = 4400;//3000;//  4400;
 
 			static constexpr size_t bnd_bernoulli_vector = 2200;
+			static constexpr size_t bnd_bernoulli_bits = 2200;//nt
 			static constexpr size_t bnd_normal_vector = 180;
 		};
 	}
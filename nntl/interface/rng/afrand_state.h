@@ -0,0 +1,92 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//helpers to save and restore the state of Agner Fog's generators. The generators don't expose their state, however they
+// are plain structures of integers (and __m128i for SFMT) without any pointers inside, so the state is copied as raw
+// 32bit words. One column of the state matrix holds one generator.
+
+#include <cstring>
+#include <type_traits>
+#include "../math/smatrix.h"
+
+namespace nntl {
+namespace rng {
+	namespace _impl {
+
+		template<typename AgnerFogRNG>
+		struct afrand_state {
+			static_assert(::std::is_trivially_copyable<AgnerFogRNG>::value, "Generator must be trivially copyable to save its state");
+
+			typedef AgnerFogRNG base_rng_t;
+			typedef math::smatrix<uint32_t> state_mtx_t;
+
+			static constexpr vec_len_t words = static_cast<vec_len_t>((sizeof(base_rng_t) + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+
+			//getRng(c) must return a reference to the generator c
+			template<typename GetRngT>
+			static bool save_each(state_mtx_t& S, const vec_len_t cnt, GetRngT&& getRng)noexcept {
+				NNTL_ASSERT(cnt > 0);
+				S.dont_emulate_biases();
+				if (!S.resize(words, cnt)) return false;
+				S.zeros();
+				for (vec_len_t c = 0; c < cnt; ++c) {
+					const base_rng_t& rg = getRng(c);
+					::std::memcpy(S.colDataAsVec(c), &rg, sizeof(base_rng_t));
+				}
+				return true;
+			}
+			static bool save(state_mtx_t& S, const base_rng_t*const pRngs, const vec_len_t cnt)noexcept {
+				NNTL_ASSERT(pRngs);
+				return save_each(S, cnt, [pRngs](const vec_len_t c)->const base_rng_t& { return pRngs[c]; });
+			}
+
+			//returns false if the state matrix doesn't match cnt generators
+			template<typename GetRngT>
+			static bool load_each(const vec_len_t cnt, GetRngT&& getRng, const state_mtx_t& S)noexcept {
+				NNTL_ASSERT(cnt > 0);
+				if (S.emulatesBiases() || S.rows() != words || S.cols() != cnt) return false;
+				for (vec_len_t c = 0; c < cnt; ++c) {
+					base_rng_t& rg = getRng(c);
+					::std::memcpy(&rg, S.colDataAsVec(c), sizeof(base_rng_t));
+				}
+				return true;
+			}
+			static bool load(base_rng_t*const pRngs, const vec_len_t cnt, const state_mtx_t& S)noexcept {
+				NNTL_ASSERT(pRngs);
+				return load_each(cnt, [pRngs](const vec_len_t c)->base_rng_t& { return pRngs[c]; }, S);
+			}
+		};
+
+	}
+}
+}
@@ -31,7 +31,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #pragma once
 
-#include <cstdlib>      // ::std::rand, ::std::srand
+#include <cstdlib>      // rand_s
+#include <random>       // ::std::minstd_rand
+#include <sstream>
 
 // this file will be included by default.
 // It defines an interface to a rng generators, provided by STL.
@@ -59,7 +61,15 @@ namespace rng {
 			seed(s);
 		}
 
-		static void seed(seed_t s) noexcept { ::std::srand(s); }// _64to32(s)); }
+		static void seed(seed_t s) noexcept {
+			auto& st = _state();
+			st.lastSeed = s;
+			_srand(static_cast<real_seed_t>(s));
+		}
+
+		static void seek_epoch(const uint64_t e)noexcept {
+			_srand(static_cast<real_seed_t>(_state().lastSeed) ^ static_cast<real_seed_t>((e * 0x9E3779B97F4A7C15ULL) >> 32));
+		}
 
 		//////////////////////////////////////////////////////////////////////////
 		// family of generator subfunctions
@@ -117,7 +127,69 @@ namespace rng {
 		}
 		
 	protected:
-		
+		//::std::rand() state is hidden, so the values come from ::std::minstd_rand instead. Its state is a single number
+		// that is saved and restored directly. With _CRT_RAND_S the values come from the OS and can't be reproduced at all.
+		typedef ::std::minstd_rand engine_t;
+		struct _state_t {
+			seed_t lastSeed;
+			engine_t eng;
+		};
+		static _state_t& _state()noexcept {
+			static _state_t st{ 0, engine_t() };
+			return st;
+		}
+		static void _srand(const real_seed_t s)noexcept {
+			_state().eng.seed(s);
+		}
+		//the textual representation of linear_congruential_engine is its state
+		static uint64_t _engine_state()noexcept {
+			::std::stringstream ss;
+			ss << _state().eng;
+			uint64_t v = 0;
+			ss >> v;
+			return v;
+		}
+		static bool _engine_state(const uint64_t v)noexcept {
+			::std::stringstream ss;
+			ss << v;
+			engine_t e;
+			ss >> e;
+			if (ss.fail()) return false;
+			_state().eng = e;
+			return true;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		//Serialization support
+	private:
+		friend class ::boost::serialization::access;
+		template<class Archive>
+		void save(Archive & ar, const unsigned int version) const {
+			NNTL_UNREF(version);
+			seed_t lastSeed = _state().lastSeed;
+			uint64_t engState = _engine_state();
+			ar & NNTL_SERIALIZATION_NVP(lastSeed);
+			ar & NNTL_SERIALIZATION_NVP(engState);
+		}
+		template<class Archive>
+		void load(Archive & ar, const unsigned int version) {
+			NNTL_UNREF(version);
+			seed_t lastSeed = 0;
+			uint64_t engState = 0;
+			ar & NNTL_SERIALIZATION_NVP(lastSeed);
+			ar & NNTL_SERIALIZATION_NVP(engState);
+			if (!ar.success()) {
+				STDCOUTL("*** Failed to read the state of CStd, " << ar.get_last_error_str());
+			} else if (_engine_state(engState)) {
+				_state().lastSeed = lastSeed;
+			} else {
+				STDCOUTL("*** Invalid state of CStd engine " << engState);
+				ar.mark_invalid_var();
+			}
+		}
+		BOOST_SERIALIZATION_SPLIT_MEMBER()
+
+	protected:
 #ifdef _CRT_RAND_S
 		static unsigned int _rand()noexcept {
 			unsigned int v;
@@ -127,8 +199,10 @@ namespace rng {
 
 		static real_rand_max_t _rand_max()noexcept { return UINT_MAX; }
 #else
-		static int _rand()noexcept { return ::std::rand(); }
-		static real_rand_max_t _rand_max()noexcept { return RAND_MAX; }
+		static real_rand_max_t _rand()noexcept {
+			return static_cast<real_rand_max_t>(_state().eng());
+		}
+		static real_rand_max_t _rand_max()noexcept { return static_cast<real_rand_max_t>(engine_t::max()); }
 #endif // _CRT_RAND_S
 		
 
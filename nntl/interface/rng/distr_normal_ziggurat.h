@@ -0,0 +1,142 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+// rng helper, that converts uniform distribution to normal (gaussian) distribution with the vectorized Ziggurat method
+// (see math/simd/ziggurat.h). Works with any _i_rng: uniform samples are made by iRng::gen_vector_norm() and the
+// conversion is spread over iRng::ithreads() when the iRng is multithreaded.
+// Samples rejected by the fast path of the Ziggurat take their additional random bits from a counter-based Philox stream,
+// keyed by a value drawn from the iRng and indexed by the sample index. So the result depends only on the iRng state and
+// doesn't depend on how the work is split between threads.
+
+#include "../math/simd/ziggurat.h"
+#include "philox.h"
+
+namespace nntl {
+namespace rng {
+
+	namespace _impl {
+		//source of uint32_t for the slow path of the Ziggurat for the sample idx
+		class philox_sample_source {
+		protected:
+			const uint32_t* m_pKey;
+			uint32_t m_ctr[4];
+			uint32_t m_buf[4];
+			unsigned m_avail{ 0 };
+
+		public:
+			philox_sample_source(const uint32_t*const pKey, const uint64_t idx)noexcept : m_pKey(pKey) {
+				m_ctr[0] = static_cast<uint32_t>(idx);
+				m_ctr[1] = static_cast<uint32_t>(idx >> 32);
+				m_ctr[2] = m_ctr[3] = 0;
+			}
+
+			uint32_t operator()()noexcept {
+				if (!m_avail) {
+					for (unsigned i = 0; i < 4; ++i) m_buf[i] = m_ctr[i];
+					philox4x32::block(m_buf, m_pKey);
+					++m_ctr[2];
+					m_avail = 4;
+				}
+				return m_buf[--m_avail];
+			}
+		};
+	}
+
+	template <typename iRng>
+	struct distr_normal_ziggurat {
+	public:
+		typedef iRng iRng_t;
+		typedef typename iRng_t::real_t real_t;
+		typedef typename iRng_t::realmtx_t realmtx_t;
+		typedef math::simd::ziggurat<real_t> ziggurat_t;
+
+		//minimum count of elements to spread the conversion over threads
+		static constexpr size_t bnd_mt_transform = 20000;//nt
+
+	protected:
+		iRng_t& m_iR;
+		const real_t m_mean, m_stdev;
+
+	public:
+		~distr_normal_ziggurat() {}
+		distr_normal_ziggurat(iRng_t& iR, real_t mn = real_t(0.0), real_t stdev = real_t(1.0))noexcept
+			: m_iR(iR), m_mean(mn), m_stdev(stdev) {}
+
+		void gen_vector(real_t*const ptr, const size_t n)noexcept {
+			NNTL_ASSERT(ptr || !n);
+			if (!n) return;
+			m_iR.gen_vector_norm(ptr, n);
+
+			uint32_t key[2];
+			key[0] = static_cast<uint32_t>(m_iR.gen_int());
+			key[1] = static_cast<uint32_t>(m_iR.gen_int());
+
+			_transform(ptr, n, key, ::std::integral_constant<bool, iRng_t::is_multithreaded>());
+		}
+
+		void gen_matrix(realmtx_t& m)noexcept {
+			NNTL_ASSERT(!m.empty() && m.numel() > 0);
+			gen_vector(m.data(), m.numel());
+		}
+
+		void gen_matrix_no_bias(realmtx_t& m)noexcept {
+			NNTL_ASSERT(!m.empty() && m.numel_no_bias() > 0);
+			gen_vector(m.data(), m.numel_no_bias());
+		}
+
+	protected:
+		static void _transform_range(real_t*const ptr, const size_t ofs, const size_t cnt, const real_t m, const real_t st
+			, const uint32_t*const pKey)noexcept
+		{
+			ziggurat_t::transform(ptr + ofs, cnt, m, st, [pKey, ofs](const size_t k) {
+				return _impl::philox_sample_source(pKey, static_cast<uint64_t>(ofs + k));
+			});
+		}
+
+		void _transform(real_t*const ptr, const size_t n, const uint32_t*const pKey, ::std::false_type)noexcept {
+			_transform_range(ptr, 0, n, m_mean, m_stdev, pKey);
+		}
+		void _transform(real_t*const ptr, const size_t n, const uint32_t*const pKey, ::std::true_type)noexcept {
+			if (n < bnd_mt_transform) {
+				_transform(ptr, n, pKey, ::std::false_type());
+			} else {
+				typedef typename iRng_t::iThreads_t::par_range_t par_range_t;
+				m_iR.ithreads().run([ptr, pKey, m = m_mean, st = m_stdev](const par_range_t& r) {
+					_transform_range(ptr, static_cast<size_t>(r.offset()), static_cast<size_t>(r.cnt()), m, st, pKey);
+				}, n);
+			}
+		}
+	};
+
+}
+}
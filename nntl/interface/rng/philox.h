@@ -0,0 +1,574 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//Counter-based Philox4x32-10 generator (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC'11).
+// The generator has no sequential state: the value at the position i of the stream is a pure function of the key
+// (the seed) and i. Every element of a vector is produced from its own stream position, so any thread can generate any
+// slice of a matrix independently and the result doesn't depend on the number of worker threads at all.
+
+#include "../_i_rng.h"
+#include "../_i_threads.h"
+#include "../math/simd/simd.h"
+
+#include "philox_thr.h"
+
+namespace nntl {
+	namespace rng {
+
+		namespace _impl {
+
+			//bare Philox4x32-10 bijection. Stream position i maps to the word (i%4) of the block (i/4) and the block
+			// counter is {lo32(i/4), hi32(i/4), lo32(substream), hi32(substream)}
+			class philox4x32 {
+			public:
+				typedef uint64_t stream_pos_t;
+
+				static constexpr uint32_t M0 = 0xD2511F53;
+				static constexpr uint32_t M1 = 0xCD9E8D57;
+				static constexpr uint32_t W0 = 0x9E3779B9;
+				static constexpr uint32_t W1 = 0xBB67AE85;
+				static constexpr unsigned rounds = 10;
+
+			protected:
+				uint32_t m_key[2];
+				uint32_t m_substream[2];
+
+			public:
+				philox4x32(const uint64_t k = 0)noexcept { set_key(k); set_substream(0); }
+
+				void set_key(const uint64_t k)noexcept {
+					m_key[0] = static_cast<uint32_t>(k);
+					m_key[1] = static_cast<uint32_t>(k >> 32);
+				}
+				uint64_t key()const noexcept { return (static_cast<uint64_t>(m_key[1]) << 32) | m_key[0]; }
+
+				//each substream is an independent stream of 2^66 values
+				void set_substream(const uint64_t s)noexcept {
+					m_substream[0] = static_cast<uint32_t>(s);
+					m_substream[1] = static_cast<uint32_t>(s >> 32);
+				}
+				uint64_t substream()const noexcept { return (static_cast<uint64_t>(m_substream[1]) << 32) | m_substream[0]; }
+
+				static nntl_force_inline uint32_t mulhilo(const uint32_t a, const uint32_t b, uint32_t& hi)noexcept {
+					const uint64_t p = static_cast<uint64_t>(a) * b;
+					hi = static_cast<uint32_t>(p >> 32);
+					return static_cast<uint32_t>(p);
+				}
+
+				//the full 4x32 block function, ctr and key are given explicitly
+				static void block(uint32_t ctr[4], const uint32_t key[2])noexcept {
+					uint32_t k0 = key[0], k1 = key[1];
+					for (unsigned r = 0; r < rounds; ++r) {
+						uint32_t hi0, hi1;
+						const uint32_t lo0 = mulhilo(M0, ctr[0], hi0);
+						const uint32_t lo1 = mulhilo(M1, ctr[2], hi1);
+						ctr[0] = hi1 ^ ctr[1] ^ k0;
+						ctr[1] = lo1;
+						ctr[2] = hi0 ^ ctr[3] ^ k1;
+						ctr[3] = lo0;
+						k0 += W0;
+						k1 += W1;
+					}
+				}
+
+				void block(const stream_pos_t blk, uint32_t out[4])const noexcept {
+					out[0] = static_cast<uint32_t>(blk);
+					out[1] = static_cast<uint32_t>(blk >> 32);
+					out[2] = m_substream[0];
+					out[3] = m_substream[1];
+					block(out, m_key);
+				}
+
+				//fills dest with n consecutive 32bit values of the stream starting at the position pos
+				void fill(uint32_t*__restrict dest, stream_pos_t pos, size_t n)const noexcept {
+					NNTL_ASSERT(dest || !n);
+					uint32_t b[4];
+					if (pos & 3) {
+						block(pos >> 2, b);
+						const unsigned ofs = static_cast<unsigned>(pos & 3);
+						const unsigned cnt = static_cast<unsigned>(::std::min(size_t(4 - ofs), n));
+						for (unsigned i = 0; i < cnt; ++i) dest[i] = b[ofs + i];
+						dest += cnt;
+						pos += cnt;
+						n -= cnt;
+					}
+#if NNTL_SIMD_AVX2
+					if (n >= 32 && math::simd::active_isa() >= math::simd::isa::avx2) {
+						const size_t nb = n / 32;
+						_fill8_avx2(dest, pos >> 2, nb);
+						dest += nb * 32;
+						pos += nb * 32;
+						n -= nb * 32;
+					}
+#endif
+					while (n >= 4) {
+						block(pos >> 2, dest);
+						dest += 4;
+						pos += 4;
+						n -= 4;
+					}
+					if (n) {
+						block(pos >> 2, b);
+						for (unsigned i = 0; i < n; ++i) dest[i] = b[i];
+					}
+				}
+
+			protected:
+#if NNTL_SIMD_AVX2
+				static nntl_force_inline void _mulhilo8(const __m256i a, const __m256i m, __m256i& lo, __m256i& hi)noexcept {
+					//_mm256_mul_epu32() multiplies only the even 32bit lanes, so the odd lanes are done separately
+					const __m256i pe = _mm256_mul_epu32(a, m);
+					const __m256i po = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+					lo = _mm256_blend_epi32(pe, _mm256_slli_epi64(po, 32), 0xAA);
+					hi = _mm256_blend_epi32(_mm256_srli_epi64(pe, 32), po, 0xAA);
+				}
+
+				//makes 8 blocks per iteration. Blocks are processed in SoA layout (one register per counter word) and are
+				// transposed back to the stream order on store
+				void _fill8_avx2(uint32_t*__restrict dest, stream_pos_t blk, size_t nIt)const noexcept {
+					const __m256i m0 = _mm256_set1_epi32(static_cast<int>(M0)), m1 = _mm256_set1_epi32(static_cast<int>(M1));
+					const __m256i w0 = _mm256_set1_epi32(static_cast<int>(W0)), w1 = _mm256_set1_epi32(static_cast<int>(W1));
+					const __m256i key0 = _mm256_set1_epi32(static_cast<int>(m_key[0])), key1 = _mm256_set1_epi32(static_cast<int>(m_key[1]));
+					const __m256i ss0 = _mm256_set1_epi32(static_cast<int>(m_substream[0])), ss1 = _mm256_set1_epi32(static_cast<int>(m_substream[1]));
+					const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+					const __m256i signBit = _mm256_set1_epi32(INT32_MIN);
+
+					for (; nIt; --nIt, blk += 8, dest += 32) {
+						__m256i c0 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(blk))), lanes);
+						//carry into the high word for the lanes that wrapped around (unsigned c0 < lo32(blk))
+						const __m256i wrapped = _mm256_cmpgt_epi32(_mm256_xor_si256(_mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(blk))), signBit)
+							, _mm256_xor_si256(c0, signBit));
+						__m256i c1 = _mm256_sub_epi32(_mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(blk >> 32))), wrapped);
+						__m256i c2 = ss0, c3 = ss1;
+						__m256i k0 = key0, k1 = key1;
+
+						for (unsigned r = 0; r < rounds; ++r) {
+							__m256i lo0, hi0, lo1, hi1;
+							_mulhilo8(c0, m0, lo0, hi0);
+							_mulhilo8(c2, m1, lo1, hi1);
+							c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), k0);
+							c1 = lo1;
+							c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), k1);
+							c3 = lo0;
+							k0 = _mm256_add_epi32(k0, w0);
+							k1 = _mm256_add_epi32(k1, w1);
+						}
+
+						//4x8 -> 8x4 transpose
+						const __m256i t0 = _mm256_unpacklo_epi32(c0, c1), t1 = _mm256_unpackhi_epi32(c0, c1);
+						const __m256i t2 = _mm256_unpacklo_epi32(c2, c3), t3 = _mm256_unpackhi_epi32(c2, c3);
+						const __m256i u0 = _mm256_unpacklo_epi64(t0, t2), u1 = _mm256_unpackhi_epi64(t0, t2);
+						const __m256i u2 = _mm256_unpacklo_epi64(t1, t3), u3 = _mm256_unpackhi_epi64(t1, t3);
+						_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest), _mm256_permute2x128_si256(u0, u1, 0x20));
+						_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + 8), _mm256_permute2x128_si256(u2, u3, 0x20));
+						_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + 16), _mm256_permute2x128_si256(u0, u1, 0x31));
+						_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + 24), _mm256_permute2x128_si256(u2, u3, 0x31));
+					}
+				}
+#endif
+			};
+		}
+
+		template<typename FCT, typename RealT, typename iThreadsT>
+		class _Philox : public rng_helper<RealT, ptrdiff_t, uint32_t, FCT> {
+			static_assert(::std::is_base_of<threads::_i_threads<RealT, typename iThreadsT::range_t>, iThreadsT>::value, "iThreads must implement threads::_i_threads");
+
+		public:
+			typedef iThreadsT iThreads_t;
+			typedef typename iThreads_t::range_t range_t;
+			typedef typename iThreads_t::par_range_t par_range_t;
+
+			typedef _impl::philox4x32 base_rng_t;
+			typedef base_rng_t::stream_pos_t stream_pos_t;
+
+			typedef _impl::PHILOX_THR<real_t> Thresholds_t;
+
+			//size (in 32bit words) of the stack buffer used to convert raw stream values. Must be a multiple of 64
+			static constexpr size_t chunk_size = 256;
+			static_assert(0 == chunk_size % 64, "");
+
+		protected:
+			iThreads_t* m_pThreads;
+			base_rng_t m_gen;
+			//position of the next unused value of the stream
+			stream_pos_t m_pos{ 0 };
+
+			//cache of the last block used by scalar generators
+			stream_pos_t m_cachedBlk{ ~stream_pos_t(0) };
+			uint32_t m_cache[4];
+
+			uint64_t m_lastSeed{ 0 };
+
+			//////////////////////////////////////////////////////////////////////////
+			//Serialization support
+		private:
+			friend class ::boost::serialization::access;
+			template<class Archive>
+			void save(Archive & ar, const unsigned int version) const {
+				NNTL_UNREF(version);
+				const uint64_t substream = m_gen.substream();
+				ar & serialization::make_nvp("key", m_lastSeed);
+				ar & NNTL_SERIALIZATION_NVP(substream);
+				ar & serialization::make_nvp("position", m_pos);
+			}
+			template<class Archive>
+			void load(Archive & ar, const unsigned int version) {
+				NNTL_UNREF(version);
+				uint64_t key = m_lastSeed, substream = m_gen.substream();
+				stream_pos_t position = m_pos;
+				ar & NNTL_SERIALIZATION_NVP(key);
+				ar & NNTL_SERIALIZATION_NVP(substream);
+				ar & NNTL_SERIALIZATION_NVP(position);
+				if (ar.success()) {
+					seed64(key);
+					m_gen.set_substream(substream);
+					m_pos = position;
+				} else {
+					STDCOUTL("*** Failed to read Philox state, " << ar.get_last_error_str());
+				}
+			}
+			BOOST_SERIALIZATION_SPLIT_MEMBER()
+
+		public:
+			static constexpr bool is_multithreaded = true;
+
+			_Philox()noexcept :m_pThreads(nullptr) {}
+
+			_Philox(iThreads_t& t)noexcept : m_pThreads(&t) {
+				seed64(static_cast<uint64_t>(::std::time(0)));
+			}
+			_Philox(iThreads_t& t, const seed_t s)noexcept : m_pThreads(&t) {
+				seed(s);
+			}
+
+			bool init_ithreads(iThreads_t& t, const seed_t s = static_cast<seed_t>(s64to32(::std::time(0))))noexcept {
+				NNTL_ASSERT(!m_pThreads);
+				if (m_pThreads) return false;
+				m_pThreads = &t;
+				seed(s);
+				return true;
+			}
+
+			iThreads_t& ithreads()const noexcept { return *m_pThreads; }
+
+			void seed(const seed_t s) noexcept {
+				seed64(static_cast<uint64_t>(static_cast<uint32_t>(s)));
+			}
+			//the whole 64 bits of the seed are used as the Philox key
+			void seed64(const uint64_t s) noexcept {
+				m_gen.set_key(s);
+				m_gen.set_substream(0);
+				m_pos = 0;
+				m_cachedBlk = ~stream_pos_t(0);
+				m_lastSeed = s;
+			}
+			void reseed()noexcept { seed64(m_lastSeed); }
+
+			//the epoch e is the substream e of the stream defined by the key, so seeking is free
+			void seek_epoch(const uint64_t e)noexcept {
+				m_gen.set_substream(e);
+				m_pos = 0;
+				m_cachedBlk = ~stream_pos_t(0);
+			}
+
+			//current position in the stream. Each generated value consumes exactly one 32bit position (with the exception
+			// of normal_vector() that consumes an even count of positions), so the position could be saved and restored
+			// to replay a sequence.
+			stream_pos_t position()const noexcept { return m_pos; }
+			void position(const stream_pos_t p)noexcept { m_pos = p; }
+
+			const base_rng_t& base_rng()const noexcept { return m_gen; }
+
+		protected:
+			uint32_t _next_u32()noexcept {
+				const auto blk = m_pos >> 2;
+				if (blk != m_cachedBlk) {
+					m_gen.block(blk, m_cache);
+					m_cachedBlk = blk;
+				}
+				return m_cache[(m_pos++) & 3];
+			}
+
+			//reserves n consecutive stream positions and returns the first one
+			stream_pos_t _take(const numel_cnt_t n)noexcept {
+				const auto p = m_pos;
+				m_pos += static_cast<stream_pos_t>(n);
+				return p;
+			}
+
+			//[0,1) with as many random bits, as real_t mantissa can hold (up to 32)
+			static nntl_force_inline real_t _u2norm(const uint32_t u)noexcept {
+				return ::std::is_same<real_t, float>::value
+					? static_cast<real_t>(u >> 8) * real_t(1. / 16777216.)
+					: static_cast<real_t>(u) * real_t(1. / 4294967296.);
+			}
+			//(0,1]
+			static nntl_force_inline real_t _u2norm_nz(const uint32_t u)noexcept {
+				return ::std::is_same<real_t, float>::value
+					? static_cast<real_t>((u >> 8) + 1) * real_t(1. / 16777216.)
+					: (static_cast<real_t>(u) + real_t(1)) * real_t(1. / 4294967296.);
+			}
+
+			//calls f(pU, cnt, i0) for consecutive chunks of the stream values at positions [pos+b, pos+e). i0 is the index
+			// of the element that corresponds to pU[0]
+			template<typename F>
+			void _for_chunks(const stream_pos_t pos, const numel_cnt_t b, const numel_cnt_t e, F&& f)const noexcept {
+				uint32_t buf[chunk_size];
+				for (numel_cnt_t i = b; i < e; i += chunk_size) {
+					const auto cnt = static_cast<size_t>(::std::min(static_cast<numel_cnt_t>(chunk_size), e - i));
+					m_gen.fill(buf, pos + static_cast<stream_pos_t>(i), cnt);
+					f(static_cast<const uint32_t*>(buf), cnt, i);
+				}
+			}
+
+		public:
+			// int_4_random_shuffle_t is either int on 32bits or int64 on 64bits
+			int_4_random_shuffle_t gen_i(const int_4_random_shuffle_t lessThan)noexcept {
+				NNTL_ASSERT(lessThan > 0 && lessThan <= UINT32_MAX);
+				return static_cast<int_4_random_shuffle_t>((static_cast<uint64_t>(_next_u32()) * static_cast<uint64_t>(lessThan)) >> 32);
+			}
+
+			int_4_distribution_t gen_int()noexcept { return static_cast<int_4_distribution_t>(_next_u32()); }
+
+			//////////////////////////////////////////////////////////////////////////
+			//generate FP value in range [0,1]
+			real_t gen_f_norm()noexcept { return _u2norm(_next_u32()); }
+
+			//////////////////////////////////////////////////////////////////////////
+			// matrix/vector generation (sequence from begin to end of numbers drawn from uniform distribution in [-a,a])
+			void gen_vector(real_t* ptr, const size_t n, const real_t a)noexcept {
+				get_self().gen_vector(ptr, n, -a, a);
+			}
+			void gen_vector_st(real_t* ptr, const size_t n, const real_t a)noexcept {
+				get_self().gen_vector_st(ptr, n, -a, a);
+			}
+			void gen_vector_mt(real_t* ptr, const size_t n, const real_t a)noexcept {
+				get_self().gen_vector_mt(ptr, n, -a, a);
+			}
+
+			// matrix/vector generation (sequence of numbers drawn from uniform distribution in [neg,pos])
+			void gen_vector(real_t* ptr, const size_t n, const real_t neg, const real_t pos)noexcept {
+				if (n < Thresholds_t::bnd_gen_vector) {
+					get_self().gen_vector_st(ptr, n, neg, pos);
+				} else get_self().gen_vector_mt(ptr, n, neg, pos);
+			}
+			void gen_vector_st(real_t* ptr, const size_t n, const real_t neg, const real_t pos)noexcept {
+				NNTL_ASSERT(ptr || !n);
+				get_self()._igen_vector_st(ptr, pos - neg, neg, elms_range(0, n), _take(n));
+			}
+			void gen_vector_mt(real_t* ptr, const size_t n, const real_t neg, const real_t pos)noexcept {
+				NNTL_ASSERT(m_pThreads && ptr);
+				m_pThreads->run([ptr, span = pos - neg, ofs = neg, sp = _take(n), this](const par_range_t&r) {
+					get_self()._igen_vector_st(ptr, span, ofs, elms_range(r), sp);
+				}, n);
+			}
+			//sp is the stream position of ptr[0]
+			void _igen_vector_st(real_t*const ptr, const real_t span, const real_t ofs, const elms_range& er, const stream_pos_t sp)const noexcept {
+				NNTL_ASSERT(ptr);
+				_for_chunks(sp, er.elmBegin, er.elmEnd, [p = ptr, span, ofs](const uint32_t*const pU, const size_t cnt, const numel_cnt_t i0) {
+					real_t*const pD = p + i0;
+					for (size_t i = 0; i < cnt; ++i) pD[i] = _u2norm(pU[i])*span + ofs;
+				});
+			}
+
+			//////////////////////////////////////////////////////////////////////////
+			//generate vector with values in range [0,1]
+			void gen_vector_norm(real_t* ptr, const size_t n)noexcept {
+				if (n < Thresholds_t::bnd_gen_vector_norm) {
+					get_self().gen_vector_norm_st(ptr, n);
+				} else get_self().gen_vector_norm_mt(ptr, n);
+			}
+			void gen_vector_norm_st(real_t* ptr, const size_t n)noexcept {
+				NNTL_ASSERT(ptr || !n);
+				get_self()._igen_vector_norm_st(ptr, elms_range(0, n), _take(n));
+			}
+			void gen_vector_norm_mt(real_t* ptr, const size_t n)noexcept {
+				NNTL_ASSERT(m_pThreads && ptr);
+				m_pThreads->run([ptr, sp = _take(n), this](const par_range_t&r) {
+					get_self()._igen_vector_norm_st(ptr, elms_range(r), sp);
+				}, n);
+			}
+			void _igen_vector_norm_st(real_t*const ptr, const elms_range& er, const stream_pos_t sp)const noexcept {
+				NNTL_ASSERT(ptr);
+				_for_chunks(sp, er.elmBegin, er.elmEnd, [p = ptr](const uint32_t*const pU, const size_t cnt, const numel_cnt_t i0) {
+					real_t*const pD = p + i0;
+					for (size_t i = 0; i < cnt; ++i) pD[i] = _u2norm(pU[i]);
+				});
+			}
+
+			//////////////////////////////////////////////////////////////////////////
+			//generate vector with values in range [0,a]
+			template<typename BaseType>
+			void gen_vector_gtz(BaseType* ptr, const size_t n, const BaseType a)noexcept {
+				if (n < Thresholds_t::bnd_gen_vector_gtz) {
+					get_self().gen_vector_gtz_st(ptr, n, a);
+				} else get_self().gen_vector_gtz_mt(ptr, n, a);
+			}
+			template<typename BaseType>
+			void gen_vector_gtz_st(BaseType* ptr, const size_t n, const BaseType a)noexcept {
+				NNTL_ASSERT(ptr || !n);
+				get_self()._igen_vector_gtz_st(ptr, a, elms_range(0, n), _take(n));
+			}
+			template<typename BaseType>
+			void gen_vector_gtz_mt(BaseType* ptr, const size_t n, const BaseType a)noexcept {
+				NNTL_ASSERT(m_pThreads && ptr);
+				m_pThreads->run([ptr, a, sp = _take(n), this](const par_range_t&r) {
+					get_self()._igen_vector_gtz_st(ptr, a, elms_range(r), sp);
+				}, n);
+			}
+			template<typename BaseType>
+			void _igen_vector_gtz_st(BaseType*const ptr, const BaseType a, const elms_range& er, const stream_pos_t sp)const noexcept {
+				NNTL_ASSERT(ptr);
+				_for_chunks(sp, er.elmBegin, er.elmEnd, [p = ptr, a](const uint32_t*const pU, const size_t cnt, const numel_cnt_t i0) {
+					BaseType*const pD = p + i0;
+					for (size_t i = 0; i < cnt; ++i) pD[i] = static_cast<BaseType>(_u2norm(pU[i])*a);
+				});
+			}
+
+			//////////////////////////////////////////////////////////////////////////
+			//////////////////////////////////////////////////////////////////////////
+			// the decision is made on the raw 32bit integers, there's no conversion to floating point
+			void bernoulli_vector(real_t* ptr, const size_t n, const real_t p, const real_t posVal = real_t(1.), const real_t negVal = real_t(0.))noexcept {
+				if (n < Thresholds_t::bnd_bernoulli_vector) {
+					get_self().bernoulli_vector_st(ptr, n, p, posVal, negVal);
+				} else get_self().bernoulli_vector_mt(ptr, n, p, posVal, negVal);
+			}
+			void bernoulli_vector_st(real_t* ptr, const size_t n, const real_t p, const real_t posVal, const real_t negVal)noexcept {
+				NNTL_ASSERT(ptr || !n);
+				get_self()._ibernoulli_vector_st(ptr, p, posVal, negVal, elms_range(0, n), _take(n));
+			}
+			void bernoulli_vector_mt(real_t* ptr, const size_t n, const real_t p, const real_t posVal, const real_t negVal)noexcept {
+				NNTL_ASSERT(m_pThreads && ptr);
+				m_pThreads->run([ptr, p, posVal, negVal, sp = _take(n), this](const par_range_t& r) {
+					get_self()._ibernoulli_vector_st(ptr, p, posVal, negVal, elms_range(r), sp);
+				}, n);
+			}
+			void _ibernoulli_vector_st(real_t*const ptr, const real_t p, const real_t posVal, const real_t negVal
+				, const elms_range& er, const stream_pos_t sp)const noexcept
+			{
+				NNTL_ASSERT(ptr);
+				NNTL_ASSERT(p > real_t(0) && p < real_t(1));
+				//u < thr with probability p
+				const uint32_t thr = static_cast<uint32_t>(static_cast<double>(p) * 4294967296.);
+				_for_chunks(sp, er.elmBegin, er.elmEnd, [pp = ptr, thr, posVal, negVal](const uint32_t*const pU, const size_t cnt, const numel_cnt_t i0) {
+					real_t*const pD = pp + i0;
+					for (size_t i = 0; i < cnt; ++i) pD[i] = pU[i] < thr ? posVal : negVal;
+				});
+			}
+
+			//////////////////////////////////////////////////////////////////////////
+			void bernoulli_bits(bitmask_word_t*const pBits, const numel_cnt_t n, const real_t p)noexcept {
+				if (n < Thresholds_t::bnd_bernoulli_bits) {
+					get_self().bernoulli_bits_st(pBits, n, p);
+				} else get_self().bernoulli_bits_mt(pBits, n, p);
+			}
+			void bernoulli_bits_st(bitmask_word_t*const pBits, const numel_cnt_t n, const real_t p)noexcept {
+				NNTL_ASSERT(pBits || !n);
+				get_self()._ibernoulli_bits_st(pBits, n, p, elms_range(0, sBitMaskWords(n)), _take(n));
+			}
+			void bernoulli_bits_mt(bitmask_word_t*const pBits, const numel_cnt_t n, const real_t p)noexcept {
+				NNTL_ASSERT(m_pThreads && pBits);
+				m_pThreads->run([pBits, n, p, sp = _take(n), this](const par_range_t& r) {
+					get_self()._ibernoulli_bits_st(pBits, n, p, elms_range(r), sp);
+				}, sBitMaskWords(n));
+			}
+			//er is a range of words of pBits. The bit j of the word w is made from the stream position sp + w*64 + j
+			void _ibernoulli_bits_st(bitmask_word_t*const pBits, const numel_cnt_t n, const real_t p
+				, const elms_range& er, const stream_pos_t sp)const noexcept
+			{
+				NNTL_ASSERT(pBits);
+				NNTL_ASSERT(p > real_t(0) && p < real_t(1));
+				const uint32_t thr = static_cast<uint32_t>(static_cast<double>(p) * 4294967296.);
+				_for_chunks(sp, er.elmBegin * 64, ::std::min(er.elmEnd * 64, n), [pBits, thr](const uint32_t*const pU, const size_t cnt, const numel_cnt_t i0) {
+					//chunk_size is a multiple of 64, so each chunk starts on a word boundary
+					NNTL_ASSERT(0 == i0 % 64);
+					bitmask_word_t*const pW = pBits + i0 / 64;
+					for (size_t w = 0; w * 64 < cnt; ++w) {
+						const size_t jE = ::std::min(size_t(64), cnt - w * 64);
+						const uint32_t*const pV = pU + w * 64;
+						bitmask_word_t v = 0;
+						for (size_t j = 0; j < jE; ++j) {
+							v |= static_cast<bitmask_word_t>(pV[j] < thr) << j;
+						}
+						pW[w] = v;
+					}
+				});
+			}
+
+			///////////////////////////////////////////////////////////////////////////
+			//////////////////////////////////////////////////////////////////////////
+			// Box-Muller transform. The pair of elements {2k, 2k+1} is made from the stream positions {sp+2k, sp+2k+1}
+			void normal_vector(real_t* ptr, const size_t n, const real_t m = real_t(0.), const real_t st = real_t(1.))noexcept {
+				if (n < Thresholds_t::bnd_normal_vector) {
+					get_self().normal_vector_st(ptr, n, m, st);
+				} else get_self().normal_vector_mt(ptr, n, m, st);
+			}
+			void normal_vector_st(real_t* ptr, const size_t n, const real_t m, const real_t st)noexcept {
+				NNTL_ASSERT(ptr || !n);
+				get_self()._inormal_vector_st(ptr, m, st, elms_range(0, n), _take(n + (n & 1)));
+			}
+			void normal_vector_mt(real_t* ptr, const size_t n, const real_t m, const real_t st)noexcept {
+				NNTL_ASSERT(m_pThreads && ptr);
+				m_pThreads->run([ptr, m, st, sp = _take(n + (n & 1)), this](const par_range_t& r) {
+					get_self()._inormal_vector_st(ptr, m, st, elms_range(r), sp);
+				}, n);
+			}
+			void _inormal_vector_st(real_t*const ptr, const real_t m, const real_t st, const elms_range& er, const stream_pos_t sp)const noexcept {
+				NNTL_ASSERT(ptr);
+				const numel_cnt_t b = er.elmBegin, e = er.elmEnd;
+				//the range of stream positions always starts on a pair boundary and since chunk_size is even, pairs never
+				// straddle chunks
+				_for_chunks(sp, b & ~numel_cnt_t(1), e + (e & 1), [ptr, m, st, b, e](const uint32_t*const pU, const size_t cnt, const numel_cnt_t i0) {
+					NNTL_ASSERT(0 == (i0 & 1) && 0 == (cnt & 1));
+					for (size_t i = 0; i < cnt; i += 2) {
+						const real_t r = st*::std::sqrt(real_t(-2) * ::std::log(_u2norm_nz(pU[i])));
+						const real_t th = real_t(6.283185307179586476925286766559) * _u2norm(pU[i + 1]);
+						const numel_cnt_t k = i0 + static_cast<numel_cnt_t>(i);
+						if (k >= b) ptr[k] = r*::std::cos(th) + m;
+						if (k + 1 < e) ptr[k + 1] = r*::std::sin(th) + m;
+					}
+				});
+			}
+		};
+
+		template<typename RealT, typename iThreadsT>
+		class Philox final : public _Philox<Philox<RealT, iThreadsT>, RealT, iThreadsT> {
+			typedef _Philox<Philox<RealT, iThreadsT>, RealT, iThreadsT> _base_class_t;
+		public:
+			~Philox() { }
+			Philox()noexcept : _base_class_t() {}
+			Philox(iThreads_t& t)noexcept : _base_class_t(t) {}
+			Philox(iThreads_t& t, seed_t s)noexcept : _base_class_t(t, s) {}
+		};
+	}
+}
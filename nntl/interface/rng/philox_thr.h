@@ -0,0 +1,70 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#ifndef NNTL_OVERRIDE_PHILOX_THRESHOLDS
+
+namespace nntl {
+namespace rng {
+
+	namespace _impl {
+
+		//Philox doesn't have a sequential state, so the only cost of going multithreaded is the threads pool overhead.
+		//The values are rough estimates and haven't been tuned yet (nt)
+		template<typename real_t>
+		struct PHILOX_THR {};
+
+		template<> struct PHILOX_THR<double> {
+			static constexpr size_t bnd_gen_vector = 6000;//nt
+			static constexpr size_t bnd_gen_vector_gtz = 6000;//nt
+			static constexpr size_t bnd_gen_vector_norm = 6000;//nt
+
+			static constexpr size_t bnd_bernoulli_vector = 6000;//nt
+			static constexpr size_t bnd_bernoulli_bits = 8000;//nt
+			static constexpr size_t bnd_normal_vector = 1500;//nt
+		};
+
+		template<> struct PHILOX_THR<float> {
+			static constexpr size_t bnd_gen_vector = 8000;//nt
+			static constexpr size_t bnd_gen_vector_gtz = 8000;//nt
+			static constexpr size_t bnd_gen_vector_norm = 8000;//nt
+
+			static constexpr size_t bnd_bernoulli_vector = 8000;//nt
+			static constexpr size_t bnd_bernoulli_bits = 8000;//nt
+			static constexpr size_t bnd_normal_vector = 2000;//nt
+		};
+	}
+
+}
+}
+
+#endif
@@ -32,7 +32,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include "../_i_bgworkers.h"
+#include "mpmc_queue.h"
 #include <vector>
+#include <array>
 #include <algorithm>
 
 
@@ -84,8 +86,17 @@ namespace threads {
 		};
 	}
 
+	//Background worker threads. There are 3 kinds of work for them:
+	// - exec()/exec_async() orders: a function that every worker thread executes once;
+	// - one-shot jobs posted with post(): any single worker executes a job. Jobs are kept in bounded lock-free queues
+	//		(one per priority level), so posting never blocks a producer thread;
+	// - standing tasks registered with add_task(): when there's nothing else to do, workers call them repeatedly
+	//		until they return false and then recheck them every set_task_wait_timeout().
+	// Idle workers park on a futex (see futex_word), so neither exec_async() nor post() take any locks. The mutex
+	// is used only to change the standing tasks set.
 	template <typename SyncT = threads::sync_primitives
 		, typename CallHandlerT = utils::cmcforwarderWrapper<2 * sizeof(void*)>
+		, unsigned JobsLaneCapacity = 256
 	>
 	class BgWorkers : public _i_bgworkers {
 		//!! copy constructor not needed
@@ -101,13 +112,15 @@ namespace threads {
 		typedef CallHandlerT CallH_t;
 		typedef SyncT Sync_t;
 
+		//count of job priority levels. Jobs from the lane with the bigger index are executed first
+		static constexpr unsigned priority_lanes = 3;
+		static constexpr unsigned jobs_lane_capacity = JobsLaneCapacity;
+
 	protected:
 		typedef typename CallH_t::template call_tpl<bool(const thread_id_t tId)> func_task_t;
 		typedef typename CallH_t::template call_tpl<void(const thread_id_t tId)> func_exec_t;
 
 		typedef typename Sync_t::shared_mutex_t shared_mutex_t;
-		//typedef typename Sync_t::cond_var_t cond_var_t;
-		typedef typename Sync_t::cond_var_any_t cond_var_any_t;
 
 		typedef _impl::disperse_locker<shared_mutex_t> disperse_locker_t;
 
@@ -115,6 +128,9 @@ namespace threads {
 		
 		typedef ::std::vector<TaskDescr_t> TaskSet_t;
 
+		typedef mpmc_queue<func_exec_t, JobsLaneCapacity> jobs_queue_t;
+		typedef futex_word::value_t signal_t;
+
 	public:
 		typedef ::std::vector<::std::thread> threads_cont_t;
 		typedef threads_cont_t::iterator ThreadObjIterator_t;
@@ -122,11 +138,9 @@ namespace threads {
 		//////////////////////////////////////////////////////////////////////////
 		//Members
 	protected:
+		//guards m_tasks only
 		shared_mutex_t m_mutexTasks;
 
-		cond_var_any_t m_waitingOrders;
-		cond_var_any_t m_orderDone;
-
 		::std::atomic<bool> m_bStop;
 		::std::atomic<bool> m_bGo2Waiting;
 
@@ -135,32 +149,31 @@ namespace threads {
 		TaskSet_t m_tasks;
 
 		threads_cont_t m_threads;
-		::std::atomic_ptrdiff_t m_workingCnt;
 
-		::std::vector<char> m_threadHasSmth2Exec;
+		//idle workers park on it. It's changed every time there's something new to do (a job, an exec() order or a stop request)
+		futex_word m_signal;
+		//count of workers that haven't finished the current exec() order yet (or haven't started yet in the constructor)
+		futex_word m_workingCnt;
+		//incremented on every exec() order. A worker executes m_execFn when the value differs from the one it has seen last time
+		::std::atomic<signal_t> m_execSeq;
 		func_exec_t m_execFn;
 
+		::std::array<jobs_queue_t, priority_lanes> m_jobs;
 
 	private:
 		void _ctor(const thread_id_t nThreads, const PriorityClass pc)noexcept {
 			NNTL_ASSERT(nThreads);
-			m_workingCnt = nThreads;
+			m_workingCnt.store(static_cast<signal_t>(nThreads));
+			m_execSeq = 0;
 			m_bGo2Waiting = false;
 			m_bStop = false;
 			//m_taskWaitTO = 250;
 
-			m_threadHasSmth2Exec.resize(nThreads, char(false));
 			m_threads.reserve(nThreads);
-			m_mutexTasks.lock();
 			for (thread_id_t i = 0; i < nThreads; ++i) {
 				m_threads.emplace_back(_s_worker, this, i);
 			}
-			m_mutexTasks.unlock();
-
-			{
-				::std::unique_lock<decltype(m_mutexTasks)> lk(m_mutexTasks);
-				m_orderDone.wait(lk, [&wc = m_workingCnt]() throw() {return wc <= 0; });
-			}
+			_wait_workers();
 
 			if (PriorityClass::threads_priority_no_change != pc) {
 				const auto b = Funcs::ChangeThreadsPriorities(*this, pc);
@@ -169,13 +182,12 @@ namespace threads {
 		}
 
 	public:
+		//jobs that are still in the queues are dropped
 		~BgWorkers()noexcept {
+			exec_wait();
 			m_bStop = true;
 			m_bGo2Waiting = true;
-
-			//m_mutexTasks.lock();
-			m_waitingOrders.notify_all();
-		//	m_mutexTasks.unlock();
+			_signal_all();
 
 			for (auto& t : m_threads)  t.join();
 		}
@@ -250,27 +262,106 @@ namespace threads {
 			m_tasks.clear();
 			return *this;
 		}
-		
+
+		//posts the one-shot job func(tId) to be executed by a single worker thread. Never blocks, returns false if
+		// the lane of the priority is full. Could be called from any thread, including the worker threads.
+		// A small func is stored by value, a bigger one is stored by reference and therefore must be an lvalue that
+		// lives until the job is done.
+		template<typename FJob>
+		bool post(FJob&& func, const unsigned priority = 0) noexcept {
+			typedef decltype(CallH_t::wrap<FJob>(::std::forward<FJob>(func))) stored_f_t;
+			static_assert(
+				::std::is_lvalue_reference<FJob>::value
+				|| !(::std::is_class<stored_f_t>::value
+					&& utils::is_specialization_of<stored_f_t, ::std::reference_wrapper>::value)
+				, "func is too big to be stored by value, pass an lvalue that outlives the job"
+				);
+			NNTL_ASSERT(priority < priority_lanes);
+
+			if (!m_jobs[::std::min(priority, priority_lanes - 1)].push(func_exec_t(CallH_t::wrap<FJob>(::std::forward<FJob>(func)))))
+				return false;
+			m_signal.fetch_add(1);
+			m_signal.wake_one();
+			return true;
+		}
+
+		//approximate count of jobs waiting for execution
+		size_t jobs_count()const noexcept {
+			size_t r = 0;
+			for (const auto& q : m_jobs) r += q.size();
+			return r;
+		}
+
 		//never call recursively or from non-main thread
 		template<typename FExec>
 		self_t& exec(FExec&& func) noexcept {
-			m_bGo2Waiting = true;
-			m_mutexTasks.lock();
-
-			m_execFn = CallH_t::wrap<FExec>(::std::forward<FExec>(func));
-			for (auto& e : m_threadHasSmth2Exec) e = char(true);
-			m_workingCnt = m_threadHasSmth2Exec.size();
-
-			m_bGo2Waiting = false;
-			m_mutexTasks.unlock();
+			_exec_start(::std::forward<FExec>(func));
+			return exec_wait();
+		}
 
-			Sync_t::lock_wait_unlock(m_mutexTasks, m_orderDone, [&wc = m_workingCnt]() {return wc <= 0; });
+		//starts func on every worker thread and returns immediately. func must outlive the corresponding exec_wait() call,
+		// so it's required to be an lvalue (or a ::std::reference_wrapper).
+		// Never call recursively or from non-main thread; every exec_async() must be paired with exec_wait() before the next
+		// exec()/exec_async() call. Jobs and tasks are not executed by a thread while it runs the exec function.
+		template<typename FExec>
+		self_t& exec_async(FExec&& func) noexcept {
+			typedef decltype(CallH_t::wrap<FExec>(::std::forward<FExec>(func))) stored_f_t;
+			static_assert(
+				::std::is_lvalue_reference<stored_f_t>::value
+				|| (::std::is_class<stored_f_t>::value
+					&& utils::is_specialization_of<stored_f_t, ::std::reference_wrapper>::value)
+				, "func representation can be rvalue only if it is a ::std::reference_wrapper"
+				);
+			_exec_start(::std::forward<FExec>(func));
+			return *this;
+		}
 
-			m_execFn.reset();//shouldn't harm when done here while outside of mutex
+		//waits until the function passed to the last exec_async() finishes on every worker thread.
+		// Safe to call when nothing was started.
+		self_t& exec_wait()noexcept {
+			if (m_execFn) {
+				_wait_workers();
+				m_execFn.reset();//all workers are done with it
+			}
 			return *this;
 		}
 
+		bool exec_pending()const noexcept { return !!m_execFn; }
+
 	protected:
+		template<typename FExec>
+		void _exec_start(FExec&& func) noexcept {
+			NNTL_ASSERT(!m_execFn || !"Call exec_wait() first!");
+			m_execFn = CallH_t::wrap<FExec>(::std::forward<FExec>(func));
+			m_workingCnt.store(static_cast<signal_t>(m_threads.size()));
+			//publishes m_execFn and m_workingCnt
+			m_execSeq.fetch_add(1, ::std::memory_order_release);
+			_signal_all();
+		}
+
+		void _signal_all()noexcept {
+			m_signal.fetch_add(1);
+			m_signal.wake_all();
+		}
+
+		void _wait_workers()noexcept {
+			signal_t v;
+			while (0 != (v = m_workingCnt.load())) m_workingCnt.wait(v);
+		}
+		void _worker_done()noexcept {
+			if (1 == m_workingCnt.fetch_sub(1)) m_workingCnt.wake_all();
+		}
+
+		bool _pop_job(func_exec_t& job)noexcept {
+			for (unsigned i = priority_lanes; i > 0; --i) {
+				if (m_jobs[i - 1].pop(job)) return true;
+			}
+			return false;
+		}
+		bool _has_jobs()const noexcept {
+			for (const auto& q : m_jobs) if (!q.empty()) return true;
+			return false;
+		}
 
 		static void _s_worker(BgWorkers* p, const thread_id_t tId)noexcept {
 			const auto b = threads::Funcs::AllowCurrentThreadPriorityBoost(false);
@@ -280,46 +371,51 @@ namespace threads {
 		}
 
 		void _worker(const thread_id_t id)noexcept {
-			m_mutexTasks.lock_shared();
-			m_workingCnt--;
-			m_orderDone.notify_one();
-			m_mutexTasks.unlock_shared();
+			signal_t lastExec = m_execSeq.load(::std::memory_order_acquire);
+			_worker_done();
 
-			auto& bHas2Exec = m_threadHasSmth2Exec[id];
+			func_exec_t job;
+			auto tasksAfter = ::std::chrono::steady_clock::now() + m_taskWaitTO;
 			while (true) {
-				::std::atomic_thread_fence(::std::memory_order_acquire);//for m_taskWaitTO usage before mutex acquisition.
-				const auto sleepUntil = ::std::chrono::steady_clock::now() + m_taskWaitTO;
-				Sync_t::lockShared_waitFor_unlock(m_mutexTasks, m_waitingOrders, m_taskWaitTO
-					, [&bStop = m_bStop, &bGo2Waiting = m_bGo2Waiting
-					, &tasks = m_tasks, &utime = sleepUntil, &h2e = bHas2Exec]()noexcept
-				{
-					return bStop || (::std::chrono::steady_clock::now() > utime && !bGo2Waiting && tasks.size() > 0) || h2e;
-				});
+				//must be read before checking for the work to not miss a wake up
+				const auto sig = m_signal.load();
 				if (m_bStop) break;
 
-				if (bHas2Exec) {
+				const auto es = m_execSeq.load(::std::memory_order_acquire);
+				if (es != lastExec) {
+					lastExec = es;
 					m_execFn(id);
-
-					m_mutexTasks.lock_shared();
-					
-					bHas2Exec = char(false);
-					m_workingCnt--;
-					m_orderDone.notify_one();
-
-					m_mutexTasks.unlock_shared();
+					_worker_done();
+				} else if (_pop_job(job)) {
+					job(id);
 				} else {
-					m_mutexTasks.lock_shared();
+					::std::atomic_thread_fence(::std::memory_order_acquire);//for m_taskWaitTO usage outside of the mutex.
+					const auto tNow = ::std::chrono::steady_clock::now();
+					if (tNow >= tasksAfter) {
+						//if the tasks were interrupted by a new job or order, they should be resumed right after it's done
+						tasksAfter = _run_tasks(id, lastExec) ? tNow : tNow + m_taskWaitTO;
+					} else m_signal.wait_for(sig, tasksAfter - tNow);
+				}
+			}
+		}
 
-					auto itCur = m_tasks.cbegin();
-					const auto itLast = m_tasks.cend();
-					while (!m_bGo2Waiting && itCur != itLast) {
-						const auto& fn = (*itCur++).task;
-						while (!m_bGo2Waiting && fn(id)) {}
-					}
+		//returns true if the tasks were interrupted
+		bool _run_tasks(const thread_id_t id, const signal_t lastExec)noexcept {
+			const auto bGo = [this, lastExec]()noexcept {
+				return !m_bGo2Waiting && lastExec == m_execSeq.load(::std::memory_order_relaxed) && !_has_jobs();
+			};
 
-					m_mutexTasks.unlock_shared();
-				}
+			m_mutexTasks.lock_shared();
+
+			auto itCur = m_tasks.cbegin();
+			const auto itLast = m_tasks.cend();
+			while (bGo() && itCur != itLast) {
+				const auto& fn = (*itCur++).task;
+				while (bGo() && fn(id)) {}
 			}
+
+			m_mutexTasks.unlock_shared();
+			return !bGo();
 		}
 	};
 
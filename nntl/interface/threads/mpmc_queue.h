@@ -0,0 +1,135 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//Bounded multi-producer multi-consumer queue. That's the array based queue by D.Vyukov
+// (http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue): every cell has a sequence number that
+// tells producers and consumers whether the cell is free or holds a value for the current lap, so push() and pop() are
+// just a single CAS on the corresponding position plus a release store to the cell. Neither push() nor pop() ever waits:
+// they return false when the queue is full or empty respectively.
+// Note, that strictly speaking the algorithm is not lock-free: if a producer is preempted between the CAS and the store
+// to the cell, consumers of that cell will see the queue as empty until the producer resumes.
+
+#include <atomic>
+#include <utility>
+
+namespace nntl {
+namespace threads {
+
+	//T must be default constructible and move-assignable. Values are assigned into the preallocated cells, there are no
+	// allocations after construction
+	template<typename T, unsigned _Capacity>
+	class mpmc_queue {
+		static_assert(_Capacity >= 2 && 0 == (_Capacity & (_Capacity - 1)), "Capacity must be a power of 2");
+
+		mpmc_queue(const mpmc_queue& other)noexcept = delete;
+		mpmc_queue(mpmc_queue&& other)noexcept = delete;
+		mpmc_queue& operator=(const mpmc_queue& rhs) noexcept = delete;
+
+	public:
+		typedef T value_type;
+		typedef size_t index_t;
+		static constexpr index_t capacity = _Capacity;
+
+	protected:
+		struct cell_t {
+			::std::atomic<index_t> seq;
+			value_type data;
+		};
+
+		cell_t m_cells[_Capacity];
+		//producers modify m_enqPos, consumers modify m_deqPos. Don't let them share a cache line with each other and the cells
+		char _pad0[64];
+		::std::atomic<index_t> m_enqPos;
+		char _pad1[64 - sizeof(::std::atomic<index_t>)];
+		::std::atomic<index_t> m_deqPos;
+		char _pad2[64 - sizeof(::std::atomic<index_t>)];
+
+	public:
+		~mpmc_queue()noexcept {}
+		mpmc_queue()noexcept : m_enqPos(0), m_deqPos(0) {
+			for (index_t i = 0; i < capacity; ++i) m_cells[i].seq.store(i, ::std::memory_order_relaxed);
+			::std::atomic_thread_fence(::std::memory_order_release);
+		}
+
+		//returns false if the queue is full
+		template<typename U>
+		bool push(U&& v)noexcept {
+			auto pos = m_enqPos.load(::std::memory_order_relaxed);
+			cell_t* pCell;
+			while (true) {
+				pCell = &m_cells[pos & (capacity - 1)];
+				const auto seq = pCell->seq.load(::std::memory_order_acquire);
+				const auto dif = static_cast<::std::ptrdiff_t>(seq) - static_cast<::std::ptrdiff_t>(pos);
+				if (0 == dif) {
+					if (m_enqPos.compare_exchange_weak(pos, pos + 1, ::std::memory_order_relaxed)) break;
+				} else if (dif < 0) {
+					return false;//the cell still holds the value of the previous lap
+				} else pos = m_enqPos.load(::std::memory_order_relaxed);
+			}
+			pCell->data = ::std::forward<U>(v);
+			pCell->seq.store(pos + 1, ::std::memory_order_release);
+			return true;
+		}
+
+		//returns false if the queue is empty
+		bool pop(value_type& v)noexcept {
+			auto pos = m_deqPos.load(::std::memory_order_relaxed);
+			cell_t* pCell;
+			while (true) {
+				pCell = &m_cells[pos & (capacity - 1)];
+				const auto seq = pCell->seq.load(::std::memory_order_acquire);
+				const auto dif = static_cast<::std::ptrdiff_t>(seq) - static_cast<::std::ptrdiff_t>(pos + 1);
+				if (0 == dif) {
+					if (m_deqPos.compare_exchange_weak(pos, pos + 1, ::std::memory_order_relaxed)) break;
+				} else if (dif < 0) {
+					return false;//nothing was pushed to the cell on this lap
+				} else pos = m_deqPos.load(::std::memory_order_relaxed);
+			}
+			v = ::std::move(pCell->data);
+			pCell->seq.store(pos + capacity, ::std::memory_order_release);
+			return true;
+		}
+
+		//both are approximate when there are concurrent push() or pop() calls
+		bool empty()const noexcept {
+			return m_enqPos.load(::std::memory_order_acquire) == m_deqPos.load(::std::memory_order_acquire);
+		}
+		index_t size()const noexcept {
+			const auto d = m_deqPos.load(::std::memory_order_acquire);
+			const auto e = m_enqPos.load(::std::memory_order_acquire);
+			return e > d ? e - d : 0;
+		}
+	};
+
+}
+}
@@ -0,0 +1,464 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//NUMA helpers for threads::Workers (and, to a lesser degree, for threads::BgWorkers and threads::WsWorkers)
+// - topology detects which logical CPUs belong to which NUMA node and produces a pinning order (compact or scatter)
+// - pin_workers is a RAII object (similar to prioritize_workers) that pins the main thread and the worker threads to CPUs
+//		in that order and restores the original affinity on destruction. It also reports the node of every par_range_t::tid()
+// - first_touch() zeroes a freshly allocated buffer by the worker threads using the same partitioning Workers::run() employs
+//		for elementwise kernels, so the OS places the pages of every range on the node of the thread that owns that range
+// - node_replicas keeps one copy of read-only data (i.e. train_x) per node, every copy is written (and therefore placed)
+//		by the threads of its node. Threads then read the copy of their own node via for_tid()
+//
+// tid->node mapping is exact for Workers only: worker thread #i always executes the range with tid==i+1 and the main thread
+// executes tid==0. BgWorkers don't use tids at all and WsWorkers tid is a slot index that any thread may execute, so for them
+// only the pinning itself is meaningful.
+//
+// Linux implementation reads /sys/devices/system/node, Windows uses GetLogicalProcessorInformationEx(RelationNumaNode).
+// Other platforms (and machines without NUMA) are treated as a single node system and pinning is a no-op.
+
+#include "../_i_threads.h"
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <thread>
+#include <cstring>
+
+#if defined(_WIN32_WINNT)
+#include <windows.h>
+#define NNTL_NUMA_WIN 1
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <dirent.h>
+#include <cstdio>
+#include <cstdlib>
+#define NNTL_NUMA_LINUX 1
+#else
+#pragma message("NUMA topology detection and thread pinning are implemented only for Windows and Linux. Single node no-op will be used.")
+#endif
+
+namespace nntl {
+namespace threads {
+namespace numa {
+
+	typedef unsigned int node_id_t;
+
+	//logical CPU description. group is always 0 on Linux (and on Windows machines with less than 65 logical CPUs)
+	struct cpu_t {
+		unsigned short group;
+		unsigned short number;
+		node_id_t node;
+
+		cpu_t()noexcept : group(0), number(0), node(0) {}
+		cpu_t(const unsigned short g, const unsigned short n, const node_id_t nd)noexcept : group(g), number(n), node(nd) {}
+	};
+
+	enum class PinOrder {
+		//fill all CPUs of the node 0 first, then all CPUs of the node 1 and so on. Neighbouring tids share the node memory
+		Compact,
+		//round-robin over the nodes: tid 0 goes to node 0, tid 1 to node 1 ... Maximizes the aggregate memory bandwidth
+		// when not all CPUs are used
+		Scatter
+	};
+
+	class topology {
+	protected:
+		//sorted by (node, group, number)
+		::std::vector<cpu_t> m_cpus;
+		node_id_t m_nodesCnt;
+
+	public:
+		~topology()noexcept {}
+		topology()noexcept : m_nodesCnt(0) {
+			detect();
+		}
+
+		//returns false if the OS didn't report the topology and the single node fallback was used
+		bool detect()noexcept {
+			m_cpus.clear();
+			m_nodesCnt = 0;
+			const bool bRet = _detect();
+			if (!bRet || m_cpus.empty()) {
+				m_cpus.clear();
+				const unsigned hc = ::std::max(1u, ::std::thread::hardware_concurrency());
+				for (unsigned i = 0; i < hc; ++i) m_cpus.push_back(cpu_t(static_cast<unsigned short>(i / 64)
+					, static_cast<unsigned short>(i % 64), 0));
+			}
+			::std::sort(m_cpus.begin(), m_cpus.end(), [](const cpu_t& a, const cpu_t& b)noexcept {
+				return a.node < b.node || (a.node == b.node && (a.group < b.group || (a.group == b.group && a.number < b.number)));
+			});
+			//nodes numbers may be sparse, so counting distinct values
+			for (size_t i = 0; i < m_cpus.size(); ++i) {
+				if (0 == i || m_cpus[i].node != m_cpus[i - 1].node) ++m_nodesCnt;
+			}
+			return bRet && !m_cpus.empty();
+		}
+
+		node_id_t nodes_count()const noexcept { return m_nodesCnt; }
+		const ::std::vector<cpu_t>& cpus()const noexcept { return m_cpus; }
+
+		::std::vector<cpu_t> order(const PinOrder po)const noexcept {
+			if (PinOrder::Compact == po || m_nodesCnt < 2) return m_cpus;
+
+			//splitting into per node lists and taking one CPU from each list in turn
+			::std::vector<::std::vector<cpu_t>> byNode;
+			for (size_t i = 0; i < m_cpus.size(); ++i) {
+				if (0 == i || m_cpus[i].node != m_cpus[i - 1].node) byNode.emplace_back();
+				byNode.back().push_back(m_cpus[i]);
+			}
+			::std::vector<cpu_t> ret;
+			ret.reserve(m_cpus.size());
+			for (size_t k = 0; ret.size() < m_cpus.size(); ++k) {
+				for (const auto& l : byNode) {
+					if (k < l.size()) ret.push_back(l[k]);
+				}
+			}
+			return ret;
+		}
+
+	protected:
+#if defined(NNTL_NUMA_WIN)
+		bool _detect()noexcept {
+			DWORD len = 0;
+			::GetLogicalProcessorInformationEx(RelationNumaNode, nullptr, &len);
+			if (ERROR_INSUFFICIENT_BUFFER != ::GetLastError() || !len) return false;
+
+			::std::unique_ptr<char[]> buf(new(::std::nothrow) char[len]);
+			if (!buf) return false;
+			auto pBuf = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buf.get());
+			if (!::GetLogicalProcessorInformationEx(RelationNumaNode, pBuf, &len)) return false;
+
+			for (DWORD ofs = 0; ofs < len; ) {
+				const auto pInfo = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buf.get() + ofs);
+				if (RelationNumaNode == pInfo->Relationship) {
+					const auto& gm = pInfo->NumaNode.GroupMask;
+					for (unsigned short b = 0; b < sizeof(KAFFINITY) * 8; ++b) {
+						if (gm.Mask & (KAFFINITY(1) << b)) m_cpus.push_back(cpu_t(gm.Group, b, pInfo->NumaNode.NodeNumber));
+					}
+				}
+				ofs += pInfo->Size;
+			}
+			return true;
+		}
+#elif defined(NNTL_NUMA_LINUX)
+		//parses the "0-3,8,10-11" format of sysfs cpulist files
+		bool _parse_cpulist(const char* fname, const node_id_t node)noexcept {
+			FILE* f = ::std::fopen(fname, "r");
+			if (!f) return false;
+			char str[4096];
+			const bool bRead = nullptr != ::std::fgets(str, sizeof(str), f);
+			::std::fclose(f);
+			if (!bRead) return false;
+
+			const char* p = str;
+			while (*p >= '0' && *p <= '9') {
+				char* pEnd;
+				const unsigned long first = ::std::strtoul(p, &pEnd, 10);
+				unsigned long last = first;
+				p = pEnd;
+				if ('-' == *p) {
+					last = ::std::strtoul(p + 1, &pEnd, 10);
+					p = pEnd;
+				}
+				for (unsigned long c = first; c <= last; ++c) m_cpus.push_back(cpu_t(0, static_cast<unsigned short>(c), node));
+				if (',' == *p) ++p;
+			}
+			return true;
+		}
+
+		bool _detect()noexcept {
+			static constexpr const char* nodesDir = "/sys/devices/system/node";
+			DIR* pDir = ::opendir(nodesDir);
+			if (!pDir) return false;
+			bool bRet = false;
+			while (const dirent* pE = ::readdir(pDir)) {
+				if (0 != ::std::strncmp(pE->d_name, "node", 4) || pE->d_name[4] < '0' || pE->d_name[4] > '9') continue;
+				char fname[512];
+				::std::snprintf(fname, sizeof(fname), "%s/%s/cpulist", nodesDir, pE->d_name);
+				bRet |= _parse_cpulist(fname, static_cast<node_id_t>(::std::strtoul(pE->d_name + 4, nullptr, 10)));
+			}
+			::closedir(pDir);
+			return bRet;
+		}
+#else
+		bool _detect()noexcept { return false; }
+#endif
+	};
+
+	namespace _impl {
+
+#if defined(NNTL_NUMA_WIN)
+		typedef GROUP_AFFINITY affinity_t;
+		typedef HANDLE native_thread_t;
+
+		inline native_thread_t current_thread()noexcept { return ::GetCurrentThread(); }
+		inline bool get_affinity(native_thread_t h, affinity_t& a)noexcept {
+			return !!::GetThreadGroupAffinity(h, &a);
+		}
+		inline bool set_affinity(native_thread_t h, const affinity_t& a)noexcept {
+			return !!::SetThreadGroupAffinity(h, &a, nullptr);
+		}
+		inline bool pin_to(native_thread_t h, const cpu_t& c)noexcept {
+			affinity_t a;
+			::std::memset(&a, 0, sizeof(a));
+			a.Group = c.group;
+			a.Mask = KAFFINITY(1) << c.number;
+			return set_affinity(h, a);
+		}
+#elif defined(NNTL_NUMA_LINUX)
+		typedef cpu_set_t affinity_t;
+		typedef pthread_t native_thread_t;
+
+		inline native_thread_t current_thread()noexcept { return ::pthread_self(); }
+		inline bool get_affinity(native_thread_t h, affinity_t& a)noexcept {
+			CPU_ZERO(&a);
+			return 0 == ::pthread_getaffinity_np(h, sizeof(a), &a);
+		}
+		inline bool set_affinity(native_thread_t h, const affinity_t& a)noexcept {
+			return 0 == ::pthread_setaffinity_np(h, sizeof(a), &a);
+		}
+		inline bool pin_to(native_thread_t h, const cpu_t& c)noexcept {
+			if (c.number >= CPU_SETSIZE) return false;
+			affinity_t a;
+			CPU_ZERO(&a);
+			CPU_SET(c.number, &a);
+			return set_affinity(h, a);
+		}
+#else
+		struct affinity_t {};
+		typedef int native_thread_t;
+
+		inline native_thread_t current_thread()noexcept { return 0; }
+		inline bool get_affinity(native_thread_t, affinity_t&)noexcept { return false; }
+		inline bool set_affinity(native_thread_t, const affinity_t&)noexcept { return false; }
+		inline bool pin_to(native_thread_t, const cpu_t&)noexcept { return false; }
+#endif
+	}
+
+	//pins the calling (main) thread to order[0] and the worker thread #i to order[(i+1) % order.size()]. For threads::Workers
+	// it means that par_range_t with tid()==t is executed on the CPU order[t]. Original affinity is restored by the destructor.
+	// If pinning of any thread failed, all threads are restored and pinned() returns false. tid_nodes() is filled anyway
+	// (it's just the expected placement then), because the first touch by a thread still tends to land on its current node.
+	template<typename iThreadsT>
+	class pin_workers {
+	public:
+		typedef iThreadsT iThreads_t;
+
+	protected:
+		iThreads_t& m_iT;
+		::std::vector<node_id_t> m_tidNodes;
+		::std::vector<_impl::affinity_t> m_origAffinity;//[0] is the main thread, [i+1] is the worker thread #i
+		node_id_t m_nodesCnt;
+		bool m_bPinned;
+
+	public:
+		~pin_workers()noexcept {
+			if (m_bPinned) _restore(static_cast<thread_id_t>(m_origAffinity.size()));
+		}
+
+		pin_workers(iThreads_t& iT, const PinOrder po = PinOrder::Compact)noexcept : m_iT(iT), m_nodesCnt(0), m_bPinned(false) {
+			const topology topo;
+			_apply(topo.order(po), topo.nodes_count());
+		}
+
+		//use the order explicitly. Must not be empty
+		pin_workers(iThreads_t& iT, const ::std::vector<cpu_t>& order)noexcept : m_iT(iT), m_nodesCnt(0), m_bPinned(false) {
+			NNTL_ASSERT(!order.empty());
+			::std::vector<node_id_t> nds;
+			for (const auto& c : order) nds.push_back(c.node);
+			::std::sort(nds.begin(), nds.end());
+			_apply(order, static_cast<node_id_t>(::std::unique(nds.begin(), nds.end()) - nds.begin()));
+		}
+
+		bool pinned()const noexcept { return m_bPinned; }
+		node_id_t nodes_count()const noexcept { return m_nodesCnt; }
+
+		//tid_nodes()[t] is the NUMA node of the thread that executes par_range_t with tid()==t
+		const ::std::vector<node_id_t>& tid_nodes()const noexcept { return m_tidNodes; }
+
+	protected:
+		void _apply(const ::std::vector<cpu_t>& order, const node_id_t nodesCnt)noexcept {
+			if (order.empty()) return;
+			m_nodesCnt = nodesCnt;
+
+			thread_id_t cnt;
+			auto head = m_iT.get_worker_threads(cnt);
+			const size_t totThreads = static_cast<size_t>(cnt) + 1;
+
+			m_tidNodes.resize(totThreads);
+			for (size_t t = 0; t < totThreads; ++t) m_tidNodes[t] = order[t % order.size()].node;
+
+			m_origAffinity.resize(totThreads);
+			if (!_impl::get_affinity(_impl::current_thread(), m_origAffinity[0])) return;
+			for (thread_id_t i = 0; i < cnt; ++i) {
+				if (!_impl::get_affinity(head->native_handle(), m_origAffinity[i + 1])) return;
+				++head;
+			}
+
+			if (!_impl::pin_to(_impl::current_thread(), order[0])) {
+				STDCOUTL("***Failed to pin the main thread");
+				return;
+			}
+			head = m_iT.get_worker_threads(cnt);
+			for (thread_id_t i = 0; i < cnt; ++i) {
+				if (!_impl::pin_to(head->native_handle(), order[(i + 1) % order.size()])) {
+					STDCOUTL("***Failed to pin the worker thread #" << i);
+					_restore(i + 1);
+					return;
+				}
+				++head;
+			}
+			m_bPinned = true;
+		}
+
+		//restores the main thread and first n-1 worker threads
+		void _restore(const thread_id_t n)noexcept {
+			if (!n) return;
+			if (!_impl::set_affinity(_impl::current_thread(), m_origAffinity[0])) STDCOUTL("***Failed to restore the main thread affinity");
+			thread_id_t cnt;
+			auto head = m_iT.get_worker_threads(cnt);
+			for (thread_id_t i = 0; i + 1 < n && i < cnt; ++i) {
+				if (!_impl::set_affinity(head->native_handle(), m_origAffinity[i + 1]))
+					STDCOUTL("***Failed to restore the affinity of the worker thread #" << i);
+				++head;
+			}
+		}
+	};
+
+	//zeroes the [ptr, ptr+numel) by the worker threads. Call it right after the allocation and before anything else touches the
+	// memory. Pages of every range land on the node of the thread that will process the same range in an elementwise kernel
+	// (Workers::run() over numel elements using all threads gives the same partitioning)
+	template<typename iThreadsT, typename T>
+	void first_touch(iThreadsT& iT, T*const ptr, const typename iThreadsT::range_t numel)noexcept {
+		static_assert(::std::is_trivially_copyable<T>::value, "");
+		if (!numel) return;
+		NNTL_ASSERT(ptr);
+		iT.run([ptr](const typename iThreadsT::par_range_t& r)noexcept {
+			::std::fill_n(ptr + r.offset(), r.cnt(), T(0));
+		}, numel);
+	}
+
+	//per node copies of read-only data. make() must be called after the threads are pinned
+	template<typename T>
+	class node_replicas {
+	protected:
+		::std::vector<::std::unique_ptr<T[]>> m_copies;
+		::std::vector<const T*> m_tidPtrs;
+		const T* m_pSrc;
+		size_t m_numel;
+
+	public:
+		~node_replicas()noexcept {}
+		node_replicas()noexcept : m_pSrc(nullptr), m_numel(0) {}
+
+		void clear()noexcept {
+			m_copies.clear();
+			m_tidPtrs.clear();
+			m_pSrc = nullptr;
+			m_numel = 0;
+		}
+
+		//true if there's more than one copy (i.e. threads span several nodes)
+		bool replicated()const noexcept { return !m_copies.empty(); }
+		//returns true when the replicas were made for exactly this data
+		bool made_for(const T*const pSrc, const size_t numel)const noexcept { return m_pSrc && pSrc == m_pSrc && numel == m_numel; }
+		const T* source()const noexcept { return m_pSrc; }
+
+		//the data to be read by the thread that executes par_range_t with the tid()==t
+		const T* for_tid(const thread_id_t t)const noexcept {
+			NNTL_ASSERT(m_pSrc);
+			NNTL_ASSERT(!replicated() || static_cast<size_t>(t) < m_tidPtrs.size() || !"the threads count grew since make()");
+			return replicated() ? m_tidPtrs[t] : m_pSrc;
+		}
+
+		//tidNodes is pin_workers::tid_nodes(). Only the threads run() currently uses (see iThreads::max_threads()) are taken into
+		// account, so make() must be redone if that cap is raised. If all such tids belong to the same node, no copies are made
+		// and for_tid() returns pSrc. Every copy is written by the threads of its node only: a thread of a node with k threads
+		// copies 1/k-th part of the data. Returns false if failed to allocate memory
+		template<typename iThreadsT>
+		bool make(iThreadsT& iT, const ::std::vector<node_id_t>& tidNodes, const T*const pSrc, const size_t numel)noexcept {
+			clear();
+			NNTL_ASSERT(pSrc && numel);
+			m_pSrc = pSrc;
+			m_numel = numel;
+
+			NNTL_ASSERT(tidNodes.size() >= static_cast<size_t>(iT.max_threads()) && "tidNodes must describe all threads run() uses");
+			const size_t tidsCnt = ::std::min(tidNodes.size(), static_cast<size_t>(iT.max_threads()));
+			if (tidsCnt < 2 || ::std::all_of(tidNodes.begin(), tidNodes.begin() + tidsCnt
+				, [n = tidNodes[0]](const node_id_t v)noexcept {return v == n; }))
+			{
+				return true;
+			}
+
+			//copy index of a tid, rank of the tid among the tids of the same node and the count of such tids
+			::std::vector<size_t> tidCopy(tidsCnt), tidRank(tidsCnt);
+			::std::vector<node_id_t> nodes;
+			::std::vector<size_t> nodeTids;
+			for (size_t t = 0; t < tidsCnt; ++t) {
+				const auto it = ::std::find(nodes.begin(), nodes.end(), tidNodes[t]);
+				const size_t ci = static_cast<size_t>(it - nodes.begin());
+				if (it == nodes.end()) {
+					nodes.push_back(tidNodes[t]);
+					nodeTids.push_back(0);
+				}
+				tidCopy[t] = ci;
+				tidRank[t] = nodeTids[ci]++;
+			}
+
+			m_copies.resize(nodes.size());
+			for (auto& c : m_copies) {
+				//memory mustn't be touched here
+				c.reset(new(::std::nothrow) T[numel]);
+				if (!c) {
+					clear();
+					return false;
+				}
+			}
+			m_tidPtrs.resize(tidsCnt);
+			for (size_t t = 0; t < tidsCnt; ++t) m_tidPtrs[t] = m_copies[tidCopy[t]].get();
+
+			//running over exactly tidsCnt elements makes every thread to execute a single range with its own tid
+			iT.run([this, pSrc, numel, &tidCopy, &tidRank, &nodeTids](const typename iThreadsT::par_range_t& r)noexcept {
+				const size_t t = r.tid();
+				const size_t k = nodeTids[tidCopy[t]], j = tidRank[t];
+				const size_t b = numel*j / k, e = numel*(j + 1) / k;
+				::std::copy(pSrc + b, pSrc + e, m_copies[tidCopy[t]].get() + b);
+			}, static_cast<typename iThreadsT::range_t>(tidsCnt));
+			return true;
+		}
+	};
+
+}
+}
+}
@@ -33,8 +33,20 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #ifdef _WIN32_WINNT
 #include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
 #else
-#pragma message("prioritize_workers class is implemented only for Windows platform. Implement it for your OS or the dummy/empty class will be used instead.")
+#pragma message("prioritize_workers class is implemented only for Windows and Linux platforms. Implement it for your OS or the dummy/empty class will be used instead.")
 #endif
 
 #include "../_i_threads.h"
@@ -241,6 +253,283 @@ namespace threads {
 
 	using Funcs = _impl::Funcs;
 	
+#elif defined(__linux__)
+
+	namespace _impl {
+
+		//Linux has neither process priority classes nor dynamic priority boosts, so Windows notions are mapped as follows:
+		// - priority class -> nice value of every thread of the process (nice is per thread in Linux, so /proc/self/task is
+		//		walked). Normal is nice 0, Working is -10 and PerfTesting is -20. If the process lacks CAP_SYS_NICE, the lowest value
+		//		permitted by RLIMIT_NICE is used instead (that may mean no change at all)
+		// - thread priority -> scheduling policy of the main and worker threads. PerfTesting tries SCHED_FIFO (requires
+		//		CAP_SYS_NICE or non-zero RLIMIT_RTPRIO, silently falls back to SCHED_OTHER), others use SCHED_OTHER
+		// - threads_priority_below_current/below_current2 (used by BgWorkers) -> SCHED_BATCH/SCHED_IDLE policy
+		// Additionally, the pool threads could be restricted to a set of cores with Funcs::SetPoolCpus() or with the NNTL_POOL_CPUS
+		// environment variable (cpulist format, i.e. "0-7,16-23"). Current thread affinity is intersected with that set, so
+		// the pinning done by threads::numa::pin_workers survives if it is compatible with the set.
+		struct linux_sched {
+			struct thread_state {
+				sched_param sp;
+				cpu_set_t affinity;
+				int policy;
+				bool bAffinity;
+			};
+
+			static pid_t current_tid()noexcept { return static_cast<pid_t>(::syscall(SYS_gettid)); }
+
+			static bool get_nice(const pid_t tid, int& n)noexcept {
+				errno = 0;
+				n = ::getpriority(PRIO_PROCESS, static_cast<id_t>(tid));
+				return 0 == errno;
+			}
+
+			//sets the nice to the target or to the closest permitted value. Returns false only on a real error
+			static bool set_nice(const pid_t tid, const int target)noexcept {
+				if (0 == ::setpriority(PRIO_PROCESS, static_cast<id_t>(tid), target)) return true;
+				if (EPERM != errno && EACCES != errno) return false;
+
+				rlimit rl;
+				int cur;
+				if (0 != ::getrlimit(RLIMIT_NICE, &rl) || !get_nice(tid, cur)) return false;
+				const int lowest = RLIM_INFINITY == rl.rlim_cur ? -20 : 20 - static_cast<int>(::std::min(rl.rlim_cur, rlim_t(40)));
+				//raising the nice value is always permitted
+				const int t = ::std::max(target, ::std::min(lowest, cur));
+				return t == cur || 0 == ::setpriority(PRIO_PROCESS, static_cast<id_t>(tid), t);
+			}
+
+			static bool process_tids(::std::vector<pid_t>& v)noexcept {
+				v.clear();
+				DIR* pDir = ::opendir("/proc/self/task");
+				if (!pDir) return false;
+				while (const dirent* pE = ::readdir(pDir)) {
+					if (pE->d_name[0] >= '0' && pE->d_name[0] <= '9') v.push_back(static_cast<pid_t>(::std::strtol(pE->d_name, nullptr, 10)));
+				}
+				::closedir(pDir);
+				return !v.empty();
+			}
+
+			static ::std::vector<unsigned> parse_cpulist(const char* p)noexcept {
+				::std::vector<unsigned> ret;
+				if (!p) return ret;
+				while (*p >= '0' && *p <= '9') {
+					char* pEnd;
+					const unsigned long first = ::std::strtoul(p, &pEnd, 10);
+					unsigned long last = first;
+					p = pEnd;
+					if ('-' == *p) {
+						last = ::std::strtoul(p + 1, &pEnd, 10);
+						p = pEnd;
+					}
+					for (unsigned long c = first; c <= last && c < CPU_SETSIZE; ++c) ret.push_back(static_cast<unsigned>(c));
+					if (',' == *p) ++p;
+				}
+				return ret;
+			}
+
+			//empty means the pool isn't restricted
+			static ::std::vector<unsigned>& pool_cpus()noexcept {
+				static ::std::vector<unsigned> v = parse_cpulist(::std::getenv("NNTL_POOL_CPUS"));
+				return v;
+			}
+
+			static bool save(const pthread_t h, thread_state& s)noexcept {
+				s.bAffinity = false;
+				return 0 == ::pthread_getschedparam(h, &s.policy, &s.sp)
+					&& 0 == ::pthread_getaffinity_np(h, sizeof(s.affinity), &s.affinity);
+			}
+			static bool restore(const pthread_t h, const thread_state& s)noexcept {
+				const bool b = 0 == ::pthread_setschedparam(h, s.policy, &s.sp);
+				return (!s.bAffinity || 0 == ::pthread_setaffinity_np(h, sizeof(s.affinity), &s.affinity)) && b;
+			}
+
+			//bRealtime tries SCHED_FIFO first
+			static bool set_policy(const pthread_t h, const bool bRealtime)noexcept {
+				sched_param sp;
+				if (bRealtime) {
+					sp.sched_priority = ::sched_get_priority_min(SCHED_FIFO);
+					if (0 == ::pthread_setschedparam(h, SCHED_FIFO, &sp)) return true;
+				}
+				sp.sched_priority = 0;
+				return 0 == ::pthread_setschedparam(h, SCHED_OTHER, &sp);
+			}
+
+			//restricts the thread to pool_cpus(), if set. s must contain the saved state
+			static bool apply_pool_cpus(const pthread_t h, thread_state& s)noexcept {
+				const auto& pc = pool_cpus();
+				if (pc.empty()) return true;
+				cpu_set_t pool, cs;
+				CPU_ZERO(&pool);
+				for (const auto c : pc) CPU_SET(c, &pool);
+				CPU_AND(&cs, &pool, &s.affinity);
+				if (0 == CPU_COUNT(&cs)) cs = pool;
+				if (0 != ::pthread_setaffinity_np(h, sizeof(cs), &cs)) return false;
+				s.bAffinity = true;
+				return true;
+			}
+		};
+
+		struct Funcs {
+			//CFS doesn't boost priorities dynamically, nothing to do
+			static bool AllowCurrentThreadPriorityBoost(bool bAllow)noexcept {
+				NNTL_UNREF(bAllow);
+				return true;
+			}
+
+			template<typename ThreadObjT>
+			static bool ChangeThreadsPriorities(ThreadObjT& iT, const PriorityClass pc)noexcept {
+				NNTL_ASSERT(pc > PriorityClass::threads_priority_first && pc < PriorityClass::threads_priority_last);
+				if (pc != PriorityClass::threads_priority_below_current && pc != PriorityClass::threads_priority_below_current2)
+					return true;
+
+				sched_param sp;
+				sp.sched_priority = 0;
+				const int policy = pc == PriorityClass::threads_priority_below_current ? SCHED_BATCH : SCHED_IDLE;
+
+				thread_id_t cnt, i = 0;
+				auto head = iT.get_worker_threads(cnt);
+				::std::vector<linux_sched::thread_state> orig(cnt);
+				for (; i < cnt; ++i) {
+					if (!linux_sched::save(head->native_handle(), orig[i]) || 0 != ::pthread_setschedparam(head->native_handle(), policy, &sp)) {
+						STDCOUTL("***Failed to set thread priority for thread #" << i);
+						head = iT.get_worker_threads(cnt);
+						for (thread_id_t j = 0; j < i; ++j) {
+							if (!linux_sched::restore(head->native_handle(), orig[j]))
+								STDCOUTL("***Failed to restore original thread priority for thread #" << j);
+							head++;
+						}
+						break;
+					}
+					head++;
+				}
+				return i == cnt;
+			}
+
+			//restricts the threads of a pool to the cpus while prioritize_workers object with a mode other than Normal is alive.
+			// Pass an empty vector to remove the restriction. Overrides NNTL_POOL_CPUS environment variable
+			static void SetPoolCpus(const ::std::vector<unsigned>& cpus)noexcept {
+				auto& pc = linux_sched::pool_cpus();
+				pc.clear();
+				for (const auto c : cpus) if (c < CPU_SETSIZE) pc.push_back(c);
+			}
+			static const ::std::vector<unsigned>& PoolCpus()noexcept { return linux_sched::pool_cpus(); }
+		};
+
+		template<PriorityClass _m> struct PrCThP_linux {};
+		template<> struct PrCThP_linux<PriorityClass::Normal> {
+			static constexpr int nice = 0;
+			static constexpr bool bRealtime = false;
+			static constexpr bool bUsePoolCpus = false;
+		};
+		template<> struct PrCThP_linux<PriorityClass::Working> {
+			static constexpr int nice = -10;
+			static constexpr bool bRealtime = false;
+			static constexpr bool bUsePoolCpus = true;
+		};
+		template<> struct PrCThP_linux<PriorityClass::PerfTesting> {
+			static constexpr int nice = -20;
+			static constexpr bool bRealtime = true;
+			static constexpr bool bUsePoolCpus = true;
+		};
+
+		template<PriorityClass _mode, typename iThreadsT>
+		class prioritize_workers_linux {
+		public:
+			typedef iThreadsT iThreads_t;
+
+		protected:
+			iThreads_t& m_iT;
+			//original nice values of all threads of the process
+			::std::vector<::std::pair<pid_t, int>> m_origNice;
+			//[0] is the main thread, [i+1] is the worker thread #i
+			::std::vector<linux_sched::thread_state> m_origThreads;
+			const pthread_t m_mainThread;
+			const bool m_bAllThreads;
+
+		public:
+			~prioritize_workers_linux()noexcept {
+				if (!m_origThreads.empty()) {
+					if (!linux_sched::restore(m_mainThread, m_origThreads[0])) STDCOUTL("***Failed to restore original thread priority for main thread");
+
+					thread_id_t cnt;
+					auto head = m_iT.get_worker_threads(cnt);
+					for (thread_id_t i = 0; i + 1 < m_origThreads.size() && i < cnt; i++) {
+						if (!linux_sched::restore(head->native_handle(), m_origThreads[i + 1]))
+							STDCOUTL("***Failed to restore original thread priority for thread #" << i);
+						head++;
+					}
+				}
+				//threads may have gone away since, so errors are ignored
+				for (const auto& e : m_origNice) ::setpriority(PRIO_PROCESS, static_cast<id_t>(e.first), e.second);
+			}
+
+			prioritize_workers_linux(iThreads_t& iT, const bool bAllThreads = true)noexcept
+				: m_iT(iT), m_mainThread(::pthread_self()), m_bAllThreads(bAllThreads)
+			{
+				_apply();
+			}
+
+		protected:
+			void _apply()noexcept {
+				typedef PrCThP_linux<_mode> PriorityData;
+
+				::std::vector<pid_t> tids;
+				if (linux_sched::process_tids(tids)) {
+					m_origNice.reserve(tids.size());
+					for (const auto t : tids) {
+						int n;
+						if (linux_sched::get_nice(t, n)) {
+							if (linux_sched::set_nice(t, PriorityData::nice)) {
+								m_origNice.push_back(::std::make_pair(t, n));
+							} else if (ESRCH != errno) STDCOUTL("***Failed to set nice value of thread " << t);
+						}
+					}
+				} else STDCOUTL("***Failed to enumerate process threads");
+
+				thread_id_t cnt = 0;
+				auto head = m_iT.get_worker_threads(cnt);
+				if (!m_bAllThreads) cnt = 0;
+
+				m_origThreads.resize(cnt + 1);
+				if (!linux_sched::save(m_mainThread, m_origThreads[0])) {
+					STDCOUTL("****** Prioritization failed - can't get original values");
+					m_origThreads.clear();
+					return;
+				}
+				for (thread_id_t i = 0; i < cnt; ++i) {
+					if (!linux_sched::save(head->native_handle(), m_origThreads[i + 1])) {
+						STDCOUTL("****** Prioritization failed - can't get original values");
+						m_origThreads.clear();
+						return;
+					}
+					head++;
+				}
+
+				if (!linux_sched::set_policy(m_mainThread, PriorityData::bRealtime)) STDCOUTL("***Failed to set main thread priority");
+				if (PriorityData::bUsePoolCpus && !linux_sched::apply_pool_cpus(m_mainThread, m_origThreads[0]))
+					STDCOUTL("***Failed to restrict main thread to the pool cpus");
+
+				head = m_iT.get_worker_threads(cnt);
+				if (!m_bAllThreads) cnt = 0;
+				for (thread_id_t i = 0; i < cnt; ++i) {
+					const auto h = head->native_handle();
+					if (!linux_sched::set_policy(h, PriorityData::bRealtime)) STDCOUTL("***Failed to set thread priority for thread #" << i);
+					if (PriorityData::bUsePoolCpus && !linux_sched::apply_pool_cpus(h, m_origThreads[i + 1]))
+						STDCOUTL("***Failed to restrict thread #" << i << " to the pool cpus");
+					//makes the pool visible in top -H, perf and gdb. Name is limited to 15 chars
+					char name[16];
+					::std::snprintf(name, sizeof(name), "nntl_w%u", static_cast<unsigned>((i + 1) % 100000));
+					::pthread_setname_np(h, name);
+					head++;
+				}
+			}
+		};
+	}
+
+	template<PriorityClass mode, typename iThreads_t>
+	using prioritize_workers = _impl::prioritize_workers_linux<mode, iThreads_t>;
+
+	using Funcs = _impl::Funcs;
+
 #else
 
 	template<PriorityClass mode, typename iThreads_t>
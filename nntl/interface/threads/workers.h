@@ -32,12 +32,16 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include "../_i_threads.h"
+#include <memory>
 
 namespace nntl {
 namespace threads {
 
 	//TODO: error handling!!!
 
+	//If SyncT is threads::spin_park_sync_primitives (or any other type with bSpinThenPark==true), jobs are dispatched through
+	// per-worker futex_word sequence counters: a worker spins for spin_count() iterations after each job and parks only then,
+	// the main thread spins (and then parks) waiting for the completion counter. Otherwise condition variables are used.
 	template <typename RealT, typename RangeT = ::std::size_t
 		, typename SyncT = threads::sync_primitives
 		, typename CallHandlerT = utils::cmcforwarderWrapper<2 * sizeof(void*)> //too large internal storage leads to worse performance
@@ -54,7 +58,11 @@ namespace threads {
 		typedef CallHandlerT CallH_t;
 		typedef SyncT Sync_t;
 
+		static constexpr bool bSpinThenPark = is_spin_park_sync<Sync_t>::value;
+
 	protected:
+		typedef ::std::integral_constant<bool, bSpinThenPark> spin_park_mode_t;
+
 		typedef typename CallH_t::template call_tpl<void(const par_range_t& r)> func_run_t;
 		typedef typename CallH_t::template call_tpl<real_t(const par_range_t& r)> func_reduce_t;
 
@@ -86,29 +94,45 @@ namespace threads {
 		func_reduce_t m_fnReduce;
 
 		const thread_id_t m_workersCnt;
+		thread_id_t m_maxThreads;//runtime cap on threads count (including the main thread) used by run()/reduce()
 		threads_cont_t m_threads;
 		::std::atomic<bool> m_bStop;
 
+		//spin-then-park mode only.
+		struct WorkerSeq {
+			futex_word seq;//incremented by the main thread to hand the m_ranges[i] order to the worker i
+			char _pad[64];//different workers spin on different cache lines
+		};
+		::std::unique_ptr<WorkerSeq[]> m_workerSeqs;
+		futex_word m_pendingCnt;//count of workers that haven't finished the current order yet
+		unsigned m_spinCount;
+
 	public:
 		~Workers()noexcept {
 			m_bStop = true;
-
-			//m_mutex.lock();
-			m_waitingOrders.notify_all();
-			//m_mutex.unlock();
-
+			_wake_all_workers(spin_park_mode_t());
 			for (auto& t : m_threads)  t.join();
 		}
 
-		Workers()noexcept : m_bStop(false), m_workersCnt(workers_count() - 1), m_workingCnt(0) {
-			NNTL_ASSERT(m_workersCnt > 0);
+		Workers()noexcept : Workers(workers_count()) {}
+
+		//creates a pool of nThreads threads (including the main thread, clamped to [1, workers_count()]). Use it when several
+		// pools share the same cores (for example, concurrent tasks of layer_pack_horizontal) to not oversubscribe them.
+		// workers_count() remains the same, so per-thread storage sized with it is still valid
+		explicit Workers(const thread_id_t nThreads)noexcept : m_bStop(false)
+			, m_workersCnt((nThreads < 1 ? 1 : (nThreads > workers_count() ? workers_count() : nThreads)) - 1)
+			, m_maxThreads(m_workersCnt + 1), m_workingCnt(0), m_pendingCnt(0)
+			, m_spinCount(_default_spin_count(spin_park_mode_t()))
+		{
 
 			m_ranges.reserve(m_workersCnt);
 			m_threads.resize(m_workersCnt);
 			m_reduceCache.resize(m_workersCnt + 1);
+			if (bSpinThenPark) m_workerSeqs.reset(new WorkerSeq[m_workersCnt]);
 
 			m_mutex.lock();
 			m_workingCnt = m_workersCnt;
+			m_pendingCnt.store(m_workersCnt);
 
 			for (thread_id_t i = 0; i < m_workersCnt; ++i) {
 				//worker threads should have par_range_t::tid>=1. tid==0 is reserved to main thread
@@ -119,9 +143,22 @@ namespace threads {
 			NNTL_ASSERT(m_ranges.size() == m_workersCnt);
 			m_mutex.unlock();
 
-			::std::unique_lock<decltype(m_mutex)> lk(m_mutex);
-			m_orderDone.wait(lk, [&wc = m_workingCnt]() throw() {return wc <= 0; });
+			_wait_orders_done(spin_park_mode_t());
+		}
+
+		//how many pause instructions a worker (and the main thread) spins waiting for the next order before parking.
+		// Spin-then-park mode only; set it when the pool is idle
+		void spin_count(const unsigned sc)noexcept { m_spinCount = sc; }
+		unsigned spin_count()const noexcept { return m_spinCount; }
+
+		//limits the number of threads (including the main thread) that run()/reduce() will use. Can't exceed the pool size.
+		// Note that idle threads of a capped pool still exist, so pools that permanently share cores should rather be
+		// constructed with the proper size. Set it when the pool is idle
+		thread_id_t max_threads(const thread_id_t n)noexcept {
+			m_maxThreads = n < 1 ? 1 : (n > m_workersCnt + 1 ? m_workersCnt + 1 : n);
+			return m_maxThreads;
 		}
+		thread_id_t max_threads()const noexcept { return m_maxThreads; }
 
 		static thread_id_t workers_count()noexcept {
 			return ::std::thread::hardware_concurrency();
@@ -151,7 +188,7 @@ namespace threads {
 		//never call recursively or from non-main thread
 		template<typename Func>
 		void run(Func&& F, const range_t cnt, const thread_id_t useNThreads = 0, thread_id_t* pThreadsUsed = nullptr) noexcept {
-			if (cnt <= 1) {
+			if (cnt <= 1 || 1 == m_maxThreads) {
 				if (pThreadsUsed) *pThreadsUsed = 1;
 				::std::forward<Func>(F)(par_range_t(cnt));
 			} else {
@@ -164,7 +201,7 @@ namespace threads {
 		template<typename Func>
 		void _run(Func&& F, const range_t cnt, const thread_id_t useNThreads = 0, thread_id_t* pThreadsUsed = nullptr) noexcept {
 			NNTL_ASSERT(cnt > 1);
-			m_mutex.lock();
+			_lock_orders(spin_park_mode_t());
 
 			m_fnRun = F;
 			m_jobType = JobType::Run;
@@ -173,23 +210,20 @@ namespace threads {
 			NNTL_ASSERT(prevOfs < cnt);
 			if (pThreadsUsed) *pThreadsUsed = static_cast<thread_id_t>(m_workingCnt) + 1;
 
-			m_waitingOrders.notify_all();
-			m_mutex.unlock();
+			_publish_orders(spin_park_mode_t());
 
 			//::std::forward<Func>(F)(par_range_t(prevOfs, cnt - prevOfs, 0));
 			//we mustn't forward F here, because we're using it in this function multiple times as normal lvalue
 			F(par_range_t(prevOfs, cnt - prevOfs, 0));
 
-			if (m_workingCnt > 0) {
-				Sync_t::lock_wait_unlock(m_mutex, m_orderDone, [&wc = m_workingCnt]() {return wc <= 0; });
-			}
+			_wait_orders_done(spin_park_mode_t());
 		}
 
 	public:
 		//never call recursively or from non-main thread
 		template<typename Func, typename FinalReduceFunc>
 		real_t reduce(Func&& FRed, FinalReduceFunc&& FRF, const range_t cnt, const thread_id_t useNThreads = 0) noexcept {
-			return cnt <= 1
+			return cnt <= 1 || 1 == m_maxThreads
 				? ::std::forward<Func>(FRed)(par_range_t(cnt))
 				: _reduce(CallH_t::wrap<Func>(::std::forward<Func>(FRed)), ::std::forward<FinalReduceFunc>(FRF), cnt, useNThreads);
 		}
@@ -200,7 +234,7 @@ namespace threads {
 		template<typename Func, typename FinalReduceFunc>
 		real_t _reduce(Func&& FRed, FinalReduceFunc&& FRF, const range_t cnt, const thread_id_t useNThreads = 0) noexcept {
 			NNTL_ASSERT(cnt > 1);
-			m_mutex.lock();
+			_lock_orders(spin_park_mode_t());
 
 			m_fnReduce = FRed;
 			m_jobType = JobType::Reduce;
@@ -212,24 +246,66 @@ namespace threads {
 			const range_t workersOnReduce = m_workingCnt + 1;
 			NNTL_ASSERT(workersOnReduce <= m_reduceCache.size());
 
-			m_waitingOrders.notify_all();
-			m_mutex.unlock();
+			_publish_orders(spin_park_mode_t());
 
 			//*rc = (::std::forward<Func>(FRed))(par_range_t(prevOfs, cnt - prevOfs, 0));
 			*rc = FRed(par_range_t(prevOfs, cnt - prevOfs, 0));
 
+			_wait_orders_done(spin_park_mode_t());
+			return (::std::forward<FinalReduceFunc>(FRF))(rc, workersOnReduce);//OK to forward as we don't care if rvalue-qualified operator spoils it
+		}
+
+	protected:
+		//////////////////////////////////////////////////////////////////////////
+		// condition variables mode
+		void _lock_orders(::std::false_type)noexcept { m_mutex.lock(); }
+		void _publish_orders(::std::false_type)noexcept {
+			m_waitingOrders.notify_all();
+			m_mutex.unlock();
+		}
+		void _wait_orders_done(::std::false_type)noexcept {
 			if (m_workingCnt > 0) {
 				Sync_t::lock_wait_unlock(m_mutex, m_orderDone, [&wc = m_workingCnt]() {return wc <= 0; });
 			}
-			return (::std::forward<FinalReduceFunc>(FRF))(rc, workersOnReduce);//OK to forward as we don't care if rvalue-qualified operator spoils it
 		}
+		void _wake_all_workers(::std::false_type)noexcept {
+			//m_mutex.lock();
+			m_waitingOrders.notify_all();
+			//m_mutex.unlock();
+		}
+		static constexpr unsigned _default_spin_count(::std::false_type)noexcept { return 0; }
 
-	protected:
+		//////////////////////////////////////////////////////////////////////////
+		// spin-then-park mode
+		static constexpr unsigned _default_spin_count(::std::true_type)noexcept { return Sync_t::defaultSpinCount; }
+		static constexpr void _lock_orders(::std::true_type)noexcept {}
+		void _publish_orders(::std::true_type)noexcept {
+			//only workers that got a non-empty range are signaled, the rest don't touch m_ranges at all
+			const auto wc = static_cast<thread_id_t>(m_workingCnt);
+			m_pendingCnt.store(wc);
+			for (thread_id_t i = 0; i < wc; ++i) {
+				auto& ws = m_workerSeqs[i].seq;
+				ws.fetch_add(1);
+				ws.wake_all();
+			}
+		}
+		void _wait_orders_done(::std::true_type)noexcept {
+			futex_word::value_t v;
+			while (0 != (v = m_pendingCnt.load())) m_pendingCnt.wait_while_equal(v, m_spinCount);
+			m_workingCnt = 0;
+		}
+		void _wake_all_workers(::std::true_type)noexcept {
+			for (thread_id_t i = 0; i < m_workersCnt; ++i) {
+				auto& ws = m_workerSeqs[i].seq;
+				ws.fetch_add(1);
+				ws.wake_all();
+			}
+		}
 
 		//returns an offset after last partitioned item
 		range_t partition_count_to_workers(const range_t cnt, const thread_id_t _useNThreads)noexcept {
 			//TODO: need cache friendly partitioning here
-			const thread_id_t useNThreads = _useNThreads > 1 && _useNThreads <= m_workersCnt + 1 ? _useNThreads - 1 : m_workersCnt;
+			const thread_id_t useNThreads = _useNThreads > 1 && _useNThreads <= m_maxThreads ? _useNThreads - 1 : m_maxThreads - 1;
 			const thread_id_t _workingCnt = cnt > useNThreads ? useNThreads : static_cast<thread_id_t>(cnt - 1);
 			m_workingCnt = _workingCnt;
 			const range_t totalWorkers = _workingCnt + 1;
@@ -251,10 +327,43 @@ namespace threads {
 
 		static void _s_worker(Workers* p, const thread_id_t id)noexcept {
 			global_denormalized_floats_mode();
-			p->_worker(id);
+			p->_worker(id, spin_park_mode_t());
 		}
 
-		void _worker(const thread_id_t id)noexcept {
+		void _execute_order(const thread_id_t id, par_range_t& thrdRange)noexcept {
+			switch (m_jobType) {
+			case JobType::Run:
+				m_fnRun(thrdRange);
+				break;
+			case JobType::Reduce:
+				m_reduceCache[id + 1] = m_fnReduce(thrdRange);
+				break;
+			default:
+				NNTL_ASSERT(!"WTF???");
+				abort();
+			}
+		}
+
+		void _worker(const thread_id_t id, ::std::true_type)noexcept {
+			auto& ws = m_workerSeqs[id].seq;
+			auto seen = ws.load();
+			//reporting readiness
+			if (1 == m_pendingCnt.fetch_sub(1)) m_pendingCnt.wake_all();
+
+			auto& thrdRange = m_ranges[id];
+			while (true) {
+				seen = ws.wait_while_equal(seen, m_spinCount);
+				if (m_bStop) break;
+
+				NNTL_ASSERT(0 != thrdRange.cnt());
+				_execute_order(id, thrdRange);
+				thrdRange.cnt(0);
+
+				if (1 == m_pendingCnt.fetch_sub(1)) m_pendingCnt.wake_all();
+			}
+		}
+
+		void _worker(const thread_id_t id, ::std::false_type)noexcept {
 			m_mutex.lock();
 			m_workingCnt--;
 			m_orderDone.notify_one();
@@ -267,17 +376,7 @@ namespace threads {
 				});
 				if (m_bStop) break;
 
-				switch (m_jobType) {
-				case JobType::Run:
-					m_fnRun(thrdRange);
-					break;
-				case JobType::Reduce:
-					m_reduceCache[id + 1] = m_fnReduce(thrdRange);
-					break;
-				default:
-					NNTL_ASSERT(!"WTF???");
-					abort();
-				}
+				_execute_order(id, thrdRange);
 
 				//must set lock here to prevent deadlock during lk.lock();while (m_workingCnt > 0)  m_orderDone.wait(lk);...
 
@@ -0,0 +1,549 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//Work-stealing alternative to threads::Workers.
+// Every thread (the calling "main" thread has id 0, worker threads have ids 1..workers_count()-1) owns a Chase-Lev deque.
+// A parallel region (run()/reduce()/run_dynamic()) is described by a stack object of the calling thread and the calling
+// thread pushes to its own deque one "helper" entry per additional thread the region may use. Any thread that pops or
+// steals a helper entry claims chunks of the region until none is left, so no thread waits on a statically assigned range
+// and idle threads just take the remaining chunks. The calling thread never sleeps while waiting for a region to complete:
+// it executes its own and stolen entries, therefore regions may be nested (run() may be called from inside of run()) and
+// fire-and-forget tasks (spawn()) may be executed while the main thread waits.
+//
+// run() and reduce() keep the exact semantic of Workers: the range is split into at most workers_count() contiguous slots
+// laid out in the same way and par_range_t::tid() is the slot index. Kernels that keep per-tid temporary data
+// (see smath.h _processMtx_cw() or AFRand_mt generators) work unchanged. However, tid is unique only within a single
+// region, so don't run concurrently (nested) regions that share a per-tid state (the same MathN or iRng object).
+
+#include "../_i_threads.h"
+#include <vector>
+#include <memory>
+
+namespace nntl {
+namespace threads {
+
+	namespace _impl {
+
+		//an entry of work-stealing deque
+		struct ws_item {
+			typedef void(*exec_fn_t)(ws_item*const pItem, const thread_id_t execId);
+
+			const exec_fn_t pfnExec;
+
+			ws_item(const exec_fn_t f)noexcept : pfnExec(f) {}
+		};
+
+		//Chase-Lev deque of a fixed capacity. That's the C11 version from "Correct and Efficient Work-Stealing for Weak
+		// Memory Models" by N.M.Le, A.Pop, A.Cohen, F.Zappa Nardelli (2013) without the buffer growth.
+		// push() and pop() must be called by the owner thread only, steal() could be called by any thread.
+		template<unsigned _Capacity>
+		class ws_deque {
+			static_assert(_Capacity >= 2 && 0 == (_Capacity & (_Capacity - 1)), "Capacity must be a power of 2");
+
+			ws_deque(const ws_deque& other)noexcept = delete;
+			ws_deque(ws_deque&& other)noexcept = delete;
+			ws_deque& operator=(const ws_deque& rhs) noexcept = delete;
+
+		public:
+			typedef ::std::int64_t index_t;
+			static constexpr index_t capacity = _Capacity;
+
+		protected:
+			::std::atomic<index_t> m_top;
+			//thieves modify m_top, the owner modifies m_bottom. Don't let them share a cache line
+			char _pad[64 - sizeof(::std::atomic<index_t>)];
+			::std::atomic<index_t> m_bottom;
+			::std::atomic<ws_item*> m_buf[_Capacity];
+
+		public:
+			~ws_deque()noexcept {}
+			ws_deque()noexcept : m_top(0), m_bottom(0) {
+				for (auto& e : m_buf) e.store(nullptr, ::std::memory_order_relaxed);
+			}
+
+			//returns false if the deque is full
+			bool push(ws_item*const p)noexcept {
+				NNTL_ASSERT(p);
+				const auto b = m_bottom.load(::std::memory_order_relaxed);
+				const auto t = m_top.load(::std::memory_order_acquire);
+				if (b - t >= capacity) return false;
+				m_buf[b & (capacity - 1)].store(p, ::std::memory_order_relaxed);
+				m_bottom.store(b + 1, ::std::memory_order_release);
+				return true;
+			}
+
+			ws_item* pop()noexcept {
+				const auto b = m_bottom.load(::std::memory_order_relaxed) - 1;
+				m_bottom.store(b, ::std::memory_order_relaxed);
+				::std::atomic_thread_fence(::std::memory_order_seq_cst);
+				auto t = m_top.load(::std::memory_order_relaxed);
+
+				ws_item* p = nullptr;
+				if (t <= b) {
+					p = m_buf[b & (capacity - 1)].load(::std::memory_order_relaxed);
+					if (t == b) {
+						//the last entry, racing with thieves for it
+						if (!m_top.compare_exchange_strong(t, t + 1, ::std::memory_order_seq_cst, ::std::memory_order_relaxed))
+							p = nullptr;
+						m_bottom.store(b + 1, ::std::memory_order_relaxed);
+					}
+				} else m_bottom.store(b + 1, ::std::memory_order_relaxed);
+				return p;
+			}
+
+			ws_item* steal()noexcept {
+				auto t = m_top.load(::std::memory_order_acquire);
+				::std::atomic_thread_fence(::std::memory_order_seq_cst);
+				const auto b = m_bottom.load(::std::memory_order_acquire);
+				if (t < b) {
+					const auto p = m_buf[t & (capacity - 1)].load(::std::memory_order_relaxed);
+					//if CAS fails, another thief or the owner got the entry. We don't retry, a caller will try another victim
+					if (m_top.compare_exchange_strong(t, t + 1, ::std::memory_order_seq_cst, ::std::memory_order_relaxed))
+						return p;
+				}
+				return nullptr;
+			}
+		};
+
+		//a parallel region description. It lives on the stack of the calling thread and is referenced by helper entries in
+		// the calling thread deque. Each helper entry claims chunks until they are exhausted, so when the last helper
+		// finished, there are no more references to the region.
+		template<typename RealT, typename RangeT>
+		struct ws_region : public ws_item {
+			typedef RealT real_t;
+			typedef RangeT range_t;
+			typedef parallel_range<range_t> par_range_t;
+			typedef void(*chunk_fn_t)(ws_region& R, const range_t chunk, const thread_id_t execId);
+
+			//that many reduce() results could be stored without a heap allocation
+			static constexpr range_t inplaceResults = 64;
+
+			void*const pFunc;
+			const chunk_fn_t pfnChunk;
+			real_t* pResults;
+
+			range_t totalCnt;
+			range_t nChunks;
+			range_t chunkCnt;
+			range_t residual;
+
+			::std::atomic<range_t> nextChunk;
+			::std::atomic<::std::ptrdiff_t> pendingHelpers;
+
+			real_t inplace[inplaceResults];
+
+			ws_region(const chunk_fn_t pfC, void*const pF)noexcept : ws_item(&_s_exec_helper), pFunc(pF), pfnChunk(pfC)
+				, pResults(nullptr), totalCnt(0), nChunks(0), chunkCnt(0), residual(0), nextChunk(0), pendingHelpers(0)
+			{}
+
+			//slot s of a static partitioning. Ranges are laid out exactly as threads::Workers does: the slot #1 gets the first
+			// range, the slot #0 (tid of the calling thread in Workers) gets the last one
+			par_range_t slot_range(const range_t s)const noexcept {
+				NNTL_ASSERT(s < nChunks);
+				const range_t i = s ? s - 1 : nChunks - 1;
+				return par_range_t(i*chunkCnt + (i < residual ? i : residual), chunkCnt + (i < residual ? 1 : 0)
+					, static_cast<thread_id_t>(s));
+			}
+			//chunk c of a dynamic partitioning
+			par_range_t chunk_range(const range_t c, const thread_id_t execId)const noexcept {
+				NNTL_ASSERT(c < nChunks);
+				const range_t ofs = c*chunkCnt, rest = totalCnt - ofs;
+				return par_range_t(ofs, rest < chunkCnt ? rest : chunkCnt, execId);
+			}
+
+			void work(const thread_id_t execId)noexcept {
+				while (true) {
+					const auto c = nextChunk.fetch_add(1, ::std::memory_order_relaxed);
+					if (c >= nChunks) break;
+					pfnChunk(*this, c, execId);
+				}
+			}
+
+			static void _s_exec_helper(ws_item*const p, const thread_id_t execId)noexcept {
+				auto& R = static_cast<ws_region&>(*p);
+				R.work(execId);
+				//the region may be destroyed right after the decrement, don't touch it anymore
+				R.pendingHelpers.fetch_sub(1, ::std::memory_order_acq_rel);
+			}
+		};
+	}
+
+	template <typename RealT, typename RangeT = ::std::size_t
+		, typename SyncT = threads::sync_primitives
+		, unsigned DequeCapacity = 1024
+	>
+	class WsWorkers : public _i_threads<RealT, RangeT> {
+		//!! copy constructor not needed
+		WsWorkers(const WsWorkers& other)noexcept = delete;
+		WsWorkers(WsWorkers&& other)noexcept = delete;
+		//!!assignment is not needed
+		WsWorkers& operator=(const WsWorkers& rhs) noexcept = delete;
+
+	private:
+		typedef WsWorkers self_t;
+		typedef _i_threads<RealT, RangeT> _base_class_t;
+
+	public:
+		typedef typename _base_class_t::real_t real_t;
+		typedef typename _base_class_t::range_t range_t;
+		typedef typename _base_class_t::par_range_t par_range_t;
+
+		typedef SyncT Sync_t;
+
+		typedef ::std::vector<::std::thread> threads_cont_t;
+		typedef threads_cont_t::iterator ThreadObjIterator_t;
+
+		//how many times an idle worker polls deques before it parks on the condition variable
+		static constexpr unsigned spinsBeforePark = 2048;
+
+	protected:
+		typedef _impl::ws_item ws_item_t;
+		typedef _impl::ws_deque<DequeCapacity> deque_t;
+		typedef _impl::ws_region<real_t, range_t> region_t;
+
+		typedef typename Sync_t::mutex_comp_t mutex_comp_t;
+		typedef typename Sync_t::cond_var_comp_t cond_var_comp_t;
+
+		struct ThreadCtx {
+			deque_t dq;
+			//denormalsOnInAnyThread() request state: 0 - no request, 1 - requested, 2 - answered "off", 3 - answered "on"
+			::std::atomic<int> denormState;
+			//xorshift32 state to choose a victim to steal from. Touched by the owner only
+			uint32_t rndState;
+
+			ThreadCtx()noexcept : denormState(0), rndState(1) {}
+		};
+
+		template<typename FTask>
+		struct SpawnedTask : public ws_item_t {
+			self_t& pool;
+			FTask func;
+
+			template<typename FArg>
+			SpawnedTask(self_t& p, FArg&& f)noexcept : ws_item_t(&_s_exec), pool(p), func(::std::forward<FArg>(f)) {}
+
+			static void _s_exec(ws_item_t*const p, const thread_id_t execId)noexcept {
+				const auto pT = static_cast<SpawnedTask*>(p);
+				auto& pool = pT->pool;
+				pT->func(execId);
+				delete pT;
+				pool.m_spawnedCnt.fetch_sub(1, ::std::memory_order_acq_rel);
+			}
+		};
+
+		struct _tls_t {
+			const self_t* pPool;
+			thread_id_t id;
+		};
+
+		//////////////////////////////////////////////////////////////////////////
+		//Members
+	protected:
+		const thread_id_t m_workersCnt;//worker threads only, i.e. workers_count()-1
+		thread_id_t m_maxThreads;//runtime cap on chunks count of run()/reduce(), see max_threads()
+		::std::unique_ptr<ThreadCtx[]> m_ctx;//m_workersCnt+1 contexts, [0] is for the calling thread
+		threads_cont_t m_threads;
+
+		mutex_comp_t m_mutex;
+		cond_var_comp_t m_cvWork;
+		//incremented each time new work is published. Parked workers wait for it to change
+		::std::atomic<uint64_t> m_epoch;
+		::std::atomic<int> m_sleepers;
+		::std::atomic<::std::ptrdiff_t> m_spawnedCnt;
+		::std::atomic<bool> m_bStop;
+
+	public:
+		~WsWorkers()noexcept {
+			wait_spawned();
+			m_bStop.store(true);
+			_notify();
+			for (auto& t : m_threads)  t.join();
+		}
+
+		WsWorkers()noexcept : WsWorkers(workers_count()) {}
+
+		//the same as Workers(nThreads): the pool has nThreads threads including the calling one
+		explicit WsWorkers(const thread_id_t nThreads)noexcept
+			: m_workersCnt((nThreads < 1 ? 1 : (nThreads > workers_count() ? workers_count() : nThreads)) - 1)
+			, m_maxThreads(m_workersCnt + 1), m_ctx(new ThreadCtx[m_workersCnt + 1])
+			, m_epoch(0), m_sleepers(0), m_spawnedCnt(0), m_bStop(false)
+		{
+			for (thread_id_t i = 0; i <= m_workersCnt; ++i) m_ctx[i].rndState = 0x9E3779B9u * (i + 1);
+
+			m_threads.reserve(m_workersCnt);
+			//worker threads have ids >= 1. id==0 is reserved to the main thread
+			for (thread_id_t i = 1; i <= m_workersCnt; ++i) m_threads.emplace_back(_s_worker, this, i);
+		}
+
+		static thread_id_t workers_count()noexcept {
+			return ::std::thread::hardware_concurrency();
+		}
+		auto get_worker_threads(thread_id_t& threadsCnt)noexcept ->ThreadObjIterator_t {
+			threadsCnt = m_workersCnt;
+			return m_threads.begin();
+		}
+
+		//the same as Workers::max_threads(). Note, that idle workers still steal, so the cap limits the parallelism of
+		// a single run()/reduce() call only
+		thread_id_t max_threads(const thread_id_t n)noexcept {
+			m_maxThreads = n < 1 ? 1 : (n > m_workersCnt + 1 ? m_workersCnt + 1 : n);
+			return m_maxThreads;
+		}
+		thread_id_t max_threads()const noexcept { return m_maxThreads; }
+
+		bool denormalsOnInAnyThread()noexcept {
+			const auto myId = _my_id();
+			for (thread_id_t i = 1; i <= m_workersCnt; ++i) {
+				if (i != myId) m_ctx[i].denormState.store(1, ::std::memory_order_release);
+			}
+			_notify();
+
+			bool bOn = isDenormalsOn();
+			for (thread_id_t i = 1; i <= m_workersCnt; ++i) {
+				if (i == myId) continue;
+				int s;
+				while ((s = m_ctx[i].denormState.load(::std::memory_order_acquire)) < 2) ::std::this_thread::yield();
+				bOn = bOn || 3 == s;
+				m_ctx[i].denormState.store(0, ::std::memory_order_relaxed);
+			}
+			return bOn;
+		}
+
+		//The same contract as Workers::run(), but could also be called from inside of another run()/spawn() task.
+		template<typename Func>
+		void run(Func&& F, const range_t cnt, const thread_id_t useNThreads = 0, thread_id_t* pThreadsUsed = nullptr) noexcept {
+			if (cnt <= 1 || 1 == m_maxThreads) {
+				if (pThreadsUsed) *pThreadsUsed = 1;
+				::std::forward<Func>(F)(par_range_t(cnt));
+			} else {
+				//we mustn't forward F, because it's called multiple times as normal lvalue
+				region_t R(&_s_run_slot<::std::remove_reference_t<Func>>, _func_ptr(F));
+				_partition(R, cnt, useNThreads);
+				if (pThreadsUsed) *pThreadsUsed = static_cast<thread_id_t>(R.nChunks);
+				_execute(R);
+			}
+		}
+
+		//The same contract as Workers::reduce(), but could also be called from inside of another run()/spawn() task.
+		template<typename Func, typename FinalReduceFunc>
+		real_t reduce(Func&& FRed, FinalReduceFunc&& FRF, const range_t cnt, const thread_id_t useNThreads = 0) noexcept {
+			if (cnt <= 1 || 1 == m_maxThreads) return ::std::forward<Func>(FRed)(par_range_t(cnt));
+
+			region_t R(&_s_reduce_slot<::std::remove_reference_t<Func>>, _func_ptr(FRed));
+			_partition(R, cnt, useNThreads);
+			::std::unique_ptr<real_t[]> heapResults;
+			if (R.nChunks > region_t::inplaceResults) {
+				heapResults.reset(new real_t[static_cast<size_t>(R.nChunks)]);
+				R.pResults = heapResults.get();
+			} else R.pResults = R.inplace;
+
+			_execute(R);
+			return (::std::forward<FinalReduceFunc>(FRF))(R.pResults, R.nChunks);
+		}
+
+		//Dynamic chunking: [0,cnt) is split into chunks of grain elements that are handed out to whichever thread is free.
+		// par_range_t::tid() is the id of the executing thread then and a thread may get several chunks, so don't use it
+		// for kernels that store per-tid results (use run() for them).
+		template<typename Func>
+		void run_dynamic(Func&& F, const range_t cnt, const range_t grain) noexcept {
+			NNTL_ASSERT(grain > 0);
+			if (cnt <= grain) {
+				::std::forward<Func>(F)(par_range_t(0, cnt, _my_id()));
+			} else {
+				region_t R(&_s_run_chunk<::std::remove_reference_t<Func>>, _func_ptr(F));
+				R.totalCnt = cnt;
+				R.chunkCnt = grain;
+				R.nChunks = (cnt + grain - 1) / grain;
+				_execute(R);
+			}
+		}
+
+		//Fire-and-forget task with signature void(const thread_id_t tId), where tId is the id of the executing thread.
+		// The functor is copied (moved) to the heap. If the allocation fails or the deque is full, the task is executed
+		// by the calling thread immediately. Use wait_spawned() to make sure that all spawned tasks are complete.
+		template<typename FTask>
+		void spawn(FTask&& func) noexcept {
+			typedef SpawnedTask<::std::decay_t<FTask>> task_t;
+			const auto id = _my_id();
+			const auto pMem = ::operator new(sizeof(task_t), ::std::nothrow);
+			if (!pMem) {
+				::std::forward<FTask>(func)(id);
+				return;
+			}
+			const auto pT = ::new(pMem) task_t(*this, ::std::forward<FTask>(func));
+			m_spawnedCnt.fetch_add(1, ::std::memory_order_relaxed);
+			if (m_ctx[id].dq.push(pT)) {
+				_notify();
+			} else task_t::_s_exec(pT, id);
+		}
+
+		//waits (executing available tasks meanwhile) until every spawned task is complete.
+		// Never call it from a spawned task itself
+		void wait_spawned() noexcept {
+			_help_while(_my_id(), [&sc = m_spawnedCnt]()noexcept {
+				return sc.load(::std::memory_order_acquire) > 0;
+			});
+		}
+
+	protected:
+		static _tls_t& _tls()noexcept {
+			static thread_local _tls_t t = { nullptr, 0 };
+			return t;
+		}
+		//any thread that isn't a worker of this pool is considered the main thread
+		thread_id_t _my_id()const noexcept {
+			const auto& t = _tls();
+			return t.pPool == this ? t.id : 0;
+		}
+
+		template<typename Func>
+		static void* _func_ptr(Func& F)noexcept {
+			return const_cast<void*>(static_cast<const void*>(::std::addressof(F)));
+		}
+
+		template<typename Func>
+		static void _s_run_slot(region_t& R, const range_t s, const thread_id_t)noexcept {
+			(*static_cast<Func*>(R.pFunc))(R.slot_range(s));
+		}
+		template<typename Func>
+		static void _s_reduce_slot(region_t& R, const range_t s, const thread_id_t)noexcept {
+			R.pResults[s] = (*static_cast<Func*>(R.pFunc))(R.slot_range(s));
+		}
+		template<typename Func>
+		static void _s_run_chunk(region_t& R, const range_t c, const thread_id_t execId)noexcept {
+			(*static_cast<Func*>(R.pFunc))(R.chunk_range(c, execId));
+		}
+
+		void _partition(region_t& R, const range_t cnt, const thread_id_t _useNThreads)const noexcept {
+			NNTL_ASSERT(cnt > 1);
+			const thread_id_t totalThreads = m_maxThreads;
+			const thread_id_t useNThreads = _useNThreads > 1 && _useNThreads <= totalThreads ? _useNThreads : totalThreads;
+			R.totalCnt = cnt;
+			R.nChunks = cnt > useNThreads ? useNThreads : cnt;
+			R.chunkCnt = cnt / R.nChunks;
+			R.residual = cnt % R.nChunks;
+		}
+
+		void _execute(region_t& R)noexcept {
+			NNTL_ASSERT(R.nChunks > 1);
+			const auto id = _my_id();
+			auto& dq = m_ctx[id].dq;
+
+			const ::std::ptrdiff_t helpersCnt = static_cast<::std::ptrdiff_t>(R.nChunks - 1 < m_workersCnt ? R.nChunks - 1 : m_workersCnt);
+			R.pendingHelpers.store(helpersCnt, ::std::memory_order_relaxed);
+			::std::ptrdiff_t pushed = 0;
+			while (pushed < helpersCnt && dq.push(&R)) ++pushed;
+			//if the deque is full, we'll just do more work here
+			if (pushed < helpersCnt) R.pendingHelpers.fetch_sub(helpersCnt - pushed, ::std::memory_order_relaxed);
+			if (pushed) _notify();
+
+			R.work(id);
+			_help_while(id, [&ph = R.pendingHelpers]()noexcept {
+				return ph.load(::std::memory_order_acquire) > 0;
+			});
+		}
+
+		template<typename PredT>
+		void _help_while(const thread_id_t id, PredT&& bContinue)noexcept {
+			unsigned idle = 0;
+			while (bContinue()) {
+				if (const auto p = _find_work(id)) {
+					p->pfnExec(p, id);
+					idle = 0;
+				} else if (++idle > 64) ::std::this_thread::yield();
+			}
+		}
+
+		ws_item_t* _find_work(const thread_id_t id)noexcept {
+			auto& ctx = m_ctx[id];
+			if (const auto p = ctx.dq.pop()) return p;
+
+			auto& r = ctx.rndState;
+			r ^= r << 13; r ^= r >> 17; r ^= r << 5;
+			const thread_id_t totalThreads = m_workersCnt + 1;
+			const thread_id_t first = r % totalThreads;
+			for (thread_id_t i = 0; i < totalThreads; ++i) {
+				const thread_id_t v = (first + i) % totalThreads;
+				if (v != id) {
+					if (const auto p = m_ctx[v].dq.steal()) return p;
+				}
+			}
+			return nullptr;
+		}
+
+		void _notify()noexcept {
+			m_epoch.fetch_add(1);
+			if (m_sleepers.load() > 0) {
+				//taking the lock guarantees that a worker is either already waiting or will see the new epoch
+				m_mutex.lock();
+				m_mutex.unlock();
+				m_cvWork.notify_all();
+			}
+		}
+
+		static void _s_worker(self_t* p, const thread_id_t id)noexcept {
+			global_denormalized_floats_mode();
+			p->_worker(id);
+		}
+
+		void _worker(const thread_id_t id)noexcept {
+			auto& tls = _tls();
+			tls.pPool = this;
+			tls.id = id;
+			auto& ctx = m_ctx[id];
+
+			unsigned idle = 0;
+			while (!m_bStop.load(::std::memory_order_acquire)) {
+				if (1 == ctx.denormState.load(::std::memory_order_acquire))
+					ctx.denormState.store(isDenormalsOn() ? 3 : 2, ::std::memory_order_release);
+
+				const auto ep = m_epoch.load();
+				if (const auto p = _find_work(id)) {
+					p->pfnExec(p, id);
+					idle = 0;
+				} else if (++idle < spinsBeforePark) {
+					::std::this_thread::yield();
+				} else {
+					idle = 0;
+					m_sleepers.fetch_add(1);
+					Sync_t::lock_wait_unlock(m_mutex, m_cvWork, [this, ep]()noexcept {
+						return m_bStop.load() || m_epoch.load() != ep;
+					});
+					m_sleepers.fetch_sub(1);
+				}
+			}
+		}
+	};
+
+}
+}
@@ -50,10 +50,18 @@ namespace nntl {
 		//WinQDU+forwarder is about 1.5/22 ~ 7% faster than Std+std::function in one sample setup (everything else remains fixed)
 		
 		typedef threads::Workers<real_t, math::smatrix_td::numel_cnt_t> iThreads_t;
-
-		//_mt is deprecated. Going to make run-time profiler sometime
+		//spin-then-park dispatch (much cheaper for back-to-back small kernels, doesn't burn CPU when idle):
+		//typedef threads::Workers<real_t, math::smatrix_td::numel_cnt_t, threads::spin_park_sync_primitives> iThreads_t;
+		//work-stealing drop-in replacement (include interface/threads/ws_workers.h) that also supports nested regions,
+		// dynamic chunking and fire-and-forget tasks
+		//typedef threads::WsWorkers<real_t, math::smatrix_td::numel_cnt_t> iThreads_t;
+
+		//_mt is deprecated. For run-time profiled st/mt thresholds use math::MathN<real_t, iThreads_t, math::_impl::MATHN_THR_RT<real_t>>
+		// together with mt::mt_dispatcher (see interface/mt_dispatcher/mt_dispatcher.h)
 		//typedef math::MathN_mt<real_t, iThreads_t> iMath_t;
 		typedef math::MathN<real_t, iThreads_t> iMath_t;
+		//to run matrix multiplications on iThreads_t workers instead of OpenBLAS own threads use
+		//typedef math::MathN<real_t, iThreads_t, math::_impl::MATHN_THR<real_t>, math::b_Native<iThreads_t>> iMath_t;
 
 		typedef rng::AFRand_mt<real_t, AFog::CRandomSFMT0, iThreads_t> iRng_t;
 	};
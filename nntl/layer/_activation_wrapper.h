@@ -65,6 +65,9 @@ namespace nntl {
 
 			static constexpr bool bActivationForOutput = ::std::is_base_of <activation::_i_activation_loss<real_t>, Activation_t>::value;
 			static constexpr bool bActivationForHidden = ::std::is_base_of<activation::_i_activation<real_t, Weights_Init_t>, Activation_t>::value;
+			//activation may be computed over any part of preactivations by any thread, see _activation_fprop_part()
+			static constexpr bool bActivationElementwise = Activation_t::bElementwise
+				&& activation::has_f_st<Activation_t, typename InterfacesT::iMath_t>::value;
 			
 // 			static_assert(!bActivationForOutput || is_dummy_dropout<DropoutT>::value, "There must be no dropout for output activation function");
 // 
@@ -203,6 +206,19 @@ namespace nntl {
 				}
 			}
 
+			//applies the activation to a bias-less matrix that shares the storage with a part of m_activations (a block of
+			// preactivations that has just been computed, see _LFC::_fprop()). The layer must not be linear.
+			// May be called from worker threads of iM concurrently for different parts
+			template<typename iMathT, bool _b = bActivationElementwise>
+			::std::enable_if_t<_b> _activation_fprop_part(realmtx_t& Zpart, iMathT& iM)noexcept {
+				NNTL_ASSERT(!bLayerIsLinear() && !Zpart.emulatesBiases());
+				NNTL_ASSERT(Zpart.data() >= m_activations.data() && Zpart.data() + Zpart.numel() <= m_activations.data() + m_activations.numel_no_bias());
+				Activation_t::f_st(Zpart, iM);
+#ifdef NNTL_AGGRESSIVE_NANS_DBG_CHECK
+				NNTL_ASSERT(Zpart.test_noNaNs());
+#endif // NNTL_AGGRESSIVE_NANS_DBG_CHECK
+			}
+
 			template<typename iMathT, bool _b = bActivationForHidden>
 			::std::enable_if_t<_b> _activation_bprop(realmtx_t& act2dAdZ_nb,iMathT& iM)noexcept {
 				NNTL_ASSERT(m_activations.emulatesBiases() && !act2dAdZ_nb.emulatesBiases());
@@ -216,6 +232,30 @@ namespace nntl {
 				NNTL_ASSERT(act2dAdZ_nb.test_noNaNs());
 			}
 
+			//same as _activation_bprop() followed by iM.evMul_ip(act2dLdZ_nb, dLdA), but makes a single pass over the data
+			// if the Activation_t::df_mul() is available
+			template<typename iMathT, bool _b = bActivationForHidden>
+			::std::enable_if_t<_b && activation::has_df_mul<Activation_t, iMathT>::value>
+				_activation_bprop_mul(realmtx_t& act2dLdZ_nb, const realmtx_t& dLdA, iMathT& iM)noexcept
+			{
+				NNTL_ASSERT(m_activations.emulatesBiases() && !act2dLdZ_nb.emulatesBiases());
+				NNTL_ASSERT(m_activations.data() == act2dLdZ_nb.data() && m_activations.size_no_bias() == act2dLdZ_nb.size());
+				NNTL_ASSERT(act2dLdZ_nb.test_noNaNs() && dLdA.test_noNaNs());
+				if (bLayerIsLinear()) {
+					Activation_t::dIdentity_mul(act2dLdZ_nb, dLdA, iM);
+				} else {
+					Activation_t::df_mul(act2dLdZ_nb, dLdA, iM);
+				}
+				NNTL_ASSERT(act2dLdZ_nb.test_noNaNs());
+			}
+			template<typename iMathT, bool _b = bActivationForHidden>
+			::std::enable_if_t<_b && !activation::has_df_mul<Activation_t, iMathT>::value>
+				_activation_bprop_mul(realmtx_t& act2dLdZ_nb, const realmtx_t& dLdA, iMathT& iM)noexcept
+			{
+				_activation_bprop(act2dLdZ_nb, iM);
+				iM.evMul_ip(act2dLdZ_nb, dLdA);
+			}
+
 			template<typename iMathT, bool _b = bActivationForOutput>
 			::std::enable_if_t<_b> _activation_bprop_output(const realmtx_t& data_y, iMathT& iM)noexcept {
 				NNTL_ASSERT(!m_activations.emulatesBiases() && !data_y.emulatesBiases());
@@ -226,6 +266,28 @@ namespace nntl {
 				}
 				NNTL_ASSERT(m_activations.test_noNaNs());
 			}
+
+			//same as _activation_bprop_output(), but also returns the loss value of the activations (as calc_loss() does).
+			// Uses the fused Activation_t::dLdZ_loss() if it's available
+			template<typename iMathT, bool _b = bActivationForOutput>
+			::std::enable_if_t<_b && activation::has_dLdZ_loss<Activation_t, iMathT>::value, real_t>
+				_activation_bprop_output_loss(const realmtx_t& data_y, iMathT& iM)noexcept
+			{
+				NNTL_ASSERT(!m_activations.emulatesBiases() && !data_y.emulatesBiases());
+				const real_t lossVal = bLayerIsLinear()
+					? Activation_t::dLdZIdentity_loss(data_y, m_activations, iM)
+					: Activation_t::dLdZ_loss(data_y, m_activations, iM);
+				NNTL_ASSERT(m_activations.test_noNaNs());
+				return lossVal;
+			}
+			template<typename iMathT, bool _b = bActivationForOutput>
+			::std::enable_if_t<_b && !activation::has_dLdZ_loss<Activation_t, iMathT>::value, real_t>
+				_activation_bprop_output_loss(const realmtx_t& data_y, iMathT& iM)noexcept
+			{
+				const real_t lossVal = Activation_t::loss(m_activations, data_y, iM);
+				_activation_bprop_output(data_y, iM);
+				return lossVal;
+			}
 		};
 
 	}
@@ -106,6 +106,7 @@ namespace nntl {
 		typedef RealT real_t;
 		typedef math::smatrix<real_t> realmtx_t;
 		typedef math::smatrix_deform<real_t> realmtxdef_t;
+		typedef math::smatrix_csr<real_t> realmtx_csr_t;
 		static_assert(::std::is_base_of<realmtx_t, realmtxdef_t>::value, "smatrix_deform must be derived from smatrix!");
 	};
 
@@ -132,6 +133,9 @@ namespace nntl {
 		nntl_interface const mtx_size_t get_activations_size()const noexcept;
 		//shared activations implies that the bias column may hold not biases, but activations of some another layer
 		nntl_interface const bool is_activations_shared()const noexcept;
+		//true if the layer activations is a sparse matrix (only layer_input may have them). get_activations() mustn't be
+		// called then. Only a layer, that knows how to deal with the sparse data, may be placed on top of such layer
+		nntl_interface const bool has_sparse_activations()const noexcept;
 
 		//essentially the same as get_activations(), however, it is allowed to call this function anytime to obtain the pointer
 		//However, if you are going to dereference the pointer, the same restrictions as for get_activations() applies.
@@ -509,6 +513,7 @@ namespace nntl {
 		}
 
 		const bool is_activations_shared()const noexcept { return m_bIsSharedActivations; }
+		constexpr const bool has_sparse_activations()const noexcept { return false; }
 	//protected:
 		const bool is_drop_samples_mbc()const noexcept { return m_bIsDropSamplesMightBeCalled; }
 
@@ -621,6 +626,7 @@ namespace nntl {
 		realmtxdef_t& _get_activations_mutable()const noexcept { return get_self()._forwarder_layer()._get_activations_mutable(); }
 		const mtx_size_t get_activations_size()const noexcept { return get_self()._forwarder_layer().get_activations_size(); }
 		const bool is_activations_shared()const noexcept { return get_self()._forwarder_layer().is_activations_shared(); }
+		const bool has_sparse_activations()const noexcept { return get_self()._forwarder_layer().has_sparse_activations(); }
 
 		const bool is_drop_samples_mbc()const noexcept { return get_self()._forwarder_layer().is_drop_samples_mbc(); }
 
@@ -55,6 +55,15 @@ namespace nntl {
 
 		static constexpr const char _defName[] = "fcl";
 
+		//fused fprop computes activation values of a block of preactivations right after the block was produced by the
+		// matrix multiplication, while it's still in the cache. It's possible only for elementwise activations that have
+		// a single threaded f_st() and only if the inspector doesn't need to see the preactivations (i.e. it must be a dummy)
+		static constexpr bool bFusedFpropAvailable = bActivationElementwise
+			&& inspector::is_dummy_inspector<typename _base_class_t::iInspect_t>::value;
+		//fused bprop computes dL/dZ directly from activation values and dL/dA in a single pass over the data. It's possible
+		// only if the inspector doesn't need to see dA/dZ
+		static constexpr bool bFusedBpropAvailable = inspector::is_dummy_inspector<typename _base_class_t::iInspect_t>::value;
+
 		//////////////////////////////////////////////////////////////////////////
 		//members
 	protected:
@@ -77,6 +86,25 @@ namespace nntl {
 		//this flag controls the weights matrix initialization and prevents reinitialization on next nnet.train() calls
 		bool m_bWeightsInitialized;
 
+		//enables fused fprop (if bFusedFpropAvailable). On by default
+		bool m_bFusedFprop;
+
+		//enables the low latency fprop for tiny batches during inference (see _fprop_small_preact()). On by default
+		bool m_bSmallBatchFprop;
+		//m_weights packed for iMath_t::mMulABt_Cnb_small(). Made lazily and dropped on every change of m_weights
+		bool m_bWeightsPackedValid;
+		typename _base_class_t::iMath_t::small_gemm_weights_t m_weightsPacked;
+
+		//enables int8 quantized fprop during inference (see _fprop_q8()). Off by default, because it trades some accuracy for speed
+		bool m_bInt8Inference;
+		//m_weights quantized for iMath_t::mMulABt_Cnb_q8() and the scratch for quantized activations. Quantized weights are made
+		// lazily from the current m_weights (including weights loaded by serialization) and dropped on every change of m_weights.
+		// m_weights stay the master copy, so the int8 path costs about a quarter (float) or an eighth (double) of m_weights
+		// on top of them (see q8_weights::bytes()), plus rows*inputs bytes for quantized activations
+		bool m_bWeightsQ8Valid;
+		typename _base_class_t::iMath_t::q8_weights_t m_weightsQ8;
+		typename _base_class_t::iMath_t::q8_activations_t m_activationsQ8;
+
 		//////////////////////////////////////////////////////////////////////////
 		//Serialization support
 	private:
@@ -124,7 +152,8 @@ namespace nntl {
 		)noexcept
 			: _base_class_t(_neurons_cnt, pCustomName), m_weights()
 			, m_bWeightsInitialized(false), m_gradientWorks(learningRate)
-			, m_nTiledTimes(0.)
+			, m_nTiledTimes(0.), m_bFusedFprop(true), m_bSmallBatchFprop(true), m_bWeightsPackedValid(false)
+			, m_bInt8Inference(false), m_bWeightsQ8Valid(false)
 		{
 			m_activations.will_emulate_biases();
 		};
@@ -132,7 +161,8 @@ namespace nntl {
 		_LFC(const neurons_count_t _neurons_cnt, const real_t learningRate = real_t(.01), const char* pCustomName=nullptr)noexcept
 			: _base_class_t(_neurons_cnt, pCustomName), m_weights()
 			, m_bWeightsInitialized(false), m_gradientWorks(learningRate)
-			, m_nTiledTimes(0.)
+			, m_nTiledTimes(0.), m_bFusedFprop(true), m_bSmallBatchFprop(true), m_bWeightsPackedValid(false)
+			, m_bInt8Inference(false), m_bWeightsQ8Valid(false)
 		{
 			m_activations.will_emulate_biases();
 		};
@@ -140,7 +170,12 @@ namespace nntl {
 		//#TODO: move all generic fullyconnected stuff into a special base class!
 
 		const realmtx_t& get_weights()const noexcept { NNTL_ASSERT(m_bWeightsInitialized); return m_weights; }
-		realmtx_t& get_weights() noexcept { NNTL_ASSERT(m_bWeightsInitialized); return m_weights; }
+		//the caller may change the weights, so the packed and quantized copies are dropped
+		realmtx_t& get_weights() noexcept {
+			NNTL_ASSERT(m_bWeightsInitialized);
+			m_bWeightsPackedValid = m_bWeightsQ8Valid = false;
+			return m_weights;
+		}
 
 		bool set_weights(realmtx_t&& W)noexcept {
 			if (W.empty() || W.emulatesBiases()
@@ -155,10 +190,21 @@ namespace nntl {
 
 			m_weights = ::std::move(W);
 			m_bWeightsInitialized = true;
+			m_bWeightsPackedValid = m_bWeightsQ8Valid = false;
 			return true;
 		}
 
+		void fused_fprop(const bool b)noexcept { m_bFusedFprop = b; }
+		bool fused_fprop()const noexcept { return bFusedFpropAvailable && m_bFusedFprop && !get_self().bLayerIsLinear(); }
+
+		void small_batch_fprop(const bool b)noexcept { m_bSmallBatchFprop = b; }
+		bool small_batch_fprop()const noexcept { return m_bSmallBatchFprop; }
+
+		void int8_inference(const bool b)noexcept { m_bInt8Inference = b; }
+		bool int8_inference()const noexcept { return m_bInt8Inference; }
+
 		bool reinit_weights()noexcept {
+			m_bWeightsPackedValid = m_bWeightsQ8Valid = false;
 			return _activation_init_weights(m_weights);
 		}
 
@@ -225,6 +271,10 @@ namespace nntl {
 
 		void deinit() noexcept {
 			m_gradientWorks.deinit();
+			m_weightsPacked.clear();
+			m_weightsQ8.clear();
+			m_activationsQ8.clear();
+			m_bWeightsPackedValid = m_bWeightsQ8Valid = false;
 			m_dLdW.clear();
 			m_dLdWScale = real_t(0.);
 			m_nTiledTimes = real_t(0.);
@@ -247,14 +297,16 @@ namespace nntl {
 
 	protected:
 		//help compiler to isolate fprop functionality from the specific of previous layer
-		void _fprop(const realmtx_t& prevActivations)noexcept {
+		//PrevActT is realmtx_t or realmtx_csr_t (the sparse data of layer_input). Inspectors never see the sparse data
+		template<typename PrevActT>
+		void _fprop(const PrevActT& prevActivations)noexcept {
 #ifdef NNTL_AGGRESSIVE_NANS_DBG_CHECK
 			NNTL_ASSERT(prevActivations.test_noNaNs());
 #endif // NNTL_AGGRESSIVE_NANS_DBG_CHECK
 
 			const auto bTrainingMode = get_self().get_common_data().is_training_mode();
 			auto& _iI = get_self().get_iInspect();
-			_iI.fprop_begin(get_self().get_layer_idx(), prevActivations, bTrainingMode);
+			_iI.fprop_begin(get_self().get_layer_idx(), math::dense_or_empty(prevActivations), bTrainingMode);
 
 			//restoring biases, should they were altered in drop_samples()
 			if (m_activations.isHoleyBiases() && !get_self().is_activations_shared()) {
@@ -271,13 +323,18 @@ namespace nntl {
 
 			auto& iM = get_self().get_iMath();
 
-			_iI.fprop_makePreActivations(m_weights, prevActivations);
-			iM.mMulABt_Cnb(prevActivations, m_weights, m_activations);
-			_iI.fprop_preactivations(m_activations);
+			_iI.fprop_makePreActivations(m_weights, math::dense_or_empty(prevActivations));
+			bool bActivated = false;
+			if (!_fprop_special(prevActivations, iM, bTrainingMode, bActivated)) {
+				iM.mMulABt_Cnb(prevActivations, m_weights, m_activations);
+			}
+			if (!bActivated) {
+				_iI.fprop_preactivations(m_activations);
 
-			NNTL_ASSERT(get_self().is_activations_shared() || m_activations.test_biases_ok());
+				NNTL_ASSERT(get_self().is_activations_shared() || m_activations.test_biases_ok());
 
-			_activation_fprop(iM);
+				_activation_fprop(iM);
+			}
 			_iI.fprop_activations(m_activations);
 
 			NNTL_ASSERT(get_self().is_activations_shared() || m_activations.test_biases_ok());
@@ -287,9 +344,78 @@ namespace nntl {
 			m_bActivationsValid = true;
 		}
 
+		//tries the int8, the small batch and the fused paths. Returns true if preactivations were computed, bActivated is set
+		// if the activation has been applied too.
+		//the int8 path (if enabled) takes precedence during inference and may apply the activation itself.
+		//the small batch path doesn't fuse the activation: the whole m_activations is tiny and stays in L1 anyway
+		template<typename iMathT>
+		bool _fprop_special(const realmtx_t& prevActivations, iMathT& iM, const bool bTrainingMode, bool& bActivated)noexcept {
+			if (_fprop_q8(prevActivations, iM, bTrainingMode, bActivated)
+				|| _fprop_small_preact(prevActivations, iM, bTrainingMode)) return true;
+			return bActivated = _fprop_fused(prevActivations, iM);
+		}
+		//the sparse data has the only dedicated kernel
+		template<typename iMathT>
+		static constexpr bool _fprop_special(const realmtx_csr_t&, iMathT&, const bool, bool&)noexcept { return false; }
+
+		//computes preactivations of a tiny batch during inference with a single threaded kernel that uses pre-packed weights.
+		// Returns false if the path isn't applicable and the caller must compute preactivations itself
+		template<typename iMathT>
+		bool _fprop_small_preact(const realmtx_t& prevActivations, iMathT& iM, const bool bTrainingMode)noexcept {
+			if (bTrainingMode || !m_bSmallBatchFprop
+				|| !iM.useSmallMulABt(prevActivations.rows(), m_weights.rows(), m_weights.cols())) return false;
+
+			if (!m_bWeightsPackedValid) {
+				//weights are packed once and then reused by every following fprop() until they change
+				if (!iM.mPack4SmallMulABt(m_weights, m_weightsPacked)) return false;
+				m_bWeightsPackedValid = true;
+			}
+			iM.mMulABt_Cnb_small(prevActivations, m_weightsPacked, m_activations);
+			return true;
+		}
+
+		//computes preactivations during inference with int8 quantized weights and activations (see iMath_t::mMulABt_Cnb_q8()).
+		// When the fused fprop is possible, the activation is applied to every computed panel and bActivated is set.
+		// Returns false if the path isn't applicable and the caller must compute preactivations itself
+		template<typename iMathT>
+		bool _fprop_q8(const realmtx_t& prevActivations, iMathT& iM, const bool bTrainingMode, bool& bActivated)noexcept {
+			if (bTrainingMode || !m_bInt8Inference) return false;
+
+			if (!m_bWeightsQ8Valid) {
+				//weights are quantized once and then reused by every following fprop() until they change
+				if (!iM.mQuantize4MulABt_q8(m_weights, m_weightsQ8)) return false;
+				m_bWeightsQ8Valid = true;
+			}
+			bActivated = _fprop_q8_fused(prevActivations, iM);
+			return bActivated || iM.mMulABt_Cnb_q8(prevActivations, m_activationsQ8, m_weightsQ8, m_activations);
+		}
+		template<typename iMathT, bool _b = bFusedFpropAvailable>
+		::std::enable_if_t<_b, bool> _fprop_q8_fused(const realmtx_t& prevActivations, iMathT& iM)noexcept {
+			return get_self().fused_fprop() && iM.mMulABt_Cnb_q8(prevActivations, m_activationsQ8, m_weightsQ8, m_activations
+				, [this, &iM](realmtx_t& Zpart) {
+				get_self()._activation_fprop_part(Zpart, iM);
+			});
+		}
+		template<typename iMathT, bool _b = bFusedFpropAvailable>
+		static constexpr ::std::enable_if_t<!_b, bool> _fprop_q8_fused(const realmtx_t&, iMathT&)noexcept { return false; }
+
+		//returns false if the fused fprop can't be used and the caller must make the usual mMulABt_Cnb() + _activation_fprop()
+		template<typename iMathT, bool _b = bFusedFpropAvailable>
+		::std::enable_if_t<_b, bool> _fprop_fused(const realmtx_t& prevActivations, iMathT& iM)noexcept {
+			if (!get_self().fused_fprop()) return false;
+			iM.mMulABt_Cnb_ep(prevActivations, m_weights, m_activations, [this, &iM](realmtx_t& Zpart) {
+				get_self()._activation_fprop_part(Zpart, iM);
+			});
+			NNTL_ASSERT(get_self().is_activations_shared() || m_activations.test_biases_ok());
+			return true;
+		}
+		template<typename iMathT, bool _b = bFusedFpropAvailable>
+		static constexpr ::std::enable_if_t<!_b, bool> _fprop_fused(const realmtx_t&, iMathT&)noexcept { return false; }
+
 		void _cust_inspect(const realmtx_t& )const noexcept{}
 
-		void _bprop(realmtx_t& dLdA, const realmtx_t& prevActivations, const bool bPrevLayerIsInput, realmtx_t& dLdAPrev)noexcept {
+		template<typename PrevActT>
+		void _bprop(realmtx_t& dLdA, const PrevActT& prevActivations, const bool bPrevLayerIsInput, realmtx_t& dLdAPrev)noexcept {
 			NNTL_ASSERT(m_bActivationsValid);
 			m_bActivationsValid = false;
 
@@ -327,12 +453,17 @@ namespace nntl {
 			dLdZ.useExternalStorage_no_bias(m_activations);
 
 			auto& iM = get_self().get_iMath();
-			//computing dA/dZ using m_activations (aliased to dLdZ variable, which eventually will be a dL/dZ
-			_activation_bprop(dLdZ, iM);
+			if (bFusedBpropAvailable) {
+				//computing dL/dZ=dL/dA.*dA/dZ using m_activations (aliased to dLdZ variable) in a single pass
+				_activation_bprop_mul(dLdZ, dLdA, iM);
+			} else {
+				//computing dA/dZ using m_activations (aliased to dLdZ variable, which eventually will be a dL/dZ
+				_activation_bprop(dLdZ, iM);
 
-			_iI.bprop_dAdZ(dLdZ);
-			//compute dL/dZ=dL/dA.*dA/dZ into dA/dZ
-			iM.evMul_ip(dLdZ, dLdA);
+				_iI.bprop_dAdZ(dLdZ);
+				//compute dL/dZ=dL/dA.*dA/dZ into dA/dZ
+				iM.evMul_ip(dLdZ, dLdA);
+			}
 			_iI.bprop_dLdZ(dLdZ);
 
 			//NB: if we're going to use some kind of regularization of the activation values, we should make sure, that excluded
@@ -356,7 +487,7 @@ namespace nntl {
 			const auto bCalcdLdW = m_dLdWScale > 0;
 			if (bCalcdLdW) {
 				iM.mScaledMulAtB_C(m_dLdWScale, dLdZ, prevActivations, m_dLdW);
-				_iI.bprop_dLdW(dLdZ, prevActivations, m_dLdW);
+				_iI.bprop_dLdW(dLdZ, math::dense_or_empty(prevActivations), m_dLdW);
 			} else {
 				//dLdZ must contain zeros only
 #ifdef NNTL_DEBUG
@@ -376,6 +507,7 @@ namespace nntl {
 			if (bCalcdLdW) {
 				//now we can apply gradient to the weights
 				m_gradientWorks.apply_grad(m_weights, m_dLdW);
+				m_bWeightsPackedValid = m_bWeightsQ8Valid = false;
 			}
 
 			NNTL_ASSERT(prevActivations.test_biases_ok());
@@ -387,20 +519,42 @@ namespace nntl {
 		template <typename LowerLayer>
 		void fprop(const LowerLayer& lowerLayer)noexcept {
 			static_assert(::std::is_base_of<_i_layer_fprop, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_fprop");
-			NNTL_ASSERT(lowerLayer.get_activations().test_biases_ok());
-			get_self()._fprop(lowerLayer.get_activations());
-			NNTL_ASSERT(lowerLayer.get_activations().test_biases_ok());
+			const auto pSpActivations = _sparse_activations(lowerLayer, ::std::is_base_of<m_layer_input, LowerLayer>());
+			if (pSpActivations) {
+				get_self()._fprop(*pSpActivations);
+			} else {
+				NNTL_ASSERT(lowerLayer.get_activations().test_biases_ok());
+				get_self()._fprop(lowerLayer.get_activations());
+				NNTL_ASSERT(lowerLayer.get_activations().test_biases_ok());
+			}
 		}
 
 		template <typename LowerLayer>
 		const unsigned bprop(realmtx_t& dLdA, const LowerLayer& lowerLayer, realmtx_t& dLdAPrev)noexcept {
 			static_assert(::std::is_base_of<_i_layer_trainable, LowerLayer>::value, "Template parameter LowerLayer must implement _i_layer_trainable");
-			NNTL_ASSERT(lowerLayer.get_activations().test_biases_ok());
-			get_self()._bprop(dLdA, lowerLayer.get_activations(), ::std::is_base_of<m_layer_input, LowerLayer>::value, dLdAPrev);
-			NNTL_ASSERT(lowerLayer.get_activations().test_biases_ok());
+			constexpr bool bPrevLayerIsInput = ::std::is_base_of<m_layer_input, LowerLayer>::value;
+			const auto pSpActivations = _sparse_activations(lowerLayer, ::std::integral_constant<bool, bPrevLayerIsInput>());
+			if (pSpActivations) {
+				get_self()._bprop(dLdA, *pSpActivations, bPrevLayerIsInput, dLdAPrev);
+			} else {
+				NNTL_ASSERT(lowerLayer.get_activations().test_biases_ok());
+				get_self()._bprop(dLdA, lowerLayer.get_activations(), bPrevLayerIsInput, dLdAPrev);
+				NNTL_ASSERT(lowerLayer.get_activations().test_biases_ok());
+			}
 			return 1;
 		}
 
+	protected:
+		//only layer_input may have sparse activations
+		template <typename LowerLayer>
+		static const realmtx_csr_t* _sparse_activations(const LowerLayer& lowerLayer, ::std::true_type)noexcept {
+			return lowerLayer.get_sparse_activations_storage();
+		}
+		template <typename LowerLayer>
+		static constexpr const realmtx_csr_t* _sparse_activations(const LowerLayer&, ::std::false_type)noexcept { return nullptr; }
+
+	public:
+
 		static constexpr bool is_trivial_drop_samples()noexcept { return true; }
 
 		void left_after_drop_samples(const numel_cnt_t nNZElems)noexcept {
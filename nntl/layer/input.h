@@ -50,6 +50,8 @@ namespace nntl {
 		//members
 	protected:
 		const realmtx_t* m_pActivations;
+		//set instead of m_pActivations when the layer is fed with a sparse data (see fprop(const realmtx_csr_t&))
+		const realmtx_csr_t* m_pSpActivations;
 
 		//////////////////////////////////////////////////////////////////////////
 		//Serialization support
@@ -58,6 +60,7 @@ namespace nntl {
 		template<class Archive>
 		::std::enable_if_t<Archive::is_saving::value> serialize(Archive & ar, const unsigned int version) {
 			NNTL_UNREF(version);
+			NNTL_ASSERT(!m_pSpActivations || !"Sparse data_x can't be serialized");
 			if (m_pActivations && utils::binary_option<true>(ar, serialization::serialize_data_x)) 
 				ar & serialization::make_nvp("data_x", * const_cast<realmtx_t*>(m_pActivations));
 		}
@@ -68,7 +71,7 @@ namespace nntl {
 	public:
 
 		_layer_input(const char* pCustomName, const neurons_count_t _neurons_cnt)noexcept 
-			: _base_class(_neurons_cnt, pCustomName), m_pActivations(nullptr)
+			: _base_class(_neurons_cnt, pCustomName), m_pActivations(nullptr), m_pSpActivations(nullptr)
 		{};
 		~_layer_input() noexcept {};
 		static constexpr const char _defName[] = "inp";
@@ -80,9 +83,17 @@ namespace nntl {
 		}
 		const realmtx_t* get_activations_storage()const noexcept { return m_pActivations; }
 		const mtx_size_t get_activations_size()const noexcept { 
-			NNTL_ASSERT(m_pActivations);
-			return m_pActivations->size();
+			NNTL_ASSERT(m_pActivations || m_pSpActivations);
+			return m_pSpActivations ? m_pSpActivations->size() : m_pActivations->size();
+		}
+
+		const bool has_sparse_activations()const noexcept { return nullptr != m_pSpActivations; }
+		const realmtx_csr_t& get_sparse_activations()const noexcept {
+			NNTL_ASSERT(m_pSpActivations);
+			NNTL_ASSERT(m_bActivationsValid);
+			return *m_pSpActivations;
 		}
+		const realmtx_csr_t* get_sparse_activations_storage()const noexcept { return m_pSpActivations; }
 		const bool is_activations_shared()const noexcept {
 			const auto r = _base_class::is_activations_shared();
 			NNTL_ASSERT(!r || m_activations.bDontManageStorage());//shared activations can't manage their own storage
@@ -94,10 +105,12 @@ namespace nntl {
 			if (ErrorCode::Success != ec) return ec;
 
 			m_pActivations = nullptr;
+			m_pSpActivations = nullptr;
 			return ec;
 		}
 		void deinit()noexcept {
 			m_pActivations = nullptr;
+			m_pSpActivations = nullptr;
 			_base_class::deinit();
 		}
 
@@ -113,12 +126,29 @@ namespace nntl {
 
 			NNTL_ASSERT(data_x.test_biases_ok());
 			m_pActivations = &data_x;
+			m_pSpActivations = nullptr;
 
 			iI.fprop_activations(*m_pActivations);
 			iI.fprop_end(*m_pActivations);
 			m_bActivationsValid = true;
 		}
 
+		//sparse data could be consumed only by the layer that expects it (_LFC), so get_activations() isn't available.
+		//Inspectors get an empty matrix instead of the data
+		void fprop(const realmtx_csr_t& data_x)noexcept {
+			auto& iI = get_self().get_iInspect();
+			const auto& dummy = math::dense_or_empty(data_x);
+			iI.fprop_begin(get_self().get_layer_idx(), dummy, get_self().get_common_data().is_training_mode());
+
+			NNTL_ASSERT(data_x.test_biases_ok() && data_x.test_valid());
+			m_pActivations = nullptr;
+			m_pSpActivations = &data_x;
+
+			iI.fprop_activations(dummy);
+			iI.fprop_end(dummy);
+			m_bActivationsValid = true;
+		}
+
 		template <typename LowerLayer>
 		const unsigned bprop(realmtx_t& dLdA, const LowerLayer& lowerLayer, realmtx_t& dLdAPrev)noexcept {
 			NNTL_ASSERT(m_bActivationsValid);
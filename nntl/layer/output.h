@@ -70,9 +70,29 @@ namespace nntl {
 		real_t m_dLdZRestrictLowerBnd, m_dLdZRestrictUpperBnd;
 		bool m_bRestrictdLdZ;//restriction flag should be permanent for init/deinit calls and changed only by explicit calls to respective functions
 
+		//when set, bprop() computes the loss value of the batch as a by-product of dL/dZ computation and stores it into m_bpropLoss
+		bool m_bCalcLossInBprop;
+		real_t m_bpropLoss;
+
 	    //this flag controls the weights matrix initialization and prevents reinitialization on next nnet.train() calls
 		bool m_bWeightsInitialized;
 
+		//enables the low latency computation of preactivations for tiny batches during inference (see _fprop_small_preact()). On by default
+		bool m_bSmallBatchFprop;
+		//m_weights packed for iMath_t::mMulABt_Cnb_small(). Made lazily and dropped on every change of m_weights
+		bool m_bWeightsPackedValid;
+		typename _base_class_t::iMath_t::small_gemm_weights_t m_weightsPacked;
+
+		//enables int8 quantized computation of preactivations during inference. Off by default
+		bool m_bInt8Inference;
+		//m_weights quantized for iMath_t::mMulABt_Cnb_q8() and the scratch for quantized activations. Quantized weights are made
+		// lazily from the current m_weights (including weights loaded by serialization) and dropped on every change of m_weights.
+		// m_weights stay the master copy, so the int8 path costs about a quarter (float) or an eighth (double) of m_weights
+		// on top of them (see q8_weights::bytes()), plus rows*inputs bytes for quantized activations
+		bool m_bWeightsQ8Valid;
+		typename _base_class_t::iMath_t::q8_weights_t m_weightsQ8;
+		typename _base_class_t::iMath_t::q8_activations_t m_activationsQ8;
+
 	public:
 		grad_works_t m_gradientWorks;
 		grad_works_t& get_gradWorks()noexcept { return m_gradientWorks; }
@@ -133,6 +153,8 @@ namespace nntl {
 			: _base_class_t(_neurons_cnt, pCustomName), m_weights(), m_dLdW(), m_bWeightsInitialized(false)
 			, m_gradientWorks(learningRate)
 			, m_bRestrictdLdZ(false), m_dLdZRestrictLowerBnd(.0), m_dLdZRestrictUpperBnd(.0)
+			, m_bCalcLossInBprop(false), m_bpropLoss(0), m_bSmallBatchFprop(true), m_bWeightsPackedValid(false)
+			, m_bInt8Inference(false), m_bWeightsQ8Valid(false)
 		{
 			m_activations.dont_emulate_biases();
 		};
@@ -142,7 +164,12 @@ namespace nntl {
 		//#TODO: move all generic fullyconnected stuff into a special base class!
 
 		const realmtx_t& get_weights()const noexcept { NNTL_ASSERT(m_bWeightsInitialized); return m_weights; }
-		realmtx_t& get_weights() noexcept { NNTL_ASSERT(m_bWeightsInitialized); return m_weights; }
+		//the caller may change the weights, so the packed and quantized copies are dropped
+		realmtx_t& get_weights() noexcept {
+			NNTL_ASSERT(m_bWeightsInitialized);
+			m_bWeightsPackedValid = m_bWeightsQ8Valid = false;
+			return m_weights;
+		}
 
 		//should be called after assembling layers into layer_pack, - it initializes _incoming_neurons_cnt
 		bool set_weights(realmtx_t&& W)noexcept {
@@ -156,13 +183,21 @@ namespace nntl {
 
 			m_weights = ::std::move(W);
 			m_bWeightsInitialized = true;
+			m_bWeightsPackedValid = m_bWeightsQ8Valid = false;
 			return true;
 		}
 
 		bool reinit_weights()noexcept {
+			m_bWeightsPackedValid = m_bWeightsQ8Valid = false;
 			return _activation_init_weights(m_weights);
 		}
 
+		void small_batch_fprop(const bool b)noexcept { m_bSmallBatchFprop = b; }
+		bool small_batch_fprop()const noexcept { return m_bSmallBatchFprop; }
+
+		void int8_inference(const bool b)noexcept { m_bInt8Inference = b; }
+		bool int8_inference()const noexcept { return m_bInt8Inference; }
+
 		ErrorCode init(_layer_init_data_t& lid)noexcept {
 			bool bSuccessfullyInitialized = false;
 			utils::scope_exit onExit([&bSuccessfullyInitialized, this]() {
@@ -220,6 +255,10 @@ namespace nntl {
 		void deinit()noexcept {
 			m_gradientWorks.deinit();
 			m_dLdW.clear();
+			m_weightsPacked.clear();
+			m_weightsQ8.clear();
+			m_activationsQ8.clear();
+			m_bWeightsPackedValid = m_bWeightsQ8Valid = false;
 			_base_class_t::deinit();
 		}
 
@@ -254,7 +293,10 @@ namespace nntl {
 
 			auto& iM = get_self().get_iMath();
 			_iI.fprop_makePreActivations(m_weights, prevActivations);
-			iM.mMulABt_Cnb(prevActivations, m_weights, m_activations);
+			//the int8 path (if enabled) takes precedence during inference
+			if (!_fprop_q8_preact(prevActivations, iM) && !_fprop_small_preact(prevActivations, iM)) {
+				iM.mMulABt_Cnb(prevActivations, m_weights, m_activations);
+			}
 
 			_iI.fprop_preactivations(m_activations);
 			_activation_fprop(iM);
@@ -264,6 +306,37 @@ namespace nntl {
 			m_bActivationsValid = true;
 		}
 
+		//computes preactivations of a tiny batch during inference with a single threaded kernel that uses pre-packed weights
+		// (the same as _LFC::_fprop_small_preact()). Returns false if the path isn't applicable and the caller must compute
+		// preactivations itself
+		template<typename iMathT>
+		bool _fprop_small_preact(const realmtx_t& prevActivations, iMathT& iM)noexcept {
+			if (!m_bSmallBatchFprop || get_self().get_common_data().is_training_mode()
+				|| !iM.useSmallMulABt(prevActivations.rows(), m_weights.rows(), m_weights.cols())) return false;
+
+			if (!m_bWeightsPackedValid) {
+				//weights are packed once and then reused by every following fprop() until they change
+				if (!iM.mPack4SmallMulABt(m_weights, m_weightsPacked)) return false;
+				m_bWeightsPackedValid = true;
+			}
+			iM.mMulABt_Cnb_small(prevActivations, m_weightsPacked, m_activations);
+			return true;
+		}
+
+		//computes preactivations during inference with int8 quantized weights and activations (see iMath_t::mMulABt_Cnb_q8()).
+		// Returns false if the path isn't applicable and the caller must compute preactivations itself
+		template<typename iMathT>
+		bool _fprop_q8_preact(const realmtx_t& prevActivations, iMathT& iM)noexcept {
+			if (!m_bInt8Inference || get_self().get_common_data().is_training_mode()) return false;
+
+			if (!m_bWeightsQ8Valid) {
+				//weights are quantized once and then reused by every following fprop() until they change
+				if (!iM.mQuantize4MulABt_q8(m_weights, m_weightsQ8)) return false;
+				m_bWeightsQ8Valid = true;
+			}
+			return iM.mMulABt_Cnb_q8(prevActivations, m_activationsQ8, m_weightsQ8, m_activations);
+		}
+
 		void _cust_inspect(const realmtx_t& M)const noexcept { NNTL_UNREF(M); }
 
 		void _bprop(const realmtx_t& data_y, const realmtx_t& prevActivations, const bool bPrevLayerIsInput, realmtx_t& dLdAPrev)noexcept {
@@ -296,7 +369,9 @@ namespace nntl {
 			//compute dL/dZ
 			_iI.bprop_predLdZOut(m_activations, data_y);
 			
-			_activation_bprop_output(data_y, iM);
+			if (m_bCalcLossInBprop) {
+				m_bpropLoss = _activation_bprop_output_loss(data_y, iM);
+			} else _activation_bprop_output(data_y, iM);
 
 			//now dLdZ is calculated into m_activations
 			realmtx_t & dLdZ = m_activations;
@@ -323,6 +398,7 @@ namespace nntl {
 
 			//now we can apply gradient to the weights
 			m_gradientWorks.apply_grad(m_weights, m_dLdW);
+			m_bWeightsPackedValid = m_bWeightsQ8Valid = false;
 
 			_iI.bprop_end(dLdAPrev);
 		}
@@ -363,6 +439,19 @@ namespace nntl {
 		//should return true, if the layer has a value to add to Loss function value (there's some regularizer attached)
 		bool hasLossAddendum()const noexcept { return m_gradientWorks.hasLossAddendum(); }
 
+		//////////////////////////////////////////////////////////////////////////
+		//makes bprop() compute the (main part of) loss function value of the batch from the activations it got from fprop().
+		// The value is available via bprop_loss() until the next bprop()
+		self_ref_t calc_loss_in_bprop(const bool b)noexcept {
+			m_bCalcLossInBprop = b;
+			return get_self();
+		}
+		bool calc_loss_in_bprop()const noexcept { return m_bCalcLossInBprop; }
+		real_t bprop_loss()const noexcept {
+			NNTL_ASSERT(m_bCalcLossInBprop);
+			return m_bpropLoss;
+		}
+
 		//////////////////////////////////////////////////////////////////////////
 
 		//use this function to put a restriction on dL/dZ value - this may help in training large networks
@@ -44,6 +44,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // |----------------------------------|
 //      / | | | | |  .  | | | | | \
 //
+// Inner layers of LPH are independent of each other, so they may run as concurrent tasks (see _LPH::concurrent_tasks()).
+// In that mode each task gets its own iMath/iRng objects (and therefore its own thread pool sized to the task's share of
+// cores, so iMath_t must have a constructor taking the threads count) and its own scratch memory, and the layers of a task
+// are processed by the task only.
 // 
 #include "_pack_.h"
 #include "../utils.h"
@@ -92,6 +96,10 @@ namespace nntl {
 		typedef typename ::std::tuple_element_t<0, _phl_tuple>::phl_original_t first_layer_t;
 		typedef typename ::std::tuple_element_t<phl_count - 1, _phl_tuple>::phl_original_t last_layer_t;
 
+		//whether the inner layers could be processed as concurrent tasks. Derived classes that rely on the order of inner
+		//layers processing (like _LPHG) must redefine it to false
+		static constexpr bool bAllowConcurrentTasks = true;
+
 	protected:
 		_phl_tuple m_phl_tuple;
 		realmtxdef_t m_activations;//its content assembled from individual activations of inner layers in-place
@@ -105,6 +113,31 @@ namespace nntl {
 		// to allocate dLdA matricies to pass to layers bprop()
 
 		realmtxdef_t m_innerdLdA, m_innerdLdAPrev;
+
+		//////////////////////////////////////////////////////////////////////////
+		// concurrent tasks mode data (see concurrent_tasks())
+		struct _task_slot {
+			::std::unique_ptr<iMath_t> pM;//created with the task's share of threads, see _init_tasks()
+			iRng_t iR;
+			common_data_t cd;//the common data for the layers of the task. Refers to *pM & iR
+
+			numel_cnt_t maxMemRequire;//the biggest scratch memory requirement among layers of the task
+			neurons_count_t maxInCols;//the biggest PHL_coord::m_count among layers of the task
+			real_t* pInAct;//storage for a copy of lower layer activations subset (with biases)
+			real_t* pMem;//scratch memory of the task
+			realmtx_t inAct;
+		};
+		struct _task_layer {
+			realmtxdef_t dLdA, dLdAPrev;//must survive bprop() of the layer until we add the result to the dLdAPrev of LPH
+			numel_cnt_t dLdANumel;
+			neurons_count_t firstNeuronOfs;//offset of the layer activations in m_activations
+			thread_id_t task;
+			unsigned switchMtxs;
+		};
+
+		::std::unique_ptr<_task_slot[]> m_pTasks;//objects own thread pools, so we create them once and keep until the mode changes
+		::std::unique_ptr<_task_layer[]> m_pTaskLayers;//phl_count elements in the m_phl_tuple order
+		thread_id_t m_tasksCnt;//0 means the serial mode
 				
 		//////////////////////////////////////////////////////////////////////////
 		//
@@ -164,6 +197,7 @@ namespace nntl {
 		void _ctor()noexcept {
 			m_pTmpBiasStorage = nullptr;
 			m_layers_max_dLdA_numel = 0;
+			m_tasksCnt = 0;
 			m_activations.will_emulate_biases();
 		}
 
@@ -245,6 +279,25 @@ namespace nntl {
 			});
 		}
 
+		//Turns on (tasksCnt > 1) or off the concurrent processing of inner layers. Inner layers are distributed among tasksCnt
+		// tasks (by their approximate cost) and every task runs on its own share of cores with its own iMath/iRng objects.
+		// Returns the number of tasks that will actually be used (0 means the serial mode). Must be called before init().
+		// The mode isn't available for derived classes with bAllowConcurrentTasks==false and with a non-dummy inspector
+		// (inspectors aren't thread-safe). Note that random streams of inner layers differ from the serial mode.
+		thread_id_t concurrent_tasks(const thread_id_t tasksCnt = ::std::numeric_limits<thread_id_t>::max())noexcept {
+			NNTL_ASSERT(!get_self().has_common_data() || !"concurrent_tasks() must be called before init()");
+			const thread_id_t tc = ::std::min({ tasksCnt, static_cast<thread_id_t>(phl_count), iThreads_t::workers_count() });
+			const bool bAllowed = FinalPolymorphChild::bAllowConcurrentTasks && inspector::is_dummy_inspector<iInspect_t>::value;
+			const thread_id_t newCnt = bAllowed && tc > 1 ? tc : 0;
+			if (newCnt != m_tasksCnt) {
+				m_pTasks.reset();
+				m_pTaskLayers.reset();
+				m_tasksCnt = newCnt;
+			}
+			return m_tasksCnt;
+		}
+		thread_id_t concurrent_tasks_count()const noexcept { return m_tasksCnt; }
+
 		//should return true, if the layer has a value to add to Loss function value (there's some regularizer attached)
 		bool hasLossAddendum()const noexcept {
 			get_self().for_each_packed_layer([&b](auto& l) {
@@ -312,6 +365,13 @@ namespace nntl {
 			// - We should aggregate (by max()) layer's initMem() requirements and add them to ours
 			NNTL_ASSERT(0 == lid.max_dLdA_numel && 0 == lid.maxMemFPropRequire && 0 == lid.maxMemTrainingRequire);
 
+			if (m_tasksCnt) {
+				ec = _init_tasks(lid);
+				if (ErrorCode::Success == ec) bSuccessfullyInitialized = true;
+				lid.bLossAddendumDependsOnActivations = can_penalize_activations<FinalPolymorphChild>::value;
+				return ec;
+			}
+
 			_layer_init_data_t origLid = lid;
 
 			const auto bLidActShSp = lid.bActivationsShareSpace;
@@ -378,10 +438,28 @@ namespace nntl {
 			m_layers_max_dLdA_numel = 0;
 			m_innerdLdA.clear();
 			m_innerdLdAPrev.clear();
+			if (m_pTasks) {
+				for (thread_id_t t = 0; t < m_tasksCnt; ++t) {
+					auto& ts = m_pTasks[t];
+					ts.iR.deinit_rng();
+					ts.pM->deinit();
+					ts.cd.deinit();
+					ts.inAct.clear();
+					ts.pInAct = ts.pMem = nullptr;
+				}
+				for (size_t i = 0; i < phl_count; ++i) {
+					m_pTaskLayers[i].dLdA.clear();
+					m_pTaskLayers[i].dLdAPrev.clear();
+				}
+			}
 			_base_class_t::deinit();
 		}
 
 		void initMem(real_t* ptr, numel_cnt_t cnt)noexcept {
+			if (m_tasksCnt) {
+				_initMem_tasks(ptr, cnt);
+				return;
+			}
 			//for fprop()
 			const auto _biggest_batch_size = static_cast<numel_cnt_t>(get_self().get_common_data().biggest_batch_size());
 			NNTL_ASSERT(ptr && cnt >= _biggest_batch_size);
@@ -421,6 +499,8 @@ namespace nntl {
 				bRestoreBiases = batchSize != get_self().get_common_data().biggest_batch_size();
 			}
 
+			for (thread_id_t t = 0; t < m_tasksCnt; ++t) m_pTasks[t].cd.sync_mode_from(get_self().get_common_data());
+
 			neurons_count_t firstNeuronOfs = 0;
 			get_self().for_each_packed_layer([&act = m_activations, &firstNeuronOfs](auto& lyr)noexcept {
 				//we're just setting memory to store activation values of inner layers here.
@@ -449,9 +529,13 @@ namespace nntl {
 
 			NNTL_ASSERT(lowerLayer.get_activations().test_biases_ok());
 
-			tuple_utils::for_each_up(m_phl_tuple, [&act = lowerLayer.get_activations(), pTmpBiasStorage = m_pTmpBiasStorage](const auto& phl) {
-				phl.l.fprop(_impl::trainable_partial_layer_wrapper<LowerLayer>(act, pTmpBiasStorage, phl.coord));
-			});
+			if (m_tasksCnt) {
+				_fprop_tasks(lowerLayer);
+			} else {
+				tuple_utils::for_each_up(m_phl_tuple, [&act = lowerLayer.get_activations(), pTmpBiasStorage = m_pTmpBiasStorage](const auto& phl) {
+					phl.l.fprop(_impl::trainable_partial_layer_wrapper<LowerLayer>(act, pTmpBiasStorage, phl.coord));
+				});
+			}
 			
 			NNTL_ASSERT(lowerLayer.get_activations().test_biases_ok());
 
@@ -502,6 +586,13 @@ namespace nntl {
 			
 			// We'll copy corresponding parts of dLdA into m_innerdLdA and on inner layer.bprop() return we'll ADD corresponding dLdA to dLdAPrev passed
 			if (!::std::is_base_of<m_layer_input, LowerLayer>::value) dLdAPrev.zeros();
+
+			if (m_tasksCnt) {
+				_bprop_tasks(dLdA, lowerLayer, dLdAPrev);
+				NNTL_ASSERT(lowerLayer.get_activations().test_biases_ok());
+				iI.bprop_end(dLdAPrev);
+				return 1;
+			}
 			
 			neurons_count_t firstNeuronOfs = get_self().get_neurons_cnt();
 			
@@ -594,6 +685,245 @@ namespace nntl {
 			}
 		}
 
+	protected:
+		//////////////////////////////////////////////////////////////////////////
+		// concurrent tasks mode implementation
+
+		//distributes inner layers among tasks, initializes them with the common data of their tasks and computes the memory
+		// requirements. Tasks run simultaneously, so unlike the serial mode, the requirements are summed up: every task needs
+		// a storage for a copy of the lower layer activations subset and it's own scratch memory, and every layer needs
+		// it's own dLdA/dLdAPrev pair.
+		ErrorCode _init_tasks(_layer_init_data_t& lid)noexcept {
+			const auto& CD = get_self().get_common_data();
+			const bool bTrainingPossible = CD.is_training_possible();
+
+			if (!m_pTasks) {
+				m_pTasks.reset(new(::std::nothrow) _task_slot[m_tasksCnt]);
+				m_pTaskLayers.reset(new(::std::nothrow) _task_layer[phl_count]);
+				if (!m_pTasks || !m_pTaskLayers) {
+					m_pTasks.reset();
+					m_pTaskLayers.reset();
+					return ErrorCode::CantAllocateMemoryForTempData;
+				}
+				//tasks split the cores, so every task's pool has only it's share of threads and all the pools together
+				// don't oversubscribe the machine (concurrent_tasks() guarantees m_tasksCnt <= workers_count())
+				const thread_id_t wc = iThreads_t::workers_count(), share = wc / m_tasksCnt, rem = wc % m_tasksCnt;
+				for (thread_id_t t = 0; t < m_tasksCnt; ++t) {
+					auto& ts = m_pTasks[t];
+					ts.pM.reset(new(::std::nothrow) iMath_t(share + (t < rem ? 1 : 0)));
+					if (!ts.pM) {
+						m_pTasks.reset();
+						m_pTaskLayers.reset();
+						return ErrorCode::CantAllocateMemoryForTempData;
+					}
+					if (iRng_t::is_multithreaded) ts.iR.init_ithreads(ts.pM->ithreads());
+				}
+			}
+
+			//the most expensive layer goes to the least loaded task. The cost of a layer is approximated by its weights count
+			numel_cnt_t costs[phl_count];
+			size_t order[phl_count];
+			size_t li = 0;
+			neurons_count_t firstNeuronOfs = 0;
+			get_self().for_each_packed_layer([&](auto& l)noexcept {
+				costs[li] = static_cast<numel_cnt_t>(l.get_neurons_cnt()) * (l.get_incoming_neurons_cnt() + 1);
+				m_pTaskLayers[li].firstNeuronOfs = firstNeuronOfs;
+				firstNeuronOfs += l.get_neurons_cnt();
+				order[li] = li;
+				++li;
+			});
+			NNTL_ASSERT(firstNeuronOfs + 1 == m_activations.cols());
+			::std::stable_sort(order, order + phl_count, [&costs](const size_t a, const size_t b)noexcept { return costs[a] > costs[b]; });
+			::std::vector<numel_cnt_t> load(m_tasksCnt, 0);
+			for (size_t i = 0; i < phl_count; ++i) {
+				const auto t = static_cast<thread_id_t>(::std::min_element(load.begin(), load.end()) - load.begin());
+				m_pTaskLayers[order[i]].task = t;
+				load[t] += costs[order[i]];
+			}
+
+			auto& iR = get_self().get_iRng();
+			for (thread_id_t t = 0; t < m_tasksCnt; ++t) {
+				auto& ts = m_pTasks[t];
+				ts.iR.seed(static_cast<typename iRng_t::seed_t>(iR.gen_int()));
+				ts.cd.init_as_child(CD, *ts.pM, ts.iR);
+				ts.maxMemRequire = 0;
+				ts.maxInCols = 0;
+				ts.pInAct = ts.pMem = nullptr;
+			}
+
+			ErrorCode ec = ErrorCode::Success;
+			const auto bLidActShSp = lid.bActivationsShareSpace;
+			lid.bActivationsShareSpace = true;
+			numel_cnt_t dLdATotal = 0;
+			li = 0;
+			tuple_utils::for_each_up(m_phl_tuple, [&, &act = m_activations](const auto& phl)noexcept {
+				auto& tl = m_pTaskLayers[li++];
+				if (ErrorCode::Success != ec) return;
+				auto& ts = m_pTasks[tl.task];
+				auto& l = phl.l;
+
+				//the layer will refer to the common data of the task
+				_layer_init_data_t initD(ts.cd);
+				initD.clean_using(lid);
+				ec = l.init(initD, act.colDataAsVec(tl.firstNeuronOfs));
+				if (ErrorCode::Success != ec) return;
+				lid.update(initD);
+
+				ts.maxMemRequire = ::std::max({ ts.maxMemRequire, initD.maxMemFPropRequire, initD.maxMemTrainingRequire });
+				ts.maxInCols = ::std::max(ts.maxInCols, phl.coord.m_count);
+				tl.dLdANumel = bTrainingPossible
+					? ::std::max(initD.max_dLdA_numel, realmtx_t::sNumel(CD.training_batch_size(), l.get_incoming_neurons_cnt()))
+					: 0;
+				dLdATotal += 2 * tl.dLdANumel;
+			});
+			lid.bActivationsShareSpace = bLidActShSp;
+			if (ErrorCode::Success != ec) return ec;
+
+			//inner layers have made their preinit() calls
+			for (thread_id_t t = 0; t < m_tasksCnt; ++t) {
+				auto& ts = m_pTasks[t];
+				if (!ts.pM->init()) return ErrorCode::CantInitializeIMath;
+				if (!ts.iR.init_rng()) return ErrorCode::CantInitializeIRng;
+			}
+
+			const auto biggestBatchSize = CD.biggest_batch_size();
+			numel_cnt_t totalMem = dLdATotal;
+			for (thread_id_t t = 0; t < m_tasksCnt; ++t) {
+				totalMem += m_pTasks[t].maxMemRequire + realmtx_t::sNumel(biggestBatchSize, m_pTasks[t].maxInCols + 1);
+			}
+			//initMem() lays out the memory the same way for fprop() and for training, so the requirements are the same
+			lid.maxMemFPropRequire = totalMem;
+			lid.maxMemTrainingRequire = totalMem;
+			if (bTrainingPossible) lid.max_dLdA_numel = realmtx_t::sNumel(CD.training_batch_size(), get_self().get_neurons_cnt());
+			return ec;
+		}
+
+		//memory layout: copies of inputs for every task, then dLdA/dLdAPrev pairs for every layer, then scratch memory of tasks
+		void _initMem_tasks(real_t* ptr, numel_cnt_t cnt)noexcept {
+			const auto& CD = get_self().get_common_data();
+			const auto biggestBatchSize = CD.biggest_batch_size();
+			NNTL_ASSERT(ptr);
+
+			for (thread_id_t t = 0; t < m_tasksCnt; ++t) {
+				auto& ts = m_pTasks[t];
+				const auto n = realmtx_t::sNumel(biggestBatchSize, ts.maxInCols + 1);
+				NNTL_ASSERT(cnt >= n);
+				ts.pInAct = ptr;
+				ptr += n;
+				cnt -= n;
+			}
+
+			if (CD.is_training_possible()) {
+				for (size_t i = 0; i < phl_count; ++i) {
+					auto& tl = m_pTaskLayers[i];
+					NNTL_ASSERT(cnt >= 2 * tl.dLdANumel);
+					tl.dLdA.useExternalStorage(ptr, tl.dLdANumel, false);
+					ptr += tl.dLdANumel;
+					tl.dLdAPrev.useExternalStorage(ptr, tl.dLdANumel, false);
+					ptr += tl.dLdANumel;
+					cnt -= 2 * tl.dLdANumel;
+				}
+			}
+
+			for (thread_id_t t = 0; t < m_tasksCnt; ++t) {
+				auto& ts = m_pTasks[t];
+				NNTL_ASSERT(cnt >= ts.maxMemRequire);
+				ts.pMem = ptr;
+				ptr += ts.maxMemRequire;
+				cnt -= ts.maxMemRequire;
+			}
+
+			size_t li = 0;
+			get_self().for_each_packed_layer([&li, this](auto& l) {
+				const auto& ts = m_pTasks[m_pTaskLayers[li++].task];
+				l.initMem(ts.pMem, ts.maxMemRequire);
+			});
+		}
+
+		// Lower layer activations are shared among tasks, therefore they must be left intact. If the range of a layer doesn't end at
+		// the bias column, we can't substitute the next column with biases (like the serial mode does) and have to make a copy.
+		static bool _is_tail_coord(const realmtx_t& act, const PHL_coord& coord)noexcept {
+			return coord.m_offset + coord.m_count >= act.cols_no_bias();
+		}
+		static void _copy_task_input(_task_slot& ts, const realmtx_t& act, const PHL_coord& coord)noexcept {
+			NNTL_ASSERT(ts.pInAct && coord.m_count <= ts.maxInCols);
+			ts.inAct.useExternalStorage(ts.pInAct, act.rows(), coord.m_count + 1, true);
+			memcpy(ts.inAct.data(), act.colDataAsVec(coord.m_offset), static_cast<size_t>(realmtx_t::sNumel(act.rows(), coord.m_count))*sizeof(real_t));
+			//biases might be holey
+			ts.inAct.copy_biases_from(act);
+		}
+
+		template <typename LowerLayer>
+		void _fprop_tasks(const LowerLayer& lowerLayer)noexcept {
+			const realmtx_t& act = lowerLayer.get_activations();
+
+			get_self().get_iMath().ithreads().run([&act, this](const typename iThreads_t::par_range_t& r) {
+				const auto last = r.offset() + r.cnt();
+				for (auto t = r.offset(); t < last; ++t) {
+					auto& ts = m_pTasks[static_cast<thread_id_t>(t)];
+					size_t li = 0;
+					tuple_utils::for_each_up(m_phl_tuple, [&](const auto& phl) {
+						if (m_pTaskLayers[li++].task != t) return;
+
+						const bool bTail = _is_tail_coord(act, phl.coord);
+						if (!bTail) _copy_task_input(ts, act, phl.coord);
+						phl.l.fprop(_impl::trainable_partial_layer_wrapper<LowerLayer>(bTail ? act : static_cast<const realmtx_t&>(ts.inAct)
+							, nullptr, bTail ? phl.coord : PHL_coord(0, phl.coord.m_count)));
+					});
+				}
+			}, m_tasksCnt, m_tasksCnt);
+		}
+
+		template <typename LowerLayer>
+		void _bprop_tasks(realmtxdef_t& dLdA, const LowerLayer& lowerLayer, realmtx_t& dLdAPrev)noexcept {
+			constexpr bool bLowerLayerIsInput = ::std::is_base_of<m_layer_input, LowerLayer>::value;
+			const realmtx_t& act = lowerLayer.get_activations();
+			const auto _training_batch_size = get_self().get_common_data().get_cur_batch_size();
+
+			get_self().get_iMath().ithreads().run([&, this](const typename iThreads_t::par_range_t& r) {
+				const auto last = r.offset() + r.cnt();
+				for (auto t = r.offset(); t < last; ++t) {
+					auto& ts = m_pTasks[static_cast<thread_id_t>(t)];
+					size_t li = phl_count;
+					//going backwards within a task, like the serial mode does
+					tuple_utils::for_each_down(m_phl_tuple, [&](const auto& phl) {
+						auto& tl = m_pTaskLayers[--li];
+						if (tl.task != t) return;
+						auto& lyr = phl.l;
+
+						tl.dLdA.deform_like_no_bias(lyr.get_activations());
+						NNTL_ASSERT(tl.firstNeuronOfs + tl.dLdA.cols() <= dLdA.cols());
+						NNTL_ASSERT(tl.dLdA.rows() == dLdA.rows() && _training_batch_size == tl.dLdA.rows());
+						memcpy(tl.dLdA.data(), dLdA.colDataAsVec(tl.firstNeuronOfs), tl.dLdA.byte_size());
+
+						if (bLowerLayerIsInput) {
+							tl.dLdAPrev.deform(0, 0);
+						} else tl.dLdAPrev.deform(_training_batch_size, phl.coord.m_count);
+
+						const bool bTail = _is_tail_coord(act, phl.coord);
+						if (!bTail) _copy_task_input(ts, act, phl.coord);
+						tl.switchMtxs = lyr.bprop(tl.dLdA
+							, _impl::trainable_partial_layer_wrapper<LowerLayer>(bTail ? act : static_cast<const realmtx_t&>(ts.inAct)
+								, nullptr, bTail ? phl.coord : PHL_coord(0, phl.coord.m_count))
+							, tl.dLdAPrev);
+					});
+				}
+			}, m_tasksCnt, m_tasksCnt);
+
+			if (!bLowerLayerIsInput) {
+				//ranges of inner layers may intersect, so summing up their dLdAPrev here in the order of the serial mode.
+				// That also keeps the result deterministic
+				auto& _Math = get_self().get_iMath();
+				size_t li = phl_count;
+				tuple_utils::for_each_down(m_phl_tuple, [&](const auto& phl) {
+					auto& tl = m_pTaskLayers[--li];
+					NNTL_ASSERT(tl.switchMtxs ? tl.dLdAPrev.size() == realmtx_t::mtx_size_t(_training_batch_size, phl.coord.m_count)
+						: tl.dLdA.size() == realmtx_t::mtx_size_t(_training_batch_size, phl.coord.m_count));
+					_Math.vAdd_ip(dLdAPrev.colDataAsVec(phl.coord.m_offset), tl.switchMtxs ? tl.dLdAPrev.data() : tl.dLdA.data()
+						, realmtx_t::sNumel(_training_batch_size, phl.coord.m_count));
+				});
+			}
+		}
 
 	private:
 		//support for ::boost::serialization
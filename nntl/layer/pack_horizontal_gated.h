@@ -75,6 +75,9 @@ namespace nntl {
 		// will check it later in runtime		
 		typedef first_layer_t gating_layer_t;
 
+		//the gate must be processed before the gated layers in fprop() and after them in bprop()
+		static constexpr bool bAllowConcurrentTasks = false;
+
 		//////////////////////////////////////////////////////////////////////////
 		//WARNING: _LEx/_LPA<> relies that the first layer is a gating layer! See _LEx/_LPA::_update_dLdA
 		//////////////////////////////////////////////////////////////////////////
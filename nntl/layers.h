@@ -44,6 +44,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 namespace nntl {
 
+	namespace _impl {
+		struct layer_complete_grad {
+			template<typename _L> ::std::enable_if_t<layer_has_gradworks<_L>::value> operator()(_L& l)const noexcept {
+				l.get_gradWorks().complete_grad();
+			}
+			template<typename _L> ::std::enable_if_t<!layer_has_gradworks<_L>::value> operator()(_L&)const noexcept {}
+		};
+	}
+
 	// layers class is a special container for all layers used in nnet.
 	// each layer is stored in layers object by its reference, therefore layer object has to be instantiated
 	// somewhere by a caller. This is not so good, because semantically one thing - neural network object -
@@ -254,15 +263,17 @@ namespace nntl {
 			tuple_utils::for_each_up(m_layers, [](auto& lyr)noexcept { lyr.on_batch_size_change(); });
 		}
 
-		void fprop(const realmtx_t& data_x) noexcept {
+		//XMtxT is either realmtx_t, or a sparse math::smatrix_csr<real_t> (see layer_input)
+		template<typename XMtxT>
+		void fprop(const XMtxT& data_x) noexcept {
 			NNTL_ASSERT(data_x.test_biases_ok());
 
 			input_layer().fprop(data_x);
 
 			tuple_utils::for_eachwp_up(m_layers, [](auto& lcur, auto& lprev, const bool)noexcept {
-				NNTL_ASSERT(lprev.get_activations().test_biases_ok());
+				NNTL_ASSERT(lprev.has_sparse_activations() || lprev.get_activations().test_biases_ok());
 				lcur.fprop(lprev);
-				NNTL_ASSERT(lprev.get_activations().test_biases_ok());
+				NNTL_ASSERT(lprev.has_sparse_activations() || lprev.get_activations().test_biases_ok());
 			});
 		}
 
@@ -287,14 +298,18 @@ namespace nntl {
 					_a_dLdA[nextMtxIdx].deform_like_no_bias(lprev.get_activations());
 				}
 				
-				NNTL_ASSERT(lprev.get_activations().test_biases_ok());
+				NNTL_ASSERT(lprev.has_sparse_activations() || lprev.get_activations().test_biases_ok());
 				NNTL_ASSERT(_a_dLdA[mtxIdx].size() == lcur.get_activations().size_no_bias());
 				const unsigned bAlternate = lcur.bprop(_a_dLdA[mtxIdx], lprev, _a_dLdA[nextMtxIdx]);
 				NNTL_ASSERT(1 == bAlternate || 0 == bAlternate);
-				NNTL_ASSERT(lprev.get_activations().test_biases_ok());
+				NNTL_ASSERT(lprev.has_sparse_activations() || lprev.get_activations().test_biases_ok());
 
 				mtxIdx ^= bAlternate;
 			});
+
+			//the distributed training defers weights updates to average gradients over the ranks while the lower layers
+			// do their bprop(). Finishing them here, so for the callers the weights are updated as usual
+			for_each_layer(_impl::layer_complete_grad());
 		}
 	};
 
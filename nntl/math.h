@@ -103,6 +103,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "_defs.h"
 #include "interface/math/smatrix.h"
+#include "interface/math/smatrix_csr.h"
 
 namespace nntl {
 
@@ -44,6 +44,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //#include "utils\lambdas.h"
 
 #include "interface/inspectors/gradcheck.h"
+#include "interface/threads/numa.h"
+#include "interface/threads/bgworkers.h"
 
 namespace nntl {
 
@@ -71,8 +73,11 @@ namespace nntl {
 
 		typedef typename iMath_t::realmtx_t realmtx_t;
 		typedef typename iMath_t::realmtxdef_t realmtxdef_t;
+		typedef typename iMath_t::realmtx_csr_t realmtx_csr_t;
 		
 		typedef train_data<real_t> train_data_t;
+		//train_data with the sparse X data. It could be used only if the first layer above the layer_input is _LFC
+		typedef train_data<real_t, realmtx_csr_t> train_data_sparse_t;
 
 		//////////////////////////////////////////////////////////////////////////
 		// members
@@ -81,15 +86,28 @@ namespace nntl {
 
 		_impl::layers_mem_requirements m_LMR;
 
-		::std::vector<real_t> m_pTmpStor;
+		::std::unique_ptr<real_t[]> m_pTmpStor;
+
+		//per NUMA node copies of the dense train_x (see numa_replicate_train_x())
+		threads::numa::node_replicas<real_t> m_xReplicas;
+		::std::vector<threads::numa::node_id_t> m_numaTidNodes;
 
 		realmtx_t m_batch_x, m_batch_y;
+		//the second pair of minibatch matrices used by the background prefetching (see nnet_train_opts::prefetchBatches())
+		realmtx_t m_batch_x2, m_batch_y2;
+		//a single background thread that gathers the next minibatch. Created on the first train() that needs it
+		::std::unique_ptr<threads::BgWorkers<>> m_pPrefetcher;
+		//minibatch X storage for the sparse training data. It doesn't use m_pTmpStor, because its size depends on the data
+		realmtx_csr_t m_batch_x_sp;
 
 		layer_index_t m_failedLayerIdx;
 
 		bool m_bCalcFullLossValue;//set based on nnet_train_opts::calcFullLossValue() and the value, returned by layers init()
 		bool m_bRequireReinit;//set this flag to require nnet object and its layers to reinitialize on next call
 
+		//drives the training of several nnet replicas reusing the nnet internals (see nnet_data_parallel.h)
+		template<typename NNetT, typename PolicyT> friend class nnet_data_parallel;
+
 		//////////////////////////////////////////////////////////////////////////
 		//Serialization support
 	private:
@@ -131,12 +149,21 @@ namespace nntl {
 		//call this to force nnet and its dependents to reinitialize 
 		void require_reinit()noexcept { m_bRequireReinit = true; }
 
+		//Opt-in: keep a copy of the dense train_x on every NUMA node the worker threads run on, so the minibatch extraction
+		// reads the data from the local node memory. Pass threads::numa::pin_workers::tid_nodes() and keep that pin_workers
+		// object alive during train(). Copies are made on every train() call (costs train_x.numel() of memory per additional
+		// node). Empty vector turns the feature off.
+		void numa_replicate_train_x(const ::std::vector<threads::numa::node_id_t>& tidNodes)noexcept {
+			m_numaTidNodes = tidNodes;
+			m_xReplicas.clear();
+		}
+
 	protected:
 
 		//#todo get rid of pTestEvalRes
 		//returns test loss
-		template<bool bPrioritizeThreads = true, typename Observer>
-		const real_t _report_training_fragment(const size_t& epoch, const real_t& trainLoss, train_data_t& td,
+		template<bool bPrioritizeThreads = true, typename Observer, typename TdT>
+		const real_t _report_training_fragment(const size_t& epoch, const real_t& trainLoss, TdT& td,
 			const ::std::chrono::nanoseconds& tElapsed, Observer& obs, const bool& bTrainSetWasInspected = false,
 			nnet_eval_results<real_t>*const pTestEvalRes=nullptr) noexcept
 		{
@@ -166,19 +193,23 @@ namespace nntl {
 			return testLoss;
 		}
 
-		bool _batchSizeOk(const train_data_t& td, vec_len_t batchSize)const noexcept {
+		template<typename TdT>
+		bool _batchSizeOk(const TdT& td, vec_len_t batchSize)const noexcept {
 			//TODO:      (RProp  )
 			double d = double(td.train_x().rows()) / double(batchSize);
 			return  d == floor(d);
 		}
 
-		void _fprop(const realmtx_t& data_x)noexcept {
+		//XMtxT is realmtx_t (or derived class) or realmtx_csr_t
+		template<typename XMtxT>
+		void _fprop(const XMtxT& data_x)noexcept {
 			//preparing for evaluation
 			set_mode_and_batch_size(data_x.rows());
 			m_Layers.fprop(data_x);
 		}
 
-		real_t _calcLossNotifyInspector(const realmtx_t*const pData_x, const realmtx_t& data_y, const bool bTrainingData) noexcept {
+		template<typename XMtxT>
+		real_t _calcLossNotifyInspector(const XMtxT*const pData_x, const realmtx_t& data_y, const bool bTrainingData) noexcept {
 			auto& iI = get_iInspect();
 			iI.train_preCalcError(bTrainingData);
 			const auto r = _calcLoss(pData_x, data_y);
@@ -186,7 +217,8 @@ namespace nntl {
 			return r;
 		}
 
-		real_t _calcLoss(const realmtx_t*const pData_x, const realmtx_t& data_y) noexcept {
+		template<typename XMtxT>
+		real_t _calcLoss(const XMtxT*const pData_x, const realmtx_t& data_y) noexcept {
 			NNTL_ASSERT(!pData_x || pData_x->rows() == data_y.rows());
 			if (pData_x) _fprop(*pData_x);
 
@@ -195,18 +227,26 @@ namespace nntl {
 			return lossValue;
 		}
 
-		const bool _is_initialized(const vec_len_t biggestFprop, const vec_len_t batchSize)const noexcept {
+		const bool _is_initialized(const vec_len_t biggestFprop, const vec_len_t batchSize, const bool bMiniBatch
+			, const bool bSparseX, const bool bPrefetch = false)const noexcept
+		{
 			return !m_bRequireReinit && get_common_data().is_initialized()
 				&& biggestFprop <= get_common_data().max_fprop_batch_size()
-				&& batchSize <= get_common_data().training_batch_size();
+				&& batchSize <= get_common_data().training_batch_size()
+				&& (!bMiniBatch || bSparseX || !m_batch_x.empty())
+				&& (!bPrefetch || !m_batch_x2.empty());
 				//&& (0 == batchSize || batchSize == get_common_data().training_batch_size());
 		}
 
 		//batchSize==0 means that _init is called for use in fprop scenario only
+		//bSparseX means that the training X data is sparse, therefore m_batch_x isn't needed (m_batch_x_sp is used instead)
+		//bPrefetch requires the second pair of minibatch matrices (m_batch_x2, m_batch_y2). Implies bMiniBatch && !bSparseX
 		ErrorCode _init(const vec_len_t biggestFprop, vec_len_t batchSize = 0, const bool bMiniBatch = false
-			, const size_t maxEpoch = 1, const vec_len_t numBatches = 1)noexcept
+			, const size_t maxEpoch = 1, const vec_len_t numBatches = 1, const bool bSparseX = false
+			, const bool bPrefetch = false)noexcept
 		{
-			if (_is_initialized(biggestFprop, batchSize)) {
+			NNTL_ASSERT(!bPrefetch || (bMiniBatch && !bSparseX));
+			if (_is_initialized(biggestFprop, batchSize, bMiniBatch, bSparseX, bPrefetch)) {
 				//_processTmpStor(bMiniBatch, train_x_cols, train_y_cols, batchSize, pTtd);
 				//looks like the call above is actually a bug. If the nnet is initalized, no work should be done with its memory
 				get_iInspect().init_nnet(m_Layers.total_layers(), maxEpoch, numBatches);
@@ -236,18 +276,18 @@ namespace nntl {
 			if (!get_iMath().init()) return ErrorCode::CantInitializeIMath;
 			if (!get_iRng().init_rng()) return ErrorCode::CantInitializeIRng;
 
-			const numel_cnt_t totalTempMemSize = _totalTrainingMemSize(bMiniBatch, batchSize);
-			//m_pTmpStor.reset(new(::std::nothrow)real_t[totalTempMemSize]);
-			//if (nullptr == m_pTmpStor.get()) return ErrorCode::CantAllocateMemoryForTempData;
-			m_pTmpStor.resize(totalTempMemSize);
+			const numel_cnt_t totalTempMemSize = _totalTrainingMemSize(bMiniBatch, batchSize, bSparseX, bPrefetch);
+			m_pTmpStor.reset(new(::std::nothrow)real_t[totalTempMemSize]);
+			if (nullptr == m_pTmpStor.get()) return ErrorCode::CantAllocateMemoryForTempData;
 			
-			const auto _memUsed = _processTmpStor(bMiniBatch, batchSize);
+			const auto _memUsed = _processTmpStor(bMiniBatch, batchSize, bSparseX, bPrefetch);
 			NNTL_ASSERT(totalTempMemSize == _memUsed);
 
 			bInitFinished = true;
 			return ErrorCode::Success;
 		}
-		const numel_cnt_t _totalTrainingMemSize(const bool bMiniBatch, const vec_len_t batchSize)noexcept
+		const numel_cnt_t _totalTrainingMemSize(const bool bMiniBatch, const vec_len_t batchSize, const bool bSparseX
+			, const bool bPrefetch)noexcept
 			//, const vec_len_t train_x_cols, const vec_len_t train_y_cols)noexcept
 		{
 			// here is how we gonna spread temp buffers:
@@ -256,6 +296,7 @@ namespace nntl {
 			//		"outgoing" i.e. for lower layer). This matrices will be used during bprop() by m_Layers.bprop()
 			// 3. In minibatch version, there will be 2 additional matrices sized (batchSize, train_x.cols()) and (batchSize, train_y.cols())
 			//		to handle _batch_x and _batch_y data
+			// 4. When the minibatches are prefetched, there's one more pair of matrices of the same size
 			
 			const vec_len_t train_x_cols = vec_len_t(1) + m_Layers.input_layer().get_neurons_cnt()//1 for bias column
 				, train_y_cols = m_Layers.output_layer().get_neurons_cnt();
@@ -263,16 +304,26 @@ namespace nntl {
 			return m_LMR.maxMemLayerTrainingRequire
 				+ (batchSize > 0 
 					? m_Layers.m_a_dLdA.size()*m_LMR.maxSingledLdANumel
-					+ (bMiniBatch ? (realmtx_t::sNumel(batchSize, train_x_cols) + realmtx_t::sNumel(batchSize, train_y_cols)) : 0)
+					+ (bMiniBatch 
+						? ((bSparseX ? 0 : realmtx_t::sNumel(batchSize, train_x_cols)) + realmtx_t::sNumel(batchSize, train_y_cols))
+							*(bPrefetch ? 2 : 1)
+						: 0)
 					: 0);
 		}
 
-		numel_cnt_t _processTmpStor(const bool bMiniBatch, const vec_len_t batchSize)noexcept
+		numel_cnt_t _processTmpStor(const bool bMiniBatch, const vec_len_t batchSize, const bool bSparseX
+			, const bool bPrefetch)noexcept
 		{
-			NNTL_ASSERT(batchSize == 0 || m_pTmpStor.size() > 0);
-			//auto tempMemStorage = m_pTmpStor.get();
-			//NNTL_ASSERT(tempMemStorage);
-			auto& tempMemStorage = m_pTmpStor;
+			auto tempMemStorage = m_pTmpStor.get();
+			NNTL_ASSERT(tempMemStorage);
+
+			//every matrix is zeroed by the worker threads on its own, so its pages land on the NUMA nodes of the threads that
+			// process the same ranges of it in elementwise kernels. The layers scratch (1.) is shared by matrices of different
+			// shapes, so no partitioning fits it better than another and it's touched as a single range
+			auto& iT = get_iMath().ithreads();
+			const auto _touch = [&iT](real_t*const p, const numel_cnt_t n)noexcept {
+				threads::numa::first_touch(iT, p, static_cast<typename iThreads_t::range_t>(n));
+			};
 
 			numel_cnt_t spreadTempMemSize = 0;
 
@@ -283,22 +334,39 @@ namespace nntl {
 				//3. _batch_x and _batch_y if necessary
 				if (bMiniBatch) {
 					NNTL_ASSERT(batchSize);
-					m_batch_x.useExternalStorage(&tempMemStorage[spreadTempMemSize], batchSize, m_Layers.input_layer().get_neurons_cnt() + 1, true);
-					spreadTempMemSize += m_batch_x.numel();
+					if (!bSparseX) {
+						m_batch_x.useExternalStorage(&tempMemStorage[spreadTempMemSize], batchSize, m_Layers.input_layer().get_neurons_cnt() + 1, true);
+						_touch(m_batch_x.data(), m_batch_x.numel());
+						spreadTempMemSize += m_batch_x.numel();
+					}
 					m_batch_y.useExternalStorage(&tempMemStorage[spreadTempMemSize], batchSize, m_Layers.output_layer().get_neurons_cnt());
+					_touch(m_batch_y.data(), m_batch_y.numel());
 					spreadTempMemSize += m_batch_y.numel();
+
+					//4.
+					if (bPrefetch) {
+						NNTL_ASSERT(!bSparseX);
+						m_batch_x2.useExternalStorage(&tempMemStorage[spreadTempMemSize], batchSize, m_Layers.input_layer().get_neurons_cnt() + 1, true);
+						_touch(m_batch_x2.data(), m_batch_x2.numel());
+						spreadTempMemSize += m_batch_x2.numel();
+						m_batch_y2.useExternalStorage(&tempMemStorage[spreadTempMemSize], batchSize, m_Layers.output_layer().get_neurons_cnt());
+						_touch(m_batch_y2.data(), m_batch_y2.numel());
+						spreadTempMemSize += m_batch_y2.numel();
+					}
 				}
 
 				//2. dLdA
 				//#TODO: better move it to m_Layers
 				for(auto& m : m_Layers.m_a_dLdA){
 					m.useExternalStorage(&tempMemStorage[spreadTempMemSize], m_LMR.maxSingledLdANumel);
+					_touch(m.data(), m_LMR.maxSingledLdANumel);
 					spreadTempMemSize += m_LMR.maxSingledLdANumel;
 				}
 			}
 
 			// 1.
 			if (m_LMR.maxMemLayerTrainingRequire > 0) {//m_LMR.maxMemLayerTrainingRequire is a max(for fprop() and for bprop() reqs)
+				_touch(&tempMemStorage[spreadTempMemSize], m_LMR.maxMemLayerTrainingRequire);
 				m_Layers.initMem(&tempMemStorage[spreadTempMemSize], m_LMR.maxMemLayerTrainingRequire);
 				spreadTempMemSize += m_LMR.maxMemLayerTrainingRequire;
 			}
@@ -315,7 +383,73 @@ namespace nntl {
 			m_LMR.zeros();
 			m_batch_x.clear();
 			m_batch_y.clear();
-			m_pTmpStor.clear();
+			m_batch_x2.clear();
+			m_batch_y2.clear();
+			m_batch_x_sp.clear();
+			m_pTmpStor.reset();
+			m_xReplicas.clear();
+		}
+
+		//returns the matrix to feed the training X data with
+		realmtx_t& _batch_x(train_data_t& td, const bool bMiniBatch)noexcept {
+			return bMiniBatch ? m_batch_x : td.train_x_mutable();
+		}
+		realmtx_csr_t& _batch_x(train_data_sparse_t& td, const bool bMiniBatch)noexcept {
+			return bMiniBatch ? m_batch_x_sp : td.train_x_mutable();
+		}
+
+		//the dense m_batch_x is spread over m_pTmpStor by _init(), while the sparse one has to be allocated here to fit
+		// batchSize of the most populated rows of the train_x
+		static constexpr bool _prepare_batch_x(const train_data_t&, const bool, const vec_len_t)noexcept { return true; }
+		bool _prepare_batch_x(const train_data_sparse_t& td, const bool bMiniBatch, const vec_len_t batchSize)noexcept {
+			if (!bMiniBatch) return true;
+			m_batch_x_sp.clear();
+			m_batch_x_sp.will_emulate_biases();
+			return m_batch_x_sp.resize(batchSize, td.train_x().cols_no_bias(), batchSize*td.train_x().max_row_nnz());
+		}
+
+		template<typename SeqIt>
+		bool _extract_batch_x(const realmtx_t& train_x, const SeqIt& rowIdxIt, realmtx_t& batch_x)noexcept {
+			if (m_xReplicas.replicated() && m_xReplicas.made_for(train_x.data(), static_cast<size_t>(train_x.numel()))) {
+				const auto& xr = m_xReplicas;
+				get_iMath().mExtractRows_replicated(train_x, [&xr](const thread_id_t t)noexcept {
+					return xr.for_tid(t);
+				}, rowIdxIt, batch_x);
+			} else get_iMath().mExtractRows(train_x, rowIdxIt, batch_x);
+			return true;
+		}
+		
+		bool _numa_replicate_x(const realmtx_t& train_x, const bool bMiniBatch)noexcept {
+			m_xReplicas.clear();
+			return !bMiniBatch || m_numaTidNodes.empty()
+				|| m_xReplicas.make(get_iMath().ithreads(), m_numaTidNodes, train_x.data(), static_cast<size_t>(train_x.numel()));
+		}
+		bool _numa_replicate_x(const realmtx_csr_t& train_x, const bool bMiniBatch)noexcept {
+			NNTL_UNREF(train_x); NNTL_UNREF(bMiniBatch);
+			m_xReplicas.clear();
+			return true;
+		}
+		template<typename SeqIt>
+		bool _extract_batch_x(const realmtx_csr_t& train_x, const SeqIt& rowIdxIt, realmtx_csr_t& batch_x)noexcept {
+			return get_iMath().mExtractRows(train_x, rowIdxIt, batch_x);
+		}
+
+		//returns the matrix to prefetch the next minibatch X data into (nullptr if prefetching isn't possible)
+		realmtx_t* _prefetch_batch_x(train_data_t&)noexcept { return &m_batch_x2; }
+		static constexpr realmtx_csr_t* _prefetch_batch_x(train_data_sparse_t&)noexcept { return nullptr; }
+
+		//runs on the prefetching thread concurrently with the main and iMath threads, so it mustn't use any of the
+		// nnet interfaces and just gathers the rows by itself
+		template<typename SeqIt>
+		static void _prefetch_batch(const realmtx_t& train_x, const realmtx_t& train_y, const SeqIt& rowIdxIt
+			, realmtx_t& batch_x, realmtx_t& batch_y)noexcept
+		{
+			iMath_t::mExtractRows_seqWrite_st(train_x, rowIdxIt, batch_x);
+			iMath_t::mExtractRows_seqWrite_st(train_y, rowIdxIt, batch_y);
+		}
+		template<typename SeqIt>
+		static void _prefetch_batch(const realmtx_csr_t&, const realmtx_t&, const SeqIt&, realmtx_csr_t&, realmtx_t&)noexcept {
+			NNTL_ASSERT(!"Sparse X data isn't prefetched");
 		}
 		
 		void set_mode_and_batch_size(const vec_len_t bs)noexcept {
@@ -328,9 +462,12 @@ namespace nntl {
 
 	public:
 
-		template <bool bPrioritizeThreads = true, typename TrainOptsT, typename OnEpochEndCbT = NNetCB_OnEpochEnd_Dummy>
-		ErrorCode train(train_data_t& td, TrainOptsT& opts, OnEpochEndCbT&& onEpochEndCB = NNetCB_OnEpochEnd_Dummy())noexcept
+		//td is either train_data_t or train_data_sparse_t
+		template <bool bPrioritizeThreads = true, typename TrainOptsT, typename OnEpochEndCbT = NNetCB_OnEpochEnd_Dummy
+			, typename XMtxT = realmtxdef_t>
+		ErrorCode train(train_data<real_t, XMtxT>& td, TrainOptsT& opts, OnEpochEndCbT&& onEpochEndCB = NNetCB_OnEpochEnd_Dummy())noexcept
 		{
+			constexpr bool bSparseX = train_data<real_t, XMtxT>::bSparseX;
 			typedef ::std::conditional_t<bPrioritizeThreads
 				, threads::prioritize_workers<threads::PriorityClass::Working, iThreads_t>
 				, threads::_impl::prioritize_workers_dummy<threads::PriorityClass::Normal, iThreads_t>> PW_t;
@@ -355,6 +492,7 @@ namespace nntl {
 
 			const bool bTrainSetBigger = samplesCount >= td.test_x().rows();
 			const bool bMiniBatch = opts.batchSize() > 0 && opts.batchSize() < samplesCount;
+			const bool bPrefetch = bMiniBatch && !bSparseX && opts.prefetchBatches();
 			const bool bSaveNNEvalResults = opts.evalNNFinalPerf();
 
 			const size_t maxEpoch = opts.maxEpoch();
@@ -367,8 +505,11 @@ namespace nntl {
 			m_bCalcFullLossValue = opts.calcFullLossValue();
 			//////////////////////////////////////////////////////////////////////////
 			// perform layers initialization, gather temp memory requirements, then allocate and spread temp buffers
-			auto ec = _init(bTrainSetBigger ? samplesCount : td.test_x().rows(), batchSize, bMiniBatch, maxEpoch, numBatches);
+			auto ec = _init(bTrainSetBigger ? samplesCount : td.test_x().rows(), batchSize, bMiniBatch, maxEpoch, numBatches
+				, bSparseX, bPrefetch);
 			if (ErrorCode::Success != ec) return _set_last_error(ec);
+			if (!_prepare_batch_x(td, bMiniBatch, batchSize)) return _set_last_error(ErrorCode::CantAllocateMemoryForTempData);
+			if (!_numa_replicate_x(train_x, bMiniBatch)) return _set_last_error(ErrorCode::CantAllocateMemoryForTempData);
 
 			//scheduling deinitialization with scope_exit to forget about return statements
 			utils::scope_exit layers_deinit([this, &opts]() {
@@ -379,9 +520,9 @@ namespace nntl {
 
 			if (m_bCalcFullLossValue) m_bCalcFullLossValue = m_LMR.bHasLossAddendum;
 
-			realmtx_t& batch_x = bMiniBatch ? m_batch_x : td.train_x_mutable();
-			realmtx_t& batch_y = bMiniBatch ? m_batch_y : td.train_y_mutable();
-			NNTL_ASSERT(batch_x.emulatesBiases() && !batch_y.emulatesBiases());
+			auto* pBatchX = &_batch_x(td, bMiniBatch);
+			realmtx_t* pBatchY = bMiniBatch ? &m_batch_y : &td.train_y_mutable();
+			NNTL_ASSERT(pBatchX->emulatesBiases() && !pBatchY->emulatesBiases());
 
 			::std::vector<vec_len_t> vRowIdxs(bMiniBatch ? samplesCount : 0);
 			if (bMiniBatch) {
@@ -389,6 +530,24 @@ namespace nntl {
 				//for (size_t i = 0; i < samplesCount; ++i) vRowIdxs[i] = static_cast<decltype(vRowIdxs)::value_type>(i);
 			}
 
+			//double buffering of minibatches: while the batch in *pBatchX/*pBatchY is being processed, the prefetcher thread
+			// gathers the next one into *pNextBatchX/*pNextBatchY. Buffers are swapped at the batch boundary.
+			// The first batch of an epoch is gathered synchronously, because the row indexes are shuffled at the epoch start.
+			auto* pNextBatchX = bPrefetch ? _prefetch_batch_x(td) : nullptr;
+			realmtx_t* pNextBatchY = bPrefetch ? &m_batch_y2 : nullptr;
+			auto prefetchIt = vRowIdxs.cbegin();
+			auto fnPrefetch = [&train_x, &train_y, &prefetchIt, &pNextBatchX, &pNextBatchY](const thread_id_t)noexcept {
+				_prefetch_batch(train_x, train_y, prefetchIt, *pNextBatchX, *pNextBatchY);
+			};
+			if (bPrefetch && !m_pPrefetcher) {
+				m_pPrefetcher.reset(new(::std::nothrow) threads::BgWorkers<>(1, threads::PriorityClass::threads_priority_no_change));
+				if (!m_pPrefetcher) return _set_last_error(ErrorCode::CantAllocateMemoryForTempData);
+			}
+			//every early return must wait for the prefetcher to stop touching the buffers
+			utils::scope_exit prefetch_wait([this, bPrefetch]() {
+				if (bPrefetch) m_pPrefetcher->exec_wait();
+			});
+
 			//////////////////////////////////////////////////////////////////////////
 			const auto& cee = opts.getCondEpochEval();			
 			const auto divergenceCheckLastEpoch = opts.divergenceCheckLastEpoch();
@@ -397,6 +556,15 @@ namespace nntl {
 			//results of training's fprop() in error calculation to skip corresponding fprop() completely
 			const bool bOptimFullBatchErrorCalc = !bMiniBatch && opts.dropFProp4FullBatchErrorCalc()
 				&& !m_LMR.bOutputDifferentDuringTraining;
+			//the training set loss may be gathered from the output layer's bprop() instead of doing additional fprop()
+			const bool bTrainLossFromBatches = opts.trainLossFromBatches();
+			//the observer needs the output activations over the whole training set for inspected epochs
+			const bool bObserverInspectsTrain = ::std::decay_t<decltype(opts.observer())>::bInspectsTrainResults;
+			const bool bSeekRng = opts.seekRngEachEpoch();
+			auto& outpLayer = m_Layers.output_layer();
+			utils::scope_exit outp_calc_loss_reset([&outpLayer]() {
+				outpLayer.calc_loss_in_bprop(false);
+			});
 
 			if (bSaveNNEvalResults) opts.getCondEpochEval().verbose(lastEpoch);
 
@@ -441,40 +609,77 @@ namespace nntl {
 					const bool bCalcLoss = bInspectEpoch || bCheckForDivergence;
 					const bool bLastEpoch = epochIdx == lastEpoch;
 					const bool bOptFBErrCalcThisEpoch = bOptimFullBatchErrorCalc && bCalcLoss && !bLastEpoch;
+					//the last epoch may have to save the output activations for the whole training set and an inspected epoch
+					// may have to pass them to the observer
+					const bool bBatchLossThisEpoch = bTrainLossFromBatches && bCalcLoss && !bOptFBErrCalcThisEpoch
+						&& !(bSaveNNEvalResults && bLastEpoch) && !(bInspectEpoch && bObserverInspectsTrain);
+					//true when there's no fprop() over the training set to calculate its loss. The training set results are
+					// then either already inspected (bOptFBErrCalcThisEpoch) or the observer doesn't need them
+					const bool bNoTrainSetFProp = bOptFBErrCalcThisEpoch || bBatchLossThisEpoch;
+					real_t batchLossSum(0);
+					outpLayer.calc_loss_in_bprop(bBatchLossThisEpoch);
+
+					if (bSeekRng) get_iRng().seek_epoch(opts.rngEpochOffset() + epochIdx);
 
 					auto vRowIdxIt = vRowIdxs.begin();
 					if (bMiniBatch) {
+						//the permutation of a sought epoch mustn't depend on the previous ones
+						if (bSeekRng) ::std::iota(vRowIdxIt, vRowIdxs.end(), 0);
 						//making random permutations to define which data rows will be used as batch data
 						::std::random_shuffle(vRowIdxIt, vRowIdxs.end(), get_iRng());
 					}
 
 					for (vec_len_t batchIdx = 0; batchIdx < numBatches; ++batchIdx) {
 						iI.train_batchBegin(batchIdx);
+						get_iRng().on_train_batch_begin();
 
 						if (bMiniBatch) {
-							get_iMath().mExtractRows(train_x, vRowIdxIt, batch_x);
-							get_iMath().mExtractRows(train_y, vRowIdxIt, batch_y);
+							if (bPrefetch && batchIdx > 0) {
+								m_pPrefetcher->exec_wait();
+								::std::swap(pBatchX, pNextBatchX);
+								::std::swap(pBatchY, pNextBatchY);
+							} else {
+								if (!_extract_batch_x(train_x, vRowIdxIt, *pBatchX))
+									return _set_last_error(ErrorCode::CantAllocateMemoryForTempData);
+								get_iMath().mExtractRows(train_y, vRowIdxIt, *pBatchY);
+							}
 							vRowIdxIt += batchSize;
+
+							if (bPrefetch && batchIdx + 1 < numBatches) {
+								prefetchIt = vRowIdxIt;
+								m_pPrefetcher->exec_async(fnPrefetch);
+							}
 						}
+						auto& batch_x = *pBatchX;
+						auto& batch_y = *pBatchY;
 
-						iI.train_preFprop(batch_x);
+						iI.train_preFprop(math::dense_or_empty(batch_x));
 						m_Layers.fprop(batch_x);
 
 						if (bOptFBErrCalcThisEpoch) {
 							if (m_bCalcFullLossValue) m_Layers.prepToCalcLossAddendum();
-							trainLoss = _calcLossNotifyInspector(nullptr, batch_y, true);
+							trainLoss = _calcLossNotifyInspector<XMtxT>(nullptr, batch_y, true);
 							//we don't need to call set_mode_and_batch_size(0) here because we did not do fprop() in _calcLoss()
 							if (bInspectEpoch) opts.observer().inspect_results(epochIdx, train_y, false, *this);
 						}
 
 						iI.train_preBprop(batch_y);
 						m_Layers.bprop(batch_y);
+						if (bBatchLossThisEpoch) batchLossSum += outpLayer.bprop_loss();
 
 						iI.train_batchEnd();
 					}
 
 					if (bCalcLoss) {
-						if (!bOptFBErrCalcThisEpoch) {
+						if (bBatchLossThisEpoch) {
+							//every batch has the same size, so the mean of batch losses is the loss over the training set
+							trainLoss = batchLossSum / numBatches;
+							if (m_bCalcFullLossValue) {
+								//activations dependent addendums are computed over the last batch
+								m_Layers.prepToCalcLossAddendum();
+								trainLoss += m_Layers.calcLossAddendum();
+							}
+						} else if (!bOptFBErrCalcThisEpoch) {
 							if (m_bCalcFullLossValue) m_Layers.prepToCalcLossAddendum();
 							trainLoss = _calcLossNotifyInspector(&train_x, train_y, true);
 						}
@@ -488,14 +693,15 @@ namespace nntl {
 								//saving training results
 								auto& trr = opts.NNEvalFinalResults().trainSet;
 								trr.lossValue = trainLoss;
-								//we can call output_layer().get_activations() here because for the last epoch
-								// bOptFBErrCalcThisEpoch is always ==false
+								//we can call output_layer().get_activations() here because for the last epoch with
+								// bSaveNNEvalResults both bOptFBErrCalcThisEpoch and bBatchLossThisEpoch are false, so the
+								// training set has just been fprop()'ed
 								m_Layers.output_layer().get_activations().clone_to(trr.output_activations);
 								pTestEvalRes = &opts.NNEvalFinalResults().testSet;
 							}
 							
 							_report_training_fragment<bPrioritizeThreads>(epochIdx, trainLoss, td
-								, epochPeriodEnds - epochPeriodBeginsAt, opts.observer(), bOptFBErrCalcThisEpoch, pTestEvalRes);
+								, epochPeriodEnds - epochPeriodBeginsAt, opts.observer(), bNoTrainSetFProp, pTestEvalRes);
 
 							epochPeriodBeginsAt = epochPeriodEnds;//restarting period timer
 						}
@@ -515,7 +721,7 @@ namespace nntl {
 					//if (! ::std::forward<OnEpochEndCbT>(onEpochEndCB)(*this, opts, epochIdx)) break;
 					if (!onEpochEndCB(*this, opts, epochIdx)) break;//mustn't forward here, onEpochEndCB is called multiple times
 
-					if (bCalcLoss && (bInspectEpoch || !bOptFBErrCalcThisEpoch)) {
+					if (bCalcLoss && (bInspectEpoch || !bNoTrainSetFProp)) {
 						set_mode_and_batch_size(0);//restoring training mode after _calcLoss()
 						//moved the set_mode_and_batch_size() here after the call to onEpochEndCB() to allow onEpochEndCB to call this->fprop() on
 						//any auxiliary (real test) dataset
@@ -539,7 +745,8 @@ namespace nntl {
 			m_Layers.fprop(data_x);
 		}
 
-		ErrorCode fprop(const realmtx_t& data_x)noexcept {
+		template<typename XMtxT>
+		ErrorCode fprop(const XMtxT& data_x)noexcept {
 			const auto ec = _init(data_x.rows());
 			if (ErrorCode::Success != ec) return _set_last_error(ec);
 
@@ -547,7 +754,8 @@ namespace nntl {
 			return _set_last_error(ec);
 		}
 
-		ErrorCode calcLoss(const realmtx_t& data_x, const realmtx_t& data_y, real_t& lossVal) noexcept {
+		template<typename XMtxT>
+		ErrorCode calcLoss(const XMtxT& data_x, const realmtx_t& data_y, real_t& lossVal) noexcept {
 			NNTL_ASSERT(data_x.rows() == data_y.rows());
 
 			auto ec = _init(data_x.rows());
@@ -558,7 +766,8 @@ namespace nntl {
 			return _set_last_error(ec);
 		}
 
-		ErrorCode eval(const realmtx_t& data_x, const realmtx_t& data_y, nnet_eval_results<real_t>& res)noexcept {
+		template<typename XMtxT>
+		ErrorCode eval(const XMtxT& data_x, const realmtx_t& data_y, nnet_eval_results<real_t>& res)noexcept {
 			NNTL_ASSERT(data_x.rows() == data_y.rows());
 
 			auto ec = _init(data_x.rows());
@@ -571,7 +780,8 @@ namespace nntl {
 			return _set_last_error(ec);
 		}
 
-		ErrorCode td_eval(train_data_t& td, nnet_td_eval_results<real_t>& res)noexcept {
+		template<typename XMtxT>
+		ErrorCode td_eval(train_data<real_t, XMtxT>& td, nnet_td_eval_results<real_t>& res)noexcept {
 			auto ec = eval(td.train_x(), td.train_y(), res.trainSet);
 			if (ec != ErrorCode::Success) return ec;
 			
@@ -957,7 +1167,7 @@ namespace nntl {
 				m_nn.m_Layers.prepToCalcLossAddendum();//cleanup cached loss version to always recalculate it from scratch, because we aren't interested in any cheats here.
 				if (m_ngcSetts.bForceSeed) m_nn.get_iRng().seed64(s);
 				m_nn.m_Layers.fprop(m_data.batchX());
-				return m_nn._calcLoss(nullptr, m_data.batchY());
+				return m_nn.template _calcLoss<realmtx_t>(nullptr, m_data.batchY());
 			}
 		};
 
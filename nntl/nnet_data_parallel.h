@@ -0,0 +1,561 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//Data parallel training of several replicas of the same architecture on a single machine.
+// nnet::train() uses the cores only inside the individual math kernels, which scales badly for mid-sized layers. Here
+// every replica is a separate nnet object with its own iMath (and therefore its own pool of threads limited to a slice of
+// cores), its own iRng and its own layers. The replicas process different minibatches of the same epoch concurrently:
+// the shuffled batches are dealt round-robin, i.e. the batch b goes to the replica b % N.
+// The replica #0 is the primary one: it shuffles the data, its weights are the result of the training, and the training
+// observer, the epoch level callback and the inspector reporting all work through it.
+//
+// The way the replicas combine their learning is selected by the policy:
+// - data_parallel::Hogwild - all replicas update the very same weights (owned by the primary) without any locking;
+// - data_parallel::TreeAveraging - every replica trains its own copy of the weights, the copies are periodically averaged.
+//
+// Requirements:
+// - replicas must be constructed with their own iMath and iRng objects, and the iRng mustn't use any process wide state
+//		(so the rng::CStd isn't suitable). Seed the iRngs differently.
+// - the thread pool of every replica's iMath must have at most cores_per_replica() threads, otherwise the replicas
+//		oversubscribe the cores. Construct it with the threads count, i.e. iMath_t iM(data_parallel::cores_per_replica(N))
+//		and make_nnet(lp, iM).
+// - layers of a replica must be separate objects and every weighted layer (the one with grad_works_t) must have the same
+//		shape across replicas. Settings of layers (learning rates, regularizers, dropout) should be the same, use
+//		for_each_replica() to change them during the training.
+// - only dense training data is supported and the minibatch mode is mandatory.
+
+#include "nnet.h"
+#include "interface/threads/bgworkers.h"
+
+namespace nntl {
+
+	namespace data_parallel {
+		//Hogwild! (Niu et al. 2011): the replicas train the weights of the primary replica in place, concurrently and without
+		// any synchronization. Gradient works state (momentums, Adam moments, etc.) remains per replica.
+		// Has no synchronization cost at all, but the results aren't reproducible and a too large learning rate might
+		// diverge more easily than in the single replica case.
+		struct Hogwild {
+			static constexpr bool bSharedWeights = true;
+		};
+
+		//Every replica trains its own copy of the weights. Every sync_every() rounds of minibatches (one round is a minibatch
+		// for every replica) and at the end of every epoch the copies are averaged and the mean is broadcasted back.
+		// The sum is made by a pairwise tree reduction: log2(N) steps, each step adds disjoint pairs of replicas concurrently
+		// on the receiving replica thread pool.
+		// With sync_every()==1 and a linear update rule (plain SGD or momentum) this is exactly a synchronous SGD with the
+		// gradient averaged over N minibatches. For adaptive optimizers it's an approximation.
+		struct TreeAveraging {
+			static constexpr bool bSharedWeights = false;
+		};
+
+		//the default nnet_data_parallel::cores_per_replica(): the hardware threads divided evenly between replicasCnt replicas
+		inline thread_id_t cores_per_replica(const size_t replicasCnt)noexcept {
+			NNTL_ASSERT(replicasCnt);
+			const auto hc = ::std::max(1u, ::std::thread::hardware_concurrency());
+			return ::std::max(thread_id_t(1), static_cast<thread_id_t>(hc / ::std::max(size_t(1), replicasCnt)));
+		}
+	}
+
+	namespace _impl {
+		//collects pointers to weight matrices of every layer with grad works in the order of for_each_layer()
+		template<typename RealmtxT>
+		struct dp_collect_weights {
+			::std::vector<RealmtxT*>& vW;
+
+			dp_collect_weights(::std::vector<RealmtxT*>& v)noexcept : vW(v) {}
+
+			template<typename _L> ::std::enable_if_t<layer_has_gradworks<_L>::value> operator()(_L& l)noexcept {
+				vW.push_back(&l.get_weights());
+			}
+			template<typename _L> ::std::enable_if_t<!layer_has_gradworks<_L>::value> operator()(_L&)noexcept {}
+		};
+
+		//makes the weights of every layer with grad works either a view of the corresponding matrix of vSrc (bView==true),
+		// or an own copy of its current weights (vSrc isn't used then)
+		template<typename RealmtxT>
+		struct dp_replace_weights {
+			const ::std::vector<RealmtxT*>& vSrc;
+			size_t idx;
+			const bool bView;
+			bool bOk;
+
+			dp_replace_weights(const ::std::vector<RealmtxT*>& v, const bool bV)noexcept : vSrc(v), idx(0), bView(bV), bOk(true) {}
+
+			template<typename _L> ::std::enable_if_t<layer_has_gradworks<_L>::value> operator()(_L& l)noexcept {
+				RealmtxT W;
+				if (bView) {
+					NNTL_ASSERT(idx < vSrc.size());
+					auto& src = *vSrc[idx++];
+					W.useExternalStorage(src.data(), src.rows(), src.cols());
+				} else {
+					const auto& cur = l.get_weights();
+					if (!cur.bDontManageStorage()) return;
+					if (!cur.clone_to(W)) {
+						bOk = false;
+						return;
+					}
+				}
+				if (!l.set_weights(::std::move(W))) bOk = false;
+			}
+			template<typename _L> ::std::enable_if_t<!layer_has_gradworks<_L>::value> operator()(_L&)noexcept {}
+		};
+	}
+
+	template<typename NNetT, typename PolicyT = data_parallel::TreeAveraging>
+	class nnet_data_parallel : public _has_last_error<_nnet_errs> {
+	public:
+		typedef NNetT nnet_t;
+		typedef PolicyT policy_t;
+		static constexpr bool bSharedWeights = policy_t::bSharedWeights;
+
+		typedef typename nnet_t::real_t real_t;
+		typedef typename nnet_t::realmtx_t realmtx_t;
+		typedef typename nnet_t::iThreads_t iThreads_t;
+		typedef typename realmtx_t::vec_len_t vec_len_t;
+
+		typedef threads::numa::pin_workers<iThreads_t> pin_workers_t;
+
+	protected:
+		//[0] is the primary replica
+		::std::vector<nnet_t*> m_replicas;
+		//m_weights[r][k] is the weight matrix of the k-th layer with grad works of the replica r. Valid only during train()
+		::std::vector<::std::vector<realmtx_t*>> m_weights;
+		//m_pins[r] pins the replica r driving thread and its worker threads. Made and destroyed by the driving thread
+		::std::vector<::std::unique_ptr<pin_workers_t>> m_pins;
+		//the thread #r-1 drives the replica r, the primary is driven by the thread that called train()
+		::std::unique_ptr<threads::BgWorkers<>> m_pDrivers;
+
+		thread_id_t m_coresPerReplica;
+		unsigned m_syncEvery;
+		bool m_bPin;
+
+	public:
+		//no user-declared destructor, the object must remain movable to be returned from make_nnet_data_parallel()
+
+		//replicas[0] is the primary. coresPerReplica==0 divides the hardware threads evenly between the replicas
+		nnet_data_parallel(const ::std::vector<nnet_t*>& replicas, const thread_id_t coresPerReplica = 0)noexcept
+			: m_replicas(replicas), m_syncEvery(1), m_bPin(false)
+		{
+			NNTL_ASSERT(!m_replicas.empty());
+			cores_per_replica(coresPerReplica);
+		}
+
+		size_t replicas_count()const noexcept { return m_replicas.size(); }
+		nnet_t& primary()const noexcept { return *m_replicas[0]; }
+		nnet_t& replica(const size_t r)const noexcept { NNTL_ASSERT(r < m_replicas.size()); return *m_replicas[r]; }
+
+		//applies f(nnet_t&) to every replica. Use it to change the settings of layers (such as learning rates) during
+		// the training, because the epoch end callback receives the primary replica only
+		template<typename F>
+		void for_each_replica(F&& f)noexcept {
+			for (auto p : m_replicas) f(*p);
+		}
+
+		//number of threads (including the driving thread) the iMath of every replica has. It's the size of the slice of
+		// CPUs every replica is pinned to, and train() checks the replicas' thread pools aren't bigger
+		nnet_data_parallel& cores_per_replica(const thread_id_t n)noexcept {
+			m_coresPerReplica = n ? n : data_parallel::cores_per_replica(m_replicas.size());
+			return *this;
+		}
+		thread_id_t cores_per_replica()const noexcept { return m_coresPerReplica; }
+
+		//TreeAveraging only: how many rounds of minibatches are done between weights averaging. Must be >0
+		nnet_data_parallel& sync_every(const unsigned n)noexcept {
+			NNTL_ASSERT(n > 0);
+			m_syncEvery = n ? n : 1;
+			return *this;
+		}
+		unsigned sync_every()const noexcept { return m_syncEvery; }
+
+		//pins every replica (its driving thread and its iMath workers) to its own slice of cores_per_replica() CPUs in
+		// the threads::numa::PinOrder::Compact order, so the replicas don't disturb each other. Off by default
+		nnet_data_parallel& pin_replicas(const bool b)noexcept { m_bPin = b; return *this; }
+		bool pin_replicas()const noexcept { return m_bPin; }
+
+	protected:
+		bool _replicas_ok()const noexcept {
+			const size_t N = m_replicas.size();
+			for (size_t r = 0; r < N; ++r) {
+				if (!m_replicas[r]) return false;
+				for (size_t q = 0; q < r; ++q) {
+					if (m_replicas[q] == m_replicas[r]
+						|| &m_replicas[q]->get_layer_pack() == &m_replicas[r]->get_layer_pack()
+						|| &m_replicas[q]->get_iMath() == &m_replicas[r]->get_iMath()
+						|| &m_replicas[q]->get_iRng() == &m_replicas[r]->get_iRng())
+						return false;
+				}
+			}
+			return true;
+		}
+
+		bool _replica_pools_ok()const noexcept {
+			for (auto p : m_replicas) {
+				thread_id_t workersCnt = 0;
+				p->get_iMath().ithreads().get_worker_threads(workersCnt);
+				if (workersCnt + 1 > m_coresPerReplica) return false;
+			}
+			return true;
+		}
+
+		//runs f(r) for every replica r concurrently on its driving thread and waits for all of them
+		template<typename F>
+		void _run_replicas(F& f)noexcept {
+			if (m_replicas.size() > 1) {
+				auto fnDrv = [&f](const thread_id_t t)noexcept {
+					f(static_cast<size_t>(t) + 1);
+				};
+				m_pDrivers->exec_async(fnDrv);
+				f(0);
+				m_pDrivers->exec_wait();
+			} else f(0);
+		}
+
+		bool _collect_weights()noexcept {
+			const size_t N = m_replicas.size();
+			m_weights.resize(N);
+			for (size_t r = 0; r < N; ++r) {
+				m_weights[r].clear();
+				m_replicas[r]->get_layer_pack().for_each_layer(_impl::dp_collect_weights<realmtx_t>(m_weights[r]));
+			}
+			const auto& w0 = m_weights[0];
+			for (size_t r = 1; r < N; ++r) {
+				const auto& w = m_weights[r];
+				if (w.size() != w0.size()) return false;
+				for (size_t k = 0; k < w.size(); ++k) {
+					if (w[k]->size() != w0[k]->size()) return false;
+				}
+			}
+			return true;
+		}
+
+		//Hogwild: bShare==true makes weights of the replicas views of the primary's weights, bShare==false gives the replicas
+		// their own copies back
+		bool _share_weights(const bool bShare)noexcept {
+			bool bRet = true;
+			for (size_t r = 1; r < m_replicas.size(); ++r) {
+				_impl::dp_replace_weights<realmtx_t> rw(m_weights[0], bShare);
+				m_replicas[r]->get_layer_pack().for_each_layer(rw);
+				bRet = bRet && rw.bOk;
+			}
+			return bRet;
+		}
+
+		//copies the primary's weights to every other replica
+		void _broadcast_weights()noexcept {
+			auto fnCopy = [this](const size_t r)noexcept {
+				if (r) {
+					const auto& w0 = m_weights[0];
+					auto& w = m_weights[r];
+					for (size_t k = 0; k < w.size(); ++k) {
+						const auto bCopied = w0[k]->copy_to(*w[k]);
+						NNTL_ASSERT(bCopied); NNTL_UNREF(bCopied);
+					}
+				}
+			};
+			_run_replicas(fnCopy);
+		}
+
+		//TreeAveraging: the primary gets the mean of the weights of all replicas that is then broadcasted
+		void _average_weights()noexcept {
+			const size_t N = m_replicas.size();
+			if (N < 2) return;
+
+			//at the step s the replica r (such that r%(2s)==0) adds the weights of the replica r+s. Pairs are disjoint,
+			// so they're processed concurrently
+			for (size_t s = 1; s < N; s *= 2) {
+				auto fnAdd = [this, s, N](const size_t r)noexcept {
+					if (0 == r % (2 * s) && r + s < N) {
+						auto& iM = m_replicas[r]->get_iMath();
+						auto& w = m_weights[r];
+						const auto& wSrc = m_weights[r + s];
+						for (size_t k = 0; k < w.size(); ++k) iM.evAdd_ip(*w[k], *wSrc[k]);
+					}
+				};
+				_run_replicas(fnAdd);
+			}
+
+			auto& iM = primary().get_iMath();
+			const real_t scale = real_t(1) / static_cast<real_t>(N);
+			for (auto pW : m_weights[0]) iM.evMulC_ip(*pW, scale);
+
+			_broadcast_weights();
+		}
+
+		//every replica gets cores_per_replica() CPUs of the compact order, wrapping around if there isn't enough of them
+		::std::vector<threads::numa::cpu_t> _cpu_slice(const size_t r)const noexcept {
+			const threads::numa::topology topo;
+			const auto order = topo.order(threads::numa::PinOrder::Compact);
+			::std::vector<threads::numa::cpu_t> ret;
+			if (!order.empty()) {
+				for (size_t i = 0; i < m_coresPerReplica; ++i) ret.push_back(order[(r*m_coresPerReplica + i) % order.size()]);
+			}
+			return ret;
+		}
+
+		//single training step of the replica nn over the minibatch #batchIdx of the current epoch permutation.
+		// Returns false if failed to extract the minibatch
+		template<typename SeqT>
+		static bool _train_batch(nnet_t& nn, const vec_len_t batchIdx, const SeqT& vRowIdxs, const vec_len_t batchSize
+			, const realmtx_t& train_x, const realmtx_t& train_y)noexcept
+		{
+			auto& iI = nn.get_iInspect();
+			iI.train_batchBegin(batchIdx);
+			nn.get_iRng().on_train_batch_begin();
+
+			const auto rowIdxIt = vRowIdxs.cbegin() + static_cast<size_t>(batchIdx)*batchSize;
+			if (!nn._extract_batch_x(train_x, rowIdxIt, nn.m_batch_x)) return false;
+			nn.get_iMath().mExtractRows(train_y, rowIdxIt, nn.m_batch_y);
+
+			iI.train_preFprop(nn.m_batch_x);
+			nn.m_Layers.fprop(nn.m_batch_x);
+
+			iI.train_preBprop(nn.m_batch_y);
+			nn.m_Layers.bprop(nn.m_batch_y);
+
+			iI.train_batchEnd();
+			return true;
+		}
+
+	public:
+		//mirrors nnet::train() for dense data with following differences:
+		// - minibatches are mandatory and opts.prefetchBatches(), opts.trainLossFromBatches() and
+		//		opts.dropFProp4FullBatchErrorCalc() aren't used;
+		// - the training set loss is evaluated by the primary replica with an additional fprop() over the training set;
+		// - onEpochEndCB gets the primary replica.
+		template <bool bPrioritizeThreads = true, typename TrainOptsT, typename OnEpochEndCbT = NNetCB_OnEpochEnd_Dummy>
+		ErrorCode train(train_data<real_t>& td, TrainOptsT& opts, OnEpochEndCbT&& onEpochEndCB = NNetCB_OnEpochEnd_Dummy())noexcept
+		{
+			typedef ::std::conditional_t<bPrioritizeThreads
+				, threads::prioritize_workers<threads::PriorityClass::Working, iThreads_t>
+				, threads::_impl::prioritize_workers_dummy<threads::PriorityClass::Normal, iThreads_t>> PW_t;
+
+			global_denormalized_floats_mode();
+
+			if (td.empty()) return _set_last_error(ErrorCode::InvalidTD);
+			if (!_replicas_ok()) return _set_last_error(ErrorCode::InvalidReplicas);
+			if (!_replica_pools_ok()) return _set_last_error(ErrorCode::ReplicaPoolTooBig);
+
+			const size_t N = m_replicas.size();
+			auto& nnP = primary();
+			auto& iI = nnP.get_iInspect();
+			const auto& train_x = td.train_x();
+			const auto& train_y = td.train_y();
+			const vec_len_t samplesCount = train_x.rows();
+			NNTL_ASSERT(samplesCount == train_y.rows());
+			NNTL_ASSERT(train_x.emulatesBiases() && td.test_x().emulatesBiases());
+
+			if (train_x.cols_no_bias() != nnP.m_Layers.input_layer().get_neurons_cnt()) return _set_last_error(ErrorCode::InvalidInputLayerNeuronsCount);
+			if (train_y.cols() != nnP.m_Layers.output_layer().get_neurons_cnt()) return _set_last_error(ErrorCode::InvalidOutputLayerNeuronsCount);
+
+			const vec_len_t batchSize = opts.batchSize();
+			if (0 == batchSize || batchSize >= samplesCount) return _set_last_error(ErrorCode::MiniBatchRequired);
+			if (!nnP._batchSizeOk(td, batchSize)) return _set_last_error(ErrorCode::BatchSizeMustBeMultipleOfTrainDataLength);
+
+			const bool bSaveNNEvalResults = opts.evalNNFinalPerf();
+			const size_t maxEpoch = opts.maxEpoch();
+			const auto lastEpoch = maxEpoch - 1;
+			const vec_len_t numBatches = samplesCount / batchSize;
+			//a round is a minibatch for every replica. The last round of an epoch may be incomplete
+			const vec_len_t numRounds = static_cast<vec_len_t>((numBatches + N - 1) / N);
+			//with the shared weights there's nothing to synchronize, so every replica runs the whole epoch at once
+			const vec_len_t roundsPerSync = bSharedWeights ? numRounds : static_cast<vec_len_t>(m_syncEvery);
+
+			//////////////////////////////////////////////////////////////////////////
+			//the primary evaluates the whole training and test sets, others need the memory just for a minibatch
+			const vec_len_t biggestFprop = ::std::max(samplesCount, td.test_x().rows());
+			for (size_t r = 0; r < N; ++r) {
+				auto& nn = *m_replicas[r];
+				nn.m_bCalcFullLossValue = opts.calcFullLossValue();
+				const auto ec = nn._init(r ? batchSize : biggestFprop, batchSize, true, maxEpoch, numBatches);
+				if (ErrorCode::Success != ec) return _set_last_error(ec);
+				if (nn.m_bCalcFullLossValue) nn.m_bCalcFullLossValue = nn.m_LMR.bHasLossAddendum;
+			}
+			utils::scope_exit layers_deinit([this, &opts]() {
+				if (opts.ImmediatelyDeinit()) {
+					for (auto p : m_replicas) p->_deinit();
+				}
+			});
+
+			if (!_collect_weights()) return _set_last_error(ErrorCode::InvalidReplicas);
+			utils::scope_exit weights_release([this]() {
+				if (bSharedWeights) {
+					const auto bDetached = _share_weights(false);
+					NNTL_ASSERT(bDetached || !"Failed to give the replicas their own weights back");
+					NNTL_UNREF(bDetached);
+				}
+				m_weights.clear();
+			});
+
+			//////////////////////////////////////////////////////////////////////////
+			//threads setup
+			if (N > 1 && (!m_pDrivers || m_pDrivers->workers_count() != N - 1)) {
+				m_pDrivers.reset(new(::std::nothrow) threads::BgWorkers<>(static_cast<thread_id_t>(N - 1)
+					, threads::PriorityClass::threads_priority_no_change));
+				if (!m_pDrivers) return _set_last_error(ErrorCode::CantAllocateMemoryForTempData);
+			}
+
+			m_pins.resize(N);
+			auto fnSetupDriver = [this](const size_t r)noexcept {
+				global_denormalized_floats_mode();
+				if (m_bPin) {
+					const auto slice = _cpu_slice(r);
+					if (!slice.empty()) m_pins[r].reset(new(::std::nothrow) pin_workers_t(m_replicas[r]->get_iMath().ithreads(), slice));
+				}
+			};
+			_run_replicas(fnSetupDriver);
+			utils::scope_exit threads_restore([this]() {
+				//pin_workers restores the affinity of the thread that destroys it, so it must be the driving thread
+				auto fnUnpin = [this](const size_t r)noexcept {
+					m_pins[r].reset();
+				};
+				_run_replicas(fnUnpin);
+			});
+
+			//every replica starts from the primary's weights
+			if (bSharedWeights) {
+				if (!_share_weights(true)) return _set_last_error(ErrorCode::InvalidReplicas);
+			} else _broadcast_weights();
+
+			//////////////////////////////////////////////////////////////////////////
+			::std::vector<vec_len_t> vRowIdxs(samplesCount);
+			::std::iota(vRowIdxs.begin(), vRowIdxs.end(), 0);
+
+			const auto& cee = opts.getCondEpochEval();
+			const auto divergenceCheckLastEpoch = opts.divergenceCheckLastEpoch();
+			const bool bSeekRng = opts.seekRngEachEpoch();
+
+			if (bSaveNNEvalResults) opts.getCondEpochEval().verbose(lastEpoch);
+
+			if (!opts.observer().init(maxEpoch, train_y, td.test_y(), nnP.get_iMath())) return _set_last_error(ErrorCode::CantInitializeObserver);
+			utils::scope_exit observer_deinit([&opts]() {
+				opts.observer().deinit();
+			});
+
+			opts.observer().on_training_start(samplesCount, td.test_x().rows(), train_x.cols_no_bias(), train_y.cols(), batchSize
+				, nnP.m_LMR.totalParamsToLearn);
+
+			if (nnP.m_bCalcFullLossValue) nnP.m_Layers.prepToCalcLossAddendum();
+			{
+				const auto lv = nnP._calcLossNotifyInspector(&train_x, train_y, true);
+				nnP.template _report_training_fragment<bPrioritizeThreads>(static_cast<size_t>(-1), lv, td, ::std::chrono::nanoseconds(0), opts.observer());
+			}
+			for (auto p : m_replicas) p->set_mode_and_batch_size(0);
+
+			nnet_eval_results<real_t>* pTestEvalRes = nullptr;
+
+			const auto trainingBeginsAt = ::std::chrono::steady_clock::now();
+			auto epochPeriodBeginsAt = ::std::chrono::steady_clock::now();
+
+			{
+				PW_t pw(nnP.get_iMath().ithreads());
+
+				vec_len_t roundBeg = 0, roundEnd = 0;
+				//vFailed[r] is set if the replica r failed to extract a minibatch
+				::std::vector<char> vFailed(N, 0);
+				auto fnTrain = [this, N, numBatches, batchSize, &roundBeg, &roundEnd, &vRowIdxs, &train_x, &train_y, &vFailed](const size_t r)noexcept {
+					auto& nn = *m_replicas[r];
+					for (vec_len_t rnd = roundBeg; rnd < roundEnd; ++rnd) {
+						const size_t batchIdx = static_cast<size_t>(rnd)*N + r;
+						if (batchIdx >= static_cast<size_t>(numBatches)) break;
+						if (!_train_batch(nn, static_cast<vec_len_t>(batchIdx), vRowIdxs, batchSize, train_x, train_y)) {
+							vFailed[r] = 1;
+							break;
+						}
+					}
+				};
+
+				for (size_t epochIdx = 0; epochIdx < maxEpoch; ++epochIdx) {
+					for (auto p : m_replicas) p->get_iInspect().train_epochBegin(epochIdx);
+
+					const bool bInspectEpoch = cee(epochIdx);
+					const bool bCheckForDivergence = epochIdx < divergenceCheckLastEpoch;
+					const bool bCalcLoss = bInspectEpoch || bCheckForDivergence;
+					const bool bLastEpoch = epochIdx == lastEpoch;
+
+					if (bSeekRng) {
+						for (auto p : m_replicas) p->get_iRng().seek_epoch(opts.rngEpochOffset() + epochIdx);
+						::std::iota(vRowIdxs.begin(), vRowIdxs.end(), 0);
+					}
+					::std::random_shuffle(vRowIdxs.begin(), vRowIdxs.end(), nnP.get_iRng());
+
+					for (roundBeg = 0; roundBeg < numRounds; roundBeg = roundEnd) {
+						roundEnd = ::std::min(numRounds, static_cast<vec_len_t>(roundBeg + roundsPerSync));
+						_run_replicas(fnTrain);
+						if (::std::any_of(vFailed.begin(), vFailed.end(), [](const char f)noexcept {return !!f; }))
+							return _set_last_error(ErrorCode::CantAllocateMemoryForTempData);
+						if (!bSharedWeights) _average_weights();
+					}
+
+					if (bCalcLoss) {
+						if (nnP.m_bCalcFullLossValue) nnP.m_Layers.prepToCalcLossAddendum();
+						const auto trainLoss = nnP._calcLossNotifyInspector(&train_x, train_y, true);
+						if (bCheckForDivergence && trainLoss >= opts.divergenceCheckThreshold())
+							return _set_last_error(ErrorCode::NNDiverged);
+
+						if (bInspectEpoch) {
+							const auto epochPeriodEnds = ::std::chrono::steady_clock::now();
+
+							if (bSaveNNEvalResults && bLastEpoch) {
+								auto& trr = opts.NNEvalFinalResults().trainSet;
+								trr.lossValue = trainLoss;
+								nnP.m_Layers.output_layer().get_activations().clone_to(trr.output_activations);
+								pTestEvalRes = &opts.NNEvalFinalResults().testSet;
+							}
+
+							nnP.template _report_training_fragment<bPrioritizeThreads>(epochIdx, trainLoss, td
+								, epochPeriodEnds - epochPeriodBeginsAt, opts.observer(), false, pTestEvalRes);
+
+							epochPeriodBeginsAt = epochPeriodEnds;
+						}
+					}
+
+					for (auto p : m_replicas) p->get_iInspect().train_epochEnd();
+
+					if (!onEpochEndCB(nnP, opts, epochIdx)) break;
+
+					if (bCalcLoss) nnP.set_mode_and_batch_size(0);
+				}
+			}
+			opts.observer().on_training_end(::std::chrono::steady_clock::now() - trainingBeginsAt);
+
+			return _set_last_error(ErrorCode::Success);
+		}
+	};
+
+	template<typename PolicyT = data_parallel::TreeAveraging, typename NNetT = void>
+	inline nnet_data_parallel<NNetT, PolicyT> make_nnet_data_parallel(const ::std::vector<NNetT*>& replicas
+		, const thread_id_t coresPerReplica = 0)noexcept
+	{
+		return nnet_data_parallel<NNetT, PolicyT>(replicas, coresPerReplica);
+	}
+}
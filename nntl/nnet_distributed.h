@@ -0,0 +1,219 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+//Multi-process (and multi-host) data parallel training. Every process (a rank) runs its own nnet::train() over its own
+// shard of the training data and after every minibatch the weight gradients of all layers are averaged over the ranks,
+// so all ranks keep the very same weights. It's a synchronous SGD with the effective batch size of
+// transport.size()*opts.batchSize().
+// Averaging of a layer's dL/dW starts as soon as its bprop() has computed it and runs on a background communication
+// thread (see distributed/grad_exchange.h) while the lower layers do their backward pass; the weights are updated at the
+// end of layers::bprop(). The averaging is a ring allreduce, optionally with the top-k or 1-bit gradient compression
+// (see distributed/allreduce.h).
+//
+// Transports (include the one you need):
+// - distributed/shm_ring.h - POSIX shared memory, for processes of a single host;
+// - distributed/tcp_ring.h - TCP (BSD sockets or Winsock), for several hosts (or the loopback interface).
+//
+// Requirements:
+// - every rank must have the same architecture, the same settings of layers and the same training options. Shards must
+//		have the same number of samples, the batch size, the number of epochs and the compression settings must match as
+//		well (train() checks it);
+// - the initial weights of the rank 0 are used;
+// - everything that decides whether to continue the training must be the same on every rank. onEpochEndCB results are
+//		combined (the training stops if any rank's callback returns false), but nnet::train() checks the divergence
+//		(opts.divergenceCheckThreshold()) with the loss of the local shard, so a rank may stop alone. The other ranks then
+//		fail with the transport timeout;
+// - observers and the inspector work on every rank, usually ranks other than 0 are given a silent observer;
+// - layer_pack_horizontal concurrent tasks mode (_LPH::concurrent_tasks()) isn't supported: inner layers would start
+//		their gradient exchanges from different threads in a nondeterministic order, while the collectives must be issued
+//		in the same order on every rank. train() returns ErrorCode::ConcurrentTasksUnsupported then.
+
+#include "nnet_data_parallel.h"
+#include "distributed/allreduce.h"
+#include "distributed/grad_exchange.h"
+
+namespace nntl {
+
+	namespace _impl {
+		template<typename GradExchT>
+		struct dist_set_grad_exchange {
+			GradExchT* pGE;
+
+			dist_set_grad_exchange(GradExchT* p)noexcept : pGE(p) {}
+
+			template<typename _L> ::std::enable_if_t<layer_has_gradworks<_L>::value> operator()(_L& l)noexcept {
+				l.get_gradWorks().set_grad_exchange(pGE);
+			}
+			template<typename _L> ::std::enable_if_t<!layer_has_gradworks<_L>::value> operator()(_L&)noexcept {}
+		};
+
+		template<typename _L, typename = ::std::void_t<>>
+		struct layer_has_concurrent_tasks : ::std::false_type {};
+		template<typename _L>
+		struct layer_has_concurrent_tasks<_L, ::std::void_t<decltype(::std::declval<const _L&>().concurrent_tasks_count())>> : ::std::true_type {};
+
+		//counts layers (packs) that are set to run their inner layers as concurrent tasks
+		struct dist_count_concurrent {
+			unsigned cnt;
+
+			dist_count_concurrent()noexcept : cnt(0) {}
+
+			template<typename _L> ::std::enable_if_t<layer_has_concurrent_tasks<_L>::value> operator()(_L& l)noexcept {
+				if (l.concurrent_tasks_count()) ++cnt;
+			}
+			template<typename _L> ::std::enable_if_t<!layer_has_concurrent_tasks<_L>::value> operator()(_L&)noexcept {}
+		};
+	}
+
+	template<typename NNetT, typename TransportT>
+	class nnet_distributed : public _has_last_error<_nnet_errs> {
+	public:
+		typedef NNetT nnet_t;
+		typedef TransportT transport_t;
+
+		typedef typename nnet_t::real_t real_t;
+		typedef typename nnet_t::realmtx_t realmtx_t;
+		typedef typename realmtx_t::vec_len_t vec_len_t;
+
+		typedef distributed::allreducer<transport_t, real_t> allreducer_t;
+		typedef distributed::grad_exchange<real_t> grad_exchange_t;
+
+	protected:
+		nnet_t& m_nn;
+		allreducer_t m_reducer;
+
+	public:
+		//no user-declared destructor, the object must remain movable to be returned from make_nnet_distributed()
+		nnet_distributed(nnet_t& nn, transport_t& tr)noexcept : m_nn(nn), m_reducer(tr) {}
+
+		nnet_t& get_nnet()const noexcept { return m_nn; }
+		transport_t& transport()const noexcept { return m_reducer.transport(); }
+		int rank()const noexcept { return transport().rank(); }
+		int size()const noexcept { return transport().size(); }
+
+		//the same compression must be set on every rank. topkRatio is the share of elements Compression::TopK sends
+		nnet_distributed& compression(const distributed::Compression c, const real_t topkRatio = real_t(.01))noexcept {
+			m_reducer.compression(c, topkRatio);
+			return *this;
+		}
+		distributed::Compression compression()const noexcept { return m_reducer.compression(); }
+		real_t topk_ratio()const noexcept { return m_reducer.topk_ratio(); }
+
+	protected:
+		//every rank must train the same way, otherwise the collectives would mismatch and hang until the timeout
+		template<typename TdT, typename TrainOptsT>
+		ErrorCode _check_setup(const TdT& td, const TrainOptsT& opts, const ::std::vector<realmtx_t*>& vW)noexcept {
+			uint64_t totalNumel = 0;
+			for (auto pW : vW) totalNumel += static_cast<uint64_t>(pW->numel());
+			//the ratio is compared bitwise, the compressed messages are sized by it
+			static_assert(sizeof(real_t) <= sizeof(uint64_t), "");
+			uint64_t ratioBits = 0;
+			const real_t ratio = topk_ratio();
+			::std::memcpy(&ratioBits, &ratio, sizeof(ratio));
+			const uint64_t setup[] = {
+				static_cast<uint64_t>(td.train_x().rows()), static_cast<uint64_t>(opts.batchSize())
+				, static_cast<uint64_t>(opts.maxEpoch()), static_cast<uint64_t>(vW.size()), totalNumel
+				, static_cast<uint64_t>(compression()), ratioBits
+			};
+			constexpr size_t K = sizeof(setup) / sizeof(setup[0]);
+
+			const size_t N = static_cast<size_t>(size());
+			::std::vector<uint64_t> all(N*K);
+			::std::copy(setup, setup + K, all.begin() + static_cast<size_t>(rank())*K);
+			if (!distributed::ring_allgather(transport(), all.data(), sizeof(setup))) return ErrorCode::TransportFailed;
+			for (size_t r = 0; r < N; ++r) {
+				if (!::std::equal(setup, setup + K, all.begin() + r*K)) return ErrorCode::RanksMismatch;
+			}
+			return ErrorCode::Success;
+		}
+
+	public:
+		//runs nnet::train() on the local shard td with the gradients averaged over all ranks. Every rank must call it
+		template <bool bPrioritizeThreads = true, typename TrainOptsT, typename OnEpochEndCbT = NNetCB_OnEpochEnd_Dummy
+			, typename XMtxT = math::smatrix_deform<real_t>>
+		ErrorCode train(train_data<real_t, XMtxT>& td, TrainOptsT& opts, OnEpochEndCbT&& onEpochEndCB = NNetCB_OnEpochEnd_Dummy())noexcept
+		{
+			//every rank has the same architecture, so every rank fails here without touching the transport
+			_impl::dist_count_concurrent cc;
+			m_nn.get_layer_pack().for_each_layer(cc);
+			if (cc.cnt) return _set_last_error(ErrorCode::ConcurrentTasksUnsupported);
+
+			auto& tr = transport();
+			if (!tr.connected() && !tr.connect()) return _set_last_error(ErrorCode::TransportFailed);
+			if (td.empty()) return _set_last_error(ErrorCode::InvalidTD);
+
+			//the weights must exist to be synchronized before the training
+			const vec_len_t batchSize = opts.batchSize();
+			auto ec = m_nn.init4fixedBatchFprop(batchSize ? batchSize : td.train_x().rows());
+			if (ErrorCode::Success != ec) return _set_last_error(ec);
+
+			::std::vector<realmtx_t*> vW;
+			m_nn.get_layer_pack().for_each_layer(_impl::dp_collect_weights<realmtx_t>(vW));
+			ec = _check_setup(td, opts, vW);
+			if (ErrorCode::Success != ec) return _set_last_error(ec);
+
+			//the sum with zeros is exact, so it's a broadcast of the rank 0 weights
+			const bool bRoot = 0 == rank();
+			for (auto pW : vW) {
+				if (!bRoot) pW->zeros();
+				if (!m_reducer.sum(pW->data(), static_cast<size_t>(pW->numel()))) return _set_last_error(ErrorCode::TransportFailed);
+			}
+
+			grad_exchange_t ge(&allreducer_t::mean_func, &m_reducer, m_reducer.needs_residual());
+			m_nn.get_layer_pack().for_each_layer(_impl::dist_set_grad_exchange<grad_exchange_t>(&ge));
+			utils::scope_exit detach_exchange([this]() {
+				m_nn.get_layer_pack().for_each_layer(_impl::dist_set_grad_exchange<grad_exchange_t>(nullptr));
+			});
+
+			//all averagings are complete by the end of an epoch, so the transport is free to use from this thread
+			bool bCommFailed = false;
+			auto fnEpochEnd = [this, &ge, &bCommFailed, &onEpochEndCB](auto& nn, auto& o, const size_t epochIdx)->bool {
+				real_t stop = onEpochEndCB(nn, o, epochIdx) ? real_t(0) : real_t(1);
+				if (ge.failed() || !m_reducer.sum(&stop, 1)) {
+					bCommFailed = true;
+					return false;
+				}
+				return stop == real_t(0);
+			};
+
+			ec = m_nn.template train<bPrioritizeThreads>(td, opts, fnEpochEnd);
+			if (ErrorCode::Success != ec) return _set_last_error(ec);
+			return _set_last_error(bCommFailed || ge.failed() ? ErrorCode::TransportFailed : ErrorCode::Success);
+		}
+	};
+
+	template<typename NNetT, typename TransportT>
+	inline nnet_distributed<NNetT, TransportT> make_nnet_distributed(NNetT& nn, TransportT& tr)noexcept {
+		return nnet_distributed<NNetT, TransportT>(nn, tr);
+	}
+}
@@ -123,6 +123,26 @@ namespace nntl {
 		//This will make error value report slightly wrong (errVal corresponds to the previous pass), but will make a significant speedup
 		bool m_bDropFProp4TrainingSetErrorCalculationWhileFullBatch;
 
+		//set this flag to true to get the training set loss value as the mean of minibatch losses, that are computed during bprop()
+		// by the output layer as a by-product of dL/dZ. This removes the additional fprop() over the whole training set,
+		// but the value is slightly different: it's computed in the training mode (i.e. with dropout and so on) and
+		// each minibatch is evaluated with the weights it had before its own update. The training set results can't be
+		// passed to observer's inspect_results() then, so for observers with bInspectsTrainResults==true the option
+		// applies only to epochs that aren't inspected (i.e. to the divergence checks)
+		bool m_bTrainLossFromBatches;
+
+		//set this flag to true to gather the next minibatch (for dense train_x only) on a background thread while the current
+		// one is being processed. Costs an additional pair of (batchSize, x_cols) and (batchSize, y_cols) matrices. Results
+		// are exactly the same as without prefetching. Ignored in full-batch mode and for sparse X data.
+		bool m_bPrefetchBatches;
+
+		//set this flag to true to seek the iRng to the epoch (m_RngEpochOffset + epochIdx) with iRng::seek_epoch() before
+		// each training epoch (the minibatch order is then made from scratch too). Then the random numbers of an epoch
+		// depend only on the rng seed and the epoch number, so a training restored from a checkpoint of the epoch N could
+		// be continued with m_RngEpochOffset==N+1 exactly as if it was never interrupted.
+		bool m_bSeekRngEachEpoch;
+		size_t m_RngEpochOffset;
+
 		void _ctor()noexcept {
 			m_BatchSize = 0;
 			m_DivergenceCheckLastEpoch = 5;
@@ -131,6 +151,10 @@ namespace nntl {
 			m_bImmediatelyDeinit = false;
 			m_pNNEvalFinalRes = nullptr;
 			m_bDropFProp4TrainingSetErrorCalculationWhileFullBatch = false;
+			m_bTrainLossFromBatches = false;
+			m_bPrefetchBatches = false;
+			m_bSeekRngEachEpoch = false;
+			m_RngEpochOffset = 0;
 		}
 
 	public:
@@ -167,6 +191,20 @@ namespace nntl {
 		self_t& dropFProp4FullBatchErrorCalc(bool f)noexcept { m_bDropFProp4TrainingSetErrorCalculationWhileFullBatch = f; return *this; }
 		bool dropFProp4FullBatchErrorCalc()const noexcept { return m_bDropFProp4TrainingSetErrorCalculationWhileFullBatch; }
 
+		self_t& trainLossFromBatches(bool f)noexcept { m_bTrainLossFromBatches = f; return *this; }
+		bool trainLossFromBatches()const noexcept { return m_bTrainLossFromBatches; }
+
+		self_t& prefetchBatches(bool f)noexcept { m_bPrefetchBatches = f; return *this; }
+		bool prefetchBatches()const noexcept { return m_bPrefetchBatches; }
+
+		self_t& seekRngEachEpoch(bool f, size_t epochOffset = 0)noexcept {
+			m_bSeekRngEachEpoch = f;
+			m_RngEpochOffset = epochOffset;
+			return *this;
+		}
+		bool seekRngEachEpoch()const noexcept { return m_bSeekRngEachEpoch; }
+		size_t rngEpochOffset()const noexcept { return m_RngEpochOffset; }
+
 		const bool evalNNFinalPerf()const noexcept { return !!m_pNNEvalFinalRes; }
 		nnet_td_eval_results<real_t>& NNEvalFinalResults()const noexcept { NNTL_ASSERT(m_pNNEvalFinalRes);			return *m_pNNEvalFinalRes; }
 		self_t& NNEvalFinalResults(nnet_td_eval_results<real_t>& er)noexcept { m_pNNEvalFinalRes = &er; 			return *this; }
@@ -54,3 +54,5 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "layer/pack_tile.h"
 #include "layer/extensions.h"
 #include "nnet.h"
+#include "nnet_data_parallel.h"
+#include "nnet_distributed.h"
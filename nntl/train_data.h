@@ -37,17 +37,28 @@ namespace nntl {
 
 
 	//dummy struct to handle training data
-	template<typename BaseT>
+	//XMtxT is the type of train_x/test_x. It's either math::smatrix_deform<BaseT>, or a sparse math::smatrix_csr<BaseT>
+	// (see smatrix_csr.h). The sparse data could be fed only to the fully connected layer that is placed directly on the
+	// top of layer_input
+	template<typename BaseT, typename XMtxT = math::smatrix_deform<BaseT>>
 	class train_data {
 	public:
 		typedef BaseT value_type;
 		typedef math::smatrix<value_type> mtx_t;
 		typedef math::smatrix_deform<value_type> mtxdef_t;
+		typedef math::smatrix_csr<value_type> mtx_csr_t;
+
+		typedef XMtxT x_mtx_t;
+		static constexpr bool bSparseX = ::std::is_same<x_mtx_t, mtx_csr_t>::value;
+		static_assert(bSparseX || ::std::is_same<x_mtx_t, mtxdef_t>::value, "XMtxT must be either smatrix_deform or smatrix_csr");
+		//the type that absorb() takes for the x data
+		typedef ::std::conditional_t<bSparseX, mtx_csr_t, mtx_t> x_src_t;
 
 		//////////////////////////////////////////////////////////////////////////
 		//members
 	protected:
-		mtxdef_t m_train_x, m_train_y, m_test_x, m_test_y;
+		x_mtx_t m_train_x, m_test_x;
+		mtxdef_t m_train_y, m_test_y;
 
 		//////////////////////////////////////////////////////////////////////////
 		//Serialization support
@@ -55,6 +66,7 @@ namespace nntl {
 		friend class ::boost::serialization::access;
 		template<class Archive>
 		void serialize(Archive & ar, const unsigned int ) {
+			static_assert(!bSparseX, "Sparse data serialization isn't implemented");
 			ar & serialization::make_nvp("train_x", m_train_x);
 			ar & serialization::make_nvp("train_y", m_train_y);
 			ar & serialization::make_nvp("test_x", m_test_x);
@@ -78,24 +90,24 @@ namespace nntl {
 			return m_train_x == rhs.m_train_x && m_train_y == rhs.m_train_y && m_test_x == rhs.m_test_x && m_test_y == rhs.m_test_y;
 		}
 
-		const mtxdef_t& train_x()const noexcept { return m_train_x; }
+		const x_mtx_t& train_x()const noexcept { return m_train_x; }
 		const mtxdef_t& train_y()const noexcept { return m_train_y; }
-		const mtxdef_t& test_x()const noexcept { return m_test_x; }
+		const x_mtx_t& test_x()const noexcept { return m_test_x; }
 		const mtxdef_t& test_y()const noexcept { return m_test_y; }
 
-		mtxdef_t& train_x()noexcept { return m_train_x; }
+		x_mtx_t& train_x()noexcept { return m_train_x; }
 		mtxdef_t& train_y()noexcept { return m_train_y; }
-		mtxdef_t& test_x()noexcept { return m_test_x; }
+		x_mtx_t& test_x()noexcept { return m_test_x; }
 		mtxdef_t& test_y()noexcept { return m_test_y; }
 
-		mtxdef_t& train_x_mutable() noexcept { return m_train_x; }
+		x_mtx_t& train_x_mutable() noexcept { return m_train_x; }
 		mtxdef_t& train_y_mutable() noexcept { return m_train_y; }
 
 		bool empty()const noexcept {
 			return m_train_x.empty() || m_train_y.empty() || m_test_x.empty() || m_test_y.empty();
 		}
 
-		bool absorb(mtx_t&& _train_x, mtx_t&& _train_y, mtx_t&& _test_x, mtx_t&& _test_y)noexcept{
+		bool absorb(x_src_t&& _train_x, mtx_t&& _train_y, x_src_t&& _test_x, mtx_t&& _test_y)noexcept{
 			//, const bool noBiasEmulationNecessary=false)noexcept {
 			
 			if (!absorbsion_will_succeed(_train_x, _train_y,_test_x,_test_y))  return false;
@@ -109,8 +121,8 @@ namespace nntl {
 			return true;
 		}
 
-		static bool absorbsion_will_succeed(const mtx_t& _train_x, const mtx_t& _train_y
-			, const mtx_t& _test_x, const mtx_t& _test_y)noexcept //, const bool noBiasEmulationNecessary) noexcept
+		static bool absorbsion_will_succeed(const x_src_t& _train_x, const mtx_t& _train_y
+			, const x_src_t& _test_x, const mtx_t& _test_y)noexcept //, const bool noBiasEmulationNecessary) noexcept
 		{
 			return !_train_x.empty() && !_train_y.empty() && _train_x.rows() == _train_y.rows()
 				&& !_test_x.empty() && !_test_y.empty() && _test_x.rows() == _test_y.rows()
@@ -118,12 +130,18 @@ namespace nntl {
 				&& _train_x.cols() == _test_x.cols()
 				&& !_train_y.emulatesBiases() && !_test_y.emulatesBiases()
 				&& _train_x.emulatesBiases() && _test_x.emulatesBiases()
-				&& !_train_x.bDontManageStorage() && !_test_x.bDontManageStorage()
+				&& _x_storage_ok(_train_x) && _x_storage_ok(_test_x)
 				&& !_train_y.bDontManageStorage() && !_test_y.bDontManageStorage()
 				;
 				//&& (noBiasEmulationNecessary ^ _train_x.emulatesBiases()) && (noBiasEmulationNecessary ^ _test_x.emulatesBiases());
 		}
 
+	protected:
+		static bool _x_storage_ok(const mtx_t& x)noexcept { return !x.bDontManageStorage(); }
+		static bool _x_storage_ok(const mtx_csr_t& x)noexcept { return x.test_valid(); }
+
+	public:
+
 		bool replace_Y_will_succeed(const mtx_t& _train_y, const mtx_t& _test_y)noexcept
 		{
 			return !_train_y.empty() && _train_y.rows() == m_train_y.rows()
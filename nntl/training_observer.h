@@ -50,6 +50,10 @@ namespace nntl {
 		
 		typedef ::std::chrono::nanoseconds nanoseconds;
 
+		//set it to false in a derived class if inspect_results(bOnTestData==false) doesn't use anything. Then nnet::train() is
+		// allowed to skip the fprop() over the training set (see nnet_train_opts::trainLossFromBatches()) and the call itself
+		static constexpr bool bInspectsTrainResults = true;
+
 		//may preprocess train_y/test_y here
 		template<typename iMath>
 		nntl_interface bool init(size_t epochs, const realmtx_t& train_y, const realmtx_t& test_y, iMath& iM)noexcept;
@@ -70,6 +74,8 @@ namespace nntl {
 
 	template<typename RealT=d_interfaces::real_t>
 	struct training_observer_silent : public i_training_observer<RealT> {
+		static constexpr bool bInspectsTrainResults = false;
+
 		template<typename iMath>
 		constexpr bool init(size_t epochs, const realmtx_t& train_y, const realmtx_t& test_y, iMath& iM)const noexcept { return true; }
 		void deinit()const noexcept {}
@@ -91,6 +97,8 @@ namespace nntl {
 		size_t m_epochs;
 
 	public:
+		static constexpr bool bInspectsTrainResults = false;
+
 		template<typename iMath>
 		bool init(size_t epochs, const realmtx_t& train_y, const realmtx_t& test_y, iMath& iM)noexcept {
 			m_epochs = epochs;
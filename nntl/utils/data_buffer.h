@@ -86,27 +86,33 @@ namespace utils {
 		CircBufferFeeder(_base_class_t&& b) noexcept : _base_class_t(::std::move(b)), m_n(0), maxN((ptr1 ? n1 : 0) + (ptr2 ? n2 : 0)) {}
 
 		real_t next(const thread_id_t tId)const noexcept {
-			NNTL_UNREF(tId);
 			NNTL_ASSERT(maxN && acquired());
+			return next(tId, []()noexcept->real_t {
+				STDCOUTL(NNTL_FUNCTION << " - no more data in buffer!");
+				abort();
+			});
+		}
+
+		//when the buffer is exhausted, returns fallback() instead of aborting. The fallback must produce the value
+		// from the same distribution (the scale is applied to it as well).
+		template<typename FallbackT>
+		real_t next(const thread_id_t tId, FallbackT&& fallback)const noexcept {
+			NNTL_UNREF(tId);
 
 			const auto n = m_n++;
-			NNTL_ASSERT(n < maxN);
+			if (n >= maxN) return _applyScale(fallback());
 			const real_t*const pCur = (n >= n1 ? ptr2 : ptr1);
 			NNTL_ASSERT(pCur);
-			if (!pCur || n >= maxN) {
-				STDCOUTL(NNTL_FUNCTION << " - no more data in buffer!");
-				abort();
-			}
 			return _applyScale(pCur[n >= n1 ? n - n1 : n]);
 		}
 
 		void shrink()noexcept {
 			NNTL_ASSERT(maxN && acquired());
 
-			const auto n = m_n.load(::std::memory_order_relaxed);
-			NNTL_ASSERT(n < maxN);
+			//could be greater than maxN if the fallback was used
+			const auto n = ::std::min(m_n.load(::std::memory_order_relaxed), maxN);
 
-			if (n>=n1) {
+			if (ptr2 && n >= n1) {
 				NNTL_ASSERT(ptr2);
 				n2 = n - n1;
 			} else {
@@ -186,6 +192,9 @@ namespace utils {
 		size_t m_afterLastValidIdx{ 0 }; //last initialized element+1, so for a full container it is either 
 										 // equals to m_curIdx if m_curIdx!=0, or equals to m_total. Modifiable only by a one of bgthreads
 		size_t m_afterLastClaimedIdx{ 0 };//last claimed by bgthread element+1. zero means uninitialized
+		//count of elements claimed by bgthreads, but not yet done. Distinguishes an empty buffer that is claimed entirely
+		// from an empty buffer with nothing claimed (m_afterLastClaimedIdx==m_curIdx in both cases)
+		size_t m_claimedCnt{ 0 };
 		bool m_bEmpty{ true };
 
 	public:
@@ -258,6 +267,31 @@ namespace utils {
 			return BufferRange_t();
 		}
 
+		//same as acquire_data(), but if there's less than n elements ready, acquires everything that is available.
+		// Returns empty range if the buffer is empty. Total count of acquired elements is n1+n2 (n2 is valid only if
+		// isTwoArrays()).
+		//must be called from the main thread only
+		BufferRange_t acquire_available(const size_t n)noexcept {
+			::std::lock_guard<decltype(m_bufMutex)> l(m_bufMutex);
+			NNTL_ASSERT(bStateOK());
+
+			if (m_bEmpty || !n) return BufferRange_t();
+			NNTL_ASSERT(m_afterLastValidIdx);
+
+			real_t* const pStart = m_pBegin + m_curIdx;
+			if (m_curIdx < m_afterLastValidIdx) {
+				const size_t a = m_afterLastValidIdx - m_curIdx;
+				return BufferRange_t(pStart, n < a ? n : a);
+			}
+			//valid zone spans from [m_curIdx to m_total), and from [0 to m_afterLastValidIdx)
+			const size_t n1 = m_total - m_curIdx;
+			if (n <= n1) return BufferRange_t(pStart, n);
+			const size_t n2 = n - n1;
+			return BufferRange_t(pStart, n1, m_pBegin, n2 < m_afterLastValidIdx ? n2 : m_afterLastValidIdx);
+		}
+
+		size_t size()const noexcept { return m_total; }
+
 		//Don't call if acquire_data() returned empty 
 		//must be called from the main thread only
 		// updates all
@@ -294,7 +328,7 @@ namespace utils {
 			NNTL_ASSERT(bStateOK());
 
 			size_t r;
-			if (!m_bEmpty && ((m_afterLastClaimedIdx && m_afterLastClaimedIdx == m_curIdx) || (!m_curIdx && m_afterLastClaimedIdx == m_total))) {
+			if ((!m_bEmpty || m_claimedCnt) && ((m_afterLastClaimedIdx && m_afterLastClaimedIdx == m_curIdx) || (!m_curIdx && m_afterLastClaimedIdx == m_total))) {
 				//the buffer is either already full or will been generated to its full condition soon. Nothing should be done.
 				r = 0;
 			} else {
@@ -343,6 +377,7 @@ namespace utils {
 				}
 			}
 			NNTL_ASSERT(r <= n);
+			m_claimedCnt += r;
 			NNTL_ASSERT(m_afterLastClaimedIdx > 0);
 			NNTL_ASSERT(bStateOK());
 			//m_bufMutex.unlock();
@@ -359,7 +394,9 @@ namespace utils {
 
 			NNTL_ASSERT(bStateOK());
 			//NNTL_ASSERT(!m_afterLastValidIdx || m_curIdx != m_afterLastValidIdx);
-			NNTL_ASSERT(m_afterLastValidIdx != m_afterLastClaimedIdx);
+			//m_afterLastValidIdx==m_afterLastClaimedIdx is possible only when the whole buffer was claimed
+			NNTL_ASSERT(n <= m_claimedCnt);
+			m_claimedCnt -= n;
 
 			//deciding where to put the data
 			if (m_afterLastValidIdx < m_afterLastClaimedIdx) {
@@ -35,7 +35,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // this file provides definitions of static (ones that doesn't require full nnet computation) weights initialization algorithms
 // Procedural weight initialization algorithms, such as LSUV, are separated into neighboring headers
 
-#include "../interface/rng/distr_normal_naive.h"
+#include "../interface/rng/distr_normal_ziggurat.h"
 
 namespace nntl {
 	namespace weights_init {
@@ -98,7 +98,7 @@ namespace nntl {
 				const auto prevLayerNeuronsCnt = W.cols() - 1;
 				const real_t stdDev = real_t(scalingCoeff*::std::sqrt(ext_real_t(2.) / prevLayerNeuronsCnt));
 
-				rng::distr_normal_naive<iRng_t> d(iR, real_t(0.0), stdDev);
+				rng::distr_normal_ziggurat<iRng_t> d(iR, real_t(0.0), stdDev);
 				d.gen_vector(W.data(), realmtx_t::sNumel(W.rows(), prevLayerNeuronsCnt));
 
 				//auto pBiases = W.colDataAsVec(prevLayerNeuronsCnt);
@@ -125,7 +125,7 @@ namespace nntl {
 				const auto prevLayerNeuronsCnt = W.cols() - 1;
 				const real_t stdDev = real_t( ::std::sqrt(paramCoeff / prevLayerNeuronsCnt));
 
-				rng::distr_normal_naive<iRng_t> d(iR, real_t(0.0), stdDev);
+				rng::distr_normal_ziggurat<iRng_t> d(iR, real_t(0.0), stdDev);
 
 				d.gen_vector(W.data(), realmtx_t::sNumel(W.rows(), prevLayerNeuronsCnt));
 
@@ -183,7 +183,7 @@ namespace nntl {
 				//generating weights
 				realmtx_t src(NonZeroUnitsCount, thisLayerNeuronsCnt);
 				if (src.isAllocationFailed())return false;
-				rng::distr_normal_naive<iRng_t> d(iR, real_t(0.0), stdDev);
+				rng::distr_normal_ziggurat<iRng_t> d(iR, real_t(0.0), stdDev);
 				d.gen_matrix(src);
 
 				auto pS = src.data();
@@ -235,7 +235,7 @@ namespace nntl {
 
 				NNTL_ASSERT(!W.empty() && W.numel() > 0);
 
-				rng::distr_normal_naive<iRng_t> d(iR, real_t(0.0), real_t(1.));
+				rng::distr_normal_ziggurat<iRng_t> d(iR, real_t(0.0), real_t(1.));
 
 				bool bOk = false;				
 				for (unsigned i = 0; i < maxTries; ++i) {
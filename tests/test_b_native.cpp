@@ -0,0 +1,213 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "stdafx.h"
+
+#include "../nntl/math.h"
+#include "../nntl/common.h"
+
+#include "../nntl/interface/math/mathn.h"
+#include "../nntl/interfaces.h"
+
+#include <atomic>
+
+#include "../nntl/utils/tictoc.h"
+#include "asserts.h"
+
+using namespace nntl;
+using namespace nntl::utils;
+using namespace nntl::math;
+
+typedef d_interfaces::iThreads_t iThreads_t;
+typedef math::MathN<real_t, iThreads_t> imath_blas_t;
+typedef math::MathN<real_t, iThreads_t, _impl::MATHN_THR<real_t>, b_Native<iThreads_t>> imath_native_t;
+
+static imath_blas_t iMB;
+static imath_native_t iMN;
+
+static_assert(imath_native_t::bBlasRunsOnIThreads && !imath_blas_t::bBlasRunsOnIThreads, "Wrong binding detection");
+
+#ifdef TESTS_SKIP_LONGRUNNING
+constexpr unsigned TEST_PERF_REPEATS_COUNT = 10;
+#else
+constexpr unsigned TEST_PERF_REPEATS_COUNT = 100;
+#endif
+
+template<typename base_t> struct b_native_EPS {};
+template<> struct b_native_EPS<double> { static constexpr double eps = 1e-10; };
+template<> struct b_native_EPS<float> { static constexpr float eps = 1e-3f; };
+
+struct isa_scope {
+	~isa_scope()noexcept { simd::set_max_isa(simd::isa::avx512); }
+	isa_scope(const simd::isa i)noexcept { simd::set_max_isa(i); }
+};
+
+//compares results of matrix multiplications done by OpenBLAS and native binding for every supported instruction set
+void test_b_native_corr(const vec_len_t aRows, const vec_len_t aCols, const vec_len_t bCols) {
+	MTXSIZE_SCOPED_TRACE1(aRows, aCols, "b_Native, B cols=", real_t(bCols));
+	d_interfaces::iRng_t rg;
+	rg.init_ithreads(iMB.ithreads());
+
+	realmtx_t A(aRows, aCols), B(aCols, bCols), Bt(bCols, aCols), At(aCols, aRows), C_ET(aRows, bCols), C(aRows, bCols)
+		, Cb_ET(aRows, bCols, true), Cb(aRows, bCols, true), D_ET(aRows, bCols), D(aRows, bCols);
+	ASSERT_TRUE(!A.isAllocationFailed() && !B.isAllocationFailed() && !Bt.isAllocationFailed() && !At.isAllocationFailed()
+		&& !C_ET.isAllocationFailed() && !C.isAllocationFailed() && !Cb_ET.isAllocationFailed() && !Cb.isAllocationFailed()
+		&& !D_ET.isAllocationFailed() && !D.isAllocationFailed());
+
+	rg.gen_matrix(A, real_t(1));
+	rg.gen_matrix(B, real_t(1));
+	rg.gen_matrix(Bt, real_t(1));
+	rg.gen_matrix(At, real_t(1));
+	const real_t alpha = real_t(.7);
+
+	iMB.mMulAB_C(A, B, C_ET);
+	iMB.mMulABt_Cnb(A, Bt, Cb_ET);
+	iMB.mScaledMulAtB_C(alpha, At, B, D_ET);
+
+	const auto supported = simd::supported_isa();
+	for (unsigned i = 0; i <= static_cast<unsigned>(supported); ++i) {
+		isa_scope s(static_cast<simd::isa>(i));
+		const auto descr = simd::isa_name(simd::active_isa());
+
+		C.ones();
+		iMN.mMulAB_C(A, B, C);
+		ASSERT_REALMTX_NEAR(C_ET, C, descr, b_native_EPS<real_t>::eps);
+
+		//biases must be left untouched
+		Cb.ones();
+		iMN.mMulABt_Cnb(A, Bt, Cb);
+		ASSERT_TRUE(Cb.test_biases_ok()) << descr;
+		ASSERT_REALMTX_NEAR(Cb_ET, Cb, descr, b_native_EPS<real_t>::eps);
+
+		D.ones();
+		iMN.mScaledMulAtB_C(alpha, At, B, D);
+		ASSERT_REALMTX_NEAR(D_ET, D, descr, b_native_EPS<real_t>::eps);
+	}
+}
+
+TEST(TestBNative, Gemm) {
+	//sizes are chosen to test edge blocks of the micro-kernel as well as st and mt code paths
+	const vec_len_t sizes[] = { 1, 3, 17, 64, 129 };
+	for (const auto r : sizes) {
+		for (const auto c : sizes) {
+			for (const auto n : sizes) {
+				ASSERT_NO_FATAL_FAILURE(test_b_native_corr(r, c, n));
+			}
+		}
+	}
+	ASSERT_NO_FATAL_FAILURE(test_b_native_corr(1000, 300, 500));
+}
+
+//the epilogue of mMulABt_Cnb_ep() runs inside the native gemm loops, so every element must be passed to it exactly once
+void test_b_native_ep(const vec_len_t aRows, const vec_len_t aCols, const vec_len_t bRows) {
+	MTXSIZE_SCOPED_TRACE1(aRows, aCols, "b_Native mMulABt_Cnb_ep, B rows=", real_t(bRows));
+	d_interfaces::iRng_t rg;
+	rg.init_ithreads(iMB.ithreads());
+
+	realmtx_t A(aRows, aCols, true), B(bRows, aCols + 1), C_ET(aRows, bRows, true), C(aRows, bRows, true);
+	ASSERT_TRUE(!A.isAllocationFailed() && !B.isAllocationFailed() && !C_ET.isAllocationFailed() && !C.isAllocationFailed());
+	rg.gen_matrix_no_bias(A, real_t(2));
+	rg.gen_matrix(B, real_t(1));
+
+	iMB.mMulABt_Cnb(A, B, C_ET);
+	iMB.sigm(C_ET);
+
+	const auto supported = simd::supported_isa();
+	for (unsigned i = 0; i <= static_cast<unsigned>(supported); ++i) {
+		isa_scope s(static_cast<simd::isa>(i));
+		const auto descr = simd::isa_name(simd::active_isa());
+
+		C.ones();
+		::std::atomic<numel_cnt_t> elmsSeen(0);
+		iMN.mMulABt_Cnb_ep(A, B, C, [&elmsSeen](realmtx_t& P) {
+			NNTL_ASSERT(!P.emulatesBiases());
+			elmsSeen += P.numel();
+			iMN.sigm_st(P);
+		});
+		ASSERT_EQ(C_ET.numel_no_bias(), elmsSeen.load()) << descr;
+		ASSERT_TRUE(C.test_biases_ok()) << descr;
+		ASSERT_REALMTX_NEAR(C_ET, C, descr, b_native_EPS<real_t>::eps);
+	}
+}
+
+TEST(TestBNative, FusedEpilogue) {
+	//single block, several blocks of rows and columns, st and mt code paths
+	ASSERT_NO_FATAL_FAILURE(test_b_native_ep(3, 2, 5));
+	ASSERT_NO_FATAL_FAILURE(test_b_native_ep(100, 30, 7));
+	ASSERT_NO_FATAL_FAILURE(test_b_native_ep(129, 300, 64));
+	ASSERT_NO_FATAL_FAILURE(test_b_native_ep(1000, 300, 500));
+	ASSERT_NO_FATAL_FAILURE(test_b_native_ep(700, 50, 3000));
+}
+
+TEST(TestBNative, BetaAndLeadingDims) {
+	//submatrices with lda>rows and beta!=0 aren't used by MathN, but must work as in BLAS
+	const vec_len_t m = 37, n = 23, k = 51, ld = 60;
+	d_interfaces::iRng_t rg;
+	rg.init_ithreads(iMB.ithreads());
+	realmtx_t A(ld, k), B(ld, k), C_ET(ld, n), C(ld, n);
+	ASSERT_TRUE(!A.isAllocationFailed() && !B.isAllocationFailed() && !C_ET.isAllocationFailed() && !C.isAllocationFailed());
+	rg.gen_matrix(A, real_t(1));
+	rg.gen_matrix(B, real_t(1));
+	rg.gen_matrix(C_ET, real_t(1));
+	const real_t alpha = real_t(-1.5), beta = real_t(.5);
+
+	for (int t = 0; t < 4; ++t) {
+		const bool bTA = !!(t & 1), bTB = !!(t & 2);
+		C_ET.clone_to(C);
+		b_OpenBLAS::gemm(bTA, bTB, m, n, k, alpha, A.data(), ld, B.data(), ld, beta, C_ET.data(), ld);
+		b_Native<iThreads_t>::gemm(iMN.ithreads(), bTA, bTB, m, n, k, alpha, A.data(), ld, B.data(), ld, beta, C.data(), ld);
+		ASSERT_REALMTX_NEAR(C_ET, C, "gemm with leading dimensions", b_native_EPS<real_t>::eps);
+	}
+}
+
+TEST(TestBNative, Perf) {
+	const vec_len_t rows = 1000, cols = 1000, n = 500;
+	d_interfaces::iRng_t rg;
+	rg.init_ithreads(iMB.ithreads());
+	realmtx_t A(rows, cols), B(n, cols), C(rows, n, true);
+	ASSERT_TRUE(!A.isAllocationFailed() && !B.isAllocationFailed() && !C.isAllocationFailed());
+	rg.gen_matrix(A, real_t(1));
+	rg.gen_matrix(B, real_t(1));
+
+	tictoc tB, tN;
+	for (unsigned r = 0; r < TEST_PERF_REPEATS_COUNT; ++r) {
+		tB.tic();
+		iMB.mMulABt_Cnb(A, B, C);
+		tB.toc();
+
+		tN.tic();
+		iMN.mMulABt_Cnb(A, B, C);
+		tN.toc();
+	}
+	STDCOUTL("mMulABt_Cnb " << rows << "x" << cols << " * (" << n << "x" << cols << ")', native code uses " << simd::isa_name(simd::active_isa()));
+	tB.say("OpenBLAS");
+	tN.say("native");
+}
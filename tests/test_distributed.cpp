@@ -0,0 +1,461 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "stdafx.h"
+
+//to get rid of '... decorated name length exceeded, name was truncated'
+#pragma warning( disable : 4503 )
+
+//on Windows tcp_ring.h brings in winsock2.h, that must precede the <windows.h> included by nntl.h
+#include "../nntl/distributed/tcp_ring.h"
+#include "../nntl/nntl.h"
+#include "../nntl/_supp/io/binfile.h"
+#include "../nntl/distributed/shm_ring.h"
+
+#include "asserts.h"
+#include "common_routines.h"
+
+#include <random>
+
+using namespace nntl;
+typedef nntl_supp::binfile reader_t;
+
+#if defined(NNTL_DISTRIBUTED_POSIX)
+#include <unistd.h>
+#endif
+
+#if defined(NNTL_DISTRIBUTED_POSIX) || defined(NNTL_DISTRIBUTED_WINSOCK)
+
+//ranks of a test are threads of this process, every one with its own transport object
+template<typename TransportT, typename MakeT, typename F>
+void _dist_run_ranks(const int N, MakeT&& fnMake, F&& f) {
+	::std::vector<::std::thread> ranks;
+	for (int r = 0; r < N; ++r) {
+		ranks.emplace_back([r, &fnMake, &f]() {
+			::std::unique_ptr<TransportT> pTr(fnMake(r));
+			EXPECT_TRUE(pTr->connect()) << "rank " << r << " failed to connect";
+			if (pTr->connected()) f(*pTr);
+		});
+	}
+	for (auto& t : ranks) t.join();
+}
+
+#if defined(NNTL_DISTRIBUTED_POSIX)
+static ::std::string _dist_shm_name(const char* sfx) {
+	return ::std::string("nntl_test_") + ::std::to_string(::getpid()) + sfx;
+}
+#endif
+
+//tcp_ring listens on basePort + rank, so this finds cnt consecutive free ports: the first one is an ephemeral port
+// given by the OS, the rest are checked by binding them. The ports are released before the ranks bind them, so only an
+// unrelated process that grabs them in between could collide with a test
+static uint16_t _dist_free_ports(const unsigned cnt) {
+	typedef distributed::_impl::tcp_sys sys;
+	if (!sys::startup()) {
+		ADD_FAILURE() << "Can't initialize sockets";
+		return 0;
+	}
+	utils::scope_exit sys_cleanup([]() { sys::cleanup(); });
+
+	for (int attempt = 0; attempt < 100; ++attempt) {
+		::std::vector<sys::socket_t> socks;
+		unsigned base = 0;
+		bool bOk = true;
+		for (unsigned i = 0; bOk && i < cnt; ++i) {
+			const auto s = ::socket(AF_INET, SOCK_STREAM, 0);
+			if (sys::invalid_socket == s) {
+				bOk = false;
+				break;
+			}
+			socks.push_back(s);
+			::sockaddr_in addr;
+			::std::memset(&addr, 0, sizeof(addr));
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			addr.sin_port = htons(static_cast<uint16_t>(i ? base + i : 0));
+			bOk = 0 == ::bind(s, reinterpret_cast<const ::sockaddr*>(&addr), sizeof(addr));
+			if (bOk && !i) {
+				::socklen_t len = sizeof(addr);
+				bOk = 0 == ::getsockname(s, reinterpret_cast<::sockaddr*>(&addr), &len);
+				base = ntohs(addr.sin_port);
+				bOk = bOk && base + cnt <= 65536;
+			}
+		}
+		for (const auto s : socks) sys::close(s);
+		if (bOk) return static_cast<uint16_t>(base);
+	}
+	ADD_FAILURE() << "Can't find " << cnt << " free consecutive ports";
+	return 0;
+}
+
+template<typename TransportT, typename MakeT>
+void _dist_test_allreduce(const int N, MakeT&& fnMake, const size_t n) {
+	::std::vector<::std::vector<real_t>> v(N, ::std::vector<real_t>(n));
+	::std::vector<double> etalon(n, 0.);
+	::std::mt19937 g(static_cast<unsigned>(n + N));
+	::std::uniform_real_distribution<real_t> distr(real_t(-1), real_t(1));
+	for (int r = 0; r < N; ++r) {
+		for (size_t i = 0; i < n; ++i) {
+			v[r][i] = distr(g);
+			etalon[i] += v[r][i];
+		}
+	}
+
+	_dist_run_ranks<TransportT>(N, fnMake, [&v, n](TransportT& tr) {
+		::std::vector<real_t> tmp;
+		EXPECT_TRUE(distributed::ring_allreduce_sum(tr, v[tr.rank()].data(), n, tmp));
+	});
+
+	for (int r = 0; r < N; ++r) {
+		ASSERT_TRUE(0 == ::std::memcmp(v[0].data(), v[r].data(), n * sizeof(real_t))) << "rank " << r << " has different sum";
+		for (size_t i = 0; i < n; ++i) ASSERT_NEAR(etalon[i], v[r][i], 1e-4) << "wrong sum at " << i;
+	}
+}
+
+TEST(TestDistributed, RingAllreduce) {
+	for (const int N : {1, 2, 3, 4}) {
+		//n < N makes empty chunks, the small shm ring capacity makes the transfers wrap around
+		for (const size_t n : {size_t(1), size_t(3), size_t(1000), size_t(100003)}) {
+#if defined(NNTL_DISTRIBUTED_POSIX)
+			ASSERT_NO_FATAL_FAILURE(_dist_test_allreduce<distributed::shm_ring>(N, [N](const int r) {
+				return new distributed::shm_ring(_dist_shm_name("ar").c_str(), r, N, 4096, 10000);
+			}, n));
+#endif
+			const auto port = _dist_free_ports(N);
+			ASSERT_NO_FATAL_FAILURE(_dist_test_allreduce<distributed::tcp_ring>(N, [N, port](const int r) {
+				return new distributed::tcp_ring(r, N, { "127.0.0.1" }, port, 10000);
+			}, n));
+		}
+	}
+}
+
+TEST(TestDistributed, Timeouts) {
+	//the rank 1 never shows up
+#if defined(NNTL_DISTRIBUTED_POSIX)
+	distributed::shm_ring s(_dist_shm_name("to").c_str(), 0, 2, 4096, 200);
+	ASSERT_FALSE(s.connect());
+#endif
+	distributed::tcp_ring t(0, 2, { "127.0.0.1" }, _dist_free_ports(2), 200);
+	ASSERT_FALSE(t.connect());
+
+	//the peer disappears in the middle of an exchange
+	::std::vector<char> snd(1 << 20), rcv(1 << 20);
+	const auto port = _dist_free_ports(2);
+	_dist_run_ranks<distributed::tcp_ring>(2, [port](const int r) {
+		return new distributed::tcp_ring(r, 2, { "127.0.0.1" }, port, 500);
+	}, [&snd, &rcv](distributed::tcp_ring& tr) {
+		if (tr.rank()) {
+			::std::this_thread::sleep_for(::std::chrono::milliseconds(100));
+		} else {
+			EXPECT_FALSE(tr.exchange(snd.data(), snd.size(), rcv.data(), rcv.size()));
+			EXPECT_FALSE(tr.connected());
+		}
+	});
+}
+
+#if defined(NNTL_DISTRIBUTED_POSIX)
+//leaves its outgoing ring behind as a crashed process would
+struct _dist_stale_shm : public distributed::shm_ring {
+	using distributed::shm_ring::shm_ring;
+	bool leave_segment() {
+		if (!_create_out()) return false;
+		_unmap(m_out);
+		return true;
+	}
+};
+
+TEST(TestDistributed, StaleSegments) {
+	const auto name = _dist_shm_name("st");
+	//the rank 1 starts first and maps the stale ring of the rank 0, then the rank 0 replaces it
+	for (const unsigned delayMs : {5u, 150u}) {
+		{
+			_dist_stale_shm s0(name.c_str(), 0, 2, 64, 200), s1(name.c_str(), 1, 2, 8192, 200);
+			ASSERT_TRUE(s0.leave_segment() && s1.leave_segment());
+		}
+		::std::vector<::std::thread> ranks;
+		for (const int r : {1, 0}) {
+			ranks.emplace_back([r, &name]() {
+				distributed::shm_ring tr(name.c_str(), r, 2, 4096, 5000);
+				ASSERT_TRUE(tr.connect()) << "rank " << r;
+				::std::vector<int> snd(50000, r + 1), rcv(50000, -1);
+				ASSERT_TRUE(tr.exchange(snd.data(), snd.size() * sizeof(int), rcv.data(), rcv.size() * sizeof(int)));
+				for (size_t i = 0; i < rcv.size(); ++i) ASSERT_EQ(2 - r, rcv[i]) << "rank " << r << " at " << i;
+			});
+			::std::this_thread::sleep_for(::std::chrono::milliseconds(delayMs));
+		}
+		for (auto& t : ranks) t.join();
+	}
+}
+#endif
+
+TEST(TestDistributed, Compression) {
+	constexpr int N = 3;
+	constexpr size_t n = 3001;
+	unsigned k = 110;
+	for (const auto c : { distributed::Compression::TopK, distributed::Compression::OneBit }) {
+		for (const real_t ratio : {real_t(.05), real_t(1.)}) {
+			::std::vector<::std::vector<real_t>> v(N, ::std::vector<real_t>(n)), res(N, ::std::vector<real_t>(n, real_t(0)));
+			::std::mt19937 g(k++);
+			::std::uniform_real_distribution<real_t> distr(real_t(-1), real_t(1));
+			for (auto& x : v) for (auto& e : x) e = distr(g);
+			const auto orig = v;
+
+			const auto port = _dist_free_ports(N);
+			_dist_run_ranks<distributed::tcp_ring>(N, [port](const int r) {
+				return new distributed::tcp_ring(r, N, { "127.0.0.1" }, port, 10000);
+			}, [&v, &res, c, ratio](distributed::tcp_ring& tr) {
+				distributed::allreducer<distributed::tcp_ring, real_t> ar(tr);
+				ar.compression(c, ratio);
+				EXPECT_TRUE(ar.needs_residual());
+				EXPECT_TRUE(ar.mean(v[tr.rank()].data(), n, res[tr.rank()].data()));
+			});
+
+			for (int r = 1; r < N; ++r) ASSERT_TRUE(0 == ::std::memcmp(v[0].data(), v[r].data(), n * sizeof(real_t)));
+			for (size_t i = 0; i < n; ++i) {
+				double s = 0, sr = 0;
+				for (int r = 0; r < N; ++r) {
+					s += orig[r][i];
+					sr += res[r][i];
+				}
+				//the error feedback loses nothing: what wasn't sent is in the residuals
+				ASSERT_NEAR(s, v[0][i] * N + sr, 1e-4) << "at " << i;
+				if (distributed::Compression::TopK == c && ratio >= real_t(1.)) ASSERT_NEAR(s / N, v[0][i], 1e-5);
+			}
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+struct _dist_rank {
+	typedef weights_init::XavierFour w_init_scheme;
+	typedef activation::sigm<real_t, w_init_scheme> activ_func;
+
+	layer_input<> inp;
+	layer_fully_connected<activ_func> fcl;
+	layer_output<activation::sigm_xentropy_loss<real_t, w_init_scheme>> outp;
+	decltype(make_layers(inp, fcl, outp)) lp;
+	decltype(make_nnet(lp)) nn;
+	train_data<real_t> td;
+
+	//the rank r gets the r-th of N parts of the training set and the whole test set
+	_dist_rank(const train_data<real_t>& src, const int r, const int N, const uint64_t rngSeed)noexcept
+		: inp(src.train_x().cols_no_bias()), fcl(60, real_t(.02)), outp(src.train_y().cols(), real_t(.02))
+		, lp(inp, fcl, outp), nn(lp)
+	{
+		nn.get_iRng().seed64(rngSeed);
+
+		const auto& sx = src.train_x();
+		const auto& sy = src.train_y();
+		const vec_len_t rows = sx.rows() / N, ofs = rows*r;
+		realmtx_t x(rows, sx.cols_no_bias(), true), y(rows, sy.cols()), tx, ty;
+		for (vec_len_t i = 0; i < rows; ++i) {
+			for (vec_len_t c = 0; c < sx.cols_no_bias(); ++c) x.set(i, c, sx.get(ofs + i, c));
+			for (vec_len_t c = 0; c < sy.cols(); ++c) y.set(i, c, sy.get(ofs + i, c));
+		}
+		src.test_x().clone_to(tx);
+		src.test_y().clone_to(ty);
+		const auto bOk = td.absorb(::std::move(x), ::std::move(y), ::std::move(tx), ::std::move(ty));
+		NNTL_ASSERT(bOk);
+		NNTL_UNREF(bOk);
+	}
+};
+
+template<typename base_t> struct DistSyncSGD_EPS {};
+template<> struct DistSyncSGD_EPS<double> { static constexpr double eps = 1e-10; };
+template<> struct DistSyncSGD_EPS<float> { static constexpr float eps = 1e-5f; };
+
+//without the compression it's a synchronous SGD: N ranks over b samples each must end with the same weights as a single
+// nnet over the N*b samples of all shards. Every shard is a single batch, so there's no shuffling to reproduce
+void _dist_sync_sgd(const train_data<real_t>& src, const uint64_t rngSeed)noexcept {
+	constexpr int N = 2;
+	constexpr vec_len_t b = 50;
+	constexpr size_t maxEpoch = 3;
+	typedef decltype(_dist_rank::nn) nnet_t;
+
+	//the rank r gets the rows [r*b, (r+1)*b) of tdRanks, the single nnet gets the same rows interleaved
+	train_data<real_t> tdRanks, tdSingle;
+	{
+		const auto& sx = src.train_x();
+		const auto& sy = src.train_y();
+		realmtx_t x(N*b, sx.cols_no_bias(), true), y(N*b, sy.cols()), xi(N*b, sx.cols_no_bias(), true), yi(N*b, sy.cols())
+			, tx, ty, txi, tyi;
+		for (vec_len_t i = 0; i < N*b; ++i) {
+			const vec_len_t j = (i % N)*b + i / N;
+			for (vec_len_t c = 0; c < sx.cols_no_bias(); ++c) {
+				x.set(i, c, sx.get(i, c));
+				xi.set(i, c, sx.get(j, c));
+			}
+			for (vec_len_t c = 0; c < sy.cols(); ++c) {
+				y.set(i, c, sy.get(i, c));
+				yi.set(i, c, sy.get(j, c));
+			}
+		}
+		src.test_x().clone_to(tx);
+		src.test_y().clone_to(ty);
+		src.test_x().clone_to(txi);
+		src.test_y().clone_to(tyi);
+		ASSERT_TRUE(tdRanks.absorb(::std::move(x), ::std::move(y), ::std::move(tx), ::std::move(ty)));
+		ASSERT_TRUE(tdSingle.absorb(::std::move(xi), ::std::move(yi), ::std::move(txi), ::std::move(tyi)));
+	}
+
+	//the single nnet is seeded as the rank 0, so it starts with the weights the rank 0 broadcasts
+	_dist_rank single(tdSingle, 0, 1, rngSeed);
+	{
+		nnet_train_opts<training_observer_silent<real_t>> opts(maxEpoch);
+		opts.batchSize(N*b);
+		const auto ec = single.nn.train(single.td, opts);
+		ASSERT_EQ(nnet_t::ErrorCode::Success, ec) << "Error code description: " << single.nn.get_last_error_string();
+	}
+
+	::std::vector<::std::unique_ptr<_dist_rank>> ranks;
+	for (int r = 0; r < N; ++r) ranks.emplace_back(new _dist_rank(tdRanks, r, N, rngSeed + r));
+	const auto port = _dist_free_ports(N);
+	_dist_run_ranks<distributed::tcp_ring>(N, [port](const int r) {
+		return new distributed::tcp_ring(r, N, { "127.0.0.1" }, port, 30000);
+	}, [&ranks](distributed::tcp_ring& tr) {
+		auto& rank = *ranks[tr.rank()];
+		nnet_train_opts<training_observer_silent<real_t>> opts(maxEpoch);
+		opts.batchSize(b);
+		auto nd = make_nnet_distributed(rank.nn, tr);
+		nd.compression(distributed::Compression::None);
+		const auto ec = nd.train(rank.td, opts);
+		EXPECT_EQ(nnet_t::ErrorCode::Success, ec) << "rank " << tr.rank() << ": " << nd.get_last_error_str();
+	});
+
+	ASSERT_REALMTX_NEAR(single.fcl.get_weights(), ranks[0]->fcl.get_weights()
+		, "fcl weights differ from the single nnet over both shards", DistSyncSGD_EPS<real_t>::eps);
+	ASSERT_REALMTX_NEAR(single.outp.get_weights(), ranks[0]->outp.get_weights()
+		, "outp weights differ from the single nnet over both shards", DistSyncSGD_EPS<real_t>::eps);
+}
+
+TEST(TestDistributed, TrainTwoRanks) {
+	train_data<real_t> td;
+	reader_t reader;
+
+	const auto srcFile = MNIST_FILE_DEBUG;
+	STDCOUTL("Reading datafile '" << srcFile << "'...");
+	reader_t::ErrorCode rec = reader.read(srcFile, td);
+	ASSERT_EQ(reader_t::ErrorCode::Success, rec) << "Error code description: " << reader.get_last_error_str();
+
+	constexpr int N = 2;
+	const uint64_t sv = static_cast<uint64_t>(::std::time(0));
+	for (const auto c : { distributed::Compression::None, distributed::Compression::TopK, distributed::Compression::OneBit }) {
+		::std::vector<::std::unique_ptr<_dist_rank>> ranks;
+		for (int r = 0; r < N; ++r) ranks.emplace_back(new _dist_rank(td, r, N, sv + r));
+		typedef decltype(_dist_rank::nn) nnet_t;
+
+		real_t lossBefore, lossAfter;
+		ASSERT_EQ(nnet_t::ErrorCode::Success, ranks[0]->nn.calcLoss(td.train_x(), td.train_y(), lossBefore));
+
+		const auto port = _dist_free_ports(N);
+		_dist_run_ranks<distributed::tcp_ring>(N, [port](const int r) {
+			return new distributed::tcp_ring(r, N, { "127.0.0.1" }, port, 30000);
+		}, [&ranks, c](distributed::tcp_ring& tr) {
+			auto& rank = *ranks[tr.rank()];
+			nnet_train_opts<training_observer_silent<real_t>> opts(5);
+			opts.batchSize(10);
+			auto nd = make_nnet_distributed(rank.nn, tr);
+			nd.compression(c, real_t(.1));
+			const auto ec = nd.train(rank.td, opts);
+			EXPECT_EQ(nnet_t::ErrorCode::Success, ec) << "rank " << tr.rank() << ": " << nd.get_last_error_str();
+		});
+
+		//the ranks started with different weights, the weights of the rank 0 must have been used
+		for (int r = 1; r < N; ++r) {
+			ASSERT_MTX_EQ(ranks[0]->fcl.get_weights(), ranks[r]->fcl.get_weights(), "fcl weights of the ranks differ");
+			ASSERT_MTX_EQ(ranks[0]->outp.get_weights(), ranks[r]->outp.get_weights(), "outp weights of the ranks differ");
+		}
+		ASSERT_EQ(nnet_t::ErrorCode::Success, ranks[0]->nn.calcLoss(td.train_x(), td.train_y(), lossAfter));
+		STDCOUTL("Compression " << static_cast<int>(c) << ": loss before = " << lossBefore << ", after = " << lossAfter);
+		ASSERT_LT(lossAfter, lossBefore) << "Training didn't decrease the loss";
+	}
+
+	STDCOUTL("No compression against a single nnet over both shards");
+	ASSERT_NO_FATAL_FAILURE(_dist_sync_sgd(td, sv));
+}
+
+TEST(TestDistributed, RanksMismatch) {
+	train_data<real_t> td;
+	reader_t reader;
+	reader_t::ErrorCode rec = reader.read(MNIST_FILE_DEBUG, td);
+	ASSERT_EQ(reader_t::ErrorCode::Success, rec) << "Error code description: " << reader.get_last_error_str();
+
+	constexpr int N = 2;
+	::std::vector<::std::unique_ptr<_dist_rank>> ranks;
+	for (int r = 0; r < N; ++r) ranks.emplace_back(new _dist_rank(td, r, N, r + 1));
+	typedef decltype(_dist_rank::nn) nnet_t;
+
+	//the rank 1 differs by the batch size, by the compression and by the top-k ratio
+	for (int d = 0; d < 3; ++d) {
+		const auto port = _dist_free_ports(N);
+		_dist_run_ranks<distributed::tcp_ring>(N, [port](const int r) {
+			return new distributed::tcp_ring(r, N, { "127.0.0.1" }, port, 30000);
+		}, [&ranks, d](distributed::tcp_ring& tr) {
+			auto& rank = *ranks[tr.rank()];
+			const bool bOdd = tr.rank() > 0;
+			nnet_train_opts<training_observer_silent<real_t>> opts(2);
+			opts.batchSize(bOdd && 0 == d ? 20 : 10);
+			auto nd = make_nnet_distributed(rank.nn, tr);
+			nd.compression(bOdd && 1 == d ? distributed::Compression::OneBit : distributed::Compression::TopK
+				, bOdd && 2 == d ? real_t(.2) : real_t(.1));
+			EXPECT_EQ(nnet_t::ErrorCode::RanksMismatch, nd.train(rank.td, opts)) << "case " << d;
+		});
+	}
+}
+
+TEST(TestDistributed, ConcurrentTasksRejected) {
+	typedef activation::sigm<real_t, weights_init::XavierFour> activ_func;
+	layer_input<> inp(10);
+	layer_fully_connected<activ_func> fcl1(4, real_t(.1)), fcl2(4, real_t(.1));
+	auto lpHor = make_layer_pack_horizontal(make_PHL(fcl1, 0, 5), make_PHL(fcl2, 5, 5));
+	layer_output<activation::sigm_xentropy_loss<real_t, weights_init::XavierFour>> outp(2, real_t(.1));
+	auto lp = make_layers(inp, lpHor, outp);
+	auto nn = make_nnet(lp);
+	typedef decltype(nn) nnet_t;
+
+	if (lpHor.concurrent_tasks() < 2) {
+		STDCOUTL("Concurrent tasks mode isn't available here, skipping the test");
+		return;
+	}
+	//the rank must fail before it touches the transport, otherwise it'd wait for the absent peer
+	distributed::tcp_ring tr(0, 2, { "127.0.0.1" }, _dist_free_ports(2), 1000);
+	train_data<real_t> td;
+	nnet_train_opts<training_observer_silent<real_t>> opts(1);
+	auto nd = make_nnet_distributed(nn, tr);
+	EXPECT_EQ(nnet_t::ErrorCode::ConcurrentTasksUnsupported, nd.train(td, opts));
+	EXPECT_FALSE(tr.connected());
+}
+
+#else
+TEST(TestDistributed, Transports) {
+	STDCOUTL("Transports of the distributed training are implemented only for POSIX systems and Windows, skipping the tests");
+}
+#endif
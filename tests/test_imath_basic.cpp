@@ -37,12 +37,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../nntl/common.h"
 
 #include "../nntl/interface/math/mathn.h"
+#include "../nntl/interface/threads/numa.h"
 #include "../nntl/interfaces.h"
 
 #include "../nntl/_supp/io/jsonreader.h"
 
 #include <array>
+#include <atomic>
 #include <numeric>
+#include <bitset>
 
 #include "../nntl/utils/tictoc.h"
 #include "imath_etalons.h"
@@ -2153,6 +2156,103 @@ TEST(TestMathN, make_dropout) {
 
 //////////////////////////////////////////////////////////////////////////
 
+void test_make_dropout_packed(vec_len_t rowsCnt, vec_len_t colsCnt = 10) {
+	MTXSIZE_SCOPED_TRACE(rowsCnt, colsCnt, "make_dropout_packed");
+	constexpr unsigned testCorrRepCnt = TEST_CORRECTN_REPEATS_COUNT;
+	typedef realmtx_t::bitmask_word_t bitmask_word_t;
+	const real_t dpa = real_t(.7), keepVal = real_t(1) / dpa, a = real_t(1.5), b = real_t(.3), c = real_t(-.9);
+
+	realmtx_t A(rowsCnt, colsCnt, true), A_ET(rowsCnt, colsCnt, true), A_src(rowsCnt, colsCnt, true)
+		, O(rowsCnt, colsCnt), D(rowsCnt, colsCnt), D_ET(rowsCnt, colsCnt), D_src(rowsCnt, colsCnt);
+	ASSERT_TRUE(!A.isAllocationFailed() && !A_ET.isAllocationFailed() && !A_src.isAllocationFailed()
+		&& !O.isAllocationFailed() && !D.isAllocationFailed() && !D_ET.isAllocationFailed() && !D_src.isAllocationFailed());
+
+	const auto n = O.numel();
+	::std::vector<bitmask_word_t> bits(realmtx_t::sBitMaskWords(n));
+	auto bit = [&bits](const numel_cnt_t i)->bool { return 0 != ((bits[i / 64] >> (i % 64)) & 1); };
+
+	d_interfaces::iRng_t rg;
+	rg.init_ithreads(iM.ithreads());
+
+	for (unsigned r = 0; r < testCorrRepCnt; ++r) {
+		rg.gen_matrix_no_bias(A_src, 5);
+		rg.gen_matrix(D_src, 5);
+		rg.bernoulli_bits(&bits[0], n, dpa);
+		if (n % 64) ASSERT_EQ(bitmask_word_t(0), bits.back() >> (n % 64)) << "unused bits must be cleared";
+
+		A_src.clone_to(A_ET);
+		D_src.clone_to(D_ET);
+		for (numel_cnt_t i = 0; i < n; ++i) {
+			A_ET.data()[i] = bit(i) ? A_src.data()[i] * keepVal : real_t(0);
+			D_ET.data()[i] = bit(i) ? D_src.data()[i] * keepVal : real_t(0);
+		}
+
+		A_src.clone_to(A);
+		iM.make_dropout_packed_st(A, keepVal, &bits[0], O);
+		ASSERT_TRUE(A.test_biases_ok());
+		ASSERT_MTX_EQ(A_ET, A, "make_dropout_packed_st: wrong act");
+		ASSERT_TRUE(0 == memcmp(A_src.data(), O.data(), O.byte_size())) << "make_dropout_packed_st: wrong origAct";
+
+		A_src.clone_to(A);
+		iM.make_dropout_packed_mt(A, keepVal, &bits[0], O);
+		ASSERT_MTX_EQ(A_ET, A, "make_dropout_packed_mt: wrong act");
+		ASSERT_TRUE(0 == memcmp(A_src.data(), O.data(), O.byte_size())) << "make_dropout_packed_mt: wrong origAct";
+
+		A_src.clone_to(A);
+		iM.make_dropout_packed(A, keepVal, &bits[0], O);
+		ASSERT_MTX_EQ(A_ET, A, "make_dropout_packed: wrong act");
+
+		D_src.clone_to(D);
+		iM.evMulByBitMask_ip_st(D, &bits[0], keepVal);
+		ASSERT_MTX_EQ(D_ET, D, "evMulByBitMask_ip_st: wrong result");
+		D_src.clone_to(D);
+		iM.evMulByBitMask_ip_mt(D, &bits[0], keepVal);
+		ASSERT_MTX_EQ(D_ET, D, "evMulByBitMask_ip_mt: wrong result");
+		D_src.clone_to(D);
+		iM.evMulByBitMask_ip(D, &bits[0], keepVal);
+		ASSERT_MTX_EQ(D_ET, D, "evMulByBitMask_ip: wrong result");
+
+		//alpha dropout variant
+		A_src.clone_to(A_ET);
+		for (numel_cnt_t i = 0; i < n; ++i) {
+			A_ET.data()[i] = bit(i) ? A_src.data()[i] * a + b : c;
+		}
+		A_src.clone_to(A);
+		iM.make_alphaDropout_packed_st(A, a, b, c, &bits[0], O);
+		ASSERT_TRUE(A.test_biases_ok());
+		ASSERT_MTX_EQ(A_ET, A, "make_alphaDropout_packed_st: wrong act");
+		A_src.clone_to(A);
+		iM.make_alphaDropout_packed_mt(A, a, b, c, &bits[0], O);
+		ASSERT_MTX_EQ(A_ET, A, "make_alphaDropout_packed_mt: wrong act");
+		ASSERT_TRUE(0 == memcmp(A_src.data(), O.data(), O.byte_size())) << "make_alphaDropout_packed_mt: wrong origAct";
+	}
+}
+
+TEST(TestMathN, make_dropout_packed) {
+	for (vec_len_t r = 1; r < g_MinDataSizeDelta; ++r) {
+		for (vec_len_t c = 1; c < g_MinDataSizeDelta; ++c) {
+			ASSERT_NO_FATAL_FAILURE((test_make_dropout_packed(r, c)));
+		}
+	}
+	ASSERT_NO_FATAL_FAILURE((test_make_dropout_packed(_baseRowsCnt, 65)));
+	ASSERT_NO_FATAL_FAILURE((test_make_dropout_packed(1000, 100)));
+
+	//the share of set bits must match the probability
+	typedef realmtx_t::bitmask_word_t bitmask_word_t;
+	constexpr numel_cnt_t n = 100000;
+	::std::vector<bitmask_word_t> bits(realmtx_t::sBitMaskWords(n));
+	d_interfaces::iRng_t rg;
+	rg.init_ithreads(iM.ithreads());
+	for (const real_t p : { real_t(.1), real_t(.5), real_t(.8) }) {
+		rg.bernoulli_bits(&bits[0], n, p);
+		numel_cnt_t cnt = 0;
+		for (const auto w : bits) cnt += static_cast<numel_cnt_t>(::std::bitset<64>(w).count());
+		ASSERT_NEAR(p, static_cast<real_t>(cnt) / n, real_t(.01)) << "bernoulli_bits() produced wrong share of ones";
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 TEST(TestMathN, vCountSameNaive) {
 // 	typedef nntl::d_interfaces::iThreads_t def_threads_t;
 // 	typedef math::MathN<real_t, def_threads_t> iMB;
@@ -2328,6 +2428,18 @@ TEST(TestMathN, mExtractRowsCorrectness) {
 			//ASSERT_DOUBLE_EQ(destMt.get(r, c), src.get(vec[r], c));
 		}
 	}
+
+	//the same over per node copies of src. Faking 2 nodes, so half of the threads read the second copy
+	::std::vector<threads::numa::node_id_t> tidNodes(iM.ithreads().workers_count());
+	for (size_t t = 0; t < tidNodes.size(); ++t) tidNodes[t] = static_cast<threads::numa::node_id_t>(t % 2);
+	threads::numa::node_replicas<real_t> xr;
+	ASSERT_TRUE(xr.make(iM.ithreads(), tidNodes, src.data(), static_cast<size_t>(src.numel())));
+	ASSERT_TRUE(xr.made_for(src.data(), static_cast<size_t>(src.numel())));
+
+	realmtx_t destRepl(extrCnt, colsCnt);
+	ASSERT_TRUE(!destRepl.isAllocationFailed());
+	iM.mExtractRows_replicated(src, [&xr](const thread_id_t t) {return xr.for_tid(t); }, vec.begin(), destRepl);
+	ASSERT_EQ(destSt, destRepl);
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -2422,6 +2534,233 @@ TEST(TestMathN, mMulABt_Cnb_biased) {
 	}
 }
 
+template<typename base_t> struct mMulABt_Cnb_ep_EPS {};
+template<> struct mMulABt_Cnb_ep_EPS<double> { static constexpr double eps = 1e-12; };
+template<> struct mMulABt_Cnb_ep_EPS<float> { static constexpr float eps = 1e-5f; };
+
+void test_mMulABt_Cnb_ep(const vec_len_t rowsCnt, const vec_len_t inCnt, const vec_len_t outCnt) {
+	MTXSIZE_SCOPED_TRACE(rowsCnt, outCnt, "mMulABt_Cnb_ep");
+
+	realmtx_t A(rowsCnt, inCnt + 1, true), W(outCnt, inCnt + 1), C(rowsCnt, outCnt, true), etC(rowsCnt, outCnt, true);
+	ASSERT_TRUE(!A.isAllocationFailed() && !W.isAllocationFailed() && !C.isAllocationFailed() && !etC.isAllocationFailed());
+
+	iM.preinit(etC.numel());
+	ASSERT_TRUE(iM.init());
+	d_int_nI<real_t>::iRng_t rg;
+	rg.init_ithreads(iM.ithreads());
+
+	rg.gen_matrix_no_bias(A, real_t(2));
+	rg.gen_matrix(W, real_t(1));
+
+	iM.mMulABt_Cnb(A, W, etC);
+	iM.sigm(etC);
+
+	C.ones();
+	//the epilogue may be called concurrently (that's the case for b_Native binding)
+	::std::atomic<numel_cnt_t> elmsSeen(0);
+	iM.mMulABt_Cnb_ep(A, W, C, [&elmsSeen](realmtx_t& P) {
+		NNTL_ASSERT(!P.emulatesBiases());
+		elmsSeen += P.numel();
+		iM.sigm_st(P);
+	});
+	ASSERT_EQ(etC.numel_no_bias(), elmsSeen.load());
+	ASSERT_TRUE(C.test_biases_ok());
+	//the summation order of gemm may differ between the calls
+	ASSERT_REALMTX_NEAR(etC, C, "mMulABt_Cnb_ep() differs from mMulABt_Cnb() + sigm()", mMulABt_Cnb_ep_EPS<real_t>::eps);
+}
+
+TEST(TestMathN, mMulABt_Cnb_ep) {
+	ASSERT_NO_FATAL_FAILURE(test_mMulABt_Cnb_ep(3, 2, 5));
+	ASSERT_NO_FATAL_FAILURE(test_mMulABt_Cnb_ep(100, 30, 7));
+	//many panels with a partial last one
+	ASSERT_NO_FATAL_FAILURE(test_mMulABt_Cnb_ep(1000, 50, 107));
+	ASSERT_NO_FATAL_FAILURE(test_mMulABt_Cnb_ep(5000, 20, 30));
+}
+
+template<typename base_t> struct mMulABt_Cnb_small_EPS {};
+template<> struct mMulABt_Cnb_small_EPS<double> { static constexpr double eps = 1e-10; };
+template<> struct mMulABt_Cnb_small_EPS<float> { static constexpr float eps = 1e-4f; };
+void test_mMulABt_Cnb_small(const vec_len_t rowsCnt, const vec_len_t inCnt, const vec_len_t outCnt) {
+	MTXSIZE_SCOPED_TRACE(rowsCnt, outCnt, "mMulABt_Cnb_small");
+
+	realmtx_t A(rowsCnt, inCnt + 1, true), W(outCnt, inCnt + 1), C(rowsCnt, outCnt, true), etC(rowsCnt, outCnt, true);
+	ASSERT_TRUE(!A.isAllocationFailed() && !W.isAllocationFailed() && !C.isAllocationFailed() && !etC.isAllocationFailed());
+
+	iM.preinit(etC.numel());
+	ASSERT_TRUE(iM.init());
+	d_int_nI<real_t>::iRng_t rg;
+	rg.init_ithreads(iM.ithreads());
+
+	imath_basic_t::small_gemm_weights_t Wp;
+	for (unsigned r = 0; r < TEST_CORRECTN_REPEATS_COUNT; ++r) {
+		rg.gen_matrix_no_bias(A, real_t(2));
+		rg.gen_matrix(W, real_t(1));
+
+		iM.mMulABt_Cnb(A, W, etC);
+
+		//packed weights must be refreshed every time W changes
+		ASSERT_TRUE(iM.mPack4SmallMulABt(W, Wp));
+		C.ones();
+		iM.mMulABt_Cnb_small(A, Wp, C);
+		ASSERT_TRUE(C.test_biases_ok());
+		ASSERT_REALMTX_NEAR(etC, C, "mMulABt_Cnb_small() differs from mMulABt_Cnb()", mMulABt_Cnb_small_EPS<real_t>::eps);
+	}
+}
+
+TEST(TestMathN, mMulABt_Cnb_small) {
+	//every row count a kernel is specialized for, neurons count that is not a multiple of the panel width
+	for (vec_len_t r = 1; r <= 16; ++r) {
+		ASSERT_NO_FATAL_FAILURE(test_mMulABt_Cnb_small(r, 30, 67));
+	}
+	ASSERT_NO_FATAL_FAILURE(test_mMulABt_Cnb_small(1, 1, 1));
+	ASSERT_NO_FATAL_FAILURE(test_mMulABt_Cnb_small(3, 300, 10));
+	ASSERT_NO_FATAL_FAILURE(test_mMulABt_Cnb_small(5, 100, 200));
+}
+
+void test_mMulABt_Cnb_q8(const vec_len_t rowsCnt, const vec_len_t inCnt, const vec_len_t outCnt) {
+	MTXSIZE_SCOPED_TRACE(rowsCnt, outCnt, "mMulABt_Cnb_q8");
+
+	realmtx_t A(rowsCnt, inCnt + 1, true), W(outCnt, inCnt + 1), C(rowsCnt, outCnt, true), etC(rowsCnt, outCnt, true)
+		, preC(rowsCnt, outCnt, true);
+	ASSERT_TRUE(!A.isAllocationFailed() && !W.isAllocationFailed() && !C.isAllocationFailed() && !etC.isAllocationFailed()
+		&& !preC.isAllocationFailed());
+
+	iM.preinit(etC.numel());
+	ASSERT_TRUE(iM.init());
+	d_int_nI<real_t>::iRng_t rg;
+	rg.init_ithreads(iM.ithreads());
+
+	typedef imath_basic_t::q8_activations_t q8_activations_t;
+	q8_activations_t Aq;
+	imath_basic_t::q8_weights_t Wq;
+	for (unsigned r = 0; r < TEST_CORRECTN_REPEATS_COUNT; ++r) {
+		rg.gen_matrix_no_bias(A, real_t(2));
+		rg.gen_matrix(W, real_t(1));
+
+		//the error of every product is within half a quantization step of each operand, i.e. within max|A|*max|W|/127.
+		// The errors of the sum are mostly independent, so they grow as sqrt(inCnt). Biases aren't quantized
+		const real_t eps = real_t(3) * ::std::sqrt(real_t(inCnt)) * q8_activations_t::amax(A.data(), A.numel_no_bias())
+			* q8_activations_t::amax(W.data(), realmtx_t::sNumel(outCnt, inCnt)) / real_t(127);
+
+		iM.mMulABt_Cnb(A, W, etC);
+
+		//quantized weights must be refreshed every time W changes
+		ASSERT_TRUE(iM.mQuantize4MulABt_q8(W, Wq));
+		ASSERT_EQ(static_cast<size_t>(inCnt), Wq.inputs());
+		C.ones();
+		ASSERT_TRUE(iM.mMulABt_Cnb_q8(A, Aq, Wq, C));
+		ASSERT_TRUE(C.test_biases_ok());
+		ASSERT_REALMTX_NEAR(etC, C, "mMulABt_Cnb_q8() differs from mMulABt_Cnb() too much", eps);
+
+		//the epilogue must see every column once. The preactivations it gets are checked against mMulABt_Cnb(), because
+		// sigm() squashes the difference, and the result must be sigm() of them
+		C.ones();
+		preC.ones();
+		vec_len_t colsSeen = 0;
+		ASSERT_TRUE(iM.mMulABt_Cnb_q8(A, Aq, Wq, C, [&colsSeen, &C, &preC](realmtx_t& P) {
+			const auto c0 = static_cast<vec_len_t>((P.data() - C.data()) / C.rows());
+			ASSERT_TRUE(P.rows() == C.rows() && c0 + P.cols() <= C.cols_no_bias());
+			::std::copy(P.data(), P.data() + P.numel(), preC.colDataAsVec(c0));
+			colsSeen += P.cols();
+			iM.sigm(P);
+		}));
+		ASSERT_EQ(outCnt, colsSeen);
+		ASSERT_TRUE(C.test_biases_ok());
+		ASSERT_REALMTX_NEAR(etC, preC, "mMulABt_Cnb_q8() with epilogue differs from mMulABt_Cnb() too much", eps);
+		iM.sigm(preC);
+		ASSERT_REALMTX_NEAR(preC, C, "the epilogue result differs from sigm() of the preactivations", mMulABt_Cnb_ep_EPS<real_t>::eps);
+	}
+}
+
+TEST(TestMathN, mMulABt_Cnb_q8) {
+	//row and neuron counts that aren't multiples of the kernel tile, inputs that aren't multiples of the padding
+	ASSERT_NO_FATAL_FAILURE(test_mMulABt_Cnb_q8(1, 1, 1));
+	ASSERT_NO_FATAL_FAILURE(test_mMulABt_Cnb_q8(7, 30, 67));
+	ASSERT_NO_FATAL_FAILURE(test_mMulABt_Cnb_q8(100, 300, 10));
+	//more than one block of inputs (the sums of blocks are accumulated in C)
+	ASSERT_NO_FATAL_FAILURE(test_mMulABt_Cnb_q8(5, 1500, 33));
+	//multithreaded, split along rows and along neurons
+	ASSERT_NO_FATAL_FAILURE(test_mMulABt_Cnb_q8(1000, 100, 107));
+	ASSERT_NO_FATAL_FAILURE(test_mMulABt_Cnb_q8(16, 785, 500));
+}
+
+void test_sparse_mtx(const vec_len_t rowsCnt, const vec_len_t inCnt, const vec_len_t outCnt) {
+	MTXSIZE_SCOPED_TRACE(rowsCnt, inCnt, "sparse x dense");
+	typedef imath_basic_t::realmtx_csr_t realmtx_csr_t;
+	const vec_len_t extrCnt = rowsCnt / 2;
+
+	realmtx_t A(rowsCnt, inCnt + 1, true), W(outCnt, inCnt + 1), C(rowsCnt, outCnt, true), etC(rowsCnt, outCnt, true)
+		, dLdZ(rowsCnt, outCnt), dW(outCnt, inCnt + 1), etdW(outCnt, inCnt + 1), extr(extrCnt, inCnt + 1, true)
+		, etExtr(extrCnt, inCnt + 1, true), dense;
+	ASSERT_TRUE(!A.isAllocationFailed() && !W.isAllocationFailed() && !C.isAllocationFailed() && !etC.isAllocationFailed()
+		&& !dLdZ.isAllocationFailed() && !dW.isAllocationFailed() && !etdW.isAllocationFailed()
+		&& !extr.isAllocationFailed() && !etExtr.isAllocationFailed());
+
+	iM.preinit(A.numel());
+	ASSERT_TRUE(iM.init());
+	d_int_nI<real_t>::iRng_t rg;
+	rg.init_ithreads(iM.ithreads());
+
+	const real_t eps = real_t(1e-4);
+	const real_t alpha = real_t(1) / rowsCnt;
+	::std::vector<vec_len_t> vRowIdxs(extrCnt);
+
+	realmtx_csr_t Asp, extrSp;
+	extrSp.will_emulate_biases();
+	//the capacity is intentionally too small, mExtractRows() must grow it
+	ASSERT_TRUE(extrSp.resize(extrCnt, inCnt, 1));
+
+	for (unsigned r = 0; r < TEST_CORRECTN_REPEATS_COUNT; ++r) {
+		//about 10% of nonzero elements
+		rg.gen_matrix_no_bias(A, real_t(1));
+		for (auto pA = A.data(), pE = pA + A.numel_no_bias(); pA < pE; ++pA) {
+			if (::std::abs(*pA) < real_t(.9)) *pA = real_t(0);
+		}
+		rg.gen_matrix(W, real_t(1));
+		rg.gen_matrix(dLdZ, real_t(1));
+
+		ASSERT_TRUE(Asp.from_dense(A));
+		ASSERT_TRUE(Asp.emulatesBiases() && Asp.test_valid());
+		ASSERT_EQ(A.size(), Asp.size());
+		ASSERT_TRUE(Asp.to_dense(dense));
+		ASSERT_EQ(A, dense) << "from_dense()/to_dense() roundtrip failed";
+
+		iM.mMulABt_Cnb(A, W, etC);
+		C.ones();
+		iM.mMulABt_Cnb_st(Asp, W, C);
+		ASSERT_TRUE(C.test_biases_ok());
+		ASSERT_REALMTX_NEAR(etC, C, "st sparse mMulABt_Cnb() differs from the dense one", eps);
+		C.ones();
+		iM.mMulABt_Cnb_mt(Asp, W, C);
+		ASSERT_REALMTX_NEAR(etC, C, "mt sparse mMulABt_Cnb() differs from the dense one", eps);
+
+		iM.mScaledMulAtB_C(alpha, dLdZ, A, etdW);
+		dW.ones();
+		iM.mScaledMulAtB_C_st(alpha, dLdZ, Asp, dW);
+		ASSERT_REALMTX_NEAR(etdW, dW, "st sparse mScaledMulAtB_C() differs from the dense one", eps);
+		dW.ones();
+		iM.mScaledMulAtB_C_mt(alpha, dLdZ, Asp, dW);
+		ASSERT_REALMTX_NEAR(etdW, dW, "mt sparse mScaledMulAtB_C() differs from the dense one", eps);
+
+		rg.gen_vector_gtz(&vRowIdxs[0], vRowIdxs.size(), rowsCnt - 1);
+		iM.mExtractRows(A, vRowIdxs.begin(), etExtr);
+		ASSERT_TRUE(iM.mExtractRows_st(Asp, vRowIdxs.begin(), extrSp));
+		ASSERT_TRUE(extrSp.test_valid() && extrSp.to_dense(extr));
+		ASSERT_EQ(etExtr, extr) << "st sparse mExtractRows() failed";
+		ASSERT_TRUE(iM.mExtractRows_mt(Asp, vRowIdxs.begin(), extrSp));
+		ASSERT_TRUE(extrSp.test_valid() && extrSp.to_dense(extr));
+		ASSERT_EQ(etExtr, extr) << "mt sparse mExtractRows() failed";
+	}
+}
+
+TEST(TestMathN, SparseMtx) {
+	ASSERT_NO_FATAL_FAILURE(test_sparse_mtx(2, 1, 1));
+	ASSERT_NO_FATAL_FAILURE(test_sparse_mtx(100, 30, 10));
+	//more neurons than a single block of the sparse kernels
+	ASSERT_NO_FATAL_FAILURE(test_sparse_mtx(200, 785, 300));
+	ASSERT_NO_FATAL_FAILURE(test_sparse_mtx(1000, 2000, 100));
+}
+
 
 //////////////////////////////////////////////////////////////////////////
 void test_evMul_ip(vec_len_t rowsCnt, vec_len_t colsCnt = 10) {
@@ -2672,6 +3011,150 @@ TEST(TestMathN, DSELU) {
 	}
 }
 
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+template<typename base_t> struct dact_mul_EPS {};
+template<> struct dact_mul_EPS <double> { static constexpr double eps = 1e-12; };
+template<> struct dact_mul_EPS <float> { static constexpr float eps = 1e-5f; };
+//compares fused d*_mul() against d*() followed by evMul_ip()
+//F is drawn from [fMin, fMax], which must be within the range of the activation (derivatives may assert on it)
+template<typename DfT, typename DfMulT>
+void test_dact_mul_corr(DfT&& df, DfMulT&& dfmul, const real_t fMin, const real_t fMax, const char* descr
+	, vec_len_t rowsCnt, vec_len_t colsCnt = 10)
+{
+	MTXSIZE_SCOPED_TRACE(rowsCnt, colsCnt, descr);
+	realmtx_t F(rowsCnt, colsCnt), dLdA(rowsCnt, colsCnt), F_ET(rowsCnt, colsCnt);
+	ASSERT_TRUE(!F.isAllocationFailed() && !dLdA.isAllocationFailed() && !F_ET.isAllocationFailed());
+
+	d_interfaces::iRng_t rg;
+	rg.init_ithreads(iM.ithreads());
+
+	for (unsigned r = 0; r < TEST_CORRECTN_REPEATS_COUNT; ++r) {
+		rg.gen_vector(F.data(), F.numel(), fMin, fMax);
+		rg.gen_matrix(dLdA, real_t(2));
+
+		F.clone_to(F_ET);
+		df(F_ET);
+		iM.evMul_ip(F_ET, dLdA);
+
+		dfmul(F, dLdA);
+		ASSERT_REALMTX_NEAR(F_ET, F, "fused version differs", dact_mul_EPS<real_t>::eps);
+	}
+}
+
+TEST(TestMathN, dact_mul) {
+	//activations without df_mul() are handled by the df()+evMul_ip() fallback of _activation_bprop_mul()
+	static_assert(activation::has_df_mul<activation::sigm<real_t>, imath_basic_t>::value, "sigm must provide df_mul()");
+	static_assert(!activation::has_df_mul<activation::_i_activation<real_t, weights_init::Martens_SI_sigm<>>, imath_basic_t>::value
+		, "has_df_mul<> must not be fooled by the interface");
+
+	const real_t lambda = real_t(1.050700), a_t_l = real_t(1.6732632)*lambda, alpha = real_t(.5), b = real_t(3);
+
+	const auto dsigm = [](realmtx_t& X) { iM.dsigm(X); };
+	const auto dsigm_mul = [](realmtx_t& X, const realmtx_t& D) { iM.dsigm_mul(X, D); };
+	const auto drelu = [](realmtx_t& X) { iM.drelu(X); };
+	const auto drelu_mul = [](realmtx_t& X, const realmtx_t& D) { iM.drelu_mul(X, D); };
+	const auto delu = [alpha](realmtx_t& X) { iM.delu(X, alpha); };
+	const auto delu_mul = [alpha](realmtx_t& X, const realmtx_t& D) { iM.delu_mul(X, D, alpha); };
+	const auto dselu = [a_t_l, lambda](realmtx_t& X) { iM.dselu(X, a_t_l, lambda); };
+	const auto dselu_mul = [a_t_l, lambda](realmtx_t& X, const realmtx_t& D) { iM.dselu_mul(X, D, a_t_l, lambda); };
+	const auto dloglogu = [b](realmtx_t& X) { iM.dloglogu(X, b, b); };
+	const auto dloglogu_mul = [b](realmtx_t& X, const realmtx_t& D) { iM.dloglogu_mul(X, D, b, b); };
+	const auto dsoftsign = [alpha, b](realmtx_t& X) { iM.dsoftsign(X, alpha, b); };
+	const auto dsoftsign_mul = [alpha, b](realmtx_t& X, const realmtx_t& D) { iM.dsoftsign_mul(X, D, alpha, b); };
+
+	const vec_len_t rows[] = { 1, 3, 17, 100, _baseRowsCnt * 10, 5000 };
+	for (const auto r : rows) {
+		//ranges are the codomains of the corresponding activations: sigm is in [0,1], elu/selu are bounded below
+		//by -alpha / -alpha*lambda, softsign with c==b is in (-b,b)
+		ASSERT_NO_FATAL_FAILURE(test_dact_mul_corr(dsigm, dsigm_mul, real_t(0), real_t(1), "dsigm_mul", r));
+		ASSERT_NO_FATAL_FAILURE(test_dact_mul_corr(drelu, drelu_mul, real_t(-5), real_t(5), "drelu_mul", r));
+		ASSERT_NO_FATAL_FAILURE(test_dact_mul_corr(delu, delu_mul, -alpha, real_t(5), "delu_mul", r));
+		ASSERT_NO_FATAL_FAILURE(test_dact_mul_corr(dselu, dselu_mul, -a_t_l, real_t(5), "dselu_mul", r));
+		ASSERT_NO_FATAL_FAILURE(test_dact_mul_corr(dloglogu, dloglogu_mul, real_t(-5), real_t(5), "dloglogu_mul", r));
+		ASSERT_NO_FATAL_FAILURE(test_dact_mul_corr(dsoftsign, dsoftsign_mul, -b * real_t(.99), b * real_t(.99), "dsoftsign_mul", r));
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+template<typename base_t> struct apply_grad_fused_EPS {};
+template<> struct apply_grad_fused_EPS <double> { static constexpr double eps = 1e-10; };
+template<> struct apply_grad_fused_EPS <float> { static constexpr float eps = 1e-4f; };
+
+void test_apply_grad_fused(vec_len_t rowsCnt, vec_len_t colsCnt, const bool bNesterov, const bool bMaxNorm) {
+	MTXSIZE_SCOPED_TRACE(rowsCnt, colsCnt, bNesterov ? (bMaxNorm ? "nesterov, max-norm" : "nesterov") : (bMaxNorm ? "classical, max-norm" : "classical"));
+	constexpr unsigned stepsCnt = 5;
+	const real_t lr = real_t(.01), beta1 = real_t(.9), beta2 = real_t(.999), ns = real_t(1e-8), momentum = real_t(.9)
+		, maxNormSq = real_t(.5), ILRdecr = real_t(.9), ILRincr = real_t(1.1), ILRcapLow = real_t(.1), ILRcapHigh = real_t(10);
+
+	realmtxdef_t W(rowsCnt, colsCnt), W_ET(rowsCnt, colsCnt), dLdW(rowsCnt, colsCnt), dLdW_ET(rowsCnt, colsCnt);
+	realmtx_t Mt(rowsCnt, colsCnt), Vt(rowsCnt, colsCnt), Vw(rowsCnt, colsCnt), Gain(rowsCnt, colsCnt), Prev(rowsCnt, colsCnt)
+		, Mt_ET(rowsCnt, colsCnt), Vt_ET(rowsCnt, colsCnt), Vw_ET(rowsCnt, colsCnt), Gain_ET(rowsCnt, colsCnt), Prev_ET(rowsCnt, colsCnt);
+	ASSERT_TRUE(!W.isAllocationFailed() && !W_ET.isAllocationFailed() && !dLdW.isAllocationFailed() && !dLdW_ET.isAllocationFailed()
+		&& !Mt.isAllocationFailed() && !Vt.isAllocationFailed() && !Vw.isAllocationFailed() && !Gain.isAllocationFailed()
+		&& !Prev.isAllocationFailed() && !Mt_ET.isAllocationFailed() && !Vt_ET.isAllocationFailed() && !Vw_ET.isAllocationFailed()
+		&& !Gain_ET.isAllocationFailed() && !Prev_ET.isAllocationFailed());
+
+	iM.preinit(realmtx_t::sNumel(rowsCnt, iM.ithreads().workers_count()));
+	ASSERT_TRUE(iM.init());
+
+	d_interfaces::iRng_t rg;
+	rg.init_ithreads(iM.ithreads());
+
+	rg.gen_matrix(W, real_t(1));
+	W.clone_to(W_ET);
+	Mt.zeros(); Vt.zeros(); Vw.zeros(); Prev.zeros(); Gain.ones();
+	Mt_ET.zeros(); Vt_ET.zeros(); Vw_ET.zeros(); Prev_ET.zeros(); Gain_ET.ones();
+	real_t beta1t = real_t(1), beta2t = real_t(1), beta1t_ET = real_t(1), beta2t_ET = real_t(1);
+
+	math::fused_update::params<real_t> u;
+	u.set_ILR(Gain.data(), Prev.data(), ILRdecr, ILRincr, ILRcapLow, ILRcapHigh);
+	u.pILRStore = Prev.data();
+	u.set_momentum(Vw.data(), momentum, bNesterov ? math::fused_update::mom_nesterov : math::fused_update::mom_classical);
+	if (bMaxNorm) u.set_max_norm(maxNormSq, false);
+
+	for (unsigned s = 0; s < stepsCnt; ++s) {
+		rg.gen_matrix(dLdW, real_t(2));
+		dLdW.clone_to(dLdW_ET);
+
+		//the same sequence of operations as _grad_works::apply_grad() does
+		iM.Adam(dLdW_ET, Mt_ET, Vt_ET, beta1t_ET, beta2t_ET, lr, beta1, beta2, ns);
+		iM.apply_ILR(dLdW_ET, Prev_ET, Gain_ET, ILRdecr, ILRincr, ILRcapLow, ILRcapHigh);
+		dLdW_ET.clone_to(Prev_ET);
+		if (bNesterov) {
+			iM.evAdd_ip(Vw_ET, dLdW_ET);
+			iM.evSub_ip(W_ET, dLdW_ET);
+		} else {
+			iM.apply_momentum(Vw_ET, momentum, dLdW_ET);
+			iM.evSub_ip(W_ET, Vw_ET);
+		}
+		if (bMaxNorm) iM.mCheck_normalize_rows(W_ET, maxNormSq, false);
+
+		iM.apply_grad_fused(W, dLdW, math::fused_update::opt_Adam<real_t>(Mt, Vt, beta1t, beta2t, lr, beta1, beta2, ns), u);
+
+		ASSERT_EQ(beta1t_ET, beta1t);
+		ASSERT_EQ(beta2t_ET, beta2t);
+		ASSERT_REALMTX_NEAR(Mt_ET, Mt, "Mt differs", apply_grad_fused_EPS<real_t>::eps);
+		ASSERT_REALMTX_NEAR(Vt_ET, Vt, "Vt differs", apply_grad_fused_EPS<real_t>::eps);
+		ASSERT_REALMTX_NEAR(Gain_ET, Gain, "ILR gains differ", apply_grad_fused_EPS<real_t>::eps);
+		ASSERT_REALMTX_NEAR(Prev_ET, Prev, "stored dLdW differs", apply_grad_fused_EPS<real_t>::eps);
+		ASSERT_REALMTX_NEAR(Vw_ET, Vw, "momentum velocity differs", apply_grad_fused_EPS<real_t>::eps);
+		ASSERT_REALMTX_NEAR(W_ET, W, "weights differ", apply_grad_fused_EPS<real_t>::eps);
+	}
+}
+
+TEST(TestMathN, apply_grad_fused) {
+	const vec_len_t rows[] = { 1, 17, 100, _baseRowsCnt * 10 }, cols[] = { 2, 5, 31, 101 };
+	for (const auto r : rows) {
+		for (const auto c : cols) {
+			ASSERT_NO_FATAL_FAILURE(test_apply_grad_fused(r, c, false, false));
+			ASSERT_NO_FATAL_FAILURE(test_apply_grad_fused(r, c, false, true));
+			ASSERT_NO_FATAL_FAILURE(test_apply_grad_fused(r, c, true, true));
+		}
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 template<typename base_t> struct elu_EPS {};
@@ -3440,6 +3923,94 @@ TEST(TestMathN, dLoss_dZ) {
 	}
 }
 
+//////////////////////////////////////////////////////////////////////////
+template<typename base_t> struct dLdZ_loss_EPS {};
+template<> struct dLdZ_loss_EPS<double> { static constexpr double eps = 1e-10; };
+template<> struct dLdZ_loss_EPS<float> { static constexpr float eps = 1e-4f; };
+
+//fused dL/dZ + loss functions must produce the same dL/dZ as the dL/dZ function does and the same (relatively) loss value
+template<typename FstT, typename FmtT, typename FbT, typename dLdZT, typename LossT>
+void test_dLdZ_loss_corr(FstT&& fst, FmtT&& fmt, FbT&& fb, dLdZT&& fdLdZ, LossT&& fLoss, const char* descr, vec_len_t rowsCnt, vec_len_t colsCnt) {
+	MTXSIZE_SCOPED_TRACE(rowsCnt, colsCnt, descr);
+	constexpr unsigned testCorrRepCnt = TEST_CORRECTN_REPEATS_COUNT;
+	realmtx_t A(rowsCnt, colsCnt), Y(rowsCnt, colsCnt), dLdZ_ET(rowsCnt, colsCnt), dLdZ(rowsCnt, colsCnt);
+	ASSERT_TRUE(!A.isAllocationFailed() && !Y.isAllocationFailed() && !dLdZ_ET.isAllocationFailed() && !dLdZ.isAllocationFailed());
+	d_interfaces::iRng_t rg;
+	rg.init_ithreads(iM.ithreads());
+
+	for (unsigned rr = 0; rr < testCorrRepCnt; ++rr) {
+		rg.gen_matrix_norm(A);
+		rg.gen_matrix_norm(Y);
+		iM.ewBinarize_ip(Y, real_t(.5));
+
+		const real_t lossET = fLoss(A, Y);
+		A.clone_to(dLdZ_ET);
+		fdLdZ(Y, dLdZ_ET);
+		const real_t eps = dLdZ_loss_EPS<real_t>::eps * ::std::max(real_t(1), ::std::abs(lossET));
+
+		A.clone_to(dLdZ);
+		ASSERT_NEAR(lossET, fst(Y, dLdZ), eps) << "st failed";
+		ASSERT_REALMTX_NEAR(dLdZ_ET, dLdZ, "st failed", dLdZ_loss_EPS<real_t>::eps);
+
+		A.clone_to(dLdZ);
+		ASSERT_NEAR(lossET, fmt(Y, dLdZ), eps) << "mt failed";
+		ASSERT_REALMTX_NEAR(dLdZ_ET, dLdZ, "mt failed", dLdZ_loss_EPS<real_t>::eps);
+
+		A.clone_to(dLdZ);
+		ASSERT_NEAR(lossET, fb(Y, dLdZ), eps) << "() failed";
+		ASSERT_REALMTX_NEAR(dLdZ_ET, dLdZ, "() failed", dLdZ_loss_EPS<real_t>::eps);
+	}
+}
+
+TEST(TestMathN, dLdZ_loss) {
+	const auto lQuad = [](const realmtx_t& A, const realmtx_t& Y) { return iM.loss_quadratic(A, Y); };
+	const auto lXEnt = [](const realmtx_t& A, const realmtx_t& Y) { return iM.loss_xentropy(A, Y); };
+	const auto lSMXEnt = [](const realmtx_t& A, const realmtx_t& Y) { return iM.loss_softmax_xentropy(A, Y); };
+	const auto evSub = [](const realmtx_t& Y, realmtx_t& A) { iM.evSub_ip(A, Y); };
+	constexpr real_t softSigmA = real_t(1.);
+
+	//vec_len_t(4100) makes the numel of the biggest matrices exceed the fusion block size
+	for (vec_len_t r : { vec_len_t(1), vec_len_t(7), vec_len_t(_baseRowsCnt), vec_len_t(4100) }) {
+		for (vec_len_t c = 1; c < g_MinDataSizeDelta; ++c) {
+			ASSERT_NO_FATAL_FAILURE(test_dLdZ_loss_corr(
+				[](const realmtx_t& Y, realmtx_t& A) { return iM.dSigmQuadLoss_dZ_loss_st(Y, A); }
+				, [](const realmtx_t& Y, realmtx_t& A) { return iM.dSigmQuadLoss_dZ_loss_mt(Y, A); }
+				, [](const realmtx_t& Y, realmtx_t& A) { return iM.dSigmQuadLoss_dZ_loss(Y, A); }
+				, [](const realmtx_t& Y, realmtx_t& A) { iM.dSigmQuadLoss_dZ(Y, A); }, lQuad, "dSigmQuadLoss_dZ_loss", r, c));
+
+			ASSERT_NO_FATAL_FAILURE(test_dLdZ_loss_corr(
+				[](const realmtx_t& Y, realmtx_t& A) { return iM.dIdentityQuadLoss_dZ_loss_st(Y, A); }
+				, [](const realmtx_t& Y, realmtx_t& A) { return iM.dIdentityQuadLoss_dZ_loss_mt(Y, A); }
+				, [](const realmtx_t& Y, realmtx_t& A) { return iM.dIdentityQuadLoss_dZ_loss(Y, A); }
+				, evSub, lQuad, "dIdentityQuadLoss_dZ_loss", r, c));
+
+			ASSERT_NO_FATAL_FAILURE(test_dLdZ_loss_corr(
+				[](const realmtx_t& Y, realmtx_t& A) { return iM.dSigmXEntropyLoss_dZ_loss_st(Y, A); }
+				, [](const realmtx_t& Y, realmtx_t& A) { return iM.dSigmXEntropyLoss_dZ_loss_mt(Y, A); }
+				, [](const realmtx_t& Y, realmtx_t& A) { return iM.dSigmXEntropyLoss_dZ_loss(Y, A); }
+				, evSub, lXEnt, "dSigmXEntropyLoss_dZ_loss", r, c));
+
+			ASSERT_NO_FATAL_FAILURE(test_dLdZ_loss_corr(
+				[](const realmtx_t& Y, realmtx_t& A) { return iM.dIdentityXEntropyLoss_dZ_loss_st(Y, A); }
+				, [](const realmtx_t& Y, realmtx_t& A) { return iM.dIdentityXEntropyLoss_dZ_loss_mt(Y, A); }
+				, [](const realmtx_t& Y, realmtx_t& A) { return iM.dIdentityXEntropyLoss_dZ_loss(Y, A); }
+				, [](const realmtx_t& Y, realmtx_t& A) { iM.dIdentityXEntropyLoss_dZ(Y, A); }, lXEnt, "dIdentityXEntropyLoss_dZ_loss", r, c));
+
+			ASSERT_NO_FATAL_FAILURE(test_dLdZ_loss_corr(
+				[softSigmA](const realmtx_t& Y, realmtx_t& A) { return iM.dSoftSigmXEntropyLoss_dZ_loss_st(Y, A, softSigmA); }
+				, [softSigmA](const realmtx_t& Y, realmtx_t& A) { return iM.dSoftSigmXEntropyLoss_dZ_loss_mt(Y, A, softSigmA); }
+				, [softSigmA](const realmtx_t& Y, realmtx_t& A) { return iM.dSoftSigmXEntropyLoss_dZ_loss(Y, A, softSigmA); }
+				, [softSigmA](const realmtx_t& Y, realmtx_t& A) { iM.dSoftSigmXEntropyLoss_dZ(Y, A, softSigmA); }, lXEnt, "dSoftSigmXEntropyLoss_dZ_loss", r, c));
+
+			ASSERT_NO_FATAL_FAILURE(test_dLdZ_loss_corr(
+				[](const realmtx_t& Y, realmtx_t& A) { return iM.dSoftmaxXEntropyLoss_dZ_loss_st(Y, A); }
+				, [](const realmtx_t& Y, realmtx_t& A) { return iM.dSoftmaxXEntropyLoss_dZ_loss_mt(Y, A); }
+				, [](const realmtx_t& Y, realmtx_t& A) { return iM.dSoftmaxXEntropyLoss_dZ_loss(Y, A); }
+				, evSub, lSMXEnt, "dSoftmaxXEntropyLoss_dZ_loss", r, c));
+		}
+	}
+}
+
 #if NNTL_MATLAB_AVAILABLE
 
 TEST(TestMathN, _mIsOrthogonal) {
@@ -84,6 +84,58 @@ TEST(TestLayerPackHorizontal, Simple) {
 	ASSERT_EQ(decltype(Bnn)::ErrorCode::Success, Bec) << "Error code description: " << Bnn.get_last_error_string();
 }
 
+//trains a small net with deterministic weights on a full batch and returns the output on the test set
+void _lph_concurrent_run(train_data<real_t>& td, const bool bConcurrent, realmtxdef_t& out) {
+	const real_t learningRate = real_t(.01);
+	const auto train_x_dim = td.train_x().cols_no_bias();
+	constexpr neurons_count_t undNeuronsCnt = 60;
+
+	layer_input<> inp(train_x_dim);
+	layer_fully_connected<activation::sigm<real_t, test_weights_init::Xavier<1>>> und(undNeuronsCnt, learningRate);
+
+	layer_fully_connected<activation::sigm<real_t, test_weights_init::Xavier<2>>> fcl1(40, learningRate);
+	layer_fully_connected<activation::sigm<real_t, test_weights_init::Xavier<3>>> fcl2(30, learningRate);
+	layer_fully_connected<activation::sigm<real_t, test_weights_init::Xavier<4>>> fcl3(20, learningRate);
+	//the first two ranges don't end at the bias column and intersect, the last one does end there
+	auto lpHor = make_layer_pack_horizontal(make_PHL(fcl1, 0, undNeuronsCnt / 2), make_PHL(fcl2, undNeuronsCnt / 4, undNeuronsCnt / 2)
+		, make_PHL(fcl3, undNeuronsCnt / 2, undNeuronsCnt / 2));
+	if (bConcurrent) {
+		ASSERT_GT(lpHor.concurrent_tasks(), 1u);
+	}
+
+	layer_output<activation::sigm_quad_loss<real_t, test_weights_init::Xavier<5>>> outp(td.train_y().cols(), learningRate);
+
+	auto lp = make_layers(inp, und, lpHor, outp);
+
+	nnet_train_opts<> opts(3);
+	opts.batchSize(td.train_x().rows()).ImmediatelyDeinit(false);
+
+	auto nn = make_nnet(lp);
+	auto ec = nn.train(td, opts);
+	ASSERT_EQ(decltype(nn)::ErrorCode::Success, ec) << "Error code description: " << nn.get_last_error_string();
+
+	nnet_eval_results<real_t> res;
+	ec = nn.eval(td.test_x(), td.test_y(), res);
+	ASSERT_EQ(decltype(nn)::ErrorCode::Success, ec) << "Error code description: " << nn.get_last_error_string();
+	ASSERT_TRUE(res.output_activations.clone_to(out));
+}
+
+TEST(TestLayerPackHorizontal, ConcurrentTasks) {
+	train_data<real_t> td;
+	reader_t reader;
+
+	STDCOUTL("Reading datafile '" << MNIST_FILE_DEBUG << "'...");
+	reader_t::ErrorCode rec = reader.read(NNTL_STRING(MNIST_FILE_DEBUG), td);
+	ASSERT_EQ(reader_t::ErrorCode::Success, rec) << "Error code description: " << reader.get_last_error_str();
+
+	realmtxdef_t serialOut, concurrentOut;
+	ASSERT_NO_FATAL_FAILURE(_lph_concurrent_run(td, false, serialOut));
+	ASSERT_NO_FATAL_FAILURE(_lph_concurrent_run(td, true, concurrentOut));
+
+	//the same weights and the same full batch, so the only difference is in the order of summation
+	ASSERT_REALMTX_NEAR(serialOut, concurrentOut, "concurrent mode differs from the serial one", real_t(1e-4));
+}
+
 
 /*
 void __test_same_layers(train_data<real_t>& td, uint64_t rngSeed) {
@@ -0,0 +1,167 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "stdafx.h"
+
+#include "../nntl/math.h"
+#include "../nntl/common.h"
+
+#include "../nntl/interfaces.h"
+#include "../nntl/interface/mt_dispatcher/mt_dispatcher.h"
+
+using namespace nntl;
+
+typedef d_interfaces::iThreads_t iThreads_t;
+typedef math::_impl::MATHN_THR_RT<real_t> Thr_t;
+typedef math::MathN<real_t, iThreads_t, Thr_t> iMathRT_t;
+typedef mt::mt_dispatcher<iMathRT_t> disp_t;
+
+static constexpr const char* TEST_PROFILE_FILE = "./test_mt_dispatcher.profile";
+
+TEST(TestMtDispatcher, ThresholdsRegistry) {
+	Thr_t::reset();
+	EXPECT_EQ(Thr_t::sigm, Thr_t::defaults_t::sigm);
+	EXPECT_EQ(Thr_t::find("sigm"), &Thr_t::sigm);
+	EXPECT_EQ(Thr_t::find("mrwMulByVec_mt_rows"), &Thr_t::mrwMulByVec_mt_rows);
+	EXPECT_EQ(Thr_t::find("softmax"), &Thr_t::softmax);
+	EXPECT_EQ(Thr_t::find("mExtractRows"), &Thr_t::mExtractRows);
+	EXPECT_EQ(Thr_t::find("mMulABt_Cnb_ep_minCols"), &Thr_t::mMulABt_Cnb_ep_minCols);
+	EXPECT_EQ(Thr_t::find("dact_mul_chunk"), &Thr_t::dact_mul_chunk);
+	EXPECT_EQ(Thr_t::find("nonexisting_threshold"), nullptr);
+
+	size_t cnt = 0;
+	Thr_t::for_each([&cnt](const char*const pName, const size_t& v) {
+		ASSERT_TRUE(pName && *pName);
+		ASSERT_EQ(Thr_t::find(pName), &v);
+		++cnt;
+	});
+	EXPECT_GT(cnt, 0);
+}
+
+TEST(TestMtDispatcher, SaveLoadRoundtrip) {
+	iMathRT_t iM;
+	disp_t disp(iM);
+
+	Thr_t::reset();
+	Thr_t::sigm = 12345;
+	Thr_t::evMul_ip = 1;
+	ASSERT_EQ(disp_t::ErrorCode::Success, disp.save(TEST_PROFILE_FILE)) << disp.get_last_error_str();
+
+	Thr_t::reset();
+	ASSERT_EQ(Thr_t::sigm, Thr_t::defaults_t::sigm);
+	ASSERT_EQ(disp_t::ErrorCode::Success, disp.load(TEST_PROFILE_FILE)) << disp.get_last_error_str();
+	EXPECT_EQ(Thr_t::sigm, 12345);
+	EXPECT_EQ(Thr_t::evMul_ip, 1);
+
+	Thr_t::reset();
+	::std::remove(TEST_PROFILE_FILE);
+}
+
+TEST(TestMtDispatcher, RejectsForeignProfiles) {
+	iMathRT_t iM;
+	disp_t disp(iM);
+	Thr_t::reset();
+
+	EXPECT_EQ(disp_t::ErrorCode::FailedToOpenFile, disp.load("./nonexisting_file.profile"));
+
+	//the signature of this machine must be accepted, but other count of workers or other CPU must not
+	ASSERT_EQ(disp_t::ErrorCode::Success, disp.save(TEST_PROFILE_FILE)) << disp.get_last_error_str();
+	char cpuName[disp_t::sMaxNameLen + 1] = {};
+	FILE* fp = nullptr;
+	ASSERT_TRUE(0 == fopen_s(&fp, TEST_PROFILE_FILE, "r") && fp);
+	ASSERT_EQ(1, fscanf_s(fp, "%*s %*u %*s %*u %63s", cpuName, static_cast<unsigned>(sizeof(cpuName))));
+	fclose(fp);
+	ASSERT_TRUE(*cpuName);
+
+	const char*const typeName = ::std::is_same<real_t, float>::value ? "float" : "double";
+	const unsigned wc = static_cast<unsigned>(iM.ithreads().workers_count());
+
+	fp = nullptr;
+	ASSERT_TRUE(0 == fopen_s(&fp, TEST_PROFILE_FILE, "w") && fp);
+	fprintf_s(fp, "%s %u %s %u %s\nsigm 1\n", disp_t::sSignature, disp_t::sVersion, typeName, wc + 1, cpuName);
+	fclose(fp);
+	EXPECT_EQ(disp_t::ErrorCode::FileIsForOtherMachine, disp.load(TEST_PROFILE_FILE));
+	EXPECT_EQ(Thr_t::sigm, Thr_t::defaults_t::sigm);
+
+	fp = nullptr;
+	ASSERT_TRUE(0 == fopen_s(&fp, TEST_PROFILE_FILE, "w") && fp);
+	fprintf_s(fp, "%s %u %s %u %s_other\nsigm 1\n", disp_t::sSignature, disp_t::sVersion, typeName, wc, cpuName);
+	fclose(fp);
+	EXPECT_EQ(disp_t::ErrorCode::FileIsForOtherMachine, disp.load(TEST_PROFILE_FILE));
+	EXPECT_EQ(Thr_t::sigm, Thr_t::defaults_t::sigm);
+
+	fp = nullptr;
+	ASSERT_TRUE(0 == fopen_s(&fp, TEST_PROFILE_FILE, "w") && fp);
+	fprintf_s(fp, "%s %u %s %u %s\nsigm 1\n", disp_t::sSignature, disp_t::sVersion, typeName, wc, cpuName);
+	fclose(fp);
+	EXPECT_EQ(disp_t::ErrorCode::Success, disp.load(TEST_PROFILE_FILE)) << disp.get_last_error_str();
+	EXPECT_EQ(Thr_t::sigm, 1);
+	Thr_t::reset();
+
+	//profiles of the previous version (without the CPU name) are rejected
+	fp = nullptr;
+	ASSERT_TRUE(0 == fopen_s(&fp, TEST_PROFILE_FILE, "w") && fp);
+	fprintf_s(fp, "%s %u %s %u\nsigm 1\n", disp_t::sSignature, disp_t::sVersion - 1, typeName, wc);
+	fclose(fp);
+	EXPECT_EQ(disp_t::ErrorCode::WrongFileSignature, disp.load(TEST_PROFILE_FILE));
+	EXPECT_EQ(Thr_t::sigm, Thr_t::defaults_t::sigm);
+
+	fp = nullptr;
+	ASSERT_TRUE(0 == fopen_s(&fp, TEST_PROFILE_FILE, "w") && fp);
+	fprintf_s(fp, "garbage\n");
+	fclose(fp);
+	EXPECT_EQ(disp_t::ErrorCode::WrongFileSignature, disp.load(TEST_PROFILE_FILE));
+
+	::std::remove(TEST_PROFILE_FILE);
+}
+
+TEST(TestMtDispatcher, AutotuneSmoke) {
+	iMathRT_t iM;
+	disp_t disp(iM);
+	Thr_t::reset();
+
+	mt::profiler_settings ps;
+	ps.minNumel = 64;
+	ps.maxNumel = 4096;
+	ps.sweepFactor = 4;
+	ps.repeats = 2;
+	ps.cols = 8;
+
+	ASSERT_EQ(disp_t::ErrorCode::Success, disp.autotune(TEST_PROFILE_FILE, true, ps)) << disp.get_last_error_str();
+	Thr_t::for_each([](const char*const pName, const size_t& v) {
+		EXPECT_GT(v, 0) << pName;
+	});
+	//the second call must just load the profile
+	ASSERT_EQ(disp_t::ErrorCode::Success, disp.autotune(TEST_PROFILE_FILE, false, ps));
+
+	Thr_t::reset();
+	::std::remove(TEST_PROFILE_FILE);
+}
@@ -42,6 +42,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../nntl/_supp/io/matfile.h"
 
 #include "../nntl/weights_init/LsuvExt.h"
+#include "../nntl/utils/tictoc.h"
 
 #include "asserts.h"
 #include "common_routines.h"
@@ -161,6 +162,244 @@ TEST(TestNnet, WeightsConstraintsL2L1) {
 	}
 }
 
+//////////////////////////////////////////////////////////////////////////
+void _nnet_prefetch_run(train_data<real_t>& td, const bool bPrefetch, const uint64_t rngSeed, realmtxdef_t& fclW, realmtxdef_t& outpW)noexcept {
+	typedef weights_init::XavierFour w_init_scheme;
+	typedef activation::sigm<real_t, w_init_scheme> activ_func;
+
+	layer_input<> inp(td.train_x().cols_no_bias());
+	layer_fully_connected<activ_func> fcl(60, real_t(.02));
+	layer_output<activation::sigm_xentropy_loss<real_t, w_init_scheme>> outp(td.train_y().cols(), real_t(.02));
+	auto lp = make_layers(inp, fcl, outp);
+
+	nnet_train_opts<> opts(3);
+	opts.calcFullLossValue(true).batchSize(100).prefetchBatches(bPrefetch);
+
+	auto nn = make_nnet(lp);
+	nn.get_iRng().seed64(rngSeed);
+
+	auto ec = nn.train(td, opts);
+	ASSERT_EQ(decltype(nn)::ErrorCode::Success, ec) << "Error code description: " << nn.get_last_error_string();
+
+	ASSERT_TRUE(fcl.get_weights().clone_to(fclW));
+	ASSERT_TRUE(outp.get_weights().clone_to(outpW));
+}
+
+TEST(TestNnet, PrefetchBatches) {
+	train_data<real_t> td;
+	reader_t reader;
+
+	const auto srcFile = MNIST_FILE_DEBUG;
+	STDCOUTL("Reading datafile '" << srcFile << "'...");
+	reader_t::ErrorCode rec = reader.read(srcFile, td);
+	ASSERT_EQ(reader_t::ErrorCode::Success, rec) << "Error code description: " << reader.get_last_error_str();
+
+	//the prefetching must not change the order of the data nor the RNG state, so the results must be exactly the same
+	const uint64_t sv = static_cast<uint64_t>(::std::time(0));
+	realmtxdef_t fclW, outpW, fclW_pf, outpW_pf;
+	ASSERT_NO_FATAL_FAILURE(_nnet_prefetch_run(td, false, sv, fclW, outpW));
+	ASSERT_NO_FATAL_FAILURE(_nnet_prefetch_run(td, true, sv, fclW_pf, outpW_pf));
+
+	ASSERT_MTX_EQ(fclW, fclW_pf, "fcl weights differ");
+	ASSERT_MTX_EQ(outpW, outpW_pf, "outp weights differ");
+}
+
+//////////////////////////////////////////////////////////////////////////
+struct _dp_replica {
+	typedef weights_init::XavierFour w_init_scheme;
+	typedef activation::sigm<real_t, w_init_scheme> activ_func;
+
+	layer_input<> inp;
+	layer_fully_connected<activ_func> fcl;
+	layer_output<activation::sigm_xentropy_loss<real_t, w_init_scheme>> outp;
+	typedef decltype(make_layers(inp, fcl, outp)) layers_pack_t;
+	layers_pack_t lp;
+	//the thread pool of a replica must be limited to its share of cores
+	layers_pack_t::iMath_t iM;
+	decltype(make_nnet(lp)) nn;
+
+	_dp_replica(const train_data<real_t>& td, const uint64_t rngSeed, const thread_id_t nThreads)noexcept
+		: inp(td.train_x().cols_no_bias()), fcl(60, real_t(.02)), outp(td.train_y().cols(), real_t(.02))
+		, lp(inp, fcl, outp), iM(nThreads), nn(lp, nullptr, &iM)
+	{
+		nn.get_iRng().seed64(rngSeed);
+	}
+};
+
+template<typename PolicyT>
+void _nnet_data_parallel_run(train_data<real_t>& td, const size_t replicasCnt, const uint64_t rngSeed)noexcept {
+	::std::vector<::std::unique_ptr<_dp_replica>> reps;
+	typedef decltype(_dp_replica::nn) nnet_t;
+	::std::vector<nnet_t*> pNets;
+	for (size_t r = 0; r < replicasCnt; ++r) {
+		reps.emplace_back(new _dp_replica(td, rngSeed + r, data_parallel::cores_per_replica(replicasCnt)));
+		pNets.push_back(&reps.back()->nn);
+	}
+	auto& nnP = reps[0]->nn;
+
+	real_t lossBefore, lossAfter;
+	ASSERT_EQ(nnet_t::ErrorCode::Success, nnP.calcLoss(td.train_x(), td.train_y(), lossBefore));
+
+	nnet_train_opts<> opts(3);
+	opts.batchSize(100);
+
+	auto dp = make_nnet_data_parallel<PolicyT>(pNets);
+	dp.sync_every(2);
+	auto ec = dp.train(td, opts);
+	ASSERT_EQ(decltype(dp)::ErrorCode::Success, ec) << "Error code description: " << dp.get_last_error_str();
+
+	ASSERT_EQ(nnet_t::ErrorCode::Success, nnP.calcLoss(td.train_x(), td.train_y(), lossAfter));
+	STDCOUTL("Loss before = " << lossBefore << ", after = " << lossAfter);
+	ASSERT_LT(lossAfter, lossBefore) << "Training didn't decrease the loss";
+
+	//both policies leave every replica with its own copy of the final weights
+	for (size_t r = 1; r < replicasCnt; ++r) {
+		const auto& W = reps[r]->fcl.get_weights();
+		ASSERT_FALSE(W.bDontManageStorage());
+		ASSERT_MTX_EQ(reps[0]->fcl.get_weights(), W, "fcl weights differ from the primary's");
+		ASSERT_MTX_EQ(reps[0]->outp.get_weights(), reps[r]->outp.get_weights(), "outp weights differ from the primary's");
+	}
+}
+
+template<typename base_t> struct DataParallelAvg_EPS {};
+template<> struct DataParallelAvg_EPS<double> { static constexpr double eps = 1e-10; };
+template<> struct DataParallelAvg_EPS<float> { static constexpr float eps = 1e-5f; };
+
+//TreeAveraging with sync_every(1) and the plain SGD is a synchronous SGD: a round of N replicas over b samples each must
+// give the same weights as a single step of one nnet over all N*b samples
+void _nnet_data_parallel_avg_grad(const train_data<real_t>& src, const uint64_t rngSeed)noexcept {
+	constexpr vec_len_t N = 2, b = 50;
+	typedef decltype(_dp_replica::nn) nnet_t;
+
+	train_data<real_t> td;
+	{
+		const auto& sx = src.train_x();
+		const auto& sy = src.train_y();
+		realmtx_t x(N*b, sx.cols_no_bias(), true), y(N*b, sy.cols()), tx, ty;
+		for (vec_len_t i = 0; i < N*b; ++i) {
+			for (vec_len_t c = 0; c < sx.cols_no_bias(); ++c) x.set(i, c, sx.get(i, c));
+			for (vec_len_t c = 0; c < sy.cols(); ++c) y.set(i, c, sy.get(i, c));
+		}
+		src.test_x().clone_to(tx);
+		src.test_y().clone_to(ty);
+		ASSERT_TRUE(td.absorb(::std::move(x), ::std::move(y), ::std::move(tx), ::std::move(ty)));
+	}
+
+	//the primary and the reference are seeded the same and have the same threads count, so they initialize the same weights
+	_dp_replica ref(td, rngSeed, data_parallel::cores_per_replica(N));
+	{
+		nnet_train_opts<training_observer_silent<real_t>> opts(1);
+		opts.batchSize(N*b);
+		const auto ec = ref.nn.train(td, opts);
+		ASSERT_EQ(nnet_t::ErrorCode::Success, ec) << "Error code description: " << ref.nn.get_last_error_string();
+	}
+
+	::std::vector<::std::unique_ptr<_dp_replica>> reps;
+	::std::vector<nnet_t*> pNets;
+	for (vec_len_t r = 0; r < N; ++r) {
+		reps.emplace_back(new _dp_replica(td, rngSeed + r, data_parallel::cores_per_replica(N)));
+		pNets.push_back(&reps.back()->nn);
+	}
+	nnet_train_opts<training_observer_silent<real_t>> opts(1);
+	opts.batchSize(b);
+	auto dp = make_nnet_data_parallel<data_parallel::TreeAveraging>(pNets);
+	dp.sync_every(1);
+	const auto ec = dp.train(td, opts);
+	ASSERT_EQ(decltype(dp)::ErrorCode::Success, ec) << "Error code description: " << dp.get_last_error_str();
+
+	ASSERT_REALMTX_NEAR(ref.fcl.get_weights(), reps[0]->fcl.get_weights()
+		, "fcl weights differ from a step on the averaged gradient", DataParallelAvg_EPS<real_t>::eps);
+	ASSERT_REALMTX_NEAR(ref.outp.get_weights(), reps[0]->outp.get_weights()
+		, "outp weights differ from a step on the averaged gradient", DataParallelAvg_EPS<real_t>::eps);
+}
+
+TEST(TestNnet, DataParallel) {
+	train_data<real_t> td;
+	reader_t reader;
+
+	const auto srcFile = MNIST_FILE_DEBUG;
+	STDCOUTL("Reading datafile '" << srcFile << "'...");
+	reader_t::ErrorCode rec = reader.read(srcFile, td);
+	ASSERT_EQ(reader_t::ErrorCode::Success, rec) << "Error code description: " << reader.get_last_error_str();
+
+	const uint64_t sv = static_cast<uint64_t>(::std::time(0));
+	STDCOUTL("TreeAveraging, 3 replicas");
+	ASSERT_NO_FATAL_FAILURE(_nnet_data_parallel_run<data_parallel::TreeAveraging>(td, 3, sv));
+	STDCOUTL("TreeAveraging, 4 replicas");
+	ASSERT_NO_FATAL_FAILURE(_nnet_data_parallel_run<data_parallel::TreeAveraging>(td, 4, sv));
+	STDCOUTL("Hogwild, 3 replicas");
+	ASSERT_NO_FATAL_FAILURE(_nnet_data_parallel_run<data_parallel::Hogwild>(td, 3, sv));
+	STDCOUTL("TreeAveraging, 2 replicas, sync every round against a step on the averaged gradient");
+	ASSERT_NO_FATAL_FAILURE(_nnet_data_parallel_avg_grad(td, sv));
+}
+
+//////////////////////////////////////////////////////////////////////////
+template<typename base_t> struct SmallBatchFprop_EPS {};
+template<> struct SmallBatchFprop_EPS<double> { static constexpr double eps = 1e-10; };
+template<> struct SmallBatchFprop_EPS<float> { static constexpr float eps = 1e-5f; };
+
+//single sample inference with a 784-500-300-10 net. The small batch path of every layer (including the output layer) must
+// give the same results as the generic one and be faster. The target is 20us on one core, but it's reachable only when the
+// weights (2.2MB for float) fit into the L2 cache, otherwise the time is bound by the L3 bandwidth, so it's just reported
+TEST(TestNnet, SmallBatchFpropLatency) {
+#ifdef NNTL_DEBUG
+	constexpr unsigned repeatsCnt = 10;
+#else
+	constexpr unsigned repeatsCnt = 2000;
+#endif // NNTL_DEBUG
+	typedef weights_init::XavierFour w_init_scheme;
+	typedef activation::sigm<real_t, w_init_scheme> activ_func;
+
+	layer_input<> inp(784);
+	layer_fully_connected<activ_func> fcl(500), fcl2(300);
+	layer_output<activation::sigm_xentropy_loss<real_t, w_init_scheme>> outp(10);
+	auto lp = make_layers(inp, fcl, fcl2, outp);
+	auto nn = make_nnet(lp);
+	typedef decltype(nn) nnet_t;
+
+	const auto ec = nn.init4fixedBatchFprop(1);
+	ASSERT_EQ(nnet_t::ErrorCode::Success, ec) << "Error code description: " << nn.get_last_error_string();
+
+	realmtx_t x(1, 784 + 1, true), etY(1, 10), y(1, 10);
+	ASSERT_TRUE(!x.isAllocationFailed() && !etY.isAllocationFailed() && !y.isAllocationFailed());
+	nn.get_iRng().gen_matrix_no_bias(x, real_t(1));
+
+	const auto setSmallBatch = [&fcl, &fcl2, &outp](const bool b)noexcept {
+		fcl.small_batch_fprop(b);
+		fcl2.small_batch_fprop(b);
+		outp.small_batch_fprop(b);
+	};
+
+	utils::tictoc tGeneric, tSmall;
+	setSmallBatch(false);
+	nn.doFixedBatchFprop(x);
+	outp.get_activations().clone_to(etY);
+	for (unsigned r = 0; r < repeatsCnt; ++r) {
+		tGeneric.tic();
+		nn.doFixedBatchFprop(x);
+		tGeneric.toc();
+	}
+
+	setSmallBatch(true);
+	//the first call also packs the weights
+	nn.doFixedBatchFprop(x);
+	outp.get_activations().clone_to(y);
+	ASSERT_REALMTX_NEAR(etY, y, "small batch fprop differs from the generic one", SmallBatchFprop_EPS<real_t>::eps);
+	for (unsigned r = 0; r < repeatsCnt; ++r) {
+		tSmall.tic();
+		nn.doFixedBatchFprop(x);
+		tSmall.toc();
+	}
+
+	tGeneric.say("generic");
+	tSmall.say("small batch");
+	STDCOUTL("best small batch run is " << (tSmall.m_dBestRun < ::std::chrono::microseconds(20) ? "within" : "OVER")
+		<< " the 20us target");
+#ifndef NNTL_DEBUG
+	EXPECT_LT(tSmall.m_dBestRun, tGeneric.m_dBestRun) << "small batch fprop is slower than the generic one";
+#endif // NNTL_DEBUG
+}
+
 /*
 TEST(TestNnet, L2Weights) {
 	train_data<real_t> td;
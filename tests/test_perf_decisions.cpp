@@ -1925,3 +1925,55 @@ TEST(TestPerfDecisions, vCountNonZeros) {
 }
 
 
+
+//////////////////////////////////////////////////////////////////////////
+//int8 inference product vs. the floating point one. The time of mMulABt_Cnb_q8() includes the quantization of A
+void test_mMulABt_Cnb_q8_perf(const vec_len_t rowsCnt, const vec_len_t inCnt, const vec_len_t outCnt) {
+	STDCOUTL("******* testing mMulABt_Cnb_q8() vs. mMulABt_Cnb() over " << rowsCnt << "x" << inCnt << " A and "
+		<< outCnt << " neurons **************");
+
+	constexpr unsigned maxReps = TEST_PERF_REPEATS_COUNT;
+
+	realmtx_t A(rowsCnt, inCnt + 1, true), W(outCnt, inCnt + 1), C(rowsCnt, outCnt, true);
+	ASSERT_TRUE(!A.isAllocationFailed() && !W.isAllocationFailed() && !C.isAllocationFailed());
+
+	iM.preinit(C.numel());
+	ASSERT_TRUE(iM.init());
+	d_interfaces::iRng_t rg;
+	rg.init_ithreads(iM.ithreads());
+	rg.gen_matrix_no_bias(A, real_t(2));
+	rg.gen_matrix(W, real_t(1));
+
+	imath_basic_t::q8_weights_t Wq;
+	imath_basic_t::q8_activations_t Aq;
+	ASSERT_TRUE(iM.mQuantize4MulABt_q8(W, Wq));
+	STDCOUTL("quantized weights take " << Wq.bytes() << " bytes, fp32/fp64 ones " << W.byte_size() << " bytes");
+
+	threads::prioritize_workers<threads::PriorityClass::PerfTesting, imath_basic_t::iThreads_t> pw(iM.ithreads());
+
+	utils::tictoc tF, tQ;
+	real_t v(0);
+	for (unsigned r = 0; r < maxReps; ++r) {
+		tF.tic();
+		iM.mMulABt_Cnb(A, W, C);
+		tF.toc();
+		v += C.data()[r % C.numel_no_bias()];
+
+		tQ.tic();
+		const bool b = iM.mMulABt_Cnb_q8(A, Aq, Wq, C);
+		tQ.toc();
+		ASSERT_TRUE(b);
+		v += C.data()[r % C.numel_no_bias()];
+	}
+	tF.say("fp");
+	tQ.say("int8");
+	tQ.ratios(tF);
+	STDCOUTL(v);
+}
+
+TEST(TestPerfDecisions, mMulABt_Cnb_q8) {
+	test_mMulABt_Cnb_q8_perf(1, 784, 500);
+	test_mMulABt_Cnb_q8_perf(16, 784, 500);
+	test_mMulABt_Cnb_q8_perf(256, 784, 500);
+	test_mMulABt_Cnb_q8_perf(1000, 300, 100);
+}
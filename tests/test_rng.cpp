@@ -37,6 +37,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../nntl/interface/rng/cstd.h"
 #include "../nntl/interface/rng/afrand.h"
 #include "../nntl/interface/rng/afrand_mt.h"
+#include "../nntl/interface/rng/philox.h"
+#include "../nntl/interface/rng/afrand_as.h"
 
 #include "../nntl/interfaces.h"
 
@@ -44,6 +46,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../nntl/utils/tictoc.h"
 
 #include "../nntl/interface/rng/distr_normal_naive.h"
+#include "../nntl/interface/rng/distr_normal_ziggurat.h"
+
+#include "../nntl/_supp/io/matfile.h"
 
 #pragma warning(push,3)
 #include <boost/accumulators/accumulators.hpp>
@@ -372,4 +377,323 @@ TEST(TestRNG, normal_vector_perf) {
 		test_normal_perf<AFog::CRandomSFMT0>(Thr, "AFSFMT0", i, 10);
 	NNTL_RUN_TEST2((rng::_impl::AFRAND_MT_THR<AFog::CRandomSFMT1, real_t>::bnd_normal_vector), 10)
 		test_normal_perf<AFog::CRandomSFMT1>(Thr, "AFSFMT1", i, 10);
-}
\ No newline at end of file
+}
+
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+TEST(TestRNG, PhiloxKAT) {
+	//known answers from the Random123 distribution (kat_vectors)
+	typedef rng::_impl::philox4x32 ph_t;
+	{
+		uint32_t c[4] = { 0,0,0,0 }, k[2] = { 0,0 };
+		ph_t::block(c, k);
+		ASSERT_EQ(0x6627e8d5u, c[0]); ASSERT_EQ(0xe169c58du, c[1]); ASSERT_EQ(0xbc57ac4cu, c[2]); ASSERT_EQ(0x9b00dbd8u, c[3]);
+	}
+	{
+		uint32_t c[4] = { UINT32_MAX,UINT32_MAX,UINT32_MAX,UINT32_MAX }, k[2] = { UINT32_MAX,UINT32_MAX };
+		ph_t::block(c, k);
+		ASSERT_EQ(0x408f276du, c[0]); ASSERT_EQ(0x41c83b0eu, c[1]); ASSERT_EQ(0xa20bc7c6u, c[2]); ASSERT_EQ(0x6d5451fdu, c[3]);
+	}
+	{
+		uint32_t c[4] = { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, k[2] = { 0xa4093822, 0x299f31d0 };
+		ph_t::block(c, k);
+		ASSERT_EQ(0xd16cfe09u, c[0]); ASSERT_EQ(0x94fdccebu, c[1]); ASSERT_EQ(0x5001e420u, c[2]); ASSERT_EQ(0x24126ea1u, c[3]);
+	}
+
+	//SIMD path must produce exactly the same stream as the scalar one, including unaligned starts and the carry
+	// into the high word of the block counter
+	ph_t g(0x0123456789abcdefull);
+	for (const uint64_t ss : { uint64_t(0), uint64_t(0x100000003ull) }) {
+		g.set_substream(ss);
+		for (const uint64_t base : { uint64_t(0), uint64_t(13), (uint64_t(UINT32_MAX) << 2) - 37 }) {
+			for (const size_t n : { 1, 5, 31, 32, 33, 1000 }) {
+				::std::vector<uint32_t> vS(n), vV(n);
+				math::simd::set_max_isa(math::simd::isa::scalar);
+				g.fill(&vS.front(), base, n);
+				math::simd::set_max_isa(math::simd::isa::avx512);
+				g.fill(&vV.front(), base, n);
+				ASSERT_TRUE(vS == vV) << "SIMD stream differs from the scalar one, substream=" << ss << ", base=" << base << ", n=" << n;
+			}
+		}
+	}
+
+	//the substream goes to the upper half of the counter
+	uint32_t c[4] = { 5, 0, 3, 1 }, k[2] = { 0x89abcdef, 0x01234567 }, b[4];
+	ph_t::block(c, k);
+	g.block(5, b);
+	ASSERT_TRUE(::std::equal(b, b + 4, c));
+}
+
+template<typename RngT, typename FuncT>
+void _test_philox_mt_invariance(FuncT&& fn, const char* pName) {
+	typedef nntl::d_interfaces::iThreads_t def_threads_t;
+	typedef ::std::vector<real_t> vec_t;
+	constexpr size_t totalElms = 100003;
+
+	def_threads_t Thr;
+	vec_t vSt(totalElms), vMt(totalElms), vMt1(totalElms);
+
+	RngT rSt(Thr, 42), rMt(Thr, 42), rMt1(Thr, 42);
+	fn(rSt, &vSt.front(), totalElms, 0);
+	fn(rMt, &vMt.front(), totalElms, 1);
+	const auto prevMax = Thr.max_threads();
+	Thr.max_threads(1);
+	fn(rMt1, &vMt1.front(), totalElms, 1);
+	Thr.max_threads(prevMax);
+
+	ASSERT_TRUE(vSt == vMt) << pName << ": _st and _mt results differ";
+	ASSERT_TRUE(vSt == vMt1) << pName << ": results depend on the number of threads";
+	ASSERT_EQ(rSt.position(), rMt.position()) << pName;
+	ASSERT_EQ(rSt.position(), rMt1.position()) << pName;
+}
+
+TEST(TestRNG, PhiloxThreadsInvariance) {
+	typedef nntl::d_interfaces::iThreads_t def_threads_t;
+	typedef rng::Philox<real_t, def_threads_t> rng_t;
+
+	_test_philox_mt_invariance<rng_t>([](rng_t& r, real_t* p, const size_t n, const bool bMt) {
+		if (bMt) r.gen_vector_mt(p, n, real_t(-2), real_t(3)); else r.gen_vector_st(p, n, real_t(-2), real_t(3));
+	}, "gen_vector");
+	_test_philox_mt_invariance<rng_t>([](rng_t& r, real_t* p, const size_t n, const bool bMt) {
+		if (bMt) r.gen_vector_norm_mt(p, n); else r.gen_vector_norm_st(p, n);
+	}, "gen_vector_norm");
+	_test_philox_mt_invariance<rng_t>([](rng_t& r, real_t* p, const size_t n, const bool bMt) {
+		if (bMt) r.gen_vector_gtz_mt(p, n, real_t(2)); else r.gen_vector_gtz_st(p, n, real_t(2));
+	}, "gen_vector_gtz");
+	_test_philox_mt_invariance<rng_t>([](rng_t& r, real_t* p, const size_t n, const bool bMt) {
+		if (bMt) r.bernoulli_vector_mt(p, n, real_t(.3), real_t(1), real_t(0)); else r.bernoulli_vector_st(p, n, real_t(.3), real_t(1), real_t(0));
+	}, "bernoulli_vector");
+	_test_philox_mt_invariance<rng_t>([](rng_t& r, real_t* p, const size_t n, const bool bMt) {
+		if (bMt) r.normal_vector_mt(p, n, real_t(0), real_t(1)); else r.normal_vector_st(p, n, real_t(0), real_t(1));
+	}, "normal_vector");
+
+	//bernoulli_bits must agree with bernoulli_vector made from the same stream positions
+	def_threads_t Thr;
+	constexpr realmtx_t::numel_cnt_t totalElms = 100003;
+	const auto nw = realmtx_t::sBitMaskWords(totalElms);
+	::std::vector<realmtx_t::bitmask_word_t> bSt(nw), bMt(nw);
+	::std::vector<real_t> v(totalElms);
+	rng_t rSt(Thr, 7), rMt(Thr, 7), rV(Thr, 7);
+	rSt.bernoulli_bits_st(&bSt.front(), totalElms, real_t(.25));
+	rMt.bernoulli_bits_mt(&bMt.front(), totalElms, real_t(.25));
+	rV.bernoulli_vector_st(&v.front(), totalElms, real_t(.25), real_t(1), real_t(0));
+	ASSERT_TRUE(bSt == bMt);
+	for (realmtx_t::numel_cnt_t i = 0; i < totalElms; ++i) {
+		ASSERT_EQ(real_t(1) == v[i], 0 != ((bSt[i / 64] >> (i % 64)) & 1)) << "i=" << i;
+	}
+}
+
+TEST(TestRNG, PhiloxDistributions) {
+	typedef nntl::d_interfaces::iThreads_t def_threads_t;
+	typedef rng::Philox<real_t, def_threads_t> rng_t;
+	constexpr unsigned totalElms = 1000000;
+
+	def_threads_t Thr;
+	rng_t iR(Thr, 1);
+	::std::vector<real_t> dest(totalElms);
+
+	const auto check = [&dest](const real_t targMean, const real_t targStddev, const real_t eps) {
+		::boost::accumulators::accumulator_set<real_t, ::boost::accumulators::stats<
+			::boost::accumulators::tag::mean
+			, ::boost::accumulators::tag::lazy_variance >
+		> acc;
+		for (const auto& v : dest) {
+			acc(v);
+		}
+		const real_t _mean = ::boost::accumulators::extract_result< ::boost::accumulators::tag::mean >(acc)
+			, _std = ::std::sqrt(::boost::accumulators::extract_result< ::boost::accumulators::tag::lazy_variance >(acc));
+		STDCOUTL("Mean = " << _mean << ", std = " << _std);
+		ASSERT_NEAR(_mean, targMean, eps) << "Wrong mean!!!";
+		ASSERT_NEAR(_std, targStddev, eps) << "Wrong StdDev!!!";
+	};
+
+	iR.gen_vector_norm(&dest.front(), totalElms);
+	check(real_t(.5), real_t(::std::sqrt(1. / 12)), real_t(5e-3));
+	iR.gen_vector(&dest.front(), totalElms, real_t(-1), real_t(3));
+	check(real_t(1), real_t(4 * ::std::sqrt(1. / 12)), real_t(2e-2));
+	iR.normal_vector(&dest.front(), totalElms, real_t(.5), real_t(2));
+	check(real_t(.5), real_t(2), real_t(2e-2));
+
+	//scalar generators read the very same stream
+	rng_t r1(Thr, 3), r2(Thr, 3);
+	r1.gen_vector_norm(&dest.front(), 10);
+	for (unsigned i = 0; i < 10; ++i) ASSERT_EQ(dest[i], r2.gen_f_norm());
+	ASSERT_EQ(r1.position(), r2.position());
+}
+
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+template<typename iRngT>
+void _test_ziggurat_moments(iRngT& iR, const char* pName) {
+	typedef ::std::vector<real_t> vec_t;
+	static constexpr real_t targMean(real_t(.5)), targStddev(real_t(2.));
+	static constexpr unsigned totalElms = 1000000;
+	STDCOUTL("Testing distr_normal_ziggurat over " << pName);
+
+	vec_t dest(totalElms);
+	rng::distr_normal_ziggurat<iRngT> d(iR, targMean, targStddev);
+	d.gen_vector(&dest.front(), totalElms);
+
+	::boost::accumulators::accumulator_set<real_t, ::boost::accumulators::stats<
+		::boost::accumulators::tag::mean
+		, ::boost::accumulators::tag::lazy_variance >
+	> acc;
+	//the mass beyond 3 stddevs checks that wedges and the tail are sampled right. Expected value is 2*(1-Phi(3)) = 0.0027
+	unsigned tailCnt = 0;
+	for (const auto& v : dest) {
+		acc(v);
+		tailCnt += ::std::abs(v - targMean) > 3 * targStddev;
+	}
+	const real_t _mean = ::boost::accumulators::extract_result< ::boost::accumulators::tag::mean >(acc)
+		, _std = ::std::sqrt(::boost::accumulators::extract_result< ::boost::accumulators::tag::lazy_variance >(acc));
+	const double tailMass = double(tailCnt) / totalElms;
+	STDCOUTL("Mean = " << _mean << ", std = " << _std << ", P(|x-m|>3std) = " << tailMass);
+	ASSERT_NEAR(_mean, targMean, NormDistrCompat_EPS<real_t>::eps) << "Wrong mean!!!";
+	ASSERT_NEAR(_std, targStddev, NormDistrCompat_EPS<real_t>::eps) << "Wrong StdDev!!!";
+	ASSERT_NEAR(tailMass, 0.0027, 0.0003) << "Wrong tail mass!!!";
+}
+
+TEST(TestRNG, ZigguratNormal) {
+	typedef nntl::d_interfaces::iThreads_t def_threads_t;
+	def_threads_t Thr;
+	{
+		d_interfaces::iRng_t iR(Thr);
+		_test_ziggurat_moments(iR, "d_interfaces::iRng_t");
+	}
+	{
+		rng::AFRand<real_t, AFog::CRandomSFMT0> iR;
+		_test_ziggurat_moments(iR, "AFRand<CRandomSFMT0>");
+	}
+	{
+		rng::Philox<real_t, def_threads_t> iR(Thr);
+		_test_ziggurat_moments(iR, "Philox");
+	}
+
+	//vectorized kernels must give exactly the same samples as the scalar code (m==0 && st==1 to exclude fma effects),
+	// and with a counter-based rng the result must not depend on the number of threads
+	typedef rng::Philox<real_t, def_threads_t> rng_t;
+	constexpr size_t totalElms = 100003;
+	::std::vector<real_t> vS(totalElms), vV(totalElms), v1(totalElms);
+	{
+		rng_t iR(Thr, 5);
+		rng::distr_normal_ziggurat<rng_t> d(iR);
+		math::simd::set_max_isa(math::simd::isa::scalar);
+		d.gen_vector(&vS.front(), totalElms);
+		math::simd::set_max_isa(math::simd::isa::avx512);
+	}
+	{
+		rng_t iR(Thr, 5);
+		rng::distr_normal_ziggurat<rng_t> d(iR);
+		d.gen_vector(&vV.front(), totalElms);
+	}
+	{
+		rng_t iR(Thr, 5);
+		rng::distr_normal_ziggurat<rng_t> d(iR);
+		const auto prevMax = Thr.max_threads();
+		Thr.max_threads(1);
+		d.gen_vector(&v1.front(), totalElms);
+		Thr.max_threads(prevMax);
+	}
+	ASSERT_TRUE(vS == vV) << "Vectorized Ziggurat differs from the scalar one";
+	ASSERT_TRUE(vS == v1) << "Result depends on the number of threads";
+}
+
+//////////////////////////////////////////////////////////////////////////
+// checkpoints and epoch seeking
+template<typename RngT, typename GenT>
+void _test_rng_checkpoint(RngT& rg, RngT& rgLoad, GenT&& gen, const char* pName) {
+	const char *const pFileName = "./test_data/test_rng_state.mat";
+	constexpr size_t totalElms = 50003;
+	::std::vector<real_t> vET(totalElms), v(totalElms);
+
+	gen(rg, &vET.front(), totalElms);
+	{
+		nntl_supp::omatfile<> mf;
+		ASSERT_EQ(mf.ErrorCode::Success, mf.open(pFileName)) << pName;
+		mf & serialization::make_named_struct("iRng", rg);
+		ASSERT_EQ(mf.ErrorCode::Success, mf.get_last_error()) << pName << ": " << mf.get_last_error_str();
+	}
+	gen(rg, &vET.front(), totalElms);
+	{
+		nntl_supp::imatfile<> mf;
+		ASSERT_EQ(mf.ErrorCode::Success, mf.open(pFileName)) << pName;
+		mf & serialization::make_named_struct("iRng", rgLoad);
+		ASSERT_EQ(mf.ErrorCode::Success, mf.get_last_error()) << pName << ": " << mf.get_last_error_str();
+	}
+	gen(rgLoad, &v.front(), totalElms);
+	ASSERT_TRUE(vET == v) << pName << ": restored rng produces a different sequence";
+
+	//seeking depends only on the seed and the epoch
+	rg.seek_epoch(5);
+	gen(rg, &vET.front(), totalElms);
+	rg.seek_epoch(2);
+	gen(rg, &v.front(), totalElms);
+	ASSERT_FALSE(vET == v) << pName << ": different epochs give the same sequence";
+	rgLoad.seek_epoch(5);
+	gen(rgLoad, &v.front(), totalElms);
+	ASSERT_TRUE(vET == v) << pName << ": seek_epoch() isn't reproducible";
+}
+
+TEST(TestRNG, CheckpointAndSeek) {
+	typedef nntl::d_interfaces::iThreads_t def_threads_t;
+	def_threads_t Thr;
+
+	auto genF = [](auto& r, real_t* p, const size_t n) {
+		r.gen_vector(p, n / 2, real_t(2));
+		r.normal_vector(p + n / 2, n - n / 2, real_t(0), real_t(1));
+	};
+	{
+		rng::AFRand<real_t, AFog::CRandomSFMT0> r(11), rL(12);
+		_test_rng_checkpoint(r, rL, genF, "AFRand<CRandomSFMT0>");
+	}
+	{
+		rng::AFRand<real_t, AFog::CRandomMersenne> r(11), rL(12);
+		_test_rng_checkpoint(r, rL, genF, "AFRand<CRandomMersenne>");
+	}
+	{
+		rng::AFRand_mt<real_t, AFog::CRandomSFMT0, def_threads_t> r(Thr, 11), rL(Thr, 12);
+		_test_rng_checkpoint(r, rL, genF, "AFRand_mt<CRandomSFMT0>");
+	}
+	{
+		rng::Philox<real_t, def_threads_t> r(Thr, 11), rL(Thr, 12);
+		_test_rng_checkpoint(r, rL, genF, "Philox");
+	}
+	{
+		//without a known demand nothing is pregenerated, so the whole sequence comes from the synchronous generators
+		rng::AFRand_as<real_t, AFog::CRandomSFMT0, def_threads_t> r(Thr, 11), rL(Thr, 12);
+		_test_rng_checkpoint(r, rL, genF, "AFRand_as<CRandomSFMT0>");
+	}
+	{
+		//the state of CStd is static, so the same object is used to restore it
+		rng::CStd<real_t> r(11);
+		_test_rng_checkpoint(r, r, [](auto& r, real_t* p, const size_t n) { r.gen_vector(p, n, real_t(2)); }, "CStd");
+	}
+}
+
+TEST(TestRNG, CheckpointAsynchRngDemand) {
+	typedef nntl::d_interfaces::iThreads_t def_threads_t;
+	typedef rng::AFRand_as<real_t, AFog::CRandomSFMT0, def_threads_t> rng_t;
+	const char *const pFileName = "./test_data/test_rng_state.mat";
+	def_threads_t Thr;
+
+	//saving must work while the background threads generate the data and must restore the learned demand
+	rng_t r(Thr, 11), rL(Thr, 12);
+	r.preinit_additive_norm(1000);
+	r.preinit_additive_normal_distr(3000);
+	ASSERT_TRUE(r.init_rng());
+	ASSERT_TRUE(r.buffer_size() > 0);
+	{
+		nntl_supp::omatfile<> mf;
+		ASSERT_EQ(mf.ErrorCode::Success, mf.open(pFileName));
+		mf & serialization::make_named_struct("iRng", r);
+		ASSERT_EQ(mf.ErrorCode::Success, mf.get_last_error()) << mf.get_last_error_str();
+	}
+	{
+		nntl_supp::imatfile<> mf;
+		ASSERT_EQ(mf.ErrorCode::Success, mf.open(pFileName));
+		mf & serialization::make_named_struct("iRng", rL);
+		ASSERT_EQ(mf.ErrorCode::Success, mf.get_last_error()) << mf.get_last_error_str();
+	}
+	ASSERT_TRUE(rL.init_rng());
+	ASSERT_EQ(r.buffer_size(), rL.buffer_size());
+}
@@ -0,0 +1,294 @@
+/*
+This file is a part of NNTL project (https://github.com/Arech/nntl)
+
+Copyright (c) 2015-2016, Arech (aradvert@gmail.com; https://github.com/Arech)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+* Neither the name of NNTL nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "stdafx.h"
+
+#include "../nntl/math.h"
+#include "../nntl/common.h"
+
+#include "../nntl/interface/math/mathn.h"
+#include "../nntl/interfaces.h"
+
+#include "../nntl/utils/tictoc.h"
+#include "asserts.h"
+
+using namespace nntl;
+using namespace nntl::utils;
+using namespace nntl::math;
+
+typedef d_interfaces::iThreads_t iThreads_t;
+typedef math::MathN<real_t, iThreads_t> imath_basic_t;
+
+static imath_basic_t iM;
+
+#ifdef TESTS_SKIP_LONGRUNNING
+constexpr unsigned TEST_PERF_REPEATS_COUNT = 10;
+#else
+constexpr unsigned TEST_PERF_REPEATS_COUNT = 300;
+#endif
+
+template<typename base_t> struct simd_EPS {};
+template<> struct simd_EPS<double> { static constexpr double eps = 1e-12; };
+template<> struct simd_EPS<float> { static constexpr float eps = 2e-6f; };
+
+struct isa_scope {
+	~isa_scope()noexcept { simd::set_max_isa(simd::isa::avx512); }
+	isa_scope(const simd::isa i)noexcept { simd::set_max_isa(i); }
+};
+
+//runs f over the same data with the scalar code and with every supported instruction set and compares results
+template<typename F>
+void test_simd_vs_scalar(F&& f, const char* descr, const real_t genScale, const bool bNonNegative = false) {
+	d_interfaces::iRng_t rg;
+	rg.init_ithreads(iM.ithreads());
+
+	const auto supported = simd::supported_isa();
+	//various sizes to check tails processing
+	for (vec_len_t r = 1; r < 41; r += 3) {
+		for (vec_len_t c = 1; c < 6; ++c) {
+			MTXSIZE_SCOPED_TRACE(r, c, descr);
+			realmtx_t src(r, c), F_ET(r, c), F(r, c);
+			ASSERT_TRUE(!src.isAllocationFailed() && !F_ET.isAllocationFailed() && !F.isAllocationFailed());
+			if (bNonNegative) {
+				rg.gen_matrix_gtz(src, genScale);
+			} else rg.gen_matrix(src, genScale);
+
+			src.clone_to(F_ET);
+			{
+				isa_scope s(simd::isa::scalar);
+				f(F_ET);
+			}
+			for (unsigned i = static_cast<unsigned>(simd::isa::avx2); i <= static_cast<unsigned>(supported); ++i) {
+				isa_scope s(static_cast<simd::isa>(i));
+				src.clone_to(F);
+				f(F);
+				ASSERT_REALMTX_NEAR(F_ET, F, simd::isa_name(simd::active_isa()), simd_EPS<real_t>::eps);
+			}
+		}
+	}
+}
+
+TEST(TestSimd, ISA) {
+	const auto s = simd::supported_isa();
+	STDCOUTL("Supported instruction set: " << simd::isa_name(s));
+	ASSERT_EQ(s, simd::active_isa());
+	{
+		isa_scope sc(simd::isa::scalar);
+		ASSERT_EQ(simd::isa::scalar, simd::active_isa());
+	}
+	ASSERT_EQ(s, simd::active_isa());
+}
+
+TEST(TestSimd, Activations) {
+	const real_t alpha = real_t(2.5), lambda = real_t(1.050700), a_t_l = real_t(1.6732632)*lambda;
+	const real_t b = real_t(2), b_neg = real_t(3), b_pos = real_t(2), a = real_t(1.5), c = real_t(2);
+
+	ASSERT_NO_FATAL_FAILURE(test_simd_vs_scalar([](realmtx_t& X) { iM.sigm_st(X); }, "sigm", real_t(10)));
+	ASSERT_NO_FATAL_FAILURE(test_simd_vs_scalar([&](realmtx_t& X) { iM.elu_st(X, alpha); }, "elu", real_t(5)));
+	ASSERT_NO_FATAL_FAILURE(test_simd_vs_scalar([](realmtx_t& X) { iM.elu_unitalpha_st(X); }, "elu_unitalpha", real_t(5)));
+	ASSERT_NO_FATAL_FAILURE(test_simd_vs_scalar([&](realmtx_t& X) { iM.selu_st(X, a_t_l, lambda); }, "selu", real_t(5)));
+	ASSERT_NO_FATAL_FAILURE(test_simd_vs_scalar([&](realmtx_t& X) { iM.elogu_st(X, alpha, b); }, "elogu", real_t(5)));
+	ASSERT_NO_FATAL_FAILURE(test_simd_vs_scalar([&](realmtx_t& X) { iM.elogu_ua_st(X, b); }, "elogu_ua", real_t(5)));
+	ASSERT_NO_FATAL_FAILURE(test_simd_vs_scalar([&](realmtx_t& X) { iM.loglogu_st(X, b_neg, b_pos); }, "loglogu", real_t(5)));
+	ASSERT_NO_FATAL_FAILURE(test_simd_vs_scalar([&](realmtx_t& X) { iM.softsign_st(X, a, c); }, "softsign", real_t(5)));
+	ASSERT_NO_FATAL_FAILURE(test_simd_vs_scalar([&](realmtx_t& X) { iM.softsign_uc_st(X, a); }, "softsign_uc", real_t(5)));
+}
+
+TEST(TestSimd, ActivationDerivatives) {
+	const real_t alpha = real_t(2.5), lambda = real_t(1.050700), a_t_l = real_t(1.6732632)*lambda;
+	const real_t b = real_t(2), b_neg = real_t(3), b_pos = real_t(2), a = real_t(1.5), c = real_t(2);
+
+	ASSERT_NO_FATAL_FAILURE(test_simd_vs_scalar([](realmtx_t& X) { iM.dsigm_st(X); }, "dsigm", real_t(1), true));
+	ASSERT_NO_FATAL_FAILURE(test_simd_vs_scalar([&](realmtx_t& X) { iM.delu_st(X, alpha); }, "delu", real_t(2)));
+	ASSERT_NO_FATAL_FAILURE(test_simd_vs_scalar([](realmtx_t& X) { iM.delu_unitalpha_st(X); }, "delu_unitalpha", real_t(1)));
+	ASSERT_NO_FATAL_FAILURE(test_simd_vs_scalar([&](realmtx_t& X) { iM.dselu_st(X, a_t_l, lambda); }, "dselu", real_t(2)));
+	ASSERT_NO_FATAL_FAILURE(test_simd_vs_scalar([&](realmtx_t& X) { iM.delogu_st(X, alpha, b); }, "delogu", real_t(2)));
+	ASSERT_NO_FATAL_FAILURE(test_simd_vs_scalar([&](realmtx_t& X) { iM.delogu_ua_st(X, b); }, "delogu_ua", real_t(1)));
+	ASSERT_NO_FATAL_FAILURE(test_simd_vs_scalar([&](realmtx_t& X) { iM.dloglogu_st(X, b_neg, b_pos); }, "dloglogu", real_t(2)));
+	ASSERT_NO_FATAL_FAILURE(test_simd_vs_scalar([&](realmtx_t& X) { iM.dsoftsign_st(X, a, c); }, "dsoftsign", c));
+	ASSERT_NO_FATAL_FAILURE(test_simd_vs_scalar([](realmtx_t& X) { iM.dsoftsign_ua_uc_st(X); }, "dsoftsign_ua_uc", real_t(1)));
+}
+
+//max relative errors of vectorized elementary functions for both accuracy policies
+template<typename base_t> struct vmath_EPS {};
+template<> struct vmath_EPS<double> { static constexpr double accurate = 2e-15, fast = 1e-4; };
+template<> struct vmath_EPS<float> { static constexpr float accurate = 3e-7f, fast = 1e-4f; };
+
+template<typename VT, typename VF, typename SF>
+void test_vmath_func(VF&& vf, SF&& sf, const ::std::vector<real_t>& x, const real_t relEps, const char* descr) {
+	::std::vector<real_t> y(x.size());
+	ASSERT_EQ(0, x.size() % VT::width);
+	for (size_t i = 0; i < x.size(); i += VT::width) VT::store(&y[i], vf(VT::load(&x[i])));
+	for (size_t i = 0; i < x.size(); ++i) {
+		const real_t et = sf(x[i]);
+		ASSERT_NEAR(et, y[i], relEps*::std::max(::std::abs(et), ::std::numeric_limits<real_t>::min()))
+			<< descr << " failed @ x=" << x[i];
+	}
+}
+
+template<typename VT, typename AccT>
+void test_vmath(const real_t relEps) {
+	typedef typename VT::vec_t vec_t;
+	constexpr size_t N = 4096;
+	::std::vector<real_t> xExp(N), xLog(N), xSmall(N);
+	for (size_t i = 0; i < N; ++i) {
+		const real_t t = real_t(i) / real_t(N - 1);
+		xExp[i] = real_t(-85) + real_t(170)*t;
+		xLog[i] = ::std::exp(real_t(-80) + real_t(160)*t);
+		//exercising both the vicinity of zero and the rest of the domain of expm1() and log1p()
+		xSmall[i] = i & 1 ? real_t(-.9) + real_t(3)*t : real_t(1e-4)*(t - real_t(.5));
+	}
+	ASSERT_NO_FATAL_FAILURE(test_vmath_func<VT>([](const vec_t v) { return simd::vexp<VT, AccT>(v); }
+		, [](const real_t v) { return ::std::exp(v); }, xExp, relEps, "vexp"));
+	ASSERT_NO_FATAL_FAILURE(test_vmath_func<VT>([](const vec_t v) { return simd::vexpm1<VT, AccT>(v); }
+		, [](const real_t v) { return ::std::expm1(v); }, xSmall, relEps, "vexpm1"));
+	ASSERT_NO_FATAL_FAILURE(test_vmath_func<VT>([](const vec_t v) { return simd::vexpm1<VT, AccT>(v); }
+		, [](const real_t v) { return ::std::expm1(v); }, xExp, relEps, "vexpm1 (wide)"));
+	ASSERT_NO_FATAL_FAILURE(test_vmath_func<VT>([](const vec_t v) { return simd::vlog<VT, AccT>(v); }
+		, [](const real_t v) { return ::std::log(v); }, xLog, relEps, "vlog"));
+	ASSERT_NO_FATAL_FAILURE(test_vmath_func<VT>([](const vec_t v) { return simd::vlog1p<VT, AccT>(v); }
+		, [](const real_t v) { return ::std::log1p(v); }, xSmall, relEps, "vlog1p"));
+
+	//NaN must pass through, exp() and expm1() must saturate
+	const real_t inf = ::std::numeric_limits<real_t>::infinity();
+	::std::vector<real_t> xSpec(VT::width), y(VT::width);
+	for (unsigned i = 0; i < VT::width; ++i) xSpec[i] = i & 1 ? real_t(1000) : -real_t(1000);
+	xSpec[0] = ::std::numeric_limits<real_t>::quiet_NaN();
+	const auto vs = VT::load(&xSpec[0]);
+
+	VT::store(&y[0], simd::vexp<VT, AccT>(vs));
+	ASSERT_TRUE(::std::isnan(y[0])) << "vexp(NaN)";
+	for (unsigned i = 1; i < VT::width; ++i) ASSERT_EQ(i & 1 ? inf : real_t(0), y[i]) << "vexp(" << xSpec[i] << ")";
+	VT::store(&y[0], simd::vexpm1<VT, AccT>(vs));
+	ASSERT_TRUE(::std::isnan(y[0])) << "vexpm1(NaN)";
+	for (unsigned i = 1; i < VT::width; ++i) ASSERT_EQ(i & 1 ? inf : real_t(-1), y[i]) << "vexpm1(" << xSpec[i] << ")";
+	VT::store(&y[0], simd::vlog<VT, AccT>(vs));
+	ASSERT_TRUE(::std::isnan(y[0])) << "vlog(NaN)";
+	VT::store(&y[0], simd::vlog1p<VT, AccT>(vs));
+	ASSERT_TRUE(::std::isnan(y[0])) << "vlog1p(NaN)";
+}
+
+TEST(TestSimd, VMath) {
+	const auto supported = simd::supported_isa();
+#if NNTL_SIMD_AVX2
+	if (supported >= simd::isa::avx2) {
+		typedef simd::vtraits<simd::isa::avx2, real_t> VT;
+		ASSERT_NO_FATAL_FAILURE((test_vmath<VT, simd::vmath_accurate>(vmath_EPS<real_t>::accurate)));
+		ASSERT_NO_FATAL_FAILURE((test_vmath<VT, simd::vmath_fast>(vmath_EPS<real_t>::fast)));
+	}
+#endif
+#if NNTL_SIMD_AVX512
+	if (supported >= simd::isa::avx512) {
+		typedef simd::vtraits<simd::isa::avx512, real_t> VT;
+		ASSERT_NO_FATAL_FAILURE((test_vmath<VT, simd::vmath_accurate>(vmath_EPS<real_t>::accurate)));
+		ASSERT_NO_FATAL_FAILURE((test_vmath<VT, simd::vmath_fast>(vmath_EPS<real_t>::fast)));
+	}
+#endif
+	NNTL_UNREF(supported);
+}
+
+template<typename base_t> struct simd_loss_EPS {};
+template<> struct simd_loss_EPS<double> { static constexpr double eps = 1e-10; };
+template<> struct simd_loss_EPS<float> { static constexpr float eps = 1e-4f; };
+
+TEST(TestSimd, SoftmaxAndLoss) {
+	d_interfaces::iRng_t rg;
+	rg.init_ithreads(iM.ithreads());
+	const auto supported = simd::supported_isa();
+
+	for (vec_len_t r = 1; r < 41; r += 3) {
+		for (vec_len_t c = 1; c < 6; ++c) {
+			MTXSIZE_SCOPED_TRACE(r, c, "softmax & loss_xentropy");
+			realmtxdef_t src(r, c), S_ET(r, c), S(r, c);
+			realmtx_t Y(r, c);
+			ASSERT_TRUE(!src.isAllocationFailed() && !S_ET.isAllocationFailed() && !S.isAllocationFailed() && !Y.isAllocationFailed());
+			iM.preinit(iM.softmax_needTempMem(src));
+			ASSERT_TRUE(iM.init());
+
+			rg.gen_matrix(src, real_t(5));
+			rg.gen_matrix_norm(Y);
+			iM.ewBinarize_ip(Y, real_t(.5));
+
+			real_t etLoss;
+			src.clone_to(S_ET);
+			{
+				isa_scope s(simd::isa::scalar);
+				iM.softmax_st(S_ET);
+				etLoss = iM.loss_xentropy_st(S_ET, Y);
+			}
+			for (unsigned i = static_cast<unsigned>(simd::isa::avx2); i <= static_cast<unsigned>(supported); ++i) {
+				isa_scope s(static_cast<simd::isa>(i));
+				src.clone_to(S);
+				iM.softmax_st(S);
+				ASSERT_REALMTX_NEAR(S_ET, S, simd::isa_name(simd::active_isa()), simd_EPS<real_t>::eps);
+				//summation order differs, so the relative error is checked
+				ASSERT_NEAR(etLoss, iM.loss_xentropy_st(S_ET, Y), simd_loss_EPS<real_t>::eps*::std::max(real_t(1), ::std::abs(etLoss)))
+					<< simd::isa_name(simd::active_isa());
+			}
+		}
+	}
+}
+
+template<typename F>
+void test_simd_perf(F&& f, const char* descr, const vec_len_t rowsCnt, const vec_len_t colsCnt = 100) {
+	realmtx_t src(rowsCnt, colsCnt), X(rowsCnt, colsCnt);
+	ASSERT_TRUE(!src.isAllocationFailed() && !X.isAllocationFailed());
+	d_interfaces::iRng_t rg;
+	rg.init_ithreads(iM.ithreads());
+	rg.gen_matrix(src, real_t(5));
+
+	threads::prioritize_workers<threads::PriorityClass::PerfTesting, iThreads_t> pw(iM.ithreads());
+	tictoc tScalar, tSimd;
+	for (unsigned r = 0; r < TEST_PERF_REPEATS_COUNT; ++r) {
+		{
+			isa_scope s(simd::isa::scalar);
+			src.copy_to(X);
+			tScalar.tic();
+			f(X);
+			tScalar.toc();
+		}
+		src.copy_to(X);
+		tSimd.tic();
+		f(X);
+		tSimd.toc();
+	}
+	STDCOUTL(descr << " over " << rowsCnt << "x" << colsCnt << ", scalar vs. " << simd::isa_name(simd::active_isa()) << ":");
+	tScalar.say("scalar");
+	tSimd.say("simd");
+}
+
+TEST(TestSimd, ActivationsPerf) {
+	const real_t alpha = real_t(2.5), b_neg = real_t(3), b_pos = real_t(2);
+	test_simd_perf([](realmtx_t& X) { iM.sigm_st(X); }, "sigm", 1000);
+	test_simd_perf([&](realmtx_t& X) { iM.elu_st(X, alpha); }, "elu", 1000);
+	test_simd_perf([&](realmtx_t& X) { iM.loglogu_st(X, b_neg, b_pos); }, "loglogu", 1000);
+	test_simd_perf([&](realmtx_t& X) { iM.dloglogu_st(X, b_neg, b_pos); }, "dloglogu", 1000);
+}
@@ -37,6 +37,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //#include "../nntl/interface/threads/winqdu.h"
 //#include "../nntl/interface/threads/std.h"
 #include "../nntl/interface/threads/workers.h"
+#include "../nntl/interface/threads/ws_workers.h"
+#include "../nntl/interface/threads/numa.h"
 #include "../nntl/interfaces.h"
 #include "../nntl/utils/chrono.h"
 #include "../nntl/interface/rng/cstd.h"
@@ -137,6 +139,187 @@ TEST(TestThreading, WorkersBasics) {
 	threads_basics_test(t);
 }
 
+TEST(TestThreading, WorkersSpinParkBasics) {
+	threads::Workers<real_t, math::smatrix_td::numel_cnt_t, threads::spin_park_sync_primitives> t;
+	threads_basics_test(t);
+	//let the workers park and make sure they wake up
+	::std::this_thread::sleep_for(::std::chrono::milliseconds(100));
+	threads_basics_test(t);
+	t.spin_count(0);
+	threads_basics_test(t);
+}
+
+TEST(TestThreading, WsWorkersBasics) {
+	threads::WsWorkers<real_t, math::smatrix_td::numel_cnt_t> t;
+	threads_basics_test(t);
+	threads_basics_test(t);
+}
+
+template<typename TT>
+void threads_pool_size_test(const thread_id_t nThreads) {
+	typedef typename TT::range_t range_t;
+	typedef typename TT::par_range_t par_range_t;
+
+	TT t(nThreads);
+	const thread_id_t poolSize = ::std::min(nThreads, TT::workers_count());
+	thread_id_t threadsCnt;
+	t.get_worker_threads(threadsCnt);
+	ASSERT_EQ(poolSize - 1, threadsCnt);
+	ASSERT_EQ(poolSize, t.max_threads());
+	ASSERT_EQ(poolSize, t.max_threads(poolSize + 1)) << "max_threads() must not exceed the pool size";
+
+	const range_t cnt = 10 * TT::workers_count();
+	::std::vector<int> hits(cnt, 0);
+	::std::atomic<int> badTids(0);
+	thread_id_t used = 0;
+	t.run([&hits, &badTids, poolSize](const par_range_t& r) {
+		if (r.tid() >= poolSize) ++badTids;
+		for (range_t i = r.offset(), e = r.offset() + r.cnt(); i < e; ++i) ++hits[i];
+	}, cnt, 0, &used);
+	ASSERT_EQ(0, badTids.load());
+	ASSERT_LE(used, poolSize);
+	for (range_t i = 0; i < cnt; ++i) ASSERT_EQ(1, hits[i]) << "element " << i;
+
+	const real_t s = t.reduce([](const par_range_t& r) { return static_cast<real_t>(r.cnt()); }
+		, [poolSize](const real_t* p, const range_t n) {
+		EXPECT_LE(n, poolSize);
+		real_t ret(0);
+		for (range_t i = 0; i < n; ++i) ret += p[i];
+		return ret;
+	}, cnt);
+	ASSERT_DOUBLE_EQ(static_cast<real_t>(cnt), s);
+}
+
+TEST(TestThreading, PoolSize) {
+	for (const thread_id_t n : { thread_id_t(1), thread_id_t(2), threads::Workers<real_t>::workers_count() + 1 }) {
+		threads_pool_size_test<threads::Workers<real_t, math::smatrix_td::numel_cnt_t>>(n);
+		threads_pool_size_test<threads::Workers<real_t, math::smatrix_td::numel_cnt_t, threads::spin_park_sync_primitives>>(n);
+		threads_pool_size_test<threads::WsWorkers<real_t, math::smatrix_td::numel_cnt_t>>(n);
+	}
+}
+
+TEST(TestThreading, WsWorkersDynamicNestedSpawn) {
+	typedef threads::WsWorkers<real_t, math::smatrix_td::numel_cnt_t> thr_t;
+	typedef thr_t::range_t range_t;
+	typedef thr_t::par_range_t par_range_t;
+
+	thr_t t;
+	const auto workersCnt = t.workers_count();
+	constexpr range_t total = 100003;
+	::std::unique_ptr<::std::atomic<int>[]> marks(new ::std::atomic<int>[total]);
+	auto resetMarks = [&marks]() {
+		for (range_t i = 0; i < total; ++i) marks[i].store(0);
+	};
+	auto checkMarks = [&marks](const int v, const char* descr) {
+		for (range_t i = 0; i < total; ++i) ASSERT_EQ(v, marks[i].load()) << descr << ": wrong mark at " << i;
+	};
+
+	//dynamic chunking must touch every element exactly once
+	for (const range_t grain : { range_t(1), range_t(7), range_t(1000), total }) {
+		resetMarks();
+		t.run_dynamic([&marks, workersCnt](const par_range_t& r) {
+			EXPECT_TRUE(r.tid() < workersCnt);
+			for (range_t i = 0; i < r.cnt(); ++i) marks[r.offset() + i]++;
+		}, total, grain);
+		ASSERT_NO_FATAL_FAILURE(checkMarks(1, "run_dynamic"));
+	}
+
+	//nested regions: every outer slot processes its own part with a nested run() and run_dynamic()
+	resetMarks();
+	::std::unique_ptr<::std::atomic<int>[]> slotSeen(new ::std::atomic<int>[workersCnt]);
+	for (thread_id_t i = 0; i < workersCnt; ++i) slotSeen[i].store(0);
+	t.run([&t, &marks, &slotSeen](const par_range_t& ro) {
+		slotSeen[ro.tid()]++;
+		const auto ofs = ro.offset();
+		t.run([&marks, ofs](const par_range_t& ri) {
+			for (range_t i = 0; i < ri.cnt(); ++i) marks[ofs + ri.offset() + i]++;
+		}, ro.cnt());
+		t.run_dynamic([&marks, ofs](const par_range_t& ri) {
+			for (range_t i = 0; i < ri.cnt(); ++i) marks[ofs + ri.offset() + i]++;
+		}, ro.cnt(), 100);
+	}, total);
+	ASSERT_NO_FATAL_FAILURE(checkMarks(2, "nested run"));
+	for (thread_id_t i = 0; i < workersCnt; ++i) ASSERT_EQ(1, slotSeen[i].load()) << "each slot must be executed exactly once";
+
+	//fire-and-forget tasks, including spawned from inside of a parallel region
+	::std::atomic<int> spawnedDone(0);
+	constexpr int spawnCnt = 1000;
+	for (int i = 0; i < spawnCnt; ++i) {
+		t.spawn([&spawnedDone](const thread_id_t) { spawnedDone++; });
+	}
+	t.run([&t, &spawnedDone](const par_range_t& r) {
+		for (range_t i = 0; i < r.cnt(); ++i) t.spawn([&spawnedDone](const thread_id_t) { spawnedDone++; });
+	}, spawnCnt);
+	t.wait_spawned();
+	ASSERT_EQ(2 * spawnCnt, spawnedDone.load());
+
+	//must not hang and must account for the calling thread
+	const bool bDenormals = t.denormalsOnInAnyThread();
+	if (isDenormalsOn()) ASSERT_TRUE(bDenormals);
+}
+
+TEST(TestThreading, NumaHelpers) {
+	typedef threads::Workers<real_t, math::smatrix_td::numel_cnt_t> thr_t;
+	typedef thr_t::range_t range_t;
+	using namespace threads::numa;
+
+	const topology topo;
+	ASSERT_TRUE(!topo.cpus().empty() && topo.nodes_count() > 0);
+	const auto compactOrd = topo.order(PinOrder::Compact), scatterOrd = topo.order(PinOrder::Scatter);
+	ASSERT_EQ(topo.cpus().size(), compactOrd.size());
+	ASSERT_EQ(topo.cpus().size(), scatterOrd.size());
+	if (topo.nodes_count() > 1) ASSERT_NE(scatterOrd[0].node, scatterOrd[1].node);
+
+	thr_t t;
+	const auto workersCnt = t.workers_count();
+	constexpr range_t total = 100003;
+	::std::unique_ptr<real_t[]> buf(new real_t[total]);
+	::std::unique_ptr<real_t[]> src(new real_t[total]);
+	for (range_t i = 0; i < total; ++i) {
+		buf[i] = real_t(1);
+		src[i] = static_cast<real_t>(i);
+	}
+
+	for (const auto po : { PinOrder::Compact, PinOrder::Scatter }) {
+		pin_workers<thr_t> pw(t, po);
+		ASSERT_EQ(static_cast<size_t>(workersCnt), pw.tid_nodes().size());
+		if (!pw.pinned()) STDCOUTL("Threads weren't pinned, the test checks the placement helpers only");
+
+		first_touch(t, buf.get(), total);
+		for (range_t i = 0; i < total; ++i) ASSERT_EQ(real_t(0), buf[i]) << "first_touch must zero the memory";
+
+		node_replicas<real_t> rp;
+		ASSERT_TRUE(rp.make(t, pw.tid_nodes(), src.get(), total));
+		const auto& tn = pw.tid_nodes();
+		ASSERT_EQ(::std::any_of(tn.begin(), tn.end(), [n = tn[0]](const node_id_t v) {return v != n; }), rp.replicated());
+	}
+
+	//faking 3 nodes to check the copies content
+	::std::vector<node_id_t> tidNodes(workersCnt);
+	for (thread_id_t i = 0; i < workersCnt; ++i) tidNodes[i] = i % 3;
+	node_replicas<real_t> rp;
+	ASSERT_TRUE(rp.make(t, tidNodes, src.get(), total));
+	ASSERT_EQ(workersCnt > 1, rp.replicated());
+	for (thread_id_t i = 0; i < workersCnt; ++i) {
+		const auto p = rp.for_tid(i);
+		if (workersCnt > 1) ASSERT_NE(src.get(), p);
+		for (range_t j = 0; j < total; ++j) ASSERT_EQ(src[j], p[j]) << "wrong copy for tid " << i;
+	}
+
+	//capped pool must get complete copies for the tids run() still uses
+	if (workersCnt > 2) {
+		const auto origMax = t.max_threads();
+		t.max_threads(2);
+		ASSERT_TRUE(rp.make(t, tidNodes, src.get(), total));
+		ASSERT_TRUE(rp.replicated());
+		for (thread_id_t i = 0; i < 2; ++i) {
+			const auto p = rp.for_tid(i);
+			for (range_t j = 0; j < total; ++j) ASSERT_EQ(src[j], p[j]) << "wrong copy for tid " << i << " of a capped pool";
+		}
+		t.max_threads(origMax);
+	}
+}
+
 
 #if !TESTS_SKIP_THREADING_PERFS
 
@@ -163,7 +346,7 @@ TEST(TestThreading, PerfComparision) {
 #else
 	static constexpr uint64_t maxreps = 100000, runCnt = 100;
 #endif
-	utils::tictoc tW, tWNE, tS;
+	utils::tictoc tW, tWNE, tS, tSP;
 
 	{
 		typedef threads::Workers<real_t, numel_cnt_t, sp_win> thr;
@@ -212,9 +395,27 @@ TEST(TestThreading, PerfComparision) {
 		tS.say("Std");
 		STDCOUTL(v);
 	}
+	{
+		typedef threads::Workers<real_t, numel_cnt_t, threads::spin_park_sync_primitives> thr;
+		typedef thr::par_range_t par_range_t;
+		thr spt;
+		::std::atomic_ptrdiff_t v = 0;
+
+		for (uint64_t i = 0; i < maxreps; ++i) {
+			tSP.tic();
+			spt.run([&](const par_range_t&) {
+				v++;
+			}, runCnt);
+			tSP.toc();
+		}
+		tSP.say("SpinPark");
+		STDCOUTL(v);
+	}
 
 	STDCOUT("ratios to threads::WinQDU are: ");
 	tS.ratios(tW);
+	STDCOUT("SpinPark ratios to threads::WinQDU are: ");
+	tSP.ratios(tW);
 }
 
 
@@ -313,3 +514,77 @@ TEST(TestBgWorkers, Simple) {
 	STDCOUTL("Using STL primitives");
 	run_bgworkers_simpletest<threads::std_sync_primitives>();
 }
+
+TEST(TestBgWorkers, MpmcQueue) {
+	threads::mpmc_queue<int, 8> q;
+	int v = -1;
+	ASSERT_TRUE(q.empty());
+	ASSERT_FALSE(q.pop(v));
+	for (int lap = 0; lap < 3; ++lap) {
+		for (int i = 0; i < 8; ++i) ASSERT_TRUE(q.push(i + lap));
+		ASSERT_FALSE(q.push(100)) << "Queue must be full";
+		ASSERT_EQ(8, q.size());
+		for (int i = 0; i < 8; ++i) {
+			ASSERT_TRUE(q.pop(v));
+			ASSERT_EQ(i + lap, v) << "Wrong order";
+		}
+		ASSERT_FALSE(q.pop(v));
+		ASSERT_TRUE(q.empty());
+	}
+}
+
+TEST(TestBgWorkers, Jobs) {
+	typedef threads::BgWorkers<> BgWorkers_t;
+	constexpr int producersCnt = 4, jobsPerProducer = 50000;
+
+	//posted functors are stored by value and must fit the storage of BgWorkers_t::CallH_t, so they capture one pointer only
+	struct _counters {
+		::std::atomic<int64_t> jobsDone, jobsSum;
+		_counters()noexcept : jobsDone(0), jobsSum(0) {}
+	} cnts;
+	auto& jobsDone = cnts.jobsDone;
+	auto& jobsSum = cnts.jobsSum;
+	::std::atomic<int> tasksBudget(0);
+	auto task = [&tasksBudget](const thread_id_t)noexcept->bool {
+		if (tasksBudget.fetch_sub(1) <= 0) {
+			tasksBudget.fetch_add(1);
+			return false;
+		}
+		return true;
+	};
+
+	BgWorkers_t bgw(3, threads::PriorityClass::threads_priority_no_change);
+	bgw.add_task(task);
+
+	::std::vector<::std::thread> producers;
+	for (int p = 0; p < producersCnt; ++p) {
+		producers.emplace_back([&bgw, &cnts, &tasksBudget]() {
+			for (int i = 0; i < jobsPerProducer; ++i) {
+				_counters*const pCnts = &cnts;
+				while (!bgw.post([pCnts, i](const thread_id_t)noexcept {
+					pCnts->jobsSum += i;
+					++pCnts->jobsDone;
+				}, static_cast<unsigned>(i % BgWorkers_t::priority_lanes))) {
+					::std::this_thread::yield();
+				}
+				if (0 == i % 1000) tasksBudget += 10;
+			}
+		});
+	}
+	for (auto& t : producers) t.join();
+
+	constexpr int64_t totalJobs = int64_t(producersCnt)*jobsPerProducer;
+	const auto waitTill = ::std::chrono::steady_clock::now() + ::std::chrono::seconds(10);
+	while ((jobsDone < totalJobs || tasksBudget > 0) && ::std::chrono::steady_clock::now() < waitTill)
+		::std::this_thread::sleep_for(::std::chrono::milliseconds(1));
+
+	ASSERT_EQ(totalJobs, jobsDone.load()) << "Not all jobs were executed";
+	ASSERT_EQ(int64_t(producersCnt)*(int64_t(jobsPerProducer)*(jobsPerProducer - 1) / 2), jobsSum.load());
+	ASSERT_EQ(0, tasksBudget.load()) << "Standing tasks weren't executed";
+
+	//exec() must still reach every worker
+	::std::atomic<int> execCnt(0);
+	bgw.exec([&execCnt](const thread_id_t)noexcept { ++execCnt; });
+	ASSERT_EQ(3, execCnt.load());
+	bgw.delete_tasks();
+}
@@ -101,6 +101,35 @@ TEST(TestUtils, PrioritizeWorkersPerf) {
 	STDCOUTL("prioritize_workers:\t" << utils::duration_readable(diff, maxReps));
 }
 
+#if defined(__linux__) && !defined(_WIN32_WINNT)
+TEST(TestUtils, PrioritizeWorkersPoolCpus) {
+	typedef nntl::d_interfaces::iThreads_t def_threads_t;
+	def_threads_t iT;
+
+	cpu_set_t orig, cs;
+	ASSERT_EQ(0, ::pthread_getaffinity_np(::pthread_self(), sizeof(orig), &orig));
+	unsigned firstCpu = 0;
+	while (!CPU_ISSET(firstCpu, &orig)) ++firstCpu;
+
+	threads::Funcs::SetPoolCpus({ firstCpu });
+	{
+		threads::prioritize_workers<threads::PriorityClass::Working, def_threads_t> pw(iT);
+		ASSERT_EQ(0, ::pthread_getaffinity_np(::pthread_self(), sizeof(cs), &cs));
+		ASSERT_EQ(1, CPU_COUNT(&cs));
+		ASSERT_TRUE(CPU_ISSET(firstCpu, &cs));
+
+		//Normal mode relaxes priorities only and mustn't touch the affinity
+		threads::prioritize_workers<threads::PriorityClass::Normal, def_threads_t> pw2(iT);
+		ASSERT_EQ(0, ::pthread_getaffinity_np(::pthread_self(), sizeof(cs), &cs));
+		ASSERT_EQ(1, CPU_COUNT(&cs));
+	}
+	threads::Funcs::SetPoolCpus({});
+
+	ASSERT_EQ(0, ::pthread_getaffinity_np(::pthread_self(), sizeof(cs), &cs));
+	ASSERT_TRUE(CPU_EQUAL(&orig, &cs)) << "original affinity must be restored";
+}
+#endif
+
 
 TEST(TestUtils, OwnOrUsePtr) {
 	int i = 1;
@@ -1030,6 +1059,117 @@ TEST(TestAFRandASDataBuffer, StateChecks_SpinLock) {
 #endif
 }
 
+TEST(TestAFRandASDataBuffer, PartialAcquireAndWholeClaim) {
+	typedef uint32_t real_t;
+	typedef utils::DataBuffer<real_t, void> DataBuffer_t;
+	constexpr size_t bufSize = 10;
+	::std::vector<real_t> bufData(bufSize), tmp(bufSize);
+	::std::iota(tmp.begin(), tmp.end(), real_t(1));
+
+	DataBuffer_t Buf(&bufData[0], bufSize);
+	ASSERT_FALSE(Buf.acquire_available(5).acquired());
+
+	ASSERT_EQ(6, Buf._as_should_work(6));
+	Buf._as_done(&tmp[0], 6);
+	auto br = Buf.acquire_available(8);
+	ASSERT_TRUE(br.acquired() && !br.isTwoArrays());
+	ASSERT_EQ(6, br.n1);
+	Buf.release_data(br);
+
+	//the buffer is empty and the whole of it gets claimed at once. Nothing must be claimed again until it's consumed
+	ASSERT_EQ(bufSize, Buf._as_should_work(bufSize + 5));
+	ASSERT_EQ(0, Buf._as_should_work(1));
+	Buf._as_done(&tmp[0], bufSize);
+	ASSERT_EQ(0, Buf._as_should_work(1));
+	ASSERT_TRUE(Buf.TestState());
+
+	br = Buf.acquire_available(7);
+	ASSERT_TRUE(br.acquired() && br.isTwoArrays());
+	ASSERT_EQ(4, br.n1);
+	ASSERT_EQ(3, br.n2);
+	Buf.release_data(br);
+
+	br = Buf.acquire_available(100);
+	ASSERT_TRUE(br.acquired() && !br.isTwoArrays());
+	ASSERT_EQ(3, br.n1);
+	Buf.release_data(br);
+	ASSERT_TRUE(Buf.TestState());
+	ASSERT_FALSE(Buf.acquire_available(1).acquired());
+
+	utils::CircBufferFeeder<real_t, 0> cbf(utils::CircBufferRange<real_t>(&bufData[0], 3));
+	size_t fallbacks = 0;
+	for (size_t i = 0; i < 5; ++i) {
+		const auto v = cbf.next(0, [&fallbacks]()noexcept { ++fallbacks; return real_t(0); });
+		if (i < 3) ASSERT_EQ(bufData[i], v);
+	}
+	ASSERT_EQ(2, fallbacks);
+	cbf.shrink();
+	ASSERT_EQ(3, cbf.n1);
+}
+
+TEST(TestAFRandAS, AdaptiveBuffersAndInlineFallback) {
+	typedef d_interfaces::real_t real_t;
+	typedef d_interfaces::iThreads_t def_threads_t;
+	typedef rng::AFRand_as<real_t, AFog::CRandomSFMT0, def_threads_t> rng_as_t;
+	typedef rng::AFRand_mt<real_t, AFog::CRandomSFMT0, def_threads_t> rng_mt_t;
+	constexpr size_t n = 5000;
+	constexpr real_t a = real_t(2);
+	def_threads_t Thr;
+	::std::vector<real_t> v(n), vET(n);
+
+	{
+		//no demand is known, so nothing is pregenerated and everything comes inline from the synchronous generator
+		rng_as_t ra(Thr, 11);
+		rng_mt_t rm(Thr, 11);
+		ASSERT_TRUE(ra.init_rng() && rm.init_rng());
+		ASSERT_EQ(size_t(0), ra.buffer_size());
+		ra.gen_vector(&v[0], n, a);
+		rm.gen_vector(&vET[0], n, a);
+		ASSERT_TRUE(vET == v) << "inline fallback must produce the sequence of the synchronous generator";
+		ra.normal_vector(&v[0], n);
+		rm.normal_vector(&vET[0], n);
+		ASSERT_TRUE(vET == v) << "inline fallback must produce the sequence of the synchronous generator";
+		ASSERT_GE(ra.inline_generated(), 2 * n);
+	}
+
+	rng_as_t ra(Thr, 13);
+	ra.preinit_additive_norm(n / 5);
+	ASSERT_TRUE(ra.init_rng());
+	const auto initSize = ra.buffer_size();
+	ASSERT_GT(initSize, size_t(0));
+	ASSERT_LT(initSize, n) << "the test expects a batch to be bigger than the initial buffers";
+
+	//requests made before the first batch aren't counted. The next call learns that a batch takes n values
+	ra.on_train_batch_begin();
+	ra.gen_vector(&v[0], n, a);
+	ASSERT_GE(ra.inline_generated(), n - initSize) << "the part the buffer can't hold must be generated inline";
+	for (const auto e : v) ASSERT_TRUE(e >= -a && e <= a);
+	ra.on_train_batch_begin();
+	ASSERT_GT(ra.buffer_size(), initSize) << "the buffers must grow to the observed batch demand";
+	ASSERT_GE(ra.buffer_size(), n);
+
+	//on_train_batch_begin() posts the refills, so eventually whole batches must be served from the buffers. The values
+	// must follow the same distribution as the synchronous generator produces
+	rng_mt_t rm(Thr, 13);
+	ASSERT_TRUE(rm.init_rng());
+	rm.gen_vector(&vET[0], n, a);
+	const auto meanET = ::std::accumulate(vET.begin(), vET.end(), real_t(0)) / n;
+	bool bServed = false;
+	for (unsigned i = 0; i < 500 && !bServed; ++i) {
+		::std::this_thread::sleep_for(::std::chrono::milliseconds(10));
+		const auto prevInline = ra.inline_generated();
+		ra.gen_vector(&v[0], n, a);
+		bServed = ra.inline_generated() == prevInline;
+		ra.on_train_batch_begin();
+	}
+	ASSERT_TRUE(bServed) << "background threads never filled the buffers";
+	for (const auto e : v) ASSERT_TRUE(e >= -a && e <= a);
+	const auto mean = ::std::accumulate(v.begin(), v.end(), real_t(0)) / n;
+	//both means are of n uniform values with stdev a/sqrt(3), so the 5 sigma band of their difference is 5*a*sqrt(2/(3n))
+	ASSERT_NEAR(meanET, mean, real_t(5) * a * ::std::sqrt(real_t(2) / (3 * n)));
+	ASSERT_NE(vET, v);
+}
+
 template<bool bOnMutex = true, typename Rep, typename Dur>
 void data_buffer_perf(::std::vector<utils::tictoc>& clocks//the first element is for the main (reader) thread.
 	, const size_t bufSize = 71, const size_t maxThreadGenSize = 5